@@ -9,6 +9,11 @@
  * - BM_FindWithProjection: Find with field projection
  * - BM_FindWithSort: Find with sorting (requires buffering)
  * - BM_FindWithSkipLimit: Pagination patterns
+ * - BM_FindOneByRefIdPlanCache: Indexed lookup with plan cache off/on
+ * - BM_FindOneByRefIdStats: Indexed lookup with metrics off/on
+ * - BM_CountByDepartment: Filtered count, scan vs index-only
+ * - BM_CountParallelScan / BM_FindParallelScan: Large filtered scans,
+ *   serial vs worker threads
  */
 
 #include <benchmark/benchmark.h>
@@ -167,6 +172,70 @@ BENCHMARK_DEFINE_F(FindFixture, BM_FindOneById)(benchmark::State& state) {
 BENCHMARK_REGISTER_F(FindFixture, BM_FindOneById)
     ->Unit(benchmark::kMicrosecond);
 
+// ============================================================
+// Benchmark: Fetch 100 documents by _id
+// Arg 0 = find_one per id, 1 = find_many_by_id, 2 = find with $in on _id
+// ============================================================
+
+BENCHMARK_DEFINE_F(FindFixture, BM_FindManyById)(benchmark::State& state) {
+    const int mode = static_cast<int>(state.range(0));
+
+    // Newest first, so the batched paths have to sort
+    std::vector<bson_oid_t> ids(known_ids.rbegin(), known_ids.rend());
+    std::vector<bson_t*> docs(ids.size());
+
+    bson_t* in_filter = bson_new();
+    bson_t id_doc, in_arr;
+    BSON_APPEND_DOCUMENT_BEGIN(in_filter, "_id", &id_doc);
+    BSON_APPEND_ARRAY_BEGIN(&id_doc, "$in", &in_arr);
+    for (size_t i = 0; i < ids.size(); ++i) {
+        std::string key = std::to_string(i);
+        BSON_APPEND_OID(&in_arr, key.c_str(), &ids[i]);
+    }
+    bson_append_array_end(&id_doc, &in_arr);
+    bson_append_document_end(in_filter, &id_doc);
+
+    for (auto _ : state) {
+        size_t found = 0;
+        if (mode == 0) {
+            for (const auto& oid : ids) {
+                bson_t* filter = bson_new();
+                BSON_APPEND_OID(filter, "_id", &oid);
+                bson_t* doc = mongolite_find_one(db, "bench", filter, nullptr, &error);
+                bson_destroy(filter);
+                if (doc) {
+                    found++;
+                    bson_destroy(doc);
+                }
+            }
+        } else if (mode == 1) {
+            mongolite_find_many_by_id(db, "bench", ids.data(), ids.size(), docs.data(), &error);
+            for (auto* doc : docs) {
+                if (doc) {
+                    found++;
+                    bson_destroy(doc);
+                }
+            }
+        } else {
+            mongolite_cursor_t* cursor = mongolite_find(db, "bench", in_filter, nullptr, &error);
+            const bson_t* doc;
+            while (cursor && mongolite_cursor_next(cursor, &doc)) found++;
+            if (cursor) mongolite_cursor_destroy(cursor);
+        }
+        if (found != ids.size()) {
+            state.SkipWithError("Not every _id was found");
+            break;
+        }
+    }
+
+    bson_destroy(in_filter);
+    state.SetItemsProcessed(state.iterations() * ids.size());
+}
+
+BENCHMARK_REGISTER_F(FindFixture, BM_FindManyById)
+    ->Arg(0)->Arg(1)->Arg(2)
+    ->Unit(benchmark::kMicrosecond);
+
 // ============================================================
 // Benchmark: Find One by indexed-like field (ref_id)
 // ============================================================
@@ -576,6 +645,8 @@ public:
     std::string db_path;
     gerror_t error;
     std::vector<int64_t> known_ref_ids;
+    bool disable_plan_cache = false;
+    bool disable_stats = false;
 
     static constexpr size_t COLLECTION_SIZE = 10000;
 
@@ -588,6 +659,8 @@ public:
 
         db_config_t config = {0};
         config.max_bytes = 1ULL * 1024 * 1024 * 1024;
+        config.disable_plan_cache = disable_plan_cache;
+        config.disable_stats = disable_stats;
 
         int rc = mongolite_open(db_path.c_str(), &db, &config, &error);
         if (rc != 0) return;
@@ -667,6 +740,159 @@ BENCHMARK_DEFINE_F(IndexedRefIdFixture, BM_FindOneByRefIdWithIndex)(benchmark::S
 BENCHMARK_REGISTER_F(IndexedRefIdFixture, BM_FindOneByRefIdWithIndex)
     ->Unit(benchmark::kMicrosecond);
 
+// ============================================================
+// Benchmark: find with $in / $or on the ref_id index
+// Arg 0 = {ref_id: {$in: [20 ids]}}, 1 = {$or: [{ref_id: x}, ... 20 clauses]}
+// (both were full scans before multi-point seeks)
+// ============================================================
+
+BENCHMARK_DEFINE_F(IndexedRefIdFixture, BM_FindRefIdInList)(benchmark::State& state) {
+    const bool use_or = state.range(0) == 1;
+    const size_t n = std::min<size_t>(20, known_ref_ids.size());
+
+    bson_t* filter = bson_new();
+    bson_t list;
+    if (use_or) {
+        BSON_APPEND_ARRAY_BEGIN(filter, "$or", &list);
+    } else {
+        bson_t in_doc;
+        BSON_APPEND_DOCUMENT_BEGIN(filter, "ref_id", &in_doc);
+        BSON_APPEND_ARRAY_BEGIN(&in_doc, "$in", &list);
+        for (size_t i = 0; i < n; ++i) {
+            std::string key = std::to_string(i);
+            BSON_APPEND_INT64(&list, key.c_str(), known_ref_ids[n - 1 - i]);
+        }
+        bson_append_array_end(&in_doc, &list);
+        bson_append_document_end(filter, &in_doc);
+    }
+    if (use_or) {
+        for (size_t i = 0; i < n; ++i) {
+            std::string key = std::to_string(i);
+            bson_t clause;
+            BSON_APPEND_DOCUMENT_BEGIN(&list, key.c_str(), &clause);
+            BSON_APPEND_INT64(&clause, "ref_id", known_ref_ids[i]);
+            bson_append_document_end(&list, &clause);
+        }
+        bson_append_array_end(filter, &list);
+    }
+
+    for (auto _ : state) {
+        mongolite_cursor_t* cursor = mongolite_find(db, "bench", filter, nullptr, &error);
+        if (!cursor) {
+            state.SkipWithError("Find returned null cursor");
+            break;
+        }
+        const bson_t* doc;
+        size_t count = 0;
+        while (mongolite_cursor_next(cursor, &doc)) count++;
+        mongolite_cursor_destroy(cursor);
+        if (count < n) {
+            state.SkipWithError("Missing documents");
+            break;
+        }
+    }
+
+    bson_destroy(filter);
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+BENCHMARK_REGISTER_F(IndexedRefIdFixture, BM_FindRefIdInList)
+    ->Arg(0)->Arg(1)
+    ->Unit(benchmark::kMicrosecond);
+
+// ============================================================
+// Benchmark: Find One by ref_id WITH index, plan cache off/on
+// Arg(0) = re-plan every query, Arg(1) = plan served from cache
+// ============================================================
+
+class PlanCacheFixture : public IndexedRefIdFixture {
+public:
+    void SetUp(const benchmark::State& state) override {
+        disable_plan_cache = (state.range(0) == 0);
+        IndexedRefIdFixture::SetUp(state);
+    }
+};
+
+BENCHMARK_DEFINE_F(PlanCacheFixture, BM_FindOneByRefIdPlanCache)(benchmark::State& state) {
+    size_t idx = 0;
+    for (auto _ : state) {
+        int64_t ref_id = known_ref_ids[idx % known_ref_ids.size()];
+        idx++;
+
+        bson_t* filter = bson_new();
+        BSON_APPEND_INT64(filter, "ref_id", ref_id);
+
+        bson_t* result = mongolite_find_one(db, "bench", filter, nullptr, &error);
+
+        bson_destroy(filter);
+        if (result) {
+            bson_destroy(result);
+        } else {
+            state.SkipWithError("Find by ref_id with plan cache returned null");
+            break;
+        }
+    }
+
+    uint64_t hits = 0, replans = 0;
+    mongolite_plan_cache_stats(db, "bench", &hits, &replans, &error);
+    state.counters["plan_hits"] = static_cast<double>(hits);
+    state.counters["replans"] = static_cast<double>(replans);
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(PlanCacheFixture, BM_FindOneByRefIdPlanCache)
+    ->Arg(0)
+    ->Arg(1)
+    ->Unit(benchmark::kMicrosecond);
+
+// ============================================================
+// Benchmark: Find One by ref_id WITH index, metrics off/on
+// Arg(0) = disable_stats, Arg(1) = counters + latency histograms
+// ============================================================
+
+class StatsFixture : public IndexedRefIdFixture {
+public:
+    void SetUp(const benchmark::State& state) override {
+        disable_stats = (state.range(0) == 0);
+        IndexedRefIdFixture::SetUp(state);
+        if (db) mongolite_stats_reset(db);
+    }
+};
+
+BENCHMARK_DEFINE_F(StatsFixture, BM_FindOneByRefIdStats)(benchmark::State& state) {
+    size_t idx = 0;
+    for (auto _ : state) {
+        int64_t ref_id = known_ref_ids[idx % known_ref_ids.size()];
+        idx++;
+
+        bson_t* filter = bson_new();
+        BSON_APPEND_INT64(filter, "ref_id", ref_id);
+
+        bson_t* result = mongolite_find_one(db, "bench", filter, nullptr, &error);
+
+        bson_destroy(filter);
+        if (result) {
+            bson_destroy(result);
+        } else {
+            state.SkipWithError("Find by ref_id with stats returned null");
+            break;
+        }
+    }
+
+    mongolite_stats_t stats;
+    mongolite_stats(db, &stats, &error);
+    const mongolite_latency_t* lat = &stats.latency[MONGOLITE_OP_FIND_ONE];
+    state.counters["p50_ns"] = static_cast<double>(mongolite_latency_percentile(lat, 50.0));
+    state.counters["p99_ns"] = static_cast<double>(mongolite_latency_percentile(lat, 99.0));
+    state.counters["index_queries"] = static_cast<double>(stats.totals.index_queries);
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(StatsFixture, BM_FindOneByRefIdStats)
+    ->Arg(0)
+    ->Arg(1)
+    ->Unit(benchmark::kMicrosecond);
+
 // ============================================================
 // Benchmark: Find One by ref_id WITHOUT index (scan baseline)
 // Uses IndexedFindFixture which has no index
@@ -698,6 +924,55 @@ BENCHMARK_DEFINE_F(IndexedFindFixture, BM_FindOneByRefIdNoIndex)(benchmark::Stat
 BENCHMARK_REGISTER_F(IndexedFindFixture, BM_FindOneByRefIdNoIndex)
     ->Unit(benchmark::kMicrosecond);
 
+// ============================================================
+// Benchmark: Filtered count, scan vs index-only
+// Arg(0) = no index (matcher over every document)
+// Arg(1) = index on department (keys counted, documents untouched)
+// ============================================================
+
+class CountFixture : public IndexedFindFixture {
+public:
+    void SetUp(const benchmark::State& state) override {
+        IndexedFindFixture::SetUp(state);
+        if (db && state.range(0) == 1) {
+            bson_t* keys = bson_new();
+            BSON_APPEND_INT32(keys, "department", 1);
+            mongolite_create_index(db, "bench", keys, "department_1", nullptr, &error);
+            bson_destroy(keys);
+        }
+    }
+};
+
+BENCHMARK_DEFINE_F(CountFixture, BM_CountByDepartment)(benchmark::State& state) {
+    size_t idx = 0;
+    int64_t matched = 0;
+    for (auto _ : state) {
+        const char* dept = bench::DEPARTMENTS[idx % bench::NUM_DEPARTMENTS];
+        idx++;
+
+        bson_t* filter = bson_new();
+        BSON_APPEND_UTF8(filter, "department", dept);
+
+        int64_t count = mongolite_collection_count(db, "bench", filter, &error);
+
+        bson_destroy(filter);
+        if (count < 0) {
+            state.SkipWithError("Filtered count failed");
+            break;
+        }
+        matched += count;
+    }
+
+    state.counters["docs_per_count"] = benchmark::Counter(
+        static_cast<double>(matched), benchmark::Counter::kAvgIterations);
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(CountFixture, BM_CountByDepartment)
+    ->Arg(0)
+    ->Arg(1)
+    ->Unit(benchmark::kMicrosecond);
+
 // ============================================================
 // Benchmark: Index vs Scan at different collection sizes
 // ============================================================
@@ -802,6 +1077,109 @@ BENCHMARK_REGISTER_F(ScaleFindFixture, BM_FindIndexVsScanAtScale)
     ->Args({50000, 1})   // 50K docs, with index
     ->Iterations(500);
 
+// ============================================================
+// Benchmark: Filtered count / find over a large collection, serial vs
+// parallel scan
+// Arg(0) = scan_threads (0 = serial)
+// ============================================================
+
+class ParallelScanFixture : public benchmark::Fixture {
+public:
+    mongolite_db_t* db = nullptr;
+    bench::DocumentGenerator generator;
+    std::string db_path;
+    gerror_t error;
+
+    static constexpr size_t COLLECTION_SIZE = 200000;
+
+    void SetUp(const benchmark::State& state) override {
+        memset(&error, 0, sizeof(error));
+        db_path = "./bench_parallel_scan_db_" + std::to_string(rand());
+        remove_directory(db_path.c_str());
+
+        db_config_t config = {0};
+        config.max_bytes = 2ULL * 1024 * 1024 * 1024;
+        config.scan_threads = static_cast<unsigned int>(state.range(0));
+        config.scan_parallel_min_docs = 1;
+
+        mongolite_open(db_path.c_str(), &db, &config, &error);
+        mongolite_collection_create(db, "bench", nullptr, &error);
+        generator.reset(42);
+
+        const size_t batch = 1000;
+        for (size_t i = 0; i < COLLECTION_SIZE; i += batch) {
+            std::vector<bench::BenchDocument> docs = generator.generate_batch(batch);
+            std::vector<bson_t*> bson_docs;
+            for (const auto& doc : docs) bson_docs.push_back(bench::bench_doc_to_bson(doc));
+            mongolite_insert_many(db, "bench", const_cast<const bson_t**>(bson_docs.data()),
+                                  batch, nullptr, &error);
+            for (auto* b : bson_docs) bson_destroy(b);
+        }
+    }
+
+    void TearDown(const benchmark::State& state) override {
+        (void)state;
+        if (db) {
+            mongolite_close(db);
+            db = nullptr;
+        }
+        remove_directory(db_path.c_str());
+    }
+};
+
+BENCHMARK_DEFINE_F(ParallelScanFixture, BM_CountParallelScan)(benchmark::State& state) {
+    size_t idx = 0;
+    for (auto _ : state) {
+        const char* dept = bench::DEPARTMENTS[idx++ % bench::NUM_DEPARTMENTS];
+        bson_t* filter = bson_new();
+        BSON_APPEND_UTF8(filter, "department", dept);
+        int64_t count = mongolite_collection_count(db, "bench", filter, &error);
+        bson_destroy(filter);
+        if (count < 0) {
+            state.SkipWithError("Filtered count failed");
+            break;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * COLLECTION_SIZE);
+    state.counters["threads"] = static_cast<double>(state.range(0));
+}
+
+BENCHMARK_REGISTER_F(ParallelScanFixture, BM_CountParallelScan)
+    ->Arg(0)
+    ->Arg(2)
+    ->Arg(4)
+    ->Arg(8)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_DEFINE_F(ParallelScanFixture, BM_FindParallelScan)(benchmark::State& state) {
+    size_t idx = 0;
+    int64_t returned = 0;
+    for (auto _ : state) {
+        const char* dept = bench::DEPARTMENTS[idx++ % bench::NUM_DEPARTMENTS];
+        bson_t* filter = bson_new();
+        BSON_APPEND_UTF8(filter, "department", dept);
+        mongolite_cursor_t* cursor = mongolite_find(db, "bench", filter, nullptr, &error);
+        bson_destroy(filter);
+        if (!cursor) {
+            state.SkipWithError("Find failed");
+            break;
+        }
+        const bson_t* doc;
+        while (mongolite_cursor_next(cursor, &doc)) returned++;
+        mongolite_cursor_destroy(cursor);
+    }
+    state.SetItemsProcessed(state.iterations() * COLLECTION_SIZE);
+    state.counters["docs_per_find"] = benchmark::Counter(
+        static_cast<double>(returned), benchmark::Counter::kAvgIterations);
+}
+
+BENCHMARK_REGISTER_F(ParallelScanFixture, BM_FindParallelScan)
+    ->Arg(0)
+    ->Arg(4)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
 // ============================================================
 // Main
 // ============================================================
@@ -6,6 +6,9 @@
  * - BM_InsertMany: Batch insertion with varying batch sizes
  * - BM_InsertOneJson: Single document insertion via JSON API
  * - BM_InsertManyJson: Batch insertion via JSON API
+ * - BM_InsertNdjson: Same batches as one NDJSON buffer (bulk ingest path)
+ * - BM_InsertOneConcurrent: Auto-commit inserts from many threads,
+ *   group commit off/on
  */
 
 #include <benchmark/benchmark.h>
@@ -246,6 +249,45 @@ BENCHMARK_REGISTER_F(MongoliteFixture, BM_InsertManyJson)
     ->Arg(100)
     ->Arg(1000);
 
+// ============================================================
+// Benchmark: Insert NDJSON - same batches as BM_InsertManyJson
+// ============================================================
+
+BENCHMARK_DEFINE_F(MongoliteFixture, BM_InsertNdjson)(benchmark::State& state) {
+    const size_t batch_size = static_cast<size_t>(state.range(0));
+    std::string ndjson;
+
+    for (auto _ : state) {
+        // Generate batch
+        std::vector<bench::BenchDocument> docs = generator.generate_batch(batch_size);
+        ndjson.clear();
+        for (const auto& doc : docs) {
+            char* json = bench::bench_doc_to_json(doc);
+            ndjson += json;
+            ndjson += '\n';
+            free(json);
+        }
+
+        // Insert batch
+        int64_t inserted = 0;
+        int rc = mongolite_insert_ndjson(db, "bench", ndjson.data(), ndjson.size(),
+                                         batch_size, &inserted, &error);
+
+        if (rc < 0) {
+            state.SkipWithError("Insert NDJSON failed");
+            break;
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * batch_size);
+}
+
+BENCHMARK_REGISTER_F(MongoliteFixture, BM_InsertNdjson)
+    ->Unit(benchmark::kMicrosecond)
+    ->Arg(10)
+    ->Arg(100)
+    ->Arg(1000);
+
 // ============================================================
 // Benchmark: Insert with explicit transaction
 // ============================================================
@@ -529,6 +571,227 @@ BENCHMARK_REGISTER_F(IndexedInsertFixture, BM_InsertManyWithIndex)
     ->Args({1000, 1})  // batch 1000, 1 index
     ->Args({1000, 2}); // batch 1000, 2 indexes
 
+// ============================================================
+// Fixture: Concurrent writers, group commit off (0) / on (1)
+// ============================================================
+
+class GroupCommitFixture : public benchmark::Fixture {
+public:
+    mongolite_db_t* db = nullptr;
+    std::string db_path;
+
+    // One database shared by all benchmark threads
+    void SetUp(const benchmark::State& state) override {
+        if (state.thread_index() != 0) return;
+
+        db_path = "./bench_group_db_" + std::to_string(rand());
+        remove_directory(db_path.c_str());
+
+        gerror_t error = {0};
+        db_config_t config = {0};
+        config.max_bytes = 1ULL * 1024 * 1024 * 1024;
+        config.group_commit = state.range(0) != 0;
+
+        int rc = mongolite_open(db_path.c_str(), &db, &config, &error);
+        if (rc != 0) {
+            fprintf(stderr, "Failed to open database: %s\n", error.message);
+            return;
+        }
+        mongolite_collection_create(db, "bench", nullptr, &error);
+    }
+
+    void TearDown(const benchmark::State& state) override {
+        if (state.thread_index() != 0) return;
+        if (db) {
+            mongolite_close(db);
+            db = nullptr;
+        }
+        remove_directory(db_path.c_str());
+    }
+};
+
+// ============================================================
+// Benchmark: Auto-commit insert_one from many threads
+// ============================================================
+
+BENCHMARK_DEFINE_F(GroupCommitFixture, BM_InsertOneConcurrent)(benchmark::State& state) {
+    gerror_t error = {0};
+    int32_t seq = 0;
+
+    for (auto _ : state) {
+        bson_t* doc = BCON_NEW("thread", BCON_INT32(state.thread_index()),
+                               "seq", BCON_INT32(seq++),
+                               "payload", BCON_UTF8("group commit benchmark document"));
+        int rc = mongolite_insert_one(db, "bench", doc, nullptr, &error);
+        bson_destroy(doc);
+
+        if (rc != 0) {
+            state.SkipWithError("Insert failed");
+            break;
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations());
+    state.counters["group_commit"] = benchmark::Counter(static_cast<double>(state.range(0)),
+                                                        benchmark::Counter::kAvgThreads);
+}
+
+BENCHMARK_REGISTER_F(GroupCommitFixture, BM_InsertOneConcurrent)
+    ->Unit(benchmark::kMicrosecond)
+    ->Arg(0)   // one transaction + sync per insert
+    ->Arg(1)   // group commit
+    ->Threads(1)
+    ->Threads(8)
+    ->UseRealTime();
+
+// ============================================================
+// Fixture: Durability level FULL (0) / ASYNC (1) / NONE (2)
+// ============================================================
+
+class DurabilityFixture : public benchmark::Fixture {
+public:
+    mongolite_db_t* db = nullptr;
+    std::string db_path;
+
+    void SetUp(const benchmark::State& state) override {
+        db_path = "./bench_durability_db_" + std::to_string(rand());
+        remove_directory(db_path.c_str());
+
+        gerror_t error = {0};
+        db_config_t config = {0};
+        config.max_bytes = 1ULL * 1024 * 1024 * 1024;
+        config.durability = static_cast<mongolite_durability_t>(state.range(0));
+        config.sync_interval_ms = 50;
+
+        int rc = mongolite_open(db_path.c_str(), &db, &config, &error);
+        if (rc != 0) {
+            fprintf(stderr, "Failed to open database: %s\n", error.message);
+            return;
+        }
+        mongolite_collection_create(db, "bench", nullptr, &error);
+    }
+
+    void TearDown(const benchmark::State& state) override {
+        (void)state;
+        if (db) {
+            mongolite_close(db);
+            db = nullptr;
+        }
+        remove_directory(db_path.c_str());
+    }
+};
+
+// ============================================================
+// Benchmark: Auto-commit insert_one per durability level
+// ============================================================
+
+BENCHMARK_DEFINE_F(DurabilityFixture, BM_InsertOneDurability)(benchmark::State& state) {
+    gerror_t error = {0};
+    int32_t seq = 0;
+
+    for (auto _ : state) {
+        bson_t* doc = BCON_NEW("seq", BCON_INT32(seq++),
+                               "payload", BCON_UTF8("durability benchmark document"));
+        int rc = mongolite_insert_one(db, "bench", doc, nullptr, &error);
+        bson_destroy(doc);
+
+        if (rc != 0) {
+            state.SkipWithError("Insert failed");
+            break;
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations());
+    state.counters["lag"] = static_cast<double>(mongolite_commit_id(db) -
+                                                mongolite_durable_id(db));
+}
+
+BENCHMARK_REGISTER_F(DurabilityFixture, BM_InsertOneDurability)
+    ->Unit(benchmark::kMicrosecond)
+    ->Arg(MONGOLITE_DURABILITY_FULL)
+    ->Arg(MONGOLITE_DURABILITY_ASYNC)
+    ->Arg(MONGOLITE_DURABILITY_NONE);
+
+// ============================================================
+// Fixture: Small initial map, grown by policy while inserting
+// ============================================================
+
+class MapGrowthFixture : public benchmark::Fixture {
+public:
+    mongolite_db_t* db = nullptr;
+    std::string db_path;
+    bench::DocumentGenerator generator;
+
+    void SetUp(const benchmark::State& state) override {
+        (void)state;
+        db_path = "./bench_map_growth_db_" + std::to_string(rand());
+        remove_directory(db_path.c_str());
+
+        gerror_t error = {0};
+        db_config_t config = {0};
+        config.max_bytes = 1ULL * 1024 * 1024;  // 1MB: grows many times
+
+        int rc = mongolite_open(db_path.c_str(), &db, &config, &error);
+        if (rc != 0) {
+            fprintf(stderr, "Failed to open database: %s\n", error.message);
+            return;
+        }
+        mongolite_collection_create(db, "bench", nullptr, &error);
+        mongolite_stats_reset(db);
+    }
+
+    void TearDown(const benchmark::State& state) override {
+        (void)state;
+        if (db) {
+            mongolite_close(db);
+            db = nullptr;
+        }
+        remove_directory(db_path.c_str());
+    }
+};
+
+// ============================================================
+// Benchmark: insert_many batches through repeated map growth
+// ============================================================
+
+BENCHMARK_DEFINE_F(MapGrowthFixture, BM_InsertManyGrowingMap)(benchmark::State& state) {
+    const size_t batch_size = static_cast<size_t>(state.range(0));
+    gerror_t error = {0};
+
+    for (auto _ : state) {
+        std::vector<bench::BenchDocument> docs = generator.generate_batch(batch_size);
+        std::vector<bson_t*> bson_docs;
+        bson_docs.reserve(batch_size);
+        for (const auto& doc : docs) {
+            bson_docs.push_back(bench::bench_doc_to_bson(doc));
+        }
+
+        int rc = mongolite_insert_many(db, "bench",
+                                       const_cast<const bson_t**>(bson_docs.data()),
+                                       batch_size, nullptr, &error);
+        for (auto* b : bson_docs) {
+            bson_destroy(b);
+        }
+
+        if (rc < 0) {
+            state.SkipWithError("Insert many failed");
+            break;
+        }
+    }
+
+    // replays: batches redone after MAP_FULL; grows: resizes done ahead of use
+    mongolite_stats_t stats;
+    mongolite_stats(db, &stats, &error);
+    state.SetItemsProcessed(state.iterations() * batch_size);
+    state.counters["replays"] = static_cast<double>(stats.resizes);
+    state.counters["grows"] = static_cast<double>(stats.map_grows);
+}
+
+BENCHMARK_REGISTER_F(MapGrowthFixture, BM_InsertManyGrowingMap)
+    ->Unit(benchmark::kMicrosecond)
+    ->Arg(1000)
+    ->Arg(10000);
+
 // ============================================================
 // Main (provided by benchmark::benchmark_main)
 // ============================================================
@@ -11,38 +11,41 @@
  *    https://www.mongodb.com/docs/manual/reference/bson-type-comparison-order/
  * ============================================================ */
 
-static int get_mongodb_type_precedence(bson_type_t type) {
-    switch (type) {
-        case BSON_TYPE_MINKEY:     return 1;
-        case BSON_TYPE_NULL:       return 2;
-
-        /* 3) Todos os números: int32, int64, double, decimal128 */
-        case BSON_TYPE_INT32:
-        case BSON_TYPE_INT64:
-        case BSON_TYPE_DOUBLE:
-        case BSON_TYPE_DECIMAL128: return 3;
-
-        /* 4) Strings/símbolos */
-        case BSON_TYPE_UTF8:
-        case BSON_TYPE_SYMBOL:     return 4;
-
-        /* 5..12) Restante conforme docs */
-        case BSON_TYPE_DOCUMENT:   return 5;
-        case BSON_TYPE_ARRAY:      return 6;
-        case BSON_TYPE_BINARY:     return 7;
-        case BSON_TYPE_OID:        return 8;
-        case BSON_TYPE_BOOL:       return 9;
-        case BSON_TYPE_DATE_TIME:  return 10;
-        case BSON_TYPE_TIMESTAMP:  return 11;
-        case BSON_TYPE_REGEX:      return 12;
-
-        /* 15) MaxKey */
-        case BSON_TYPE_MAXKEY:     return 15;
+/* Indexada pelo byte de tipo (0x00..0x13); MinKey (0xFF) e MaxKey (0x7F)
+ * ficam fora da tabela. Tipos não suportados: logo abaixo de MaxKey (14). */
+static const uint8_t type_precedence[0x14] = {
+    14,     /* 0x00 (fim do documento) */
+    3,      /* 0x01 double */
+    4,      /* 0x02 utf8 */
+    5,      /* 0x03 document */
+    6,      /* 0x04 array */
+    7,      /* 0x05 binary */
+    14,     /* 0x06 undefined */
+    8,      /* 0x07 oid */
+    9,      /* 0x08 bool */
+    10,     /* 0x09 date_time */
+    2,      /* 0x0A null */
+    12,     /* 0x0B regex */
+    14,     /* 0x0C dbpointer */
+    14,     /* 0x0D code */
+    4,      /* 0x0E symbol */
+    14,     /* 0x0F codewscope */
+    3,      /* 0x10 int32 */
+    11,     /* 0x11 timestamp */
+    3,      /* 0x12 int64 */
+    3,      /* 0x13 decimal128 */
+};
+
+static inline int type_rank(bson_type_t type) {
+    unsigned t = (unsigned)type;
+    if (t < sizeof(type_precedence)) return type_precedence[t];
+    if (t == BSON_TYPE_MINKEY) return 1;
+    if (t == BSON_TYPE_MAXKEY) return 15;
+    return 14;
+}
 
-        default:
-            /* Tipos não suportados: jogar lá pra cima, logo acima de MaxKey */
-            return 14;
-    }
+int get_mongodb_type_precedence(bson_type_t type) {
+    return type_rank(type);
 }
 
 /* ============================================================
@@ -164,6 +167,21 @@ static int numeric_fallback_compare(const bson_iter_t *a, const bson_iter_t *b)
  * - Falls back to deterministic type-based ordering otherwise
  */
 static int mongodb_compare_numbers(const bson_iter_t *a, const bson_iter_t *b) {
+    bson_type_t ta = bson_iter_type_unsafe(a);
+    bson_type_t tb = bson_iter_type_unsafe(b);
+
+    /* int32 vs int64 within 2^53: exact integer compare, same result as
+     * the double path below without the conversions */
+    if ((ta == BSON_TYPE_INT32 || ta == BSON_TYPE_INT64) &&
+        (tb == BSON_TYPE_INT32 || tb == BSON_TYPE_INT64)) {
+        int64_t va = ta == BSON_TYPE_INT32 ? bson_iter_int32_unsafe(a) : bson_iter_int64_unsafe(a);
+        int64_t vb = tb == BSON_TYPE_INT32 ? bson_iter_int32_unsafe(b) : bson_iter_int64_unsafe(b);
+        if (va >= -MAX_SAFE_INT_DOUBLE && va <= MAX_SAFE_INT_DOUBLE &&
+            vb >= -MAX_SAFE_INT_DOUBLE && vb <= MAX_SAFE_INT_DOUBLE) {
+            return (va > vb) - (va < vb);
+        }
+    }
+
     bool safe_a = number_is_safe(a);
     bool safe_b = number_is_safe(b);
 
@@ -216,10 +234,12 @@ int bson_compare_docs(const bson_t *doc1, const bson_t *doc2) {
     bool ok2 = bson_iter_init(&it2, doc2) && bson_iter_next(&it2);
 
     while (ok1 && ok2) {
-        const char *k1 = bson_iter_key(&it1);
-        const char *k2 = bson_iter_key(&it2);
-
-        int keyCmp = strcmp(k1, k2);
+        /* Chaves têm o tamanho conhecido: memcmp até o NUL da menor
+         * dá o mesmo resultado do strcmp sem varrer as duas */
+        uint32_t l1 = bson_iter_key_len(&it1);
+        uint32_t l2 = bson_iter_key_len(&it2);
+        int keyCmp = memcmp(bson_iter_key_unsafe(&it1), bson_iter_key_unsafe(&it2),
+                            (l1 < l2 ? l1 : l2) + 1);
         if (keyCmp != 0)
             return (keyCmp < 0) ? -1 : 1;
 
@@ -240,12 +260,72 @@ int bson_compare_docs(const bson_t *doc1, const bson_t *doc2) {
  * 6) COMPARAÇÃO DE VALORES BSON (ITERADORES)
  * ============================================================ */
 
+/* Doubles do mesmo tipo: NaN == NaN e menor que tudo; -0 == +0 */
+static inline int compare_doubles(double da, double db) {
+    if (isnan(da) || isnan(db)) {
+        if (isnan(da) && isnan(db)) return 0;
+        return isnan(da) ? -1 : 1;
+    }
+    return (da > db) - (da < db);
+}
+
+static inline int compare_bytes(const char *sa, size_t la, const char *sb, size_t lb) {
+    int cmp = memcmp(sa, sb, la < lb ? la : lb);
+    if (cmp != 0)
+        return (cmp < 0) ? -1 : 1;
+    return (la > lb) - (la < lb);
+}
+
+/* Lê utf8 como bytes; símbolo vale "" (como bson_iter_utf8 sempre leu).
+ * Índices gravados seguem essa ordem, então ela não pode mudar. */
+static inline const char *string_bytes(const bson_iter_t *it, bson_type_t t, size_t *len) {
+    if (t != BSON_TYPE_UTF8) {
+        *len = 0;
+        return "";
+    }
+    return bson_iter_utf8_unsafe(it, len);
+}
+
 int mongodb_compare_iter(const bson_iter_t *a, const bson_iter_t *b) {
-    bson_type_t ta = bson_iter_type(a);
-    bson_type_t tb = bson_iter_type(b);
+    bson_type_t ta = bson_iter_type_unsafe(a);
+    bson_type_t tb = bson_iter_type_unsafe(b);
+
+    /* Mesmo tipo: comparar direto, sem precedência nem conversão.
+     * O resultado é o mesmo do caminho geral abaixo. */
+    if (ta == tb) {
+        switch (ta) {
+            case BSON_TYPE_INT32: {
+                int32_t va = bson_iter_int32_unsafe(a);
+                int32_t vb = bson_iter_int32_unsafe(b);
+                return (va > vb) - (va < vb);
+            }
+            case BSON_TYPE_INT64:
+            case BSON_TYPE_DATE_TIME: {
+                int64_t va = bson_iter_int64_unsafe(a);
+                int64_t vb = bson_iter_int64_unsafe(b);
+                return (va > vb) - (va < vb);
+            }
+            case BSON_TYPE_DOUBLE:
+                return compare_doubles(bson_iter_double_unsafe(a), bson_iter_double_unsafe(b));
+            case BSON_TYPE_UTF8: {
+                size_t la, lb;
+                const char *sa = bson_iter_utf8_unsafe(a, &la);
+                const char *sb = bson_iter_utf8_unsafe(b, &lb);
+                return compare_bytes(sa, la, sb, lb);
+            }
+            case BSON_TYPE_SYMBOL:
+                return 0;   /* ambos "" */
+            case BSON_TYPE_OID: {
+                int cmp = memcmp(bson_iter_oid_unsafe(a), bson_iter_oid_unsafe(b), 12);
+                return (cmp > 0) - (cmp < 0);
+            }
+            default:
+                break;
+        }
+    }
 
-    int pa = get_mongodb_type_precedence(ta);
-    int pb = get_mongodb_type_precedence(tb);
+    int pa = type_rank(ta);
+    int pb = type_rank(tb);
 
     /* Se tipos diferentes, só a precedência importa */
     if (pa != pb)
@@ -269,18 +349,11 @@ int mongodb_compare_iter(const bson_iter_t *a, const bson_iter_t *b) {
 
         case BSON_TYPE_UTF8:
         case BSON_TYPE_SYMBOL: {
-            uint32_t la, lb;
-            const char *sa = bson_iter_utf8(a, &la);
-            const char *sb = bson_iter_utf8(b, &lb);
-
-            uint32_t min = (la < lb) ? la : lb;
-            int cmp = memcmp(sa, sb, min);
-            if (cmp != 0)
-                return (cmp < 0) ? -1 : 1;
-
-            if (la < lb) return -1;
-            if (la > lb) return 1;
-            return 0;
+            /* utf8 x symbol: símbolo conta como "" */
+            size_t la, lb;
+            const char *sa = string_bytes(a, ta, &la);
+            const char *sb = string_bytes(b, tb, &lb);
+            return compare_bytes(sa, la, sb, lb);
         }
 
         case BSON_TYPE_INT32:
@@ -557,4 +630,62 @@ bool bson_index_key_extractor_sparse(const void *value, size_t value_len,
 
     /* Extract the key normally */
     return bson_index_key_extractor(value, value_len, user_data, out_key, out_len);
-}
\ No newline at end of file
+}
+/* ============================================================
+ * 10) COMPARAÇÃO EM LOTE
+ *
+ *    Um mesmo campo de muitos documentos contra um pivô (sort
+ *    buffers, partições). Trechos com o tipo numérico do pivô são
+ *    copiados para um array e comparados num laço sem desvios, que o
+ *    compilador vetoriza; o resto passa por mongodb_compare_iter.
+ * ============================================================ */
+
+#define BATCH_CHUNK 64
+
+void mongodb_compare_iter_batch(const bson_iter_t *values, size_t n,
+                                const bson_iter_t *pivot, int *out) {
+    bson_type_t tp = bson_iter_type_unsafe(pivot);
+    bool batchable = tp == BSON_TYPE_INT32 || tp == BSON_TYPE_INT64 ||
+                     tp == BSON_TYPE_DATE_TIME || tp == BSON_TYPE_DOUBLE;
+
+    size_t i = 0;
+    while (i < n) {
+        size_t run = 0;
+        if (batchable) {
+            while (run < BATCH_CHUNK && i + run < n &&
+                   bson_iter_type_unsafe(&values[i + run]) == tp) {
+                run++;
+            }
+        }
+        if (run < 2) {
+            out[i] = mongodb_compare_iter(&values[i], pivot);
+            i++;
+            continue;
+        }
+
+        int *o = out + i;
+        const bson_iter_t *v = values + i;
+        if (tp == BSON_TYPE_INT32) {
+            int32_t x[BATCH_CHUNK];
+            int32_t p = bson_iter_int32_unsafe(pivot);
+            for (size_t k = 0; k < run; k++) x[k] = bson_iter_int32_unsafe(&v[k]);
+            for (size_t k = 0; k < run; k++) o[k] = (x[k] > p) - (x[k] < p);
+        } else if (tp == BSON_TYPE_DOUBLE) {
+            double x[BATCH_CHUNK];
+            double p = bson_iter_double_unsafe(pivot);
+            for (size_t k = 0; k < run; k++) x[k] = bson_iter_double_unsafe(&v[k]);
+            if (isnan(p)) {
+                for (size_t k = 0; k < run; k++) o[k] = x[k] != x[k] ? 0 : 1;
+            } else {
+                /* NaN: nem maior nem menor, mas x != x → -1 (menor que tudo) */
+                for (size_t k = 0; k < run; k++) o[k] = (x[k] > p) - (x[k] < p) - (x[k] != x[k]);
+            }
+        } else {
+            int64_t x[BATCH_CHUNK];
+            int64_t p = bson_iter_int64_unsafe(pivot);
+            for (size_t k = 0; k < run; k++) x[k] = bson_iter_int64_unsafe(&v[k]);
+            for (size_t k = 0; k < run; k++) o[k] = (x[k] > p) - (x[k] < p);
+        }
+        i += run;
+    }
+}
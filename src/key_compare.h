@@ -12,10 +12,20 @@ extern "C" {
 // Compara dois documentos BSON inteiros (ordem MongoDB)
 int bson_compare_docs(const bson_t *doc1, const bson_t *doc2);
 
+// Classe de ordenação de um tipo BSON (todos os números = mesma classe)
+// Valores de classes diferentes nunca são comparados por valor
+int get_mongodb_type_precedence(bson_type_t type);
+
 // Compara valores BSON de dois iteradores (ordem MongoDB)
 // Retorna: -1 se a < b, 0 se a == b, 1 se a > b
 int mongodb_compare_iter(const bson_iter_t *a, const bson_iter_t *b);
 
+// Compara o mesmo campo de n documentos com um pivô (sort buffers)
+// out[i] = mongodb_compare_iter(&values[i], pivot); trechos com o tipo
+// numérico do pivô são comparados em lote
+void mongodb_compare_iter_batch(const bson_iter_t *values, size_t n,
+                                const bson_iter_t *pivot, int *out);
+
 // Extrai campos de um documento para criar uma index key
 // doc: documento fonte
 // keys: especificação do índice, ex: {"name": 1, "age": -1}
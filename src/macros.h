@@ -6,6 +6,7 @@
  * - Function attributes (pure, const, malloc, nonnull, etc.)
  * - Inline hints
  * - Alignment
+ * - Thread-local storage and relaxed atomics
  */
 
 #ifndef MACROS_H
@@ -179,6 +180,45 @@
 
 #endif
 
+/* ============================================================
+ * Thread-local Storage and Relaxed Atomics
+ *
+ * Used for statistics counters: the value only needs to be eventually
+ * consistent, so no ordering is imposed on surrounding memory.
+ * ============================================================ */
+
+#if WTREE_MSVC
+#include <intrin.h>
+#define WTREE_THREAD_LOCAL      __declspec(thread)
+#define WTREE_ATOMIC_ADD(p, v)  ((void)_InterlockedExchangeAdd64((volatile __int64 *)(p), (__int64)(v)))
+#define WTREE_ATOMIC_LOAD(p)    ((uint64_t)_InterlockedOr64((volatile __int64 *)(p), 0))
+#define WTREE_ATOMIC_STORE(p, v) ((void)_InterlockedExchange64((volatile __int64 *)(p), (__int64)(v)))
+#else
+#define WTREE_THREAD_LOCAL      _Thread_local
+#define WTREE_ATOMIC_ADD(p, v)  ((void)__atomic_fetch_add((p), (v), __ATOMIC_RELAXED))
+#define WTREE_ATOMIC_LOAD(p)    __atomic_load_n((p), __ATOMIC_RELAXED)
+#define WTREE_ATOMIC_STORE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#endif
+
+/* ============================================================
+ * Ordered Atomics
+ *
+ * Used where one thread publishes data to another (lock-free queues):
+ * a release store makes the writes before it visible to an acquire
+ * load of the same location. CAS returns true if *p held expected.
+ * ============================================================ */
+
+#if WTREE_MSVC
+#define WTREE_ATOMIC_LOAD_ACQ(p)     ((uint64_t)_InterlockedOr64((volatile __int64 *)(p), 0))
+#define WTREE_ATOMIC_STORE_REL(p, v) ((void)_InterlockedExchange64((volatile __int64 *)(p), (__int64)(v)))
+#define WTREE_ATOMIC_CAS(p, e, d) \
+    (_InterlockedCompareExchange64((volatile __int64 *)(p), (__int64)(d), (__int64)(e)) == (__int64)(e))
+#else
+#define WTREE_ATOMIC_LOAD_ACQ(p)     __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define WTREE_ATOMIC_STORE_REL(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define WTREE_ATOMIC_CAS(p, e, d)    __sync_bool_compare_and_swap((p), (e), (d))
+#endif
+
 /* ============================================================
  * Restrict Pointer (C99)
  * ============================================================ */
@@ -260,5 +300,12 @@
 #define MONGOLITE_ASSUME(cond)      WTREE_ASSUME(cond)
 #define MONGOLITE_CHECK(cond)       WTREE_CHECK(cond)
 #define MONGOLITE_SUCCESS(cond)     WTREE_SUCCESS(cond)
+#define MONGOLITE_THREAD_LOCAL      WTREE_THREAD_LOCAL
+#define MONGOLITE_ATOMIC_ADD(p, v)  WTREE_ATOMIC_ADD(p, v)
+#define MONGOLITE_ATOMIC_LOAD(p)    WTREE_ATOMIC_LOAD(p)
+#define MONGOLITE_ATOMIC_STORE(p, v) WTREE_ATOMIC_STORE(p, v)
+#define MONGOLITE_ATOMIC_LOAD_ACQ(p)     WTREE_ATOMIC_LOAD_ACQ(p)
+#define MONGOLITE_ATOMIC_STORE_REL(p, v) WTREE_ATOMIC_STORE_REL(p, v)
+#define MONGOLITE_ATOMIC_CAS(p, e, d)    WTREE_ATOMIC_CAS(p, e, d)
 
 #endif /* MACROS */
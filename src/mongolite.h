@@ -17,6 +17,9 @@ extern "C" {
 
 typedef struct mongolite_db mongolite_db_t;
 typedef struct mongolite_cursor mongolite_cursor_t;
+typedef struct mongolite_collection mongolite_collection_t;
+typedef struct mongolite_stmt mongolite_stmt_t;
+typedef struct mongolite_session mongolite_session_t;
 
 /* ============================================================
  * Configuration Structures
@@ -25,6 +28,37 @@ typedef struct mongolite_cursor mongolite_cursor_t;
  * Structures are designed for extensibility (add new fields at end).
  * ============================================================ */
 
+/*
+ * Durability level (db_config_t.durability)
+ *
+ * ASYNC and NONE open LMDB with MDB_NOSYNC: commits return before they
+ * reach disk and a crash loses the unsynced tail (on filesystems that do
+ * not preserve write order it may also corrupt the file, see LMDB docs).
+ * Syncs are ordered: once commit X is durable, so is every commit before it.
+ */
+typedef enum {
+    MONGOLITE_DURABILITY_FULL = 0,  /* Every commit synced before it returns */
+    MONGOLITE_DURABILITY_ASYNC,     /* Background sync every interval or N bytes */
+    MONGOLITE_DURABILITY_NONE       /* Synced only by mongolite_sync / wait / close */
+} mongolite_durability_t;
+
+/*
+ * Map growth decision (db_config_t.map_growth_fn)
+ *
+ * Called with no transaction open: after commits, before large batches
+ * (need_bytes > 0) and when a write hit MDB_MAP_FULL (map_full). Returns
+ * the new map size in bytes; 0 or <= map_size keeps the current map, which
+ * fails the write when map_full. map_max_bytes still caps the result.
+ */
+typedef struct {
+    size_t map_size;            /* Current map size */
+    size_t used_bytes;          /* Pages in use up to the last commit */
+    size_t need_bytes;          /* Estimated size of the next write (0 = unknown) */
+    bool map_full;              /* A write failed with MDB_MAP_FULL */
+} mongolite_map_usage_t;
+
+typedef size_t (*mongolite_map_growth_fn)(const mongolite_map_usage_t *usage, void *ctx);
+
 /*
  * Database configuration (passed to mongolite_open)
  *
@@ -49,6 +83,66 @@ typedef struct db_config {
 
     /* Reserved for future expansion */
     void *_reserved[4];
+
+    /* Newer fields follow _reserved, so the fields above keep their offsets */
+
+    /* Query planner */
+    bool disable_plan_cache;    /* Re-plan every query (default: cache plans by shape) */
+
+    /* Parallel scan: filtered find / count / delete_many that scan a whole
+     * collection split it across worker threads */
+    unsigned int scan_threads;          /* Worker threads (default: 0, < 2 = serial) */
+    uint64_t scan_parallel_min_docs;    /* Smaller collections scan serially (default: 100000) */
+
+    /* Readahead: scans ask the OS for the pages ahead of the cursor, index
+     * lookups for a batch of documents at once (helps when data > RAM) */
+    size_t readahead_bytes;             /* Window per hint (default: 1MB) */
+    bool disable_readahead;             /* No hints (default: on) */
+
+    /* Instrumentation */
+    bool disable_stats;         /* Skip counters and latency timing (default: on) */
+
+    /* Slow-operation log: find / find_one / count / update / delete calls at
+     * least this slow, plus a sampled fraction of all of them, are queued
+     * for mongolite_slowlog_drain (both 0 = off) */
+    uint64_t slowlog_threshold_us;      /* Log calls this slow (0 = none by time) */
+    double slowlog_sample_rate;         /* Also log this fraction of calls, 0..1 (default: 0) */
+    unsigned int slowlog_capacity;      /* Queued entries before new ones drop (default: 1024) */
+
+    /* Group commit: concurrent auto-commit insert_one / update_one /
+     * replace_one / delete_one calls share one transaction and one sync */
+    bool group_commit;                  /* Coalesce concurrent writers (default: off) */
+    unsigned int group_commit_max_ops;  /* Writes per transaction (default: 128) */
+    unsigned int group_commit_wait_us;  /* Leader waits for more writers (default: 0) */
+
+    /* Change feed: inserts, updates, replaces and deletes are also written,
+     * in the same transaction, to a sequence-numbered log read through
+     * mongolite_change_stream_* */
+    bool change_feed;                   /* Record changes (default: off) */
+    uint64_t change_feed_max_entries;   /* Keep about this many (0 = no limit) */
+    uint64_t change_feed_max_age_ms;    /* Trim entries older than this (0 = no limit) */
+
+    /* Durability */
+    mongolite_durability_t durability;  /* Default: MONGOLITE_DURABILITY_FULL */
+    unsigned int sync_interval_ms;      /* ASYNC: sync period (default: 100) */
+    size_t sync_bytes;                  /* ASYNC: also sync after this many bytes (0 = off) */
+
+    /* Map growth: grow ahead of use instead of failing and replaying writes.
+     * A write still fails with MAP_FULL, and is retried after growing
+     * (counted in mongolite_stats_t.map_full_replays), when it outgrows the
+     * headroom left by the threshold, when a batch outgrows its estimate,
+     * or when an open session, cursor or backup kept growth from running. */
+    unsigned int map_grow_at_percent;   /* Grow once this % is used (default: 90, 100 = only when full) */
+    size_t map_growth_step;             /* Grow by this many bytes (0 = use map_growth_percent) */
+    unsigned int map_growth_percent;    /* Grow by this % of the map (default: 100) */
+    size_t map_max_bytes;               /* Never grow past this (0 = no cap) */
+    mongolite_map_growth_fn map_growth_fn;  /* Replaces the policy above (NULL = built in) */
+    void *map_growth_ctx;
+
+    /* Writes while another thread's write session is open wait for it:
+     * 0 = until it ends, > 0 = up to this long, < 0 = not at all
+     * (then MONGOLITE_EBUSY) */
+    int busy_timeout_ms;
 } db_config_t;
 
 /*
@@ -119,6 +213,15 @@ void mongolite_collection_list_free(char **list, size_t count);
 int64_t mongolite_collection_count(mongolite_db_t *db, const char *collection,
                                    const bson_t *filter, gerror_t *error);
 
+// Prepared collection handles
+// Resolve a collection once and reuse it on hot paths (skips the name lookup).
+// Handles stay valid across drop/re-create of the collection, but must be
+// closed before mongolite_close().
+mongolite_collection_t* mongolite_collection_open(mongolite_db_t *db, const char *name,
+                                                  gerror_t *error);
+void mongolite_collection_close(mongolite_collection_t *col);
+const char* mongolite_collection_name(const mongolite_collection_t *col);
+
 // ============= Document Operations =============
 
 // Insert
@@ -134,6 +237,16 @@ int mongolite_insert_one_json(mongolite_db_t *db, const char *collection,
 int mongolite_insert_many_json(mongolite_db_t *db, const char *collection,
                          const char **json_strs, size_t n_docs, 
                          bson_oid_t **inserted_ids, gerror_t *error);
+
+// Bulk insert from newline-delimited JSON (one document per line, blank
+// lines skipped), in batches of batch_size documents (0 = 1000). Each
+// batch is its own insert_many; on failure earlier batches stay inserted
+// (inside an explicit transaction nothing is committed until commit).
+// *n_inserted (may be NULL) counts the documents inserted. Parse errors
+// name the line.
+int mongolite_insert_ndjson(mongolite_db_t *db, const char *collection,
+                            const char *data, size_t len, size_t batch_size,
+                            int64_t *n_inserted, gerror_t *error);
 // Find
 bson_t* mongolite_find_one(mongolite_db_t *db, const char *collection,
                            const bson_t *filter, const bson_t *projection,
@@ -150,6 +263,28 @@ char** mongolite_find_json(mongolite_db_t *db, const char *collection,
                                    const char *filter_json, const char *projection_json,
                                    gerror_t *error);
 
+// Look up n_ids documents by _id in one batch. docs[i] is the document for
+// ids[i] (caller destroys it) or NULL if there is none.
+int mongolite_find_many_by_id(mongolite_db_t *db, const char *collection,
+                              const bson_oid_t *ids, size_t n_ids, bson_t **docs,
+                              gerror_t *error);
+
+// Plan cache counters for a collection (plans served from cache / computed)
+int mongolite_plan_cache_stats(mongolite_db_t *db, const char *collection,
+                               uint64_t *hits, uint64_t *replans, gerror_t *error);
+
+// Run a find and report how it was answered (caller destroys the result):
+//   queryPlanner:   namespace, filter, sort, projection, planCacheHit,
+//                   winningPlan (COLLSCAN, or FETCH over IXSCAN / ID_LOOKUP /
+//                   AND_SORTED / OR / TEXT / GEO_NEAR / GEO_WITHIN stages
+//                   with their bounds) and
+//                   candidates (every index, chosen or why it was rejected)
+//   executionStats: nReturned, keysExamined, docsExamined, executionTimeMicros
+// Cursors do not apply sort and projection yet; they are reported as given.
+bson_t* mongolite_explain(mongolite_db_t *db, const char *collection,
+                          const bson_t *filter, const bson_t *sort,
+                          const bson_t *projection, gerror_t *error);
+
 // Update
 int mongolite_update_one(mongolite_db_t *db, const char *collection,
                          const bson_t *filter, const bson_t *update,
@@ -188,19 +323,118 @@ int mongolite_delete_many(mongolite_db_t *db, const char *collection,
                          const bson_t *filter, int64_t *deleted_count, 
                          gerror_t *error);
 
+// Handle-based variants (same semantics as the name-based calls above)
+int mongolite_col_insert_one(mongolite_collection_t *col, const bson_t *doc,
+                             bson_oid_t *inserted_id, gerror_t *error);
+bson_t* mongolite_col_find_one(mongolite_collection_t *col, const bson_t *filter,
+                               const bson_t *projection, gerror_t *error);
+mongolite_cursor_t* mongolite_col_find(mongolite_collection_t *col, const bson_t *filter,
+                                       const bson_t *projection, gerror_t *error);
+int mongolite_col_find_many_by_id(mongolite_collection_t *col, const bson_oid_t *ids,
+                                  size_t n_ids, bson_t **docs, gerror_t *error);
+int64_t mongolite_col_count(mongolite_collection_t *col, const bson_t *filter,
+                            gerror_t *error);
+
+// ============= Prepared Queries =============
+
+// mongolite_step() result codes (similar to SQLite)
+#define MONGOLITE_ROW   100     // A document is available
+#define MONGOLITE_DONE  101     // No more documents
+
+// Compile a filter once and execute it many times. Placeholders are written
+// as {"$param": N} (N = 1-based parameter number) wherever a value may appear:
+//   {"email": {"$param": 1}, "age": {"$gt": {"$param": 2}}}
+// Steps return whole documents: projection must be NULL or empty
+// (otherwise MONGOLITE_EINVAL).
+mongolite_stmt_t* mongolite_prepare(mongolite_db_t *db, const char *collection,
+                                   const bson_t *filter, const bson_t *projection,
+                                   gerror_t *error);
+void mongolite_finalize(mongolite_stmt_t *stmt);
+
+// Bind values (rebinding resets an in-progress execution)
+int mongolite_bind_count(mongolite_stmt_t *stmt);
+int mongolite_bind_value(mongolite_stmt_t *stmt, int index, const bson_value_t *value);
+int mongolite_bind_int32(mongolite_stmt_t *stmt, int index, int32_t value);
+int mongolite_bind_int64(mongolite_stmt_t *stmt, int index, int64_t value);
+int mongolite_bind_double(mongolite_stmt_t *stmt, int index, double value);
+int mongolite_bind_bool(mongolite_stmt_t *stmt, int index, bool value);
+int mongolite_bind_null(mongolite_stmt_t *stmt, int index);
+int mongolite_bind_utf8(mongolite_stmt_t *stmt, int index, const char *value);
+int mongolite_bind_oid(mongolite_stmt_t *stmt, int index, const bson_oid_t *value);
+int mongolite_clear_bindings(mongolite_stmt_t *stmt);
+
+// Returns MONGOLITE_ROW (doc valid until the next step/reset), MONGOLITE_DONE,
+// or a negative error code
+int mongolite_step(mongolite_stmt_t *stmt, const bson_t **doc, gerror_t *error);
+int mongolite_reset(mongolite_stmt_t *stmt);
+
 // ============= Cursor Operations =============
 
 bool mongolite_cursor_next(mongolite_cursor_t *cursor, const bson_t **doc);
 bool mongolite_cursor_more(mongolite_cursor_t *cursor);
+// After cursor_next returns false: MONGOLITE_OK at the end of the results,
+// or the error code (and message in error) of a read that failed first
+int mongolite_cursor_error(const mongolite_cursor_t *cursor, gerror_t *error);
 void mongolite_cursor_destroy(mongolite_cursor_t *cursor);
 
+// Write the cursor's remaining documents as extended JSON to a sink,
+// without building a string per document: output goes through one reused
+// buffer, handed over in chunks of about chunk_bytes. opts may be NULL
+// (relaxed JSON array). The cursor is left exhausted; the caller still
+// destroys it. *n_docs (may be NULL) counts the documents written.
+typedef enum {
+    MONGOLITE_JSON_ARRAY = 0,           // [doc,doc,...]
+    MONGOLITE_JSON_LINES                // one document per line (NDJSON)
+} mongolite_json_format_t;
+
+typedef enum {
+    MONGOLITE_JSON_RELAXED = 0,         // plain numbers, ISO-8601 dates
+    MONGOLITE_JSON_CANONICAL            // type-preserving ({"$numberInt":"1"})
+} mongolite_json_mode_t;
+
+typedef struct {
+    mongolite_json_format_t format;
+    mongolite_json_mode_t mode;
+    size_t chunk_bytes;                 // Sink call size (default: 64KB)
+} mongolite_json_opts_t;
+
+// Returns non-zero to stop (the write then fails with MONGOLITE_ECANCELED)
+typedef int (*mongolite_json_sink_fn)(const char *data, size_t len, void *ctx);
+
+int mongolite_cursor_write_json(mongolite_cursor_t *cursor, const mongolite_json_opts_t *opts,
+                                mongolite_json_sink_fn sink, void *ctx,
+                                int64_t *n_docs, gerror_t *error);
+// Same, written to a file descriptor (socket, pipe, file); MONGOLITE_EIO
+// if a write fails
+int mongolite_cursor_write_json_fd(mongolite_cursor_t *cursor, const mongolite_json_opts_t *opts,
+                                   int fd, int64_t *n_docs, gerror_t *error);
+
 // Cursor modifiers (before iteration)
 int mongolite_cursor_set_limit(mongolite_cursor_t *cursor, int64_t limit);
 int mongolite_cursor_set_skip(mongolite_cursor_t *cursor, int64_t skip);
 int mongolite_cursor_set_sort(mongolite_cursor_t *cursor, const bson_t *sort);
+// Parallel scans return documents in _id order; false lets them come in
+// as ranges finish (no effect on serial cursors)
+int mongolite_cursor_set_ordered(mongolite_cursor_t *cursor, bool ordered);
 
 // ============= Index Operations =============
 
+// Ordered indexes ({"tags": 1}, {"a": 1, "b.c": -1}) are multi-key: an array
+// field is indexed once per element, so {tags: "red"} finds documents whose
+// tags hold "red", and a compound index holds every combination of its
+// fields' elements. A document may have at most 1024 keys in an index (the
+// write fails beyond that); on a unique index no two documents may share
+// an element. Indexes created before multi-key support hold whole arrays as
+// keys: they are maintained (and still enforce uniqueness) but queries do not
+// use them; drop and re-create them to index the elements.
+//
+// Keys whose values are all "text" ({"title": "text", "body": "text"}) make
+// the collection's text index (one per collection, not unique): an inverted
+// index of the lowercased terms of those string fields, which answers
+// top-level {$text: {$search: "..."}} filters (documents holding every term).
+// {"loc": "2dsphere"} (or "2d") makes a geo index of the points in one field,
+// [x, y] pairs or GeoJSON Points (not unique): it answers $geoWithin ($box,
+// $polygon) and $near, which then returns the nearest documents first
 int mongolite_create_index(mongolite_db_t *db, const char *collection,
                           const bson_t *keys, const char *name,
                           index_config_t *config, gerror_t *error);
@@ -208,8 +442,54 @@ int mongolite_create_index(mongolite_db_t *db, const char *collection,
 int mongolite_drop_index(mongolite_db_t *db, const char *collection,
                         const char *index_name, gerror_t *error);
 
+// Planner statistics of one index. The planner picks the index with the
+// fewest estimated entries to read; statistics are built with the index,
+// persisted by mongolite_analyze, and rebuilt and persisted after the
+// commit that leaves the index grown or shrunk by more than its analyzed
+// size (never while planning a query).
+typedef struct {
+    uint64_t entries;           // index entries when analyzed
+    uint64_t distinct_keys;     // distinct keys when analyzed
+    uint32_t histogram_buckets; // equi-depth buckets over the keys
+    bool analyzed;              // false: estimates are heuristic
+} mongolite_index_stats_t;
+
+// Rebuild and persist the statistics of every index on a collection
+// (every collection when collection is NULL)
+int mongolite_analyze(mongolite_db_t *db, const char *collection, gerror_t *error);
+int mongolite_index_stats(mongolite_db_t *db, const char *collection,
+                          const char *index_name, mongolite_index_stats_t *out,
+                          gerror_t *error);
+
+// ============= Sessions =============
+
+// A session owns one transaction and is bound to the thread that begins
+// it: every call that thread makes on the database runs inside the
+// session until it ends. Other threads are not affected.
+//
+// Snapshot sessions see one consistent view across all their queries;
+// any number can be open on different threads, alongside a writer.
+// A write session holds the single writer: while it is open, writes and
+// schema changes from other threads wait for it to end, or fail with
+// MONGOLITE_EBUSY (-1012) after db_config_t.busy_timeout_ms.
+// A thread has at most one session; cursors and statements used inside a
+// session must be finished before it ends.
+typedef enum {
+    MONGOLITE_SESSION_SNAPSHOT = 0,
+    MONGOLITE_SESSION_WRITE
+} mongolite_session_mode_t;
+
+mongolite_session_t* mongolite_session_begin(mongolite_db_t *db,
+                                             mongolite_session_mode_t mode,
+                                             gerror_t *error);
+// Commit (write) or release (snapshot), then free the session
+int mongolite_session_commit(mongolite_session_t *session, gerror_t *error);
+// Discard all changes, then free the session
+void mongolite_session_abort(mongolite_session_t *session);
+
 // ============= Transaction Support (Optional) =============
 
+// Write session bound to the calling thread (see Sessions)
 int mongolite_begin_transaction(mongolite_db_t *db);
 int mongolite_commit(mongolite_db_t *db);
 int mongolite_rollback(mongolite_db_t *db);
@@ -219,6 +499,136 @@ int mongolite_rollback(mongolite_db_t *db);
 mongolite_cursor_t* mongolite_aggregate(mongolite_db_t *db, const char *collection,
                                        const bson_t *pipeline, gerror_t *error);
 
+// ============= Statistics =============
+
+// Operations with a latency histogram
+typedef enum {
+    MONGOLITE_OP_FIND_ONE = 0,
+    MONGOLITE_OP_FIND,          // cursor creation (iteration is not timed)
+    MONGOLITE_OP_COUNT,
+    MONGOLITE_OP_INSERT,
+    MONGOLITE_OP_UPDATE,        // update/replace/find_and_modify
+    MONGOLITE_OP_DELETE,
+    MONGOLITE_OP_COMMIT,
+    MONGOLITE_OP_MAX
+} mongolite_op_t;
+
+// Log-linear (HDR-style) buckets over nanoseconds: 4 sub-buckets per power
+// of two, covering up to ~36 minutes
+#define MONGOLITE_LATENCY_BUCKETS 160
+
+typedef struct {
+    uint64_t count;
+    uint64_t total_ns;
+    uint64_t max_ns;
+    uint64_t buckets[MONGOLITE_LATENCY_BUCKETS];
+} mongolite_latency_t;
+
+// Query counters (per collection and database-wide)
+typedef struct {
+    uint64_t id_queries;        // served by a direct _id lookup
+    uint64_t index_queries;     // served by a secondary index
+    uint64_t scan_queries;      // fell back to a full collection scan
+    uint64_t docs_scanned;      // documents read to answer queries
+    uint64_t docs_returned;     // documents matched (returned or written)
+    uint64_t matcher_evals;     // filter evaluations
+} mongolite_op_stats_t;
+
+typedef struct {
+    mongolite_op_stats_t totals;
+    mongolite_latency_t latency[MONGOLITE_OP_MAX];
+
+    uint64_t read_txn_begins;   // fresh read transactions
+    uint64_t read_txn_renews;   // pooled read transactions renewed
+    uint64_t write_txn_begins;
+    uint64_t resizes;           // map-full resize attempts
+    uint64_t map_grows;         // proactive map growths (before the map filled)
+    uint64_t map_full_replays;  // writes retried after MAP_FULL (growth ahead fell short)
+    uint64_t parallel_scans;    // scans split across worker threads
+    uint64_t readahead_hints;   // prefetch hints given to the OS
+    uint64_t index_intersections; // seeks that merge-joined several indexes
+    uint64_t index_analyses;    // index statistics rebuilt
+    uint64_t group_commits;     // group commit transactions
+    uint64_t group_ops;         // writes applied through group commit
+    uint64_t syncs;             // explicit and background syncs (ASYNC / NONE)
+    uint64_t slow_ops;          // operations queued in the slow-operation log
+    uint64_t slow_ops_dropped;  // ... dropped because the log was full
+
+    uint64_t lock_acquires;
+    uint64_t lock_contended;    // acquisitions that had to wait
+    uint64_t lock_wait_ns;      // total time spent waiting for the lock
+} mongolite_stats_t;
+
+// Snapshot of database-wide counters (summed over per-thread shards)
+int mongolite_stats(mongolite_db_t *db, mongolite_stats_t *out, gerror_t *error);
+// Counters for one open collection (zero until first use after open)
+int mongolite_collection_stats(mongolite_db_t *db, const char *collection,
+                               mongolite_op_stats_t *out, gerror_t *error);
+void mongolite_stats_reset(mongolite_db_t *db);
+
+// Latency at a percentile (0-100), as the upper bound of its bucket in ns
+uint64_t mongolite_latency_percentile(const mongolite_latency_t *latency, double percentile);
+
+// ============= Slow-Operation Log =============
+
+#define MONGOLITE_SLOWLOG_NAME_MAX  64
+#define MONGOLITE_SLOWLOG_SHAPE_MAX 256
+
+// One logged operation. shape is the filter with its values replaced by
+// their types (the plan cache key), truncated to fit.
+typedef struct {
+    mongolite_op_t op;
+    const char *plan;               // COLLSCAN, ID_LOOKUP, IXSCAN, IXSEEK or NONE (static)
+    char collection[MONGOLITE_SLOWLOG_NAME_MAX];
+    char shape[MONGOLITE_SLOWLOG_SHAPE_MAX];
+    uint64_t duration_ns;           // find: cursor creation plus time in cursor_next
+    uint64_t lock_wait_ns;          // spent waiting for the database lock
+    uint64_t keys_examined;         // index entries read
+    uint64_t docs_examined;
+    uint64_t docs_returned;         // returned, or matched by an update / delete
+    bool sampled;                   // under the threshold, logged by sampling
+} mongolite_slow_op_t;
+
+typedef void (*mongolite_slowlog_fn)(const mongolite_slow_op_t *op, void *ctx);
+
+// Pass each queued entry to fn, oldest first, and remove it. Returns the
+// number drained; entries queued meanwhile may be left for the next call.
+// find entries are queued when their cursor is destroyed.
+size_t mongolite_slowlog_drain(mongolite_db_t *db, mongolite_slowlog_fn fn, void *ctx);
+
+// ============= Change Feed =============
+
+// Each change is a document {seq, ts, op, ns, _id, doc}: op is "insert",
+// "update", "replace" or "delete", ns the collection, doc the document as
+// written (absent for deletes). seq numbers are consecutive. Retention
+// trims the oldest entries as writes come in; the newest is always kept.
+typedef struct mongolite_change_stream mongolite_change_stream_t;
+
+// Stream the changes after after_seq (0 = from the oldest kept). Fails
+// with MONGOLITE_EINVAL when the database was opened without change_feed.
+mongolite_change_stream_t* mongolite_change_stream_open(mongolite_db_t *db, uint64_t after_seq,
+                                                        gerror_t *error);
+
+// Next change, waiting up to timeout_ms for one to commit (0 = poll,
+// < 0 = forever); MONGOLITE_ETIMEDOUT if none did. *change is valid
+// until the next call. MONGOLITE_ETRUNCATED if changes after the resume
+// point were trimmed before the stream read them. Waiting from inside a
+// session on the same thread only sees the session's snapshot.
+int mongolite_change_stream_next(mongolite_change_stream_t *stream, const bson_t **change,
+                                 int timeout_ms, gerror_t *error);
+
+// seq of the last change returned: reopen after it to resume
+uint64_t mongolite_change_stream_seq(const mongolite_change_stream_t *stream);
+
+// Close streams before the database
+void mongolite_change_stream_close(mongolite_change_stream_t *stream);
+
+// seq of the newest change (0 = none, or the feed is off)
+uint64_t mongolite_change_feed_last_seq(mongolite_db_t *db);
+
+// Drop changes up to through_seq (the newest one is kept)
+int mongolite_change_feed_truncate(mongolite_db_t *db, uint64_t through_seq, gerror_t *error);
+
 // ============= Utility =============
 
 const char* mongolite_version(void);
@@ -227,6 +637,46 @@ const char* mongolite_errstr(int error_code);
 // Database sync (flush to disk)
 int mongolite_sync(mongolite_db_t *db, bool force, gerror_t *error);
 
+// ============= Durability =============
+
+// Id of the latest committed write transaction (grows with every commit;
+// read it after a write to get an id that covers that write)
+uint64_t mongolite_commit_id(mongolite_db_t *db);
+// Id of the latest commit known to be on disk
+uint64_t mongolite_durable_id(mongolite_db_t *db);
+// Block until commit_id (0 = latest) is on disk, syncing early if needed.
+// timeout_ms < 0 waits forever; returns MONGOLITE_ETIMEDOUT on timeout.
+int mongolite_wait_durable(mongolite_db_t *db, uint64_t commit_id, int timeout_ms,
+                           gerror_t *error);
+
+// ============= Backup / Compaction =============
+
+// mongolite_backup flags
+#define MONGOLITE_BACKUP_COMPACT 0x01   // Skip free pages (smaller, slower copy)
+
+// Progress: bytes written so far and the expected total (an upper bound
+// when compacting). Return non-zero to cancel the backup.
+typedef int (*mongolite_backup_progress_fn)(uint64_t bytes_done, uint64_t bytes_total,
+                                            void *ctx);
+
+typedef struct {
+    mongolite_backup_progress_fn progress;  // NULL = no reports
+    void *progress_ctx;
+    uint64_t max_bytes_per_sec;             // Throttle writes (0 = unthrottled)
+} mongolite_backup_opts_t;
+
+// Copy the database to dest (a new or empty directory) from a read
+// snapshot; writers keep going. The copy opens with mongolite_open.
+// opts may be NULL. Returns MONGOLITE_ECANCELED if progress stopped it.
+int mongolite_backup(mongolite_db_t *db, const char *dest, unsigned int flags,
+                     const mongolite_backup_opts_t *opts, gerror_t *error);
+// Rewrite the data file without free pages and reopen it (offline: no
+// session, cursor or backup may be open). Commit ids restart afterwards.
+// The copy is checked to open before it replaces the file; should the
+// reopen still fail, every call on db fails with MONGOLITE_EIO until
+// mongolite_close.
+int mongolite_compact(mongolite_db_t *db, gerror_t *error);
+
 // BSON helpers specific to mongolite
 bson_t* mongolite_matcher_regex(const char *field, const char *pattern, const char *options);
 bson_t* mongolite_matcher_in(const char *field, const bson_t *values);
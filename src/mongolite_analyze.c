@@ -0,0 +1,398 @@
+/*
+ * mongolite_analyze.c - Index statistics for the query planner
+ *
+ * Handles:
+ * - Building an equi-depth histogram over an index's keys
+ * - Persisting it with the index metadata (mongolite_analyze)
+ * - Estimating index entries per key for the planner
+ * - Rebuilding statistics that drifted, checked after commits as writes
+ *   accumulate
+ *
+ * Building walks the distinct keys of the index DBI; mdb_cursor_count
+ * gives each key's duplicates, so no document is read. The histogram
+ * keeps up to MONGOLITE_HIST_BUCKETS buckets of about equal entry
+ * counts; a key holding a bucket's worth of entries closes the bucket
+ * before it and gets its own, which is what separates {country: "US"}
+ * from a rare country on skewed data.
+ *
+ * A drifted index is rebuilt only once it has changed by more than its
+ * analyzed size, so the walk is paid back by the writes that caused it.
+ * That happens after a commit, in a write transaction of its own, never
+ * while planning a query; the result is persisted like mongolite_analyze.
+ *
+ * Persisted format (native byte order, as the wtree3 metadata):
+ *   [version:4][n_buckets:4][entries:8][keys:8]
+ *   n_buckets x [rows:8][keys:8][key_len:4][key:N]
+ */
+
+#include "mongolite_internal.h"
+#include "macros.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define MONGOLITE_LIB "mongolite"
+
+#define MONGOLITE_HIST_VERSION  1
+#define MONGOLITE_HIST_BUCKETS  32
+#define MONGOLITE_HIST_MAX      (2 * MONGOLITE_HIST_BUCKETS + 1)  /* With heavy keys split out */
+#define HIST_HEADER_SIZE        24
+#define HIST_BUCKET_HEADER_SIZE 20
+
+/* Drift check cadence, and the smallest drift worth a rebuild */
+#define MONGOLITE_ANALYZE_CHECK_BYTES (64 * 1024)
+#define MONGOLITE_ANALYZE_MIN_ROWS    128
+
+/* Entries per key assumed for an index that was never analyzed; each
+ * further key field is taken as ten times more selective */
+#define MONGOLITE_EST_UNKNOWN   1e6
+
+/* ============================================================
+ * Building
+ * ============================================================ */
+
+typedef struct {
+    uint8_t *data;
+    size_t len;
+    size_t cap;
+} hist_buf_t;
+
+static bool _buf_put(hist_buf_t *b, const void *data, size_t len) {
+    if (b->len + len > b->cap) {
+        size_t cap = b->cap ? b->cap : 512;
+        while (cap < b->len + len) cap *= 2;
+        uint8_t *tmp = realloc(b->data, cap);
+        if (!tmp) return false;
+        b->data = tmp;
+        b->cap = cap;
+    }
+    memcpy(b->data + b->len, data, len);
+    b->len += len;
+    return true;
+}
+
+static bool _buf_bucket(hist_buf_t *b, uint64_t rows, uint64_t keys, const MDB_val *upper) {
+    uint32_t key_len = (uint32_t)upper->mv_size;
+    return _buf_put(b, &rows, 8) && _buf_put(b, &keys, 8) && _buf_put(b, &key_len, 4) &&
+           _buf_put(b, upper->mv_data, upper->mv_size);
+}
+
+/* Serialized statistics of one index DBI, read in mtxn. Returns an
+ * MDB error code or MONGOLITE_ENOMEM; *out is malloc'd. */
+static int _hist_build(MDB_txn *mtxn, MDB_dbi dbi, uint8_t **out, size_t *out_len) {
+    MDB_stat st;
+    int rc = mdb_stat(mtxn, dbi, &st);
+    if (rc != MDB_SUCCESS) return rc;
+
+    uint64_t depth = (st.ms_entries + MONGOLITE_HIST_BUCKETS - 1) / MONGOLITE_HIST_BUCKETS;
+    if (depth == 0) depth = 1;
+
+    MDB_cursor *cursor = NULL;
+    rc = mdb_cursor_open(mtxn, dbi, &cursor);
+    if (rc != MDB_SUCCESS) return rc;
+
+    hist_buf_t b = {0};
+    uint8_t header[HIST_HEADER_SIZE] = {0};
+    bool ok = _buf_put(&b, header, sizeof(header));
+
+    uint32_t n_buckets = 0;
+    uint64_t entries = 0, keys = 0, rows = 0, bucket_keys = 0;
+    MDB_val key, val, last = {0};
+    rc = mdb_cursor_get(cursor, &key, &val, MDB_FIRST);
+    while (ok && rc == MDB_SUCCESS) {
+        size_t dups = 0;
+        rc = mdb_cursor_count(cursor, &dups);
+        if (rc != MDB_SUCCESS) break;
+
+        /* A heavy key does not share its bucket with lighter ones */
+        if (bucket_keys > 0 && dups >= depth) {
+            ok = _buf_bucket(&b, rows, bucket_keys, &last);
+            n_buckets++;
+            rows = bucket_keys = 0;
+        }
+
+        rows += dups;
+        bucket_keys++;
+        entries += dups;
+        keys++;
+        last = key;                     /* Stays valid for the txn */
+
+        if (ok && rows >= depth) {
+            ok = _buf_bucket(&b, rows, bucket_keys, &last);
+            n_buckets++;
+            rows = bucket_keys = 0;
+        }
+        rc = mdb_cursor_get(cursor, &key, &val, MDB_NEXT_NODUP);
+    }
+    if (ok && rc == MDB_NOTFOUND && bucket_keys > 0) {
+        ok = _buf_bucket(&b, rows, bucket_keys, &last);
+        n_buckets++;
+    }
+    mdb_cursor_close(cursor);
+
+    if (!ok || (rc != MDB_SUCCESS && rc != MDB_NOTFOUND)) {
+        free(b.data);
+        return ok ? rc : MONGOLITE_ENOMEM;
+    }
+
+    uint32_t version = MONGOLITE_HIST_VERSION;
+    memcpy(b.data, &version, 4);
+    memcpy(b.data + 4, &n_buckets, 4);
+    memcpy(b.data + 8, &entries, 8);
+    memcpy(b.data + 16, &keys, 8);
+    *out = b.data;
+    *out_len = b.len;
+    return MDB_SUCCESS;
+}
+
+/* ============================================================
+ * Parsing and Estimates
+ * ============================================================ */
+
+mongolite_index_hist_t* _mongolite_hist_parse(const void *data, size_t len) {
+    if (!data || len < HIST_HEADER_SIZE) return NULL;
+
+    uint32_t version, n_buckets;
+    memcpy(&version, data, 4);
+    memcpy(&n_buckets, (const uint8_t *)data + 4, 4);
+    if (version != MONGOLITE_HIST_VERSION || n_buckets > MONGOLITE_HIST_MAX) return NULL;
+
+    mongolite_index_hist_t *hist = calloc(1, sizeof(*hist));
+    if (!hist) return NULL;
+    hist->blob = malloc(len);
+    hist->buckets = calloc(n_buckets ? n_buckets : 1, sizeof(mongolite_hist_bucket_t));
+    if (!hist->blob || !hist->buckets) {
+        _mongolite_hist_free(hist);
+        return NULL;
+    }
+    memcpy(hist->blob, data, len);
+    hist->blob_len = len;
+    memcpy(&hist->entries, hist->blob + 8, 8);
+    memcpy(&hist->keys, hist->blob + 16, 8);
+
+    size_t at = HIST_HEADER_SIZE;
+    for (uint32_t i = 0; i < n_buckets; i++) {
+        mongolite_hist_bucket_t *bk = &hist->buckets[i];
+        uint32_t key_len;
+        if (len - at < HIST_BUCKET_HEADER_SIZE) break;
+        memcpy(&bk->rows, hist->blob + at, 8);
+        memcpy(&bk->keys, hist->blob + at + 8, 8);
+        memcpy(&key_len, hist->blob + at + 16, 4);
+        at += HIST_BUCKET_HEADER_SIZE;
+        if (len - at < key_len || bk->keys == 0) break;
+        bk->upper = (MDB_val){.mv_size = key_len, .mv_data = hist->blob + at};
+        at += key_len;
+        hist->n_buckets++;
+    }
+    if (hist->n_buckets != n_buckets) {
+        _mongolite_hist_free(hist);
+        return NULL;
+    }
+    return hist;
+}
+
+void _mongolite_hist_free(mongolite_index_hist_t *hist) {
+    if (!hist) return;
+    free(hist->buckets);
+    free(hist->blob);
+    free(hist);
+}
+
+MONGOLITE_HOT
+double _mongolite_index_estimate(const mongolite_cached_index_t *index, const bson_t *key) {
+    const mongolite_index_hist_t *hist = index->hist;
+    if (index->unique) return 1.0;
+    if (!hist || hist->keys == 0) {
+        double est = MONGOLITE_EST_UNKNOWN;
+        for (uint32_t n = index->keys ? bson_count_keys(index->keys) : 1; n > 1; n--) est /= 10;
+        return est;
+    }
+
+    double avg = (double)hist->entries / (double)hist->keys;
+    if (!key) return avg;
+
+    /* First bucket whose last key is >= key */
+    MDB_val k = {.mv_size = key->len, .mv_data = (void *)bson_get_data(key)};
+    size_t lo = 0, hi = hist->n_buckets;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (_mongolite_index_compare(&hist->buckets[mid].upper, &k) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo == hist->n_buckets) return avg;  /* Past the last key analyzed */
+    return (double)hist->buckets[lo].rows / (double)hist->buckets[lo].keys;
+}
+
+/* ============================================================
+ * Analysis
+ * ============================================================ */
+
+/* Rebuild the statistics of one cached index in txn, persisting them
+ * when txn is a write transaction */
+static int _analyze_index(mongolite_db_t *db, mongolite_tree_cache_entry_t *entry,
+                          mongolite_cached_index_t *index, wtree3_txn_t *txn, gerror_t *error) {
+    uint8_t *blob = NULL;
+    size_t len = 0;
+    int rc = _hist_build(wtree3_txn_get_mdb(txn), index->dbi, &blob, &len);
+    if (rc == MONGOLITE_ENOMEM) {
+        set_error(error, "system", MONGOLITE_ENOMEM, "Failed to allocate index statistics");
+        return rc;
+    }
+    if (rc != MDB_SUCCESS) {
+        set_error(error, "lmdb", rc, "Failed to analyze index '%s': %s",
+                 index->name, mdb_strerror(rc));
+        return rc;
+    }
+
+    mongolite_index_hist_t *hist = _mongolite_hist_parse(blob, len);
+    if (!hist) {
+        free(blob);
+        set_error(error, "system", MONGOLITE_ENOMEM, "Failed to allocate index statistics");
+        return MONGOLITE_ENOMEM;
+    }
+
+    if (wtree3_txn_is_readonly(txn)) {
+        rc = 0;
+    } else {
+        rc = wtree3_tree_set_index_stats_txn(txn, entry->tree, index->name, blob, len, error);
+    }
+    free(blob);
+    if (rc != 0) {
+        _mongolite_hist_free(hist);
+        return _mongolite_translate_wtree3_error(rc);
+    }
+
+    _mongolite_hist_free(index->hist);
+    index->hist = hist;
+    MONGOLITE_STAT(db, index_analyses, 1);
+    return MONGOLITE_OK;
+}
+
+/* Has the index grown or shrunk by more than its analyzed size? */
+static bool _index_drifted(MDB_txn *mtxn, const mongolite_cached_index_t *index) {
+    MDB_stat st;
+    if (mdb_stat(mtxn, index->dbi, &st) != MDB_SUCCESS) return false;
+
+    uint64_t then = index->hist ? index->hist->entries : 0;
+    uint64_t now = st.ms_entries;
+    uint64_t drift = now > then ? now - then : then - now;
+    return drift > (then > MONGOLITE_ANALYZE_MIN_ROWS ? then : MONGOLITE_ANALYZE_MIN_ROWS);
+}
+
+/* Analyze and persist the indexes of a collection: index_name, or all
+ * when NULL, or only those that drifted */
+static int _analyze_entry(mongolite_db_t *db, mongolite_tree_cache_entry_t *entry,
+                          const char *index_name, bool drifted_only, gerror_t *error) {
+    size_t count = 0;
+    mongolite_cached_index_t *indexes = _mongolite_entry_indexes(db, entry, &count, error);
+    if (!indexes || count == 0) return MONGOLITE_OK;
+
+    wtree3_txn_t *txn = _mongolite_get_write_txn(db, error);
+    if (!txn) return MONGOLITE_ETXN;
+
+    int rc = MONGOLITE_OK;
+    size_t analyzed = 0;
+    for (size_t i = 0; i < count && rc == MONGOLITE_OK; i++) {
+        if (index_name && strcmp(indexes[i].name, index_name) != 0) continue;
+        if (drifted_only && !_index_drifted(wtree3_txn_get_mdb(txn), &indexes[i])) continue;
+        rc = _analyze_index(db, entry, &indexes[i], txn, error);
+        analyzed++;
+    }
+    if (rc != MONGOLITE_OK || analyzed == 0) {
+        _mongolite_abort_if_auto(db, txn);
+        return rc;
+    }
+
+    rc = _mongolite_commit_if_auto(db, txn, error);
+    if (rc != 0) return rc;
+
+    /* Plans chosen on the old estimates */
+    _mongolite_plan_cache_clear(entry);
+    entry->index_epoch++;
+    return MONGOLITE_OK;
+}
+
+int _mongolite_analyze_locked(mongolite_db_t *db, mongolite_tree_cache_entry_t *entry,
+                              const char *index_name, gerror_t *error) {
+    return _analyze_entry(db, entry, index_name, false, error);
+}
+
+void _mongolite_analyze_committed(mongolite_db_t *db) {
+    if (MONGOLITE_UNLIKELY(!db || !db->wdb) || db->analyzing || db->open_sessions > 0) return;
+
+    uint64_t written = wtree3_db_bytes_written(db->wdb);
+    if (MONGOLITE_LIKELY(written - db->analyze_clock < MONGOLITE_ANALYZE_CHECK_BYTES)) return;
+    db->analyze_clock = written;
+
+    /* The rebuilds commit too: keep them from checking again */
+    db->analyzing = true;
+    for (size_t i = 0; i < db->tree_cache_capacity; i++) {
+        mongolite_tree_cache_entry_t *entry = db->tree_cache[i];
+        if (entry) _analyze_entry(db, entry, NULL, true, NULL);
+    }
+    db->analyzing = false;
+}
+
+/* ============================================================
+ * Public API
+ * ============================================================ */
+
+int mongolite_analyze(mongolite_db_t *db, const char *collection, gerror_t *error) {
+    VALIDATE_PARAMS(db, error, "Database is required", MONGOLITE_EINVAL);
+
+    char **names = NULL;
+    size_t n = 0;
+    if (!collection) {
+        names = mongolite_collection_list(db, &n, error);
+        if (!names) return n == 0 ? MONGOLITE_OK : MONGOLITE_ERROR;
+    }
+
+    _mongolite_lock(db);
+    int rc = _mongolite_require_no_write_session(db, error);
+    for (size_t i = 0; rc == MONGOLITE_OK && i < (collection ? 1 : n); i++) {
+        const char *name = collection ? collection : names[i];
+        mongolite_tree_cache_entry_t *entry = _mongolite_get_collection_entry(db, name, error);
+        rc = entry ? _mongolite_analyze_locked(db, entry, NULL, error) : MONGOLITE_ENOTFOUND;
+    }
+    _mongolite_unlock(db);
+
+    mongolite_collection_list_free(names, n);
+    return rc;
+}
+
+int mongolite_index_stats(mongolite_db_t *db, const char *collection,
+                          const char *index_name, mongolite_index_stats_t *out,
+                          gerror_t *error) {
+    VALIDATE_PARAMS(db && collection && index_name && out, error,
+                   "Database, collection, index_name and out are required", MONGOLITE_EINVAL);
+    memset(out, 0, sizeof(*out));
+
+    _mongolite_lock(db);
+    mongolite_tree_cache_entry_t *entry = _mongolite_get_collection_entry(db, collection, error);
+    if (!entry) {
+        _mongolite_unlock(db);
+        return MONGOLITE_ENOTFOUND;
+    }
+
+    size_t count = 0;
+    mongolite_cached_index_t *indexes = _mongolite_entry_indexes(db, entry, &count, error);
+    for (size_t i = 0; indexes && i < count; i++) {
+        if (strcmp(indexes[i].name, index_name) != 0) continue;
+        const mongolite_index_hist_t *hist = indexes[i].hist;
+        if (hist) {
+            out->entries = hist->entries;
+            out->distinct_keys = hist->keys;
+            out->histogram_buckets = (uint32_t)hist->n_buckets;
+            out->analyzed = true;
+        }
+        _mongolite_unlock(db);
+        return MONGOLITE_OK;
+    }
+    _mongolite_unlock(db);
+
+    set_error(error, MONGOLITE_LIB, MONGOLITE_ENOTFOUND,
+             "Index '%s' not found on collection '%s'", index_name, collection);
+    return MONGOLITE_ENOTFOUND;
+}
@@ -0,0 +1,478 @@
+/*
+ * mongolite_backup.c - Hot backup and compaction
+ *
+ * Handles:
+ * - mongolite_backup: copy from a read snapshot (optionally compacting)
+ *   while writers continue, with progress reports and I/O throttling
+ * - mongolite_compact: compacting copy swapped in for the data file,
+ *   then the environment is reopened
+ *
+ * The copy itself is LMDB's (mdb_env_copyfd2). It runs on its own thread
+ * so it gets a fresh reader slot, whatever txns the caller's thread holds.
+ * With progress or throttling it writes into a pipe that this thread
+ * drains into the destination file.
+ */
+
+#include "mongolite_internal.h"
+#include "macros.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <direct.h>
+#include <io.h>
+#define mkdir(path, mode) _mkdir(path)
+#else
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#define MONGOLITE_LIB "mongolite"
+
+/* LMDB's file names inside an environment directory */
+#define MONGOLITE_DATA_FILE    "data.mdb"
+#define MONGOLITE_COMPACT_FILE "data.mdb.compact"
+
+/* Pipe drain chunk (progress granularity) */
+#define MONGOLITE_BACKUP_CHUNK (1024 * 1024)
+
+/* ============================================================
+ * Helpers
+ * ============================================================ */
+
+static char* _path_join(const char *dir, const char *name) {
+    size_t len = strlen(dir) + 1 + strlen(name) + 1;
+    char *path = malloc(len);
+    if (path) snprintf(path, len, "%s/%s", dir, name);
+    return path;
+}
+
+/* Pages in use as of the last commit (what a plain copy writes) */
+static uint64_t _bytes_in_use(mongolite_db_t *db) {
+    MDB_envinfo info;
+    MDB_stat stat;
+    uint64_t bytes = 0;
+
+    _mongolite_env_lock(db);
+    MDB_env *env = wtree3_db_get_env(db->wdb);
+    if (mdb_env_info(env, &info) == 0 && mdb_env_stat(env, &stat) == 0) {
+        bytes = (uint64_t)(info.me_last_pgno + 1) * stat.ms_psize;
+    }
+    _mongolite_env_unlock(db);
+    return bytes;
+}
+
+/* The copy's read txn lives outside the db lock: keep the map from moving
+ * under it (see _mongolite_try_resize) */
+static void _snapshot_hold(mongolite_db_t *db) {
+    _mongolite_lock(db);
+    MONGOLITE_ATOMIC_ADD(&db->cursor_txns, 1);
+    _mongolite_unlock(db);
+}
+
+static void _snapshot_release(mongolite_db_t *db) {
+    MONGOLITE_ATOMIC_ADD(&db->cursor_txns, (uint64_t)-1);
+}
+
+/* ============================================================
+ * Copy (POSIX: helper thread, optionally through a pipe)
+ * ============================================================ */
+
+#ifndef _WIN32
+
+typedef struct {
+    MDB_env *env;
+    int fd;                             /* Destination file or pipe write end */
+    unsigned int cp_flags;
+    bool close_fd;                      /* Pipe: close to signal EOF */
+    int rc;
+} copy_job_t;
+
+static void* _copy_main(void *arg) {
+    copy_job_t *job = arg;
+
+    /* A cancelled backup closes the pipe: fail the write, don't kill us */
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+
+    job->rc = mdb_env_copyfd2(job->env, job->fd, job->cp_flags);
+    if (job->close_fd) close(job->fd);
+    return NULL;
+}
+
+static uint64_t _monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int _write_all(int fd, const uint8_t *buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return errno;
+        }
+        buf += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+/* Drain the pipe into out_fd, reporting and pacing. Returns 0, an errno,
+ * or MONGOLITE_ECANCELED. */
+static int _drain(int pipe_fd, int out_fd, uint64_t total,
+                  const mongolite_backup_opts_t *opts) {
+    uint8_t *buf = malloc(MONGOLITE_BACKUP_CHUNK);
+    if (!buf) return ENOMEM;
+
+    uint64_t done = 0;
+    uint64_t start_ns = _monotonic_ns();
+    int rc = 0;
+
+    for (;;) {
+        ssize_t n = read(pipe_fd, buf, MONGOLITE_BACKUP_CHUNK);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            rc = errno;
+            break;
+        }
+        if (n == 0) break;
+
+        rc = _write_all(out_fd, buf, (size_t)n);
+        if (rc != 0) break;
+        done += (uint64_t)n;
+
+        if (opts->progress && opts->progress(done, total > done ? total : done,
+                                             opts->progress_ctx) != 0) {
+            rc = MONGOLITE_ECANCELED;
+            break;
+        }
+
+        /* Sleep off whatever is ahead of max_bytes_per_sec */
+        if (opts->max_bytes_per_sec > 0) {
+            uint64_t due_ns = done * 1000000000ULL / opts->max_bytes_per_sec;
+            uint64_t elapsed_ns = _monotonic_ns() - start_ns;
+            if (due_ns > elapsed_ns) {
+                uint64_t wait_ns = due_ns - elapsed_ns;
+                struct timespec ts = {(time_t)(wait_ns / 1000000000ULL),
+                                      (long)(wait_ns % 1000000000ULL)};
+                nanosleep(&ts, NULL);
+            }
+        }
+    }
+
+    free(buf);
+    return rc;
+}
+
+static int _copy_to_fd(mongolite_db_t *db, int out_fd, unsigned int cp_flags,
+                       const mongolite_backup_opts_t *opts, gerror_t *error) {
+    copy_job_t job = {
+        .env = wtree3_db_get_env(db->wdb),
+        .fd = out_fd,
+        .cp_flags = cp_flags,
+        .close_fd = false,
+        .rc = 0
+    };
+    bool piped = opts && (opts->progress || opts->max_bytes_per_sec > 0);
+    int pipe_fds[2] = {-1, -1};
+
+    if (piped) {
+        if (pipe(pipe_fds) != 0) {
+            set_error(error, "system", MONGOLITE_EIO, "Failed to create backup pipe");
+            return MONGOLITE_EIO;
+        }
+        job.fd = pipe_fds[1];
+        job.close_fd = true;
+    }
+
+    uint64_t total = _bytes_in_use(db);
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, _copy_main, &job) != 0) {
+        if (piped) {
+            close(pipe_fds[0]);
+            close(pipe_fds[1]);
+        }
+        set_error(error, "system", MONGOLITE_ERROR, "Failed to start backup thread");
+        return MONGOLITE_ERROR;
+    }
+
+    int drain_rc = 0;
+    if (piped) {
+        drain_rc = _drain(pipe_fds[0], out_fd, total, opts);
+        /* Early stop: the copy's next write fails and it winds down */
+        close(pipe_fds[0]);
+    }
+    pthread_join(thread, NULL);
+
+    if (drain_rc == MONGOLITE_ECANCELED) {
+        set_error(error, MONGOLITE_LIB, MONGOLITE_ECANCELED, "Backup cancelled");
+        return MONGOLITE_ECANCELED;
+    }
+    if (drain_rc != 0) {
+        set_error(error, "system", MONGOLITE_EIO, "Backup write failed: %s",
+                  strerror(drain_rc));
+        return MONGOLITE_EIO;
+    }
+    if (job.rc != 0) {
+        set_error(error, MONGOLITE_LIB, MONGOLITE_EIO, "Backup copy failed: %s",
+                  mdb_strerror(job.rc));
+        return MONGOLITE_EIO;
+    }
+    return MONGOLITE_OK;
+}
+
+static int _create_file(const char *path, gerror_t *error) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) {
+        set_error(error, "system", MONGOLITE_EIO, "Cannot create %s: %s",
+                  path, strerror(errno));
+    }
+    return fd;
+}
+
+static int _finish_file(int fd, const char *path, gerror_t *error) {
+    int rc = (fsync(fd) == 0) ? 0 : errno;
+    if (close(fd) != 0 && rc == 0) rc = errno;
+    if (rc != 0) {
+        set_error(error, "system", MONGOLITE_EIO, "Cannot flush %s: %s",
+                  path, strerror(rc));
+        return MONGOLITE_EIO;
+    }
+    return MONGOLITE_OK;
+}
+
+#else /* _WIN32 */
+
+/* Windows: LMDB copies straight into the file; progress is reported once
+ * at the end and max_bytes_per_sec is not applied */
+static int _copy_to_fd(mongolite_db_t *db, int out_fd, unsigned int cp_flags,
+                       const mongolite_backup_opts_t *opts, gerror_t *error) {
+    int rc = mdb_env_copyfd2(wtree3_db_get_env(db->wdb),
+                             (HANDLE)_get_osfhandle(out_fd), cp_flags);
+
+    if (rc != 0) {
+        set_error(error, MONGOLITE_LIB, MONGOLITE_EIO, "Backup copy failed: %s",
+                  mdb_strerror(rc));
+        return MONGOLITE_EIO;
+    }
+    if (opts && opts->progress) {
+        uint64_t size = (uint64_t)_lseeki64(out_fd, 0, SEEK_END);
+        if (opts->progress(size, size, opts->progress_ctx) != 0) {
+            set_error(error, MONGOLITE_LIB, MONGOLITE_ECANCELED, "Backup cancelled");
+            return MONGOLITE_ECANCELED;
+        }
+    }
+    return MONGOLITE_OK;
+}
+
+static int _create_file(const char *path, gerror_t *error) {
+    int fd = _open(path, _O_WRONLY | _O_CREAT | _O_EXCL | _O_BINARY, _S_IREAD | _S_IWRITE);
+    if (fd < 0) {
+        set_error(error, "system", MONGOLITE_EIO, "Cannot create %s", path);
+    }
+    return fd;
+}
+
+static int _finish_file(int fd, const char *path, gerror_t *error) {
+    int rc = _commit(fd);
+    if (_close(fd) != 0 && rc == 0) rc = -1;
+    if (rc != 0) {
+        set_error(error, "system", MONGOLITE_EIO, "Cannot flush %s", path);
+        return MONGOLITE_EIO;
+    }
+    return MONGOLITE_OK;
+}
+
+#endif /* _WIN32 */
+
+/* ============================================================
+ * Backup
+ * ============================================================ */
+
+int mongolite_backup(mongolite_db_t *db, const char *dest, unsigned int flags,
+                     const mongolite_backup_opts_t *opts, gerror_t *error) {
+    if (!db || !db->wdb || !dest) {
+        set_error(error, MONGOLITE_LIB, MONGOLITE_EINVAL,
+                 "Database and destination are required");
+        return MONGOLITE_EINVAL;
+    }
+
+    /* Same layout as the source: a directory holding data.mdb */
+    struct stat st = {0};
+    if (stat(dest, &st) == -1) {
+        if (mkdir(dest, 0755) != 0) {
+            set_error(error, "system", errno,
+                     "Failed to create backup directory: %s", dest);
+            return MONGOLITE_EIO;
+        }
+    } else if (!S_ISDIR(st.st_mode)) {
+        set_error(error, MONGOLITE_LIB, MONGOLITE_EINVAL,
+                 "Backup destination is not a directory: %s", dest);
+        return MONGOLITE_EINVAL;
+    }
+
+    char *file = _path_join(dest, MONGOLITE_DATA_FILE);
+    if (!file) {
+        set_error(error, "system", MONGOLITE_ENOMEM, "Failed to allocate path");
+        return MONGOLITE_ENOMEM;
+    }
+
+    /* Never overwrite: an existing data file means dest is in use */
+    int fd = _create_file(file, error);
+    if (fd < 0) {
+        free(file);
+        return MONGOLITE_EIO;
+    }
+
+    unsigned int cp_flags = (flags & MONGOLITE_BACKUP_COMPACT) ? MDB_CP_COMPACT : 0;
+    _snapshot_hold(db);
+    int rc = _copy_to_fd(db, fd, cp_flags, opts, error);
+    _snapshot_release(db);
+
+    gerror_t close_error = {0};
+    int close_rc = _finish_file(fd, file, &close_error);
+    if (rc == MONGOLITE_OK && close_rc != MONGOLITE_OK) {
+        rc = close_rc;
+        if (error) *error = close_error;
+    }
+
+    if (rc != MONGOLITE_OK) remove(file);
+    free(file);
+    return rc;
+}
+
+/* ============================================================
+ * Compact In Place
+ * ============================================================ */
+
+/* Does the copy at file open as an environment? Checked while the live
+ * one is still open, so a bad copy never replaces it. */
+static int _check_copy(const char *file, gerror_t *error) {
+    MDB_env *env = NULL;
+    MDB_txn *txn = NULL;
+    MDB_dbi dbi;
+    MDB_stat st;
+
+    int rc = mdb_env_create(&env);
+    if (rc == MDB_SUCCESS) rc = mdb_env_open(env, file, MDB_NOSUBDIR | MDB_RDONLY | MDB_NOLOCK, 0644);
+    if (rc == MDB_SUCCESS) rc = mdb_txn_begin(env, NULL, MDB_RDONLY, &txn);
+    if (rc == MDB_SUCCESS) rc = mdb_dbi_open(txn, NULL, 0, &dbi);
+    if (rc == MDB_SUCCESS) rc = mdb_stat(txn, dbi, &st);
+    if (txn) mdb_txn_abort(txn);
+    if (env) mdb_env_close(env);
+
+    if (rc != MDB_SUCCESS) {
+        set_error(error, "lmdb", rc, "Compacted copy does not open: %s", mdb_strerror(rc));
+        return MONGOLITE_EIO;
+    }
+    return MONGOLITE_OK;
+}
+
+int mongolite_compact(mongolite_db_t *db, gerror_t *error) {
+    if (!db || !db->wdb) {
+        set_error(error, MONGOLITE_LIB, MONGOLITE_EINVAL, "Database is NULL");
+        return MONGOLITE_EINVAL;
+    }
+
+    _mongolite_lock(db);
+
+    /* Offline: the environment is closed and reopened underneath */
+    if (db->open_sessions > 0 || MONGOLITE_ATOMIC_LOAD(&db->cursor_txns) > 0) {
+        _mongolite_unlock(db);
+        set_error(error, MONGOLITE_LIB, MONGOLITE_EBUSY,
+                 "Cannot compact while a session, cursor or backup is open");
+        return MONGOLITE_EBUSY;
+    }
+
+    char *data_file = _path_join(db->path, MONGOLITE_DATA_FILE);
+    char *tmp_file = _path_join(db->path, MONGOLITE_COMPACT_FILE);
+    if (!data_file || !tmp_file) {
+        free(data_file);
+        free(tmp_file);
+        _mongolite_unlock(db);
+        set_error(error, "system", MONGOLITE_ENOMEM, "Failed to allocate path");
+        return MONGOLITE_ENOMEM;
+    }
+
+    /* Leftover from an interrupted compaction */
+    remove(tmp_file);
+
+    int rc = MONGOLITE_OK;
+    int fd = _create_file(tmp_file, error);
+    if (fd < 0) rc = MONGOLITE_EIO;
+
+    if (rc == MONGOLITE_OK) {
+        /* Drop everything that points into the old environment */
+        if (db->read_txn_pool) {
+            wtree3_txn_abort(db->read_txn_pool);
+            db->read_txn_pool = NULL;
+        }
+        _mongolite_tree_cache_clear(db);
+        _mongolite_change_feed_detach(db);
+
+        /* The db lock held throughout keeps the map still */
+        rc = _copy_to_fd(db, fd, MDB_CP_COMPACT, NULL, error);
+        int close_rc = _finish_file(fd, tmp_file, rc == MONGOLITE_OK ? error : NULL);
+        if (rc == MONGOLITE_OK) rc = close_rc;
+    }
+    if (rc == MONGOLITE_OK) rc = _check_copy(tmp_file, error);
+
+    if (rc == MONGOLITE_OK) {
+        /* Swap files with the environment closed, then reopen it. The
+         * flusher syncs through the environment: stop it first. */
+        _mongolite_durability_stop(db);
+        _mongolite_env_lock(db);
+        wtree3_db_close(db->wdb);
+        db->wdb = NULL;
+
+        if (rename(tmp_file, data_file) != 0) {
+            set_error(error, "system", MONGOLITE_EIO, "Cannot replace %s: %s",
+                      data_file, strerror(errno));
+            rc = MONGOLITE_EIO;
+        }
+
+        /* Reopen either way: on a failed rename the old file is intact.
+         * Should it still fail, the handle stays closed: every entry
+         * point then fails (_mongolite_require_env) until mongolite_close. */
+        gerror_t open_error = {0};
+        int open_rc = _mongolite_open_env(db, &open_error);
+        if (open_rc != 0 && rc == MONGOLITE_OK) {
+            rc = open_rc;
+            if (error) *error = open_error;
+        }
+        _mongolite_env_unlock(db);
+
+        if (db->wdb) {
+            _mongolite_durability_reset(db);
+            if (_mongolite_durability_start(db) != MONGOLITE_OK && rc == MONGOLITE_OK) {
+                set_error(error, "system", MONGOLITE_ERROR, "Failed to restart durability flusher");
+                rc = MONGOLITE_ERROR;
+            }
+        }
+    }
+
+    /* Feed tree handle into whichever environment is open now */
+    if (db->wdb) {
+        int feed_rc = _mongolite_change_feed_attach(db, rc == MONGOLITE_OK ? error : NULL);
+        if (rc == MONGOLITE_OK) rc = feed_rc;
+    }
+
+    if (rc != MONGOLITE_OK) remove(tmp_file);
+    free(data_file);
+    free(tmp_file);
+
+    _mongolite_unlock(db);
+    return rc;
+}
@@ -0,0 +1,557 @@
+/*
+ * mongolite_changes.c - Change feed
+ *
+ * Handles:
+ * - Feed setup / teardown (db_config_t.change_feed*)
+ * - Recording inserts, updates, replaces and deletes in the writer's
+ *   transaction, with retention trimming
+ * - Commit notifications for waiting streams
+ * - Public API: mongolite_change_stream_*, mongolite_change_feed_last_seq,
+ *   mongolite_change_feed_truncate
+ *
+ * The feed is one tree keyed by a big-endian sequence number, so LMDB
+ * keeps it in commit order and appends always land on the rightmost
+ * page. A sequence number is the last key + 1, read in the writing
+ * transaction: an aborted write gives its number back and the feed has
+ * no gaps. Trimming never removes the newest entry, which carries the
+ * sequence across reopen.
+ */
+
+#include "mongolite_internal.h"
+#include "macros.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
+#endif
+
+#define MONGOLITE_LIB "mongolite"
+
+/* Entries trimmed by one write at most, so retention never makes a
+ * single write slow; a backlog drains over the following writes */
+#define MONGOLITE_CHANGE_TRIM_BATCH 8
+
+/* Entries a stream copies per visit to the feed */
+#define MONGOLITE_CHANGE_STREAM_BATCH 64
+
+#define MONGOLITE_CHANGE_KEY_LEN 8
+
+/* ============================================================
+ * Feed State
+ * ============================================================ */
+
+struct mongolite_change_feed {
+#ifdef _WIN32
+    CRITICAL_SECTION mutex;
+    CONDITION_VARIABLE commit_cond;
+#else
+    pthread_mutex_t mutex;
+    pthread_cond_t commit_cond;         /* Streams: a write committed */
+#endif
+    wtree3_tree_t *tree;                /* MONGOLITE_CHANGES_TREE (NULL while compacting) */
+    uint64_t max_entries;               /* 0 = no limit */
+    uint64_t max_age_ms;                /* 0 = no limit */
+
+    /* Under mutex */
+    uint64_t commits;                   /* Bumped by every commit */
+    unsigned int waiters;
+};
+
+static void _feed_lock(mongolite_change_feed_t *feed) {
+#ifdef _WIN32
+    EnterCriticalSection(&feed->mutex);
+#else
+    pthread_mutex_lock(&feed->mutex);
+#endif
+}
+
+static void _feed_unlock(mongolite_change_feed_t *feed) {
+#ifdef _WIN32
+    LeaveCriticalSection(&feed->mutex);
+#else
+    pthread_mutex_unlock(&feed->mutex);
+#endif
+}
+
+/* Wait for a commit for up to ms (> 0) or forever (< 0) */
+static void _feed_wait(mongolite_change_feed_t *feed, int ms) {
+#ifdef _WIN32
+    SleepConditionVariableCS(&feed->commit_cond, &feed->mutex, ms < 0 ? INFINITE : (DWORD)ms);
+#else
+    if (ms < 0) {
+        pthread_cond_wait(&feed->commit_cond, &feed->mutex);
+        return;
+    }
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_nsec += (long)(ms % 1000) * 1000000L;
+    deadline.tv_sec += ms / 1000 + deadline.tv_nsec / 1000000000L;
+    deadline.tv_nsec %= 1000000000L;
+    pthread_cond_timedwait(&feed->commit_cond, &feed->mutex, &deadline);
+#endif
+}
+
+static void _seq_encode(uint64_t seq, uint8_t *key) {
+    for (int i = MONGOLITE_CHANGE_KEY_LEN - 1; i >= 0; i--) {
+        key[i] = (uint8_t)seq;
+        seq >>= 8;
+    }
+}
+
+static uint64_t _seq_decode(const void *key, size_t len) {
+    if (len != MONGOLITE_CHANGE_KEY_LEN) return 0;
+    const uint8_t *p = key;
+    uint64_t seq = 0;
+    for (int i = 0; i < MONGOLITE_CHANGE_KEY_LEN; i++) seq = (seq << 8) | p[i];
+    return seq;
+}
+
+/* ============================================================
+ * Setup
+ * ============================================================ */
+
+int _mongolite_change_feed_attach(mongolite_db_t *db, gerror_t *error) {
+    if (!db->change_feed || db->change_feed->tree) return MONGOLITE_OK;
+    db->change_feed->tree = wtree3_tree_open(db->wdb, MONGOLITE_CHANGES_TREE, 0, -1, error);
+    return db->change_feed->tree ? MONGOLITE_OK : MONGOLITE_ERROR;
+}
+
+void _mongolite_change_feed_detach(mongolite_db_t *db) {
+    if (!db->change_feed || !db->change_feed->tree) return;
+    wtree3_tree_close(db->change_feed->tree);
+    db->change_feed->tree = NULL;
+}
+
+int _mongolite_change_feed_init(mongolite_db_t *db, const db_config_t *config,
+                                gerror_t *error) {
+    db->change_feed = NULL;
+    if (!config || !config->change_feed) return MONGOLITE_OK;
+
+    mongolite_change_feed_t *feed = calloc(1, sizeof(*feed));
+    if (!feed) {
+        set_error(error, "system", MONGOLITE_ENOMEM, "Failed to allocate change feed");
+        return MONGOLITE_ENOMEM;
+    }
+
+#ifdef _WIN32
+    InitializeCriticalSection(&feed->mutex);
+    InitializeConditionVariable(&feed->commit_cond);
+#else
+    if (pthread_mutex_init(&feed->mutex, NULL) != 0) {
+        free(feed);
+        set_error(error, "system", MONGOLITE_ERROR, "Failed to initialize change feed");
+        return MONGOLITE_ERROR;
+    }
+    if (pthread_cond_init(&feed->commit_cond, NULL) != 0) {
+        pthread_mutex_destroy(&feed->mutex);
+        free(feed);
+        set_error(error, "system", MONGOLITE_ERROR, "Failed to initialize change feed");
+        return MONGOLITE_ERROR;
+    }
+#endif
+
+    feed->max_entries = config->change_feed_max_entries;
+    feed->max_age_ms = config->change_feed_max_age_ms;
+    db->change_feed = feed;
+
+    int rc = _mongolite_change_feed_attach(db, error);
+    if (rc != MONGOLITE_OK) _mongolite_change_feed_free(db);
+    return rc;
+}
+
+void _mongolite_change_feed_free(mongolite_db_t *db) {
+    if (!db || !db->change_feed) return;
+    mongolite_change_feed_t *feed = db->change_feed;
+
+    _mongolite_change_feed_detach(db);
+#ifdef _WIN32
+    DeleteCriticalSection(&feed->mutex);
+#else
+    pthread_cond_destroy(&feed->commit_cond);
+    pthread_mutex_destroy(&feed->mutex);
+#endif
+    free(feed);
+    db->change_feed = NULL;
+}
+
+/* ============================================================
+ * Recording
+ * ============================================================ */
+
+static const char* _change_op_name(mongolite_change_op_t op) {
+    switch (op) {
+        case MONGOLITE_CHANGE_INSERT:  return "insert";
+        case MONGOLITE_CHANGE_UPDATE:  return "update";
+        case MONGOLITE_CHANGE_REPLACE: return "replace";
+        default:                       return "delete";
+    }
+}
+
+/* Drop expired entries from the front, it positioned anywhere; next_seq
+ * is the entry about to be written and always survives */
+static int _feed_trim(const mongolite_change_feed_t *feed, wtree3_iterator_t *it,
+                      uint64_t next_seq, int64_t now_ms, gerror_t *error) {
+    if (!wtree3_iterator_first(it)) return 0;
+
+    for (int n = 0; n < MONGOLITE_CHANGE_TRIM_BATCH && wtree3_iterator_valid(it); n++) {
+        const void *key, *value;
+        size_t key_len, value_len;
+        wtree3_iterator_key(it, &key, &key_len);
+        uint64_t seq = _seq_decode(key, key_len);
+
+        bool expired = feed->max_entries && next_seq - seq >= feed->max_entries;
+        if (!expired && feed->max_age_ms && wtree3_iterator_value(it, &value, &value_len)) {
+            bson_t entry;
+            bson_iter_t iter;
+            if (bson_init_static(&entry, value, value_len) &&
+                bson_iter_init_find(&iter, &entry, "ts") && BSON_ITER_HOLDS_DATE_TIME(&iter)) {
+                expired = bson_iter_date_time(&iter) + (int64_t)feed->max_age_ms <= now_ms;
+            }
+        }
+        if (!expired) break;
+
+        int rc = wtree3_iterator_delete(it, error);
+        if (rc != 0) return rc;
+    }
+    return 0;
+}
+
+int _mongolite_change_log(mongolite_db_t *db, wtree3_txn_t *txn, mongolite_change_op_t op,
+                          const char *collection, wtree3_tree_t *tree,
+                          const bson_oid_t *oid, const bson_t *doc, gerror_t *error) {
+    mongolite_change_feed_t *feed = db->change_feed;
+    if (!feed->tree) {
+        set_error(error, MONGOLITE_LIB, WTREE3_EINVAL, "Change feed is not open");
+        return WTREE3_EINVAL;
+    }
+
+    /* Post-image not at hand: read what the write left */
+    bson_t stored;
+    if (!doc && op != MONGOLITE_CHANGE_DELETE) {
+        const void *data;
+        size_t len;
+        int rc = wtree3_get_txn(txn, tree, oid->bytes, sizeof(oid->bytes), &data, &len, error);
+        if (rc == WTREE3_NOT_FOUND) {
+            /* Nothing was written */
+            if (error) {
+                error->code = 0;
+                error->message[0] = '\0';
+            }
+            return 0;
+        }
+        if (rc != 0) return rc;
+        if (!bson_init_static(&stored, data, len)) {
+            set_error(error, MONGOLITE_LIB, WTREE3_EINVAL, "Invalid document");
+            return WTREE3_EINVAL;
+        }
+        doc = &stored;
+    }
+
+    wtree3_iterator_t *it = wtree3_iterator_create_with_txn(feed->tree, txn, error);
+    if (!it) return WTREE3_ERROR;
+
+    uint64_t seq = 1;
+    const void *last;
+    size_t last_len;
+    if (wtree3_iterator_last(it) && wtree3_iterator_key(it, &last, &last_len)) {
+        seq = _seq_decode(last, last_len) + 1;
+    }
+
+    int64_t now_ms = _mongolite_now_ms();
+    int rc = 0;
+    if (feed->max_entries || feed->max_age_ms) rc = _feed_trim(feed, it, seq, now_ms, error);
+    wtree3_iterator_close(it);
+    if (rc != 0) return rc;
+
+    bson_t entry;
+    bson_init(&entry);
+    BSON_APPEND_INT64(&entry, "seq", (int64_t)seq);
+    BSON_APPEND_DATE_TIME(&entry, "ts", now_ms);
+    BSON_APPEND_UTF8(&entry, "op", _change_op_name(op));
+    BSON_APPEND_UTF8(&entry, "ns", collection);
+
+    /* The document's own _id, which may not be the OID it is stored under */
+    bson_iter_t id_iter;
+    if (doc && bson_iter_init_find(&id_iter, doc, "_id")) {
+        BSON_APPEND_VALUE(&entry, "_id", bson_iter_value(&id_iter));
+    } else {
+        BSON_APPEND_OID(&entry, "_id", oid);
+    }
+    if (op != MONGOLITE_CHANGE_DELETE) BSON_APPEND_DOCUMENT(&entry, "doc", doc);
+
+    uint8_t key[MONGOLITE_CHANGE_KEY_LEN];
+    _seq_encode(seq, key);
+    rc = wtree3_insert_one_txn(txn, feed->tree, key, sizeof(key),
+                               bson_get_data(&entry), entry.len, error);
+    bson_destroy(&entry);
+    return rc;
+}
+
+void _mongolite_change_feed_committed(mongolite_db_t *db) {
+    mongolite_change_feed_t *feed = db->change_feed;
+    if (!feed) return;
+
+    _feed_lock(feed);
+    feed->commits++;
+    if (feed->waiters) {
+#ifdef _WIN32
+        WakeAllConditionVariable(&feed->commit_cond);
+#else
+        pthread_cond_broadcast(&feed->commit_cond);
+#endif
+    }
+    _feed_unlock(feed);
+}
+
+/* ============================================================
+ * Streams
+ * ============================================================ */
+
+typedef struct {
+    uint64_t seq;
+    bson_t *change;
+} change_slot_t;
+
+struct mongolite_change_stream {
+    mongolite_db_t *db;
+    uint64_t seq;                       /* Last change returned (resume point) */
+    bool resumed;                       /* seq came from the caller or a change */
+    change_slot_t batch[MONGOLITE_CHANGE_STREAM_BATCH];
+    size_t count;
+    size_t pos;
+};
+
+static void _stream_clear(mongolite_change_stream_t *stream) {
+    for (size_t i = 0; i < stream->count; i++) bson_destroy(stream->batch[i].change);
+    stream->count = 0;
+    stream->pos = 0;
+}
+
+/* Copy the next batch after stream->seq out of a pooled snapshot */
+static int _stream_fetch(mongolite_change_stream_t *stream, gerror_t *error) {
+    mongolite_db_t *db = stream->db;
+    _stream_clear(stream);
+
+    _mongolite_lock(db);
+    wtree3_txn_t *txn = _mongolite_get_read_txn(db, error);
+    if (!txn) {
+        _mongolite_unlock(db);
+        return MONGOLITE_ERROR;
+    }
+    wtree3_iterator_t *it = wtree3_iterator_create_with_txn(db->change_feed->tree, txn, error);
+    if (!it) {
+        _mongolite_release_read_txn(db, txn);
+        _mongolite_unlock(db);
+        return MONGOLITE_ERROR;
+    }
+
+    uint8_t key[MONGOLITE_CHANGE_KEY_LEN];
+    _seq_encode(stream->seq + 1, key);
+    int rc = MONGOLITE_OK;
+    bool ok = wtree3_iterator_seek_range(it, key, sizeof(key));
+    while (ok && stream->count < MONGOLITE_CHANGE_STREAM_BATCH) {
+        const void *k, *v;
+        size_t k_len, v_len;
+        wtree3_iterator_key(it, &k, &k_len);
+        wtree3_iterator_value(it, &v, &v_len);
+        uint64_t seq = _seq_decode(k, k_len);
+
+        /* Retention or a truncate got past this stream */
+        if (stream->count == 0 && stream->resumed && seq > stream->seq + 1) {
+            rc = MONGOLITE_ETRUNCATED;
+            set_error(error, MONGOLITE_LIB, rc,
+                      "Changes %llu to %llu are no longer in the feed",
+                      (unsigned long long)(stream->seq + 1), (unsigned long long)(seq - 1));
+            break;
+        }
+
+        bson_t *change = bson_new_from_data(v, v_len);
+        if (!change) {
+            rc = MONGOLITE_ENOMEM;
+            set_error(error, "system", rc, "Failed to copy change");
+            break;
+        }
+        stream->batch[stream->count].seq = seq;
+        stream->batch[stream->count].change = change;
+        stream->count++;
+        ok = wtree3_iterator_next(it);
+    }
+
+    wtree3_iterator_close(it);
+    _mongolite_release_read_txn(db, txn);
+    _mongolite_unlock(db);
+    if (rc != MONGOLITE_OK) _stream_clear(stream);
+    return rc;
+}
+
+mongolite_change_stream_t* mongolite_change_stream_open(mongolite_db_t *db, uint64_t after_seq,
+                                                        gerror_t *error) {
+    if (!db) {
+        set_error(error, MONGOLITE_LIB, MONGOLITE_EINVAL, "Database is NULL");
+        return NULL;
+    }
+    if (!db->change_feed) {
+        set_error(error, MONGOLITE_LIB, MONGOLITE_EINVAL,
+                  "Change feed is off (db_config_t.change_feed)");
+        return NULL;
+    }
+
+    mongolite_change_stream_t *stream = calloc(1, sizeof(*stream));
+    if (!stream) {
+        set_error(error, "system", MONGOLITE_ENOMEM, "Failed to allocate change stream");
+        return NULL;
+    }
+    stream->db = db;
+    stream->seq = after_seq;
+    stream->resumed = after_seq > 0;
+    return stream;
+}
+
+int mongolite_change_stream_next(mongolite_change_stream_t *stream, const bson_t **change,
+                                 int timeout_ms, gerror_t *error) {
+    if (!stream || !change) {
+        set_error(error, MONGOLITE_LIB, MONGOLITE_EINVAL, "Stream and change are required");
+        return MONGOLITE_EINVAL;
+    }
+    *change = NULL;
+
+    mongolite_change_feed_t *feed = stream->db->change_feed;
+    uint64_t deadline = timeout_ms > 0
+        ? _mongolite_now_ns() / 1000000 + (uint64_t)timeout_ms : 0;
+
+    for (;;) {
+        if (stream->pos < stream->count) {
+            change_slot_t *slot = &stream->batch[stream->pos++];
+            stream->seq = slot->seq;
+            stream->resumed = true;
+            *change = slot->change;
+            return MONGOLITE_OK;
+        }
+
+        /* Registered before reading: a commit after the read is not missed */
+        _feed_lock(feed);
+        uint64_t seen = feed->commits;
+        feed->waiters++;
+        _feed_unlock(feed);
+
+        int rc = _stream_fetch(stream, error);
+
+        _feed_lock(feed);
+        if (rc == MONGOLITE_OK && stream->count == 0 && timeout_ms != 0) {
+            while (feed->commits == seen) {
+                int wait_ms = -1;
+                if (timeout_ms > 0) {
+                    uint64_t now = _mongolite_now_ns() / 1000000;
+                    if (now >= deadline) break;
+                    wait_ms = (int)(deadline - now);
+                }
+                _feed_wait(feed, wait_ms);
+            }
+        }
+        bool woken = feed->commits != seen;
+        feed->waiters--;
+        _feed_unlock(feed);
+
+        if (rc != MONGOLITE_OK) return rc;
+        if (stream->count == 0 && !woken) {
+            set_error(error, MONGOLITE_LIB, MONGOLITE_ETIMEDOUT,
+                      "No change after %llu", (unsigned long long)stream->seq);
+            return MONGOLITE_ETIMEDOUT;
+        }
+    }
+}
+
+uint64_t mongolite_change_stream_seq(const mongolite_change_stream_t *stream) {
+    return stream ? stream->seq : 0;
+}
+
+void mongolite_change_stream_close(mongolite_change_stream_t *stream) {
+    if (!stream) return;
+    _stream_clear(stream);
+    free(stream);
+}
+
+/* ============================================================
+ * Feed Maintenance
+ * ============================================================ */
+
+uint64_t mongolite_change_feed_last_seq(mongolite_db_t *db) {
+    if (!db || !db->change_feed) return 0;
+
+    gerror_t error = {0};
+    uint64_t seq = 0;
+    _mongolite_lock(db);
+    wtree3_txn_t *txn = _mongolite_get_read_txn(db, &error);
+    if (txn) {
+        wtree3_iterator_t *it = wtree3_iterator_create_with_txn(db->change_feed->tree, txn,
+                                                                &error);
+        const void *key;
+        size_t key_len;
+        if (it && wtree3_iterator_last(it) && wtree3_iterator_key(it, &key, &key_len)) {
+            seq = _seq_decode(key, key_len);
+        }
+        wtree3_iterator_close(it);
+        _mongolite_release_read_txn(db, txn);
+    }
+    _mongolite_unlock(db);
+    return seq;
+}
+
+/* Delete up to the newest entry, exclusive */
+static bool _truncate_predicate(const void *key, size_t key_len,
+                                const void *value, size_t value_len, void *user_data) {
+    (void)value; (void)value_len;
+    return _seq_decode(key, key_len) < *(const uint64_t *)user_data;
+}
+
+int mongolite_change_feed_truncate(mongolite_db_t *db, uint64_t through_seq, gerror_t *error) {
+    if (!db) {
+        set_error(error, MONGOLITE_LIB, MONGOLITE_EINVAL, "Database is NULL");
+        return MONGOLITE_EINVAL;
+    }
+    if (!db->change_feed) {
+        set_error(error, MONGOLITE_LIB, MONGOLITE_EINVAL,
+                  "Change feed is off (db_config_t.change_feed)");
+        return MONGOLITE_EINVAL;
+    }
+
+    _mongolite_lock(db);
+    wtree3_txn_t *txn = _mongolite_get_write_txn(db, error);
+    if (!txn) {
+        _mongolite_unlock(db);
+        return MONGOLITE_ERROR;
+    }
+
+    /* The newest entry stays whatever through_seq says */
+    uint64_t newest = 0;
+    wtree3_iterator_t *it = wtree3_iterator_create_with_txn(db->change_feed->tree, txn, error);
+    const void *key;
+    size_t key_len;
+    if (it && wtree3_iterator_last(it) && wtree3_iterator_key(it, &key, &key_len)) {
+        newest = _seq_decode(key, key_len);
+    }
+    wtree3_iterator_close(it);
+
+    int rc = 0;
+    if (through_seq >= newest) through_seq = newest ? newest - 1 : 0;
+    if (through_seq > 0) {
+        uint8_t end[MONGOLITE_CHANGE_KEY_LEN];
+        _seq_encode(through_seq, end);
+        rc = wtree3_delete_if_txn(txn, db->change_feed->tree, NULL, 0, end, sizeof(end),
+                                  _truncate_predicate, &newest, NULL, error);
+    }
+    if (rc != 0) {
+        _mongolite_abort_if_auto(db, txn);
+        _mongolite_unlock(db);
+        return _mongolite_translate_wtree3_error(rc);
+    }
+
+    rc = _mongolite_commit_if_auto(db, txn, error);
+    _mongolite_unlock(db);
+    return rc;
+}
@@ -5,6 +5,7 @@
  * - Collection create/drop
  * - Collection list/exists
  * - Collection count
+ * - Prepared collection handles
  *
  * Note: Schema system removed - collections are simply wtree3 trees with "col:" prefix.
  * Metadata support removed for simplicity (low-level embedded DB like SQLite).
@@ -33,6 +34,13 @@ int mongolite_collection_create(mongolite_db_t *db, const char *name,
 
     _mongolite_lock(db);
 
+    int busy = _mongolite_require_env(db, error);
+    if (busy == MONGOLITE_OK) busy = _mongolite_require_no_write_session(db, error);
+    if (busy != MONGOLITE_OK) {
+        _mongolite_unlock(db);
+        return busy;
+    }
+
     /* Check if collection already exists in cache */
     wtree3_tree_t *existing = _mongolite_tree_cache_get(db, name);
     if (existing) {
@@ -95,6 +103,13 @@ int mongolite_collection_drop(mongolite_db_t *db, const char *name, gerror_t *er
 
     _mongolite_lock(db);
 
+    int busy = _mongolite_require_env(db, error);
+    if (busy == MONGOLITE_OK) busy = _mongolite_require_no_write_session(db, error);
+    if (busy != MONGOLITE_OK) {
+        _mongolite_unlock(db);
+        return busy;
+    }
+
     /* Build tree name */
     char *tree_name = _mongolite_collection_tree_name(name);
     if (!tree_name) {
@@ -258,56 +273,139 @@ void mongolite_collection_list_free(char **list, size_t count) {
  * Collection Count
  * ============================================================ */
 
-int64_t mongolite_collection_count(mongolite_db_t *db, const char *collection,
-                                    const bson_t *filter, gerror_t *error) {
-    if (!db || !collection) {
-        set_error(error, MONGOLITE_LIB, MONGOLITE_EINVAL,
-                 "Database and collection name are required");
-        return -1;
+/* Filtered count on parallel scan workers. Called with the database lock
+ * held; releases it once the workers hold their snapshots. Returns false
+ * (lock still held) when the workers could not start. */
+static bool _count_parallel_unlock(mongolite_db_t *db, mongolite_tree_cache_entry_t *entry,
+                                   const bson_t *filter, int64_t *count, gerror_t *error) {
+    gerror_t scan_error = {0};
+    mongolite_scan_t *scan = _mongolite_scan_start(db, entry->tree, filter,
+                                                   MONGOLITE_SCAN_COUNT, &scan_error);
+    if (!scan) {
+        if (scan_error.code != MONGOLITE_EQUERY) return false;
+        if (error) *error = scan_error;
+        _mongolite_unlock(db);
+        *count = -1;
+        return true;
     }
 
-    /* Get tree */
-    wtree3_tree_t *tree = _mongolite_get_collection_tree(db, collection, error);
-    if (!tree) {
-        return -1;
+    /* Entry may go away while unlocked: keep the name for statistics */
+    char *name = strdup(entry->name);
+    _mongolite_stats_query(db, entry->stats, MONGOLITE_PLAN_SCAN);
+    _mongolite_unlock(db);
+
+    uint64_t matched = 0;
+    int rc = _mongolite_scan_finish(scan, &matched);
+    uint64_t scanned = _mongolite_scan_scanned(scan);
+    _mongolite_scan_free(scan);
+
+    _mongolite_lock(db);
+    _mongolite_stats_docs(db, name ? _mongolite_collection_stats_lookup(db, name) : NULL,
+                          scanned, matched, scanned);
+    _mongolite_unlock(db);
+    free(name);
+
+    if (rc != MONGOLITE_OK) {
+        set_error(error, MONGOLITE_LIB, rc, "Parallel scan failed");
+        *count = -1;
+    } else {
+        *count = (int64_t)matched;
     }
+    return true;
+}
 
+/* Count core shared by the name- and handle-based APIs.
+ * Called with the database lock held; releases it. */
+static int64_t _count_entry_unlock(mongolite_db_t *db, mongolite_tree_cache_entry_t *entry,
+                                   const bson_t *filter, gerror_t *error) {
     /* If no filter, return count from wtree3 (fast path) */
     if (!filter || bson_empty(filter)) {
-        return wtree3_tree_count(tree);
+        int64_t count = wtree3_tree_count(entry->tree);
+        _mongolite_unlock(db);
+        return count;
     }
 
-    /* With filter: iterate and count matches using cursor */
-    mongolite_cursor_t *cursor = mongolite_find(db, collection, filter, NULL, error);
+    /* Filter answered by an index: count keys, never touch documents */
+    int64_t count = 0;
+    int rc = _mongolite_count_with_index(db, entry, filter, &count, error);
+    if (rc != 0) {
+        if (rc > 0) _mongolite_stats_query(db, entry->stats, MONGOLITE_PLAN_INDEX_EQ);
+        _mongolite_unlock(db);
+        return rc > 0 ? count : -1;
+    }
+
+    /* Large collections: match on worker threads, unless index seeks apply */
+    mongolite_cached_index_t *idx = NULL;
+    mongolite_plan_type_t plan = _mongolite_plan_query(db, entry, filter, &idx, error);
+    if (plan == MONGOLITE_PLAN_SCAN && _mongolite_text_unindexed(filter, error)) {
+        _mongolite_unlock(db);
+        return -1;
+    }
+    if (plan == MONGOLITE_PLAN_SCAN && _mongolite_scan_eligible(db, entry->tree, filter) &&
+        _count_parallel_unlock(db, entry, filter, &count, error)) {
+        return count;
+    }
+
+    /* Otherwise: iterate and count matches using cursor */
+    mongolite_cursor_t *cursor = _mongolite_find_entry_planned(db, entry, filter, NULL,
+                                                                plan, error);
+    _mongolite_unlock(db);
     if (!cursor) {
         return -1;
     }
 
-    int64_t count = 0;
     const bson_t *doc;
     while (mongolite_cursor_next(cursor, &doc)) {
         count++;
     }
+    if (mongolite_cursor_error(cursor, error) != MONGOLITE_OK) count = -1;
 
     mongolite_cursor_destroy(cursor);
     return count;
 }
 
+int64_t mongolite_collection_count(mongolite_db_t *db, const char *collection,
+                                    const bson_t *filter, gerror_t *error) {
+    if (!db || !collection) {
+        set_error(error, MONGOLITE_LIB, MONGOLITE_EINVAL,
+                 "Database and collection name are required");
+        return -1;
+    }
+
+    uint64_t start = _mongolite_stats_start_query(db, collection, filter);
+    _mongolite_lock(db);
+
+    mongolite_tree_cache_entry_t *entry = _mongolite_get_collection_entry(db, collection, error);
+    if (!entry) {
+        _mongolite_unlock(db);
+        return -1;
+    }
+
+    int64_t count = _count_entry_unlock(db, entry, filter, error);
+    _mongolite_stats_record(db, MONGOLITE_OP_COUNT, start);
+    return count;
+}
+
 /* ============================================================
  * Internal: Get or Open Collection Tree
  * ============================================================ */
 
 wtree3_tree_t* _mongolite_get_collection_tree(mongolite_db_t *db, const char *name,
                                                gerror_t *error) {
-    if (!db || !name) {
-        set_error(error, MONGOLITE_LIB, MONGOLITE_EINVAL, "Invalid parameters");
-        return NULL;
-    }
+    mongolite_tree_cache_entry_t *entry = _mongolite_get_collection_entry(db, name, error);
+    return entry ? entry->tree : NULL;
+}
 
-    /* Check cache first */
-    wtree3_tree_t *tree = _mongolite_tree_cache_get(db, name);
-    if (tree) {
-        return tree;
+/* Open the tree behind a collection and add it to the cache */
+static mongolite_tree_cache_entry_t* _open_collection_entry(mongolite_db_t *db,
+                                                           const char *name,
+                                                           uint64_t hash,
+                                                           gerror_t *error) {
+    if (_mongolite_require_env(db, error) != MONGOLITE_OK) return NULL;
+
+    /* Opening takes LMDB's writer lock (see mongolite_session_begin) */
+    if (_mongolite_require_no_write_session(db, error) != MONGOLITE_OK) {
+        return NULL;
     }
 
     /* Not cached - build tree name */
@@ -328,7 +426,7 @@ wtree3_tree_t* _mongolite_get_collection_tree(mongolite_db_t *db, const char *na
 
     /* Open the tree with wtree3 (index-aware) */
     /* Note: wtree3 automatically loads all indexes from its metadata database */
-    tree = wtree3_tree_open(db->wdb, tree_name, 0, -1, error);
+    wtree3_tree_t *tree = wtree3_tree_open(db->wdb, tree_name, 0, -1, error);
     if (!tree) {
         free(tree_name);
         return NULL;
@@ -339,8 +437,163 @@ wtree3_tree_t* _mongolite_get_collection_tree(mongolite_db_t *db, const char *na
     bson_oid_init(&oid, NULL);
 
     /* Cache it */
-    _mongolite_tree_cache_put(db, name, tree_name, &oid, tree);
-
+    int rc = _mongolite_tree_cache_put(db, name, tree_name, &oid, tree);
     free(tree_name);
-    return tree;
+    if (rc != MONGOLITE_OK) {
+        wtree3_tree_close(tree);
+        set_error(error, MONGOLITE_LIB, rc, "Failed to cache collection: %s", name);
+        return NULL;
+    }
+
+    return _mongolite_tree_cache_lookup(db, name, hash);
+}
+
+MONGOLITE_HOT
+mongolite_tree_cache_entry_t* _mongolite_get_collection_entry(mongolite_db_t *db,
+                                                              const char *name,
+                                                              gerror_t *error) {
+    if (!db || !name) {
+        set_error(error, MONGOLITE_LIB, MONGOLITE_EINVAL, "Invalid parameters");
+        return NULL;
+    }
+
+    /* Check cache first */
+    uint64_t hash = _mongolite_name_hash(name);
+    mongolite_tree_cache_entry_t *entry = _mongolite_tree_cache_lookup(db, name, hash);
+    if (MONGOLITE_LIKELY(entry != NULL)) {
+        return entry;
+    }
+
+    return _open_collection_entry(db, name, hash, error);
+}
+
+/* Named trees (collections and indexes) in the environment, as last
+ * committed by any process */
+static size_t _named_tree_count(mongolite_db_t *db) {
+    MDB_stat st;
+    if (mdb_env_stat(wtree3_db_get_env(db->wdb), &st) != MDB_SUCCESS) return 0;
+    return st.ms_entries;
+}
+
+int _mongolite_open_all_collections(mongolite_db_t *db, gerror_t *error) {
+    /* Still all open unless this process or another created or dropped one */
+    size_t trees = _named_tree_count(db);
+    if (trees != 0 && trees == db->opened_trees &&
+        db->schema_generation == db->opened_generation) {
+        return MONGOLITE_OK;
+    }
+
+    size_t count = 0;
+    char **names = mongolite_collection_list(db, &count, error);
+
+    int rc = MONGOLITE_OK;
+    for (size_t i = 0; i < count; i++) {
+        if (!_mongolite_get_collection_entry(db, names[i], error)) {
+            rc = MONGOLITE_ERROR;
+            break;
+        }
+    }
+
+    mongolite_collection_list_free(names, count);
+    if (rc == MONGOLITE_OK) {
+        db->opened_generation = db->schema_generation;
+        db->opened_trees = trees;
+    }
+    return rc;
+}
+
+/* ============================================================
+ * Prepared Collection Handles
+ *
+ * A handle pins the collection name and its precomputed hash, and
+ * remembers the resolved cache entry. Operations through a handle skip
+ * the name lookup entirely unless the cache has dropped entries since
+ * the handle was last resolved.
+ * ============================================================ */
+
+mongolite_collection_t* mongolite_collection_open(mongolite_db_t *db, const char *name,
+                                                   gerror_t *error) {
+    if (!db || !name || strlen(name) == 0) {
+        set_error(error, MONGOLITE_LIB, MONGOLITE_EINVAL,
+                 "Database and collection name are required");
+        return NULL;
+    }
+
+    mongolite_collection_t *col = calloc(1, sizeof(mongolite_collection_t));
+    if (!col) {
+        set_error(error, "system", MONGOLITE_ENOMEM, "Failed to allocate collection handle");
+        return NULL;
+    }
+
+    col->db = db;
+    col->name = strdup(name);
+    if (!col->name) {
+        free(col);
+        set_error(error, "system", MONGOLITE_ENOMEM, "Failed to allocate collection handle");
+        return NULL;
+    }
+    col->hash = _mongolite_name_hash(name);
+
+    /* Resolve eagerly so a missing collection is reported here */
+    _mongolite_lock(db);
+    mongolite_tree_cache_entry_t *entry = _mongolite_collection_resolve(col, error);
+    _mongolite_unlock(db);
+
+    if (!entry) {
+        mongolite_collection_close(col);
+        return NULL;
+    }
+
+    return col;
+}
+
+void mongolite_collection_close(mongolite_collection_t *col) {
+    if (!col) return;
+    free(col->name);
+    free(col);
+}
+
+const char* mongolite_collection_name(const mongolite_collection_t *col) {
+    return col ? col->name : NULL;
+}
+
+MONGOLITE_HOT
+mongolite_tree_cache_entry_t* _mongolite_collection_resolve(mongolite_collection_t *col,
+                                                            gerror_t *error) {
+    mongolite_db_t *db = col->db;
+
+    if (MONGOLITE_LIKELY(col->entry && col->generation == db->tree_cache_generation)) {
+        return col->entry;
+    }
+
+    mongolite_tree_cache_entry_t *entry = _mongolite_tree_cache_lookup(db, col->name, col->hash);
+    if (!entry) {
+        entry = _open_collection_entry(db, col->name, col->hash, error);
+    }
+
+    col->entry = entry;
+    col->generation = db->tree_cache_generation;
+    return entry;
+}
+
+int64_t mongolite_col_count(mongolite_collection_t *col, const bson_t *filter,
+                             gerror_t *error) {
+    if (!col) {
+        set_error(error, MONGOLITE_LIB, MONGOLITE_EINVAL, "Collection handle is required");
+        return -1;
+    }
+
+    mongolite_db_t *db = col->db;
+    uint64_t start = _mongolite_stats_start_query(db, col->name, filter);
+    _mongolite_lock(db);
+
+    mongolite_tree_cache_entry_t *entry = _mongolite_collection_resolve(col, error);
+    if (!entry) {
+        _mongolite_unlock(db);
+        return -1;
+    }
+
+    int64_t count = _count_entry_unlock(db, entry, filter, error);
+    _mongolite_stats_record(db, MONGOLITE_OP_COUNT, start);
+    return count;
 }
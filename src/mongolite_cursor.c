@@ -2,9 +2,12 @@
  * mongolite_cursor.c - Cursor operations for iterating query results
  *
  * Handles:
- * - cursor_next / cursor_more
+ * - cursor_next / cursor_more / cursor_error
  * - cursor_destroy
- * - limit / skip / sort modifiers
+ * - limit / skip / sort / ordered modifiers
+ * - Documents from a parallel scan (mongolite_scan.c)
+ * - Readahead ahead of the scan position (mongolite_readahead.c)
+ * - Documents from batched _id lookups ($in on _id)
  */
 
 #include "mongolite_internal.h"
@@ -14,6 +17,105 @@
 
 #define MONGOLITE_LIB "mongolite"
 
+/* ============================================================
+ * Cursor Next (parallel scan)
+ *
+ * The workers already matched; position counts the matches consumed.
+ * A worker error ends the results and stays on the cursor.
+ * ============================================================ */
+
+static bool _cursor_next_scan(mongolite_cursor_t *cursor, const bson_t **doc) {
+    const void *data;
+    size_t len;
+    int rc;
+
+    while ((rc = _mongolite_scan_next(cursor->scan, &data, &len)) == 1) {
+        cursor->position++;
+        if (cursor->position <= cursor->skip) continue;
+
+        cursor->current_doc = bson_new_from_data(data, len);
+        if (!cursor->current_doc) continue;
+        cursor->returned++;
+
+        if (doc) *doc = cursor->current_doc;
+        return true;
+    }
+
+    if (rc != 0) cursor->error_rc = rc;
+    cursor->exhausted = true;
+    if (doc) *doc = NULL;
+    return false;
+}
+
+/* ============================================================
+ * Cursor Next (batched _id lookups)
+ *
+ * Fetches the next batch of ids once the current one is served; a $near
+ * cursor reads the next ring of ids once all of them are.
+ * ============================================================ */
+
+static bool _cursor_next_ids(mongolite_cursor_t *cursor, const bson_t **doc) {
+    for (;;) {
+        while (cursor->batch_pos < cursor->batch_len) {
+            const mongolite_fetch_t *row = &cursor->batch[cursor->batch_pos++];
+            bson_t temp_doc;
+            if (!row->data || !bson_init_static(&temp_doc, row->data, row->len)) continue;
+            cursor->position++;
+
+            if (cursor->matcher && !mongoc_matcher_match(cursor->matcher, &temp_doc)) continue;
+            if (cursor->skipped < cursor->skip) {
+                cursor->skipped++;
+                continue;
+            }
+
+            cursor->current_doc = bson_copy(&temp_doc);
+            if (!cursor->current_doc) continue;
+            cursor->returned++;
+
+            if (doc) *doc = cursor->current_doc;
+            return true;
+        }
+        if (cursor->next_id >= cursor->n_ids) {
+            bson_oid_t *ids;
+            size_t n_ids;
+            if (!cursor->near) break;
+            int rc = _mongolite_geo_near_next(cursor->near, wtree3_txn_get_mdb(cursor->txn),
+                                              &ids, &n_ids, &cursor->keys_examined);
+            if (rc != 1) {
+                if (rc != 0) cursor->error_rc = rc;
+                break;
+            }
+            free(cursor->ids);
+            cursor->ids = ids;
+            cursor->n_ids = n_ids;
+            cursor->next_id = 0;
+            continue;
+        }
+
+        const void *keys[MONGOLITE_FETCH_BATCH];
+        size_t n = cursor->n_ids - cursor->next_id;
+        if (n > MONGOLITE_FETCH_BATCH) n = MONGOLITE_FETCH_BATCH;
+        for (size_t i = 0; i < n; i++) keys[i] = cursor->ids[cursor->next_id + i].bytes;
+        cursor->next_id += n;
+
+        /* A missing _id leaves its row empty: it is skipped. A failed
+         * read ends the results and stays on the cursor. */
+        cursor->batch_pos = 0;
+        cursor->batch_len = n;
+        int rc = _mongolite_fetch_batch(&cursor->readahead, cursor->txn, cursor->tree,
+                                        keys, n, cursor->batch, NULL);
+        if (MONGOLITE_UNLIKELY(rc != MONGOLITE_OK)) {
+            cursor->error_rc = rc;
+            cursor->batch_len = 0;
+            break;
+        }
+    }
+
+    cursor->exhausted = true;
+    if (doc) *doc = NULL;
+    return false;
+}
+
 /* ============================================================
  * Cursor Next
  *
@@ -21,7 +123,7 @@
  * Returns true if a document was found, false if exhausted.
  * ============================================================ */
 
-bool mongolite_cursor_next(mongolite_cursor_t *cursor, const bson_t **doc) {
+static bool _cursor_next(mongolite_cursor_t *cursor, const bson_t **doc) {
     if (!cursor || cursor->exhausted) {
         if (doc) *doc = NULL;
         return false;
@@ -40,6 +142,9 @@ bool mongolite_cursor_next(mongolite_cursor_t *cursor, const bson_t **doc) {
         return false;
     }
 
+    if (cursor->scan) return _cursor_next_scan(cursor, doc);
+    if (cursor->ids || cursor->near) return _cursor_next_ids(cursor, doc);
+
     /* Start iteration if not started */
     bool has_entry;
     if (cursor->position == 0) {
@@ -58,6 +163,7 @@ bool mongolite_cursor_next(mongolite_cursor_t *cursor, const bson_t **doc) {
             has_entry = wtree3_iterator_next(cursor->iter);
             continue;
         }
+        _mongolite_readahead_seq(&cursor->readahead, value);
 
         /* Parse document */
         bson_t temp_doc;
@@ -99,6 +205,17 @@ bool mongolite_cursor_next(mongolite_cursor_t *cursor, const bson_t **doc) {
     return false;
 }
 
+/* A find traced by the slow-operation log counts its iteration time */
+bool mongolite_cursor_next(mongolite_cursor_t *cursor, const bson_t **doc) {
+    if (MONGOLITE_UNLIKELY(cursor && cursor->slow)) {
+        uint64_t start = _mongolite_now_ns();
+        bool found = _cursor_next(cursor, doc);
+        cursor->slow->duration_ns += _mongolite_now_ns() - start;
+        return found;
+    }
+    return _cursor_next(cursor, doc);
+}
+
 /* ============================================================
  * Cursor More
  *
@@ -111,13 +228,53 @@ bool mongolite_cursor_more(mongolite_cursor_t *cursor) {
     return !cursor->exhausted;
 }
 
+/* ============================================================
+ * Cursor Error
+ *
+ * Tells a failed read from the end of the results once next is false.
+ * ============================================================ */
+
+int mongolite_cursor_error(const mongolite_cursor_t *cursor, gerror_t *error) {
+    if (!cursor || cursor->error_rc == MONGOLITE_OK) return MONGOLITE_OK;
+    set_error(error, MONGOLITE_LIB, cursor->error_rc,
+             "Query stopped early: reading the collection failed (%d)", cursor->error_rc);
+    return cursor->error_rc;
+}
+
 /* ============================================================
  * Cursor Destroy
  * ============================================================ */
 
+/* Flush the cursor's scan counters. External cursors come from
+ * mongolite_find and are destroyed without the db lock held. */
+static void _cursor_flush_stats(mongolite_cursor_t *cursor) {
+    mongolite_db_t *db = cursor->db;
+    if (!db || (!db->stats_shards && !db->slowlog)) return;
+
+    uint64_t scanned = cursor->scan ? _mongolite_scan_scanned(cursor->scan)
+                                    : (uint64_t)cursor->position;
+    if (scanned == 0) return;
+
+    /* Statistics off: only the slow-log trace of the calling operation */
+    if (!db->stats_shards) {
+        MONGOLITE_TRACE(db, docs_examined, scanned);
+        MONGOLITE_TRACE(db, docs_returned, (uint64_t)cursor->returned);
+        return;
+    }
+    uint64_t evals = (cursor->matcher || cursor->scan) ? scanned : 0;
+
+    if (cursor->external) _mongolite_lock(db);
+    _mongolite_stats_docs(db, _mongolite_collection_stats_lookup(db, cursor->collection_name),
+                          scanned, (uint64_t)cursor->returned, evals);
+    if (cursor->external) _mongolite_unlock(db);
+}
+
 void mongolite_cursor_destroy(mongolite_cursor_t *cursor) {
     if (!cursor) return;
 
+    _cursor_flush_stats(cursor);
+    if (cursor->slow) _mongolite_slowlog_cursor_end(cursor);
+
     /* Free current document */
     if (cursor->current_doc) {
         bson_destroy(cursor->current_doc);
@@ -143,9 +300,17 @@ void mongolite_cursor_destroy(mongolite_cursor_t *cursor) {
         wtree3_iterator_close(cursor->iter);
     }
 
+    /* Stop parallel scan workers */
+    if (cursor->scan) {
+        _mongolite_scan_free(cursor->scan);
+    }
+    free(cursor->ids);
+    _mongolite_geo_near_free(cursor->near);
+
     /* Abort transaction if we own it */
     if (cursor->owns_txn && cursor->txn) {
         wtree3_txn_abort(cursor->txn);
+        MONGOLITE_ATOMIC_ADD(&cursor->db->cursor_txns, (uint64_t)-1);
     }
 
     /* Free sort buffer if any */
@@ -232,10 +397,27 @@ mongolite_cursor_t* _mongolite_cursor_create_with_txn(mongolite_db_t *db,
     cursor->current_doc = NULL;
     cursor->sort_buffer = NULL;
     cursor->sort_buffer_size = 0;
+    _mongolite_readahead_init(db, txn, &cursor->readahead);
 
     return cursor;
 }
 
+void _mongolite_cursor_set_ids(mongolite_cursor_t *cursor, wtree3_tree_t *tree,
+                               bson_oid_t *ids, size_t n_ids) {
+    cursor->tree = tree;
+    cursor->ids = ids;
+    cursor->n_ids = n_ids;
+    cursor->next_id = 0;
+    cursor->batch_len = 0;
+    cursor->batch_pos = 0;
+}
+
+void _mongolite_cursor_set_near(mongolite_cursor_t *cursor, wtree3_tree_t *tree,
+                                mongolite_geo_near_t *near) {
+    _mongolite_cursor_set_ids(cursor, tree, NULL, 0);
+    cursor->near = near;
+}
+
 /* ============================================================
  * Cursor Set Limit
  * ============================================================ */
@@ -268,6 +450,22 @@ int mongolite_cursor_set_skip(mongolite_cursor_t *cursor, int64_t skip) {
     return MONGOLITE_OK;
 }
 
+/* ============================================================
+ * Cursor Set Ordered
+ * ============================================================ */
+
+int mongolite_cursor_set_ordered(mongolite_cursor_t *cursor, bool ordered) {
+    if (!cursor) return MONGOLITE_EINVAL;
+
+    /* Can only set before iteration starts */
+    if (cursor->position > 0) {
+        return MONGOLITE_ERROR;
+    }
+
+    _mongolite_scan_set_ordered(cursor->scan, ordered);
+    return MONGOLITE_OK;
+}
+
 /* ============================================================
  * Cursor Set Sort
  *
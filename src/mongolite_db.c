@@ -31,6 +31,62 @@
  * Database Open / Close
  * ============================================================ */
 
+int _mongolite_open_env(mongolite_db_t *db, gerror_t *error) {
+    db->wdb = wtree3_db_open(db->path, db->max_bytes, db->max_dbs, db->version,
+                             db->lmdb_flags, error);
+    if (!db->wdb) return MONGOLITE_ERROR;
+
+    /* Indexes are ordered by _mongolite_index_compare, also when reloaded */
+    wtree3_db_set_index_compare(db->wdb, _mongolite_index_compare);
+
+    /* Register BSON key extractors for indexes */
+    /* Flags: 0x00 = non-unique, non-sparse; 0x01 = unique; 0x02 = sparse; 0x03 = unique+sparse */
+    int rc = wtree3_db_register_key_extractor(db->wdb, db->version, 0x00,
+                                              bson_index_key_extractor, error);
+    if (rc == 0) {
+        rc = wtree3_db_register_key_extractor(db->wdb, db->version, 0x01,
+                                              bson_index_key_extractor, error);
+    }
+    if (rc == 0) {
+        rc = wtree3_db_register_key_extractor(db->wdb, db->version, 0x02,
+                                              bson_index_key_extractor_sparse, error);
+    }
+    if (rc == 0) {
+        rc = wtree3_db_register_key_extractor(db->wdb, db->version, 0x03,
+                                              bson_index_key_extractor_sparse, error);
+    }
+    /* 0x04 = multi-key: text, geo and (since multi-key ordered indexes)
+     * every new index; 0x05 unique, 0x06 sparse, 0x07 both */
+    if (rc == 0) {
+        rc = wtree3_db_register_key_extractor(db->wdb, db->version, 0x04,
+                                              _mongolite_multikey_extractor, error);
+    }
+    if (rc == 0) {
+        rc = wtree3_db_register_key_extractor(db->wdb, db->version, 0x05,
+                                              _mongolite_multikey_extractor, error);
+    }
+    if (rc == 0) {
+        rc = wtree3_db_register_key_extractor(db->wdb, db->version, 0x06,
+                                              _mongolite_multikey_extractor_sparse, error);
+    }
+    if (rc == 0) {
+        rc = wtree3_db_register_key_extractor(db->wdb, db->version, 0x07,
+                                              _mongolite_multikey_extractor_sparse, error);
+    }
+    if (rc != 0) {
+        wtree3_db_close(db->wdb);
+        db->wdb = NULL;
+    }
+    return rc;
+}
+
+int _mongolite_require_env(mongolite_db_t *db, gerror_t *error) {
+    if (MONGOLITE_LIKELY(db->wdb != NULL)) return MONGOLITE_OK;
+    set_error(error, MONGOLITE_LIB, MONGOLITE_EIO,
+             "Database is closed: it could not be reopened after compaction");
+    return MONGOLITE_EIO;
+}
+
 int mongolite_open(const char *filename, mongolite_db_t **db,
                    db_config_t *config, gerror_t *error) {
     if (!filename || !db) {
@@ -72,67 +128,106 @@ int mongolite_open(const char *filename, mongolite_db_t **db,
     if (max_dbs == 0) max_dbs = MONGOLITE_DEFAULT_MAX_DBS;
 
     unsigned int lmdb_flags = config ? config->lmdb_flags : 0;
+    lmdb_flags |= _mongolite_durability_env_flags(config);
 
+    new_db->path = strdup(filename);
+    new_db->max_bytes = max_bytes;
+    new_db->max_dbs = max_dbs;
+    new_db->lmdb_flags = lmdb_flags;
     /* Schema version for wtree3 extractors */
-    uint32_t version = WTREE3_VERSION(1, 0);
+    new_db->version = WTREE3_VERSION(1, 0);
+    new_db->plan_cache_disabled = config ? config->disable_plan_cache : false;
+    new_db->busy_timeout_ms = config ? config->busy_timeout_ms : 0;
+    new_db->scan_threads = config ? config->scan_threads : 0;
+    new_db->scan_min_docs = (config && config->scan_parallel_min_docs)
+                                ? config->scan_parallel_min_docs : MONGOLITE_DEFAULT_SCAN_MIN_DOCS;
+    if (!config || !config->disable_readahead) {
+        new_db->readahead_bytes = (config && config->readahead_bytes)
+                                      ? config->readahead_bytes : MONGOLITE_DEFAULT_READAHEAD_BYTES;
+    }
 
     /* Open LMDB environment via wtree3 */
-    new_db->wdb = wtree3_db_open(filename, max_bytes, max_dbs, version, lmdb_flags, error);
-    if (!new_db->wdb) {
+    int rc = _mongolite_open_env(new_db, error);
+    if (rc != 0) {
+        free(new_db->path);
         free(new_db);
-        return MONGOLITE_ERROR;
+        return rc;
     }
 
-    new_db->path = strdup(filename);
-    new_db->max_bytes = max_bytes;
-    new_db->max_dbs = max_dbs;
-    new_db->version = version;
+    /* Initialize mutex */
+    rc = _mongolite_lock_init(new_db);
+    if (rc != 0) {
+        wtree3_db_close(new_db->wdb);
+        free(new_db->path);
+        free(new_db);
+        set_error(error, MONGOLITE_LIB, rc, "Failed to initialize mutex");
+        return rc;
+    }
 
-    /* Register BSON key extractors for indexes */
-    /* Flags: 0x00 = non-unique, non-sparse; 0x01 = unique; 0x02 = sparse; 0x03 = unique+sparse */
-    int rc = wtree3_db_register_key_extractor(new_db->wdb, version, 0x00,
-                                          bson_index_key_extractor, error);
+    /* Statistics shards (lock timing uses them, so after the mutex) */
+    rc = _mongolite_stats_init(new_db, config ? !config->disable_stats : true);
     if (rc != 0) {
+        _mongolite_lock_free(new_db);
         wtree3_db_close(new_db->wdb);
         free(new_db->path);
         free(new_db);
+        set_error(error, "system", rc, "Failed to allocate statistics");
         return rc;
     }
 
-    rc = wtree3_db_register_key_extractor(new_db->wdb, version, 0x01,
-                                          bson_index_key_extractor, error);
+    /* Slow-operation log (opt-in) */
+    rc = _mongolite_slowlog_init(new_db, config);
     if (rc != 0) {
+        _mongolite_stats_free(new_db);
+        _mongolite_lock_free(new_db);
         wtree3_db_close(new_db->wdb);
         free(new_db->path);
         free(new_db);
+        set_error(error, "system", rc, "Failed to allocate slow-operation log");
         return rc;
     }
 
-    rc = wtree3_db_register_key_extractor(new_db->wdb, version, 0x02,
-                                          bson_index_key_extractor_sparse, error);
+    /* Group commit queue (opt-in) */
+    rc = _mongolite_group_init(new_db, config);
     if (rc != 0) {
+        _mongolite_slowlog_free(new_db);
+        _mongolite_stats_free(new_db);
+        _mongolite_lock_free(new_db);
         wtree3_db_close(new_db->wdb);
         free(new_db->path);
         free(new_db);
+        set_error(error, "system", rc, "Failed to initialize group commit");
         return rc;
     }
 
-    rc = wtree3_db_register_key_extractor(new_db->wdb, version, 0x03,
-                                          bson_index_key_extractor_sparse, error);
+    /* Map growth policy */
+    _mongolite_map_init(new_db, config);
+
+    /* Sync tracking (and the ASYNC flusher thread) */
+    rc = _mongolite_durability_init(new_db, config);
     if (rc != 0) {
+        _mongolite_group_free(new_db);
+        _mongolite_slowlog_free(new_db);
+        _mongolite_stats_free(new_db);
+        _mongolite_lock_free(new_db);
         wtree3_db_close(new_db->wdb);
         free(new_db->path);
         free(new_db);
+        set_error(error, "system", rc, "Failed to start durability flusher");
         return rc;
     }
 
-    /* Initialize mutex */
-    rc = _mongolite_lock_init(new_db);
+    /* Change feed (opt-in) */
+    rc = _mongolite_change_feed_init(new_db, config, error);
     if (rc != 0) {
+        _mongolite_durability_close(new_db);
+        _mongolite_group_free(new_db);
+        _mongolite_slowlog_free(new_db);
+        _mongolite_stats_free(new_db);
+        _mongolite_lock_free(new_db);
         wtree3_db_close(new_db->wdb);
         free(new_db->path);
         free(new_db);
-        set_error(error, MONGOLITE_LIB, rc, "Failed to initialize mutex");
         return rc;
     }
 
@@ -145,12 +240,8 @@ int mongolite_open(const char *filename, mongolite_db_t **db,
 int mongolite_close(mongolite_db_t *db) {
     if (!db) return MONGOLITE_OK;
 
-    /* Abort any pending transaction */
-    if (db->in_transaction && db->current_txn) {
-        wtree3_txn_abort(db->current_txn);
-        db->current_txn = NULL;
-        db->in_transaction = false;
-    }
+    /* Abort the calling thread's session (others must be ended first) */
+    _mongolite_session_end_current(db);
 
     /* Clean up pooled read transaction */
     if (db->read_txn_pool) {
@@ -158,8 +249,12 @@ int mongolite_close(mongolite_db_t *db) {
         db->read_txn_pool = NULL;
     }
 
+    /* Stop the flusher; final sync for ASYNC / NONE */
+    _mongolite_durability_close(db);
+
     /* Clear tree cache (closes wtree3 collection trees) */
     _mongolite_tree_cache_clear(db);
+    _mongolite_change_feed_detach(db);
 
     /* Close LMDB environment via wtree3 */
     if (db->wdb) {
@@ -168,6 +263,10 @@ int mongolite_close(mongolite_db_t *db) {
 
     /* Free mutex */
     _mongolite_lock_free(db);
+    _mongolite_stats_free(db);
+    _mongolite_group_free(db);
+    _mongolite_slowlog_free(db);
+    _mongolite_change_feed_free(db);
 
     free(db->path);
     free(db);
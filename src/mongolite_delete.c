@@ -4,6 +4,7 @@
  * Functions:
  * - mongolite_delete_one() - Delete first matching document
  * - mongolite_delete_many() - Delete all matching documents
+ *   (matching on parallel scan workers for large collections)
  */
 
 #include "mongolite_internal.h"
@@ -18,9 +19,8 @@
  * Delete one document
  * ============================================================ */
 
-MONGOLITE_HOT
-int mongolite_delete_one(mongolite_db_t *db, const char *collection,
-                         const bson_t *filter, gerror_t *error) {
+static int _delete_one(mongolite_db_t *db, const char *collection,
+                       const bson_t *filter, gerror_t *error) {
     VALIDATE_DB_COLLECTION(db, collection, error, -1);
 
     /* We need to find the document first (for index maintenance) */
@@ -37,7 +37,11 @@ int mongolite_delete_one(mongolite_db_t *db, const char *collection,
         return -1;
     }
 
-    if (MONGOLITE_LIKELY(_mongolite_is_id_query(filter, &doc_id))) {
+    bool has_id = _mongolite_is_id_query(filter, &doc_id);
+    _mongolite_stats_query(db, _mongolite_collection_stats_lookup(db, collection),
+                           has_id ? MONGOLITE_PLAN_ID : MONGOLITE_PLAN_SCAN);
+
+    if (MONGOLITE_LIKELY(has_id)) {
         /* Fast path: direct _id lookup */
         doc_to_delete = _mongolite_find_by_id(db, tree, &doc_id, error);
     } else {
@@ -71,13 +75,16 @@ int mongolite_delete_one(mongolite_db_t *db, const char *collection,
         return -1;
     }
 
-    bson_destroy(doc_to_delete);
-
     /* Delete document via wtree3 (indexes maintained automatically) */
     bool deleted = false;
     int rc = wtree3_delete_one_txn(txn, tree,
                                     doc_id.bytes, sizeof(doc_id.bytes),
                                     &deleted, error);
+    if (rc == 0 && deleted && MONGOLITE_UNLIKELY(db->change_feed != NULL)) {
+        rc = _mongolite_change_log(db, txn, MONGOLITE_CHANGE_DELETE, collection, tree,
+                                   &doc_id, doc_to_delete, error);
+    }
+    bson_destroy(doc_to_delete);
     if (MONGOLITE_UNLIKELY(rc != 0)) {
         _mongolite_abort_if_auto(db, txn);
         _mongolite_unlock(db);
@@ -104,6 +111,32 @@ int mongolite_delete_one(mongolite_db_t *db, const char *collection,
     return 0;
 }
 
+/* Group commit: arguments of a queued delete_one */
+typedef struct {
+    const char *collection;
+    const bson_t *filter;
+} delete_one_args_t;
+
+static int _delete_one_grouped(mongolite_db_t *db, void *arg, gerror_t *error) {
+    delete_one_args_t *args = arg;
+    return _delete_one(db, args->collection, args->filter, error);
+}
+
+MONGOLITE_HOT
+int mongolite_delete_one(mongolite_db_t *db, const char *collection,
+                         const bson_t *filter, gerror_t *error) {
+    uint64_t start = _mongolite_stats_start_query(db, collection, filter);
+    int rc;
+    if (collection && _mongolite_group_enabled(db)) {
+        delete_one_args_t args = {collection, filter};
+        rc = _mongolite_group_submit(db, collection, _delete_one_grouped, &args, error);
+    } else {
+        rc = _delete_one(db, collection, filter, error);
+    }
+    _mongolite_stats_record(db, MONGOLITE_OP_DELETE, start);
+    return rc;
+}
+
 /* Helper struct to store document id for deletion */
 typedef struct {
     bson_oid_t id;
@@ -116,14 +149,23 @@ typedef struct {
 /* Context for delete predicate callback */
 typedef struct {
     mongoc_matcher_t *matcher;
+    uint64_t scanned;
+
+    /* Change feed (db->change_feed set): deletes are recorded as matched */
+    mongolite_db_t *db;
+    wtree3_txn_t *txn;
+    const char *collection;
+    int change_rc;                      /* First failure; nothing more matches */
+    gerror_t *error;
 } delete_many_ctx_t;
 
 /* Predicate callback: returns true to delete matching documents */
 static bool _delete_many_predicate(const void *key, size_t key_len,
                                    const void *value, size_t value_len,
                                    void *user_data) {
-    (void)key; (void)key_len;  /* Unused */
     delete_many_ctx_t *ctx = (delete_many_ctx_t*)user_data;
+    if (MONGOLITE_UNLIKELY(ctx->change_rc != 0)) return false;
+    ctx->scanned++;
 
     /* Parse document */
     bson_t doc;
@@ -131,18 +173,23 @@ static bool _delete_many_predicate(const void *key, size_t key_len,
         return false;  /* Don't delete on parse error */
     }
 
-    /* Check if matches filter */
-    if (ctx->matcher) {
-        return mongoc_matcher_match(ctx->matcher, &doc);
+    /* Check if matches filter (no filter = delete all) */
+    if (ctx->matcher && !mongoc_matcher_match(ctx->matcher, &doc)) {
+        return false;
     }
 
-    return true;  /* No filter = delete all */
+    if (MONGOLITE_UNLIKELY(ctx->txn != NULL) && key_len == sizeof(bson_oid_t)) {
+        ctx->change_rc = _mongolite_change_log(ctx->db, ctx->txn, MONGOLITE_CHANGE_DELETE,
+                                               ctx->collection, NULL, (const bson_oid_t *)key,
+                                               &doc, ctx->error);
+        if (ctx->change_rc != 0) return false;
+    }
+    return true;
 }
 
-MONGOLITE_HOT
-int mongolite_delete_many(mongolite_db_t *db, const char *collection,
-                          const bson_t *filter, int64_t *deleted_count,
-                          gerror_t *error) {
+static int _delete_many(mongolite_db_t *db, const char *collection,
+                        const bson_t *filter, int64_t *deleted_count,
+                        gerror_t *error) {
     VALIDATE_DB_COLLECTION(db, collection, error, -1);
 
     if (deleted_count) {
@@ -180,11 +227,69 @@ int mongolite_delete_many(mongolite_db_t *db, const char *collection,
         }
     }
 
-    /* Single-pass delete using wtree3_delete_if_txn - indexes maintained automatically */
-    delete_many_ctx_t ctx = { .matcher = matcher };
+    delete_many_ctx_t ctx = { .matcher = matcher, .scanned = 0 };
+    if (MONGOLITE_UNLIKELY(db->change_feed != NULL)) {
+        ctx.db = db;
+        ctx.txn = txn;
+        ctx.collection = collection;
+        ctx.error = error;
+    }
     size_t count = 0;
-    int rc = wtree3_delete_if_txn(txn, tree, NULL, 0, NULL, 0,
-                                   _delete_many_predicate, &ctx, &count, error);
+    int rc = 0;
+
+    /* Large collections: workers match (snapshot = this txn's base), we delete */
+    gerror_t scan_error = {0};
+    mongolite_scan_t *scan = _mongolite_scan_eligible(db, tree, filter)
+        ? _mongolite_scan_start(db, tree, filter, MONGOLITE_SCAN_KEYS, &scan_error) : NULL;
+    if (scan) {
+        const void *key;
+        size_t key_len;
+        int scan_rc;
+        while ((scan_rc = _mongolite_scan_next(scan, &key, &key_len)) == 1) {
+            if (MONGOLITE_UNLIKELY(ctx.txn != NULL)) {
+                /* The removed document only supplies the change's _id */
+                const void *value;
+                size_t value_len;
+                bson_t doc;
+                rc = wtree3_get_txn(txn, tree, key, key_len, &value, &value_len, error);
+                if (rc == WTREE3_NOT_FOUND) continue;
+                if (rc == 0 && bson_init_static(&doc, value, value_len)) {
+                    rc = _mongolite_change_log(db, txn, MONGOLITE_CHANGE_DELETE, collection, tree,
+                                               (const bson_oid_t *)key, &doc, error);
+                }
+                if (MONGOLITE_UNLIKELY(rc != 0)) break;
+            }
+            bool deleted = false;
+            rc = wtree3_delete_one_txn(txn, tree, key, key_len, &deleted, error);
+            if (MONGOLITE_UNLIKELY(rc != 0)) break;
+            if (deleted) count++;
+        }
+        ctx.scanned = _mongolite_scan_scanned(scan);
+        _mongolite_scan_free(scan);
+
+        if (MONGOLITE_UNLIKELY(rc != 0 || scan_rc < 0)) {
+            if (rc == 0) set_error(error, MONGOLITE_LIB, scan_rc, "Parallel scan failed");
+            if (matcher) mongoc_matcher_destroy(matcher);
+            _mongolite_abort_if_auto(db, txn);
+            _mongolite_unlock(db);
+            return -1;
+        }
+    } else {
+        /* Single-pass delete using wtree3_delete_if_txn - indexes maintained automatically */
+        rc = wtree3_delete_if_txn(txn, tree, NULL, 0, NULL, 0,
+                                  _delete_many_predicate, &ctx, &count, error);
+        if (rc == 0) rc = ctx.change_rc;
+        if (MONGOLITE_UNLIKELY(rc != 0)) {
+            if (matcher) mongoc_matcher_destroy(matcher);
+            _mongolite_abort_if_auto(db, txn);
+            _mongolite_unlock(db);
+            return -1;
+        }
+    }
+
+    mongolite_op_stats_shard_t *col_stats = _mongolite_collection_stats_lookup(db, collection);
+    _mongolite_stats_query(db, col_stats, MONGOLITE_PLAN_SCAN);
+    _mongolite_stats_docs(db, col_stats, ctx.scanned, count, matcher ? ctx.scanned : 0);
 
     if (matcher) {
         mongoc_matcher_destroy(matcher);
@@ -207,3 +312,13 @@ int mongolite_delete_many(mongolite_db_t *db, const char *collection,
     _mongolite_unlock(db);
     return 0;
 }
+
+MONGOLITE_HOT
+int mongolite_delete_many(mongolite_db_t *db, const char *collection,
+                          const bson_t *filter, int64_t *deleted_count,
+                          gerror_t *error) {
+    uint64_t start = _mongolite_stats_start_query(db, collection, filter);
+    int rc = _delete_many(db, collection, filter, deleted_count, error);
+    _mongolite_stats_record(db, MONGOLITE_OP_DELETE, start);
+    return rc;
+}
@@ -0,0 +1,467 @@
+/*
+ * mongolite_durability.c - Durability levels and background sync
+ *
+ * Handles:
+ * - Mapping durability levels to LMDB flags
+ * - Commit ids and the durable id (last commit known to be on disk)
+ * - Background flusher thread (ASYNC: every interval or N bytes)
+ * - Env lock against map resizes for calls made outside the db lock
+ * - Public API: mongolite_commit_id, mongolite_durable_id,
+ *   mongolite_wait_durable
+ */
+
+#include "mongolite_internal.h"
+#include "macros.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <process.h>
+#else
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
+#endif
+
+#define MONGOLITE_LIB "mongolite"
+
+/* ============================================================
+ * Flusher State
+ * ============================================================ */
+
+struct mongolite_flusher {
+#ifdef _WIN32
+    CRITICAL_SECTION env_mutex;
+    CRITICAL_SECTION mutex;
+    CONDITION_VARIABLE wake_cond;
+    CONDITION_VARIABLE durable_cond;
+    HANDLE thread;
+#else
+    pthread_mutex_t env_mutex;          /* Map reads vs resize (may nest inside mutex) */
+    pthread_mutex_t mutex;
+    pthread_cond_t wake_cond;           /* Flusher: sync now (or stop) */
+    pthread_cond_t durable_cond;        /* Waiters: a sync finished */
+    pthread_t thread;
+#endif
+    mongolite_db_t *db;
+    bool thread_started;
+    bool stop;
+    bool requested;                     /* Sync before the next tick */
+
+    unsigned int interval_ms;
+    uint64_t sync_bytes;                /* 0 = interval only */
+
+    /* Written under mutex; read relaxed outside it */
+    uint64_t durable_id;                /* Last commit known to be on disk */
+    uint64_t synced_bytes;              /* bytes_written when the last sync started */
+    uint64_t sync_count;                /* Completed sync attempts */
+    int sync_rc;                        /* Result of the last attempt */
+};
+
+static void _flusher_lock(mongolite_flusher_t *f) {
+#ifdef _WIN32
+    EnterCriticalSection(&f->mutex);
+#else
+    pthread_mutex_lock(&f->mutex);
+#endif
+}
+
+static void _flusher_unlock(mongolite_flusher_t *f) {
+#ifdef _WIN32
+    LeaveCriticalSection(&f->mutex);
+#else
+    pthread_mutex_unlock(&f->mutex);
+#endif
+}
+
+void _mongolite_env_lock(mongolite_db_t *db) {
+    if (!db->flusher) return;
+#ifdef _WIN32
+    EnterCriticalSection(&db->flusher->env_mutex);
+#else
+    pthread_mutex_lock(&db->flusher->env_mutex);
+#endif
+}
+
+void _mongolite_env_unlock(mongolite_db_t *db) {
+    if (!db->flusher) return;
+#ifdef _WIN32
+    LeaveCriticalSection(&db->flusher->env_mutex);
+#else
+    pthread_mutex_unlock(&db->flusher->env_mutex);
+#endif
+}
+
+static void _flusher_wake(mongolite_flusher_t *f) {
+#ifdef _WIN32
+    WakeConditionVariable(&f->wake_cond);
+#else
+    pthread_cond_signal(&f->wake_cond);
+#endif
+}
+
+static void _flusher_broadcast_durable(mongolite_flusher_t *f) {
+#ifdef _WIN32
+    WakeAllConditionVariable(&f->durable_cond);
+#else
+    pthread_cond_broadcast(&f->durable_cond);
+#endif
+}
+
+#ifndef _WIN32
+static void _deadline_after_ms(struct timespec *ts, unsigned int ms) {
+    clock_gettime(CLOCK_REALTIME, ts);
+    ts->tv_nsec += (long)(ms % 1000) * 1000000L;
+    ts->tv_sec += ms / 1000 + ts->tv_nsec / 1000000000L;
+    ts->tv_nsec %= 1000000000L;
+}
+#endif
+
+/* Wait on cond for up to ms (< 0 = forever). Returns false on timeout. */
+static bool _flusher_wait(mongolite_flusher_t *f, bool durable, int ms) {
+#ifdef _WIN32
+    CONDITION_VARIABLE *cond = durable ? &f->durable_cond : &f->wake_cond;
+    return SleepConditionVariableCS(cond, &f->mutex, ms < 0 ? INFINITE : (DWORD)ms) != 0;
+#else
+    pthread_cond_t *cond = durable ? &f->durable_cond : &f->wake_cond;
+    if (ms < 0) {
+        pthread_cond_wait(cond, &f->mutex);
+        return true;
+    }
+    struct timespec deadline;
+    _deadline_after_ms(&deadline, (unsigned int)ms);
+    return pthread_cond_timedwait(cond, &f->mutex, &deadline) != ETIMEDOUT;
+#endif
+}
+
+/* ============================================================
+ * Commit Ids
+ * ============================================================ */
+
+/* Caller holds the env lock (or the db lock, which resizes also take) */
+static uint64_t _last_commit_id_locked(mongolite_db_t *db) {
+    MDB_envinfo info;
+    /* No environment: a compaction failed to reopen it */
+    if (!db->wdb) return 0;
+    if (mdb_env_info(wtree3_db_get_env(db->wdb), &info) != 0) return 0;
+    return (uint64_t)info.me_last_txnid;
+}
+
+static uint64_t _last_commit_id(mongolite_db_t *db) {
+    _mongolite_env_lock(db);
+    uint64_t id = _last_commit_id_locked(db);
+    _mongolite_env_unlock(db);
+    return id;
+}
+
+uint64_t mongolite_commit_id(mongolite_db_t *db) {
+    if (!db || !db->wdb) return 0;
+    return _last_commit_id(db);
+}
+
+uint64_t mongolite_durable_id(mongolite_db_t *db) {
+    if (!db || !db->wdb) return 0;
+    if (db->sync_on_commit || !db->flusher) return _last_commit_id(db);
+    return MONGOLITE_ATOMIC_LOAD(&db->flusher->durable_id);
+}
+
+/* ============================================================
+ * Sync
+ * ============================================================ */
+
+int _mongolite_durability_sync(mongolite_db_t *db, gerror_t *error) {
+    mongolite_flusher_t *f = db->flusher;
+
+    /* Everything committed before the sync starts is covered by it */
+    _mongolite_env_lock(db);
+    uint64_t commit_id = _last_commit_id_locked(db);
+    uint64_t bytes = wtree3_db_bytes_written(db->wdb);
+    int rc = wtree3_db_sync(db->wdb, true, error);
+    _mongolite_env_unlock(db);
+
+    MONGOLITE_STAT(db, syncs, 1);
+    if (!f) return rc;
+
+    _flusher_lock(f);
+    if (rc == 0) {
+        if (commit_id > f->durable_id) MONGOLITE_ATOMIC_STORE(&f->durable_id, commit_id);
+        if (bytes > f->synced_bytes) MONGOLITE_ATOMIC_STORE(&f->synced_bytes, bytes);
+    }
+    f->sync_rc = rc;
+    f->sync_count++;
+    _flusher_broadcast_durable(f);
+    _flusher_unlock(f);
+    return rc;
+}
+
+/* ============================================================
+ * Flusher Thread (ASYNC)
+ * ============================================================ */
+
+#ifdef _WIN32
+static unsigned __stdcall _flusher_main(void *arg)
+#else
+static void* _flusher_main(void *arg)
+#endif
+{
+    mongolite_flusher_t *f = arg;
+    mongolite_db_t *db = f->db;
+
+    _flusher_lock(f);
+    while (!f->stop) {
+        if (!f->requested) _flusher_wait(f, false, (int)f->interval_ms);
+        if (f->stop) break;
+        f->requested = false;
+
+        if (_last_commit_id(db) <= f->durable_id) continue;
+
+        _flusher_unlock(f);
+        gerror_t error = {0};
+        (void)_mongolite_durability_sync(db, &error);
+        _flusher_lock(f);
+    }
+    _flusher_unlock(f);
+
+#ifdef _WIN32
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+/* ============================================================
+ * Init / Close
+ * ============================================================ */
+
+unsigned int _mongolite_durability_env_flags(const db_config_t *config) {
+    if (!config || config->durability == MONGOLITE_DURABILITY_FULL) return 0;
+    return MDB_NOSYNC;
+}
+
+static void _flusher_destroy(mongolite_flusher_t *f) {
+#ifdef _WIN32
+    DeleteCriticalSection(&f->mutex);
+    DeleteCriticalSection(&f->env_mutex);
+#else
+    pthread_cond_destroy(&f->durable_cond);
+    pthread_cond_destroy(&f->wake_cond);
+    pthread_mutex_destroy(&f->mutex);
+    pthread_mutex_destroy(&f->env_mutex);
+#endif
+    free(f);
+}
+
+int _mongolite_durability_init(mongolite_db_t *db, const db_config_t *config) {
+    db->durability = config ? config->durability : MONGOLITE_DURABILITY_FULL;
+
+    unsigned int env_flags = 0;
+    mdb_env_get_flags(wtree3_db_get_env(db->wdb), &env_flags);
+    db->sync_on_commit = !(env_flags & (MDB_NOSYNC | MDB_NOMETASYNC | MDB_MAPASYNC));
+
+    mongolite_flusher_t *f = calloc(1, sizeof(mongolite_flusher_t));
+    if (!f) return MONGOLITE_ENOMEM;
+
+#ifdef _WIN32
+    InitializeCriticalSection(&f->env_mutex);
+    InitializeCriticalSection(&f->mutex);
+    InitializeConditionVariable(&f->wake_cond);
+    InitializeConditionVariable(&f->durable_cond);
+#else
+    if (pthread_mutex_init(&f->env_mutex, NULL) != 0) {
+        free(f);
+        return MONGOLITE_ERROR;
+    }
+    if (pthread_mutex_init(&f->mutex, NULL) != 0) {
+        pthread_mutex_destroy(&f->env_mutex);
+        free(f);
+        return MONGOLITE_ERROR;
+    }
+    if (pthread_cond_init(&f->wake_cond, NULL) != 0) {
+        pthread_mutex_destroy(&f->mutex);
+        pthread_mutex_destroy(&f->env_mutex);
+        free(f);
+        return MONGOLITE_ERROR;
+    }
+    if (pthread_cond_init(&f->durable_cond, NULL) != 0) {
+        pthread_cond_destroy(&f->wake_cond);
+        pthread_mutex_destroy(&f->mutex);
+        pthread_mutex_destroy(&f->env_mutex);
+        free(f);
+        return MONGOLITE_ERROR;
+    }
+#endif
+
+    f->db = db;
+    f->interval_ms = (config && config->sync_interval_ms) ? config->sync_interval_ms
+                                                          : MONGOLITE_DEFAULT_SYNC_INTERVAL_MS;
+    f->sync_bytes = config ? config->sync_bytes : 0;
+    /* What is on disk at open is durable */
+    f->durable_id = _last_commit_id(db);
+    f->synced_bytes = wtree3_db_bytes_written(db->wdb);
+
+    /* Published before the thread starts: it syncs through db->flusher */
+    db->flusher = f;
+
+    int rc = _mongolite_durability_start(db);
+    if (rc != MONGOLITE_OK) {
+        db->flusher = NULL;
+        _flusher_destroy(f);
+    }
+    return rc;
+}
+
+int _mongolite_durability_start(mongolite_db_t *db) {
+    mongolite_flusher_t *f = db->flusher;
+    if (!f || f->thread_started) return MONGOLITE_OK;
+    if (db->durability != MONGOLITE_DURABILITY_ASYNC || db->sync_on_commit) return MONGOLITE_OK;
+
+    f->stop = false;
+#ifdef _WIN32
+    f->thread = (HANDLE)_beginthreadex(NULL, 0, _flusher_main, f, 0, NULL);
+    f->thread_started = (f->thread != 0);
+#else
+    f->thread_started = (pthread_create(&f->thread, NULL, _flusher_main, f) == 0);
+#endif
+    return f->thread_started ? MONGOLITE_OK : MONGOLITE_ERROR;
+}
+
+void _mongolite_durability_stop(mongolite_db_t *db) {
+    if (!db || !db->flusher) return;
+    mongolite_flusher_t *f = db->flusher;
+
+    if (f->thread_started) {
+        _flusher_lock(f);
+        f->stop = true;
+        _flusher_wake(f);
+        _flusher_unlock(f);
+#ifdef _WIN32
+        WaitForSingleObject(f->thread, INFINITE);
+        CloseHandle(f->thread);
+#else
+        pthread_join(f->thread, NULL);
+#endif
+        f->thread_started = false;
+    }
+
+    /* Leave nothing committed-but-unsynced behind a clean close */
+    if (db->wdb && !db->sync_on_commit && _last_commit_id(db) > f->durable_id) {
+        gerror_t error = {0};
+        (void)_mongolite_durability_sync(db, &error);
+    }
+}
+
+void _mongolite_durability_close(mongolite_db_t *db) {
+    if (!db || !db->flusher) return;
+    _mongolite_durability_stop(db);
+
+    mongolite_flusher_t *f = db->flusher;
+    db->flusher = NULL;
+    _flusher_destroy(f);
+}
+
+void _mongolite_durability_reset(mongolite_db_t *db) {
+    mongolite_flusher_t *f = db->flusher;
+    if (!f) return;
+
+    uint64_t commit_id = _last_commit_id(db);
+    _flusher_lock(f);
+    MONGOLITE_ATOMIC_STORE(&f->durable_id, commit_id);
+    MONGOLITE_ATOMIC_STORE(&f->synced_bytes, wtree3_db_bytes_written(db->wdb));
+    _flusher_broadcast_durable(f);
+    _flusher_unlock(f);
+}
+
+/* ============================================================
+ * Commit Hook
+ * ============================================================ */
+
+void _mongolite_durability_committed(mongolite_db_t *db) {
+    mongolite_flusher_t *f = db->flusher;
+    if (!f || !f->thread_started || f->sync_bytes == 0) return;
+
+    uint64_t pending = wtree3_db_bytes_written(db->wdb) -
+                       MONGOLITE_ATOMIC_LOAD(&f->synced_bytes);
+    if (pending < f->sync_bytes) return;
+
+    _flusher_lock(f);
+    if (!f->requested) {
+        f->requested = true;
+        _flusher_wake(f);
+    }
+    _flusher_unlock(f);
+}
+
+/* ============================================================
+ * Wait
+ * ============================================================ */
+
+#ifdef _WIN32
+static uint64_t _now_ms(void) {
+    return (uint64_t)GetTickCount64();
+}
+#else
+static uint64_t _now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+#endif
+
+int mongolite_wait_durable(mongolite_db_t *db, uint64_t commit_id, int timeout_ms,
+                           gerror_t *error) {
+    if (!db || !db->wdb) {
+        set_error(error, MONGOLITE_LIB, MONGOLITE_EINVAL, "Database is NULL");
+        return MONGOLITE_EINVAL;
+    }
+
+    uint64_t last = _last_commit_id(db);
+    if (commit_id == 0) commit_id = last;
+    if (commit_id > last) {
+        set_error(error, MONGOLITE_LIB, MONGOLITE_EINVAL,
+                  "Commit %llu has not happened yet", (unsigned long long)commit_id);
+        return MONGOLITE_EINVAL;
+    }
+
+    mongolite_flusher_t *f = db->flusher;
+    if (db->sync_on_commit || !f) return MONGOLITE_OK;
+    if (MONGOLITE_ATOMIC_LOAD(&f->durable_id) >= commit_id) return MONGOLITE_OK;
+
+    /* No flusher (NONE): this thread pays for the sync */
+    if (!f->thread_started) return _mongolite_durability_sync(db, error);
+
+    /* ASYNC: have the flusher sync now; one sync serves every waiter */
+    uint64_t deadline = timeout_ms < 0 ? 0 : _now_ms() + (uint64_t)timeout_ms;
+    int rc = MONGOLITE_OK;
+
+    _flusher_lock(f);
+    uint64_t seen = f->sync_count;
+    if (!f->requested) {
+        f->requested = true;
+        _flusher_wake(f);
+    }
+    while (f->durable_id < commit_id) {
+        /* A sync that started after this call failed: report it */
+        if (f->sync_count > seen + 1 && f->sync_rc != 0) {
+            rc = f->sync_rc;
+            set_error(error, MONGOLITE_LIB, rc, "Background sync failed");
+            break;
+        }
+
+        int wait_ms = -1;
+        if (timeout_ms >= 0) {
+            uint64_t now = _now_ms();
+            if (now >= deadline) {
+                rc = MONGOLITE_ETIMEDOUT;
+                set_error(error, MONGOLITE_LIB, rc,
+                          "Commit %llu not durable within %d ms",
+                          (unsigned long long)commit_id, timeout_ms);
+                break;
+            }
+            wait_ms = (int)(deadline - now);
+        }
+        _flusher_wait(f, true, wait_ms);
+    }
+    _flusher_unlock(f);
+    return rc;
+}
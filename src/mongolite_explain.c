@@ -0,0 +1,138 @@
+/*
+ * mongolite_explain.c - Query plan and execution reports
+ *
+ * Handles:
+ * - mongolite_explain: plans and runs a find, then reports the access
+ *   path, the indexes weighed against it and what the run read
+ *
+ * The report follows MongoDB's explain layout (queryPlanner /
+ * executionStats) so the usual reading of it carries over. The query
+ * really runs: counters come from the cursor that answered it, and
+ * it is counted in mongolite_stats like any other find.
+ */
+
+#include "mongolite_internal.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define MONGOLITE_LIB "mongolite"
+
+/* ============================================================
+ * Plan Description
+ * ============================================================ */
+
+/* The stage tree of the plan the cursor runs. The seek stage comes from
+ * the index planner; a seek it could not answer has fallen back to a scan. */
+static void _explain_winning_plan(mongolite_db_t *db, mongolite_tree_cache_entry_t *entry,
+                                  const bson_t *filter, const mongolite_cursor_t *cursor,
+                                  bson_t *out, bson_t *candidates, gerror_t *error) {
+    bool has_filter = filter && !bson_empty(filter);
+    bson_t seek = BSON_INITIALIZER;
+    bool seekable = _mongolite_index_explain(db, entry, filter, &seek, candidates, error);
+
+    if (cursor->plan == MONGOLITE_PLAN_SCAN) {
+        BSON_APPEND_UTF8(out, "stage", "COLLSCAN");
+        if (has_filter) BSON_APPEND_DOCUMENT(out, "filter", filter);
+        BSON_APPEND_BOOL(out, "parallel", cursor->scan != NULL);
+        bson_destroy(&seek);
+        return;
+    }
+
+    BSON_APPEND_UTF8(out, "stage", "FETCH");
+    if (cursor->matcher) BSON_APPEND_DOCUMENT(out, "filter", filter);
+    if (seekable) {
+        BSON_APPEND_DOCUMENT(out, "inputStage", &seek);
+    } else {
+        /* {_id: {$in: [...]}} mixed with predicates the seeks skip */
+        bson_t input;
+        BSON_APPEND_DOCUMENT_BEGIN(out, "inputStage", &input);
+        BSON_APPEND_UTF8(&input, "stage", "ID_LOOKUP");
+        BSON_APPEND_INT64(&input, "seeks", (int64_t)cursor->n_ids);
+        bson_append_document_end(out, &input);
+    }
+    bson_destroy(&seek);
+}
+
+/* ============================================================
+ * Public API
+ * ============================================================ */
+
+bson_t* mongolite_explain(mongolite_db_t *db, const char *collection,
+                          const bson_t *filter, const bson_t *sort,
+                          const bson_t *projection, gerror_t *error) {
+    if (!db || !collection) {
+        set_error(error, MONGOLITE_LIB, MONGOLITE_EINVAL,
+                 "Database and collection are required");
+        return NULL;
+    }
+
+    uint64_t start = _mongolite_stats_start(db);
+    uint64_t t0 = _mongolite_now_ns();
+    _mongolite_lock(db);
+
+    mongolite_tree_cache_entry_t *entry = _mongolite_get_collection_entry(db, collection, error);
+    if (!entry) {
+        _mongolite_unlock(db);
+        return NULL;
+    }
+
+    uint64_t hits = entry->plan_hits;
+    mongolite_cached_index_t *idx = NULL;
+    mongolite_plan_type_t plan = _mongolite_plan_query(db, entry, filter, &idx, error);
+    bool cache_hit = entry->plan_hits > hits;
+
+    mongolite_cursor_t *cursor = _mongolite_find_entry_planned(db, entry, filter, projection,
+                                                               plan, error);
+    if (!cursor) {
+        _mongolite_unlock(db);
+        return NULL;
+    }
+    uint64_t planning_ns = _mongolite_now_ns() - t0;
+
+    bson_t *result = bson_new();
+    bson_t planner, winning, exec;
+    BSON_APPEND_DOCUMENT_BEGIN(result, "queryPlanner", &planner);
+    BSON_APPEND_UTF8(&planner, "namespace", collection);
+    if (filter) BSON_APPEND_DOCUMENT(&planner, "filter", filter);
+    if (sort && !bson_empty(sort)) BSON_APPEND_DOCUMENT(&planner, "sort", sort);
+    if (projection && !bson_empty(projection)) {
+        BSON_APPEND_DOCUMENT(&planner, "projection", projection);
+    }
+    BSON_APPEND_BOOL(&planner, "planCacheHit", cache_hit);
+
+    bson_t candidate_list = BSON_INITIALIZER;
+    BSON_APPEND_DOCUMENT_BEGIN(&planner, "winningPlan", &winning);
+    _explain_winning_plan(db, entry, filter, cursor, &winning, &candidate_list, error);
+    bson_append_document_end(&planner, &winning);
+    bson_append_array(&planner, "candidates", -1, &candidate_list);
+    bson_destroy(&candidate_list);
+    bson_append_document_end(result, &planner);
+
+    _mongolite_unlock(db);
+
+    /* Run it to the end, as the caller's loop would */
+    uint64_t t1 = _mongolite_now_ns();
+    const bson_t *doc;
+    while (mongolite_cursor_next(cursor, &doc)) continue;
+    uint64_t elapsed_ns = planning_ns + (_mongolite_now_ns() - t1);
+
+    /* A failed run has no meaningful counts */
+    if (mongolite_cursor_error(cursor, error) != MONGOLITE_OK) {
+        mongolite_cursor_destroy(cursor);
+        bson_destroy(result);
+        return NULL;
+    }
+
+    uint64_t docs = cursor->scan ? _mongolite_scan_scanned(cursor->scan)
+                                 : (uint64_t)cursor->position;
+    BSON_APPEND_DOCUMENT_BEGIN(result, "executionStats", &exec);
+    BSON_APPEND_INT64(&exec, "nReturned", cursor->returned);
+    BSON_APPEND_INT64(&exec, "keysExamined", (int64_t)cursor->keys_examined);
+    BSON_APPEND_INT64(&exec, "docsExamined", (int64_t)docs);
+    BSON_APPEND_INT64(&exec, "executionTimeMicros", (int64_t)(elapsed_ns / 1000));
+    bson_append_document_end(result, &exec);
+
+    mongolite_cursor_destroy(cursor);
+    _mongolite_stats_record(db, MONGOLITE_OP_FIND, start);
+    return result;
+}
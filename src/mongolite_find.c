@@ -4,8 +4,10 @@
  * Handles:
  * - find_one / find
  * - JSON wrappers
- * - _id optimization
+ * - _id optimization, batched _id lookups ($in, find_many_by_id)
+ * - Plan cache statistics
  * - bsonmatch integration for filtering
+ * - Handing large filtered scans to parallel workers
  */
 
 #include "mongolite_internal.h"
@@ -54,6 +56,63 @@ bool _mongolite_is_id_query(const bson_t *filter, bson_oid_t *out_oid) {
     return (field_count == 1 && has_id);
 }
 
+/* ============================================================
+ * Internal: Check if filter is an _id $in query
+ * ============================================================ */
+
+static int _oid_cmp(const void *a, const void *b) {
+    return memcmp(a, b, sizeof(bson_oid_t));
+}
+
+size_t _mongolite_oids_sort_unique(bson_oid_t *ids, size_t n) {
+    qsort(ids, n, sizeof(bson_oid_t), _oid_cmp);
+    size_t unique = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (unique == 0 || memcmp(&ids[unique - 1], &ids[i], sizeof(bson_oid_t)) != 0) {
+            ids[unique++] = ids[i];
+        }
+    }
+    return unique;
+}
+
+bool _mongolite_id_in_query(const bson_t *filter, bson_oid_t **out_ids, size_t *out_n,
+                            bool *out_residual) {
+    if (!filter || bson_empty(filter)) return false;
+
+    bson_iter_t iter, ops, elems;
+    if (!bson_iter_init_find(&iter, filter, "_id") || !BSON_ITER_HOLDS_DOCUMENT(&iter)) {
+        return false;
+    }
+    if (!bson_iter_recurse(&iter, &ops) || !bson_iter_next(&ops) ||
+        strcmp(bson_iter_key(&ops), "$in") != 0 || !BSON_ITER_HOLDS_ARRAY(&ops)) {
+        return false;
+    }
+    bson_iter_t more = ops;
+    if (bson_iter_next(&more)) return false;     /* {$in: [...], $nin: ...} */
+
+    /* Every element must be an OID */
+    size_t n = 0;
+    if (!bson_iter_recurse(&ops, &elems)) return false;
+    while (bson_iter_next(&elems)) {
+        if (!BSON_ITER_HOLDS_OID(&elems)) return false;
+        n++;
+    }
+
+    bson_oid_t *ids = malloc((n ? n : 1) * sizeof(bson_oid_t));
+    if (!ids) return false;
+    size_t i = 0;
+    bson_iter_recurse(&ops, &elems);
+    while (bson_iter_next(&elems)) {
+        bson_oid_copy(bson_iter_oid(&elems), &ids[i++]);
+    }
+
+    /* Key order (the scan's order), duplicates once */
+    *out_ids = ids;
+    *out_n = _mongolite_oids_sort_unique(ids, n);
+    *out_residual = bson_count_keys(filter) > 1;
+    return true;
+}
+
 /* ============================================================
  * Internal: Get document by _id (direct lookup)
  * ============================================================ */
@@ -87,6 +146,122 @@ bson_t* _mongolite_find_by_id(mongolite_db_t *db, wtree3_tree_t *tree,
  * Find One
  * ============================================================ */
 
+/* First match among the ids, in key order (or the nearest of a $near
+ * search, when near is set), checked against residual (NULL: the ids
+ * are exact). Takes ownership of ids and near and releases txn (from
+ * _mongolite_get_read_txn). */
+static bson_t* _find_one_by_ids(mongolite_db_t *db, mongolite_tree_cache_entry_t *entry,
+                                wtree3_txn_t *txn, const bson_t *residual,
+                                bson_oid_t *ids, size_t n_ids, mongolite_geo_near_t *near,
+                                gerror_t *error) {
+    mongolite_cursor_t *cursor = _mongolite_cursor_create_with_txn(
+        db, entry->tree, entry->name, txn, residual, error);
+    if (MONGOLITE_UNLIKELY(!cursor)) {
+        free(ids);
+        _mongolite_geo_near_free(near);
+        _mongolite_release_read_txn(db, txn);
+        return NULL;
+    }
+    if (near) _mongolite_cursor_set_near(cursor, entry->tree, near);
+    else _mongolite_cursor_set_ids(cursor, entry->tree, ids, n_ids);
+    mongolite_cursor_set_limit(cursor, 1);
+
+    bson_t *result = NULL;
+    const bson_t *doc;
+    if (mongolite_cursor_next(cursor, &doc)) {
+        result = bson_copy(doc);
+    } else {
+        (void)mongolite_cursor_error(cursor, error);
+    }
+
+    mongolite_cursor_destroy(cursor);
+    _mongolite_release_read_txn(db, txn);
+    return result;
+}
+
+MONGOLITE_HOT
+bson_t* _mongolite_find_one_entry(mongolite_db_t *db, mongolite_tree_cache_entry_t *entry,
+                                   const bson_t *filter, const bson_t *projection,
+                                   gerror_t *error) {
+    wtree3_tree_t *tree = entry->tree;
+
+    /* TODO: Apply projection if specified */
+    (void)projection;
+
+    /* Batched lookups: {_id: {$in: [...]}} (first match in _id order) */
+    bson_oid_t *ids;
+    size_t n_ids;
+    bool residual;
+    if (_mongolite_id_in_query(filter, &ids, &n_ids, &residual)) {
+        wtree3_txn_t *txn = _mongolite_get_read_txn(db, error);
+        if (MONGOLITE_UNLIKELY(!txn)) {
+            free(ids);
+            return NULL;
+        }
+        _mongolite_stats_query(db, entry->stats, MONGOLITE_PLAN_ID);
+        return _find_one_by_ids(db, entry, txn, residual ? filter : NULL, ids, n_ids, NULL,
+                                error);
+    }
+
+    /* Plan (cached per query shape) */
+    mongolite_cached_index_t *idx = NULL;
+    mongolite_plan_type_t plan = _mongolite_plan_query(db, entry, filter, &idx, error);
+
+    /* Optimization 1: direct _id lookup */
+    if (plan == MONGOLITE_PLAN_ID) {
+        bson_oid_t oid;
+        if (_mongolite_is_id_query(filter, &oid)) {
+            _mongolite_stats_query(db, entry->stats, MONGOLITE_PLAN_ID);
+            bson_t *doc = _mongolite_find_by_id(db, tree, &oid, error);
+            if (doc) _mongolite_stats_docs(db, entry->stats, 1, 1, 0);
+            return doc;
+        }
+    }
+
+    /* Optimization 2: use secondary index */
+    if (plan == MONGOLITE_PLAN_INDEX_EQ && idx) {
+        _mongolite_stats_query(db, entry->stats, MONGOLITE_PLAN_INDEX_EQ);
+        return _find_one_with_index(db, entry->name, tree, idx, filter, error);
+    }
+
+    /* Optimization 3: point seeks ($in lists, $or index unions) */
+    if (plan == MONGOLITE_PLAN_INDEX_MULTI) {
+        wtree3_txn_t *txn = _mongolite_get_read_txn(db, error);
+        if (MONGOLITE_UNLIKELY(!txn)) return NULL;
+
+        /* $near: the nearest match; the rest of the filter is matched */
+        mongolite_geo_near_t *near = NULL;
+        bson_t *rest = NULL;
+        int rc = _mongolite_index_seek_near(db, entry, filter, &near, &rest, error);
+        if (rc > 0) {
+            _mongolite_stats_query(db, entry->stats, MONGOLITE_PLAN_INDEX_MULTI);
+            bson_t *doc = _find_one_by_ids(db, entry, txn, rest, NULL, 0, near, error);
+            if (rest) bson_destroy(rest);
+            return doc;
+        }
+        if (rc == 0) {
+            rc = _mongolite_index_seek_ids(db, entry, txn, filter, &ids, &n_ids, &residual,
+                                           NULL, error);
+        }
+        if (rc > 0) {
+            /* A $text predicate was answered by the seeks */
+            rest = residual ? _mongolite_text_strip(filter) : NULL;
+            _mongolite_stats_query(db, entry->stats, MONGOLITE_PLAN_INDEX_MULTI);
+            bson_t *doc = _find_one_by_ids(db, entry, txn, rest ? rest : (residual ? filter : NULL),
+                                           ids, n_ids, NULL, error);
+            if (rest) bson_destroy(rest);
+            return doc;
+        }
+        _mongolite_release_read_txn(db, txn);
+        if (rc < 0) return NULL;
+    }
+
+    /* Fallback: Full scan with filter (docs counted by the cursor) */
+    if (_mongolite_text_unindexed(filter, error)) return NULL;
+    _mongolite_stats_query(db, entry->stats, MONGOLITE_PLAN_SCAN);
+    return _mongolite_find_one_scan(db, tree, entry->name, filter, error);
+}
+
 bson_t* mongolite_find_one(mongolite_db_t *db, const char *collection,
                             const bson_t *filter, const bson_t *projection,
                             gerror_t *error) {
@@ -96,52 +271,168 @@ bson_t* mongolite_find_one(mongolite_db_t *db, const char *collection,
         return NULL;
     }
 
+    uint64_t start = _mongolite_stats_start_query(db, collection, filter);
     _mongolite_lock(db);
 
-    /* Get collection tree (wtree3) */
-    wtree3_tree_t *tree = _mongolite_get_collection_tree(db, collection, error);
-    if (!tree) {
+    /* Get collection cache entry (wtree3 tree + index specs) */
+    mongolite_tree_cache_entry_t *entry = _mongolite_get_collection_entry(db, collection, error);
+    if (!entry) {
         _mongolite_unlock(db);
         return NULL;
     }
 
-    bson_t *result = NULL;
+    bson_t *result = _mongolite_find_one_entry(db, entry, filter, projection, error);
 
-    /* Optimization 1: direct _id lookup */
-    bson_oid_t oid;
-    if (_mongolite_is_id_query(filter, &oid)) {
-        result = _mongolite_find_by_id(db, tree, &oid, error);
-        _mongolite_unlock(db);
-        /* TODO: Apply projection if specified */
-        (void)projection;
-        return result;
-    }
-
-    /* Optimization 2: try to use secondary index */
-    query_analysis_t *analysis = _analyze_query_for_index(filter);
-    if (analysis) {
-        mongolite_cached_index_t *idx = _find_best_index(db, collection, analysis, error);
-        if (idx && analysis->is_simple_equality) {
-            /* Use index for lookup */
-            result = _find_one_with_index(db, collection, tree, idx, filter, error);
-            _free_query_analysis(analysis);
-            _mongolite_unlock(db);
-            /* TODO: Apply projection if specified */
-            (void)projection;
-            return result;
+    _mongolite_unlock(db);
+    _mongolite_stats_record(db, MONGOLITE_OP_FIND_ONE, start);
+    return result;
+}
+
+bson_t* mongolite_col_find_one(mongolite_collection_t *col, const bson_t *filter,
+                                const bson_t *projection, gerror_t *error) {
+    if (!col) {
+        set_error(error, MONGOLITE_LIB, MONGOLITE_EINVAL, "Collection handle is required");
+        return NULL;
+    }
+
+    mongolite_db_t *db = col->db;
+    uint64_t start = _mongolite_stats_start_query(db, col->name, filter);
+    _mongolite_lock(db);
+
+    mongolite_tree_cache_entry_t *entry = _mongolite_collection_resolve(col, error);
+    bson_t *result = entry ? _mongolite_find_one_entry(db, entry, filter, projection, error)
+                           : NULL;
+
+    _mongolite_unlock(db);
+    _mongolite_stats_record(db, MONGOLITE_OP_FIND_ONE, start);
+    return result;
+}
+
+/* ============================================================
+ * Find Many By Id
+ * ============================================================ */
+
+static int _find_many_by_id_entry(mongolite_db_t *db, mongolite_tree_cache_entry_t *entry,
+                                  const bson_oid_t *ids, size_t n_ids, bson_t **docs,
+                                  gerror_t *error) {
+    for (size_t i = 0; i < n_ids; i++) docs[i] = NULL;
+    _mongolite_stats_query(db, entry->stats, MONGOLITE_PLAN_ID);
+    if (n_ids == 0) return MONGOLITE_OK;
+
+    const void **keys = malloc(n_ids * sizeof(*keys));
+    mongolite_fetch_t *found = malloc(n_ids * sizeof(*found));
+    if (!keys || !found) {
+        free(keys);
+        free(found);
+        set_error(error, "system", MONGOLITE_ENOMEM, "Failed to allocate lookup batch");
+        return MONGOLITE_ENOMEM;
+    }
+    for (size_t i = 0; i < n_ids; i++) keys[i] = ids[i].bytes;
+
+    wtree3_txn_t *txn = _mongolite_get_read_txn(db, error);
+    if (!txn) {
+        free(keys);
+        free(found);
+        return MONGOLITE_ERROR;
+    }
+
+    mongolite_readahead_t ra;
+    _mongolite_readahead_init(db, txn, &ra);
+    int rc = _mongolite_fetch_batch(&ra, txn, entry->tree, keys, n_ids, found, error);
+
+    uint64_t returned = 0;
+    for (size_t i = 0; rc == 0 && i < n_ids; i++) {
+        if (!found[i].data) continue;
+        docs[i] = bson_new_from_data(found[i].data, found[i].len);
+        if (!docs[i]) {
+            set_error(error, MONGOLITE_LIB, MONGOLITE_ERROR, "Corrupt document in collection");
+            rc = MONGOLITE_ERROR;
+            break;
         }
-        _free_query_analysis(analysis);
+        returned++;
     }
+    _mongolite_release_read_txn(db, txn);
+    free(keys);
+    free(found);
 
-    /* Fallback: Full scan with filter */
-    result = _mongolite_find_one_scan(db, tree, collection, filter, error);
+    if (rc != 0) {
+        for (size_t i = 0; i < n_ids; i++) {
+            if (docs[i]) bson_destroy(docs[i]);
+            docs[i] = NULL;
+        }
+        return rc;
+    }
+    _mongolite_stats_docs(db, entry->stats, returned, returned, 0);
+    return MONGOLITE_OK;
+}
+
+int mongolite_find_many_by_id(mongolite_db_t *db, const char *collection,
+                              const bson_oid_t *ids, size_t n_ids, bson_t **docs,
+                              gerror_t *error) {
+    if (!db || !collection || (n_ids && (!ids || !docs))) {
+        set_error(error, MONGOLITE_LIB, MONGOLITE_EINVAL,
+                 "Database, collection, ids and docs are required");
+        return MONGOLITE_EINVAL;
+    }
+
+    uint64_t start = _mongolite_stats_start(db);
+    _mongolite_lock(db);
+
+    mongolite_tree_cache_entry_t *entry = _mongolite_get_collection_entry(db, collection, error);
+    int rc = entry ? _find_many_by_id_entry(db, entry, ids, n_ids, docs, error)
+                   : MONGOLITE_ENOTFOUND;
 
     _mongolite_unlock(db);
+    _mongolite_stats_record(db, MONGOLITE_OP_FIND, start);
+    return rc;
+}
 
-    /* TODO: Apply projection if specified */
-    (void)projection;
+int mongolite_col_find_many_by_id(mongolite_collection_t *col, const bson_oid_t *ids,
+                                  size_t n_ids, bson_t **docs, gerror_t *error) {
+    if (!col || (n_ids && (!ids || !docs))) {
+        set_error(error, MONGOLITE_LIB, MONGOLITE_EINVAL,
+                 "Collection handle, ids and docs are required");
+        return MONGOLITE_EINVAL;
+    }
 
-    return result;
+    mongolite_db_t *db = col->db;
+    uint64_t start = _mongolite_stats_start(db);
+    _mongolite_lock(db);
+
+    mongolite_tree_cache_entry_t *entry = _mongolite_collection_resolve(col, error);
+    int rc = entry ? _find_many_by_id_entry(db, entry, ids, n_ids, docs, error)
+                   : MONGOLITE_ENOTFOUND;
+
+    _mongolite_unlock(db);
+    _mongolite_stats_record(db, MONGOLITE_OP_FIND, start);
+    return rc;
+}
+
+/* ============================================================
+ * Plan Cache Statistics
+ * ============================================================ */
+
+int mongolite_plan_cache_stats(mongolite_db_t *db, const char *collection,
+                               uint64_t *hits, uint64_t *replans, gerror_t *error) {
+    if (!db || !collection) {
+        set_error(error, MONGOLITE_LIB, MONGOLITE_EINVAL,
+                 "Database and collection are required");
+        return MONGOLITE_EINVAL;
+    }
+
+    _mongolite_lock(db);
+
+    mongolite_tree_cache_entry_t *entry = _mongolite_get_collection_entry(db, collection, error);
+    if (!entry) {
+        _mongolite_unlock(db);
+        return MONGOLITE_ENOTFOUND;
+    }
+
+    if (hits) *hits = entry->plan_hits;
+    if (replans) *replans = entry->plan_replans;
+
+    _mongolite_unlock(db);
+    return MONGOLITE_OK;
 }
 
 /* ============================================================
@@ -203,49 +494,201 @@ const char* mongolite_find_one_json(mongolite_db_t *db, const char *collection,
  * Find (returns cursor)
  * ============================================================ */
 
-mongolite_cursor_t* mongolite_find(mongolite_db_t *db, const char *collection,
-                                    const bson_t *filter, const bson_t *projection,
-                                    gerror_t *error) {
-    if (!db || !collection) {
-        set_error(error, MONGOLITE_LIB, MONGOLITE_EINVAL,
-                 "Database and collection are required");
+/* Cursor fed by a parallel scan. NULL with *serial set: scan serially
+ * (workers could not start); otherwise error is set. */
+static mongolite_cursor_t* _find_entry_parallel(mongolite_db_t *db,
+                                                mongolite_tree_cache_entry_t *entry,
+                                                const bson_t *filter, const bson_t *projection,
+                                                bool *serial, gerror_t *error) {
+    gerror_t scan_error = {0};
+    mongolite_scan_t *scan = _mongolite_scan_start(db, entry->tree, filter,
+                                                   MONGOLITE_SCAN_DOCS, &scan_error);
+    if (!scan) {
+        *serial = (scan_error.code != MONGOLITE_EQUERY);
+        if (!*serial && error) *error = scan_error;
         return NULL;
     }
 
-    _mongolite_lock(db);
+    mongolite_cursor_t *cursor = calloc(1, sizeof(mongolite_cursor_t));
+    if (!cursor || !(cursor->collection_name = strdup(entry->name))) {
+        free(cursor);
+        _mongolite_scan_free(scan);
+        set_error(error, "system", MONGOLITE_ENOMEM, "Failed to allocate cursor");
+        return NULL;
+    }
+    cursor->db = db;
+    cursor->scan = scan;
+    cursor->external = true;
+    _mongolite_stats_query(db, entry->stats, MONGOLITE_PLAN_SCAN);
 
-    /* Get collection tree (wtree3) */
-    wtree3_tree_t *tree = _mongolite_get_collection_tree(db, collection, error);
-    if (!tree) {
-        _mongolite_unlock(db);
+    if (projection && !bson_empty(projection)) {
+        cursor->projection = bson_copy(projection);
+    }
+    return cursor;
+}
+
+mongolite_cursor_t* _mongolite_find_entry(mongolite_db_t *db,
+                                           mongolite_tree_cache_entry_t *entry,
+                                           const bson_t *filter, const bson_t *projection,
+                                           gerror_t *error) {
+    mongolite_cached_index_t *idx = NULL;
+    mongolite_plan_type_t plan = _mongolite_plan_query(db, entry, filter, &idx, error);
+    return _mongolite_find_entry_planned(db, entry, filter, projection, plan, error);
+}
+
+mongolite_cursor_t* _mongolite_find_entry_planned(mongolite_db_t *db,
+                                                   mongolite_tree_cache_entry_t *entry,
+                                                   const bson_t *filter,
+                                                   const bson_t *projection,
+                                                   mongolite_plan_type_t plan,
+                                                   gerror_t *error) {
+    /* Batched lookups: {_id: {$in: [...]}} */
+    bson_oid_t *ids = NULL;
+    size_t n_ids = 0;
+    bool residual = true;
+    if (_mongolite_id_in_query(filter, &ids, &n_ids, &residual)) {
+        plan = MONGOLITE_PLAN_ID;
+    } else if (plan == MONGOLITE_PLAN_ID) {
+        /* {_id: <oid>}: a batch of one */
+        if ((ids = malloc(sizeof(bson_oid_t))) && _mongolite_is_id_query(filter, ids)) {
+            n_ids = 1;
+            residual = false;
+        } else {
+            free(ids);
+            ids = NULL;
+            plan = MONGOLITE_PLAN_SCAN;
+        }
+    }
+
+    if (plan == MONGOLITE_PLAN_SCAN && _mongolite_text_unindexed(filter, error)) {
+        free(ids);
         return NULL;
     }
+    if (plan == MONGOLITE_PLAN_SCAN && _mongolite_scan_eligible(db, entry->tree, filter)) {
+        bool serial = false;
+        mongolite_cursor_t *cursor = _find_entry_parallel(db, entry, filter, projection,
+                                                          &serial, error);
+        if (!serial) return cursor;
+    }
 
-    /* Create read transaction */
-    wtree3_txn_t *txn = wtree3_txn_begin(db->wdb, false, error);
+    /* Inside a session the cursor reads its snapshot, otherwise its own txn */
+    wtree3_txn_t *session_txn = _mongolite_session_txn(db);
+    wtree3_txn_t *txn = session_txn;
     if (!txn) {
-        _mongolite_unlock(db);
-        return NULL;
+        txn = wtree3_txn_begin(db->wdb, false, error);
+        if (!txn) {
+            free(ids);
+            return NULL;
+        }
+        MONGOLITE_STAT(db, read_txn_begins, 1);
+    }
+
+    /* Index point seeks, read in the cursor's snapshot */
+    uint64_t keys = n_ids;                  /* _id lookups: one key each */
+    bson_t *rest = NULL;
+    mongolite_geo_near_t *near = NULL;
+    if (plan == MONGOLITE_PLAN_INDEX_MULTI) {
+        /* $near: rings read as the cursor needs them; the rest is matched */
+        int rc = _mongolite_index_seek_near(db, entry, filter, &near, &rest, error);
+        if (rc < 0) {
+            if (!session_txn) wtree3_txn_abort(txn);
+            return NULL;
+        }
+        if (rc > 0) {
+            residual = rest != NULL;
+            keys = 0;
+        }
+    }
+    if (!near && (plan == MONGOLITE_PLAN_INDEX_EQ || plan == MONGOLITE_PLAN_INDEX_MULTI)) {
+        int rc = _mongolite_index_seek_ids(db, entry, txn, filter, &ids, &n_ids, &residual,
+                                           &keys, error);
+        if (rc < 0) {
+            if (!session_txn) wtree3_txn_abort(txn);
+            return NULL;
+        }
+        if (rc == 0) plan = MONGOLITE_PLAN_SCAN;
+        if (rc == 0 && _mongolite_text_unindexed(filter, error)) {
+            if (!session_txn) wtree3_txn_abort(txn);
+            return NULL;
+        }
+        /* A $text predicate was answered by the seeks */
+        if (rc > 0 && residual) rest = _mongolite_text_strip(filter);
     }
+    _mongolite_stats_query(db, entry->stats, plan);
 
     /* Create cursor using internal helper */
     mongolite_cursor_t *cursor = _mongolite_cursor_create_with_txn(
-        db, tree, collection, txn, filter, error);
+        db, entry->tree, entry->name, txn, rest ? rest : (residual ? filter : NULL), error);
+    if (rest) bson_destroy(rest);
     if (!cursor) {
-        wtree3_txn_abort(txn);
-        _mongolite_unlock(db);
+        free(ids);
+        _mongolite_geo_near_free(near);
+        if (!session_txn) wtree3_txn_abort(txn);
         return NULL;
     }
+    if (near) _mongolite_cursor_set_near(cursor, entry->tree, near);
+    else if (plan != MONGOLITE_PLAN_SCAN) _mongolite_cursor_set_ids(cursor, entry->tree, ids, n_ids);
+    cursor->plan = plan;
+    cursor->keys_examined = plan != MONGOLITE_PLAN_SCAN ? keys : 0;
 
     /* Take ownership of the transaction */
-    cursor->owns_txn = true;
+    cursor->owns_txn = (session_txn == NULL);
+    cursor->external = true;
+    if (cursor->owns_txn) MONGOLITE_ATOMIC_ADD(&db->cursor_txns, 1);
 
     /* Copy projection if provided */
     if (projection && !bson_empty(projection)) {
         cursor->projection = bson_copy(projection);
     }
 
+    return cursor;
+}
+
+mongolite_cursor_t* mongolite_find(mongolite_db_t *db, const char *collection,
+                                    const bson_t *filter, const bson_t *projection,
+                                    gerror_t *error) {
+    if (!db || !collection) {
+        set_error(error, MONGOLITE_LIB, MONGOLITE_EINVAL,
+                 "Database and collection are required");
+        return NULL;
+    }
+
+    uint64_t start = _mongolite_stats_start_query(db, collection, filter);
+    _mongolite_lock(db);
+
+    /* Get collection cache entry (wtree3) */
+    mongolite_tree_cache_entry_t *entry = _mongolite_get_collection_entry(db, collection, error);
+    if (!entry) {
+        _mongolite_unlock(db);
+        return NULL;
+    }
+
+    mongolite_cursor_t *cursor = _mongolite_find_entry(db, entry, filter, projection, error);
+
     _mongolite_unlock(db);
+    if (MONGOLITE_UNLIKELY(db->slowlog && cursor)) _mongolite_slowlog_defer(cursor, start);
+    _mongolite_stats_record(db, MONGOLITE_OP_FIND, start);
+    return cursor;
+}
+
+mongolite_cursor_t* mongolite_col_find(mongolite_collection_t *col, const bson_t *filter,
+                                        const bson_t *projection, gerror_t *error) {
+    if (!col) {
+        set_error(error, MONGOLITE_LIB, MONGOLITE_EINVAL, "Collection handle is required");
+        return NULL;
+    }
+
+    mongolite_db_t *db = col->db;
+    uint64_t start = _mongolite_stats_start_query(db, col->name, filter);
+    _mongolite_lock(db);
+
+    mongolite_tree_cache_entry_t *entry = _mongolite_collection_resolve(col, error);
+    mongolite_cursor_t *cursor = entry ? _mongolite_find_entry(db, entry, filter, projection, error)
+                                       : NULL;
+
+    _mongolite_unlock(db);
+    if (MONGOLITE_UNLIKELY(db->slowlog && cursor)) _mongolite_slowlog_defer(cursor, start);
+    _mongolite_stats_record(db, MONGOLITE_OP_FIND, start);
     return cursor;
 }
 
@@ -333,6 +776,13 @@ char** mongolite_find_json(mongolite_db_t *db, const char *collection,
     }
 
     results[count] = NULL;  /* NULL terminator */
+    if (mongolite_cursor_error(cursor, error) != MONGOLITE_OK) {
+        for (size_t i = 0; i < count; i++) {
+            bson_free(results[i]);
+        }
+        free(results);
+        results = NULL;
+    }
 
     mongolite_cursor_destroy(cursor);
     return results;
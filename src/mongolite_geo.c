@@ -0,0 +1,578 @@
+/*
+ * mongolite_geo.c - Geospatial indexes
+ *
+ * Handles:
+ * - Cell keys: a point's x (longitude) and y (latitude) quantized to 31
+ *   bits each and interleaved (Z-order), so nearby points share key
+ *   prefixes and a box is covered by a few contiguous key ranges
+ * - The extractor: one {_geo: <cell>, x: <x>, y: <y>} key per point
+ * - Parsing $geoWithin ($box, $polygon) and $near (a GeoJSON $geometry
+ *   in meters on the sphere, or a legacy [x, y] pair in plane units)
+ * - $geoWithin candidates: the box's cell ranges, filtered on the
+ *   coordinates kept in the key (the matcher still checks each document)
+ * - $near as an expanding ring search: each ring's points in distance
+ *   order, read only when the cursor has returned the previous ones
+ *
+ * A field indexed "2dsphere" (or "2d") holds a legacy pair [x, y] or a
+ * GeoJSON Point {type: "Point", coordinates: [x, y]}, with x in
+ * [-180, 180] and y in [-90, 90]. A point outside those ranges is keyed
+ * to the nearest edge cell, so box coverings still find it. The key
+ * keeps the exact coordinates: a cell range scan drops its false
+ * positives and $near computes distances without reading documents.
+ */
+
+#include "mongolite_internal.h"
+#include "macros.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GEO_BITS        31
+#define GEO_CELLS       (1u << GEO_BITS)
+#define GEO_COVER_SIDE  4               /* Cells per axis covering a box */
+#define GEO_MAX_RANGES  (2 * GEO_COVER_SIDE * GEO_COVER_SIDE)
+
+#define GEO_EARTH_RADIUS_M  6371000.0   /* As bsonmatch's haversine_distance */
+#define GEO_PI              3.14159265358979323846
+
+typedef struct {
+    uint64_t lo, hi;
+} geo_range_t;
+
+/* ============================================================
+ * Cells
+ * ============================================================ */
+
+static uint32_t _geo_quantize(double v, double min, double span) {
+    double t = (v - min) / span;
+    if (!(t > 0)) return 0;             /* Also NaN */
+    if (t >= 1) return GEO_CELLS - 1;
+    return (uint32_t)(t * GEO_CELLS);
+}
+
+/* The bits of v at the even positions of a 64-bit word */
+static uint64_t _geo_spread(uint32_t v) {
+    uint64_t x = v;
+    x = (x | (x << 16)) & 0x0000FFFF0000FFFFULL;
+    x = (x | (x << 8)) & 0x00FF00FF00FF00FFULL;
+    x = (x | (x << 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    x = (x | (x << 2)) & 0x3333333333333333ULL;
+    x = (x | (x << 1)) & 0x5555555555555555ULL;
+    return x;
+}
+
+static uint64_t _geo_cell_of(uint32_t ux, uint32_t uy) {
+    return _geo_spread(ux) | (_geo_spread(uy) << 1);
+}
+
+uint64_t _mongolite_geo_cell(double x, double y) {
+    return _geo_cell_of(_geo_quantize(x, -180.0, 360.0), _geo_quantize(y, -90.0, 180.0));
+}
+
+static int _geo_range_cmp(const void *a, const void *b) {
+    const geo_range_t *x = a, *y = b;
+    return (x->lo > y->lo) - (x->lo < y->lo);
+}
+
+/* Cover [x1, x2] x [y1, y2] with the cells of the finest level at which
+ * it spans at most GEO_COVER_SIDE cells per axis; returns the ranges
+ * added to out (sorted, adjacent ones merged) */
+static size_t _geo_cover(double x1, double y1, double x2, double y2, geo_range_t *out) {
+    uint32_t ux1 = _geo_quantize(x1, -180.0, 360.0), ux2 = _geo_quantize(x2, -180.0, 360.0);
+    uint32_t uy1 = _geo_quantize(y1, -90.0, 180.0), uy2 = _geo_quantize(y2, -90.0, 180.0);
+
+    unsigned s = 0;
+    while (s < GEO_BITS && ((ux2 >> s) - (ux1 >> s) >= GEO_COVER_SIDE ||
+                            (uy2 >> s) - (uy1 >> s) >= GEO_COVER_SIDE)) {
+        s++;
+    }
+
+    size_t n = 0;
+    uint64_t span = (s == GEO_BITS) ? ~0ULL >> 2 : (1ULL << (2 * s)) - 1;
+    for (uint32_t cy = uy1 >> s; cy <= uy2 >> s; cy++) {
+        for (uint32_t cx = ux1 >> s; cx <= ux2 >> s; cx++) {
+            uint64_t lo = _geo_cell_of(s == GEO_BITS ? 0 : cx << s, s == GEO_BITS ? 0 : cy << s);
+            out[n++] = (geo_range_t){.lo = lo, .hi = lo | span};
+        }
+    }
+
+    qsort(out, n, sizeof(*out), _geo_range_cmp);
+    size_t m = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (m > 0 && out[m - 1].hi + 1 >= out[i].lo) {
+            if (out[i].hi > out[m - 1].hi) out[m - 1].hi = out[i].hi;
+        } else {
+            out[m++] = out[i];
+        }
+    }
+    return m;
+}
+
+/* ============================================================
+ * Index Spec and Extractor
+ * ============================================================ */
+
+const char* _mongolite_geo_spec(const bson_t *keys) {
+    bson_iter_t iter;
+    if (!keys || !bson_iter_init(&iter, keys) || !bson_iter_next(&iter) ||
+        !BSON_ITER_HOLDS_UTF8(&iter)) {
+        return NULL;
+    }
+    const char *kind = bson_iter_utf8(&iter, NULL);
+    if (strcmp(kind, "2dsphere") != 0 && strcmp(kind, "2d") != 0) return NULL;
+
+    const char *field = bson_iter_key(&iter);
+    return bson_iter_next(&iter) ? NULL : field;
+}
+
+bool _mongolite_geo_mentioned(const bson_t *keys) {
+    bson_iter_t iter;
+    if (!keys || !bson_iter_init(&iter, keys)) return false;
+    while (bson_iter_next(&iter)) {
+        if (!BSON_ITER_HOLDS_UTF8(&iter)) continue;
+        const char *kind = bson_iter_utf8(&iter, NULL);
+        if (strcmp(kind, "2dsphere") == 0 || strcmp(kind, "2d") == 0) return true;
+    }
+    return false;
+}
+
+static bool _geo_number(const bson_iter_t *iter, double *out) {
+    if (!BSON_ITER_HOLDS_NUMBER(iter)) return false;
+    *out = bson_iter_as_double(iter);
+    return true;
+}
+
+/* [x, y, ...] */
+static bool _geo_pair(const bson_iter_t *iter, double *x, double *y) {
+    bson_iter_t elems;
+    return BSON_ITER_HOLDS_ARRAY(iter) && bson_iter_recurse(iter, &elems) &&
+           bson_iter_next(&elems) && _geo_number(&elems, x) &&
+           bson_iter_next(&elems) && _geo_number(&elems, y);
+}
+
+/* A legacy pair, or {type: "Point", coordinates: [x, y]} */
+static bool _geo_point(const bson_iter_t *iter, double *x, double *y) {
+    if (BSON_ITER_HOLDS_ARRAY(iter)) return _geo_pair(iter, x, y);
+
+    bson_iter_t fields;
+    if (!BSON_ITER_HOLDS_DOCUMENT(iter) || !bson_iter_recurse(iter, &fields)) return false;
+    bool point = true, found = false;
+    while (bson_iter_next(&fields)) {
+        const char *key = bson_iter_key(&fields);
+        if (strcmp(key, "type") == 0) {
+            point = BSON_ITER_HOLDS_UTF8(&fields) &&
+                    strcmp(bson_iter_utf8(&fields, NULL), "Point") == 0;
+        } else if (strcmp(key, "coordinates") == 0) {
+            found = _geo_pair(&fields, x, y);
+        }
+    }
+    return point && found;
+}
+
+void _mongolite_geo_key(double x, double y, bson_t *key) {
+    bson_init(key);
+    BSON_APPEND_INT64(key, MONGOLITE_GEO_FIELD, (int64_t)_mongolite_geo_cell(x, y));
+    BSON_APPEND_DOUBLE(key, "x", x);
+    BSON_APPEND_DOUBLE(key, "y", y);
+}
+
+static bool _geo_key_decode(const MDB_val *k, uint64_t *cell, double *x, double *y) {
+    bson_t key;
+    bson_iter_t iter;
+    if (!bson_init_static(&key, k->mv_data, k->mv_size) || !bson_iter_init(&iter, &key)) {
+        return false;
+    }
+    if (!bson_iter_next(&iter) || !BSON_ITER_HOLDS_INT64(&iter)) return false;
+    *cell = (uint64_t)bson_iter_int64(&iter);
+
+    if (!bson_iter_next(&iter) || !BSON_ITER_HOLDS_DOUBLE(&iter)) return false;
+    *x = bson_iter_double(&iter);
+    if (!bson_iter_next(&iter) || !BSON_ITER_HOLDS_DOUBLE(&iter)) return false;
+    *y = bson_iter_double(&iter);
+    return true;
+}
+
+bool _mongolite_geo_extractor(const void *value, size_t value_len, const char *field,
+                              void **out_key, size_t *out_len) {
+    bson_t doc;
+    bson_iter_t iter, found;
+    if (!bson_init_static(&doc, value, value_len)) return false;
+
+    double x, y;
+    bool ok;
+    if (bson_iter_init_find(&iter, &doc, field)) {
+        ok = _geo_point(&iter, &x, &y);
+    } else {
+        ok = strchr(field, '.') && bson_iter_init(&iter, &doc) &&
+             bson_iter_find_descendant(&iter, field, &found) && _geo_point(&found, &x, &y);
+    }
+    if (!ok) return false;              /* No point: not in the index */
+
+    /* A packed list of one key (see wtree3_index_key_fn) */
+    bson_t key;
+    _mongolite_geo_key(x, y, &key);
+    uint32_t len = key.len;
+    uint8_t *buf = malloc(sizeof(len) + len);
+    if (buf) {
+        memcpy(buf, &len, sizeof(len));
+        memcpy(buf + sizeof(len), bson_get_data(&key), len);
+    }
+    bson_destroy(&key);
+    if (!buf) return false;
+
+    *out_key = buf;
+    *out_len = sizeof(len) + len;
+    return true;
+}
+
+/* ============================================================
+ * Queries
+ * ============================================================ */
+
+/* {$box: [[x1, y1], [x2, y2]]} or {$polygon: [[x, y], ...]} */
+static bool _geo_parse_within(const bson_iter_t *iter, mongolite_geo_query_t *q) {
+    bson_iter_t shape, elems;
+    if (!BSON_ITER_HOLDS_DOCUMENT(iter) || !bson_iter_recurse(iter, &shape) ||
+        !bson_iter_next(&shape) || !bson_iter_recurse(&shape, &elems)) {
+        return false;
+    }
+    const char *kind = bson_iter_key(&shape);
+    bool box = strcmp(kind, "$box") == 0;
+    if (!box && strcmp(kind, "$polygon") != 0) return false;
+
+    size_t n = 0;
+    double x, y;
+    while (bson_iter_next(&elems)) {
+        if (!_geo_pair(&elems, &x, &y)) return false;
+        if (box) {
+            /* The corners as given: the matcher compares against them */
+            if (n < 2) {
+                q->box[2 * n] = x;
+                q->box[2 * n + 1] = y;
+            }
+        } else if (n == 0) {
+            q->box[0] = q->box[2] = x;
+            q->box[1] = q->box[3] = y;
+        } else {
+            q->box[0] = fmin(q->box[0], x);
+            q->box[1] = fmin(q->box[1], y);
+            q->box[2] = fmax(q->box[2], x);
+            q->box[3] = fmax(q->box[3], y);
+        }
+        n++;
+    }
+    return box ? n == 2 : n >= 3;
+}
+
+/* {$geometry: {type: "Point", coordinates: [x, y]}, $maxDistance,
+ * $minDistance} */
+static bool _geo_parse_geometry(const bson_iter_t *iter, mongolite_geo_query_t *q) {
+    bson_iter_t opts;
+    if (!bson_iter_recurse(iter, &opts)) return false;
+
+    bool center = false;
+    while (bson_iter_next(&opts)) {
+        const char *key = bson_iter_key(&opts);
+        if (strcmp(key, "$geometry") == 0) {
+            center = BSON_ITER_HOLDS_DOCUMENT(&opts) && _geo_point(&opts, &q->x, &q->y);
+            if (!center) return false;
+        } else if (strcmp(key, "$maxDistance") == 0) {
+            if (!_geo_number(&opts, &q->max_d)) return false;
+        } else if (strcmp(key, "$minDistance") == 0) {
+            if (!_geo_number(&opts, &q->min_d)) return false;
+        } else {
+            return false;
+        }
+    }
+    return center;
+}
+
+bool _mongolite_geo_parse(const bson_iter_t *iter, const char *field,
+                          mongolite_geo_query_t *out) {
+    bson_iter_t ops;
+    if (!BSON_ITER_HOLDS_DOCUMENT(iter) || !bson_iter_recurse(iter, &ops) ||
+        !bson_iter_next(&ops)) {
+        return false;
+    }
+
+    mongolite_geo_query_t q = {.field = field, .min_d = 0, .max_d = INFINITY};
+    const char *op = bson_iter_key(&ops);
+    if (strcmp(op, "$geoWithin") == 0) {
+        if (!_geo_parse_within(&ops, &q)) return false;
+    } else if (strcmp(op, "$near") == 0 && BSON_ITER_HOLDS_DOCUMENT(&ops)) {
+        q.near = true;
+        q.sphere = true;
+        if (!_geo_parse_geometry(&ops, &q)) return false;
+    } else if (strcmp(op, "$near") == 0) {
+        q.near = true;
+        if (!_geo_pair(&ops, &q.x, &q.y)) return false;
+        while (bson_iter_next(&ops)) {
+            const char *key = bson_iter_key(&ops);
+            double *d = strcmp(key, "$maxDistance") == 0 ? &q.max_d :
+                        strcmp(key, "$minDistance") == 0 ? &q.min_d : NULL;
+            if (!d || !_geo_number(&ops, d)) return false;
+        }
+        *out = q;
+        return true;
+    } else {
+        return false;
+    }
+
+    if (bson_iter_next(&ops)) return false;     /* Other operators on the field */
+    *out = q;
+    return true;
+}
+
+/* Great-circle meters (the haversine formula bsonmatch's $near uses),
+ * or plane distance */
+static double _geo_distance(const mongolite_geo_query_t *q, double x, double y) {
+    if (!q->sphere) return hypot(x - q->x, y - q->y);
+
+    const double rad = GEO_PI / 180.0;
+    double lon_diff = (x - q->x) * rad, lat_diff = (y - q->y) * rad;
+    double h = 0.5 * (1 - cos(lat_diff)) +
+               cos(q->y * rad) * cos(y * rad) * 0.5 * (1 - cos(lon_diff));
+    double root = sqrt(h);
+    if (root > 1.0) root = 1.0;
+    return 2 * asin(root) * GEO_EARTH_RADIUS_M;
+}
+
+/* ============================================================
+ * Cell Range Scans
+ * ============================================================ */
+
+typedef struct {
+    double d;
+    bson_oid_t id;
+} geo_hit_t;
+
+typedef struct {
+    geo_hit_t *hits;
+    size_t n, cap;
+} geo_hits_t;
+
+/* Which points of a range a scan keeps */
+typedef struct {
+    const mongolite_geo_query_t *q;
+    double lo, hi;                      /* $near: distances in (lo, hi] */
+} geo_filter_t;
+
+static bool _geo_keep(const geo_filter_t *f, double x, double y, double *d) {
+    const mongolite_geo_query_t *q = f->q;
+    if (!q->near) {
+        *d = 0;
+        return x >= q->box[0] && y >= q->box[1] && x <= q->box[2] && y <= q->box[3];
+    }
+    *d = _geo_distance(q, x, y);
+    return *d > f->lo && *d <= f->hi && *d >= q->min_d;
+}
+
+/* Every entry of the cells in [r->lo, r->hi] whose point f keeps.
+ * Returns 1, 0 when the index holds something else, or an error code. */
+static int _geo_scan_range(MDB_cursor *cursor, const geo_range_t *r, const geo_filter_t *f,
+                           geo_hits_t *out, uint64_t *keys_examined) {
+    bson_t probe;
+    bson_init(&probe);
+    BSON_APPEND_INT64(&probe, MONGOLITE_GEO_FIELD, (int64_t)r->lo);
+    MDB_val k = {.mv_size = probe.len, .mv_data = (void *)bson_get_data(&probe)};
+    MDB_val v;
+    int rc = mdb_cursor_get(cursor, &k, &v, MDB_SET_RANGE);
+    bson_destroy(&probe);               /* k now points at the key in the map */
+
+    while (rc == MDB_SUCCESS) {
+        uint64_t cell;
+        double x, y, d;
+        if (!_geo_key_decode(&k, &cell, &x, &y)) return 0;
+        if (cell > r->hi) break;
+        (*keys_examined)++;
+
+        if (_geo_keep(f, x, y, &d)) {
+            do {
+                if (v.mv_size != sizeof(bson_oid_t)) return 0;
+                if (out->n == out->cap) {
+                    size_t grown = out->cap ? out->cap * 2 : 64;
+                    geo_hit_t *tmp = realloc(out->hits, grown * sizeof(*tmp));
+                    if (!tmp) return MONGOLITE_ENOMEM;
+                    out->hits = tmp;
+                    out->cap = grown;
+                }
+                out->hits[out->n].d = d;
+                memcpy(out->hits[out->n].id.bytes, v.mv_data, sizeof(bson_oid_t));
+                out->n++;
+                rc = mdb_cursor_get(cursor, &k, &v, MDB_NEXT_DUP);
+            } while (rc == MDB_SUCCESS);
+            if (rc != MDB_NOTFOUND) return rc;
+        }
+        rc = mdb_cursor_get(cursor, &k, &v, MDB_NEXT_NODUP);
+    }
+    return (rc == MDB_SUCCESS || rc == MDB_NOTFOUND) ? 1 : rc;
+}
+
+static int _geo_scan(MDB_txn *txn, MDB_dbi dbi, const double (*boxes)[4], size_t n_boxes,
+                     const geo_filter_t *f, geo_hits_t *out, uint64_t *keys_examined) {
+    geo_range_t ranges[GEO_MAX_RANGES];
+    size_t n = 0;
+    for (size_t b = 0; b < n_boxes; b++) {
+        n += _geo_cover(boxes[b][0], boxes[b][1], boxes[b][2], boxes[b][3], ranges + n);
+    }
+
+    MDB_cursor *cursor;
+    int rc = mdb_cursor_open(txn, dbi, &cursor);
+    if (rc != MDB_SUCCESS) return rc;
+    int result = 1;
+    for (size_t i = 0; i < n && result == 1; i++) {
+        result = _geo_scan_range(cursor, &ranges[i], f, out, keys_examined);
+    }
+    mdb_cursor_close(cursor);
+    return result;
+}
+
+int _mongolite_geo_within(MDB_txn *txn, MDB_dbi dbi, const mongolite_geo_query_t *q,
+                          bson_oid_t **out, size_t *out_n, uint64_t *keys_examined) {
+    double box[1][4] = {{fmin(q->box[0], q->box[2]), fmin(q->box[1], q->box[3]),
+                         fmax(q->box[0], q->box[2]), fmax(q->box[1], q->box[3])}};
+    geo_filter_t f = {.q = q};
+    geo_hits_t hits = {0};
+    int rc = _geo_scan(txn, dbi, (const double (*)[4])box, 1, &f, &hits, keys_examined);
+
+    /* Reuse the hits in place as the ids */
+    bson_oid_t *ids = (bson_oid_t *)hits.hits;
+    for (size_t i = 0; i < hits.n; i++) memmove(&ids[i], &hits.hits[i].id, sizeof(bson_oid_t));
+    if (rc != 1) {
+        free(hits.hits);
+        return rc;
+    }
+    *out = ids;
+    *out_n = hits.n;
+    return 1;
+}
+
+/* ============================================================
+ * $near: Expanding Rings
+ *
+ * Ring k returns the points at distance (r[k-1], r[k]], sorted; the
+ * radius doubles each ring. A ring scans the cells of the bounding box
+ * of its whole disk (inner points are skipped on their coordinates), so
+ * the cells read over all rings add up to about 4/3 of the last ring's.
+ * A cursor with a limit stops asking for rings once it has enough.
+ * ============================================================ */
+
+#define GEO_FIRST_RING_M      1000.0    /* $geometry: meters */
+#define GEO_FIRST_RING_PLANE  0.01      /* Legacy pairs: coordinate units */
+
+struct mongolite_geo_near {
+    MDB_dbi dbi;
+    mongolite_geo_query_t q;
+    double inner;                       /* Points up to here were returned */
+    double radius;                      /* The next ring's */
+    bool done;
+};
+
+mongolite_geo_near_t* _mongolite_geo_near_new(MDB_dbi dbi, const mongolite_geo_query_t *q) {
+    mongolite_geo_near_t *near = calloc(1, sizeof(*near));
+    if (!near) return NULL;
+    near->dbi = dbi;
+    near->q = *q;
+    near->q.field = NULL;               /* Points into the caller's filter */
+    near->inner = -1;
+    near->radius = q->sphere ? GEO_FIRST_RING_M : GEO_FIRST_RING_PLANE;
+    return near;
+}
+
+void _mongolite_geo_near_free(mongolite_geo_near_t *near) {
+    free(near);
+}
+
+/* The boxes holding every point within r of the center (two when the
+ * disk crosses the antimeridian); *all when they cover every cell */
+static size_t _geo_ring_boxes(const mongolite_geo_query_t *q, double r, double boxes[2][4],
+                              bool *all) {
+    *all = false;
+    if (!q->sphere) {
+        boxes[0][0] = q->x - r;
+        boxes[0][1] = q->y - r;
+        boxes[0][2] = q->x + r;
+        boxes[0][3] = q->y + r;
+        *all = boxes[0][0] <= -180 && boxes[0][1] <= -90 && boxes[0][2] >= 180 &&
+               boxes[0][3] >= 90;
+        return 1;
+    }
+
+    double angle = r / GEO_EARTH_RADIUS_M;
+    double dlat = angle * 180.0 / GEO_PI;
+    double lat1 = q->y - dlat, lat2 = q->y + dlat;
+    double s = sin(angle) / cos(q->y * GEO_PI / 180.0);
+    if (angle >= GEO_PI || lat1 <= -90 || lat2 >= 90 || !(s < 1)) {
+        /* Around a pole, or wider than a hemisphere: every longitude */
+        boxes[0][0] = -180;
+        boxes[0][1] = fmax(lat1, -90);
+        boxes[0][2] = 180;
+        boxes[0][3] = fmin(lat2, 90);
+        *all = lat1 <= -90 && lat2 >= 90;
+        return 1;
+    }
+
+    double dlon = asin(s) * 180.0 / GEO_PI;
+    double lon1 = q->x - dlon, lon2 = q->x + dlon;
+    boxes[0][1] = boxes[1][1] = lat1;
+    boxes[0][3] = boxes[1][3] = lat2;
+    if (lon1 < -180 || lon2 > 180) {
+        boxes[0][0] = lon1 < -180 ? lon1 + 360 : lon1;
+        boxes[0][2] = 180;
+        boxes[1][0] = -180;
+        boxes[1][2] = lon2 > 180 ? lon2 - 360 : lon2;
+        return 2;
+    }
+    boxes[0][0] = lon1;
+    boxes[0][2] = lon2;
+    return 1;
+}
+
+static int _geo_hit_cmp(const void *a, const void *b) {
+    const geo_hit_t *x = a, *y = b;
+    if (x->d != y->d) return x->d < y->d ? -1 : 1;
+    return memcmp(x->id.bytes, y->id.bytes, sizeof(x->id.bytes));
+}
+
+int _mongolite_geo_near_next(mongolite_geo_near_t *near, MDB_txn *txn,
+                             bson_oid_t **out, size_t *out_n, uint64_t *keys_examined) {
+    while (!near->done) {
+        double r = near->radius;
+        bool last = !(r < near->q.max_d);
+        if (last) r = near->q.max_d;
+
+        double boxes[2][4];
+        bool all;
+        size_t n_boxes = _geo_ring_boxes(&near->q, r, boxes, &all);
+        last = last || all;
+
+        geo_filter_t f = {.q = &near->q, .lo = near->inner, .hi = last ? near->q.max_d : r};
+        geo_hits_t hits = {0};
+        int rc = _geo_scan(txn, near->dbi, (const double (*)[4])boxes, n_boxes, &f, &hits,
+                           keys_examined);
+        if (rc != 1) {
+            free(hits.hits);
+            return rc;
+        }
+        near->inner = f.hi;
+        near->radius = r * 2;
+        near->done = last;
+        if (hits.n == 0) {
+            free(hits.hits);
+            continue;
+        }
+
+        /* Nearest first; a point in both antimeridian boxes is kept once */
+        qsort(hits.hits, hits.n, sizeof(*hits.hits), _geo_hit_cmp);
+        bson_oid_t *ids = (bson_oid_t *)hits.hits;
+        size_t m = 0;
+        for (size_t i = 0; i < hits.n; i++) {
+            if (i > 0 && _geo_hit_cmp(&hits.hits[i], &hits.hits[i - 1]) == 0) continue;
+            memmove(&ids[m++], &hits.hits[i].id, sizeof(bson_oid_t));
+        }
+        *out = ids;
+        *out_n = m;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,330 @@
+/*
+ * mongolite_group.c - Group commit
+ *
+ * Handles:
+ * - Commit queue setup / teardown (db_config_t.group_commit)
+ * - Leader election among concurrent auto-commit writers
+ * - Applying a batch in one group session with one commit (one sync)
+ * - Per-write results, and batch commit failures reported to every write
+ */
+
+#include "mongolite_internal.h"
+#include "macros.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
+#endif
+
+#define MONGOLITE_LIB "mongolite"
+
+/* Same bound as the insert path's resize retry */
+#define MONGOLITE_GROUP_RESIZE_ATTEMPTS 3
+
+/* ============================================================
+ * Queue
+ * ============================================================ */
+
+/* One queued write, on the stack of the thread that submitted it */
+typedef struct mongolite_group_op {
+    const char *collection;
+    mongolite_group_fn fn;
+    void *arg;
+    gerror_t *error;                    /* Caller's error (may be NULL) */
+    int rc;
+    bool done;                          /* Result final: the caller may return */
+    struct mongolite_group_op *next;
+} mongolite_group_op_t;
+
+struct mongolite_group {
+#ifdef _WIN32
+    CRITICAL_SECTION mutex;
+    CONDITION_VARIABLE done_cond;
+    CONDITION_VARIABLE join_cond;
+#else
+    pthread_mutex_t mutex;
+    pthread_cond_t done_cond;           /* A batch finished (or the leader left) */
+    pthread_cond_t join_cond;           /* The queue filled up a batch */
+#endif
+    mongolite_group_op_t *head;
+    mongolite_group_op_t *tail;
+    size_t queued;
+    bool leader_active;
+
+    unsigned int max_ops;
+    unsigned int wait_us;
+};
+
+static void _group_lock(mongolite_group_t *g) {
+#ifdef _WIN32
+    EnterCriticalSection(&g->mutex);
+#else
+    pthread_mutex_lock(&g->mutex);
+#endif
+}
+
+static void _group_unlock(mongolite_group_t *g) {
+#ifdef _WIN32
+    LeaveCriticalSection(&g->mutex);
+#else
+    pthread_mutex_unlock(&g->mutex);
+#endif
+}
+
+static void _group_wait_done(mongolite_group_t *g) {
+#ifdef _WIN32
+    SleepConditionVariableCS(&g->done_cond, &g->mutex, INFINITE);
+#else
+    pthread_cond_wait(&g->done_cond, &g->mutex);
+#endif
+}
+
+static void _group_broadcast_done(mongolite_group_t *g) {
+#ifdef _WIN32
+    WakeAllConditionVariable(&g->done_cond);
+#else
+    pthread_cond_broadcast(&g->done_cond);
+#endif
+}
+
+static void _group_signal_join(mongolite_group_t *g) {
+#ifdef _WIN32
+    WakeConditionVariable(&g->join_cond);
+#else
+    pthread_cond_signal(&g->join_cond);
+#endif
+}
+
+/* Leader: give other writers up to wait_us to join before starting */
+static void _group_wait_joiners(mongolite_group_t *g) {
+    if (g->wait_us == 0 || g->queued >= g->max_ops) return;
+#ifdef _WIN32
+    DWORD ms = (g->wait_us + 999) / 1000;
+    SleepConditionVariableCS(&g->join_cond, &g->mutex, ms);
+#else
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_nsec += (long)(g->wait_us % 1000000) * 1000;
+    deadline.tv_sec += g->wait_us / 1000000 + deadline.tv_nsec / 1000000000;
+    deadline.tv_nsec %= 1000000000;
+    while (g->queued < g->max_ops) {
+        if (pthread_cond_timedwait(&g->join_cond, &g->mutex, &deadline) == ETIMEDOUT) break;
+    }
+#endif
+}
+
+/* Detach up to max_ops writes from the front of the queue */
+static mongolite_group_op_t* _group_take_batch(mongolite_group_t *g, size_t *out_count) {
+    mongolite_group_op_t *batch = g->head;
+    mongolite_group_op_t *last = batch;
+    size_t n = 1;
+    while (n < g->max_ops && last->next) {
+        last = last->next;
+        n++;
+    }
+
+    g->head = last->next;
+    if (!g->head) g->tail = NULL;
+    g->queued -= n;
+    last->next = NULL;
+
+    *out_count = n;
+    return batch;
+}
+
+/* ============================================================
+ * Init / Free
+ * ============================================================ */
+
+int _mongolite_group_init(mongolite_db_t *db, const db_config_t *config) {
+    db->group = NULL;
+    if (!config || !config->group_commit) return MONGOLITE_OK;
+
+    mongolite_group_t *g = calloc(1, sizeof(mongolite_group_t));
+    if (!g) return MONGOLITE_ENOMEM;
+
+#ifdef _WIN32
+    InitializeCriticalSection(&g->mutex);
+    InitializeConditionVariable(&g->done_cond);
+    InitializeConditionVariable(&g->join_cond);
+#else
+    if (pthread_mutex_init(&g->mutex, NULL) != 0) {
+        free(g);
+        return MONGOLITE_ERROR;
+    }
+    if (pthread_cond_init(&g->done_cond, NULL) != 0) {
+        pthread_mutex_destroy(&g->mutex);
+        free(g);
+        return MONGOLITE_ERROR;
+    }
+    if (pthread_cond_init(&g->join_cond, NULL) != 0) {
+        pthread_cond_destroy(&g->done_cond);
+        pthread_mutex_destroy(&g->mutex);
+        free(g);
+        return MONGOLITE_ERROR;
+    }
+#endif
+
+    g->max_ops = config->group_commit_max_ops ? config->group_commit_max_ops
+                                              : MONGOLITE_DEFAULT_GROUP_OPS;
+    g->wait_us = config->group_commit_wait_us;
+    db->group = g;
+    return MONGOLITE_OK;
+}
+
+void _mongolite_group_free(mongolite_db_t *db) {
+    if (!db || !db->group) return;
+    mongolite_group_t *g = db->group;
+
+#ifdef _WIN32
+    DeleteCriticalSection(&g->mutex);
+#else
+    pthread_cond_destroy(&g->join_cond);
+    pthread_cond_destroy(&g->done_cond);
+    pthread_mutex_destroy(&g->mutex);
+#endif
+    free(g);
+    db->group = NULL;
+}
+
+/* ============================================================
+ * Batch Execution (leader, group mutex not held)
+ * ============================================================ */
+
+static inline bool _is_map_full_error(int rc) {
+    return (rc == WTREE3_MAP_FULL || rc == MDB_MAP_FULL);
+}
+
+static void _copy_error(gerror_t *dst, const gerror_t *src) {
+    if (dst && src) *dst = *src;
+}
+
+/* The commit covering [from, to) failed: none of its writes happened */
+static void _fail_committed(mongolite_group_op_t *from, mongolite_group_op_t *to,
+                            int rc, const gerror_t *error) {
+    for (mongolite_group_op_t *op = from; op != to; op = op->next) {
+        if (op->rc != MONGOLITE_OK) continue;
+        op->rc = rc;
+        _copy_error(op->error, error);
+    }
+}
+
+static void _group_run(mongolite_db_t *db, mongolite_group_op_t *batch, size_t count) {
+    _mongolite_lock_hold(db);
+
+    /* Opening a collection takes LMDB's writer lock, which the batch
+     * will hold: open them all first (failures are per write) */
+    for (mongolite_group_op_t *op = batch; op; op = op->next) {
+        if (!_mongolite_get_collection_entry(db, op->collection, op->error)) {
+            op->rc = MONGOLITE_ERROR;
+        }
+    }
+
+    gerror_t batch_error = {0};
+    mongolite_session_t *session = _mongolite_session_begin_group(db, &batch_error);
+    mongolite_group_op_t *segment = batch;  /* First write of the open session */
+
+    for (mongolite_group_op_t *op = batch; op; op = op->next) {
+        if (op->rc != MONGOLITE_OK) continue;
+
+        for (int attempt = 0; ; attempt++) {
+            if (!session) {
+                op->rc = batch_error.code ? batch_error.code : MONGOLITE_ETXN;
+                _copy_error(op->error, &batch_error);
+                break;
+            }
+
+            op->rc = op->fn(db, op->arg, op->error);
+            if (!_is_map_full_error(op->rc) || attempt >= MONGOLITE_GROUP_RESIZE_ATTEMPTS) {
+                break;
+            }
+
+            /* The map can only grow with no txn open: commit what the
+             * batch has so far, grow, and retry this write in a new one */
+            op->rc = MONGOLITE_OK;
+            int rc = _mongolite_session_end_group(session, true, &batch_error);
+            session = NULL;
+            if (rc != 0) _fail_committed(segment, op, rc, &batch_error);
+            segment = op;
+
+            gerror_t resize_error = {0};
+            if (_mongolite_try_resize(db, &resize_error) != 0) {
+                op->rc = WTREE3_MAP_FULL;
+                _copy_error(op->error, &resize_error);
+                break;
+            }
+            if (op->error) {
+                op->error->code = 0;
+                op->error->message[0] = '\0';
+            }
+            memset(&batch_error, 0, sizeof(batch_error));
+            session = _mongolite_session_begin_group(db, &batch_error);
+        }
+    }
+
+    if (session) {
+        int rc = _mongolite_session_end_group(session, true, &batch_error);
+        if (rc != 0) _fail_committed(segment, NULL, rc, &batch_error);
+    }
+
+    MONGOLITE_STAT(db, group_commits, 1);
+    MONGOLITE_STAT(db, group_ops, count);
+
+    _mongolite_lock_drop(db);
+}
+
+/* ============================================================
+ * Submit
+ * ============================================================ */
+
+int _mongolite_group_submit(mongolite_db_t *db, const char *collection,
+                            mongolite_group_fn fn, void *arg, gerror_t *error) {
+    mongolite_group_t *g = db->group;
+    mongolite_group_op_t op = {
+        .collection = collection,
+        .fn = fn,
+        .arg = arg,
+        .error = error,
+        .rc = MONGOLITE_OK,
+        .done = false,
+        .next = NULL
+    };
+
+    _group_lock(g);
+
+    if (g->tail) g->tail->next = &op;
+    else g->head = &op;
+    g->tail = &op;
+    if (++g->queued >= g->max_ops) _group_signal_join(g);
+
+    for (;;) {
+        while (!op.done && g->leader_active) _group_wait_done(g);
+        if (op.done) break;
+
+        /* No leader: this thread applies the front of the queue, which
+         * may end before its own write (then it leads again) */
+        g->leader_active = true;
+        _group_wait_joiners(g);
+
+        size_t count = 0;
+        mongolite_group_op_t *batch = _group_take_batch(g, &count);
+        _group_unlock(g);
+
+        _group_run(db, batch, count);
+
+        _group_lock(g);
+        for (mongolite_group_op_t *done = batch; done; done = done->next) {
+            done->done = true;
+        }
+        g->leader_active = false;
+        _group_broadcast_done(g);
+    }
+
+    _group_unlock(g);
+    return op.rc;
+}
@@ -174,6 +174,13 @@ static inline bool extract_doc_oid_with_error(const bson_t *doc, bson_oid_t *out
  * Parse JSON strings to BSON with consistent error handling.
  * ============================================================ */
 
+/**
+ * Parse one JSON document into out (empty, e.g. fresh or bson_reinit),
+ * in one pass without intermediate allocations (mongolite_json.c). On
+ * failure out is left empty.
+ */
+int _mongolite_json_parse(const char *json, size_t len, bson_t *out, gerror_t *error);
+
 /**
  * Parse JSON string to BSON document
  *
@@ -193,15 +200,9 @@ static inline bson_t* parse_json_to_bson(const char *json_str, gerror_t *error)
         return NULL;
     }
 
-    bson_error_t bson_err;
-    bson_t *doc = bson_new_from_json((const uint8_t*)json_str, -1, &bson_err);
-    if (MONGOLITE_UNLIKELY(!doc)) {
-        if (error) {
-            error->code = -1003;  /* MONGOLITE_EINVAL */
-            snprintf(error->message, sizeof(error->message), "Invalid JSON: %s", bson_err.message);
-            strncpy(error->lib, "libbson", sizeof(error->lib) - 1);
-            error->lib[sizeof(error->lib) - 1] = '\0';
-        }
+    bson_t *doc = bson_new();
+    if (MONGOLITE_UNLIKELY(_mongolite_json_parse(json_str, strlen(json_str), doc, error) != 0)) {
+        bson_destroy(doc);
         return NULL;
     }
 
@@ -26,6 +26,8 @@
  *   {"email": 1}           -> "email_1"
  *   {"name": 1, "age": -1} -> "name_1_age_-1"
  *   {"a.b.c": 1}           -> "a.b.c_1"
+ *   {"body": "text"}       -> "body_text"
+ *   {"loc": "2dsphere"}    -> "loc_2dsphere"
  * ============================================================ */
 
 char* _index_name_from_spec(const bson_t *keys) {
@@ -44,6 +46,7 @@ char* _index_name_from_spec(const bson_t *keys) {
         const char *field = bson_iter_key(&iter);
         total_len += strlen(field);
         total_len += 3;  /* "_1" or "_-1" + separator "_" */
+        if (BSON_ITER_HOLDS_UTF8(&iter)) total_len += strlen(bson_iter_utf8(&iter, NULL));
         field_count++;
     }
 
@@ -82,8 +85,13 @@ char* _index_name_from_spec(const bson_t *keys) {
         memcpy(p, field, field_len);
         p += field_len;
 
-        /* Add direction */
-        if (direction >= 0) {
+        /* Add direction, or the index type ("text", "2dsphere") */
+        if (BSON_ITER_HOLDS_UTF8(&iter)) {
+            const char *type = bson_iter_utf8(&iter, NULL);
+            *p++ = '_';
+            memcpy(p, type, strlen(type));
+            p += strlen(type);
+        } else if (direction >= 0) {
             *p++ = '_';
             *p++ = '1';
         } else {
@@ -395,6 +403,221 @@ int _mongolite_index_compare(const MDB_val *a, const MDB_val *b) {
     return _index_key_compare(a->mv_data, a->mv_size, b->mv_data, b->mv_size, NULL);
 }
 
+/* ============================================================
+ * Multi-key Ordered Indexes
+ *
+ * Ordered indexes are created multi-key: a field holding an array is
+ * indexed once per element (nested arrays flattened, as the matcher
+ * compares them), and a dotted path continues into the documents of an
+ * array ({"a.b": 1} over {a: [{b: 1}, {b: 2}]} gives b: 1 and b: 2).
+ * A compound index gets the cartesian product of its fields' values.
+ * A document with only scalar fields has the single key it always had;
+ * an empty array is indexed as itself, a missing field as null.
+ *
+ * The keys are distinct under the index comparator, so a document has
+ * at most one duplicate per key and a unique index rejects two documents
+ * sharing any element. More than MONGOLITE_INDEX_MAX_KEYS keys fail the
+ * write.
+ * ============================================================ */
+
+typedef struct {
+    bson_iter_t *v;
+    size_t n;
+    size_t cap;
+    bool found;                         /* A non-null value was reached */
+} multikey_values_t;
+
+static bool _multikey_push(multikey_values_t *vals, const bson_iter_t *iter) {
+    if (vals->n == MONGOLITE_INDEX_MAX_KEYS) return false;
+    if (vals->n == vals->cap) {
+        size_t grown = vals->cap ? vals->cap * 2 : 8;
+        bson_iter_t *tmp = realloc(vals->v, grown * sizeof(*tmp));
+        if (!tmp) return false;
+        vals->v = tmp;
+        vals->cap = grown;
+    }
+    vals->v[vals->n++] = *iter;
+    if (!BSON_ITER_HOLDS_NULL(iter)) vals->found = true;
+    return true;
+}
+
+/* The values path reaches below iter ("" is iter itself) */
+static bool _multikey_collect(const bson_iter_t *iter, const char *path,
+                              multikey_values_t *vals) {
+    bson_iter_t child;
+    if (*path == '\0') {
+        if (!BSON_ITER_HOLDS_ARRAY(iter)) return _multikey_push(vals, iter);
+        if (!bson_iter_recurse(iter, &child)) return true;
+        bool any = false;
+        while (bson_iter_next(&child)) {
+            any = true;
+            if (!_multikey_collect(&child, "", vals)) return false;
+        }
+        return any ? true : _multikey_push(vals, iter);
+    }
+
+    const char *dot = strchr(path, '.');
+    size_t len = dot ? (size_t)(dot - path) : strlen(path);
+    const char *rest = dot ? dot + 1 : "";
+
+    if (BSON_ITER_HOLDS_DOCUMENT(iter)) {
+        if (bson_iter_recurse(iter, &child) && bson_iter_find_w_len(&child, path, (int)len)) {
+            return _multikey_collect(&child, rest, vals);
+        }
+        return true;
+    }
+
+    if (BSON_ITER_HOLDS_ARRAY(iter) && bson_iter_recurse(iter, &child)) {
+        while (bson_iter_next(&child)) {
+            /* A numeric component also names the element itself */
+            const char *k = bson_iter_key(&child);
+            if (strlen(k) == len && memcmp(k, path, len) == 0 &&
+                !_multikey_collect(&child, rest, vals)) {
+                return false;
+            }
+            if (BSON_ITER_HOLDS_DOCUMENT(&child) && !_multikey_collect(&child, path, vals)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/* The values of one key field: the literal top-level field first, as
+ * bson_extract_index_key looks it up, else the dotted path */
+static bool _multikey_field(const bson_t *doc, const char *field, multikey_values_t *vals) {
+    bson_iter_t iter;
+    if (bson_iter_init_find(&iter, doc, field)) {
+        return _multikey_collect(&iter, "", vals);
+    }
+
+    const char *dot = strchr(field, '.');
+    if (dot && bson_iter_init(&iter, doc) &&
+        bson_iter_find_w_len(&iter, field, (int)(dot - field))) {
+        return _multikey_collect(&iter, dot + 1, vals);
+    }
+    return true;
+}
+
+static int _multikey_key_cmp(const void *a, const void *b) {
+    return bson_compare_docs((const bson_t *)a, (const bson_t *)b);
+}
+
+static bool _multikey_ordered_extractor(const void *value, size_t value_len,
+                                        const bson_t *keys, bool sparse,
+                                        void **out_key, size_t *out_len) {
+    bson_t doc;
+    bson_iter_t kit;
+    if (!bson_init_static(&doc, value, value_len) || !bson_iter_init(&kit, keys)) {
+        return false;
+    }
+
+    /* Missing fields index as null */
+    bson_t null_doc;
+    bson_iter_t null_iter;
+    bson_init(&null_doc);
+    bson_append_null(&null_doc, "", 0);
+    bson_iter_init(&null_iter, &null_doc);
+    bson_iter_next(&null_iter);
+
+    size_t n_fields = 0;
+    while (bson_iter_next(&kit)) n_fields++;
+
+    multikey_values_t *fields = calloc(n_fields ? n_fields : 1, sizeof(*fields));
+    const char **names = calloc(n_fields ? n_fields : 1, sizeof(*names));
+    bson_t *built = NULL;
+    bool ok = fields && names, found = false;
+    size_t total = 1, n_built = 0;
+
+    bson_iter_init(&kit, keys);
+    for (size_t f = 0; ok && bson_iter_next(&kit); f++) {
+        names[f] = bson_iter_key(&kit);
+        ok = _multikey_field(&doc, names[f], &fields[f]) &&
+             (fields[f].n > 0 || _multikey_push(&fields[f], &null_iter));
+        found = found || fields[f].found;
+        ok = ok && total * fields[f].n <= MONGOLITE_INDEX_MAX_KEYS;
+        if (ok) total *= fields[f].n;
+    }
+
+    /* Sparse: every key field is missing or null */
+    bool indexed = !ok || !sparse || found;
+    if (ok && indexed) {
+        built = malloc(total * sizeof(*built));
+        ok = built != NULL;
+    }
+
+    /* Cartesian product, the last field varying fastest */
+    for (size_t k = 0; ok && indexed && k < total; k++) {
+        bson_t *key = &built[n_built++];
+        bson_init(key);
+        size_t stride = total;
+        for (size_t f = 0; ok && f < n_fields; f++) {
+            stride /= fields[f].n;
+            ok = bson_append_iter(key, names[f], -1, &fields[f].v[(k / stride) % fields[f].n]);
+        }
+    }
+
+    uint8_t *buf = NULL;
+    size_t used = 0;
+    if (ok && indexed) {
+        qsort(built, n_built, sizeof(*built), _multikey_key_cmp);
+        size_t bytes = 0;
+        for (size_t k = 0; k < n_built; k++) bytes += sizeof(uint32_t) + built[k].len;
+        buf = malloc(bytes);
+        for (size_t k = 0; buf && k < n_built; k++) {
+            if (k > 0 && bson_compare_docs(&built[k - 1], &built[k]) == 0) continue;
+            /* Packed [uint32_t len][key] per key (see wtree3_index_key_fn) */
+            uint32_t len = built[k].len;
+            memcpy(buf + used, &len, sizeof(len));
+            memcpy(buf + used + sizeof(len), bson_get_data(&built[k]), len);
+            used += sizeof(len) + len;
+        }
+        ok = buf != NULL;
+    }
+
+    for (size_t k = 0; k < n_built; k++) bson_destroy(&built[k]);
+    free(built);
+    for (size_t f = 0; fields && f < n_fields; f++) free(fields[f].v);
+    free(fields);
+    free(names);
+    bson_destroy(&null_doc);
+
+    if (!indexed) return false;
+    /* Failed (too many keys, out of memory): fail the write */
+    *out_key = ok ? buf : NULL;
+    *out_len = ok ? used : 0;
+    return true;
+}
+
+static bool _multikey_extract(const void *value, size_t value_len, void *user_data,
+                              bool sparse, void **out_key, size_t *out_len) {
+    if (!value || !user_data || !out_key || !out_len) return false;
+
+    /* user_data is raw BSON bytes of the keys spec */
+    bson_t keys;
+    if (!bson_init_static(&keys, user_data, BSON_UINT32_FROM_LE(*(uint32_t*)user_data))) {
+        return false;
+    }
+    if (_mongolite_text_spec(&keys)) {
+        return _mongolite_text_extractor(value, value_len, &keys, out_key, out_len);
+    }
+    const char *geo = _mongolite_geo_spec(&keys);
+    if (geo) {
+        return _mongolite_geo_extractor(value, value_len, geo, out_key, out_len);
+    }
+    return _multikey_ordered_extractor(value, value_len, &keys, sparse, out_key, out_len);
+}
+
+bool _mongolite_multikey_extractor(const void *value, size_t value_len, void *user_data,
+                                   void **out_key, size_t *out_len) {
+    return _multikey_extract(value, value_len, user_data, false, out_key, out_len);
+}
+
+bool _mongolite_multikey_extractor_sparse(const void *value, size_t value_len, void *user_data,
+                                          void **out_key, size_t *out_len) {
+    return _multikey_extract(value, value_len, user_data, true, out_key, out_len);
+}
+
 /* Note: Index array helper functions (_index_exists, _add_index_to_array,
  * _remove_index_from_array) removed - wtree3 handles all index metadata directly */
 
@@ -428,6 +651,12 @@ int mongolite_create_index(mongolite_db_t *db, const char *collection,
 
     _mongolite_lock(db);
 
+    rc = _mongolite_require_no_write_session(db, error);
+    if (rc != MONGOLITE_OK) {
+        _mongolite_unlock(db);
+        return rc;
+    }
+
     /* Generate index name if not provided */
     if (name && strlen(name) > 0) {
         index_name = strdup(name);
@@ -456,6 +685,34 @@ int mongolite_create_index(mongolite_db_t *db, const char *collection,
         goto cleanup;
     }
 
+    /* Text indexes: text fields only, not unique, one per collection */
+    bool is_text = _mongolite_text_mentioned(keys);
+    if (is_text) {
+        size_t count = 0;
+        mongolite_cached_index_t *indexes = _mongolite_get_cached_indexes(db, collection,
+                                                                          &count, NULL);
+        bool exists = false;
+        for (size_t i = 0; indexes && i < count; i++) exists = exists || indexes[i].text;
+
+        const char *why = !_mongolite_text_spec(keys) ? "cannot mix text and ordered fields" :
+                          (config && config->unique) ? "cannot be unique" :
+                          exists ? "already exists on this collection" : NULL;
+        if (why) {
+            set_error(error, MONGOLITE_LIB, MONGOLITE_EINVAL, "Text index %s", why);
+            rc = MONGOLITE_EINVAL;
+            goto cleanup;
+        }
+    }
+
+    /* Geo indexes: one "2dsphere" (or "2d") field, not unique */
+    bool is_geo = _mongolite_geo_mentioned(keys);
+    if (is_geo && (!_mongolite_geo_spec(keys) || (config && config->unique))) {
+        set_error(error, MONGOLITE_LIB, MONGOLITE_EINVAL, "Geo index %s",
+                  (config && config->unique) ? "cannot be unique" : "must have exactly one field");
+        rc = MONGOLITE_EINVAL;
+        goto cleanup;
+    }
+
     /* Serialize keys for wtree3 user_data (will be persisted automatically) */
     const uint8_t *keys_data = bson_get_data(keys);
     size_t keys_len = keys->len;
@@ -479,6 +736,7 @@ int mongolite_create_index(mongolite_db_t *db, const char *collection,
         .user_data_len = keys_len,          /* Length for persistence */
         .unique = is_unique,
         .sparse = is_sparse,
+        .multikey = true,                   /* Arrays index per element */
         .compare = _mongolite_index_compare,
         .dupsort_compare = NULL             /* Use default */
     };
@@ -510,6 +768,12 @@ int mongolite_create_index(mongolite_db_t *db, const char *collection,
     /* Invalidate index cache so it gets reloaded with new index */
     _mongolite_invalidate_index_cache(db, collection);
 
+    /* Planner statistics; without them the index is merely estimated */
+    mongolite_tree_cache_entry_t *entry = _mongolite_get_collection_entry(db, collection, NULL);
+    if (entry) {
+        _mongolite_analyze_locked(db, entry, index_name, NULL);
+    }
+
     rc = MONGOLITE_OK;
 
 cleanup:
@@ -545,6 +809,12 @@ int mongolite_drop_index(mongolite_db_t *db, const char *collection,
 
     _mongolite_lock(db);
 
+    rc = _mongolite_require_no_write_session(db, error);
+    if (rc != MONGOLITE_OK) {
+        _mongolite_unlock(db);
+        return rc;
+    }
+
     /* Get collection tree (wtree3) - also verifies collection exists */
     wtree3_tree_t *tree = _mongolite_get_collection_tree(db, collection, error);
     if (!tree) {
@@ -20,57 +20,6 @@
 /* Maximum resize attempts to prevent infinite loops */
 #define MONGOLITE_MAX_RESIZE_ATTEMPTS 3
 
-/*
- * Optional compile-time limit for maximum database size after auto-resize.
- * Define MONGOLITE_MAX_DB_SIZE to a byte value to enforce a limit.
- * If not defined or set to 0, only overflow is checked (no artificial limit).
- *
- * Example: -DMONGOLITE_MAX_DB_SIZE=1099511627776ULL  (1TB)
- */
-#ifndef MONGOLITE_MAX_DB_SIZE
-#define MONGOLITE_MAX_DB_SIZE 0
-#endif
-
-/* ============================================================
- * Internal: Try to resize database on MDB_MAP_FULL
- *
- * Doubles the current mapsize. Returns 0 on success.
- * Should only be called when no transactions are active.
- * ============================================================ */
-int _mongolite_try_resize(mongolite_db_t *db, gerror_t *error) {
-    if (!db || !db->wdb) {
-        set_error(error, MONGOLITE_LIB, MONGOLITE_EINVAL,
-                 "Invalid database handle");
-        return MONGOLITE_EINVAL;
-    }
-
-    size_t current_size = wtree3_db_get_mapsize(db->wdb);
-    size_t new_size = current_size * 2;
-
-    /* Check for overflow */
-    if (new_size < current_size) {
-        set_error(error, MONGOLITE_LIB, MONGOLITE_ERROR,
-                 "Database size overflow");
-        return MONGOLITE_ERROR;
-    }
-
-#if MONGOLITE_MAX_DB_SIZE > 0
-    /* Check compile-time size limit */
-    if (new_size > (size_t)MONGOLITE_MAX_DB_SIZE) {
-        set_error(error, MONGOLITE_LIB, MONGOLITE_ERROR,
-                 "Database would exceed maximum size limit");
-        return MONGOLITE_ERROR;
-    }
-#endif
-
-    int rc = wtree3_db_resize(db->wdb, new_size, error);
-    if (rc == 0) {
-        db->max_bytes = new_size;
-    }
-
-    return rc;
-}
-
 /* _ensure_id is now _mongolite_ensure_doc_id in mongolite_util.c */
 
 /* ============================================================
@@ -84,29 +33,21 @@ static inline bool _is_map_full_error(int rc) {
  * Insert One
  *
  * With wtree3, indexes are maintained automatically.
+ * The core assumes the caller holds the database lock.
  * ============================================================ */
 
 MONGOLITE_HOT
-int mongolite_insert_one(mongolite_db_t *db, const char *collection,
-                          const bson_t *doc, bson_oid_t *inserted_id,
-                          gerror_t *error) {
-    VALIDATE_DB_COLLECTION_DOC(db, collection, doc, error, MONGOLITE_EINVAL);
-
-    _mongolite_lock(db);
-
-    /* Get collection tree (wtree3 - handles indexes automatically) */
-    wtree3_tree_t *tree = _mongolite_get_collection_tree(db, collection, error);
-    if (MONGOLITE_UNLIKELY(!tree)) {
-        _mongolite_unlock(db);
-        return MONGOLITE_ERROR;
-    }
+int _mongolite_insert_one_entry(mongolite_db_t *db, mongolite_tree_cache_entry_t *entry,
+                                 const bson_t *doc, bson_oid_t *inserted_id,
+                                 gerror_t *error) {
+    /* Collection tree (wtree3 - handles indexes automatically) */
+    wtree3_tree_t *tree = entry->tree;
 
     /* Ensure document has _id */
     bson_oid_t oid;
     bool id_generated = false;
     bson_t *final_doc = _mongolite_ensure_doc_id(doc, &oid, &id_generated, error);
     if (MONGOLITE_UNLIKELY(!final_doc)) {
-        _mongolite_unlock(db);
         return MONGOLITE_ENOMEM;
     }
 
@@ -119,7 +60,6 @@ retry_insert:
         wtree3_txn_t *txn = _mongolite_get_write_txn(db, error);
         if (MONGOLITE_UNLIKELY(!txn)) {
             if (id_generated) bson_destroy(final_doc);
-            _mongolite_unlock(db);
             return MONGOLITE_ERROR;
         }
 
@@ -129,6 +69,10 @@ retry_insert:
                                     oid.bytes, sizeof(oid.bytes),
                                     bson_get_data(final_doc), final_doc->len,
                                     error);
+        if (rc == 0 && MONGOLITE_UNLIKELY(db->change_feed != NULL)) {
+            rc = _mongolite_change_log(db, txn, MONGOLITE_CHANGE_INSERT, entry->name, tree,
+                                       &oid, final_doc, error);
+        }
 
         if (MONGOLITE_UNLIKELY(rc != 0)) {
             _mongolite_abort_if_auto(db, txn);
@@ -149,7 +93,6 @@ retry_insert:
             }
 
             if (id_generated) bson_destroy(final_doc);
-            _mongolite_unlock(db);
             return _mongolite_translate_wtree3_error(rc);
         }
 
@@ -173,7 +116,6 @@ retry_insert:
             }
 
             if (id_generated) bson_destroy(final_doc);
-            _mongolite_unlock(db);
             return rc;
         }
     }
@@ -188,19 +130,119 @@ retry_insert:
     db->changes = 1;
 
     if (id_generated) bson_destroy(final_doc);
-    _mongolite_unlock(db);
 
     return MONGOLITE_OK;
 }
 
+static int _insert_one(mongolite_db_t *db, const char *collection,
+                       const bson_t *doc, bson_oid_t *inserted_id,
+                       gerror_t *error) {
+    _mongolite_lock(db);
+
+    /* Get collection cache entry (wtree3 - handles indexes automatically) */
+    mongolite_tree_cache_entry_t *entry = _mongolite_get_collection_entry(db, collection, error);
+    if (MONGOLITE_UNLIKELY(!entry)) {
+        _mongolite_unlock(db);
+        return MONGOLITE_ERROR;
+    }
+
+    int rc = _mongolite_insert_one_entry(db, entry, doc, inserted_id, error);
+
+    _mongolite_unlock(db);
+    return rc;
+}
+
+static int _col_insert_one(mongolite_collection_t *col, const bson_t *doc,
+                           bson_oid_t *inserted_id, gerror_t *error) {
+    mongolite_db_t *db = col->db;
+    _mongolite_lock(db);
+
+    mongolite_tree_cache_entry_t *entry = _mongolite_collection_resolve(col, error);
+    if (MONGOLITE_UNLIKELY(!entry)) {
+        _mongolite_unlock(db);
+        return MONGOLITE_ERROR;
+    }
+
+    int rc = _mongolite_insert_one_entry(db, entry, doc, inserted_id, error);
+
+    _mongolite_unlock(db);
+    return rc;
+}
+
+/* Group commit: arguments of a queued insert (col set for handle inserts) */
+typedef struct {
+    const char *collection;
+    mongolite_collection_t *col;
+    const bson_t *doc;
+    bson_oid_t *inserted_id;
+} insert_one_args_t;
+
+static int _insert_one_grouped(mongolite_db_t *db, void *arg, gerror_t *error) {
+    insert_one_args_t *args = arg;
+    if (args->col) return _col_insert_one(args->col, args->doc, args->inserted_id, error);
+    return _insert_one(db, args->collection, args->doc, args->inserted_id, error);
+}
+
+MONGOLITE_HOT
+int mongolite_insert_one(mongolite_db_t *db, const char *collection,
+                          const bson_t *doc, bson_oid_t *inserted_id,
+                          gerror_t *error) {
+    VALIDATE_DB_COLLECTION_DOC(db, collection, doc, error, MONGOLITE_EINVAL);
+
+    uint64_t start = _mongolite_stats_start(db);
+    int rc;
+    if (_mongolite_group_enabled(db)) {
+        insert_one_args_t args = {collection, NULL, doc, inserted_id};
+        rc = _mongolite_group_submit(db, collection, _insert_one_grouped, &args, error);
+    } else {
+        rc = _insert_one(db, collection, doc, inserted_id, error);
+    }
+    _mongolite_stats_record(db, MONGOLITE_OP_INSERT, start);
+    return rc;
+}
+
+MONGOLITE_HOT
+int mongolite_col_insert_one(mongolite_collection_t *col, const bson_t *doc,
+                              bson_oid_t *inserted_id, gerror_t *error) {
+    if (MONGOLITE_UNLIKELY(!col || !doc)) {
+        set_error(error, MONGOLITE_LIB, MONGOLITE_EINVAL,
+                 "Collection handle and document are required");
+        return MONGOLITE_EINVAL;
+    }
+
+    mongolite_db_t *db = col->db;
+    uint64_t start = _mongolite_stats_start(db);
+    int rc;
+    if (_mongolite_group_enabled(db)) {
+        insert_one_args_t args = {col->name, col, doc, inserted_id};
+        rc = _mongolite_group_submit(db, col->name, _insert_one_grouped, &args, error);
+    } else {
+        rc = _col_insert_one(col, doc, inserted_id, error);
+    }
+    _mongolite_stats_record(db, MONGOLITE_OP_INSERT, start);
+    return rc;
+}
+
 /* ============================================================
  * Insert Many
  * ============================================================ */
 
-MONGOLITE_HOT
-int mongolite_insert_many(mongolite_db_t *db, const char *collection,
-                           const bson_t **docs, size_t n_docs,
-                           bson_oid_t **inserted_ids, gerror_t *error) {
+/* Rough map space for a batch: pages may be half full after splits, and
+ * each index adds an entry of a key plus _id per document */
+#define MONGOLITE_INDEX_ENTRY_ESTIMATE 64
+
+static size_t _batch_map_estimate(const bson_t **docs, size_t n_docs, size_t index_count) {
+    size_t bytes = 0;
+    for (size_t i = 0; i < n_docs; i++) {
+        if (docs[i]) bytes += docs[i]->len + sizeof(bson_oid_t) + 8;
+    }
+    bytes += n_docs * index_count * MONGOLITE_INDEX_ENTRY_ESTIMATE;
+    return bytes * 2;
+}
+
+static int _insert_many(mongolite_db_t *db, const char *collection,
+                         const bson_t **docs, size_t n_docs,
+                         bson_oid_t **inserted_ids, gerror_t *error) {
     VALIDATE_PARAMS(db && collection && docs && n_docs > 0, error,
                    "Database, collection, and documents are required", MONGOLITE_EINVAL);
 
@@ -225,6 +267,10 @@ int mongolite_insert_many(mongolite_db_t *db, const char *collection,
         }
     }
 
+    /* Grow before the batch instead of replaying it after MAP_FULL */
+    _mongolite_map_reserve(db, _batch_map_estimate(docs, n_docs,
+                                                   wtree3_tree_index_count(tree)));
+
     int rc = MONGOLITE_OK;
     int resize_attempts = 0;
 
@@ -301,6 +347,14 @@ retry_insert_many:
         if (rc == MONGOLITE_OK && inserted > 0) {
             rc = wtree3_insert_many_txn(txn, tree, kvs, inserted, error);
         }
+        if (rc == 0 && MONGOLITE_UNLIKELY(db->change_feed != NULL)) {
+            for (size_t i = 0; i < inserted && rc == 0; i++) {
+                bson_t doc;
+                bson_init_static(&doc, kvs[i].value, kvs[i].value_len);
+                rc = _mongolite_change_log(db, txn, MONGOLITE_CHANGE_INSERT, collection, tree,
+                                           (const bson_oid_t *)kvs[i].key, &doc, error);
+            }
+        }
 
         /* Cleanup generated docs and batch arrays */
         for (size_t i = 0; i < n_docs; i++) {
@@ -379,6 +433,16 @@ retry_insert_many:
     return MONGOLITE_OK;
 }
 
+MONGOLITE_HOT
+int mongolite_insert_many(mongolite_db_t *db, const char *collection,
+                           const bson_t **docs, size_t n_docs,
+                           bson_oid_t **inserted_ids, gerror_t *error) {
+    uint64_t start = _mongolite_stats_start(db);
+    int rc = _insert_many(db, collection, docs, n_docs, inserted_ids, error);
+    _mongolite_stats_record(db, MONGOLITE_OP_INSERT, start);
+    return rc;
+}
+
 /* ============================================================
  * Insert One JSON
  * ============================================================ */
@@ -443,3 +507,79 @@ int mongolite_insert_many_json(mongolite_db_t *db, const char *collection,
 
     return rc;
 }
+
+/* ============================================================
+ * Insert NDJSON
+ * ============================================================ */
+
+#define MONGOLITE_NDJSON_DEFAULT_BATCH 1000
+
+int mongolite_insert_ndjson(mongolite_db_t *db, const char *collection,
+                            const char *data, size_t len, size_t batch_size,
+                            int64_t *n_inserted, gerror_t *error) {
+    if (n_inserted) *n_inserted = 0;
+    VALIDATE_PARAMS(db && collection && (data || len == 0), error,
+                   "Database, collection, and data are required", MONGOLITE_EINVAL);
+    if (batch_size == 0) batch_size = MONGOLITE_NDJSON_DEFAULT_BATCH;
+
+    /* One document per batch slot, reset (keeping its buffer) for each
+     * line instead of allocated per line */
+    bson_t **docs = calloc(batch_size, sizeof(bson_t*));
+    if (MONGOLITE_UNLIKELY(!docs)) {
+        set_error(error, "system", MONGOLITE_ENOMEM, "Failed to allocate document array");
+        return MONGOLITE_ENOMEM;
+    }
+
+    int rc = MONGOLITE_OK;
+    int64_t total = 0;
+    size_t n = 0;
+    size_t line = 0;
+    const char *p = data;
+    const char *end = data + len;
+
+    while (rc == MONGOLITE_OK && p < end) {
+        const char *nl = memchr(p, '\n', (size_t)(end - p));
+        const char *eol = nl ? nl : end;
+        const char *s = p;
+        p = nl ? nl + 1 : end;
+        line++;
+
+        while (s < eol && (*s == ' ' || *s == '\t' || *s == '\r')) s++;
+        if (s == eol) continue;
+
+        if (!docs[n]) {
+            docs[n] = bson_new();
+        } else {
+            bson_reinit(docs[n]);
+        }
+        rc = _mongolite_json_parse(s, (size_t)(eol - s), docs[n], error);
+        if (MONGOLITE_UNLIKELY(rc != MONGOLITE_OK)) {
+            if (error) {
+                char lib[sizeof(error->lib)];
+                char msg[sizeof(error->message)];
+                memcpy(lib, error->lib, sizeof(lib));
+                memcpy(msg, error->message, sizeof(msg));
+                set_error(error, lib, rc, "Line %zu: %s", line, msg);
+            }
+            break;
+        }
+
+        if (++n == batch_size) {
+            rc = mongolite_insert_many(db, collection, (const bson_t**)docs, n, NULL, error);
+            if (rc == MONGOLITE_OK) total += (int64_t)n;
+            n = 0;
+        }
+    }
+    if (rc == MONGOLITE_OK && n > 0) {
+        rc = mongolite_insert_many(db, collection, (const bson_t**)docs, n, NULL, error);
+        if (rc == MONGOLITE_OK) total += (int64_t)n;
+    }
+
+    for (size_t i = 0; i < batch_size; i++) {
+        if (docs[i]) bson_destroy(docs[i]);
+    }
+    free(docs);
+
+    if (n_inserted) *n_inserted = total;
+    return rc;
+}
@@ -22,11 +22,18 @@ extern "C" {
 /* Tree naming conventions */
 #define MONGOLITE_COL_PREFIX    "col:"
 #define MONGOLITE_IDX_PREFIX    "idx:"
+#define MONGOLITE_CHANGES_TREE  "log:changes"    /* Change feed (not a collection) */
 
 /* Default limits */
 #define MONGOLITE_DEFAULT_MAPSIZE     (1024ULL * 1024 * 1024)  /* 1GB */
 #define MONGOLITE_DEFAULT_MAX_DBS     256
 #define MONGOLITE_DEFAULT_MAX_COLLECTIONS 128
+#define MONGOLITE_DEFAULT_GROUP_OPS   128
+#define MONGOLITE_DEFAULT_SYNC_INTERVAL_MS 100
+#define MONGOLITE_DEFAULT_GROW_AT_PERCENT  90
+#define MONGOLITE_DEFAULT_GROWTH_PERCENT   100
+#define MONGOLITE_DEFAULT_SCAN_MIN_DOCS    100000
+#define MONGOLITE_DEFAULT_READAHEAD_BYTES  (1024 * 1024)
 
 /* Note: Schema system removed - collections are simply wtree3 trees with "col:" prefix */
 
@@ -56,6 +63,10 @@ extern "C" {
 #define MONGOLITE_EINDEX       -1009   /* Index error */
 #define MONGOLITE_ECAPPED      -1010   /* Capped collection error */
 #define MONGOLITE_EVALIDATION  -1011   /* Validation error */
+#define MONGOLITE_EBUSY        -1012   /* Write session open on another thread */
+#define MONGOLITE_ETIMEDOUT    -1013   /* Wait timed out */
+#define MONGOLITE_ECANCELED    -1014   /* Stopped by a callback */
+#define MONGOLITE_ETRUNCATED   -1015   /* Changes already trimmed from the feed */
 
 /* Check if error code is from mongolite range */
 #define MONGOLITE_IS_ERROR(code) ((code) <= -1000 && (code) >= -1999)
@@ -79,6 +90,38 @@ static inline int _mongolite_translate_wtree3_error(int wtree3_rc) {
  * Internal Structures
  * ============================================================ */
 
+/*
+ * Access path chosen for a query (shared by prepared statements and
+ * the find paths)
+ */
+typedef enum {
+    MONGOLITE_PLAN_SCAN = 0,            /* Full collection scan + matcher */
+    MONGOLITE_PLAN_ID,                  /* Direct _id lookup */
+    MONGOLITE_PLAN_INDEX_EQ,            /* Equality seek on a secondary index */
+    MONGOLITE_PLAN_INDEX_MULTI          /* Point seeks: $in lists, $or unions */
+} mongolite_plan_type_t;
+
+/*
+ * Planner statistics for an index (mongolite_analyze.c): an equi-depth
+ * histogram over its keys in index order. A key holding a bucket's worth
+ * of entries gets a bucket of its own, so rows / keys of the bucket a key
+ * falls in estimates its duplicates even on skewed data.
+ */
+typedef struct {
+    uint64_t rows;              /* Index entries in the bucket */
+    uint64_t keys;              /* Distinct keys in the bucket */
+    MDB_val upper;              /* Last key of the bucket (points into blob) */
+} mongolite_hist_bucket_t;
+
+typedef struct mongolite_index_hist {
+    uint64_t entries;           /* Index entries when analyzed */
+    uint64_t keys;              /* Distinct keys when analyzed */
+    size_t n_buckets;
+    mongolite_hist_bucket_t *buckets;
+    uint8_t *blob;              /* Persisted form (wtree3 index stats) */
+    size_t blob_len;
+} mongolite_index_hist_t;
+
 /*
  * Cached index info for a collection (used for query optimization)
  * Note: Index trees are now managed internally by wtree2
@@ -88,15 +131,49 @@ typedef struct mongolite_cached_index {
     bson_t *keys;               /* Index key spec (e.g., {"email": 1}) */
     bool unique;
     bool sparse;
+    bool text;                  /* Inverted text index: every key value is "text" */
+    bool geo;                   /* Geospatial index: {field: "2dsphere"} or "2d" */
+    bool multikey;              /* Ordered index keyed per array element */
+    bool legacy;                /* Ordered, created before multi-key indexes:
+                                 * an array is one key, so never seeked */
     MDB_dbi dbi;                /* Index DBI handle (from wtree3) */
+    mongolite_index_hist_t *hist;   /* Planner statistics (NULL = not analyzed) */
 } mongolite_cached_index_t;
 
+/*
+ * Plan cache slot (per collection, direct-mapped by query shape hash)
+ *
+ * The shape is the filter with values stripped: field names, operators
+ * and equality value types (hex bson_type_t), e.g. "ref_id=12;" or
+ * "age{$gt,$lt};".
+ */
+#define MONGOLITE_PLAN_CACHE_SLOTS 32
+#define MONGOLITE_QUERY_SHAPE_MAX  256
+
+typedef struct mongolite_plan_cache_slot {
+    char *shape;                        /* Normalized query shape (NULL = empty) */
+    uint64_t hash;                      /* Hash of shape */
+    mongolite_plan_type_t type;
+    mongolite_cached_index_t *index;    /* INDEX_EQ: points into entry->indexes */
+} mongolite_plan_cache_slot_t;
+
+/* One thread shard of a collection's query counters, padded to a cache
+ * line so threads on different shards do not share one */
+typedef struct {
+    mongolite_op_stats_t counters;
+    uint8_t pad[64 - sizeof(mongolite_op_stats_t)];
+} mongolite_op_stats_shard_t;
+
 /*
  * Cached tree handle (for open collection trees)
  * Note: Index trees are now managed internally by wtree3
+ *
+ * Entries are heap-allocated and referenced from the open-addressed
+ * slot array in mongolite_db, so their address is stable across rehashes.
  */
 typedef struct mongolite_tree_cache_entry {
     bson_oid_t oid;             /* Tree's unique identifier */
+    uint64_t hash;              /* Precomputed hash of name */
     char *name;                 /* Collection name */
     char *tree_name;            /* Full LMDB tree name (col:xxx) */
     wtree3_tree_t *tree;        /* Open tree handle (wtree3 - manages indexes) */
@@ -105,10 +182,80 @@ typedef struct mongolite_tree_cache_entry {
     mongolite_cached_index_t *indexes;  /* Array of cached index specs */
     size_t index_count;                 /* Number of indexes (excluding _id) */
     bool indexes_loaded;                /* true if index specs have been loaded */
+    uint64_t index_epoch;               /* Bumped whenever the index specs change */
 
-    struct mongolite_tree_cache_entry *next;
+    /* Query plan cache (cleared with the index specs) */
+    mongolite_plan_cache_slot_t *plan_cache;  /* [MONGOLITE_PLAN_CACHE_SLOTS], lazy */
+    uint64_t plan_hits;                 /* Plans served from the cache */
+    uint64_t plan_replans;              /* Plans computed (miss or eviction) */
+
+    /* Query counters for mongolite_collection_stats, sharded like the
+     * database totals ([MONGOLITE_STATS_SHARDS], NULL without statistics) */
+    mongolite_op_stats_shard_t *stats;
 } mongolite_tree_cache_entry_t;
 
+/*
+ * Prepared collection handle (public opaque mongolite_collection_t)
+ *
+ * Remembers the resolved cache entry so hot paths skip the name lookup.
+ * The entry pointer is only trusted while `generation` matches
+ * db->tree_cache_generation; after a drop/clear it is re-resolved by hash.
+ */
+struct mongolite_collection {
+    mongolite_db_t *db;
+    char *name;                         /* Collection name (owned) */
+    uint64_t hash;                      /* Precomputed hash of name */
+    mongolite_tree_cache_entry_t *entry;  /* Resolved cache entry */
+    uint64_t generation;                /* Cache generation at resolve time */
+};
+
+/* Group commit queue (opaque, holds platform condition variables) */
+typedef struct mongolite_group mongolite_group_t;
+
+/* Slow-operation log ring (opaque, mongolite_slowlog.c) */
+typedef struct mongolite_slowlog mongolite_slowlog_t;
+
+/* Change feed tree and commit notifications (opaque, mongolite_changes.c) */
+typedef struct mongolite_change_feed mongolite_change_feed_t;
+
+/* Sync tracking and background flusher (opaque, mongolite_durability.c) */
+typedef struct mongolite_flusher mongolite_flusher_t;
+
+/* Parallel collection scan in progress (opaque, mongolite_scan.c) */
+typedef struct mongolite_scan mongolite_scan_t;
+
+/* $near ring search in progress (opaque, mongolite_geo.c) */
+typedef struct mongolite_geo_near mongolite_geo_near_t;
+
+/* Scan readahead (mongolite_readahead.c): WILLNEED windows ahead of a
+ * reader's position in the map. Per reader, no locking. */
+typedef struct {
+    mongolite_db_t *db;
+    size_t window;                      /* Bytes per hint (0 = off) */
+    size_t page_size;
+    uintptr_t start;                    /* Last window issued */
+    uintptr_t next;                     /* Address that issues the next one */
+} mongolite_readahead_t;
+
+/* Fetches by _id looked up together, so their pages are hinted at once */
+#define MONGOLITE_FETCH_BATCH 32
+
+typedef struct {
+    const void *data;                   /* Document (valid while the txn is open), NULL = gone */
+    size_t len;
+} mongolite_fetch_t;
+
+/* Map growth policy (mongolite_map.c), resolved from db_config_t at open */
+typedef struct {
+    unsigned int grow_at_percent;       /* >= 100: grow only on MAP_FULL */
+    size_t growth_step;                 /* 0 = growth_percent of the map */
+    unsigned int growth_percent;
+    size_t max_bytes;                   /* 0 = no cap */
+    mongolite_map_growth_fn fn;         /* Decision hook (NULL = built in) */
+    void *ctx;
+    size_t page_size;
+} mongolite_map_policy_t;
+
 /*
  * Main database handle
  */
@@ -119,6 +266,7 @@ struct mongolite_db {
     /* Configuration (copied from open) */
     char *path;                         /* Database directory path */
     int open_flags;                     /* MONGOLITE_OPEN_* flags */
+    unsigned int lmdb_flags;            /* Incl. durability flags (reopen after compact) */
     size_t max_bytes;
     unsigned int max_dbs;
     uint32_t version;                   /* Extractor version for indexes */
@@ -126,21 +274,62 @@ struct mongolite_db {
     /* State */
     int64_t last_insert_rowid;          /* Last generated _id as int64 */
     int changes;                        /* Docs affected by last operation */
-    bool in_transaction;                /* Explicit transaction active */
-    wtree3_txn_t *current_txn;          /* Current explicit transaction (wtree3) */
+
+    /* Sessions (mongolite_session.c), counted under the db lock */
+    int open_sessions;                  /* Sessions bound to any thread */
+    int write_sessions;                 /* Write sessions, incl. one waiting for the writer */
+    int busy_timeout_ms;                /* Other writers wait this long (0 = forever, < 0 = never) */
+
+    /* Query planner */
+    bool plan_cache_disabled;           /* Re-plan every query */
+    unsigned int scan_threads;          /* Parallel scan workers (< 2 = serial) */
+    uint64_t scan_min_docs;             /* Smaller collections scan serially */
+    size_t readahead_bytes;             /* Scan readahead window (0 = off) */
+    uint64_t analyze_clock;             /* Bytes written at the last statistics check */
+    bool analyzing;                     /* Drifted statistics being rebuilt */
+
+    /* Statistics: per-thread shards, summed on read (NULL = disabled) */
+    mongolite_stats_t *stats_shards;    /* [MONGOLITE_STATS_SHARDS] */
+
+    /* Slow-operation log (mongolite_slowlog.c, NULL = disabled) */
+    mongolite_slowlog_t *slowlog;
+
+    /* Group commit queue (mongolite_group.c, NULL = disabled) */
+    mongolite_group_t *group;
+
+    /* Change feed (mongolite_changes.c, NULL = disabled) */
+    mongolite_change_feed_t *change_feed;
+
+    /* Durability (mongolite_durability.c) */
+    mongolite_durability_t durability;
+    bool sync_on_commit;                /* LMDB syncs every commit itself */
+    mongolite_flusher_t *flusher;       /* Sync state + ASYNC thread */
+
+    /* Map growth (mongolite_map.c) */
+    mongolite_map_policy_t map_policy;
+    uint64_t cursor_txns;               /* Cursors / backups holding a read txn (atomic) */
 
     /* Read transaction pool (optimization: reuse via reset/renew) */
     wtree3_txn_t *read_txn_pool;        /* Cached read transaction (wtree3) */
 
-    /* Tree cache (simple linked list for now) */
-    mongolite_tree_cache_entry_t *tree_cache;
+    /* Tree cache (open-addressed hash table, linear probing) */
+    mongolite_tree_cache_entry_t **tree_cache;  /* Slot array (NULL = empty) */
+    size_t tree_cache_capacity;                 /* Slot count (power of two) */
     size_t tree_cache_count;
+    uint64_t tree_cache_generation;             /* Bumped when entries are removed */
+    uint64_t schema_generation;                 /* Bumped when collections or index specs
+                                                 * are added to or dropped from the cache */
+    uint64_t opened_generation;                 /* schema_generation when every collection
+                                                 * was last opened (write session begin) */
+    size_t opened_trees;                        /* Named trees in the env then (0 = never) */
 
     /* Thread safety (if FULLMUTEX) */
 #ifdef _WIN32
     void *mutex;                        /* CRITICAL_SECTION* on Windows */
+    void *writer_cond;                  /* CONDITION_VARIABLE*: a write session ended */
 #else
     pthread_mutex_t *mutex;
+    pthread_cond_t *writer_cond;        /* A write session ended */
 #endif
 };
 
@@ -155,6 +344,7 @@ struct mongolite_cursor {
     wtree3_txn_t *txn;                  /* Read transaction (wtree3) */
     wtree3_iterator_t *iter;            /* Tree iterator (wtree3) */
     bool owns_txn;                      /* Did we create the transaction? */
+    bool external;                      /* Returned to the caller (destroyed unlocked) */
 
     /* Query */
     mongoc_matcher_t *matcher;          /* Filter (from bsonmatch) */
@@ -170,11 +360,95 @@ struct mongolite_cursor {
     /* Current document */
     bson_t *current_doc;                /* Current document (owned) */
     bool exhausted;                     /* No more results */
+    int error_rc;                       /* Read error that ended them (MONGOLITE_OK = none) */
 
     /* Sort buffer (if sorting required) */
     bson_t **sort_buffer;               /* Buffered docs for sorting */
     size_t sort_buffer_size;
     size_t sort_buffer_pos;
+
+    /* Parallel scan feeding the cursor instead of iter (NULL = serial) */
+    mongolite_scan_t *scan;
+
+    /* Batched _id lookups feeding the cursor instead of iter ($in on _id) */
+    wtree3_tree_t *tree;
+    bson_oid_t *ids;                    /* Sorted, deduplicated (owned) */
+    size_t n_ids;
+    size_t next_id;
+    mongolite_geo_near_t *near;         /* Refills ids ring by ring (owned, NULL = none) */
+    mongolite_fetch_t batch[MONGOLITE_FETCH_BATCH];
+    size_t batch_len;
+    size_t batch_pos;
+    int64_t skipped;
+
+    mongolite_readahead_t readahead;
+
+    /* Access path, for mongolite_explain */
+    mongolite_plan_type_t plan;
+    uint64_t keys_examined;             /* Index entries read by the seeks */
+
+    /* Slow-operation log: the find's entry, completed at destroy (NULL = not traced) */
+    mongolite_slow_op_t *slow;
+};
+
+/* Placeholder key used in prepared statement filters: {"field": {"$param": N}} */
+#define MONGOLITE_PARAM_KEY "$param"
+
+/*
+ * Prepared statement (public opaque mongolite_stmt_t)
+ *
+ * The filter template is analyzed and planned once at prepare time.
+ * Bindings only rebuild the concrete filter; the matcher is compiled
+ * lazily and only when the plan cannot answer the query by itself.
+ */
+struct mongolite_stmt {
+    mongolite_db_t *db;
+    mongolite_collection_t *col;        /* Resolved collection handle */
+
+    /* Template */
+    bson_t *filter;                     /* Filter with $param placeholders */
+    int param_count;                    /* Highest placeholder number */
+    bson_value_t *params;               /* Bound values [param_count] */
+    bool *bound;                        /* Bound flags [param_count] */
+
+    /* Shape (top-level equality fields of the template) */
+    char **eq_fields;
+    int *eq_params;                     /* Param number per field (0 = literal) */
+    size_t eq_count;
+    bool all_equality;                  /* Every predicate is a top-level equality */
+
+    /* Plan (revalidated against the cache generation and the entry's
+     * index epoch; only dereferenced under the db lock) */
+    mongolite_plan_type_t plan;
+    mongolite_cached_index_t *index;    /* INDEX_EQ: chosen index */
+    bool covered;                       /* INDEX_EQ: index answers the filter exactly */
+    mongolite_tree_cache_entry_t *plan_entry;
+    uint64_t plan_generation;           /* db->tree_cache_generation when planned */
+    uint64_t plan_epoch;
+
+    /* Execution state */
+    bson_t *bound_filter;               /* Concrete filter for current bindings */
+    mongoc_matcher_t *matcher;          /* Compiled from bound_filter (lazy) */
+    bool bindings_dirty;                /* bound_filter/matcher need a rebuild */
+    bool match_rows;                    /* Rows must be checked by the matcher */
+    bool active;                        /* An execution is in progress */
+    bool done;
+    wtree3_txn_t *txn;                  /* Read txn (multi-row plans) */
+    bool session_txn;                   /* txn belongs to the caller's session */
+    MDB_cursor *index_cursor;           /* INDEX_EQ: positioned on the key */
+    MDB_cursor_op index_op;             /* INDEX_EQ: next cursor move */
+    bool index_done;                    /* INDEX_EQ: duplicates exhausted */
+    wtree3_tree_t *tree;                /* INDEX_EQ: collection tree, copied at begin */
+    uint64_t rows_scanned;              /* INDEX_EQ: counted until the execution ends */
+    uint64_t rows_returned;
+    mongolite_fetch_t batch[MONGOLITE_FETCH_BATCH];  /* INDEX_EQ: fetched rows */
+    size_t batch_len;
+    size_t batch_pos;
+    mongolite_readahead_t readahead;
+    mongolite_cursor_t *scan;           /* SCAN: cursor over the collection */
+    bson_t current;                     /* Current row (static view) */
+    uint8_t *row_buf;                   /* Row copy for single-row plans */
+    size_t row_cap;
 };
 
 /* Note: Schema system removed - no longer needed */
@@ -183,7 +457,13 @@ struct mongolite_cursor {
  * Internal Tree Cache Operations
  * ============================================================ */
 
+/* Hash used to key the tree cache (FNV-1a) */
+uint64_t _mongolite_name_hash(const char *name);
+
 wtree3_tree_t* _mongolite_tree_cache_get(mongolite_db_t *db, const char *name);
+mongolite_tree_cache_entry_t* _mongolite_tree_cache_lookup(mongolite_db_t *db,
+                                                           const char *name,
+                                                           uint64_t hash);
 int _mongolite_tree_cache_put(mongolite_db_t *db, const char *name,
                               const char *tree_name, const bson_oid_t *oid,
                               wtree3_tree_t *tree);
@@ -195,12 +475,24 @@ mongolite_cached_index_t* _mongolite_get_cached_indexes(mongolite_db_t *db,
                                                          const char *collection,
                                                          size_t *out_count,
                                                          gerror_t *error);
+mongolite_cached_index_t* _mongolite_entry_indexes(mongolite_db_t *db,
+                                                    mongolite_tree_cache_entry_t *entry,
+                                                    size_t *out_count,
+                                                    gerror_t *error);
 void _mongolite_invalidate_index_cache(mongolite_db_t *db, const char *collection);
 
 /* ============================================================
  * Internal Utilities
  * ============================================================ */
 
+/* Open db->path with the handle's settings and register index key
+ * extractors (mongolite_open, and reopen after compaction) */
+int _mongolite_open_env(mongolite_db_t *db, gerror_t *error);
+
+/* MONGOLITE_EIO once a compaction could not reopen the environment: the
+ * handle then only closes */
+int _mongolite_require_env(mongolite_db_t *db, gerror_t *error);
+
 /* Build tree names */
 char* _mongolite_collection_tree_name(const char *collection_name);
 char* _mongolite_index_tree_name(const char *collection_name, const char *index_name);
@@ -221,6 +513,16 @@ void _mongolite_lock_free(mongolite_db_t *db);
 void _mongolite_lock(mongolite_db_t *db);
 void _mongolite_unlock(mongolite_db_t *db);
 
+/* Take the lock and keep it across calls: until dropped, the calling
+ * thread's _mongolite_lock/_unlock on db are no-ops (group commit leader) */
+void _mongolite_lock_hold(mongolite_db_t *db);
+void _mongolite_lock_drop(mongolite_db_t *db);
+
+/* Wait, lock held (released meanwhile), for a write session to end, up
+ * to ms (< 0 = forever). Also returns on timeout or spuriously: re-check. */
+void _mongolite_writer_wait(mongolite_db_t *db, int ms);
+void _mongolite_writer_wake(mongolite_db_t *db);
+
 /* Platform helpers */
 char* _mongolite_strndup(const char *s, size_t n);
 
@@ -233,11 +535,16 @@ void _mongolite_abort_if_auto(mongolite_db_t *db, wtree3_txn_t *txn);
 
 /* Note: Doc count now managed automatically by wtree3_tree_count() */
 
-/* Auto-resize database on MDB_MAP_FULL (doubles mapsize) */
-int _mongolite_try_resize(mongolite_db_t *db, gerror_t *error);
-
 /* Query optimization helpers */
 bool _mongolite_is_id_query(const bson_t *filter, bson_oid_t *out_oid);
+
+/* {_id: {$in: [<oid>, ...]}, ...}: the OIDs sorted and deduplicated (caller
+ * frees) and whether other predicates remain for the matcher. False if _id
+ * is not an $in of OIDs only (other _id types are keyed by generated OIDs). */
+bool _mongolite_id_in_query(const bson_t *filter, bson_oid_t **out_ids, size_t *out_n,
+                            bool *out_residual);
+/* Sort OIDs into key order and drop duplicates; returns the new count */
+size_t _mongolite_oids_sort_unique(bson_oid_t *ids, size_t n);
 bson_t* _mongolite_find_by_id(mongolite_db_t *db, wtree3_tree_t *tree,
                                const bson_oid_t *oid, gerror_t *error);
 
@@ -271,6 +578,18 @@ int _index_key_compare(const void *key1, size_t key1_len,
 /* LMDB-style index comparator wrapper for wtree3 */
 int _mongolite_index_compare(const MDB_val *a, const MDB_val *b);
 
+/* Keys one document may have in a multi-key ordered index */
+#define MONGOLITE_INDEX_MAX_KEYS 1024
+
+/* wtree3 extractors for multi-key indexes (text specs: one key per term,
+ * geo specs: one cell key per point, ordered specs: one key per array
+ * element, cartesian over compound fields). The sparse one skips
+ * documents whose key fields are all missing or null. */
+bool _mongolite_multikey_extractor(const void *value, size_t value_len, void *user_data,
+                                   void **out_key, size_t *out_len);
+bool _mongolite_multikey_extractor_sparse(const void *value, size_t value_len, void *user_data,
+                                          void **out_key, size_t *out_len);
+
 /* Serialize/deserialize index keys */
 uint8_t* _index_key_serialize(const bson_t *key, size_t *out_len);
 bson_t* _index_key_deserialize(const uint8_t *data, size_t len);
@@ -309,6 +628,73 @@ void _free_query_analysis(query_analysis_t *analysis);
 mongolite_cached_index_t* _find_best_index(mongolite_db_t *db, const char *collection,
                                             const query_analysis_t *analysis,
                                             gerror_t *error);
+mongolite_cached_index_t* _find_best_index_entry(mongolite_db_t *db,
+                                                  mongolite_tree_cache_entry_t *entry,
+                                                  const query_analysis_t *analysis,
+                                                  gerror_t *error);
+
+/* Build an index key ({field: value, ...} in index key order) from the
+ * equality values in filter. out_key must be initialized by the caller.
+ * Returns false if a key field is missing from the filter. */
+bool _mongolite_index_key_from_filter(const bson_t *filter, const bson_t *index_keys,
+                                      bson_t *out_key);
+
+/* Can the equality values of filter seek index's key? Not on a legacy
+ * index, nor a whole array on a multi-key index, which holds the
+ * elements. Clears *exact (may be NULL) when the documents found must
+ * still be matched. */
+bool _mongolite_index_eq_seekable(const mongolite_cached_index_t *index, const bson_t *filter,
+                                  bool *exact);
+
+/* Normalize a filter to its shape (values stripped) into buf.
+ * Returns the shape length, or 0 if it does not fit in cap. */
+size_t _mongolite_query_shape(const bson_t *filter, char *buf, size_t cap);
+
+/* Choose the access path for a find_one-style query, consulting the
+ * collection's plan cache. *out_index is set for MONGOLITE_PLAN_INDEX_EQ. */
+mongolite_plan_type_t _mongolite_plan_query(mongolite_db_t *db,
+                                            mongolite_tree_cache_entry_t *entry,
+                                            const bson_t *filter,
+                                            mongolite_cached_index_t **out_index,
+                                            gerror_t *error);
+
+/* Drop all cached plans of a collection */
+void _mongolite_plan_cache_clear(mongolite_tree_cache_entry_t *entry);
+
+/* Count matches by walking only an index (no document fetches).
+ * Handles equality on an index key prefix, optionally ending in a range
+ * ($gt/$gte/$lt/$lte) on the next key field; on a multi-key index
+ * documents are counted once, and a range needs a single bound.
+ * Returns 1 if answered (*out_count set), 0 if the filter needs a
+ * document scan, or a negative error code. */
+int _mongolite_count_with_index(mongolite_db_t *db, mongolite_tree_cache_entry_t *entry,
+                                const bson_t *filter, int64_t *out_count,
+                                gerror_t *error);
+
+/* Point seeks for an equality, $in or $or filter (MONGOLITE_PLAN_INDEX_EQ /
+ * _MULTI) in txn: the collection keys found, sorted and deduplicated
+ * (caller frees), whether the matcher must still check the documents and
+ * the index entries read (out_keys may be NULL). Returns 1 if answered,
+ * 0 if the filter needs a scan, or a negative error code. */
+int _mongolite_index_seek_ids(mongolite_db_t *db, mongolite_tree_cache_entry_t *entry,
+                              wtree3_txn_t *txn, const bson_t *filter,
+                              bson_oid_t **out_ids, size_t *out_n, bool *out_residual,
+                              uint64_t *out_keys, gerror_t *error);
+
+/* $near on a geo index as the filter's access path: the ring search
+ * (*out_near, caller frees) and the filter without the $near field
+ * (*out_rest, NULL when nothing is left; caller destroys). Returns 1,
+ * 0 if the filter has no such path, or a negative error code. */
+int _mongolite_index_seek_near(mongolite_db_t *db, mongolite_tree_cache_entry_t *entry,
+                               const bson_t *filter, mongolite_geo_near_t **out_near,
+                               bson_t **out_rest, gerror_t *error);
+
+/* Describe the seek plan of a filter for mongolite_explain: the access
+ * stage (when the filter has one) and one document per index of the
+ * collection, considered or rejected. Returns true if stage was filled. */
+bool _mongolite_index_explain(mongolite_db_t *db, mongolite_tree_cache_entry_t *entry,
+                              const bson_t *filter, bson_t *stage, bson_t *candidates,
+                              gerror_t *error);
 
 /* Use index to find documents matching a simple equality query */
 bson_t* _find_one_with_index(mongolite_db_t *db, const char *collection,
@@ -316,6 +702,32 @@ bson_t* _find_one_with_index(mongolite_db_t *db, const char *collection,
                               mongolite_cached_index_t *index,
                               const bson_t *filter, gerror_t *error);
 
+/* ============================================================
+ * Index Statistics (mongolite_analyze.c)
+ *
+ * Built by walking an index's distinct keys (mdb_cursor_count gives the
+ * duplicates, no document is read) and kept with the index metadata.
+ * ============================================================ */
+
+/* Parse persisted statistics; NULL if malformed */
+mongolite_index_hist_t* _mongolite_hist_parse(const void *data, size_t len);
+void _mongolite_hist_free(mongolite_index_hist_t *hist);
+
+/* Estimated index entries for one key ({field: value, ...} as stored in
+ * the index), or per key on average when key is NULL */
+double _mongolite_index_estimate(const mongolite_cached_index_t *index, const bson_t *key);
+
+/* Analyze and persist the indexes of a collection (index_name NULL = all)
+ * IMPORTANT: Caller must hold the database lock and no write session. */
+int _mongolite_analyze_locked(mongolite_db_t *db, mongolite_tree_cache_entry_t *entry,
+                              const char *index_name, gerror_t *error);
+
+/* After a commit: rebuild and persist the statistics of indexes that grew
+ * or shrank past their analyzed size, once enough has been written since
+ * the last check. Skipped while a session is open.
+ * IMPORTANT: Caller must hold the database lock. */
+void _mongolite_analyze_committed(mongolite_db_t *db);
+
 /* ============================================================
  * Internal Collection Operations
  * ============================================================ */
@@ -324,6 +736,467 @@ bson_t* _find_one_with_index(mongolite_db_t *db, const char *collection,
 wtree3_tree_t* _mongolite_get_collection_tree(mongolite_db_t *db, const char *name,
                                                gerror_t *error);
 
+/* Get or open a collection's cache entry (uses cache) */
+mongolite_tree_cache_entry_t* _mongolite_get_collection_entry(mongolite_db_t *db,
+                                                              const char *name,
+                                                              gerror_t *error);
+
+/* Open every collection into the cache, unless none was created or
+ * dropped since the last call. Lock held. */
+int _mongolite_open_all_collections(mongolite_db_t *db, gerror_t *error);
+
+/* Resolve a prepared collection handle to its cache entry.
+ * IMPORTANT: Caller must already hold the database lock. */
+mongolite_tree_cache_entry_t* _mongolite_collection_resolve(mongolite_collection_t *col,
+                                                            gerror_t *error);
+
+/* Operation cores shared by the name-based and handle-based APIs.
+ * IMPORTANT: Caller must already hold the database lock. */
+bson_t* _mongolite_find_one_entry(mongolite_db_t *db, mongolite_tree_cache_entry_t *entry,
+                                   const bson_t *filter, const bson_t *projection,
+                                   gerror_t *error);
+mongolite_cursor_t* _mongolite_find_entry(mongolite_db_t *db,
+                                           mongolite_tree_cache_entry_t *entry,
+                                           const bson_t *filter, const bson_t *projection,
+                                           gerror_t *error);
+/* Same, with the plan already chosen (_mongolite_plan_query) */
+mongolite_cursor_t* _mongolite_find_entry_planned(mongolite_db_t *db,
+                                                   mongolite_tree_cache_entry_t *entry,
+                                                   const bson_t *filter,
+                                                   const bson_t *projection,
+                                                   mongolite_plan_type_t plan,
+                                                   gerror_t *error);
+int _mongolite_insert_one_entry(mongolite_db_t *db, mongolite_tree_cache_entry_t *entry,
+                                 const bson_t *doc, bson_oid_t *inserted_id,
+                                 gerror_t *error);
+
+/* ============================================================
+ * Statistics (mongolite_stats.c)
+ *
+ * Each thread is pinned to one shard on first use, so concurrent
+ * threads mostly touch distinct cache lines; updates are relaxed
+ * atomic adds and mongolite_stats() sums the shards. Every helper is
+ * a no-op when the database was opened with disable_stats.
+ * ============================================================ */
+
+#define MONGOLITE_STATS_SHARDS 16
+
+int _mongolite_stats_init(mongolite_db_t *db, bool enabled);
+void _mongolite_stats_free(mongolite_db_t *db);
+
+/* Calling thread's shard, or NULL when statistics are disabled */
+mongolite_stats_t* _mongolite_stats_shard(mongolite_db_t *db);
+
+/* Add n to a database-wide counter: MONGOLITE_STAT(db, read_txn_renews, 1) */
+#define MONGOLITE_STAT(db, field, n) do { \
+    mongolite_stats_t *_shard = _mongolite_stats_shard(db); \
+    if (_shard) MONGOLITE_ATOMIC_ADD(&_shard->field, (uint64_t)(n)); \
+} while (0)
+
+/* Monotonic clock in nanoseconds */
+uint64_t _mongolite_now_ns(void);
+
+/* Latency timing: start returns 0 when disabled, record ignores 0 */
+uint64_t _mongolite_stats_start(mongolite_db_t *db);
+void _mongolite_stats_record(mongolite_db_t *db, mongolite_op_t op, uint64_t start_ns);
+
+/* Counter shards of a new cache entry (NULL when statistics are
+ * disabled); sets *rc to MONGOLITE_ENOMEM on allocation failure */
+mongolite_op_stats_shard_t* _mongolite_collection_stats_alloc(mongolite_db_t *db, int *rc);
+
+/* Per-collection counters of an open collection (NULL if not cached).
+ * IMPORTANT: Caller must already hold the database lock. */
+mongolite_op_stats_shard_t* _mongolite_collection_stats_lookup(mongolite_db_t *db,
+                                                              const char *name);
+
+/* Attribute a query's access path / document counts to the database
+ * totals and (if non-NULL) a collection: both in the calling thread's
+ * shard */
+void _mongolite_stats_query(mongolite_db_t *db, mongolite_op_stats_shard_t *col,
+                            mongolite_plan_type_t plan);
+void _mongolite_stats_docs(mongolite_db_t *db, mongolite_op_stats_shard_t *col,
+                           uint64_t scanned, uint64_t returned, uint64_t evals);
+
+/* Latency timing that also opens a slow-log trace of a filtered call */
+uint64_t _mongolite_stats_start_query(mongolite_db_t *db, const char *collection,
+                                      const bson_t *filter);
+
+/* ============================================================
+ * Slow-Operation Log (mongolite_slowlog.c)
+ *
+ * _mongolite_stats_start_query opens a trace on the calling thread; the
+ * plan and document counters, index seeks and lock waits add to it as
+ * they are counted, and _mongolite_stats_record closes it and queues
+ * the entry if it qualifies. With the log off every hook is a single
+ * untaken branch on db->slowlog.
+ * ============================================================ */
+
+typedef struct {
+    bool active;                        /* Between begin and end */
+    uint64_t start_ns;                  /* Identifies the call (a failed one never ends) */
+    bool planned;
+    mongolite_plan_type_t plan;
+    const char *collection;
+    const bson_t *filter;
+    uint64_t keys_examined;
+    uint64_t docs_examined;
+    uint64_t docs_returned;
+    uint64_t lock_wait_ns;
+} mongolite_op_trace_t;
+
+extern MONGOLITE_THREAD_LOCAL mongolite_op_trace_t _mongolite_trace;
+
+/* Add n to a counter of the calling thread's trace */
+#define MONGOLITE_TRACE(db, field, n) do { \
+    if (MONGOLITE_UNLIKELY((db)->slowlog != NULL)) _mongolite_trace.field += (n); \
+} while (0)
+
+int _mongolite_slowlog_init(mongolite_db_t *db, const db_config_t *config);
+void _mongolite_slowlog_free(mongolite_db_t *db);
+
+void _mongolite_slowlog_begin(const char *collection, const bson_t *filter, uint64_t start_ns);
+void _mongolite_slowlog_end(mongolite_db_t *db, mongolite_op_t op, uint64_t start_ns,
+                            uint64_t elapsed_ns);
+
+/* find: move the open trace into the cursor (before _mongolite_stats_record);
+ * cursor_next time is added and the entry is queued at destroy */
+void _mongolite_slowlog_defer(mongolite_cursor_t *cursor, uint64_t start_ns);
+void _mongolite_slowlog_cursor_end(mongolite_cursor_t *cursor);
+
+/* ============================================================
+ * Sessions (mongolite_session.c)
+ *
+ * A session owns one wtree3 transaction and is bound to the thread that
+ * began it. The txn helpers in mongolite_txn.c route that thread's
+ * operations into it; other threads keep auto-commit behavior.
+ * ============================================================ */
+
+struct mongolite_session {
+    mongolite_db_t *db;
+    wtree3_txn_t *txn;
+    bool write;                         /* Write session (else read snapshot) */
+    bool group;                         /* Group commit batch (writes nest) */
+    wtree3_txn_t *nested;               /* Group: the current write's child txn */
+};
+
+/* Session bound to the calling thread for db, or NULL. Lock held. */
+mongolite_session_t* _mongolite_session_current(mongolite_db_t *db);
+
+/* True if the calling thread has a session on any database */
+bool _mongolite_session_bound(void);
+
+/* Transaction of the calling thread's session, or NULL. Lock held.
+ * For a group session this is the open nested txn, if any. */
+wtree3_txn_t* _mongolite_session_txn(mongolite_db_t *db);
+
+/* Group session: the batch txn of a group commit leader. Every write
+ * inside runs in a nested txn, so a failing write only rolls back
+ * itself. Begin waits for a write session as other writers do. Lock held. */
+mongolite_session_t* _mongolite_session_begin_group(mongolite_db_t *db, gerror_t *error);
+int _mongolite_session_end_group(mongolite_session_t *session, bool commit,
+                                 gerror_t *error);
+
+/* Nested txn for a write in a group session (reused until ended) */
+wtree3_txn_t* _mongolite_session_nested_txn(mongolite_session_t *session, gerror_t *error);
+int _mongolite_session_end_nested(mongolite_session_t *session, bool commit,
+                                  gerror_t *error);
+
+/* Wait, lock released meanwhile, until no write session is open: writes,
+ * schema changes and collection opens need their own LMDB write txn.
+ * MONGOLITE_EBUSY after busy_timeout_ms, or at once when the session is
+ * the calling thread's own. Lock held. */
+int _mongolite_require_no_write_session(mongolite_db_t *db, gerror_t *error);
+
+/* Abort the calling thread's session on db, if any (used by close) */
+void _mongolite_session_end_current(mongolite_db_t *db);
+
+/* ============================================================
+ * Group Commit (mongolite_group.c)
+ *
+ * Auto-commit writers enqueue their operation; the first one in becomes
+ * leader, holds the db lock and applies the queue in one group session,
+ * then commits once and wakes the others. Writers that arrive meanwhile
+ * form the next batch.
+ * ============================================================ */
+
+/* A queued write: fn runs on the leader thread with the db lock held
+ * (its own _mongolite_lock calls nest) */
+typedef int (*mongolite_group_fn)(mongolite_db_t *db, void *arg, gerror_t *error);
+
+int _mongolite_group_init(mongolite_db_t *db, const db_config_t *config);
+void _mongolite_group_free(mongolite_db_t *db);
+
+/* Should this write go through the queue? (enabled, no session on this thread) */
+static inline bool _mongolite_group_enabled(mongolite_db_t *db) {
+    return db && db->group && !_mongolite_session_bound();
+}
+
+/* Enqueue fn and wait until its batch is durable. Returns fn's result,
+ * or the batch commit error. collection is opened before the batch. */
+int _mongolite_group_submit(mongolite_db_t *db, const char *collection,
+                            mongolite_group_fn fn, void *arg, gerror_t *error);
+
+/* ============================================================
+ * Change Feed (mongolite_changes.c)
+ *
+ * Writers record each changed document in their own transaction, after
+ * the collection write succeeded and before the commit; the entry is
+ * rolled back with the write. Callers check db->change_feed first.
+ * ============================================================ */
+
+typedef enum {
+    MONGOLITE_CHANGE_INSERT,
+    MONGOLITE_CHANGE_UPDATE,
+    MONGOLITE_CHANGE_REPLACE,
+    MONGOLITE_CHANGE_DELETE
+} mongolite_change_op_t;
+
+/* Open the feed tree when db_config_t.change_feed is set (sets error) */
+int _mongolite_change_feed_init(mongolite_db_t *db, const db_config_t *config,
+                                gerror_t *error);
+void _mongolite_change_feed_free(mongolite_db_t *db);
+
+/* Close / reopen the tree handle around an environment swap (compaction) */
+void _mongolite_change_feed_detach(mongolite_db_t *db);
+int _mongolite_change_feed_attach(mongolite_db_t *db, gerror_t *error);
+
+/* Record a change to the document stored under oid in tree. doc is the
+ * document as written; NULL reads it back from txn (an update that
+ * matched nothing then records nothing). For a delete, doc only supplies
+ * the _id. Returns a wtree3 code, so MAP_FULL retries as the write does. */
+int _mongolite_change_log(mongolite_db_t *db, wtree3_txn_t *txn, mongolite_change_op_t op,
+                          const char *collection, wtree3_tree_t *tree,
+                          const bson_oid_t *oid, const bson_t *doc, gerror_t *error);
+
+/* After a successful commit: wake waiting streams */
+void _mongolite_change_feed_committed(mongolite_db_t *db);
+
+/* ============================================================
+ * Durability (mongolite_durability.c)
+ *
+ * Commit ids are LMDB transaction ids. The durable id only advances
+ * after a forced sync that started once the commit was written.
+ * ============================================================ */
+
+/* LMDB flags implied by a durability level (added to lmdb_flags at open) */
+unsigned int _mongolite_durability_env_flags(const db_config_t *config);
+
+/* Set up sync tracking; starts the flusher thread for ASYNC */
+int _mongolite_durability_init(mongolite_db_t *db, const db_config_t *config);
+/* Stop the flusher and sync unless every commit was already synced */
+void _mongolite_durability_close(mongolite_db_t *db);
+
+/* Stop the flusher thread and sync, keeping the sync state (compaction
+ * closes the environment under it); start runs it again for ASYNC */
+void _mongolite_durability_stop(mongolite_db_t *db);
+int _mongolite_durability_start(mongolite_db_t *db);
+
+/* Forced sync; advances the durable id to the commit id read before it */
+int _mongolite_durability_sync(mongolite_db_t *db, gerror_t *error);
+
+/* After a successful commit: wake the flusher early past sync_bytes */
+void _mongolite_durability_committed(mongolite_db_t *db);
+
+/* The environment was replaced (compaction): what it holds is on disk and
+ * commit ids restart. Caller holds the db lock, not the env lock. */
+void _mongolite_durability_reset(mongolite_db_t *db);
+
+/* Serializes env calls that read the map (commit ids, syncs) made outside
+ * the db lock against a resize remapping it */
+void _mongolite_env_lock(mongolite_db_t *db);
+void _mongolite_env_unlock(mongolite_db_t *db);
+
+/* ============================================================
+ * Map Growth (mongolite_map.c)
+ *
+ * The map can only change size with no transaction open in the process:
+ * growth runs under the db lock with no session and no cursor-owned
+ * read txn open, else it waits for the next safe point.
+ * ============================================================ */
+
+/* Resolve the growth policy from config (after the environment is open) */
+void _mongolite_map_init(mongolite_db_t *db, const db_config_t *config);
+
+/* A write failed with MAP_FULL: grow by policy so it can be retried */
+int _mongolite_try_resize(mongolite_db_t *db, gerror_t *error);
+
+/* After a successful commit: grow ahead of use past grow_at_percent */
+void _mongolite_map_committed(mongolite_db_t *db);
+
+/* Before a write of about need_bytes: grow now if it would not fit */
+void _mongolite_map_reserve(mongolite_db_t *db, size_t need_bytes);
+
+/* ============================================================
+ * Parallel Scan (mongolite_scan.c)
+ *
+ * Large filtered scans split the _id key space into ranges that worker
+ * threads match in their own read txns. Start with the db lock held:
+ * the workers' snapshots are taken before it returns, so the caller may
+ * unlock and collect results afterwards.
+ * ============================================================ */
+
+typedef enum {
+    MONGOLITE_SCAN_COUNT,               /* Count matches only */
+    MONGOLITE_SCAN_KEYS,                /* Matching _id keys */
+    MONGOLITE_SCAN_DOCS                 /* Matching documents */
+} mongolite_scan_mode_t;
+
+/* Worth scanning in parallel? (enabled, filtered, no session, large) */
+bool _mongolite_scan_eligible(mongolite_db_t *db, wtree3_tree_t *tree, const bson_t *filter);
+
+/* NULL on error (bad filter, no threads): fall back to a serial scan
+ * unless error->code is MONGOLITE_EQUERY */
+mongolite_scan_t* _mongolite_scan_start(mongolite_db_t *db, wtree3_tree_t *tree,
+                                        const bson_t *filter, mongolite_scan_mode_t mode,
+                                        gerror_t *error);
+
+/* KEYS / DOCS: results in key order (default) or as ranges finish */
+void _mongolite_scan_set_ordered(mongolite_scan_t *scan, bool ordered);
+
+/* KEYS / DOCS: next result, valid until the next call. Returns 1, 0 at
+ * the end, or an error code. */
+int _mongolite_scan_next(mongolite_scan_t *scan, const void **data, size_t *len);
+
+/* COUNT: wait for every range and sum the matches */
+int _mongolite_scan_finish(mongolite_scan_t *scan, uint64_t *matched);
+
+/* Documents read so far (for statistics) */
+uint64_t _mongolite_scan_scanned(mongolite_scan_t *scan);
+
+/* Stops the workers if still running */
+void _mongolite_scan_free(mongolite_scan_t *scan);
+
+/* ============================================================
+ * Readahead (mongolite_readahead.c)
+ *
+ * Scans hint the kernel a window ahead of the cursor's position in the
+ * map; index plans resolve a batch of _ids and hint their documents
+ * before reading them. On a cold cache the page faults overlap instead
+ * of stalling one at a time. Hints never fail a query.
+ * ============================================================ */
+
+/* Off unless txn is read-only: a write txn's results may sit in its own
+ * dirty pages rather than the map */
+void _mongolite_readahead_init(mongolite_db_t *db, wtree3_txn_t *txn,
+                               mongolite_readahead_t *ra);
+
+/* Scans: ptr is the value just read; hints the next window when needed */
+void _mongolite_readahead_seq(mongolite_readahead_t *ra, const void *ptr);
+
+/* Look up n 12-byte _ids into out[n] (data NULL = no such document),
+ * sorted through one cursor, then hint the documents that live on their
+ * own pages. Valid while txn is open. */
+int _mongolite_fetch_batch(mongolite_readahead_t *ra, wtree3_txn_t *txn,
+                           wtree3_tree_t *tree, const void *const *ids, size_t n,
+                           mongolite_fetch_t *out, gerror_t *error);
+
+/* ============================================================
+ * Text Indexes (mongolite_text.c)
+ *
+ * A text index is a multi-key wtree3 index with one {_fts: <term>}
+ * key per distinct term of a document; $text searches intersect the
+ * terms' posting lists (mongolite_query_index.c).
+ * ============================================================ */
+
+#define MONGOLITE_TEXT_FIELD    "_fts"
+#define MONGOLITE_TEXT_MAX_TERM 128     /* Bytes kept of a longer term */
+
+typedef struct {
+    const char *p;                      /* Into the arena (after finish) */
+    size_t off;
+    uint32_t len;
+} mongolite_text_term_t;
+
+typedef struct {
+    char *arena;
+    size_t used, arena_cap;
+    mongolite_text_term_t *terms;
+    size_t n, cap;
+#ifdef WITH_STEMMER
+    struct sb_stemmer *stemmer;
+#endif
+} mongolite_text_terms_t;
+
+void _mongolite_text_terms_init(mongolite_text_terms_t *t);
+/* Tokenize one string into t; false on allocation failure */
+bool _mongolite_text_terms_add(mongolite_text_terms_t *t, const char *text, size_t len);
+/* Sort and deduplicate; terms[i].p is valid until free */
+void _mongolite_text_terms_finish(mongolite_text_terms_t *t);
+void _mongolite_text_terms_free(mongolite_text_terms_t *t);
+
+/* The index key of a term (caller destroys) */
+void _mongolite_text_key(const mongolite_text_term_t *term, bson_t *key);
+
+/* Every key value is "text" / some key value is */
+bool _mongolite_text_spec(const bson_t *keys);
+bool _mongolite_text_mentioned(const bson_t *keys);
+
+/* Multi-key extractor body for a text spec (false: no terms) */
+bool _mongolite_text_extractor(const void *value, size_t value_len,
+                               const bson_t *keys, void **out_key, size_t *out_len);
+
+/* The $search string of a {$text: {...}} value; false if malformed or
+ * asking for a language or stop characters the index was not built with */
+bool _mongolite_text_search(const bson_iter_t *iter, const char **search, uint32_t *len);
+
+/* A copy of filter without its $text predicate, NULL if it has none */
+bson_t* _mongolite_text_strip(const bson_t *filter);
+
+/* Set EQUERY if filter has $text, which no index plan answered */
+bool _mongolite_text_unindexed(const bson_t *filter, gerror_t *error);
+
+/* ============================================================
+ * Geospatial Indexes (mongolite_geo.c)
+ *
+ * A geo index is a multi-key wtree3 index with one {_geo: <cell>,
+ * x: <x>, y: <y>} key per document holding a point; the cell is the
+ * Z-order interleave of x and y quantized to 31 bits each.
+ * ============================================================ */
+
+#define MONGOLITE_GEO_FIELD     "_geo"
+
+/* A $geoWithin or $near predicate on one field */
+typedef struct {
+    const char *field;                  /* Into the filter (NULL = none) */
+    bool near;                          /* $near, else $geoWithin */
+    bool sphere;                        /* $geometry: meters on the sphere */
+    double box[4];                      /* $geoWithin bounds: x1, y1, x2, y2 */
+    double x, y;                        /* $near center */
+    double min_d, max_d;                /* $near bounds (max_d INFINITY = none) */
+} mongolite_geo_query_t;
+
+uint64_t _mongolite_geo_cell(double x, double y);
+
+/* The index key of a point (caller destroys) */
+void _mongolite_geo_key(double x, double y, bson_t *key);
+
+/* The field of a single-field "2dsphere"/"2d" spec, NULL otherwise /
+ * whether some key value is "2dsphere" or "2d" */
+const char* _mongolite_geo_spec(const bson_t *keys);
+bool _mongolite_geo_mentioned(const bson_t *keys);
+
+/* Multi-key extractor body for a geo spec (false: no point) */
+bool _mongolite_geo_extractor(const void *value, size_t value_len, const char *field,
+                              void **out_key, size_t *out_len);
+
+/* Parse field's value as {$geoWithin: {$box | $polygon}} or {$near: ...};
+ * false for anything else */
+bool _mongolite_geo_parse(const bson_iter_t *iter, const char *field,
+                          mongolite_geo_query_t *out);
+
+/* The _ids of the points in a $geoWithin's bounding box, in key order
+ * (one per document; caller frees). Returns 1, 0 (not a geo index) or an
+ * error code. */
+int _mongolite_geo_within(MDB_txn *txn, MDB_dbi dbi, const mongolite_geo_query_t *q,
+                          bson_oid_t **out, size_t *out_n, uint64_t *keys_examined);
+
+/* $near: each call returns the next ring's _ids, nearest first (caller
+ * frees). Returns 1, 0 when exhausted, or an error code. */
+mongolite_geo_near_t* _mongolite_geo_near_new(MDB_dbi dbi, const mongolite_geo_query_t *q);
+int _mongolite_geo_near_next(mongolite_geo_near_t *near, MDB_txn *txn,
+                             bson_oid_t **out, size_t *out_n, uint64_t *keys_examined);
+void _mongolite_geo_near_free(mongolite_geo_near_t *near);
+
 /* ============================================================
  * Internal Cursor Operations
  * ============================================================ */
@@ -341,6 +1214,16 @@ mongolite_cursor_t* _mongolite_cursor_create_with_txn(mongolite_db_t *db,
                                                        const bson_t *filter,
                                                        gerror_t *error);
 
+/* Serve the cursor from batched lookups of ids (sorted, deduplicated;
+ * the cursor takes ownership) instead of iterating the collection */
+void _mongolite_cursor_set_ids(mongolite_cursor_t *cursor, wtree3_tree_t *tree,
+                               bson_oid_t *ids, size_t n_ids);
+
+/* Serve the cursor from a $near search's rings, nearest first (the
+ * cursor takes ownership) */
+void _mongolite_cursor_set_near(mongolite_cursor_t *cursor, wtree3_tree_t *tree,
+                                mongolite_geo_near_t *near);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,1113 @@
+/*
+ * mongolite_json.c - Streaming JSON output
+ *
+ * Handles:
+ * - Extended JSON v2 encoding (relaxed / canonical) into a growable buffer
+ * - Writing a cursor's documents to a sink as a JSON array or JSON lines
+ * - One-pass JSON to BSON parsing for the *_json APIs and NDJSON ingest
+ * - Public API: mongolite_cursor_write_json, mongolite_cursor_write_json_fd
+ *
+ * Documents are encoded straight from their BSON into one buffer that is
+ * handed to the sink once it holds chunk_bytes and then reused, so memory
+ * stays at about one chunk plus the largest document whatever the result
+ * size. Output is compact (no spaces) and parses back with libbson.
+ */
+
+#include "mongolite_internal.h"
+#include "macros.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <errno.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#define MONGOLITE_LIB "mongolite"
+
+#define MONGOLITE_JSON_DEFAULT_CHUNK (64 * 1024)
+
+/* ============================================================
+ * Buffer
+ * ============================================================ */
+
+typedef struct {
+    char *data;
+    size_t len;
+    size_t cap;
+    bool failed;                        /* An allocation failed: output is incomplete */
+} json_buf_t;
+
+static bool _buf_reserve(json_buf_t *buf, size_t extra) {
+    if (MONGOLITE_LIKELY(buf->len + extra <= buf->cap)) return true;
+    if (buf->failed) return false;
+
+    size_t cap = buf->cap ? buf->cap : 256;
+    while (cap < buf->len + extra) cap *= 2;
+    char *data = realloc(buf->data, cap);
+    if (!data) {
+        buf->failed = true;
+        return false;
+    }
+    buf->data = data;
+    buf->cap = cap;
+    return true;
+}
+
+static void _buf_append(json_buf_t *buf, const char *s, size_t n) {
+    if (!_buf_reserve(buf, n)) return;
+    memcpy(buf->data + buf->len, s, n);
+    buf->len += n;
+}
+
+#define _buf_literal(buf, s) _buf_append((buf), (s), sizeof(s) - 1)
+
+static void _buf_char(json_buf_t *buf, char c) {
+    if (!_buf_reserve(buf, 1)) return;
+    buf->data[buf->len++] = c;
+}
+
+static void _buf_printf(json_buf_t *buf, const char *fmt, ...) BSON_GNUC_PRINTF(2, 3);
+
+static void _buf_printf(json_buf_t *buf, const char *fmt, ...) {
+    /* Callers print numbers: 64 bytes is always enough */
+    if (!_buf_reserve(buf, 64)) return;
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(buf->data + buf->len, 64, fmt, ap);
+    va_end(ap);
+    if (n > 0) buf->len += (size_t)(n < 64 ? n : 63);
+}
+
+/* ============================================================
+ * Encoding
+ * ============================================================ */
+
+static void _json_string(json_buf_t *buf, const char *s, size_t n) {
+    static const char hex[] = "0123456789abcdef";
+
+    /* Worst case every byte becomes \u00XX */
+    if (!_buf_reserve(buf, n * 6 + 2)) return;
+    char *out = buf->data + buf->len;
+    *out++ = '"';
+
+    const char *run = s;
+    for (size_t i = 0; i < n; i++) {
+        unsigned char c = (unsigned char)s[i];
+        if (MONGOLITE_LIKELY(c >= 0x20 && c != '"' && c != '\\')) continue;
+
+        size_t plain = (size_t)(s + i - run);
+        memcpy(out, run, plain);
+        out += plain;
+        run = s + i + 1;
+
+        *out++ = '\\';
+        switch (c) {
+            case '"':  *out++ = '"';  break;
+            case '\\': *out++ = '\\'; break;
+            case '\b': *out++ = 'b';  break;
+            case '\f': *out++ = 'f';  break;
+            case '\n': *out++ = 'n';  break;
+            case '\r': *out++ = 'r';  break;
+            case '\t': *out++ = 't';  break;
+            default:
+                *out++ = 'u';
+                *out++ = '0';
+                *out++ = '0';
+                *out++ = hex[c >> 4];
+                *out++ = hex[c & 0xf];
+                break;
+        }
+    }
+    size_t plain = (size_t)(s + n - run);
+    memcpy(out, run, plain);
+    out += plain;
+
+    *out++ = '"';
+    buf->len = (size_t)(out - buf->data);
+}
+
+static void _json_cstring(json_buf_t *buf, const char *s) {
+    _json_string(buf, s, strlen(s));
+}
+
+static void _json_base64(json_buf_t *buf, const uint8_t *data, uint32_t n) {
+    static const char alphabet[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    if (!_buf_reserve(buf, ((size_t)n + 2) / 3 * 4 + 2)) return;
+    char *out = buf->data + buf->len;
+    *out++ = '"';
+    uint32_t i = 0;
+    for (; i + 2 < n; i += 3) {
+        uint32_t v = ((uint32_t)data[i] << 16) | ((uint32_t)data[i + 1] << 8) | data[i + 2];
+        *out++ = alphabet[(v >> 18) & 63];
+        *out++ = alphabet[(v >> 12) & 63];
+        *out++ = alphabet[(v >> 6) & 63];
+        *out++ = alphabet[v & 63];
+    }
+    if (i < n) {
+        uint32_t v = (uint32_t)data[i] << 16;
+        if (i + 1 < n) v |= (uint32_t)data[i + 1] << 8;
+        *out++ = alphabet[(v >> 18) & 63];
+        *out++ = alphabet[(v >> 12) & 63];
+        *out++ = i + 1 < n ? alphabet[(v >> 6) & 63] : '=';
+        *out++ = '=';
+    }
+    *out++ = '"';
+    buf->len = (size_t)(out - buf->data);
+}
+
+static void _json_oid(json_buf_t *buf, const bson_oid_t *oid) {
+    char hex[25];
+    bson_oid_to_string(oid, hex);
+    _buf_literal(buf, "{\"$oid\":\"");
+    _buf_append(buf, hex, 24);
+    _buf_literal(buf, "\"}");
+}
+
+static void _json_double(json_buf_t *buf, double v, bool canonical) {
+    const char *special = isnan(v) ? "NaN" : isinf(v) ? (v > 0 ? "Infinity" : "-Infinity") : NULL;
+    if (!canonical && !special) {
+        size_t start = buf->len;
+        _buf_printf(buf, "%.17g", v);
+        /* Keep 3.0 a double when read back */
+        if (buf->len > start &&
+            strspn(buf->data + start, "0123456789-") == buf->len - start) {
+            _buf_literal(buf, ".0");
+        }
+        return;
+    }
+
+    _buf_literal(buf, "{\"$numberDouble\":\"");
+    if (special) {
+        _buf_append(buf, special, strlen(special));
+    } else if (v == 0.0 && signbit(v)) {
+        _buf_literal(buf, "-0.0");
+    } else {
+        size_t start = buf->len;
+        _buf_printf(buf, "%.17g", v);
+        if (buf->len > start &&
+            strspn(buf->data + start, "0123456789-") == buf->len - start) {
+            _buf_literal(buf, ".0");
+        }
+    }
+    _buf_literal(buf, "\"}");
+}
+
+/* Relaxed dates in years 1970-9999 print as ISO-8601, the rest as numbers */
+static void _json_date(json_buf_t *buf, int64_t ms, bool canonical) {
+    if (!canonical && ms >= 0 && ms <= INT64_C(253402300799999)) {
+        time_t secs = (time_t)(ms / 1000);
+        struct tm tm;
+#ifdef _WIN32
+        gmtime_s(&tm, &secs);
+#else
+        gmtime_r(&secs, &tm);
+#endif
+        char iso[32];
+        size_t n = strftime(iso, sizeof(iso), "%Y-%m-%dT%H:%M:%S", &tm);
+        _buf_literal(buf, "{\"$date\":\"");
+        _buf_append(buf, iso, n);
+        if (ms % 1000) _buf_printf(buf, ".%03d", (int)(ms % 1000));
+        _buf_literal(buf, "Z\"}");
+        return;
+    }
+    _buf_literal(buf, "{\"$date\":{\"$numberLong\":\"");
+    _buf_printf(buf, "%" PRId64, ms);
+    _buf_literal(buf, "\"}}");
+}
+
+static void _json_document(json_buf_t *buf, const bson_t *doc, bool array, bool canonical);
+
+static void _json_value(json_buf_t *buf, const bson_iter_t *iter, bool canonical) {
+    switch (bson_iter_type(iter)) {
+        case BSON_TYPE_DOUBLE:
+            _json_double(buf, bson_iter_double(iter), canonical);
+            break;
+
+        case BSON_TYPE_UTF8: {
+            uint32_t len;
+            const char *s = bson_iter_utf8(iter, &len);
+            _json_string(buf, s, len);
+            break;
+        }
+
+        case BSON_TYPE_DOCUMENT:
+        case BSON_TYPE_ARRAY: {
+            uint32_t len;
+            const uint8_t *data;
+            bson_t child;
+            if (BSON_ITER_HOLDS_ARRAY(iter)) {
+                bson_iter_array(iter, &len, &data);
+            } else {
+                bson_iter_document(iter, &len, &data);
+            }
+            if (bson_init_static(&child, data, len)) {
+                _json_document(buf, &child, BSON_ITER_HOLDS_ARRAY(iter), canonical);
+            } else {
+                _buf_literal(buf, "null");
+            }
+            break;
+        }
+
+        case BSON_TYPE_BINARY: {
+            bson_subtype_t subtype;
+            uint32_t len;
+            const uint8_t *data;
+            bson_iter_binary(iter, &subtype, &len, &data);
+            _buf_literal(buf, "{\"$binary\":{\"base64\":");
+            _json_base64(buf, data, len);
+            _buf_printf(buf, ",\"subType\":\"%02x\"}}", (unsigned)subtype);
+            break;
+        }
+
+        case BSON_TYPE_UNDEFINED:
+            _buf_literal(buf, "{\"$undefined\":true}");
+            break;
+
+        case BSON_TYPE_OID:
+            _json_oid(buf, bson_iter_oid(iter));
+            break;
+
+        case BSON_TYPE_BOOL:
+            if (bson_iter_bool(iter)) {
+                _buf_literal(buf, "true");
+            } else {
+                _buf_literal(buf, "false");
+            }
+            break;
+
+        case BSON_TYPE_DATE_TIME:
+            _json_date(buf, bson_iter_date_time(iter), canonical);
+            break;
+
+        case BSON_TYPE_NULL:
+            _buf_literal(buf, "null");
+            break;
+
+        case BSON_TYPE_REGEX: {
+            const char *options;
+            const char *pattern = bson_iter_regex(iter, &options);
+            _buf_literal(buf, "{\"$regularExpression\":{\"pattern\":");
+            _json_cstring(buf, pattern);
+            _buf_literal(buf, ",\"options\":");
+            _json_cstring(buf, options ? options : "");
+            _buf_literal(buf, "}}");
+            break;
+        }
+
+        case BSON_TYPE_DBPOINTER: {
+            uint32_t len;
+            const char *collection;
+            const bson_oid_t *oid;
+            bson_iter_dbpointer(iter, &len, &collection, &oid);
+            _buf_literal(buf, "{\"$dbPointer\":{\"$ref\":");
+            _json_string(buf, collection, len);
+            _buf_literal(buf, ",\"$id\":");
+            _json_oid(buf, oid);
+            _buf_literal(buf, "}}");
+            break;
+        }
+
+        case BSON_TYPE_CODE: {
+            uint32_t len;
+            const char *code = bson_iter_code(iter, &len);
+            _buf_literal(buf, "{\"$code\":");
+            _json_string(buf, code, len);
+            _buf_char(buf, '}');
+            break;
+        }
+
+        case BSON_TYPE_SYMBOL: {
+            uint32_t len;
+            const char *symbol = bson_iter_symbol(iter, &len);
+            _buf_literal(buf, "{\"$symbol\":");
+            _json_string(buf, symbol, len);
+            _buf_char(buf, '}');
+            break;
+        }
+
+        case BSON_TYPE_CODEWSCOPE: {
+            uint32_t len, scope_len;
+            const uint8_t *scope_data;
+            const char *code = bson_iter_codewscope(iter, &len, &scope_len, &scope_data);
+            bson_t scope;
+            _buf_literal(buf, "{\"$code\":");
+            _json_string(buf, code, len);
+            _buf_literal(buf, ",\"$scope\":");
+            if (bson_init_static(&scope, scope_data, scope_len)) {
+                _json_document(buf, &scope, false, canonical);
+            } else {
+                _buf_literal(buf, "{}");
+            }
+            _buf_char(buf, '}');
+            break;
+        }
+
+        case BSON_TYPE_INT32:
+            if (canonical) {
+                _buf_printf(buf, "{\"$numberInt\":\"%" PRId32 "\"}", bson_iter_int32(iter));
+            } else {
+                _buf_printf(buf, "%" PRId32, bson_iter_int32(iter));
+            }
+            break;
+
+        case BSON_TYPE_TIMESTAMP: {
+            uint32_t t, i;
+            bson_iter_timestamp(iter, &t, &i);
+            _buf_printf(buf, "{\"$timestamp\":{\"t\":%u,\"i\":%u}}", t, i);
+            break;
+        }
+
+        case BSON_TYPE_INT64:
+            if (canonical) {
+                _buf_printf(buf, "{\"$numberLong\":\"%" PRId64 "\"}", bson_iter_int64(iter));
+            } else {
+                _buf_printf(buf, "%" PRId64, bson_iter_int64(iter));
+            }
+            break;
+
+        case BSON_TYPE_DECIMAL128: {
+            bson_decimal128_t dec;
+            char str[BSON_DECIMAL128_STRING];
+            bson_iter_decimal128(iter, &dec);
+            bson_decimal128_to_string(&dec, str);
+            _buf_literal(buf, "{\"$numberDecimal\":\"");
+            _buf_append(buf, str, strlen(str));
+            _buf_literal(buf, "\"}");
+            break;
+        }
+
+        case BSON_TYPE_MINKEY:
+            _buf_literal(buf, "{\"$minKey\":1}");
+            break;
+
+        case BSON_TYPE_MAXKEY:
+            _buf_literal(buf, "{\"$maxKey\":1}");
+            break;
+
+        default:
+            _buf_literal(buf, "null");
+            break;
+    }
+}
+
+static void _json_document(json_buf_t *buf, const bson_t *doc, bool array, bool canonical) {
+    bson_iter_t iter;
+    _buf_char(buf, array ? '[' : '{');
+    if (bson_iter_init(&iter, doc)) {
+        bool first = true;
+        while (bson_iter_next(&iter)) {
+            if (!first) _buf_char(buf, ',');
+            first = false;
+            if (!array) {
+                _json_string(buf, bson_iter_key(&iter), bson_iter_key_len(&iter));
+                _buf_char(buf, ':');
+            }
+            _json_value(buf, &iter, canonical);
+        }
+    }
+    _buf_char(buf, array ? ']' : '}');
+}
+
+/* ============================================================
+ * Cursor Output
+ * ============================================================ */
+
+typedef struct {
+    int fd;
+    int err;                            /* errno of the failed write */
+} json_fd_sink_t;
+
+static int _json_fd_sink(const char *data, size_t len, void *ctx) {
+    json_fd_sink_t *sink = ctx;
+    while (len > 0) {
+#ifdef _WIN32
+        int n = _write(sink->fd, data, len > INT_MAX ? INT_MAX : (unsigned int)len);
+#else
+        ssize_t n = write(sink->fd, data, len);
+#endif
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            sink->err = errno;
+            return -1;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+int mongolite_cursor_write_json(mongolite_cursor_t *cursor, const mongolite_json_opts_t *opts,
+                                mongolite_json_sink_fn sink, void *ctx,
+                                int64_t *n_docs, gerror_t *error) {
+    if (n_docs) *n_docs = 0;
+    if (!cursor || !sink) {
+        set_error(error, MONGOLITE_LIB, MONGOLITE_EINVAL, "Cursor and sink are required");
+        return MONGOLITE_EINVAL;
+    }
+
+    bool lines = opts && opts->format == MONGOLITE_JSON_LINES;
+    bool canonical = opts && opts->mode == MONGOLITE_JSON_CANONICAL;
+    size_t chunk = (opts && opts->chunk_bytes) ? opts->chunk_bytes : MONGOLITE_JSON_DEFAULT_CHUNK;
+
+    json_buf_t buf = {0};
+    int rc = MONGOLITE_OK;
+    int64_t count = 0;
+    if (!lines) _buf_char(&buf, '[');
+
+    const bson_t *doc;
+    while (mongolite_cursor_next(cursor, &doc)) {
+        if (!lines && count > 0) _buf_char(&buf, ',');
+        _json_document(&buf, doc, false, canonical);
+        if (lines) _buf_char(&buf, '\n');
+        count++;
+
+        if (MONGOLITE_UNLIKELY(buf.failed)) break;
+        if (buf.len >= chunk) {
+            if (sink(buf.data, buf.len, ctx) != 0) {
+                rc = MONGOLITE_ECANCELED;
+                break;
+            }
+            buf.len = 0;
+        }
+    }
+    if (rc == MONGOLITE_OK) rc = mongolite_cursor_error(cursor, error);
+    if (rc == MONGOLITE_OK && !lines) _buf_char(&buf, ']');
+
+    if (MONGOLITE_UNLIKELY(buf.failed)) {
+        rc = MONGOLITE_ENOMEM;
+        set_error(error, "system", rc, "Failed to grow JSON buffer");
+    } else if (rc == MONGOLITE_OK && buf.len > 0 && sink(buf.data, buf.len, ctx) != 0) {
+        rc = MONGOLITE_ECANCELED;
+    }
+    if (rc == MONGOLITE_ECANCELED) {
+        set_error(error, MONGOLITE_LIB, rc, "JSON sink stopped after %lld documents",
+                  (long long)count);
+    }
+
+    free(buf.data);
+    if (n_docs) *n_docs = count;
+    return rc;
+}
+
+int mongolite_cursor_write_json_fd(mongolite_cursor_t *cursor, const mongolite_json_opts_t *opts,
+                                   int fd, int64_t *n_docs, gerror_t *error) {
+    if (fd < 0) {
+        set_error(error, MONGOLITE_LIB, MONGOLITE_EINVAL, "Invalid file descriptor");
+        return MONGOLITE_EINVAL;
+    }
+
+    json_fd_sink_t sink = {fd, 0};
+    int rc = mongolite_cursor_write_json(cursor, opts, _json_fd_sink, &sink, n_docs, error);
+    if (rc == MONGOLITE_ECANCELED && sink.err) {
+        rc = MONGOLITE_EIO;
+        set_error(error, "system", rc, "JSON write failed: %s", strerror(sink.err));
+    }
+    return rc;
+}
+
+/* ============================================================
+ * Parsing
+ *
+ * One pass from JSON text to BSON appended straight into the output
+ * document: no token list, no tree, no allocation per value. Strings
+ * are scanned eight bytes at a time and, unless they hold escapes,
+ * appended from the input itself. Plain JSON and the common extended
+ * JSON wrappers ($oid, $date, $numberInt, $numberLong, $numberDouble)
+ * are handled here; any other wrapper sends the whole document to
+ * libbson's parser, so both accept the same input.
+ * ============================================================ */
+
+#define JSON_MAX_DEPTH 100
+
+typedef enum {
+    JSON_OK = 0,
+    JSON_ERROR,
+    JSON_FALLBACK                       /* Needs libbson's parser */
+} json_status_t;
+
+typedef enum {
+    EXT_NONE = 0,
+    EXT_OID,
+    EXT_INT,
+    EXT_LONG,
+    EXT_DOUBLE,
+    EXT_DATE,
+    EXT_OTHER
+} json_ext_t;
+
+typedef struct {
+    const char *p;
+    const char *end;
+    json_buf_t scratch;                 /* Strings with escapes, decoded */
+    const char *msg;
+} json_parser_t;
+
+/* A string in the input, or decoded into scratch (ptr == NULL) */
+typedef struct {
+    const char *ptr;
+    size_t off;
+    size_t len;
+} json_str_t;
+
+static inline const char* _str_ptr(const json_parser_t *ps, const json_str_t *s) {
+    return s->ptr ? s->ptr : ps->scratch.data + s->off;
+}
+
+static inline bool _str_is(const json_parser_t *ps, const json_str_t *s, const char *lit) {
+    size_t n = strlen(lit);
+    return s->len == n && memcmp(_str_ptr(ps, s), lit, n) == 0;
+}
+
+static inline char _peek(const json_parser_t *ps) {
+    return ps->p < ps->end ? *ps->p : '\0';
+}
+
+static inline void _skip_ws(json_parser_t *ps) {
+    while (ps->p < ps->end &&
+           (*ps->p == ' ' || *ps->p == '\n' || *ps->p == '\r' || *ps->p == '\t')) {
+        ps->p++;
+    }
+}
+
+static json_status_t _fail(json_parser_t *ps, const char *msg) {
+    ps->msg = msg;
+    return JSON_ERROR;
+}
+
+#define SWAR_ONES  UINT64_C(0x0101010101010101)
+#define SWAR_HIGHS UINT64_C(0x8080808080808080)
+
+/* Non-zero if any byte of v is '"', '\\' or a control character */
+static inline uint64_t _swar_special(uint64_t v) {
+    uint64_t q = v ^ (SWAR_ONES * '"');
+    uint64_t b = v ^ (SWAR_ONES * '\\');
+    return (((q - SWAR_ONES) & ~q) | ((b - SWAR_ONES) & ~b) | ((v - SWAR_ONES * 0x20) & ~v))
+           & SWAR_HIGHS;
+}
+
+static inline bool _json_special(unsigned char c) {
+    return c == '"' || c == '\\' || c < 0x20;
+}
+
+static int _hex4(const char *s) {
+    int v = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = s[i];
+        v <<= 4;
+        if (c >= '0' && c <= '9') v |= c - '0';
+        else if (c >= 'a' && c <= 'f') v |= c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') v |= c - 'A' + 10;
+        else return -1;
+    }
+    return v;
+}
+
+/* Decode the escapes of s[0..n) into out; returns the decoded length */
+static json_status_t _decode_escapes(json_parser_t *ps, const char *s, size_t n,
+                                     char *out, size_t *out_len) {
+    const char *end = s + n;
+    char *o = out;
+    while (s < end) {
+        if (*s != '\\') {
+            *o++ = *s++;
+            continue;
+        }
+        if (end - s < 2) return _fail(ps, "Bad escape");
+        char e = s[1];
+        s += 2;
+        switch (e) {
+            case '"':  *o++ = '"';  break;
+            case '\\': *o++ = '\\'; break;
+            case '/':  *o++ = '/';  break;
+            case 'b':  *o++ = '\b'; break;
+            case 'f':  *o++ = '\f'; break;
+            case 'n':  *o++ = '\n'; break;
+            case 'r':  *o++ = '\r'; break;
+            case 't':  *o++ = '\t'; break;
+            case 'u': {
+                int cp = end - s >= 4 ? _hex4(s) : -1;
+                if (cp < 0) return _fail(ps, "Bad \\u escape");
+                s += 4;
+                if (cp >= 0xD800 && cp <= 0xDBFF) {
+                    int lo = (end - s >= 6 && s[0] == '\\' && s[1] == 'u') ? _hex4(s + 2) : -1;
+                    if (lo < 0xDC00 || lo > 0xDFFF) return _fail(ps, "Unpaired surrogate");
+                    s += 6;
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+                    return _fail(ps, "Unpaired surrogate");
+                }
+                if (cp < 0x80) {
+                    *o++ = (char)cp;
+                } else if (cp < 0x800) {
+                    *o++ = (char)(0xC0 | (cp >> 6));
+                    *o++ = (char)(0x80 | (cp & 0x3F));
+                } else if (cp < 0x10000) {
+                    *o++ = (char)(0xE0 | (cp >> 12));
+                    *o++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+                    *o++ = (char)(0x80 | (cp & 0x3F));
+                } else {
+                    *o++ = (char)(0xF0 | (cp >> 18));
+                    *o++ = (char)(0x80 | ((cp >> 12) & 0x3F));
+                    *o++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+                    *o++ = (char)(0x80 | (cp & 0x3F));
+                }
+                break;
+            }
+            default:
+                return _fail(ps, "Bad escape");
+        }
+    }
+    *out_len = (size_t)(o - out);
+    return JSON_OK;
+}
+
+/* ps->p at the opening quote */
+static json_status_t _parse_string(json_parser_t *ps, json_str_t *out) {
+    const char *s = ++ps->p;
+    const char *p = s;
+    const char *end = ps->end;
+    uint64_t high = 0;
+
+    while (end - p >= 8) {
+        uint64_t v;
+        memcpy(&v, p, 8);
+        if (_swar_special(v)) break;
+        high |= v;
+        p += 8;
+    }
+    while (p < end && !_json_special((unsigned char)*p)) {
+        high |= (unsigned char)*p;
+        p++;
+    }
+    if (p >= end) return _fail(ps, "Unterminated string");
+
+    if (MONGOLITE_LIKELY(*p == '"')) {
+        out->ptr = s;
+        out->off = 0;
+        out->len = (size_t)(p - s);
+        ps->p = p + 1;
+    } else if (*p == '\\') {
+        /* Find the end first: decoding only shrinks, so the raw length
+         * bounds the scratch space */
+        const char *q = p;
+        while (q < end && *q != '"') {
+            if ((unsigned char)*q < 0x20) return _fail(ps, "Control character in string");
+            high |= (unsigned char)*q;
+            q += (*q == '\\' && q + 1 < end) ? 2 : 1;
+        }
+        if (q >= end) return _fail(ps, "Unterminated string");
+        if (!_buf_reserve(&ps->scratch, (size_t)(q - s))) return _fail(ps, "Out of memory");
+
+        size_t len;
+        char *o = ps->scratch.data + ps->scratch.len;
+        json_status_t st = _decode_escapes(ps, s, (size_t)(q - s), o, &len);
+        if (st != JSON_OK) return st;
+        out->ptr = NULL;
+        out->off = ps->scratch.len;
+        out->len = len;
+        ps->scratch.len += len;
+        ps->p = q + 1;
+    } else {
+        return _fail(ps, "Control character in string");
+    }
+
+    if ((high & SWAR_HIGHS) && !bson_utf8_validate(_str_ptr(ps, out), out->len, true)) {
+        return _fail(ps, "Invalid UTF-8");
+    }
+    return JSON_OK;
+}
+
+static bool _parse_int64(const char *s, size_t n, int64_t *out) {
+    bool neg = n > 0 && *s == '-';
+    if (neg) {
+        s++;
+        n--;
+    }
+    if (n == 0 || n > 19) return false;
+
+    uint64_t v = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (s[i] < '0' || s[i] > '9') return false;
+        v = v * 10 + (uint64_t)(s[i] - '0');
+    }
+    if (v > (uint64_t)INT64_MAX + neg) return false;
+    *out = neg ? (int64_t)(0 - v) : (int64_t)v;
+    return true;
+}
+
+static bool _parse_double(const char *s, size_t n, double *out) {
+    char buf[64];
+    if (n == 0 || n >= sizeof(buf)) return false;
+    memcpy(buf, s, n);
+    buf[n] = '\0';
+
+    /* Only decimal numbers: strtod also takes "inf", hex, spaces... */
+    const char *p = buf + (buf[0] == '-');
+    if (*p < '0' || *p > '9') {
+        if (strcmp(buf, "Infinity") == 0) *out = INFINITY;
+        else if (strcmp(buf, "-Infinity") == 0) *out = -INFINITY;
+        else if (strcmp(buf, "NaN") == 0) *out = NAN;
+        else return false;
+        return true;
+    }
+
+    /* Out of range (1e400, 1e-400): left to libbson, which rejects it */
+    char *endp;
+    errno = 0;
+    *out = strtod(buf, &endp);
+    return endp == buf + n && errno != ERANGE && !isinf(*out);
+}
+
+/* Length of the JSON number at ps->p (0 if none); *is_float if it has a
+ * fraction or exponent */
+static size_t _scan_number(const json_parser_t *ps, bool *is_float) {
+    const char *p = ps->p;
+    const char *end = ps->end;
+    *is_float = false;
+
+    if (p < end && *p == '-') p++;
+    const char *digits = p;
+    while (p < end && *p >= '0' && *p <= '9') p++;
+    if (p == digits || (*digits == '0' && p - digits > 1)) return 0;
+
+    if (p < end && *p == '.') {
+        *is_float = true;
+        const char *frac = ++p;
+        while (p < end && *p >= '0' && *p <= '9') p++;
+        if (p == frac) return 0;
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        *is_float = true;
+        p++;
+        if (p < end && (*p == '+' || *p == '-')) p++;
+        const char *exp = p;
+        while (p < end && *p >= '0' && *p <= '9') p++;
+        if (p == exp) return 0;
+    }
+    return (size_t)(p - ps->p);
+}
+
+static json_ext_t _ext_kind(const char *name, size_t len) {
+    static const char *const others[] = {
+        "$numberDecimal", "$binary", "$type", "$uuid", "$timestamp", "$regularExpression",
+        "$regex", "$options", "$code", "$scope", "$symbol", "$dbPointer", "$minKey",
+        "$maxKey", "$undefined",
+    };
+
+#define EXT_IS(lit) (len == sizeof(lit) - 1 && memcmp(name, lit, len) == 0)
+    if (EXT_IS("$oid")) return EXT_OID;
+    if (EXT_IS("$date")) return EXT_DATE;
+    if (EXT_IS("$numberInt")) return EXT_INT;
+    if (EXT_IS("$numberLong")) return EXT_LONG;
+    if (EXT_IS("$numberDouble")) return EXT_DOUBLE;
+#undef EXT_IS
+    for (size_t i = 0; i < sizeof(others) / sizeof(others[0]); i++) {
+        if (strlen(others[i]) == len && memcmp(name, others[i], len) == 0) return EXT_OTHER;
+    }
+    return EXT_NONE;
+}
+
+/* Extended JSON wrapper named by the first key of the object at ps->p */
+static json_ext_t _ext_peek(const json_parser_t *ps) {
+    const char *q = ps->p + 1;
+    while (q < ps->end && (*q == ' ' || *q == '\n' || *q == '\r' || *q == '\t')) q++;
+    if (ps->end - q < 3 || q[0] != '"' || q[1] != '$') return EXT_NONE;
+
+    const char *close = memchr(q + 1, '"', (size_t)(ps->end - q - 1));
+    if (!close) return EXT_NONE;
+    return _ext_kind(q + 1, (size_t)(close - q - 1));
+}
+
+/* {"$kind": value}, nothing more; anything unusual goes to libbson */
+static json_status_t _parse_ext(json_parser_t *ps, bson_t *parent, const json_str_t *key,
+                                json_ext_t kind) {
+    json_str_t name, str;
+    int64_t i64 = 0;
+    double dbl = 0.0;
+    bson_oid_t oid;
+
+    ps->p++;
+    _skip_ws(ps);
+    if (_parse_string(ps, &name) != JSON_OK) return JSON_FALLBACK;
+    _skip_ws(ps);
+    if (_peek(ps) != ':') return JSON_FALLBACK;
+    ps->p++;
+    _skip_ws(ps);
+
+    if (kind == EXT_DATE) {
+        char c = _peek(ps);
+        if (c == '{') {
+            ps->p++;
+            _skip_ws(ps);
+            if (_peek(ps) != '"' || _parse_string(ps, &name) != JSON_OK ||
+                !_str_is(ps, &name, "$numberLong")) {
+                return JSON_FALLBACK;
+            }
+            _skip_ws(ps);
+            if (_peek(ps) != ':') return JSON_FALLBACK;
+            ps->p++;
+            _skip_ws(ps);
+            if (_peek(ps) != '"' || _parse_string(ps, &str) != JSON_OK ||
+                !_parse_int64(_str_ptr(ps, &str), str.len, &i64)) {
+                return JSON_FALLBACK;
+            }
+            _skip_ws(ps);
+            if (_peek(ps) != '}') return JSON_FALLBACK;
+            ps->p++;
+        } else if (c == '-' || (c >= '0' && c <= '9')) {
+            bool is_float;
+            size_t n = _scan_number(ps, &is_float);
+            if (n == 0 || is_float || !_parse_int64(ps->p, n, &i64)) return JSON_FALLBACK;
+            ps->p += n;
+        } else {
+            return JSON_FALLBACK;           /* ISO-8601 string */
+        }
+    } else {
+        if (_peek(ps) != '"' || _parse_string(ps, &str) != JSON_OK) return JSON_FALLBACK;
+        const char *s = _str_ptr(ps, &str);
+        switch (kind) {
+            case EXT_OID:
+                if (str.len != 24 || !bson_oid_is_valid(s, 24)) return JSON_FALLBACK;
+                bson_oid_init_from_string(&oid, s);
+                break;
+            case EXT_INT:
+                if (!_parse_int64(s, str.len, &i64) || i64 < INT32_MIN || i64 > INT32_MAX) {
+                    return JSON_FALLBACK;
+                }
+                break;
+            case EXT_LONG:
+                if (!_parse_int64(s, str.len, &i64)) return JSON_FALLBACK;
+                break;
+            default:
+                if (!_parse_double(s, str.len, &dbl)) return JSON_FALLBACK;
+                break;
+        }
+    }
+    _skip_ws(ps);
+    if (_peek(ps) != '}') return JSON_FALLBACK;
+    ps->p++;
+
+    const char *k = _str_ptr(ps, key);
+    int klen = (int)key->len;
+    bool ok;
+    switch (kind) {
+        case EXT_OID:  ok = bson_append_oid(parent, k, klen, &oid); break;
+        case EXT_INT:  ok = bson_append_int32(parent, k, klen, (int32_t)i64); break;
+        case EXT_LONG: ok = bson_append_int64(parent, k, klen, i64); break;
+        case EXT_DATE: ok = bson_append_date_time(parent, k, klen, i64); break;
+        default:       ok = bson_append_double(parent, k, klen, dbl); break;
+    }
+    return ok ? JSON_OK : _fail(ps, "Document too large");
+}
+
+static json_status_t _parse_object(json_parser_t *ps, bson_t *doc, int depth);
+static json_status_t _parse_array(json_parser_t *ps, bson_t *arr, int depth);
+
+static json_status_t _parse_value(json_parser_t *ps, bson_t *parent, const json_str_t *key,
+                                  int depth) {
+    bool ok;
+    char c = _peek(ps);
+
+    switch (c) {
+        case '"': {
+            json_str_t str;
+            json_status_t st = _parse_string(ps, &str);
+            if (st != JSON_OK) return st;
+            /* Resolve the key after the value: decoding may move scratch */
+            ok = bson_append_utf8(parent, _str_ptr(ps, key), (int)key->len,
+                                  _str_ptr(ps, &str), (int)str.len);
+            break;
+        }
+
+        case '{':
+        case '[': {
+            if (depth >= JSON_MAX_DEPTH) return _fail(ps, "Nesting too deep");
+            if (c == '{') {
+                json_ext_t kind = _ext_peek(ps);
+                if (kind == EXT_OTHER) return JSON_FALLBACK;
+                if (kind != EXT_NONE) return _parse_ext(ps, parent, key, kind);
+            }
+
+            /* The child is always closed, even on failure, so the parent
+             * stays usable (bson_reinit) */
+            bson_t child;
+            json_status_t st;
+            if (c == '{') {
+                if (!bson_append_document_begin(parent, _str_ptr(ps, key), (int)key->len, &child)) {
+                    return _fail(ps, "Document too large");
+                }
+                st = _parse_object(ps, &child, depth + 1);
+                ok = bson_append_document_end(parent, &child);
+            } else {
+                if (!bson_append_array_begin(parent, _str_ptr(ps, key), (int)key->len, &child)) {
+                    return _fail(ps, "Document too large");
+                }
+                st = _parse_array(ps, &child, depth + 1);
+                ok = bson_append_array_end(parent, &child);
+            }
+            if (st != JSON_OK) return st;
+            break;
+        }
+
+        case 't':
+        case 'f':
+        case 'n': {
+            const char *lit = c == 't' ? "true" : c == 'f' ? "false" : "null";
+            size_t n = strlen(lit);
+            if ((size_t)(ps->end - ps->p) < n || memcmp(ps->p, lit, n) != 0) {
+                return _fail(ps, "Unexpected literal");
+            }
+            ps->p += n;
+            ok = c == 'n' ? bson_append_null(parent, _str_ptr(ps, key), (int)key->len)
+                          : bson_append_bool(parent, _str_ptr(ps, key), (int)key->len, c == 't');
+            break;
+        }
+
+        default: {
+            bool is_float;
+            size_t n = _scan_number(ps, &is_float);
+            if (n == 0) return _fail(ps, "Unexpected character");
+
+            const char *k = _str_ptr(ps, key);
+            int64_t i64;
+            double dbl;
+            if (is_float) {
+                if (!_parse_double(ps->p, n, &dbl)) return JSON_FALLBACK;
+                ok = bson_append_double(parent, k, (int)key->len, dbl);
+            } else if (!_parse_int64(ps->p, n, &i64)) {
+                return JSON_FALLBACK;           /* Beyond int64 */
+            } else if (i64 >= INT32_MIN && i64 <= INT32_MAX) {
+                ok = bson_append_int32(parent, k, (int)key->len, (int32_t)i64);
+            } else {
+                ok = bson_append_int64(parent, k, (int)key->len, i64);
+            }
+            ps->p += n;
+            break;
+        }
+    }
+    return ok ? JSON_OK : _fail(ps, "Document too large");
+}
+
+/* ps->p at '{' */
+static json_status_t _parse_object(json_parser_t *ps, bson_t *doc, int depth) {
+    ps->p++;
+    _skip_ws(ps);
+    if (_peek(ps) == '}') {
+        ps->p++;
+        return JSON_OK;
+    }
+
+    for (;;) {
+        size_t mark = ps->scratch.len;
+        json_str_t key;
+        if (_peek(ps) != '"') return _fail(ps, "Expected a key");
+        json_status_t st = _parse_string(ps, &key);
+        if (st != JSON_OK) return st;
+        if (!key.ptr && memchr(_str_ptr(ps, &key), '\0', key.len)) {
+            return _fail(ps, "Key contains a NUL character");
+        }
+
+        _skip_ws(ps);
+        if (_peek(ps) != ':') return _fail(ps, "Expected ':'");
+        ps->p++;
+        _skip_ws(ps);
+        st = _parse_value(ps, doc, &key, depth);
+        if (st != JSON_OK) return st;
+        ps->scratch.len = mark;
+
+        _skip_ws(ps);
+        char c = _peek(ps);
+        ps->p++;
+        if (c == '}') return JSON_OK;
+        if (c != ',') {
+            ps->p--;
+            return _fail(ps, "Expected ',' or '}'");
+        }
+        _skip_ws(ps);
+    }
+}
+
+/* ps->p at '[' */
+static json_status_t _parse_array(json_parser_t *ps, bson_t *arr, int depth) {
+    ps->p++;
+    _skip_ws(ps);
+    if (_peek(ps) == ']') {
+        ps->p++;
+        return JSON_OK;
+    }
+
+    for (uint32_t i = 0;; i++) {
+        char buf[16];
+        const char *k;
+        json_str_t key = {NULL, 0, bson_uint32_to_string(i, &k, buf, sizeof(buf))};
+        key.ptr = k;
+
+        size_t mark = ps->scratch.len;
+        json_status_t st = _parse_value(ps, arr, &key, depth);
+        if (st != JSON_OK) return st;
+        ps->scratch.len = mark;
+
+        _skip_ws(ps);
+        char c = _peek(ps);
+        ps->p++;
+        if (c == ']') return JSON_OK;
+        if (c != ',') {
+            ps->p--;
+            return _fail(ps, "Expected ',' or ']'");
+        }
+        _skip_ws(ps);
+    }
+}
+
+int _mongolite_json_parse(const char *json, size_t len, bson_t *out, gerror_t *error) {
+    json_parser_t ps = {0};
+    ps.p = json;
+    ps.end = json + len;
+
+    json_status_t st;
+    _skip_ws(&ps);
+    if (_peek(&ps) == '{') {
+        st = _parse_object(&ps, out, 1);
+        if (st == JSON_OK) {
+            _skip_ws(&ps);
+            if (ps.p != ps.end) st = _fail(&ps, "Unexpected data after the document");
+        }
+    } else if (_peek(&ps) == '[') {
+        st = JSON_FALLBACK;                 /* libbson reads a top-level array as {"0": ...} */
+    } else {
+        st = _fail(&ps, "Expected a JSON object");
+    }
+    free(ps.scratch.data);
+
+    if (st == JSON_FALLBACK) {
+        bson_error_t bson_err;
+        bson_t *doc = bson_new_from_json((const uint8_t *)json, (ssize_t)len, &bson_err);
+        bson_reinit(out);
+        if (!doc) {
+            set_error(error, "libbson", MONGOLITE_EINVAL, "Invalid JSON: %s", bson_err.message);
+            return MONGOLITE_EINVAL;
+        }
+        bool ok = bson_concat(out, doc);
+        bson_destroy(doc);
+        if (!ok) {
+            set_error(error, MONGOLITE_LIB, MONGOLITE_EINVAL, "Invalid JSON: document too large");
+            return MONGOLITE_EINVAL;
+        }
+        return MONGOLITE_OK;
+    }
+    if (st != JSON_OK) {
+        bson_reinit(out);
+        set_error(error, MONGOLITE_LIB, MONGOLITE_EINVAL, "Invalid JSON at offset %zu: %s",
+                  (size_t)(ps.p - json), ps.msg);
+        return MONGOLITE_EINVAL;
+    }
+    return MONGOLITE_OK;
+}
@@ -0,0 +1,207 @@
+/*
+ * mongolite_map.c - Map growth policy
+ *
+ * Handles:
+ * - Growth policy from db_config_t (threshold, step / percent, cap, hook)
+ * - Proactive growth after commits, at points with no transaction open
+ * - Pre-sizing the map before large batches
+ * - Reactive growth on MDB_MAP_FULL (the write is then retried)
+ *
+ * Growing ahead cannot promise the replay never happens: it only runs
+ * with no transaction open, single inserts are not pre-sized, and batch
+ * sizes are estimates. Each replay is counted in map_full_replays.
+ */
+
+#include "mongolite_internal.h"
+#include "macros.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MONGOLITE_LIB "mongolite"
+
+/*
+ * Optional compile-time limit for maximum database size after auto-resize.
+ * Define MONGOLITE_MAX_DB_SIZE to a byte value to enforce a limit.
+ * If not defined or set to 0, only overflow is checked (no artificial limit).
+ *
+ * Example: -DMONGOLITE_MAX_DB_SIZE=1099511627776ULL  (1TB)
+ */
+#ifndef MONGOLITE_MAX_DB_SIZE
+#define MONGOLITE_MAX_DB_SIZE 0
+#endif
+
+/* ============================================================
+ * Init
+ * ============================================================ */
+
+void _mongolite_map_init(mongolite_db_t *db, const db_config_t *config) {
+    mongolite_map_policy_t *p = &db->map_policy;
+    memset(p, 0, sizeof(*p));
+
+    p->grow_at_percent = (config && config->map_grow_at_percent)
+                             ? config->map_grow_at_percent : MONGOLITE_DEFAULT_GROW_AT_PERCENT;
+    p->growth_step = config ? config->map_growth_step : 0;
+    p->growth_percent = (config && config->map_growth_percent)
+                            ? config->map_growth_percent : MONGOLITE_DEFAULT_GROWTH_PERCENT;
+    p->max_bytes = config ? config->map_max_bytes : 0;
+    p->fn = config ? config->map_growth_fn : NULL;
+    p->ctx = config ? config->map_growth_ctx : NULL;
+
+    MDB_stat stat;
+    p->page_size = (mdb_env_stat(wtree3_db_get_env(db->wdb), &stat) == 0) ? stat.ms_psize : 4096;
+}
+
+/* ============================================================
+ * Policy
+ * ============================================================ */
+
+static void _map_usage(mongolite_db_t *db, mongolite_map_usage_t *usage) {
+    memset(usage, 0, sizeof(*usage));
+    usage->map_size = wtree3_db_get_mapsize(db->wdb);
+
+    MDB_envinfo info;
+    if (mdb_env_info(wtree3_db_get_env(db->wdb), &info) == 0) {
+        usage->used_bytes = (size_t)(info.me_last_pgno + 1) * db->map_policy.page_size;
+    }
+}
+
+/* Largest size the map may reach (0 = unbounded) */
+static size_t _map_cap(const mongolite_map_policy_t *p) {
+    size_t cap = p->max_bytes;
+#if MONGOLITE_MAX_DB_SIZE > 0
+    if (cap == 0 || cap > (size_t)MONGOLITE_MAX_DB_SIZE) cap = (size_t)MONGOLITE_MAX_DB_SIZE;
+#endif
+    return cap;
+}
+
+/* New map size for usage (built-in policy or hook), capped; 0 = stay */
+static size_t _map_target(mongolite_db_t *db, const mongolite_map_usage_t *usage) {
+    const mongolite_map_policy_t *p = &db->map_policy;
+    size_t current = usage->map_size;
+    size_t target;
+
+    if (p->fn) {
+        target = p->fn(usage, p->ctx);
+    } else {
+        size_t step = p->growth_step;
+        if (step == 0) step = current / 100 * p->growth_percent;
+        if (step < p->page_size) step = p->page_size;
+
+        /* Room for the next write, then still below the threshold */
+        size_t want = usage->used_bytes + usage->need_bytes;
+        target = current;
+        do {
+            if (target > SIZE_MAX - step) {
+                target = SIZE_MAX;
+                break;
+            }
+            target += step;
+        } while (p->grow_at_percent < 100 && want > target / 100 * p->grow_at_percent);
+    }
+
+    size_t cap = _map_cap(p);
+    if (cap > 0 && target > cap) target = cap;
+    target -= target % p->page_size;
+    return target > current ? target : 0;
+}
+
+/* Is usage past the point where the policy wants more room? */
+static bool _map_wants_growth(mongolite_db_t *db, const mongolite_map_usage_t *usage) {
+    const mongolite_map_policy_t *p = &db->map_policy;
+    if (p->fn) return true;
+
+    size_t want = usage->used_bytes + usage->need_bytes;
+    if (want >= usage->map_size) return true;
+    if (p->grow_at_percent >= 100) return false;
+    return want > usage->map_size / 100 * p->grow_at_percent;
+}
+
+/* No transaction of this process may be open while the map moves */
+static bool _map_safe_point(mongolite_db_t *db) {
+    return db->open_sessions == 0 && MONGOLITE_ATOMIC_LOAD(&db->cursor_txns) == 0;
+}
+
+static int _map_resize(mongolite_db_t *db, size_t new_size, gerror_t *error) {
+    /* The pooled read txn is reset; drop it so nothing refers to the old map */
+    if (db->read_txn_pool) {
+        wtree3_txn_abort(db->read_txn_pool);
+        db->read_txn_pool = NULL;
+    }
+
+    _mongolite_env_lock(db);
+    int rc = wtree3_db_resize(db->wdb, new_size, error);
+    _mongolite_env_unlock(db);
+
+    if (rc == 0) db->max_bytes = new_size;
+    return rc;
+}
+
+/* ============================================================
+ * Growth Points (db lock held)
+ * ============================================================ */
+
+static void _map_grow_ahead(mongolite_db_t *db, size_t need_bytes) {
+    if (MONGOLITE_UNLIKELY(!db || !db->wdb) || !_map_safe_point(db)) return;
+
+    mongolite_map_usage_t usage;
+    _map_usage(db, &usage);
+    usage.need_bytes = need_bytes;
+    if (!_map_wants_growth(db, &usage)) return;
+
+    size_t target = _map_target(db, &usage);
+    if (target == 0) return;
+
+    gerror_t error = {0};
+    if (_map_resize(db, target, &error) == 0) {
+        MONGOLITE_STAT(db, map_grows, 1);
+    }
+}
+
+void _mongolite_map_committed(mongolite_db_t *db) {
+    _map_grow_ahead(db, 0);
+}
+
+void _mongolite_map_reserve(mongolite_db_t *db, size_t need_bytes) {
+    _map_grow_ahead(db, need_bytes);
+}
+
+int _mongolite_try_resize(mongolite_db_t *db, gerror_t *error) {
+    if (!db || !db->wdb) {
+        set_error(error, MONGOLITE_LIB, MONGOLITE_EINVAL,
+                 "Invalid database handle");
+        return MONGOLITE_EINVAL;
+    }
+
+    /* The map can only grow with no transaction open in the process */
+    if (db->open_sessions > 0) {
+        set_error(error, MONGOLITE_LIB, MONGOLITE_ETXN,
+                 "Database is full and cannot grow while a session is open");
+        return MONGOLITE_ETXN;
+    }
+    if (MONGOLITE_ATOMIC_LOAD(&db->cursor_txns) > 0) {
+        set_error(error, MONGOLITE_LIB, MONGOLITE_ETXN,
+                 "Database is full and cannot grow while a cursor or backup is open");
+        return MONGOLITE_ETXN;
+    }
+
+    MONGOLITE_STAT(db, resizes, 1);
+
+    mongolite_map_usage_t usage;
+    _map_usage(db, &usage);
+    usage.map_full = true;
+    /* Whatever the pages say, the last write did not fit */
+    if (usage.used_bytes < usage.map_size) usage.used_bytes = usage.map_size;
+
+    size_t new_size = _map_target(db, &usage);
+    if (new_size == 0) {
+        set_error(error, MONGOLITE_LIB, MONGOLITE_ERROR,
+                 "Database would exceed maximum size limit");
+        return MONGOLITE_ERROR;
+    }
+
+    int rc = _map_resize(db, new_size, error);
+    /* Every caller retries its write once the map has grown */
+    if (rc == 0) MONGOLITE_STAT(db, map_full_replays, 1);
+    return rc;
+}
@@ -4,15 +4,24 @@
  * Functions:
  * - _analyze_query_for_index() - Analyze query filter for index use
  * - _free_query_analysis() - Free query analysis
- * - _find_best_index() - Find best index for query
+ * - _find_best_index() - Find the index expected to read the fewest entries
+ * - _find_best_index_entry() - Same, for an already-resolved collection
  * - _find_one_with_index() - Execute index-based query
+ * - _mongolite_plan_query() - Plan selection with per-collection plan cache
+ * - _mongolite_count_with_index() - Index-only filtered count
+ * - _mongolite_index_seek_ids() - Point seeks for $in / $or (index union)
+ * - _mongolite_index_seek_near() - $near ring search on a geo index
+ * - _mongolite_index_explain() - Seek plan and index candidates for explain
  */
 
 #include "mongolite_internal.h"
 #include "mongoc-matcher.h"
+#include "key_compare.h"
 #include "macros.h"
 #include <string.h>
 #include <stdlib.h>
+#include <math.h>
+#include <errno.h>
 
 #define MONGOLITE_LIB "mongolite"
 
@@ -154,16 +163,37 @@ mongolite_cached_index_t* _find_best_index(mongolite_db_t *db,
         return NULL;
     }
 
+    mongolite_tree_cache_entry_t *entry = _mongolite_get_collection_entry(db, collection, error);
+    if (!entry) {
+        return NULL;
+    }
+
+    return _find_best_index_entry(db, entry, analysis, error);
+}
+
+MONGOLITE_HOT
+mongolite_cached_index_t* _find_best_index_entry(mongolite_db_t *db,
+                                                  mongolite_tree_cache_entry_t *entry,
+                                                  const query_analysis_t *analysis,
+                                                  gerror_t *error) {
+    if (!analysis || !analysis->is_simple_equality || analysis->equality_count == 0) {
+        return NULL;
+    }
+
     /* Get cached indexes */
     size_t index_count = 0;
-    mongolite_cached_index_t *indexes = _mongolite_get_cached_indexes(db, collection, &index_count, error);
+    mongolite_cached_index_t *indexes = _mongolite_entry_indexes(db, entry, &index_count, error);
     if (!indexes || index_count == 0) {
         return NULL;
     }
 
-    /* Find index that matches query fields */
+    /* Among indexes whose fields are all in the query, the one expected to
+     * read the fewest entries; more key fields, then creation order, on a tie */
+    mongolite_cached_index_t *best = NULL;
+    double best_rows = 0;
+    uint32_t best_fields = 0;
     for (size_t i = 0; i < index_count; i++) {
-        if (!indexes[i].keys) continue;
+        if (!indexes[i].keys || indexes[i].text || indexes[i].geo || indexes[i].legacy) continue;
 
         /* Check if index keys match query fields */
         bson_iter_t idx_iter;
@@ -193,34 +223,238 @@ mongolite_cached_index_t* _find_best_index(mongolite_db_t *db,
             }
         }
 
-        /* If all index fields are in the query, use this index */
-        if (matches && matched_count > 0) {
-            return &indexes[i];
+        if (!matches || matched_count == 0) continue;
+
+        double rows = _mongolite_index_estimate(&indexes[i], NULL);
+        if (!best || rows < best_rows ||
+            (rows == best_rows && matched_count > best_fields)) {
+            best = &indexes[i];
+            best_rows = rows;
+            best_fields = (uint32_t)matched_count;
         }
     }
 
-    return NULL;
+    return best;
 }
 
 /* ============================================================
- * Index-based Query Execution
+ * Query Shape and Plan Cache
+ *
+ * Plans depend only on the filter's shape (field names, operators and
+ * the type of equality values - an OID _id or a regex value changes the
+ * plan), so they are memoized per collection keyed by that shape.
  * ============================================================ */
 
-static void* _build_index_key_from_filter(const bson_t *filter,
-                                          const bson_t *index_keys,
-                                          size_t *out_key_len) {
-    if (!filter || !index_keys || !out_key_len) {
-        return NULL;
+static bool _shape_put(char *buf, size_t cap, size_t *len, const char *s, size_t n) {
+    if (*len + n + 1 > cap) return false;
+    memcpy(buf + *len, s, n);
+    *len += n;
+    buf[*len] = '\0';
+    return true;
+}
+
+static bool _shape_doc(const bson_t *doc, char *buf, size_t cap, size_t *len);
+
+static bool _shape_subdoc(const bson_iter_t *iter, bson_t *sub) {
+    uint32_t sub_len;
+    const uint8_t *sub_data;
+    if (BSON_ITER_HOLDS_DOCUMENT(iter)) {
+        bson_iter_document(iter, &sub_len, &sub_data);
+    } else if (BSON_ITER_HOLDS_ARRAY(iter)) {
+        bson_iter_array(iter, &sub_len, &sub_data);
+    } else {
+        return false;
+    }
+    return bson_init_static(sub, sub_data, sub_len);
+}
+
+/* Does a document value contain query operators? (mirrors the analyzer) */
+static bool _is_operator_doc(const bson_t *sub) {
+    bson_iter_t it;
+    if (!bson_iter_init(&it, sub)) return false;
+    while (bson_iter_next(&it)) {
+        if (bson_iter_key(&it)[0] == '$') return true;
     }
+    return false;
+}
 
-    bson_t key_doc;
-    bson_init(&key_doc);
+static bool _shape_doc(const bson_t *doc, char *buf, size_t cap, size_t *len) {
+    bson_iter_t iter;
+    if (!bson_iter_init(&iter, doc)) return false;
+
+    while (bson_iter_next(&iter)) {
+        const char *key = bson_iter_key(&iter);
+        if (!_shape_put(buf, cap, len, key, strlen(key))) return false;
+
+        bson_t sub;
+        bool has_sub = _shape_subdoc(&iter, &sub);
+
+        if (key[0] == '$' && has_sub) {
+            /* Logical operator ($or, $and, ...) or nested expression */
+            if (!_shape_put(buf, cap, len, "(", 1)) return false;
+            bson_iter_t elems;
+            if (BSON_ITER_HOLDS_ARRAY(&iter) && bson_iter_init(&elems, &sub)) {
+                while (bson_iter_next(&elems)) {
+                    bson_t clause;
+                    if (_shape_subdoc(&elems, &clause)) {
+                        if (!_shape_doc(&clause, buf, cap, len)) return false;
+                    }
+                    if (!_shape_put(buf, cap, len, "|", 1)) return false;
+                }
+            } else if (!_shape_doc(&sub, buf, cap, len)) {
+                return false;
+            }
+            if (!_shape_put(buf, cap, len, ")", 1)) return false;
+        } else if (BSON_ITER_HOLDS_DOCUMENT(&iter) && has_sub && _is_operator_doc(&sub)) {
+            /* Field operators: keep the operator names, drop the values */
+            if (!_shape_put(buf, cap, len, "{", 1)) return false;
+            bson_iter_t ops;
+            bson_iter_init(&ops, &sub);
+            while (bson_iter_next(&ops)) {
+                const char *op = bson_iter_key(&ops);
+                if (!_shape_put(buf, cap, len, op, strlen(op)) ||
+                    !_shape_put(buf, cap, len, ",", 1)) {
+                    return false;
+                }
+            }
+            if (!_shape_put(buf, cap, len, "}", 1)) return false;
+        } else {
+            /* Equality: keep the value type only */
+            static const char hex[] = "0123456789abcdef";
+            unsigned t = (unsigned)bson_iter_type(&iter);
+            char tag[4] = {'=', hex[(t >> 4) & 0xf], hex[t & 0xf], '\0'};
+            if (!_shape_put(buf, cap, len, tag, 3)) return false;
+        }
+
+        if (!_shape_put(buf, cap, len, ";", 1)) return false;
+    }
+
+    return true;
+}
+
+size_t _mongolite_query_shape(const bson_t *filter, char *buf, size_t cap) {
+    if (!buf || cap == 0) return 0;
+    size_t len = 0;
+    buf[0] = '\0';
+    if (!filter) return 0;
+    if (!_shape_doc(filter, buf, cap, &len)) return 0;
+    return len;
+}
+
+void _mongolite_plan_cache_clear(mongolite_tree_cache_entry_t *entry) {
+    if (!entry || !entry->plan_cache) return;
+    for (size_t i = 0; i < MONGOLITE_PLAN_CACHE_SLOTS; i++) {
+        free(entry->plan_cache[i].shape);
+    }
+    free(entry->plan_cache);
+    entry->plan_cache = NULL;
+}
+
+static bool _seek_plannable(mongolite_db_t *db, mongolite_tree_cache_entry_t *entry,
+                            const bson_t *filter, bool *intersects, gerror_t *error);
+
+/* Uncached planning: the decision sequence used by find_one */
+static mongolite_plan_type_t _plan_uncached(mongolite_db_t *db,
+                                            mongolite_tree_cache_entry_t *entry,
+                                            const bson_t *filter,
+                                            mongolite_cached_index_t **out_index,
+                                            gerror_t *error) {
+    bson_oid_t oid;
+    if (_mongolite_is_id_query(filter, &oid)) {
+        return MONGOLITE_PLAN_ID;
+    }
+
+    mongolite_plan_type_t type = MONGOLITE_PLAN_SCAN;
+    query_analysis_t *analysis = _analyze_query_for_index(filter);
+    if (analysis) {
+        mongolite_cached_index_t *idx = _find_best_index_entry(db, entry, analysis, error);
+        if (idx && analysis->is_simple_equality && _mongolite_index_eq_seekable(idx, filter, NULL)) {
+            *out_index = idx;
+            type = MONGOLITE_PLAN_INDEX_EQ;
+        }
+        _free_query_analysis(analysis);
+    }
+
+    /* $in / $or seeks, or an intersection beating the single-index seek */
+    bool intersects = false;
+    if (type != MONGOLITE_PLAN_ID && _seek_plannable(db, entry, filter, &intersects, error) &&
+        (type == MONGOLITE_PLAN_SCAN || intersects)) {
+        type = MONGOLITE_PLAN_INDEX_MULTI;
+        *out_index = NULL;
+    }
+    return type;
+}
+
+MONGOLITE_HOT
+mongolite_plan_type_t _mongolite_plan_query(mongolite_db_t *db,
+                                            mongolite_tree_cache_entry_t *entry,
+                                            const bson_t *filter,
+                                            mongolite_cached_index_t **out_index,
+                                            gerror_t *error) {
+    *out_index = NULL;
+
+    if (!filter || bson_empty(filter)) {
+        return MONGOLITE_PLAN_SCAN;
+    }
+
+    if (MONGOLITE_UNLIKELY(db->plan_cache_disabled)) {
+        entry->plan_replans++;
+        return _plan_uncached(db, entry, filter, out_index, error);
+    }
+
+    char shape[MONGOLITE_QUERY_SHAPE_MAX];
+    size_t shape_len = _mongolite_query_shape(filter, shape, sizeof(shape));
+    if (MONGOLITE_UNLIKELY(shape_len == 0)) {
+        /* Shape too large to cache */
+        entry->plan_replans++;
+        return _plan_uncached(db, entry, filter, out_index, error);
+    }
+
+    uint64_t hash = _mongolite_name_hash(shape);
+    if (MONGOLITE_UNLIKELY(!entry->plan_cache)) {
+        entry->plan_cache = calloc(MONGOLITE_PLAN_CACHE_SLOTS, sizeof(mongolite_plan_cache_slot_t));
+    }
+
+    mongolite_plan_cache_slot_t *slot = entry->plan_cache ?
+        &entry->plan_cache[hash & (MONGOLITE_PLAN_CACHE_SLOTS - 1)] : NULL;
+
+    /* Index changes clear the cache, so a matching slot is always current */
+    if (slot && slot->shape && slot->hash == hash && strcmp(slot->shape, shape) == 0) {
+        entry->plan_hits++;
+        *out_index = slot->index;
+        return slot->type;
+    }
+
+    entry->plan_replans++;
+    mongolite_plan_type_t type = _plan_uncached(db, entry, filter, out_index, error);
+
+    if (slot) {
+        char *copy = _mongolite_strndup(shape, shape_len);
+        if (copy) {
+            free(slot->shape);
+            slot->shape = copy;
+            slot->hash = hash;
+            slot->type = type;
+            slot->index = *out_index;
+        }
+    }
+    return type;
+}
+
+/* ============================================================
+ * Index-based Query Execution
+ * ============================================================ */
+
+bool _mongolite_index_key_from_filter(const bson_t *filter, const bson_t *index_keys,
+                                      bson_t *out_key) {
+    if (!filter || !index_keys || !out_key) {
+        return false;
+    }
 
     /* Iterate index keys (e.g., {"field1": 1, "field2": -1}) */
     bson_iter_t idx_iter;
     if (!bson_iter_init(&idx_iter, index_keys)) {
-        bson_destroy(&key_doc);
-        return NULL;
+        return false;
     }
 
     while (bson_iter_next(&idx_iter)) {
@@ -228,17 +462,49 @@ static void* _build_index_key_from_filter(const bson_t *filter,
 
         /* Look for this field in the filter */
         bson_iter_t filter_iter;
-        if (bson_iter_init_find(&filter_iter, filter, idx_field)) {
-            /* Append the value to our key document */
-            if (!bson_append_iter(&key_doc, idx_field, -1, &filter_iter)) {
-                bson_destroy(&key_doc);
-                return NULL;
-            }
-        } else {
+        if (!bson_iter_init_find(&filter_iter, filter, idx_field)) {
             /* Field not in filter - can't use this index */
-            bson_destroy(&key_doc);
-            return NULL;
+            return false;
         }
+
+        /* Append the value to our key document */
+        if (!bson_append_iter(out_key, idx_field, -1, &filter_iter)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool _mongolite_index_eq_seekable(const mongolite_cached_index_t *index, const bson_t *filter,
+                                  bool *exact) {
+    bson_iter_t kit, value;
+    if (index->legacy) return false;
+    if (!index->multikey || !bson_iter_init(&kit, index->keys)) return true;
+
+    /* A multi-key index holds the elements, not the whole array, and
+     * also an array's null elements, which {f: null} does not match */
+    while (bson_iter_next(&kit)) {
+        if (!bson_iter_init_find(&value, filter, bson_iter_key(&kit))) continue;
+        if (BSON_ITER_HOLDS_ARRAY(&value)) return false;
+        if (BSON_ITER_HOLDS_NULL(&value) && exact) *exact = false;
+    }
+    return true;
+}
+
+static void* _build_index_key_from_filter(const bson_t *filter,
+                                          const bson_t *index_keys,
+                                          size_t *out_key_len) {
+    if (!filter || !index_keys || !out_key_len) {
+        return NULL;
+    }
+
+    bson_t key_doc;
+    bson_init(&key_doc);
+
+    if (!_mongolite_index_key_from_filter(filter, index_keys, &key_doc)) {
+        bson_destroy(&key_doc);
+        return NULL;
     }
 
     /* Serialize to buffer */
@@ -262,8 +528,6 @@ bson_t* _find_one_with_index(mongolite_db_t *db,
                               mongolite_cached_index_t *index,
                               const bson_t *filter,
                               gerror_t *error) {
-    (void)collection;  /* Unused */
-
     /* Build index key from filter */
     size_t index_key_len = 0;
     void *index_key = _build_index_key_from_filter(filter, index->keys, &index_key_len);
@@ -315,6 +579,7 @@ bson_t* _find_one_with_index(mongolite_db_t *db,
     rc = mdb_cursor_get(cursor, &key, &val, MDB_SET_KEY);
 
     bson_t *result = NULL;
+    uint64_t fetched = 0;  /* Documents read and matched, for stats */
 
     if (rc == MDB_SUCCESS) {
         /* Found matching index entry - val contains document _id */
@@ -328,6 +593,7 @@ bson_t* _find_one_with_index(mongolite_db_t *db,
             int get_rc = wtree3_get_txn(txn, col_tree, doc_oid.bytes, sizeof(doc_oid.bytes),
                                         &doc_data, &doc_len, error);
             if (get_rc == 0) {
+                fetched++;
                 bson_t *doc = bson_new_from_data(doc_data, doc_len);
                 if (doc) {
                     /* Validate with matcher (handles sparse indexes) */
@@ -344,6 +610,7 @@ bson_t* _find_one_with_index(mongolite_db_t *db,
                                     get_rc = wtree3_get_txn(txn, col_tree, doc_oid.bytes, sizeof(doc_oid.bytes),
                                                             &doc_data, &doc_len, NULL);
                                     if (get_rc == 0) {
+                                        fetched++;
                                         doc = bson_new_from_data(doc_data, doc_len);
                                         if (doc && mongoc_matcher_match(matcher, doc)) {
                                             result = doc;
@@ -364,5 +631,1280 @@ bson_t* _find_one_with_index(mongolite_db_t *db,
     _mongolite_release_read_txn(db, txn);
     mongoc_matcher_destroy(matcher);
     free(index_key);
+
+    MONGOLITE_TRACE(db, keys_examined, fetched);
+    _mongolite_stats_docs(db, _mongolite_collection_stats_lookup(db, collection),
+                          fetched, result ? 1 : 0, fetched);
     return result;
 }
+
+/* ============================================================
+ * Index-only Count
+ *
+ * A filter made of equalities on an index key prefix, optionally ending
+ * in a range on the next key field, is answered from the index DBI
+ * alone: one mdb_cursor_count per distinct key, no document fetches.
+ * ============================================================ */
+
+#define COUNT_MAX_PREDICATES 8
+
+typedef struct {
+    const char *field;
+    bson_iter_t eq;
+    bson_iter_t lo;
+    bson_iter_t hi;
+    bool has_eq;
+    bool has_lo;
+    bool has_hi;
+    bool lo_inclusive;
+    bool hi_inclusive;
+} count_predicate_t;
+
+/* Values whose index order matches the matcher's semantics
+ * (null, arrays, documents and regexes match more than their index key) */
+static bool _count_value_ok(const bson_iter_t *iter) {
+    switch (bson_iter_type(iter)) {
+        case BSON_TYPE_DOUBLE:
+            return !isnan(bson_iter_double(iter));
+        case BSON_TYPE_INT32:
+        case BSON_TYPE_INT64:
+        case BSON_TYPE_UTF8:
+        case BSON_TYPE_OID:
+        case BSON_TYPE_BOOL:
+        case BSON_TYPE_DATE_TIME:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/* Range bounds the matcher compares by value (it has no string ranges) */
+static bool _count_bound_ok(const bson_iter_t *iter) {
+    switch (bson_iter_type(iter)) {
+        case BSON_TYPE_DOUBLE:
+            return !isnan(bson_iter_double(iter));
+        case BSON_TYPE_INT32:
+        case BSON_TYPE_INT64:
+        case BSON_TYPE_OID:
+        case BSON_TYPE_DATE_TIME:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool _count_parse_operators(const bson_iter_t *iter, count_predicate_t *pred) {
+    bson_iter_t ops;
+    if (!bson_iter_recurse(iter, &ops)) return false;
+
+    bool any = false;
+    while (bson_iter_next(&ops)) {
+        const char *op = bson_iter_key(&ops);
+        if (!_count_bound_ok(&ops)) return false;
+
+        if ((strcmp(op, "$gt") == 0 || strcmp(op, "$gte") == 0) && !pred->has_lo) {
+            pred->lo = ops;
+            pred->has_lo = true;
+            pred->lo_inclusive = (op[3] == 'e');
+        } else if ((strcmp(op, "$lt") == 0 || strcmp(op, "$lte") == 0) && !pred->has_hi) {
+            pred->hi = ops;
+            pred->has_hi = true;
+            pred->hi_inclusive = (op[3] == 'e');
+        } else {
+            return false;
+        }
+        any = true;
+    }
+
+    if (!any) return false;
+
+    /* Bounds of different type classes: leave it to the matcher */
+    if (pred->has_lo && pred->has_hi &&
+        get_mongodb_type_precedence(bson_iter_type(&pred->lo)) !=
+        get_mongodb_type_precedence(bson_iter_type(&pred->hi))) {
+        return false;
+    }
+    return true;
+}
+
+static size_t _count_parse_filter(const bson_t *filter, count_predicate_t *preds) {
+    bson_iter_t iter;
+    if (!bson_iter_init(&iter, filter)) return 0;
+
+    size_t n = 0;
+    while (bson_iter_next(&iter)) {
+        const char *key = bson_iter_key(&iter);
+        if (key[0] == '$' || n == COUNT_MAX_PREDICATES) return 0;
+
+        for (size_t i = 0; i < n; i++) {
+            if (strcmp(preds[i].field, key) == 0) return 0;
+        }
+
+        count_predicate_t *pred = &preds[n];
+        memset(pred, 0, sizeof(*pred));
+        pred->field = key;
+
+        if (BSON_ITER_HOLDS_DOCUMENT(&iter)) {
+            if (!_count_parse_operators(&iter, pred)) return 0;
+        } else if (_count_value_ok(&iter)) {
+            pred->eq = iter;
+            pred->has_eq = true;
+        } else {
+            return 0;
+        }
+        n++;
+    }
+    return n;
+}
+
+static count_predicate_t* _count_find_predicate(count_predicate_t *preds, size_t n,
+                                                const char *field) {
+    for (size_t i = 0; i < n; i++) {
+        if (strcmp(preds[i].field, field) == 0) return &preds[i];
+    }
+    return NULL;
+}
+
+/*
+ * How many leading key fields of index the predicates cover, or 0 if the
+ * index cannot answer them: every predicate must sit on the key prefix
+ * and only the last covered field may be a range.
+ */
+static size_t _count_index_prefix(const mongolite_cached_index_t *index,
+                                  count_predicate_t *preds, size_t n,
+                                  count_predicate_t **ordered, size_t *nkeys) {
+    bson_iter_t kit;
+    if (index->text || index->geo || index->legacy || !bson_iter_init(&kit, index->keys)) {
+        return 0;
+    }
+
+    size_t m = 0, total = 0;
+    bool ended = false;
+    while (bson_iter_next(&kit)) {
+        total++;
+        if (ended) continue;
+
+        count_predicate_t *pred = _count_find_predicate(preds, n, bson_iter_key(&kit));
+        if (!pred) {
+            ended = true;
+            continue;
+        }
+        ordered[m++] = pred;
+        if (!pred->has_eq) ended = true;
+    }
+
+    *nkeys = total;
+    return (m == n) ? m : 0;
+}
+
+/* Compare the range field of an index key against its bounds.
+ * Returns -1 (below range: skip), 0 (inside), 1 (past range: stop). */
+static int _count_range_position(const bson_iter_t *value, const count_predicate_t *pred) {
+    const bson_iter_t *bound = pred->has_lo ? &pred->lo : &pred->hi;
+    int vclass = get_mongodb_type_precedence(bson_iter_type(value));
+    int bclass = get_mongodb_type_precedence(bson_iter_type(bound));
+
+    /* Range operators only match values of the bound's type class */
+    if (vclass != bclass) return vclass < bclass ? -1 : 1;
+    if (BSON_ITER_HOLDS_DOUBLE(value) && isnan(bson_iter_double(value))) return -1;
+
+    if (pred->has_lo) {
+        int c = mongodb_compare_iter(value, &pred->lo);
+        if (c < 0 || (c == 0 && !pred->lo_inclusive)) return -1;
+    }
+    if (pred->has_hi) {
+        int c = mongodb_compare_iter(value, &pred->hi);
+        if (c > 0 || (c == 0 && !pred->hi_inclusive)) return 1;
+    }
+    return 0;
+}
+
+/* Collect the duplicates (collection keys) of the cursor's index key */
+static int _count_collect_ids(MDB_cursor *cursor, MDB_val *key, MDB_val *val,
+                              bson_oid_t **ids, size_t *n, size_t *cap) {
+    int rc = MDB_SUCCESS;
+    while (rc == MDB_SUCCESS) {
+        if (val->mv_size != sizeof(bson_oid_t)) return MDB_CORRUPTED;
+        if (*n == *cap) {
+            size_t grown = *cap ? *cap * 2 : 256;
+            bson_oid_t *tmp = realloc(*ids, grown * sizeof(*tmp));
+            if (!tmp) return ENOMEM;
+            *ids = tmp;
+            *cap = grown;
+        }
+        memcpy((*ids)[(*n)++].bytes, val->mv_data, sizeof(bson_oid_t));
+        rc = mdb_cursor_get(cursor, key, val, MDB_NEXT_DUP);
+    }
+    return rc == MDB_NOTFOUND ? MDB_SUCCESS : rc;
+}
+
+/* Walk distinct index keys from the seek position while they satisfy
+ * the predicates, summing their duplicate counts. With distinct, the
+ * duplicates are collected and counted once per document instead: a
+ * multi-key index lists a document under each of its matching keys. */
+static int _count_walk(MDB_cursor *cursor, MDB_val *key, count_predicate_t **ordered,
+                       size_t m, bool distinct, int64_t *out_count) {
+    int64_t total = 0;
+    bson_oid_t *ids = NULL;
+    size_t n_ids = 0, cap = 0;
+    MDB_val val;
+    int rc = mdb_cursor_get(cursor, key, &val, MDB_SET_RANGE);
+
+    while (rc == MDB_SUCCESS) {
+        bson_t kdoc;
+        bson_iter_t kit;
+        if (!bson_init_static(&kdoc, key->mv_data, key->mv_size) ||
+            !bson_iter_init(&kit, &kdoc)) {
+            return MDB_CORRUPTED;
+        }
+
+        int position = 0;
+        for (size_t i = 0; i < m && position == 0; i++) {
+            if (!bson_iter_next(&kit)) return MDB_CORRUPTED;
+            const count_predicate_t *pred = ordered[i];
+            if (pred->has_eq) {
+                /* Keys are sorted: a differing prefix means we are past it */
+                position = mongodb_compare_iter(&kit, &pred->eq) == 0 ? 0 : 1;
+            } else {
+                position = _count_range_position(&kit, pred);
+            }
+        }
+
+        if (position > 0) break;
+        if (position == 0 && distinct) {
+            rc = _count_collect_ids(cursor, key, &val, &ids, &n_ids, &cap);
+            if (rc != MDB_SUCCESS) break;
+        } else if (position == 0) {
+            size_t dups = 0;
+            rc = mdb_cursor_count(cursor, &dups);
+            if (rc != MDB_SUCCESS) break;
+            total += (int64_t)dups;
+        }
+
+        rc = mdb_cursor_get(cursor, key, &val, MDB_NEXT_NODUP);
+    }
+
+    if (distinct) total = (int64_t)_mongolite_oids_sort_unique(ids, n_ids);
+    free(ids);
+    if (rc != MDB_SUCCESS && rc != MDB_NOTFOUND) return rc;
+    *out_count = total;
+    return MDB_SUCCESS;
+}
+
+/* Does every document have exactly one key in a multi-key index? Then
+ * its keys are ordinary ones. Only a non-sparse index has a key for
+ * every document, so only there do equal entry counts tell. */
+static bool _count_index_flat(MDB_txn *txn, mongolite_tree_cache_entry_t *entry,
+                              const mongolite_cached_index_t *index) {
+    MDB_stat idx_stat, col_stat;
+    return !index->sparse &&
+           mdb_stat(txn, index->dbi, &idx_stat) == MDB_SUCCESS &&
+           mdb_stat(txn, wtree3_tree_get_dbi(entry->tree), &col_stat) == MDB_SUCCESS &&
+           idx_stat.ms_entries == col_stat.ms_entries;
+}
+
+MONGOLITE_HOT
+int _mongolite_count_with_index(mongolite_db_t *db, mongolite_tree_cache_entry_t *entry,
+                                const bson_t *filter, int64_t *out_count,
+                                gerror_t *error) {
+    count_predicate_t preds[COUNT_MAX_PREDICATES];
+    size_t n = _count_parse_filter(filter, preds);
+    if (n == 0) return 0;
+
+    size_t index_count = 0;
+    mongolite_cached_index_t *indexes = _mongolite_entry_indexes(db, entry, &index_count, error);
+    if (!indexes || index_count == 0) return 0;
+
+    /* Prefer an index whose whole key is pinned by equalities (single seek) */
+    count_predicate_t *ordered[COUNT_MAX_PREDICATES];
+    mongolite_cached_index_t *chosen = NULL;
+    bool exact = false;
+    for (size_t i = 0; i < index_count && !exact; i++) {
+        count_predicate_t *cand[COUNT_MAX_PREDICATES];
+        size_t nkeys = 0;
+        size_t m = _count_index_prefix(&indexes[i], preds, n, cand, &nkeys);
+        if (m == 0) continue;
+
+        bool cand_exact = (m == nkeys && cand[m - 1]->has_eq);
+        if (!chosen || cand_exact) {
+            chosen = &indexes[i];
+            exact = cand_exact;
+            memcpy(ordered, cand, m * sizeof(*cand));
+        }
+    }
+    if (!chosen) return 0;
+
+    /* Seek key: the equality prefix, plus the lower bound of a range.
+     * A shorter document sorts before all of its extensions. */
+    bson_t seek;
+    bson_init(&seek);
+    for (size_t i = 0; i < n; i++) {
+        const count_predicate_t *pred = ordered[i];
+        const bson_iter_t *value = pred->has_eq ? &pred->eq :
+                                   pred->has_lo ? &pred->lo : NULL;
+        if (value) {
+            bson_append_iter(&seek, pred->field, -1, value);
+        }
+    }
+
+    wtree3_txn_t *txn = _mongolite_get_read_txn(db, error);
+    if (MONGOLITE_UNLIKELY(!txn)) {
+        bson_destroy(&seek);
+        return MONGOLITE_ETXN;
+    }
+
+    MDB_cursor *cursor = NULL;
+    int rc = mdb_cursor_open(wtree3_txn_get_mdb(txn), chosen->dbi, &cursor);
+    if (MONGOLITE_UNLIKELY(rc != MDB_SUCCESS)) {
+        _mongolite_release_read_txn(db, txn);
+        bson_destroy(&seek);
+        set_error(error, "lmdb", rc, "Failed to open cursor: %s", mdb_strerror(rc));
+        return rc;
+    }
+
+    /* A multi-key index lists a document once per matching key. A range
+     * with both bounds may match a document through two elements that
+     * each satisfy one bound and no key between them: leave it to the
+     * matcher. Otherwise count distinct documents. */
+    bool distinct = chosen->multikey && !exact &&
+                    !_count_index_flat(wtree3_txn_get_mdb(txn), entry, chosen);
+    const count_predicate_t *last = ordered[n - 1];
+    if (distinct && last->has_lo && last->has_hi) {
+        mdb_cursor_close(cursor);
+        _mongolite_release_read_txn(db, txn);
+        bson_destroy(&seek);
+        return 0;
+    }
+
+    MDB_val key = {.mv_size = seek.len, .mv_data = (void *)bson_get_data(&seek)};
+    if (exact) {
+        MDB_val val;
+        size_t dups = 0;
+        rc = mdb_cursor_get(cursor, &key, &val, MDB_SET_KEY);
+        if (rc == MDB_SUCCESS) {
+            rc = mdb_cursor_count(cursor, &dups);
+        } else if (rc == MDB_NOTFOUND) {
+            rc = MDB_SUCCESS;
+        }
+        *out_count = (int64_t)dups;
+    } else {
+        rc = _count_walk(cursor, &key, ordered, n, distinct, out_count);
+    }
+
+    mdb_cursor_close(cursor);
+    _mongolite_release_read_txn(db, txn);
+    bson_destroy(&seek);
+
+    if (MONGOLITE_UNLIKELY(rc != MDB_SUCCESS)) {
+        set_error(error, "lmdb", rc, "Index count failed: %s", mdb_strerror(rc));
+        return rc;
+    }
+    MONGOLITE_TRACE(db, keys_examined, (uint64_t)*out_count);
+    return 1;
+}
+
+/* ============================================================
+ * Multi-point Index Seeks
+ *
+ * {f: {$in: [...]}} becomes one point seek per value on an index whose
+ * key fields are all pinned by equalities or $in lists; {$or: [...]}
+ * becomes the union of each clause's seeks, each on its own index (or
+ * _id). The keys found are sorted and deduplicated, then fetched in _id
+ * order as a scan would return them. The matcher runs only on fetched
+ * documents, and not at all when the seeks consume every predicate.
+ *
+ * Equalities on fields with separate indexes intersect: each index's
+ * duplicates for its key are sorted by collection key, so the streams
+ * merge-join (skipping ahead with MDB_GET_BOTH_RANGE) and only the
+ * intersection is fetched. mdb_cursor_count sizes each stream first.
+ *
+ * {$text: {$search: ...}} is answered by the collection's text index
+ * alone: the search's terms are looked up and all their posting lists
+ * joined the same way, so only documents holding every term are read.
+ * The matcher never sees $text (it is stripped from the residual
+ * filter), and without a text index the query fails.
+ *
+ * $geoWithin and $near on a field with a geo index read the cells
+ * covering the query's area (mongolite_geo.c). $geoWithin's candidates
+ * are still matched; $near is answered by the index alone, nearest
+ * first, one ring of cells at a time as the cursor consumes them.
+ * ============================================================ */
+
+#define SEEK_MAX_FIELDS  8
+#define SEEK_MAX_CLAUSES 256
+#define SEEK_MAX_POINTS  4096           /* Key combinations per clause */
+#define SEEK_MAX_PATHS   4              /* Indexes intersected per clause */
+#define SEEK_JOIN_RATIO  8              /* Index entries walked per fetch saved */
+#define SEEK_COST_POINTS 16             /* Key combinations estimated one by one */
+
+typedef struct {
+    const char *field;
+    bson_iter_t value;                  /* The scalar, or the $in array */
+    bool is_in;
+    size_t count;                       /* Values: 1, or the $in length */
+} seek_field_t;
+
+typedef struct {
+    mongolite_cached_index_t *index;    /* NULL: the _id field */
+    size_t order[SEEK_MAX_FIELDS];      /* Seek fields in key order */
+    size_t n_order;
+    size_t points;                      /* Key combinations */
+} seek_path_t;
+
+typedef struct {
+    seek_field_t fields[SEEK_MAX_FIELDS];
+    size_t n_fields;
+    bool all_seekable;                  /* Every predicate is a seek field */
+
+    const char *text;                   /* $text $search string (NULL: none) */
+    uint32_t text_len;
+    mongolite_geo_query_t geo;          /* $geoWithin / $near (geo.field NULL: none) */
+
+    /* Access paths: one, or several single-key indexes to intersect */
+    seek_path_t paths[SEEK_MAX_PATHS];
+    size_t n_paths;
+    bool covered;                       /* The seeks consume every predicate */
+} seek_clause_t;
+
+typedef struct {
+    seek_clause_t *clauses;             /* The filter, or one per $or clause */
+    size_t n_clauses;
+    bool covered;
+} seek_plan_t;
+
+/* A scalar equality, or {$in: [scalars]} alone */
+static bool _seek_parse_value(const bson_iter_t *iter, seek_field_t *f) {
+    if (!BSON_ITER_HOLDS_DOCUMENT(iter)) {
+        if (!_count_value_ok(iter)) return false;
+        f->value = *iter;
+        f->is_in = false;
+        f->count = 1;
+        return true;
+    }
+
+    bson_iter_t ops, elems;
+    if (!bson_iter_recurse(iter, &ops) || !bson_iter_next(&ops) ||
+        strcmp(bson_iter_key(&ops), "$in") != 0 || !BSON_ITER_HOLDS_ARRAY(&ops)) {
+        return false;
+    }
+    bson_iter_t more = ops;
+    if (bson_iter_next(&more)) return false;
+
+    size_t n = 0;
+    if (!bson_iter_recurse(&ops, &elems)) return false;
+    while (bson_iter_next(&elems)) {
+        if (!_count_value_ok(&elems)) return false;
+        n++;
+    }
+    f->value = ops;
+    f->is_in = true;
+    f->count = n;
+    return true;
+}
+
+/* _id seeks go straight to the collection key, which only OIDs are */
+static bool _seek_all_oids(const seek_field_t *f) {
+    if (!f->is_in) return BSON_ITER_HOLDS_OID(&f->value);
+
+    bson_iter_t elems;
+    if (!bson_iter_recurse(&f->value, &elems)) return false;
+    while (bson_iter_next(&elems)) {
+        if (!BSON_ITER_HOLDS_OID(&elems)) return false;
+    }
+    return true;
+}
+
+static void _seek_parse_clause(const bson_t *clause, seek_clause_t *c) {
+    memset(c, 0, sizeof(*c));
+    c->all_seekable = true;
+
+    bson_iter_t iter;
+    if (!bson_iter_init(&iter, clause)) {
+        c->all_seekable = false;
+        return;
+    }
+
+    while (bson_iter_next(&iter)) {
+        const char *key = bson_iter_key(&iter);
+        seek_field_t *f = &c->fields[c->n_fields];
+        bool dup = false;
+        for (size_t i = 0; i < c->n_fields; i++) {
+            if (strcmp(c->fields[i].field, key) == 0) dup = true;
+        }
+
+        if (strcmp(key, "$text") == 0 && !c->text &&
+            _mongolite_text_search(&iter, &c->text, &c->text_len)) {
+            continue;
+        }
+        if (!c->geo.field && key[0] != '$' && _mongolite_geo_parse(&iter, key, &c->geo)) {
+            continue;
+        }
+        if (key[0] == '$' || dup || c->n_fields == SEEK_MAX_FIELDS ||
+            !_seek_parse_value(&iter, f) ||
+            (strcmp(key, "_id") == 0 && !_seek_all_oids(f))) {
+            c->all_seekable = false;    /* Left to the matcher */
+            continue;
+        }
+        f->field = key;
+        c->n_fields++;
+    }
+}
+
+/* The index as an access path if every key field is pinned */
+static bool _seek_path(mongolite_cached_index_t *index, const seek_clause_t *c,
+                       seek_path_t *path) {
+    bson_iter_t kit;
+    if (index->text || index->geo || index->legacy || !index->keys ||
+        !bson_iter_init(&kit, index->keys)) {
+        return false;
+    }
+
+    path->index = index;
+    path->n_order = 0;
+    path->points = 1;
+    while (bson_iter_next(&kit)) {
+        size_t j = 0;
+        while (j < c->n_fields && strcmp(c->fields[j].field, bson_iter_key(&kit)) != 0) j++;
+        if (j == c->n_fields || path->n_order == SEEK_MAX_FIELDS ||
+            c->fields[j].count > SEEK_MAX_POINTS ||
+            path->points * c->fields[j].count > SEEK_MAX_POINTS) {
+            return false;
+        }
+        path->order[path->n_order++] = j;
+        path->points *= c->fields[j].count;
+    }
+    return path->n_order > 0;
+}
+
+static double _seek_cost(const seek_clause_t *c, const seek_path_t *path);
+
+/* Access path for a clause: _id, else the index expected to read the
+ * fewest entries (most key fields pinned, then fewest seeks, on a tie).
+ * If that is a single key, other single-key indexes pinning further
+ * fields are added for intersection. */
+static bool _seek_choose(mongolite_cached_index_t *indexes, size_t index_count,
+                         seek_clause_t *c) {
+    c->n_paths = 0;
+    if (c->text) {
+        /* Nothing else can evaluate $text: the text index or no plan */
+        for (size_t i = 0; i < index_count; i++) {
+            if (!indexes[i].text) continue;
+            c->paths[0] = (seek_path_t){.index = &indexes[i]};
+            c->n_paths = 1;
+            c->covered = c->all_seekable && c->n_fields == 0;
+            return true;
+        }
+        return false;
+    }
+    if (c->geo.field) {
+        /* The field's geo index, else the matcher evaluates it */
+        for (size_t i = 0; i < index_count; i++) {
+            const char *field = indexes[i].geo ? _mongolite_geo_spec(indexes[i].keys) : NULL;
+            if (!field || strcmp(field, c->geo.field) != 0) continue;
+            c->paths[0] = (seek_path_t){.index = &indexes[i]};
+            c->n_paths = 1;
+            c->covered = false;
+            return true;
+        }
+        c->geo.field = NULL;
+        c->all_seekable = false;
+    }
+
+    for (size_t i = 0; i < c->n_fields; i++) {
+        if (strcmp(c->fields[i].field, "_id") == 0) {
+            c->paths[0] = (seek_path_t){.index = NULL, .order = {i}, .n_order = 1,
+                                        .points = c->fields[i].count};
+            c->n_paths = 1;
+            c->covered = c->all_seekable && c->n_fields == 1;
+            return true;
+        }
+    }
+
+    seek_path_t *best = &c->paths[0];
+    double best_cost = 0;
+    for (size_t i = 0; i < index_count; i++) {
+        seek_path_t path;
+        if (!_seek_path(&indexes[i], c, &path)) continue;
+        double cost = _seek_cost(c, &path);
+        if (c->n_paths == 0 || cost < best_cost ||
+            (cost == best_cost && (path.n_order > best->n_order ||
+                                   (path.n_order == best->n_order &&
+                                    path.points < best->points)))) {
+            *best = path;
+            best_cost = cost;
+            c->n_paths = 1;
+        }
+    }
+    if (c->n_paths == 0) return false;
+
+    bool pinned[SEEK_MAX_FIELDS] = {false};
+    size_t n_pinned = 0;
+    for (size_t k = 0; k < best->n_order; k++) {
+        pinned[best->order[k]] = true;
+        n_pinned++;
+    }
+
+    for (size_t i = 0; i < index_count && best->points == 1 && c->n_paths < SEEK_MAX_PATHS; i++) {
+        seek_path_t path;
+        if (&indexes[i] == best->index || !_seek_path(&indexes[i], c, &path) ||
+            path.points != 1) {
+            continue;
+        }
+        size_t fresh = 0;
+        for (size_t k = 0; k < path.n_order; k++) fresh += !pinned[path.order[k]];
+        if (fresh == 0) continue;
+
+        for (size_t k = 0; k < path.n_order; k++) {
+            if (!pinned[path.order[k]]) n_pinned++;
+            pinned[path.order[k]] = true;
+        }
+        c->paths[c->n_paths++] = path;
+    }
+
+    c->covered = c->all_seekable && n_pinned == c->n_fields;
+    return true;
+}
+
+/* The whole filter on one access path, else a union over its $or.
+ * On success the caller frees plan->clauses. */
+static bool _seek_plan(mongolite_db_t *db, mongolite_tree_cache_entry_t *entry,
+                       const bson_t *filter, seek_plan_t *plan, gerror_t *error) {
+    if (!filter || bson_empty(filter)) return false;
+
+    size_t index_count = 0;
+    mongolite_cached_index_t *indexes = _mongolite_entry_indexes(db, entry, &index_count, error);
+    if (!indexes) index_count = 0;
+
+    seek_clause_t top;
+    _seek_parse_clause(filter, &top);
+    if ((top.n_fields > 0 || top.text || top.geo.field) &&
+        _seek_choose(indexes, index_count, &top)) {
+        if (!(plan->clauses = malloc(sizeof(seek_clause_t)))) return false;
+        plan->clauses[0] = top;
+        plan->n_clauses = 1;
+        plan->covered = top.covered;
+        return true;
+    }
+
+    bson_iter_t iter, elems;
+    if (!bson_iter_init_find(&iter, filter, "$or") || !BSON_ITER_HOLDS_ARRAY(&iter) ||
+        !bson_iter_recurse(&iter, &elems)) {
+        return false;
+    }
+    size_t n = 0;
+    bson_iter_t count = elems;
+    while (bson_iter_next(&count)) n++;
+    if (n == 0 || n > SEEK_MAX_CLAUSES || !(plan->clauses = malloc(n * sizeof(seek_clause_t)))) {
+        return false;
+    }
+
+    plan->n_clauses = 0;
+    plan->covered = bson_count_keys(filter) == 1;
+    while (bson_iter_next(&elems)) {
+        bson_t clause;
+        uint32_t len;
+        const uint8_t *data;
+        seek_clause_t *c = &plan->clauses[plan->n_clauses];
+        if (!BSON_ITER_HOLDS_DOCUMENT(&elems)) break;
+        bson_iter_document(&elems, &len, &data);
+        if (!bson_init_static(&clause, data, len)) break;
+
+        _seek_parse_clause(&clause, c);
+        if (c->text || c->geo.field || c->n_fields == 0 ||
+            !_seek_choose(indexes, index_count, c)) {
+            break;
+        }
+        plan->covered = plan->covered && c->covered;
+        plan->n_clauses++;
+    }
+
+    if (plan->n_clauses < n) {
+        free(plan->clauses);
+        return false;
+    }
+    return true;
+}
+
+static bool _seek_push(bson_oid_t **ids, size_t *n, size_t *cap, const void *key) {
+    if (*n == *cap) {
+        size_t grown = *cap ? *cap * 2 : 64;
+        bson_oid_t *tmp = realloc(*ids, grown * sizeof(bson_oid_t));
+        if (!tmp) return false;
+        *ids = tmp;
+        *cap = grown;
+    }
+    memcpy((*ids)[(*n)++].bytes, key, sizeof(bson_oid_t));
+    return true;
+}
+
+/* Move to the next key combination (last field fastest); false when done */
+static bool _seek_advance(const seek_clause_t *c, const seek_path_t *path, bson_iter_t *cur) {
+    for (size_t i = path->n_order; i-- > 0;) {
+        const seek_field_t *f = &c->fields[path->order[i]];
+        if (!f->is_in) continue;
+        if (bson_iter_next(&cur[i])) return true;
+        bson_iter_recurse(&f->value, &cur[i]);
+        bson_iter_next(&cur[i]);
+    }
+    return false;
+}
+
+/* First key combination; false if an $in is empty */
+static bool _seek_first(const seek_clause_t *c, const seek_path_t *path, bson_iter_t *cur) {
+    for (size_t i = 0; i < path->n_order; i++) {
+        const seek_field_t *f = &c->fields[path->order[i]];
+        if (!f->is_in) {
+            cur[i] = f->value;
+        } else if (!bson_iter_recurse(&f->value, &cur[i]) || !bson_iter_next(&cur[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void _seek_key(const seek_clause_t *c, const seek_path_t *path, const bson_iter_t *cur,
+                      bson_t *key) {
+    bson_init(key);
+    for (size_t i = 0; i < path->n_order; i++) {
+        bson_append_iter(key, c->fields[path->order[i]].field, -1, &cur[i]);
+    }
+}
+
+/* Index entries a path is expected to read: the histogram's estimate
+ * for each key combination, or the average per key past a few */
+static double _seek_cost(const seek_clause_t *c, const seek_path_t *path) {
+    if (path->points > SEEK_COST_POINTS) {
+        return (double)path->points * _mongolite_index_estimate(path->index, NULL);
+    }
+
+    bson_iter_t cur[SEEK_MAX_FIELDS];
+    if (!_seek_first(c, path, cur)) return 0;
+
+    double cost = 0;
+    bson_t key;
+    do {
+        _seek_key(c, path, cur, &key);
+        cost += _mongolite_index_estimate(path->index, &key);
+        bson_destroy(&key);
+    } while (_seek_advance(c, path, cur));
+    return cost;
+}
+
+/* Leapfrog over cursors positioned on their keys, use[0] the smallest
+ * stream: every other cursor moves to the first duplicate >= the
+ * candidate, and a candidate all of them hold is a match. Returns 1, 0
+ * when a duplicate is not a collection key, or an error code. */
+static int _seek_join(MDB_cursor **cursors, MDB_val *kv, const size_t *use, size_t m,
+                      bson_oid_t **ids, size_t *n, size_t *cap, uint64_t *keys_examined) {
+    MDB_cursor *driver = cursors[use[0]];
+    MDB_val v;
+    int rc = mdb_cursor_get(driver, &kv[use[0]], &v, MDB_GET_CURRENT);
+    while (rc == MDB_SUCCESS) {
+        if (v.mv_size != sizeof(bson_oid_t)) {
+            return 0;                   /* Not a collection key: leave it to a scan */
+        }
+        uint8_t target[sizeof(bson_oid_t)];
+        memcpy(target, v.mv_data, sizeof(target));
+
+        bool all = true;
+        for (size_t j = 1; j < m && rc == MDB_SUCCESS; j++) {
+            MDB_val t = {.mv_size = sizeof(target), .mv_data = target};
+            rc = mdb_cursor_get(cursors[use[j]], &kv[use[j]], &t, MDB_GET_BOTH_RANGE);
+            if (rc == MDB_SUCCESS) (*keys_examined)++;
+            if (rc == MDB_SUCCESS && memcmp(t.mv_data, target, sizeof(target)) != 0) {
+                memcpy(target, t.mv_data, sizeof(target));
+                all = false;
+                break;
+            }
+        }
+        if (rc != MDB_SUCCESS) break;
+
+        if (all) {
+            if (!_seek_push(ids, n, cap, target)) return MONGOLITE_ENOMEM;
+            rc = mdb_cursor_get(driver, &kv[use[0]], &v, MDB_NEXT_DUP);
+        } else {
+            v = (MDB_val){.mv_size = sizeof(target), .mv_data = target};
+            rc = mdb_cursor_get(driver, &kv[use[0]], &v, MDB_GET_BOTH_RANGE);
+        }
+        if (rc == MDB_SUCCESS) (*keys_examined)++;
+    }
+    return rc == MDB_NOTFOUND ? 1 : rc;
+}
+
+/* Merge-join the duplicates of one key per path. The smallest stream
+ * drives; a larger one joins only while walking it costs less than the
+ * fetches it could save (*dropped: the matcher must cover for it).
+ * Returns 1, 0 or an error code as _seek_clause. */
+static int _seek_intersect(mongolite_db_t *db, MDB_txn *mtxn, const seek_clause_t *c,
+                           bson_oid_t **ids, size_t *n, size_t *cap, bool *dropped,
+                           uint64_t *keys_examined) {
+    MDB_cursor *cursors[SEEK_MAX_PATHS] = {NULL};
+    bson_t keys[SEEK_MAX_PATHS];
+    MDB_val kv[SEEK_MAX_PATHS];
+    size_t counts[SEEK_MAX_PATHS];
+    size_t use[SEEK_MAX_PATHS];
+    size_t opened = 0, m = 0;
+    int rc = MDB_SUCCESS, result = 1;
+
+    for (size_t p = 0; p < c->n_paths; p++) {
+        bson_iter_t cur[SEEK_MAX_FIELDS];
+        MDB_val v;
+        _seek_first(c, &c->paths[p], cur);
+        _seek_key(c, &c->paths[p], cur, &keys[p]);
+        opened++;
+
+        rc = mdb_cursor_open(mtxn, c->paths[p].index->dbi, &cursors[p]);
+        if (rc != MDB_SUCCESS) goto done;
+        kv[p] = (MDB_val){.mv_size = keys[p].len, .mv_data = (void *)bson_get_data(&keys[p])};
+        rc = mdb_cursor_get(cursors[p], &kv[p], &v, MDB_SET_KEY);
+        if (rc == MDB_SUCCESS) rc = mdb_cursor_count(cursors[p], &counts[p]);
+        if (rc != MDB_SUCCESS) goto done;   /* A missing key: empty intersection */
+        (*keys_examined)++;
+
+        /* Keep use[] ordered by count */
+        size_t at = m++;
+        while (at > 0 && counts[use[at - 1]] > counts[p]) {
+            use[at] = use[at - 1];
+            at--;
+        }
+        use[at] = p;
+    }
+    while (m > 1 && counts[use[m - 1]] > counts[use[0]] * SEEK_JOIN_RATIO) m--;
+    if (m < c->n_paths) *dropped = true;
+    if (m > 1) MONGOLITE_STAT(db, index_intersections, 1);
+
+    result = _seek_join(cursors, kv, use, m, ids, n, cap, keys_examined);
+
+done:
+    for (size_t p = 0; p < opened; p++) {
+        if (cursors[p]) mdb_cursor_close(cursors[p]);
+        bson_destroy(&keys[p]);
+    }
+    if (result == 1 && rc != MDB_SUCCESS && rc != MDB_NOTFOUND) result = rc;
+    return result;
+}
+
+/* $text: the posting list of every term of the search, all joined (no
+ * stream is dropped, as the matcher cannot check $text). A search
+ * without terms finds nothing. Returns 1 or an error code. */
+static int _seek_text(mongolite_db_t *db, MDB_txn *mtxn, const seek_clause_t *c,
+                      bson_oid_t **ids, size_t *n, size_t *cap, uint64_t *keys_examined) {
+    mongolite_text_terms_t t;
+    _mongolite_text_terms_init(&t);
+    if (!_mongolite_text_terms_add(&t, c->text, c->text_len)) {
+        _mongolite_text_terms_free(&t);
+        return MONGOLITE_ENOMEM;
+    }
+    _mongolite_text_terms_finish(&t);
+    if (t.n == 0) {
+        _mongolite_text_terms_free(&t);
+        return 1;
+    }
+
+    MDB_cursor **cursors = calloc(t.n, sizeof(*cursors));
+    MDB_val *kv = malloc(t.n * sizeof(*kv));
+    size_t *counts = malloc(t.n * sizeof(*counts));
+    size_t *use = malloc(t.n * sizeof(*use));
+    int rc = (cursors && kv && counts && use) ? MDB_SUCCESS : MONGOLITE_ENOMEM;
+
+    size_t m = 0;
+    for (size_t p = 0; p < t.n && rc == MDB_SUCCESS; p++) {
+        bson_t key;
+        MDB_val v;
+        _mongolite_text_key(&t.terms[p], &key);
+        kv[p] = (MDB_val){.mv_size = key.len, .mv_data = (void *)bson_get_data(&key)};
+        rc = mdb_cursor_open(mtxn, c->paths[0].index->dbi, &cursors[p]);
+        /* On success kv[p] points at the key in the map */
+        if (rc == MDB_SUCCESS) rc = mdb_cursor_get(cursors[p], &kv[p], &v, MDB_SET_KEY);
+        if (rc == MDB_SUCCESS) rc = mdb_cursor_count(cursors[p], &counts[p]);
+        bson_destroy(&key);
+        if (rc != MDB_SUCCESS) break;   /* A missing term: no documents */
+        (*keys_examined)++;
+
+        size_t at = m++;
+        while (at > 0 && counts[use[at - 1]] > counts[p]) {
+            use[at] = use[at - 1];
+            at--;
+        }
+        use[at] = p;
+    }
+
+    int result = rc == MDB_NOTFOUND ? 1 : rc;
+    if (rc == MDB_SUCCESS) {
+        if (m > 1) MONGOLITE_STAT(db, index_intersections, 1);
+        result = _seek_join(cursors, kv, use, m, ids, n, cap, keys_examined);
+    }
+
+    for (size_t p = 0; cursors && p < t.n; p++) {
+        if (cursors[p]) mdb_cursor_close(cursors[p]);
+    }
+    free(cursors);
+    free(kv);
+    free(counts);
+    free(use);
+    _mongolite_text_terms_free(&t);
+    return result;
+}
+
+/* $geoWithin: the points in the query's bounding box. $near is only
+ * read through _mongolite_index_seek_near (0: leave it to a scan). */
+static int _seek_geo(MDB_txn *mtxn, const seek_clause_t *c,
+                     bson_oid_t **ids, size_t *n, size_t *cap, uint64_t *keys_examined) {
+    if (c->geo.near) return 0;
+
+    bson_oid_t *found = NULL;
+    size_t n_found = 0;
+    int rc = _mongolite_geo_within(mtxn, c->paths[0].index->dbi, &c->geo, &found, &n_found,
+                                   keys_examined);
+    if (rc == 1 && *n == 0) {
+        /* The only clause (geo clauses are never in an $or): take the list */
+        free(*ids);
+        *ids = found;
+        *n = *cap = n_found;
+        return 1;
+    }
+    for (size_t i = 0; rc == 1 && i < n_found; i++) {
+        if (!_seek_push(ids, n, cap, found[i].bytes)) rc = MONGOLITE_ENOMEM;
+    }
+    free(found);
+    return rc;
+}
+
+/* Append the collection keys a clause's seeks find, counting the index
+ * entries read. Returns 1, 0 when an index entry does not hold a
+ * collection key, or an error code. */
+static int _seek_clause(mongolite_db_t *db, MDB_txn *mtxn, const seek_clause_t *c,
+                        bson_oid_t **ids, size_t *n, size_t *cap, bool *dropped,
+                        uint64_t *keys_examined) {
+    if (c->text) {
+        return _seek_text(db, mtxn, c, ids, n, cap, keys_examined);
+    }
+    if (c->geo.field) {
+        return _seek_geo(mtxn, c, ids, n, cap, keys_examined);
+    }
+    if (c->n_paths > 1) {
+        return _seek_intersect(db, mtxn, c, ids, n, cap, dropped, keys_examined);
+    }
+
+    const seek_path_t *path = &c->paths[0];
+    bson_iter_t cur[SEEK_MAX_FIELDS];
+    if (!_seek_first(c, path, cur)) return 1;      /* Empty $in: no keys */
+
+    if (!path->index) {
+        do {
+            if (!_seek_push(ids, n, cap, bson_iter_oid(&cur[0])->bytes)) return MONGOLITE_ENOMEM;
+            (*keys_examined)++;
+        } while (_seek_advance(c, path, cur));
+        return 1;
+    }
+
+    MDB_cursor *cursor = NULL;
+    int rc = mdb_cursor_open(mtxn, path->index->dbi, &cursor);
+    if (rc != MDB_SUCCESS) return rc;
+
+    int result = 1;
+    bson_t key;
+    do {
+        _seek_key(c, path, cur, &key);
+        MDB_val k = {.mv_size = key.len, .mv_data = (void *)bson_get_data(&key)};
+        MDB_val v;
+        rc = mdb_cursor_get(cursor, &k, &v, MDB_SET_KEY);
+        while (rc == MDB_SUCCESS) {
+            if (v.mv_size != sizeof(bson_oid_t)) {
+                rc = MDB_NOTFOUND;
+                result = 0;             /* Not a collection key: leave it to a scan */
+                break;
+            }
+            if (!_seek_push(ids, n, cap, v.mv_data)) {
+                rc = MONGOLITE_ENOMEM;
+                break;
+            }
+            (*keys_examined)++;
+            rc = mdb_cursor_get(cursor, &k, &v, MDB_NEXT_DUP);
+        }
+        bson_destroy(&key);
+
+        if (rc != MDB_NOTFOUND) result = rc;
+    } while (result == 1 && _seek_advance(c, path, cur));
+
+    mdb_cursor_close(cursor);
+    return result;
+}
+
+static bool _seek_plannable(mongolite_db_t *db, mongolite_tree_cache_entry_t *entry,
+                            const bson_t *filter, bool *intersects, gerror_t *error) {
+    seek_plan_t plan;
+    if (!_seek_plan(db, entry, filter, &plan, error)) return false;
+    *intersects = false;
+    for (size_t i = 0; i < plan.n_clauses; i++) {
+        if (plan.clauses[i].n_paths > 1) *intersects = true;
+    }
+    free(plan.clauses);
+    return true;
+}
+
+int _mongolite_index_seek_ids(mongolite_db_t *db, mongolite_tree_cache_entry_t *entry,
+                              wtree3_txn_t *txn, const bson_t *filter,
+                              bson_oid_t **out_ids, size_t *out_n, bool *out_residual,
+                              uint64_t *out_keys, gerror_t *error) {
+    seek_plan_t plan;
+    if (!_seek_plan(db, entry, filter, &plan, error)) return 0;
+
+    MDB_txn *mtxn = wtree3_txn_get_mdb(txn);
+    bson_oid_t *ids = NULL;
+    size_t n = 0, cap = 0;
+    int rc = 1;
+    bool dropped = false;
+    uint64_t keys = 0;
+    for (size_t i = 0; i < plan.n_clauses && rc == 1; i++) {
+        rc = _seek_clause(db, mtxn, &plan.clauses[i], &ids, &n, &cap, &dropped, &keys);
+    }
+    if (out_keys) *out_keys = keys;
+    MONGOLITE_TRACE(db, keys_examined, keys);
+    free(plan.clauses);
+
+    if (rc == MONGOLITE_ENOMEM) {
+        free(ids);
+        set_error(error, "system", MONGOLITE_ENOMEM, "Failed to allocate seek results");
+        return MONGOLITE_ENOMEM;
+    }
+    if (rc != 1) {
+        free(ids);
+        if (rc == 0) return 0;
+        set_error(error, "lmdb", rc, "Index seek failed: %s", mdb_strerror(rc));
+        return rc;
+    }
+
+    /* Never hand back NULL: an empty list still means "no documents" */
+    if (!ids && !(ids = malloc(sizeof(bson_oid_t)))) {
+        set_error(error, "system", MONGOLITE_ENOMEM, "Failed to allocate seek results");
+        return MONGOLITE_ENOMEM;
+    }
+    *out_ids = ids;
+    *out_n = _mongolite_oids_sort_unique(ids, n);
+    *out_residual = !plan.covered || dropped;
+    return 1;
+}
+
+int _mongolite_index_seek_near(mongolite_db_t *db, mongolite_tree_cache_entry_t *entry,
+                               const bson_t *filter, mongolite_geo_near_t **out_near,
+                               bson_t **out_rest, gerror_t *error) {
+    seek_plan_t plan;
+    if (!_seek_plan(db, entry, filter, &plan, error)) return 0;
+
+    const seek_clause_t *c = &plan.clauses[0];
+    if (plan.n_clauses != 1 || !c->geo.field || !c->geo.near) {
+        free(plan.clauses);
+        return 0;
+    }
+
+    mongolite_geo_near_t *near = _mongolite_geo_near_new(c->paths[0].index->dbi, &c->geo);
+    bson_t *rest = bson_new();
+    bson_copy_to_excluding_noinit(filter, rest, c->geo.field, NULL);
+    free(plan.clauses);
+    if (!near) {
+        bson_destroy(rest);
+        set_error(error, "system", MONGOLITE_ENOMEM, "Failed to allocate $near search");
+        return MONGOLITE_ENOMEM;
+    }
+    if (bson_empty(rest)) {
+        bson_destroy(rest);
+        rest = NULL;
+    }
+    *out_near = near;
+    *out_rest = rest;
+    return 1;
+}
+
+/* ============================================================
+ * Explain
+ *
+ * The seek plan as a stage tree: IXSCAN (point keys on one index),
+ * ID_LOOKUP (_id values), AND_SORTED (indexes intersected; at run time
+ * a stream much larger than the smallest one is left to the matcher),
+ * OR (a union over $or clauses), TEXT, GEO_NEAR and GEO_WITHIN.
+ * ============================================================ */
+
+#define EXPLAIN_MAX_BOUNDS 32           /* Point keys listed per path */
+
+/* TEXT: the terms whose posting lists are joined */
+static void _explain_text(const seek_clause_t *c, const seek_path_t *path, bson_t *out) {
+    BSON_APPEND_UTF8(out, "stage", "TEXT");
+    BSON_APPEND_UTF8(out, "indexName", path->index->name);
+    BSON_APPEND_DOCUMENT(out, "keyPattern", path->index->keys);
+
+    mongolite_text_terms_t t;
+    bson_t terms;
+    _mongolite_text_terms_init(&t);
+    if (_mongolite_text_terms_add(&t, c->text, c->text_len)) _mongolite_text_terms_finish(&t);
+    else t.n = 0;
+    BSON_APPEND_ARRAY_BEGIN(out, "terms", &terms);
+    for (size_t i = 0; i < t.n; i++) {
+        char buf[16];
+        const char *k;
+        bson_uint32_to_string((uint32_t)i, &k, buf, sizeof(buf));
+        bson_append_utf8(&terms, k, -1, t.terms[i].p, (int)t.terms[i].len);
+    }
+    bson_append_array_end(out, &terms);
+    _mongolite_text_terms_free(&t);
+}
+
+/* GEO_NEAR / GEO_WITHIN: the center or the box the cells cover */
+static void _explain_geo(const seek_clause_t *c, const seek_path_t *path, bson_t *out) {
+    const mongolite_geo_query_t *q = &c->geo;
+    BSON_APPEND_UTF8(out, "stage", q->near ? "GEO_NEAR" : "GEO_WITHIN");
+    BSON_APPEND_UTF8(out, "indexName", path->index->name);
+    BSON_APPEND_DOCUMENT(out, "keyPattern", path->index->keys);
+
+    bson_t coords;
+    if (q->near) {
+        BSON_APPEND_ARRAY_BEGIN(out, "near", &coords);
+        BSON_APPEND_DOUBLE(&coords, "0", q->x);
+        BSON_APPEND_DOUBLE(&coords, "1", q->y);
+        bson_append_array_end(out, &coords);
+        BSON_APPEND_BOOL(out, "spherical", q->sphere);
+        if (q->min_d > 0) BSON_APPEND_DOUBLE(out, "minDistance", q->min_d);
+        if (isfinite(q->max_d)) BSON_APPEND_DOUBLE(out, "maxDistance", q->max_d);
+        return;
+    }
+    BSON_APPEND_ARRAY_BEGIN(out, "box", &coords);
+    for (uint32_t i = 0; i < 4; i++) {
+        char buf[16];
+        const char *k;
+        bson_uint32_to_string(i, &k, buf, sizeof(buf));
+        BSON_APPEND_DOUBLE(&coords, k, q->box[i]);
+    }
+    bson_append_array_end(out, &coords);
+}
+
+static void _explain_path(const seek_clause_t *c, const seek_path_t *path, bson_t *out) {
+    if (c->text) {
+        _explain_text(c, path, out);
+        return;
+    }
+    if (c->geo.field) {
+        _explain_geo(c, path, out);
+        return;
+    }
+    BSON_APPEND_UTF8(out, "stage", path->index ? "IXSCAN" : "ID_LOOKUP");
+    if (path->index) {
+        BSON_APPEND_UTF8(out, "indexName", path->index->name);
+        BSON_APPEND_DOCUMENT(out, "keyPattern", path->index->keys);
+        BSON_APPEND_DOUBLE(out, "estimatedKeys", _seek_cost(c, path));
+    }
+    BSON_APPEND_INT64(out, "seeks", (int64_t)path->points);
+
+    bson_t bounds;
+    bson_iter_t cur[SEEK_MAX_FIELDS];
+    BSON_APPEND_ARRAY_BEGIN(out, "indexBounds", &bounds);
+    if (_seek_first(c, path, cur)) {
+        uint32_t i = 0;
+        do {
+            char buf[16];
+            const char *k;
+            bson_t key;
+            bson_uint32_to_string(i, &k, buf, sizeof(buf));
+            _seek_key(c, path, cur, &key);
+            BSON_APPEND_DOCUMENT(&bounds, k, &key);
+            bson_destroy(&key);
+        } while (++i < EXPLAIN_MAX_BOUNDS && _seek_advance(c, path, cur));
+    }
+    bson_append_array_end(out, &bounds);
+    if (path->points > EXPLAIN_MAX_BOUNDS) BSON_APPEND_BOOL(out, "boundsTruncated", true);
+}
+
+static void _explain_clause(const seek_clause_t *c, bson_t *out) {
+    if (c->n_paths == 1) {
+        _explain_path(c, &c->paths[0], out);
+        return;
+    }
+
+    bson_t inputs, child;
+    BSON_APPEND_UTF8(out, "stage", "AND_SORTED");
+    BSON_APPEND_ARRAY_BEGIN(out, "inputStages", &inputs);
+    for (size_t p = 0; p < c->n_paths; p++) {
+        char buf[16];
+        const char *k;
+        bson_uint32_to_string((uint32_t)p, &k, buf, sizeof(buf));
+        BSON_APPEND_DOCUMENT_BEGIN(&inputs, k, &child);
+        _explain_path(c, &c->paths[p], &child);
+        bson_append_document_end(&inputs, &child);
+    }
+    bson_append_array_end(out, &inputs);
+}
+
+bool _mongolite_index_explain(mongolite_db_t *db, mongolite_tree_cache_entry_t *entry,
+                              const bson_t *filter, bson_t *stage, bson_t *candidates,
+                              gerror_t *error) {
+    size_t index_count = 0;
+    mongolite_cached_index_t *indexes = _mongolite_entry_indexes(db, entry, &index_count, error);
+    if (!indexes) index_count = 0;
+
+    /* The clauses the indexes are weighed against: the plan's, else the
+     * filter's own predicates */
+    seek_plan_t plan = {0};
+    seek_clause_t top;
+    bool planned = _seek_plan(db, entry, filter, &plan, error);
+    if (!planned) {
+        memset(&top, 0, sizeof(top));
+        if (filter) _seek_parse_clause(filter, &top);
+        plan.clauses = &top;
+        plan.n_clauses = 1;
+    }
+
+    if (planned && plan.n_clauses == 1) {
+        _explain_clause(&plan.clauses[0], stage);
+    } else if (planned) {
+        bson_t inputs, child;
+        BSON_APPEND_UTF8(stage, "stage", "OR");
+        BSON_APPEND_ARRAY_BEGIN(stage, "inputStages", &inputs);
+        for (size_t i = 0; i < plan.n_clauses; i++) {
+            char buf[16];
+            const char *k;
+            bson_uint32_to_string((uint32_t)i, &k, buf, sizeof(buf));
+            BSON_APPEND_DOCUMENT_BEGIN(&inputs, k, &child);
+            _explain_clause(&plan.clauses[i], &child);
+            bson_append_document_end(&inputs, &child);
+        }
+        bson_append_array_end(stage, &inputs);
+    }
+
+    for (size_t i = 0; i < index_count; i++) {
+        bool chosen = false, usable = false;
+        double cost = 0;
+        for (size_t j = 0; j < plan.n_clauses; j++) {
+            const seek_clause_t *c = &plan.clauses[j];
+            seek_path_t path;
+            for (size_t p = 0; planned && p < c->n_paths; p++) {
+                if (c->paths[p].index == &indexes[i]) chosen = true;
+            }
+            if (_seek_path(&indexes[i], c, &path)) {
+                usable = true;
+                cost += _seek_cost(c, &path);
+            }
+        }
+
+        char buf[16];
+        const char *k;
+        bson_t doc;
+        bson_uint32_to_string((uint32_t)i, &k, buf, sizeof(buf));
+        BSON_APPEND_DOCUMENT_BEGIN(candidates, k, &doc);
+        BSON_APPEND_UTF8(&doc, "indexName", indexes[i].name);
+        if (indexes[i].keys) BSON_APPEND_DOCUMENT(&doc, "keyPattern", indexes[i].keys);
+        BSON_APPEND_BOOL(&doc, "isMultiKey", indexes[i].multikey);
+        BSON_APPEND_BOOL(&doc, "analyzed", indexes[i].hist != NULL);
+        BSON_APPEND_DOUBLE(&doc, "rowsPerKey", _mongolite_index_estimate(&indexes[i], NULL));
+        if (usable) BSON_APPEND_DOUBLE(&doc, "estimatedKeys", cost);
+        BSON_APPEND_BOOL(&doc, "chosen", chosen);
+        if (!chosen) {
+            BSON_APPEND_UTF8(&doc, "rejected",
+                             usable ? "higher estimated cost" :
+                             indexes[i].legacy ? "created before multi-key indexes (re-create it)" :
+                             "key fields not all pinned by the filter");
+        }
+        bson_append_document_end(candidates, &doc);
+    }
+
+    if (planned) free(plan.clauses);
+    return planned;
+}
@@ -0,0 +1,124 @@
+/*
+ * mongolite_readahead.c - Readahead hints for scans and index fetches
+ *
+ * Handles:
+ * - WILLNEED windows ahead of a scan's position in the map
+ * - Batched fetches by _id: look the _ids up together, then hint the
+ *   documents stored on their own pages
+ *
+ * LMDB read results point into its memory map, so the address of the
+ * value just read is a position in the data file. A cold scan otherwise
+ * faults its pages in one at a time; a hint lets the kernel read ahead
+ * while the matcher works. Hints are advisory: a failure turns them off.
+ *
+ * Scans use WILLNEED windows rather than MADV_SEQUENTIAL, which applies
+ * to the whole map and would make concurrent point lookups drop pages.
+ */
+
+#include "mongolite_internal.h"
+#include "macros.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MONGOLITE_LIB "mongolite"
+
+/* ============================================================
+ * Setup
+ * ============================================================ */
+
+void _mongolite_readahead_init(mongolite_db_t *db, wtree3_txn_t *txn,
+                               mongolite_readahead_t *ra) {
+    memset(ra, 0, sizeof(*ra));
+    ra->db = db;
+    if (!db->readahead_bytes || !txn || !wtree3_txn_is_readonly(txn)) return;
+
+    ra->page_size = db->map_policy.page_size ? db->map_policy.page_size : 4096;
+    ra->window = db->readahead_bytes < ra->page_size ? ra->page_size : db->readahead_bytes;
+}
+
+static void _hint(mongolite_readahead_t *ra, const void *addr, size_t len) {
+    if (wtree3_db_prefetch_addr(ra->db->wdb, addr, len, NULL) != 0) {
+        ra->window = 0;                 /* Unsupported here: stop trying */
+        return;
+    }
+    MONGOLITE_STAT(ra->db, readahead_hints, 1);
+}
+
+/* ============================================================
+ * Scans
+ * ============================================================ */
+
+MONGOLITE_HOT
+void _mongolite_readahead_seq(mongolite_readahead_t *ra, const void *ptr) {
+    uintptr_t p = (uintptr_t)ptr;
+    if (!ra->window) return;
+
+    /* Still in the first half of the last window */
+    if (p >= ra->start && p < ra->next) return;
+
+    _hint(ra, ptr, ra->window);
+    ra->start = p - p % ra->page_size;
+    ra->next = ra->start + ra->window / 2;
+}
+
+/* ============================================================
+ * Fetches by _id
+ * ============================================================ */
+
+int _mongolite_fetch_batch(mongolite_readahead_t *ra, wtree3_txn_t *txn,
+                           wtree3_tree_t *tree, const void *const *ids, size_t n,
+                           mongolite_fetch_t *out, gerror_t *error) {
+    wtree3_kv_t stack_keys[MONGOLITE_FETCH_BATCH];
+    const void *stack_values[MONGOLITE_FETCH_BATCH];
+    size_t stack_lens[MONGOLITE_FETCH_BATCH];
+    wtree3_kv_t *keys = stack_keys;
+    const void **values = stack_values;
+    size_t *lens = stack_lens;
+
+    for (size_t i = 0; i < n; i++) {
+        out[i].data = NULL;
+        out[i].len = 0;
+    }
+    if (n == 0) return MONGOLITE_OK;
+
+    if (n > MONGOLITE_FETCH_BATCH) {
+        keys = malloc(n * sizeof(*keys));
+        values = malloc(n * sizeof(*values));
+        lens = malloc(n * sizeof(*lens));
+        if (!keys || !values || !lens) {
+            free(keys);
+            free(values);
+            free(lens);
+            set_error(error, "system", MONGOLITE_ENOMEM, "Failed to allocate lookup batch");
+            return MONGOLITE_ENOMEM;
+        }
+    }
+
+    /* Lookups first, sorted through one cursor: each touches its leaf,
+     * but not an overflow value */
+    for (size_t i = 0; i < n; i++) {
+        keys[i] = (wtree3_kv_t){.key = ids[i], .key_len = sizeof(bson_oid_t)};
+    }
+    int rc = wtree3_get_many_txn(txn, tree, keys, n, values, lens, error);
+    if (rc == 0) {
+        for (size_t i = 0; i < n; i++) {
+            out[i].data = values[i];
+            out[i].len = values[i] ? lens[i] : 0;
+        }
+
+        /* Values of half a page or more live on their own (overflow) pages */
+        for (size_t i = 0; i < n && ra->window; i++) {
+            if (out[i].data && out[i].len >= ra->page_size / 2) {
+                _hint(ra, out[i].data, out[i].len);
+            }
+        }
+    }
+
+    if (keys != stack_keys) {
+        free(keys);
+        free(values);
+        free(lens);
+    }
+    return rc;
+}
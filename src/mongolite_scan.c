@@ -0,0 +1,606 @@
+/*
+ * mongolite_scan.c - Parallel collection scan
+ *
+ * Handles:
+ * - Splitting a collection's _id key space into ranges
+ * - Worker threads, each with its own read txn and matcher
+ * - Results per range: match counts, matching keys or documents
+ * - Consumption in key order or in completion order, with bounded
+ *   read-ahead so buffered results stay small
+ *
+ * All worker txns begin while the caller holds the db lock. Commits take
+ * that lock too, so every worker reads the same snapshot.
+ */
+
+#include "mongolite_internal.h"
+#include "macros.h"
+#include <stdlib.h>
+#include <string.h>
+
+#include "mongoc-matcher.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <process.h>
+#else
+#include <pthread.h>
+#endif
+
+#define MONGOLITE_LIB "mongolite"
+
+/* Longest key used as a range bound (ObjectId keys are 12 bytes) */
+#define MONGOLITE_SCAN_KEY_MAX 64
+
+/* Range sizing: about this many documents each, at least this many
+ * ranges per worker (uneven ranges even out), at most this many ranges */
+#define MONGOLITE_SCAN_RANGE_DOCS   8192
+#define MONGOLITE_SCAN_RANGES_PER_WORKER 4
+#define MONGOLITE_SCAN_MAX_RANGES   4096
+
+/* Ranges a worker may run ahead of the consumer (per worker) */
+#define MONGOLITE_SCAN_WINDOW_PER_WORKER 2
+
+/* ============================================================
+ * State
+ * ============================================================ */
+
+typedef struct {
+    uint8_t lo[MONGOLITE_SCAN_KEY_MAX]; /* First key of the range (inclusive) */
+    size_t lo_len;                      /* 0 = from the first key */
+    bool done;
+    bool consumed;
+
+    /* COUNT: matched only. KEYS / DOCS: [uint32 len][bytes] records */
+    uint8_t *buf;
+    size_t len;
+    size_t cap;
+    uint64_t scanned;
+    uint64_t matched;
+} scan_range_t;
+
+typedef struct {
+    mongolite_scan_t *scan;
+    unsigned int index;
+    mongoc_matcher_t *matcher;          /* Own matcher: not shared across threads */
+#ifdef _WIN32
+    HANDLE thread;
+#else
+    pthread_t thread;
+#endif
+    bool started;
+} scan_worker_t;
+
+struct mongolite_scan {
+    mongolite_db_t *db;
+    wtree3_tree_t *tree;
+    mongolite_scan_mode_t mode;
+    bool ordered;
+
+#ifdef _WIN32
+    CRITICAL_SECTION mutex;
+    CONDITION_VARIABLE cond;
+#else
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;                /* Any state change (few threads, one cond) */
+#endif
+
+    scan_worker_t *workers;
+    unsigned int n_slots;               /* Length of workers (each may hold a matcher) */
+    unsigned int n_workers;             /* Threads started (or to start) */
+    unsigned int ready;                 /* Workers holding their snapshot */
+    bool go;                            /* Ranges are set: start claiming */
+    uint64_t stop;                      /* Atomic: also polled mid-range */
+    int rc;                             /* First worker error */
+
+    size_t n_ranges_wanted;
+    scan_range_t *ranges;
+    size_t n_ranges;
+    size_t next_range;                  /* Next range to claim */
+    size_t n_done;
+    size_t n_consumed;                  /* Ranges the consumer is finished with */
+    size_t window;                      /* Max claimed but unconsumed (0 = any) */
+
+    /* Consumer position (caller's thread only) */
+    scan_range_t *cur;
+    size_t cur_pos;
+    size_t cur_index;
+};
+
+static void _scan_lock(mongolite_scan_t *s) {
+#ifdef _WIN32
+    EnterCriticalSection(&s->mutex);
+#else
+    pthread_mutex_lock(&s->mutex);
+#endif
+}
+
+static void _scan_unlock(mongolite_scan_t *s) {
+#ifdef _WIN32
+    LeaveCriticalSection(&s->mutex);
+#else
+    pthread_mutex_unlock(&s->mutex);
+#endif
+}
+
+static void _scan_wait(mongolite_scan_t *s) {
+#ifdef _WIN32
+    SleepConditionVariableCS(&s->cond, &s->mutex, INFINITE);
+#else
+    pthread_cond_wait(&s->cond, &s->mutex);
+#endif
+}
+
+static void _scan_broadcast(mongolite_scan_t *s) {
+#ifdef _WIN32
+    WakeAllConditionVariable(&s->cond);
+#else
+    pthread_cond_broadcast(&s->cond);
+#endif
+}
+
+/* ============================================================
+ * Ranges
+ * ============================================================ */
+
+/* Same order as LMDB's default key compare: bytes, then shorter first */
+static bool _key_before(const void *key, size_t key_len, const uint8_t *bound, size_t bound_len) {
+    size_t n = key_len < bound_len ? key_len : bound_len;
+    int c = memcmp(key, bound, n);
+    return c < 0 || (c == 0 && key_len < bound_len);
+}
+
+/* Up to 8 bytes of key from offset, big-endian, zero-padded */
+static uint64_t _key_word(const uint8_t *key, size_t off, size_t width) {
+    uint64_t v = 0;
+    for (size_t i = 0; i < width; i++) v = (v << 8) | key[off + i];
+    return v;
+}
+
+/*
+ * Split [first, last] into about n ranges by interpolating the bytes
+ * where the two keys first differ. For ObjectIds that is the timestamp
+ * for data written over time, or the counter within one second.
+ */
+static size_t _split_ranges(mongolite_scan_t *s, const uint8_t *first, size_t first_len,
+                            const uint8_t *last, size_t last_len, size_t n) {
+    uint8_t lo[MONGOLITE_SCAN_KEY_MAX] = {0};
+    uint8_t hi[MONGOLITE_SCAN_KEY_MAX] = {0};
+    size_t len = first_len > last_len ? first_len : last_len;
+    if (len > MONGOLITE_SCAN_KEY_MAX) len = MONGOLITE_SCAN_KEY_MAX;
+    memcpy(lo, first, first_len < len ? first_len : len);
+    memcpy(hi, last, last_len < len ? last_len : len);
+
+    size_t d = 0;
+    while (d < len && lo[d] == hi[d]) d++;
+
+    /* Range 0 starts at the first key */
+    s->ranges[0].lo_len = 0;
+    size_t count = 1;
+    if (d == len) return count;
+
+    size_t width = len - d < 8 ? len - d : 8;
+    uint64_t v_lo = _key_word(lo, d, width);
+    uint64_t span = _key_word(hi, d, width) - v_lo;
+
+    uint8_t prev[MONGOLITE_SCAN_KEY_MAX];
+    memcpy(prev, lo, len);
+    for (size_t i = 1; i < n; i++) {
+        /* v_lo + span * i / n without overflow */
+        uint64_t v = v_lo + (span / n) * i + (span % n) * i / n;
+
+        scan_range_t *r = &s->ranges[count];
+        memset(r->lo, 0, sizeof(r->lo));
+        memcpy(r->lo, lo, d);
+        for (size_t b = 0; b < width; b++) {
+            r->lo[d + b] = (uint8_t)(v >> (8 * (width - 1 - b)));
+        }
+        r->lo_len = len;
+
+        /* Narrow spans repeat bounds; keep each range non-empty in key space */
+        if (memcmp(r->lo, prev, len) <= 0) continue;
+        memcpy(prev, r->lo, len);
+        count++;
+    }
+    return count;
+}
+
+/* Worker 0, inside its snapshot: find the key span and cut it */
+static int _plan_ranges(mongolite_scan_t *s, wtree3_txn_t *txn) {
+    gerror_t error = {0};
+    wtree3_iterator_t *iter = wtree3_iterator_create_with_txn(s->tree, txn, &error);
+    if (!iter) return MONGOLITE_ERROR;
+
+    uint8_t first[MONGOLITE_SCAN_KEY_MAX], last[MONGOLITE_SCAN_KEY_MAX];
+    size_t first_len = 0, last_len = 0;
+    const void *key;
+    size_t key_len;
+
+    if (wtree3_iterator_first(iter) && wtree3_iterator_key(iter, &key, &key_len)) {
+        first_len = key_len < sizeof(first) ? key_len : sizeof(first);
+        memcpy(first, key, first_len);
+    }
+    if (wtree3_iterator_last(iter) && wtree3_iterator_key(iter, &key, &key_len)) {
+        last_len = key_len < sizeof(last) ? key_len : sizeof(last);
+        memcpy(last, key, last_len);
+    }
+    wtree3_iterator_close(iter);
+
+    s->n_ranges = (first_len == 0)
+                      ? 1
+                      : _split_ranges(s, first, first_len, last, last_len, s->n_ranges_wanted);
+    return MONGOLITE_OK;
+}
+
+/* ============================================================
+ * Workers
+ * ============================================================ */
+
+static bool _range_append(scan_range_t *r, const void *data, size_t len) {
+    size_t need = r->len + sizeof(uint32_t) + len;
+    if (need > r->cap) {
+        size_t cap = r->cap ? r->cap * 2 : 4096;
+        while (cap < need) cap *= 2;
+        uint8_t *buf = realloc(r->buf, cap);
+        if (!buf) return false;
+        r->buf = buf;
+        r->cap = cap;
+    }
+    uint32_t len32 = (uint32_t)len;
+    memcpy(r->buf + r->len, &len32, sizeof(len32));
+    memcpy(r->buf + r->len + sizeof(len32), data, len);
+    r->len = need;
+    return true;
+}
+
+/* Scan one range into out (not yet visible to the consumer) */
+static int _scan_range(mongolite_scan_t *s, scan_worker_t *w, wtree3_txn_t *txn,
+                       size_t index, scan_range_t *out) {
+    gerror_t error = {0};
+    wtree3_iterator_t *iter = wtree3_iterator_create_with_txn(s->tree, txn, &error);
+    if (!iter) return MONGOLITE_ERROR;
+
+    const scan_range_t *range = &s->ranges[index];
+    const scan_range_t *upper = (index + 1 < s->n_ranges) ? &s->ranges[index + 1] : NULL;
+
+    mongolite_readahead_t readahead;
+    _mongolite_readahead_init(s->db, txn, &readahead);
+
+    bool has = range->lo_len ? wtree3_iterator_seek_range(iter, range->lo, range->lo_len)
+                             : wtree3_iterator_first(iter);
+    int rc = MONGOLITE_OK;
+
+    while (has) {
+        const void *key, *value;
+        size_t key_len, value_len;
+        if (!wtree3_iterator_key(iter, &key, &key_len) ||
+            !wtree3_iterator_value(iter, &value, &value_len)) {
+            break;
+        }
+        if (upper && !_key_before(key, key_len, upper->lo, upper->lo_len)) break;
+        _mongolite_readahead_seq(&readahead, value);
+
+        out->scanned++;
+        bson_t doc;
+        if (bson_init_static(&doc, value, value_len) &&
+            mongoc_matcher_match(w->matcher, &doc)) {
+            out->matched++;
+            bool ok = true;
+            if (s->mode == MONGOLITE_SCAN_KEYS) ok = _range_append(out, key, key_len);
+            else if (s->mode == MONGOLITE_SCAN_DOCS) ok = _range_append(out, value, value_len);
+            if (!ok) {
+                rc = MONGOLITE_ENOMEM;
+                break;
+            }
+        }
+
+        /* Let an early stop (cursor destroyed) end long ranges */
+        if ((out->scanned & 1023) == 0 && MONGOLITE_ATOMIC_LOAD(&s->stop)) break;
+        has = wtree3_iterator_next(iter);
+    }
+
+    wtree3_iterator_close(iter);
+    return rc;
+}
+
+static bool _may_claim(mongolite_scan_t *s) {
+    if (s->next_range >= s->n_ranges) return false;
+    return s->window == 0 || s->next_range - s->n_consumed < s->window;
+}
+
+#ifdef _WIN32
+static unsigned __stdcall _worker_main(void *arg)
+#else
+static void* _worker_main(void *arg)
+#endif
+{
+    scan_worker_t *w = arg;
+    mongolite_scan_t *s = w->scan;
+
+    /* A fresh thread: its own reader slot, whatever the caller holds */
+    gerror_t error = {0};
+    wtree3_txn_t *txn = wtree3_txn_begin(s->db->wdb, false, &error);
+    int rc = txn ? MONGOLITE_OK : MONGOLITE_ERROR;
+    if (txn && w->index == 0) rc = _plan_ranges(s, txn);
+
+    _scan_lock(s);
+    if (rc != MONGOLITE_OK && s->rc == MONGOLITE_OK) s->rc = rc;
+    s->ready++;
+    _scan_broadcast(s);
+    while (!s->go && !s->stop) _scan_wait(s);
+
+    while (txn && !s->stop && s->rc == MONGOLITE_OK) {
+        if (!_may_claim(s)) {
+            if (s->next_range >= s->n_ranges) break;
+            _scan_wait(s);
+            continue;
+        }
+        size_t index = s->next_range++;
+        _scan_unlock(s);
+
+        scan_range_t result = {0};
+        rc = _scan_range(s, w, txn, index, &result);
+
+        _scan_lock(s);
+        scan_range_t *r = &s->ranges[index];
+        r->buf = result.buf;
+        r->len = result.len;
+        r->cap = result.cap;
+        r->scanned = result.scanned;
+        r->matched = result.matched;
+        r->done = true;
+        s->n_done++;
+        if (rc != MONGOLITE_OK && s->rc == MONGOLITE_OK) s->rc = rc;
+        _scan_broadcast(s);
+    }
+    _scan_unlock(s);
+
+    if (txn) wtree3_txn_abort(txn);
+#ifdef _WIN32
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+/* ============================================================
+ * Start / Free
+ * ============================================================ */
+
+bool _mongolite_scan_eligible(mongolite_db_t *db, wtree3_tree_t *tree, const bson_t *filter) {
+    if (!db || db->scan_threads < 2 || !tree || !filter || bson_empty(filter)) return false;
+    /* A session reads its own uncommitted writes: only its txn can see them */
+    if (_mongolite_session_txn(db)) return false;
+    return (uint64_t)wtree3_tree_count(tree) >= db->scan_min_docs;
+}
+
+static void _scan_join(mongolite_scan_t *s) {
+    _scan_lock(s);
+    MONGOLITE_ATOMIC_STORE(&s->stop, true);
+    s->go = true;
+    _scan_broadcast(s);
+    _scan_unlock(s);
+
+    for (unsigned int i = 0; i < s->n_workers; i++) {
+        scan_worker_t *w = &s->workers[i];
+        if (!w->started) continue;
+#ifdef _WIN32
+        WaitForSingleObject(w->thread, INFINITE);
+        CloseHandle(w->thread);
+#else
+        pthread_join(w->thread, NULL);
+#endif
+        w->started = false;
+    }
+}
+
+void _mongolite_scan_free(mongolite_scan_t *s) {
+    if (!s) return;
+    _scan_join(s);
+
+    /* Every slot: a thread that failed to start still has its matcher */
+    for (unsigned int i = 0; i < s->n_slots; i++) {
+        if (s->workers[i].matcher) mongoc_matcher_destroy(s->workers[i].matcher);
+    }
+    free(s->workers);
+    if (s->ranges) {
+        for (size_t i = 0; i < s->n_ranges; i++) free(s->ranges[i].buf);
+        free(s->ranges);
+    }
+    MONGOLITE_ATOMIC_ADD(&s->db->cursor_txns, (uint64_t)-1);
+
+#ifdef _WIN32
+    DeleteCriticalSection(&s->mutex);
+#else
+    pthread_cond_destroy(&s->cond);
+    pthread_mutex_destroy(&s->mutex);
+#endif
+    free(s);
+}
+
+mongolite_scan_t* _mongolite_scan_start(mongolite_db_t *db, wtree3_tree_t *tree,
+                                        const bson_t *filter, mongolite_scan_mode_t mode,
+                                        gerror_t *error) {
+    mongolite_scan_t *s = calloc(1, sizeof(mongolite_scan_t));
+    if (!s) {
+        set_error(error, "system", MONGOLITE_ENOMEM, "Failed to allocate scan");
+        return NULL;
+    }
+    s->db = db;
+    s->tree = tree;
+    s->mode = mode;
+    s->ordered = true;
+    s->n_workers = db->scan_threads;
+
+#ifdef _WIN32
+    InitializeCriticalSection(&s->mutex);
+    InitializeConditionVariable(&s->cond);
+#else
+    if (pthread_mutex_init(&s->mutex, NULL) != 0) {
+        free(s);
+        set_error(error, "system", MONGOLITE_ERROR, "Failed to initialize scan mutex");
+        return NULL;
+    }
+    if (pthread_cond_init(&s->cond, NULL) != 0) {
+        pthread_mutex_destroy(&s->mutex);
+        free(s);
+        set_error(error, "system", MONGOLITE_ERROR, "Failed to initialize scan cond");
+        return NULL;
+    }
+#endif
+    /* Held until free: the map must not move under the workers' txns */
+    MONGOLITE_ATOMIC_ADD(&db->cursor_txns, 1);
+
+    uint64_t docs = (uint64_t)wtree3_tree_count(tree);
+    size_t n = (size_t)(docs / MONGOLITE_SCAN_RANGE_DOCS);
+    size_t min_ranges = (size_t)s->n_workers * MONGOLITE_SCAN_RANGES_PER_WORKER;
+    if (n < min_ranges) n = min_ranges;
+    if (n > MONGOLITE_SCAN_MAX_RANGES) n = MONGOLITE_SCAN_MAX_RANGES;
+    s->n_ranges_wanted = n;
+    /* Only buffered results need a bound */
+    s->window = (mode == MONGOLITE_SCAN_COUNT)
+                    ? 0 : (size_t)s->n_workers * MONGOLITE_SCAN_WINDOW_PER_WORKER;
+
+    s->ranges = calloc(n, sizeof(scan_range_t));
+    s->workers = calloc(s->n_workers, sizeof(scan_worker_t));
+    if (!s->ranges || !s->workers) {
+        _mongolite_scan_free(s);
+        set_error(error, "system", MONGOLITE_ENOMEM, "Failed to allocate scan");
+        return NULL;
+    }
+    s->n_slots = s->n_workers;
+
+    /* Matchers are compiled here: a bad filter fails the call */
+    for (unsigned int i = 0; i < s->n_workers; i++) {
+        bson_error_t bson_err;
+        s->workers[i].matcher = mongoc_matcher_new(filter, &bson_err);
+        if (!s->workers[i].matcher) {
+            _mongolite_scan_free(s);
+            set_error(error, "bsonmatch", MONGOLITE_EQUERY, "Invalid query: %s", bson_err.message);
+            return NULL;
+        }
+        s->workers[i].scan = s;
+        s->workers[i].index = i;
+    }
+
+    for (unsigned int i = 0; i < s->n_workers; i++) {
+        scan_worker_t *w = &s->workers[i];
+#ifdef _WIN32
+        w->thread = (HANDLE)_beginthreadex(NULL, 0, _worker_main, w, 0, NULL);
+        w->started = (w->thread != 0);
+#else
+        w->started = (pthread_create(&w->thread, NULL, _worker_main, w) == 0);
+#endif
+        if (!w->started) {
+            s->n_workers = i;
+            break;
+        }
+    }
+
+    /* Wait for every snapshot (taken under the caller's db lock) */
+    _scan_lock(s);
+    while (s->ready < s->n_workers) _scan_wait(s);
+    bool ok = s->n_workers == db->scan_threads && s->rc == MONGOLITE_OK;
+    if (ok) {
+        s->go = true;
+        _scan_broadcast(s);
+    }
+    _scan_unlock(s);
+
+    if (!ok) {
+        _mongolite_scan_free(s);
+        set_error(error, MONGOLITE_LIB, MONGOLITE_ERROR, "Failed to start parallel scan");
+        return NULL;
+    }
+
+    MONGOLITE_STAT(db, parallel_scans, 1);
+    return s;
+}
+
+/* ============================================================
+ * Results
+ * ============================================================ */
+
+void _mongolite_scan_set_ordered(mongolite_scan_t *s, bool ordered) {
+    if (s) s->ordered = ordered;
+}
+
+/* Consumer is done with cur: free its buffer, let workers run ahead */
+static void _release_current(mongolite_scan_t *s) {
+    if (!s->cur) return;
+    _scan_lock(s);
+    free(s->cur->buf);
+    s->cur->buf = NULL;
+    s->cur->len = s->cur->cap = 0;
+    s->cur->consumed = true;
+    s->n_consumed++;
+    _scan_broadcast(s);
+    _scan_unlock(s);
+    s->cur = NULL;
+}
+
+/* Next finished range for the consumer (NULL when all are consumed) */
+static scan_range_t* _next_range(mongolite_scan_t *s) {
+    scan_range_t *found = NULL;
+    _scan_lock(s);
+    for (;;) {
+        if (s->rc != MONGOLITE_OK) break;
+        if (s->ordered) {
+            while (s->cur_index < s->n_ranges && s->ranges[s->cur_index].consumed) s->cur_index++;
+            if (s->cur_index >= s->n_ranges) break;
+            if (s->ranges[s->cur_index].done) {
+                found = &s->ranges[s->cur_index];
+                break;
+            }
+        } else {
+            if (s->n_consumed >= s->n_ranges) break;
+            for (size_t i = 0; i < s->n_ranges; i++) {
+                if (s->ranges[i].done && !s->ranges[i].consumed) {
+                    found = &s->ranges[i];
+                    break;
+                }
+            }
+            if (found) break;
+        }
+        _scan_wait(s);
+    }
+    _scan_unlock(s);
+    return found;
+}
+
+int _mongolite_scan_next(mongolite_scan_t *s, const void **data, size_t *len) {
+    for (;;) {
+        if (s->cur && s->cur_pos < s->cur->len) {
+            uint32_t len32;
+            memcpy(&len32, s->cur->buf + s->cur_pos, sizeof(len32));
+            *data = s->cur->buf + s->cur_pos + sizeof(len32);
+            *len = len32;
+            s->cur_pos += sizeof(len32) + len32;
+            return 1;
+        }
+        _release_current(s);
+
+        s->cur = _next_range(s);
+        s->cur_pos = 0;
+        if (!s->cur) return s->rc == MONGOLITE_OK ? 0 : s->rc;
+    }
+}
+
+int _mongolite_scan_finish(mongolite_scan_t *s, uint64_t *matched) {
+    _scan_lock(s);
+    while (s->rc == MONGOLITE_OK && s->n_done < s->n_ranges) _scan_wait(s);
+    _scan_unlock(s);
+    _scan_join(s);
+
+    uint64_t total = 0;
+    for (size_t i = 0; i < s->n_ranges; i++) total += s->ranges[i].matched;
+    if (matched) *matched = total;
+    return s->rc;
+}
+
+uint64_t _mongolite_scan_scanned(mongolite_scan_t *s) {
+    uint64_t total = 0;
+    _scan_lock(s);
+    for (size_t i = 0; i < s->n_ranges; i++) total += s->ranges[i].scanned;
+    _scan_unlock(s);
+    return total;
+}
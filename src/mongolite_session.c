@@ -0,0 +1,303 @@
+/*
+ * mongolite_session.c - Thread-bound sessions
+ *
+ * Handles:
+ * - Session begin / commit / abort (snapshot and write)
+ * - Binding the session to the calling thread
+ * - Lookups used by the transaction helpers in mongolite_txn.c
+ * - Group sessions (group commit batches with nested writes)
+ */
+
+#include "mongolite_internal.h"
+#include "macros.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define MONGOLITE_LIB "mongolite"
+
+/* Session of the calling thread (at most one, for any database) */
+static MONGOLITE_THREAD_LOCAL mongolite_session_t *_tls_session = NULL;
+
+/* ============================================================
+ * Internal Lookups
+ * ============================================================ */
+
+MONGOLITE_HOT
+mongolite_session_t* _mongolite_session_current(mongolite_db_t *db) {
+    if (MONGOLITE_LIKELY(!db || db->open_sessions == 0)) return NULL;
+    mongolite_session_t *session = _tls_session;
+    return (session && session->db == db) ? session : NULL;
+}
+
+bool _mongolite_session_bound(void) {
+    return _tls_session != NULL;
+}
+
+MONGOLITE_HOT
+wtree3_txn_t* _mongolite_session_txn(mongolite_db_t *db) {
+    mongolite_session_t *session = _mongolite_session_current(db);
+    if (!session) return NULL;
+    return session->nested ? session->nested : session->txn;
+}
+
+int _mongolite_require_no_write_session(mongolite_db_t *db, gerror_t *error) {
+    if (MONGOLITE_LIKELY(db->write_sessions == 0)) return MONGOLITE_OK;
+
+    /* The session is this thread's own: waiting would never end */
+    mongolite_session_t *own = _tls_session;
+    if ((own && own->db == db && own->write) || db->busy_timeout_ms < 0) {
+        set_error(error, MONGOLITE_LIB, MONGOLITE_EBUSY,
+                 "Not allowed while a write session is open");
+        return MONGOLITE_EBUSY;
+    }
+
+    /* Another thread's: wait for it to end (the wait releases the lock) */
+    uint64_t deadline = db->busy_timeout_ms > 0
+        ? _mongolite_now_ns() + (uint64_t)db->busy_timeout_ms * 1000000ULL : 0;
+    while (db->write_sessions > 0) {
+        int ms = -1;
+        if (deadline) {
+            uint64_t now = _mongolite_now_ns();
+            if (now >= deadline) {
+                set_error(error, MONGOLITE_LIB, MONGOLITE_EBUSY,
+                         "Timed out waiting for a write session to end");
+                return MONGOLITE_EBUSY;
+            }
+            ms = (int)((deadline - now + 999999) / 1000000);
+        }
+        _mongolite_writer_wait(db, ms);
+    }
+    return MONGOLITE_OK;
+}
+
+/* Unbind and free. Lock held; the txn is already committed or aborted. */
+static void _session_release(mongolite_session_t *session) {
+    mongolite_db_t *db = session->db;
+
+    db->open_sessions--;
+    if (session->write && --db->write_sessions == 0) _mongolite_writer_wake(db);
+
+    if (_tls_session == session) _tls_session = NULL;
+    free(session);
+}
+
+void _mongolite_session_end_current(mongolite_db_t *db) {
+    mongolite_session_t *session = _tls_session;
+    if (!session || session->db != db) return;
+    mongolite_session_abort(session);
+}
+
+/* ============================================================
+ * Begin
+ * ============================================================ */
+
+mongolite_session_t* mongolite_session_begin(mongolite_db_t *db,
+                                             mongolite_session_mode_t mode,
+                                             gerror_t *error) {
+    if (!db) {
+        set_error(error, MONGOLITE_LIB, MONGOLITE_EINVAL, "Database is required");
+        return NULL;
+    }
+    if (_tls_session) {
+        set_error(error, MONGOLITE_LIB, MONGOLITE_ETXN,
+                 "This thread already has an open session");
+        return NULL;
+    }
+
+    bool write = (mode == MONGOLITE_SESSION_WRITE);
+    mongolite_session_t *session = calloc(1, sizeof(mongolite_session_t));
+    if (!session) {
+        set_error(error, "system", MONGOLITE_ENOMEM, "Failed to allocate session");
+        return NULL;
+    }
+    session->db = db;
+    session->write = write;
+
+    _mongolite_lock(db);
+
+    if (_mongolite_require_env(db, error) != MONGOLITE_OK) {
+        _mongolite_unlock(db);
+        free(session);
+        return NULL;
+    }
+
+    if (write) {
+        /* Opening a collection takes LMDB's writer lock, which the session
+         * will hold: have them all open so lookups inside never need to
+         * (only redone once collections were created or dropped) */
+        int rc = _mongolite_open_all_collections(db, error);
+        if (rc != MONGOLITE_OK) {
+            _mongolite_unlock(db);
+            free(session);
+            return NULL;
+        }
+
+        /* Same reason as _mongolite_get_write_txn: drop the pooled reader */
+        if (db->read_txn_pool) {
+            wtree3_txn_abort(db->read_txn_pool);
+            db->read_txn_pool = NULL;
+        }
+        db->write_sessions++;
+    }
+    db->open_sessions++;
+
+    _mongolite_unlock(db);
+
+    /* Outside the lock: a second write session waits here for the first
+     * to finish, and the first still needs the lock to get there */
+    if (write) MONGOLITE_STAT(db, write_txn_begins, 1);
+    else MONGOLITE_STAT(db, read_txn_begins, 1);
+
+    session->txn = wtree3_txn_begin(db->wdb, write, error);
+    if (!session->txn) {
+        _mongolite_lock(db);
+        _session_release(session);
+        _mongolite_unlock(db);
+        return NULL;
+    }
+
+    _tls_session = session;
+    return session;
+}
+
+/* ============================================================
+ * Group Sessions
+ * ============================================================ */
+
+mongolite_session_t* _mongolite_session_begin_group(mongolite_db_t *db, gerror_t *error) {
+    if (_tls_session) {
+        set_error(error, MONGOLITE_LIB, MONGOLITE_ETXN,
+                 "This thread already has an open session");
+        return NULL;
+    }
+    /* Lock held: the writer is free unless a write session has it */
+    if (_mongolite_require_env(db, error) != MONGOLITE_OK ||
+        _mongolite_require_no_write_session(db, error) != MONGOLITE_OK) {
+        return NULL;
+    }
+
+    mongolite_session_t *session = calloc(1, sizeof(mongolite_session_t));
+    if (!session) {
+        set_error(error, "system", MONGOLITE_ENOMEM, "Failed to allocate session");
+        return NULL;
+    }
+    session->db = db;
+    session->write = true;
+    session->group = true;
+
+    if (db->read_txn_pool) {
+        wtree3_txn_abort(db->read_txn_pool);
+        db->read_txn_pool = NULL;
+    }
+
+    MONGOLITE_STAT(db, write_txn_begins, 1);
+    session->txn = wtree3_txn_begin(db->wdb, true, error);
+    if (!session->txn) {
+        free(session);
+        return NULL;
+    }
+
+    db->open_sessions++;
+    db->write_sessions++;
+    _tls_session = session;
+    return session;
+}
+
+int _mongolite_session_end_group(mongolite_session_t *session, bool commit,
+                                 gerror_t *error) {
+    mongolite_db_t *db = session->db;
+    int rc = MONGOLITE_OK;
+
+    if (session->nested) {
+        wtree3_txn_abort(session->nested);
+        session->nested = NULL;
+    }
+
+    if (commit) {
+        uint64_t start = _mongolite_stats_start(db);
+        rc = wtree3_txn_commit(session->txn, error);
+        _mongolite_stats_record(db, MONGOLITE_OP_COMMIT, start);
+        if (rc == 0) {
+            _mongolite_durability_committed(db);
+            _mongolite_change_feed_committed(db);
+        }
+    } else {
+        wtree3_txn_abort(session->txn);
+    }
+    _session_release(session);
+    if (commit && rc == 0) {
+        _mongolite_map_committed(db);
+        _mongolite_analyze_committed(db);
+    }
+    return rc;
+}
+
+wtree3_txn_t* _mongolite_session_nested_txn(mongolite_session_t *session, gerror_t *error) {
+    if (!session->nested) {
+        session->nested = wtree3_txn_begin_nested(session->txn, error);
+    }
+    return session->nested;
+}
+
+int _mongolite_session_end_nested(mongolite_session_t *session, bool commit,
+                                  gerror_t *error) {
+    wtree3_txn_t *nested = session->nested;
+    if (!nested) return MONGOLITE_OK;
+    session->nested = NULL;
+
+    if (commit) return wtree3_txn_commit(nested, error);
+    wtree3_txn_abort(nested);
+    return MONGOLITE_OK;
+}
+
+/* ============================================================
+ * Commit / Abort
+ * ============================================================ */
+
+int mongolite_session_commit(mongolite_session_t *session, gerror_t *error) {
+    if (!session) {
+        set_error(error, MONGOLITE_LIB, MONGOLITE_EINVAL, "Session is required");
+        return MONGOLITE_EINVAL;
+    }
+    if (_tls_session != session) {
+        set_error(error, MONGOLITE_LIB, MONGOLITE_ETXN,
+                 "Session belongs to another thread");
+        return MONGOLITE_ETXN;
+    }
+
+    mongolite_db_t *db = session->db;
+    int rc = MONGOLITE_OK;
+
+    _mongolite_lock(db);
+
+    if (session->write) {
+        uint64_t start = _mongolite_stats_start(db);
+        rc = wtree3_txn_commit(session->txn, error);
+        _mongolite_stats_record(db, MONGOLITE_OP_COMMIT, start);
+        if (rc == 0) {
+            _mongolite_durability_committed(db);
+            _mongolite_change_feed_committed(db);
+        }
+    } else {
+        wtree3_txn_abort(session->txn);
+    }
+    bool grow = session->write && rc == 0;
+    _session_release(session);
+    if (grow) {
+        _mongolite_map_committed(db);
+        _mongolite_analyze_committed(db);
+    }
+
+    _mongolite_unlock(db);
+    return rc;
+}
+
+void mongolite_session_abort(mongolite_session_t *session) {
+    if (!session || _tls_session != session) return;
+
+    mongolite_db_t *db = session->db;
+    _mongolite_lock(db);
+    wtree3_txn_abort(session->txn);
+    _session_release(session);
+    _mongolite_unlock(db);
+}
@@ -0,0 +1,274 @@
+/*
+ * mongolite_slowlog.c - Slow-operation log
+ *
+ * Handles:
+ * - Log setup / teardown (db_config_t.slowlog_*)
+ * - Per-thread traces of a query call: plan, keys and documents read,
+ *   lock wait
+ * - Threshold and sampling decision, bounded lock-free queue
+ * - Public API: mongolite_slowlog_drain
+ *
+ * Entries are queued on the thread that ran the operation, without the
+ * database lock, so a caller's drain never blocks queries (and the other
+ * way round). A full queue drops new entries and counts them.
+ */
+
+#include "mongolite_internal.h"
+#include "macros.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MONGOLITE_SLOWLOG_DEFAULT_CAPACITY 1024
+#define MONGOLITE_SLOWLOG_MAX_CAPACITY     (1u << 20)
+
+MONGOLITE_THREAD_LOCAL mongolite_op_trace_t _mongolite_trace;
+
+/* ============================================================
+ * Queue
+ *
+ * Bounded multi-producer / multi-consumer ring (D. Vyukov): each cell
+ * carries a sequence number that says whether it is free for the
+ * enqueue at position pos (seq == pos) or holds the entry for the
+ * dequeue at pos (seq == pos + 1). Producers and consumers claim
+ * positions with one CAS and never wait for each other.
+ * ============================================================ */
+
+typedef struct {
+    uint64_t seq;
+    mongolite_slow_op_t op;
+} slowlog_cell_t;
+
+struct mongolite_slowlog {
+    uint64_t threshold_ns;              /* 0 = no threshold */
+    uint64_t sample_cut;                /* Sample if rand32 < cut (2^32 = all) */
+    slowlog_cell_t *cells;
+    uint64_t mask;                      /* Capacity - 1 */
+
+    /* Enqueue and dequeue positions on their own cache lines */
+    char _pad0[64];
+    uint64_t head;
+    char _pad1[64];
+    uint64_t tail;
+    char _pad2[64];
+};
+
+static bool _ring_push(mongolite_slowlog_t *log, const mongolite_slow_op_t *op) {
+    uint64_t pos = MONGOLITE_ATOMIC_LOAD(&log->head);
+    for (;;) {
+        slowlog_cell_t *cell = &log->cells[pos & log->mask];
+        int64_t diff = (int64_t)(MONGOLITE_ATOMIC_LOAD_ACQ(&cell->seq) - pos);
+        if (diff == 0) {
+            if (MONGOLITE_ATOMIC_CAS(&log->head, pos, pos + 1)) {
+                cell->op = *op;
+                MONGOLITE_ATOMIC_STORE_REL(&cell->seq, pos + 1);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false;               /* Full: the cell still holds an entry */
+        }
+        pos = MONGOLITE_ATOMIC_LOAD(&log->head);
+    }
+}
+
+static bool _ring_pop(mongolite_slowlog_t *log, mongolite_slow_op_t *out) {
+    uint64_t pos = MONGOLITE_ATOMIC_LOAD(&log->tail);
+    for (;;) {
+        slowlog_cell_t *cell = &log->cells[pos & log->mask];
+        int64_t diff = (int64_t)(MONGOLITE_ATOMIC_LOAD_ACQ(&cell->seq) - (pos + 1));
+        if (diff == 0) {
+            if (MONGOLITE_ATOMIC_CAS(&log->tail, pos, pos + 1)) {
+                *out = cell->op;
+                MONGOLITE_ATOMIC_STORE_REL(&cell->seq, pos + log->mask + 1);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false;               /* Empty (or the producer is still copying) */
+        }
+        pos = MONGOLITE_ATOMIC_LOAD(&log->tail);
+    }
+}
+
+/* ============================================================
+ * Setup
+ * ============================================================ */
+
+int _mongolite_slowlog_init(mongolite_db_t *db, const db_config_t *config) {
+    db->slowlog = NULL;
+    if (!config) return MONGOLITE_OK;
+
+    double rate = config->slowlog_sample_rate;
+    if (config->slowlog_threshold_us == 0 && !(rate > 0.0)) return MONGOLITE_OK;
+    if (rate > 1.0) rate = 1.0;
+
+    uint64_t capacity = config->slowlog_capacity ? config->slowlog_capacity
+                                                 : MONGOLITE_SLOWLOG_DEFAULT_CAPACITY;
+    if (capacity > MONGOLITE_SLOWLOG_MAX_CAPACITY) capacity = MONGOLITE_SLOWLOG_MAX_CAPACITY;
+    uint64_t pow2 = 1;
+    while (pow2 < capacity) pow2 <<= 1;
+
+    mongolite_slowlog_t *log = calloc(1, sizeof(*log));
+    if (!log) return MONGOLITE_ENOMEM;
+    log->cells = calloc(pow2, sizeof(slowlog_cell_t));
+    if (!log->cells) {
+        free(log);
+        return MONGOLITE_ENOMEM;
+    }
+    for (uint64_t i = 0; i < pow2; i++) log->cells[i].seq = i;
+
+    log->mask = pow2 - 1;
+    log->threshold_ns = config->slowlog_threshold_us * 1000;
+    log->sample_cut = rate > 0.0 ? (uint64_t)(rate * 4294967296.0) : 0;
+    db->slowlog = log;
+    return MONGOLITE_OK;
+}
+
+void _mongolite_slowlog_free(mongolite_db_t *db) {
+    if (!db || !db->slowlog) return;
+    free(db->slowlog->cells);
+    free(db->slowlog);
+    db->slowlog = NULL;
+}
+
+/* ============================================================
+ * Recording
+ * ============================================================ */
+
+/* Per-thread xorshift state for sampling (0 = not seeded yet) */
+static MONGOLITE_THREAD_LOCAL uint64_t _tls_rand = 0;
+
+static uint32_t _slowlog_rand(void) {
+    uint64_t x = _tls_rand;
+    if (MONGOLITE_UNLIKELY(x == 0)) {
+        x = (_mongolite_now_ns() ^ (uint64_t)(uintptr_t)&_tls_rand) | 1;
+    }
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    _tls_rand = x;
+    return (uint32_t)(x >> 32);
+}
+
+/* Does an operation that took elapsed_ns qualify? */
+static bool _slowlog_wanted(const mongolite_slowlog_t *log, uint64_t elapsed_ns,
+                            bool *sampled) {
+    *sampled = false;
+    if (log->threshold_ns && elapsed_ns >= log->threshold_ns) return true;
+    if (log->sample_cut && _slowlog_rand() < log->sample_cut) {
+        *sampled = true;
+        return true;
+    }
+    return false;
+}
+
+static const char* _plan_name(const mongolite_op_trace_t *trace) {
+    if (!trace->planned) return "NONE";
+    switch (trace->plan) {
+        case MONGOLITE_PLAN_ID:          return "ID_LOOKUP";
+        case MONGOLITE_PLAN_INDEX_EQ:    return "IXSCAN";
+        case MONGOLITE_PLAN_INDEX_MULTI: return "IXSEEK";
+        default:                         return "COLLSCAN";
+    }
+}
+
+/* Entry from the trace so far (shape is computed here, while the
+ * caller's filter is still alive) */
+static void _slowlog_fill(mongolite_slow_op_t *out, mongolite_op_t op,
+                          const mongolite_op_trace_t *trace) {
+    memset(out, 0, sizeof(*out));
+    out->op = op;
+    out->plan = _plan_name(trace);
+    if (trace->collection) {
+        size_t len = strlen(trace->collection);
+        if (len >= sizeof(out->collection)) len = sizeof(out->collection) - 1;
+        memcpy(out->collection, trace->collection, len);
+    }
+    _mongolite_query_shape(trace->filter, out->shape, sizeof(out->shape));
+    out->lock_wait_ns = trace->lock_wait_ns;
+    out->keys_examined = trace->keys_examined;
+    out->docs_examined = trace->docs_examined;
+    out->docs_returned = trace->docs_returned;
+}
+
+static void _slowlog_push(mongolite_db_t *db, const mongolite_slow_op_t *entry) {
+    if (_ring_push(db->slowlog, entry)) {
+        MONGOLITE_STAT(db, slow_ops, 1);
+    } else {
+        MONGOLITE_STAT(db, slow_ops_dropped, 1);
+    }
+}
+
+void _mongolite_slowlog_begin(const char *collection, const bson_t *filter, uint64_t start_ns) {
+    mongolite_op_trace_t *trace = &_mongolite_trace;
+    memset(trace, 0, sizeof(*trace));
+    trace->active = true;
+    trace->start_ns = start_ns;
+    trace->collection = collection;
+    trace->filter = filter;
+}
+
+void _mongolite_slowlog_end(mongolite_db_t *db, mongolite_op_t op, uint64_t start_ns,
+                            uint64_t elapsed_ns) {
+    mongolite_op_trace_t *trace = &_mongolite_trace;
+    if (!trace->active || trace->start_ns != start_ns) return;
+    trace->active = false;
+
+    bool sampled;
+    if (!_slowlog_wanted(db->slowlog, elapsed_ns, &sampled)) return;
+
+    mongolite_slow_op_t entry;
+    _slowlog_fill(&entry, op, trace);
+    entry.duration_ns = elapsed_ns;
+    entry.sampled = sampled;
+    _slowlog_push(db, &entry);
+}
+
+void _mongolite_slowlog_defer(mongolite_cursor_t *cursor, uint64_t start_ns) {
+    mongolite_op_trace_t *trace = &_mongolite_trace;
+    if (!trace->active || trace->start_ns != start_ns) return;
+    trace->active = false;
+
+    /* Without an entry the find is simply not logged */
+    cursor->slow = malloc(sizeof(mongolite_slow_op_t));
+    if (!cursor->slow) return;
+    _slowlog_fill(cursor->slow, MONGOLITE_OP_FIND, trace);
+    cursor->slow->duration_ns = _mongolite_now_ns() - start_ns;
+}
+
+void _mongolite_slowlog_cursor_end(mongolite_cursor_t *cursor) {
+    mongolite_slow_op_t *entry = cursor->slow;
+    cursor->slow = NULL;
+
+    bool sampled;
+    if (_slowlog_wanted(cursor->db->slowlog, entry->duration_ns, &sampled)) {
+        mongolite_op_trace_t trace = {0};
+        trace.planned = true;
+        trace.plan = cursor->plan;
+        entry->plan = _plan_name(&trace);
+        entry->keys_examined = cursor->keys_examined;
+        entry->docs_examined = cursor->scan ? _mongolite_scan_scanned(cursor->scan)
+                                            : (uint64_t)cursor->position;
+        entry->docs_returned = (uint64_t)cursor->returned;
+        entry->sampled = sampled;
+        _slowlog_push(cursor->db, entry);
+    }
+    free(entry);
+}
+
+/* ============================================================
+ * Public API
+ * ============================================================ */
+
+size_t mongolite_slowlog_drain(mongolite_db_t *db, mongolite_slowlog_fn fn, void *ctx) {
+    if (!db || !db->slowlog || !fn) return 0;
+
+    /* At most one pass over the ring, so busy producers cannot keep
+     * the caller here */
+    mongolite_slow_op_t entry;
+    size_t drained = 0;
+    while (drained <= db->slowlog->mask && _ring_pop(db->slowlog, &entry)) {
+        fn(&entry, ctx);
+        drained++;
+    }
+    return drained;
+}
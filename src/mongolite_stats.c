@@ -0,0 +1,342 @@
+/*
+ * mongolite_stats.c - Built-in metrics and latency histograms
+ *
+ * Handles:
+ * - Per-thread counter shards (allocation, shard selection)
+ * - Operation latency timing into log-linear histograms
+ * - Per-collection query counters
+ * - Public API: mongolite_stats, mongolite_collection_stats,
+ *   mongolite_stats_reset, mongolite_latency_percentile
+ */
+
+#include "mongolite_internal.h"
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#define MONGOLITE_LIB "mongolite"
+
+/* ============================================================
+ * Clock
+ * ============================================================ */
+
+uint64_t _mongolite_now_ns(void) {
+#ifdef _WIN32
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER now;
+    if (freq.QuadPart == 0) QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (uint64_t)((double)now.QuadPart * 1e9 / (double)freq.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+/* ============================================================
+ * Shards
+ * ============================================================ */
+
+int _mongolite_stats_init(mongolite_db_t *db, bool enabled) {
+    db->stats_shards = NULL;
+    if (!enabled) return MONGOLITE_OK;
+
+    db->stats_shards = calloc(MONGOLITE_STATS_SHARDS, sizeof(mongolite_stats_t));
+    return db->stats_shards ? MONGOLITE_OK : MONGOLITE_ENOMEM;
+}
+
+void _mongolite_stats_free(mongolite_db_t *db) {
+    if (!db) return;
+    free(db->stats_shards);
+    db->stats_shards = NULL;
+}
+
+/* Shard index of the calling thread (+1; 0 = not assigned yet).
+ * Assignment is round-robin over an atomic ticket. */
+static MONGOLITE_THREAD_LOCAL unsigned _tls_shard = 0;
+static uint64_t _next_shard = 0;
+
+static inline unsigned _shard_index(void) {
+    if (MONGOLITE_UNLIKELY(_tls_shard == 0)) {
+        uint64_t ticket;
+        do {
+            ticket = MONGOLITE_ATOMIC_LOAD(&_next_shard);
+        } while (!MONGOLITE_ATOMIC_CAS(&_next_shard, ticket, ticket + 1));
+        _tls_shard = (unsigned)(ticket % MONGOLITE_STATS_SHARDS) + 1;
+    }
+    return _tls_shard - 1;
+}
+
+MONGOLITE_HOT
+mongolite_stats_t* _mongolite_stats_shard(mongolite_db_t *db) {
+    if (MONGOLITE_UNLIKELY(!db || !db->stats_shards)) return NULL;
+    return &db->stats_shards[_shard_index()];
+}
+
+/* ============================================================
+ * Latency Histograms
+ *
+ * Log-linear buckets: values below 4ns map 1:1, above that each power
+ * of two is split into 4 sub-buckets (max relative error 25%).
+ * ============================================================ */
+
+static unsigned _latency_bucket(uint64_t ns) {
+    if (ns < 4) return (unsigned)ns;
+
+#if WTREE_GCC_LIKE
+    unsigned msb = 63 - (unsigned)__builtin_clzll(ns);
+#else
+    unsigned msb = 2;
+    while (msb < 63 && (ns >> (msb + 1)) != 0) msb++;
+#endif
+    unsigned sub = (unsigned)(ns >> (msb - 2)) & 3;
+    unsigned bucket = 4 * (msb - 1) + sub;
+    return bucket < MONGOLITE_LATENCY_BUCKETS ? bucket : MONGOLITE_LATENCY_BUCKETS - 1;
+}
+
+/* Smallest value that falls in bucket b */
+static uint64_t _latency_bucket_floor(unsigned b) {
+    if (b < 4) return b;
+    unsigned msb = b / 4 + 1;
+    uint64_t sub = b % 4;
+    return (4 + sub) << (msb - 2);
+}
+
+uint64_t _mongolite_stats_start(mongolite_db_t *db) {
+    if (MONGOLITE_UNLIKELY(!db || !db->stats_shards)) return 0;
+    return _mongolite_now_ns();
+}
+
+uint64_t _mongolite_stats_start_query(mongolite_db_t *db, const char *collection,
+                                      const bson_t *filter) {
+    if (MONGOLITE_UNLIKELY(db && db->slowlog)) {
+        uint64_t start = _mongolite_now_ns();
+        _mongolite_slowlog_begin(collection, filter, start);
+        return start;
+    }
+    return _mongolite_stats_start(db);
+}
+
+MONGOLITE_HOT
+void _mongolite_stats_record(mongolite_db_t *db, mongolite_op_t op, uint64_t start_ns) {
+    if (start_ns == 0 || (unsigned)op >= MONGOLITE_OP_MAX) return;
+
+    uint64_t elapsed = _mongolite_now_ns() - start_ns;
+    if (MONGOLITE_UNLIKELY(db->slowlog != NULL)) _mongolite_slowlog_end(db, op, start_ns, elapsed);
+
+    mongolite_stats_t *shard = _mongolite_stats_shard(db);
+    if (!shard) return;
+
+    mongolite_latency_t *lat = &shard->latency[op];
+
+    MONGOLITE_ATOMIC_ADD(&lat->count, 1);
+    MONGOLITE_ATOMIC_ADD(&lat->total_ns, elapsed);
+    MONGOLITE_ATOMIC_ADD(&lat->buckets[_latency_bucket(elapsed)], 1);
+
+    /* Threads sharing a shard may race on the max */
+    uint64_t max_ns = MONGOLITE_ATOMIC_LOAD(&lat->max_ns);
+    while (elapsed > max_ns && !MONGOLITE_ATOMIC_CAS(&lat->max_ns, max_ns, elapsed)) {
+        max_ns = MONGOLITE_ATOMIC_LOAD(&lat->max_ns);
+    }
+}
+
+/* ============================================================
+ * Query Counters
+ * ============================================================ */
+
+mongolite_op_stats_shard_t* _mongolite_collection_stats_alloc(mongolite_db_t *db, int *rc) {
+    if (!db->stats_shards) return NULL;
+    mongolite_op_stats_shard_t *shards = calloc(MONGOLITE_STATS_SHARDS, sizeof(*shards));
+    if (!shards) *rc = MONGOLITE_ENOMEM;
+    return shards;
+}
+
+mongolite_op_stats_shard_t* _mongolite_collection_stats_lookup(mongolite_db_t *db,
+                                                              const char *name) {
+    if (!db || !db->stats_shards || !name) return NULL;
+    mongolite_tree_cache_entry_t *entry =
+        _mongolite_tree_cache_lookup(db, name, _mongolite_name_hash(name));
+    return entry ? entry->stats : NULL;
+}
+
+MONGOLITE_HOT
+void _mongolite_stats_query(mongolite_db_t *db, mongolite_op_stats_shard_t *col,
+                            mongolite_plan_type_t plan) {
+    if (MONGOLITE_UNLIKELY(db && db->slowlog)) {
+        _mongolite_trace.plan = plan;
+        _mongolite_trace.planned = true;
+    }
+
+    mongolite_stats_t *shard = _mongolite_stats_shard(db);
+    if (!shard) return;
+    unsigned s = _shard_index();
+
+    size_t offset;
+    switch (plan) {
+        case MONGOLITE_PLAN_ID:       offset = offsetof(mongolite_op_stats_t, id_queries); break;
+        case MONGOLITE_PLAN_INDEX_EQ:
+        case MONGOLITE_PLAN_INDEX_MULTI: offset = offsetof(mongolite_op_stats_t, index_queries); break;
+        default:                      offset = offsetof(mongolite_op_stats_t, scan_queries); break;
+    }
+
+    MONGOLITE_ATOMIC_ADD((uint64_t *)((char *)&shard->totals + offset), (uint64_t)1);
+    if (col) {
+        MONGOLITE_ATOMIC_ADD((uint64_t *)((char *)&col[s].counters + offset), (uint64_t)1);
+    }
+}
+
+MONGOLITE_HOT
+void _mongolite_stats_docs(mongolite_db_t *db, mongolite_op_stats_shard_t *col,
+                           uint64_t scanned, uint64_t returned, uint64_t evals) {
+    if (MONGOLITE_UNLIKELY(db && db->slowlog)) {
+        _mongolite_trace.docs_examined += scanned;
+        _mongolite_trace.docs_returned += returned;
+    }
+
+    mongolite_stats_t *shard = _mongolite_stats_shard(db);
+    if (!shard) return;
+
+    if (scanned) MONGOLITE_ATOMIC_ADD(&shard->totals.docs_scanned, scanned);
+    if (returned) MONGOLITE_ATOMIC_ADD(&shard->totals.docs_returned, returned);
+    if (evals) MONGOLITE_ATOMIC_ADD(&shard->totals.matcher_evals, evals);
+
+    if (col) {
+        mongolite_op_stats_t *c = &col[_shard_index()].counters;
+        if (scanned) MONGOLITE_ATOMIC_ADD(&c->docs_scanned, scanned);
+        if (returned) MONGOLITE_ATOMIC_ADD(&c->docs_returned, returned);
+        if (evals) MONGOLITE_ATOMIC_ADD(&c->matcher_evals, evals);
+    }
+}
+
+/* ============================================================
+ * Public API
+ * ============================================================ */
+
+static void _sum_op_stats(mongolite_op_stats_t *dst, const mongolite_op_stats_t *src) {
+    dst->id_queries += MONGOLITE_ATOMIC_LOAD(&src->id_queries);
+    dst->index_queries += MONGOLITE_ATOMIC_LOAD(&src->index_queries);
+    dst->scan_queries += MONGOLITE_ATOMIC_LOAD(&src->scan_queries);
+    dst->docs_scanned += MONGOLITE_ATOMIC_LOAD(&src->docs_scanned);
+    dst->docs_returned += MONGOLITE_ATOMIC_LOAD(&src->docs_returned);
+    dst->matcher_evals += MONGOLITE_ATOMIC_LOAD(&src->matcher_evals);
+}
+
+int mongolite_stats(mongolite_db_t *db, mongolite_stats_t *out, gerror_t *error) {
+    if (!db || !out) {
+        set_error(error, MONGOLITE_LIB, MONGOLITE_EINVAL,
+                 "Database and output are required");
+        return MONGOLITE_EINVAL;
+    }
+
+    memset(out, 0, sizeof(*out));
+    if (!db->stats_shards) return MONGOLITE_OK;
+
+    for (size_t s = 0; s < MONGOLITE_STATS_SHARDS; s++) {
+        mongolite_stats_t *shard = &db->stats_shards[s];
+
+        _sum_op_stats(&out->totals, &shard->totals);
+
+        for (int op = 0; op < MONGOLITE_OP_MAX; op++) {
+            const mongolite_latency_t *src = &shard->latency[op];
+            mongolite_latency_t *dst = &out->latency[op];
+            dst->count += MONGOLITE_ATOMIC_LOAD(&src->count);
+            dst->total_ns += MONGOLITE_ATOMIC_LOAD(&src->total_ns);
+            uint64_t max_ns = MONGOLITE_ATOMIC_LOAD(&src->max_ns);
+            if (max_ns > dst->max_ns) dst->max_ns = max_ns;
+            for (int b = 0; b < MONGOLITE_LATENCY_BUCKETS; b++) {
+                dst->buckets[b] += MONGOLITE_ATOMIC_LOAD(&src->buckets[b]);
+            }
+        }
+
+        out->read_txn_begins += MONGOLITE_ATOMIC_LOAD(&shard->read_txn_begins);
+        out->read_txn_renews += MONGOLITE_ATOMIC_LOAD(&shard->read_txn_renews);
+        out->write_txn_begins += MONGOLITE_ATOMIC_LOAD(&shard->write_txn_begins);
+        out->resizes += MONGOLITE_ATOMIC_LOAD(&shard->resizes);
+        out->map_grows += MONGOLITE_ATOMIC_LOAD(&shard->map_grows);
+        out->map_full_replays += MONGOLITE_ATOMIC_LOAD(&shard->map_full_replays);
+        out->parallel_scans += MONGOLITE_ATOMIC_LOAD(&shard->parallel_scans);
+        out->readahead_hints += MONGOLITE_ATOMIC_LOAD(&shard->readahead_hints);
+        out->index_intersections += MONGOLITE_ATOMIC_LOAD(&shard->index_intersections);
+        out->index_analyses += MONGOLITE_ATOMIC_LOAD(&shard->index_analyses);
+        out->group_commits += MONGOLITE_ATOMIC_LOAD(&shard->group_commits);
+        out->group_ops += MONGOLITE_ATOMIC_LOAD(&shard->group_ops);
+        out->syncs += MONGOLITE_ATOMIC_LOAD(&shard->syncs);
+        out->slow_ops += MONGOLITE_ATOMIC_LOAD(&shard->slow_ops);
+        out->slow_ops_dropped += MONGOLITE_ATOMIC_LOAD(&shard->slow_ops_dropped);
+        out->lock_acquires += MONGOLITE_ATOMIC_LOAD(&shard->lock_acquires);
+        out->lock_contended += MONGOLITE_ATOMIC_LOAD(&shard->lock_contended);
+        out->lock_wait_ns += MONGOLITE_ATOMIC_LOAD(&shard->lock_wait_ns);
+    }
+
+    return MONGOLITE_OK;
+}
+
+int mongolite_collection_stats(mongolite_db_t *db, const char *collection,
+                               mongolite_op_stats_t *out, gerror_t *error) {
+    if (!db || !collection || !out) {
+        set_error(error, MONGOLITE_LIB, MONGOLITE_EINVAL,
+                 "Database, collection and output are required");
+        return MONGOLITE_EINVAL;
+    }
+
+    _mongolite_lock(db);
+
+    mongolite_tree_cache_entry_t *entry = _mongolite_get_collection_entry(db, collection, error);
+    if (!entry) {
+        _mongolite_unlock(db);
+        return MONGOLITE_ENOTFOUND;
+    }
+
+    memset(out, 0, sizeof(*out));
+    for (size_t s = 0; entry->stats && s < MONGOLITE_STATS_SHARDS; s++) {
+        _sum_op_stats(out, &entry->stats[s].counters);
+    }
+
+    _mongolite_unlock(db);
+    return MONGOLITE_OK;
+}
+
+void mongolite_stats_reset(mongolite_db_t *db) {
+    if (!db) return;
+
+    _mongolite_lock(db);
+
+    if (db->stats_shards) {
+        memset(db->stats_shards, 0, MONGOLITE_STATS_SHARDS * sizeof(mongolite_stats_t));
+    }
+    for (size_t i = 0; i < db->tree_cache_capacity; i++) {
+        if (db->tree_cache[i] && db->tree_cache[i]->stats) {
+            memset(db->tree_cache[i]->stats, 0,
+                   MONGOLITE_STATS_SHARDS * sizeof(mongolite_op_stats_shard_t));
+        }
+    }
+
+    _mongolite_unlock(db);
+}
+
+uint64_t mongolite_latency_percentile(const mongolite_latency_t *latency, double percentile) {
+    if (!latency || latency->count == 0) return 0;
+    if (percentile < 0.0) percentile = 0.0;
+    if (percentile > 100.0) percentile = 100.0;
+
+    uint64_t rank = (uint64_t)((percentile / 100.0) * (double)latency->count + 0.5);
+    if (rank == 0) rank = 1;
+
+    uint64_t seen = 0;
+    for (unsigned b = 0; b < MONGOLITE_LATENCY_BUCKETS; b++) {
+        seen += latency->buckets[b];
+        if (seen >= rank) {
+            uint64_t upper = (b + 1 < MONGOLITE_LATENCY_BUCKETS) ?
+                _latency_bucket_floor(b + 1) - 1 : latency->max_ns;
+            return upper < latency->max_ns ? upper : latency->max_ns;
+        }
+    }
+    return latency->max_ns;
+}
@@ -0,0 +1,863 @@
+/*
+ * mongolite_stmt.c - Prepared queries
+ *
+ * Handles:
+ * - mongolite_prepare / mongolite_finalize
+ * - Parameter binding ({"$param": N} placeholders, 1-based)
+ * - Planning once per statement (_id lookup, index equality seek, scan)
+ * - mongolite_step / mongolite_reset execution
+ * - Index seeks fetch their rows in batches (mongolite_readahead.c)
+ *
+ * Modeled on SQLite's prepare/bind/step. The filter shape is analyzed and
+ * the access path chosen at prepare time; the plan is only recomputed when
+ * the collection's indexes change. bsonmatch bakes literal values into its
+ * compiled op tree, so the matcher is rebuilt after rebinding - but only
+ * when the plan needs it: a covered index equality seek skips it entirely.
+ */
+
+#include "mongolite_internal.h"
+#include "mongoc-matcher.h"
+#include "macros.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define MONGOLITE_LIB "mongolite"
+
+/* Upper bound on placeholder numbers (keeps the bindings array small) */
+#define MONGOLITE_MAX_PARAMS 256
+
+/* ============================================================
+ * Placeholder Helpers
+ * ============================================================ */
+
+/* Returns N if iter holds {"$param": N}, 0 otherwise, -1 if malformed */
+static int _param_number(const bson_iter_t *iter) {
+    if (!BSON_ITER_HOLDS_DOCUMENT(iter)) return 0;
+
+    uint32_t len;
+    const uint8_t *data;
+    bson_t sub;
+    bson_iter_t sub_iter;
+
+    bson_iter_document(iter, &len, &data);
+    if (!bson_init_static(&sub, data, len) || !bson_iter_init(&sub_iter, &sub)) {
+        return 0;
+    }
+    if (!bson_iter_next(&sub_iter) ||
+        strcmp(bson_iter_key(&sub_iter), MONGOLITE_PARAM_KEY) != 0) {
+        return 0;
+    }
+
+    int64_t n;
+    if (BSON_ITER_HOLDS_INT32(&sub_iter)) {
+        n = bson_iter_int32(&sub_iter);
+    } else if (BSON_ITER_HOLDS_INT64(&sub_iter)) {
+        n = bson_iter_int64(&sub_iter);
+    } else {
+        return -1;
+    }
+
+    if (bson_iter_next(&sub_iter) || n < 1 || n > MONGOLITE_MAX_PARAMS) {
+        return -1;
+    }
+    return (int)n;
+}
+
+/* Find the highest placeholder number in doc (recurses into docs/arrays) */
+static int _count_params(const bson_t *doc, int *max_param, gerror_t *error) {
+    bson_iter_t iter;
+    if (!bson_iter_init(&iter, doc)) {
+        set_error(error, MONGOLITE_LIB, MONGOLITE_EQUERY, "Invalid filter document");
+        return MONGOLITE_EQUERY;
+    }
+
+    while (bson_iter_next(&iter)) {
+        int n = _param_number(&iter);
+        if (n < 0) {
+            set_error(error, MONGOLITE_LIB, MONGOLITE_EQUERY,
+                     "Invalid placeholder for '%s': expected {\"%s\": 1..%d}",
+                     bson_iter_key(&iter), MONGOLITE_PARAM_KEY, MONGOLITE_MAX_PARAMS);
+            return MONGOLITE_EQUERY;
+        }
+        if (n > 0) {
+            if (n > *max_param) *max_param = n;
+            continue;
+        }
+
+        if (BSON_ITER_HOLDS_DOCUMENT(&iter) || BSON_ITER_HOLDS_ARRAY(&iter)) {
+            uint32_t len;
+            const uint8_t *data;
+            bson_t sub;
+            if (BSON_ITER_HOLDS_DOCUMENT(&iter)) {
+                bson_iter_document(&iter, &len, &data);
+            } else {
+                bson_iter_array(&iter, &len, &data);
+            }
+            if (!bson_init_static(&sub, data, len)) continue;
+            int rc = _count_params(&sub, max_param, error);
+            if (rc != MONGOLITE_OK) return rc;
+        }
+    }
+
+    return MONGOLITE_OK;
+}
+
+/* Copy tmpl into out, replacing placeholders with bound values */
+static bool _substitute_params(const bson_t *tmpl, bson_t *out,
+                               const bson_value_t *params) {
+    bson_iter_t iter;
+    if (!bson_iter_init(&iter, tmpl)) return false;
+
+    while (bson_iter_next(&iter)) {
+        const char *key = bson_iter_key(&iter);
+        int n = _param_number(&iter);
+
+        if (n > 0) {
+            if (!bson_append_value(out, key, -1, &params[n - 1])) return false;
+            continue;
+        }
+
+        if (BSON_ITER_HOLDS_DOCUMENT(&iter) || BSON_ITER_HOLDS_ARRAY(&iter)) {
+            bool is_array = BSON_ITER_HOLDS_ARRAY(&iter);
+            uint32_t len;
+            const uint8_t *data;
+            bson_t sub, child;
+            if (is_array) {
+                bson_iter_array(&iter, &len, &data);
+            } else {
+                bson_iter_document(&iter, &len, &data);
+            }
+            if (!bson_init_static(&sub, data, len)) return false;
+
+            bool ok = is_array ? bson_append_array_begin(out, key, -1, &child)
+                               : bson_append_document_begin(out, key, -1, &child);
+            if (!ok) return false;
+            ok = _substitute_params(&sub, &child, params);
+            ok = (is_array ? bson_append_array_end(out, &child)
+                           : bson_append_document_end(out, &child)) && ok;
+            if (!ok) return false;
+            continue;
+        }
+
+        if (!bson_append_iter(out, key, -1, &iter)) return false;
+    }
+
+    return true;
+}
+
+/* Value types that an index equality seek answers exactly */
+static inline bool _is_exact_scalar(bson_type_t type) {
+    switch (type) {
+        case BSON_TYPE_DOCUMENT:
+        case BSON_TYPE_ARRAY:
+        case BSON_TYPE_REGEX:
+            return false;
+        default:
+            return true;
+    }
+}
+
+/* ============================================================
+ * Shape Analysis
+ *
+ * Records the top-level equality fields of the template. Placeholders
+ * count as equality values; operator documents ({"$gt": ...}), regex
+ * literals and top-level operators ($or, $and, ...) do not.
+ * ============================================================ */
+
+static int _analyze_shape(mongolite_stmt_t *stmt, gerror_t *error) {
+    bson_iter_t iter;
+    size_t field_count = 0;
+
+    if (!bson_iter_init(&iter, stmt->filter)) {
+        set_error(error, MONGOLITE_LIB, MONGOLITE_EQUERY, "Invalid filter document");
+        return MONGOLITE_EQUERY;
+    }
+    while (bson_iter_next(&iter)) field_count++;
+
+    stmt->all_equality = true;
+    if (field_count == 0) return MONGOLITE_OK;
+
+    stmt->eq_fields = calloc(field_count, sizeof(char*));
+    stmt->eq_params = calloc(field_count, sizeof(int));
+    if (!stmt->eq_fields || !stmt->eq_params) {
+        set_error(error, "system", MONGOLITE_ENOMEM, "Failed to allocate statement shape");
+        return MONGOLITE_ENOMEM;
+    }
+
+    bson_iter_init(&iter, stmt->filter);
+    while (bson_iter_next(&iter)) {
+        const char *key = bson_iter_key(&iter);
+        int n = _param_number(&iter);
+
+        if (key[0] == '$' || BSON_ITER_HOLDS_REGEX(&iter)) {
+            stmt->all_equality = false;
+            continue;
+        }
+
+        if (n == 0 && BSON_ITER_HOLDS_DOCUMENT(&iter)) {
+            /* Operator document? */
+            uint32_t len;
+            const uint8_t *data;
+            bson_t sub;
+            bson_iter_t sub_iter;
+            bson_iter_document(&iter, &len, &data);
+            if (bson_init_static(&sub, data, len) && bson_iter_init(&sub_iter, &sub) &&
+                bson_iter_next(&sub_iter) && bson_iter_key(&sub_iter)[0] == '$') {
+                stmt->all_equality = false;
+                continue;
+            }
+        }
+
+        /* Dotted paths and structured literals may match through arrays,
+         * which an exact index key cannot express */
+        if (strchr(key, '.') || (n == 0 && !_is_exact_scalar(bson_iter_type(&iter)))) {
+            stmt->all_equality = false;
+        }
+
+        stmt->eq_fields[stmt->eq_count] = strdup(key);
+        if (!stmt->eq_fields[stmt->eq_count]) {
+            set_error(error, "system", MONGOLITE_ENOMEM, "Failed to allocate statement shape");
+            return MONGOLITE_ENOMEM;
+        }
+        stmt->eq_params[stmt->eq_count] = n;
+        stmt->eq_count++;
+    }
+
+    return MONGOLITE_OK;
+}
+
+/* ============================================================
+ * Planning
+ * ============================================================ */
+
+static size_t _count_keys(const bson_t *doc) {
+    bson_iter_t iter;
+    size_t n = 0;
+    if (doc && bson_iter_init(&iter, doc)) {
+        while (bson_iter_next(&iter)) n++;
+    }
+    return n;
+}
+
+static void _stmt_plan(mongolite_stmt_t *stmt, mongolite_tree_cache_entry_t *entry) {
+    stmt->plan = MONGOLITE_PLAN_SCAN;
+    stmt->index = NULL;
+    stmt->covered = false;
+    stmt->plan_entry = entry;
+    stmt->plan_generation = stmt->db->tree_cache_generation;
+    stmt->plan_epoch = entry->index_epoch;
+
+    /* {_id: <oid or placeholder>} */
+    if (stmt->eq_count == 1 && stmt->all_equality &&
+        strcmp(stmt->eq_fields[0], "_id") == 0 && _count_keys(stmt->filter) == 1) {
+        stmt->plan = MONGOLITE_PLAN_ID;
+        return;
+    }
+
+    /* Equality fields other than _id drive index selection */
+    if (stmt->eq_count == 0) return;
+    char **fields = malloc(stmt->eq_count * sizeof(char*));
+    if (!fields) return;
+
+    size_t n = 0;
+    for (size_t i = 0; i < stmt->eq_count; i++) {
+        if (strcmp(stmt->eq_fields[i], "_id") != 0) {
+            fields[n++] = stmt->eq_fields[i];
+        }
+    }
+    if (n == 0) {
+        free(fields);
+        return;
+    }
+
+    query_analysis_t analysis = {
+        .equality_fields = fields,
+        .equality_count = n,
+        .is_simple_equality = true
+    };
+    mongolite_cached_index_t *idx = _find_best_index_entry(stmt->db, entry, &analysis, NULL);
+    free(fields);
+    if (!idx) return;
+
+    stmt->plan = MONGOLITE_PLAN_INDEX_EQ;
+    stmt->index = idx;
+    /* Every predicate is an equality on an index key field */
+    stmt->covered = stmt->all_equality && n == stmt->eq_count &&
+                    _count_keys(idx->keys) == n;
+}
+
+/* ============================================================
+ * Execution Helpers
+ * ============================================================ */
+
+/* Flush an index seek's document counters. Like a cursor's, they are
+ * attributed by name: the plan's entry may be gone by now. */
+static void _stmt_flush_stats(mongolite_stmt_t *stmt) {
+    mongolite_db_t *db = stmt->db;
+    if (stmt->rows_scanned == 0) return;
+
+    if (db->stats_shards) _mongolite_lock(db);
+    _mongolite_stats_docs(db, _mongolite_collection_stats_lookup(db, stmt->col->name),
+                          stmt->rows_scanned, stmt->rows_returned,
+                          stmt->match_rows ? stmt->rows_scanned : 0);
+    if (db->stats_shards) _mongolite_unlock(db);
+    stmt->rows_scanned = 0;
+    stmt->rows_returned = 0;
+}
+
+static void _stmt_end(mongolite_stmt_t *stmt) {
+    _stmt_flush_stats(stmt);
+    if (stmt->index_cursor) {
+        mdb_cursor_close(stmt->index_cursor);
+        stmt->index_cursor = NULL;
+    }
+    if (stmt->txn) {
+        if (!stmt->session_txn) {
+            wtree3_txn_abort(stmt->txn);
+            MONGOLITE_ATOMIC_ADD(&stmt->db->cursor_txns, (uint64_t)-1);
+        }
+        stmt->txn = NULL;
+        stmt->session_txn = false;
+    }
+    stmt->index_done = false;
+    stmt->tree = NULL;
+    stmt->batch_len = 0;
+    stmt->batch_pos = 0;
+    if (stmt->scan) {
+        mongolite_cursor_destroy(stmt->scan);
+        stmt->scan = NULL;
+    }
+    stmt->active = false;
+    stmt->done = false;
+}
+
+static int _stmt_prepare_bindings(mongolite_stmt_t *stmt, gerror_t *error) {
+    for (int i = 0; i < stmt->param_count; i++) {
+        if (!stmt->bound[i]) {
+            set_error(error, MONGOLITE_LIB, MONGOLITE_EINVAL,
+                     "Parameter %d is not bound", i + 1);
+            return MONGOLITE_EINVAL;
+        }
+    }
+
+    if (!stmt->bindings_dirty) return MONGOLITE_OK;
+
+    if (stmt->matcher) {
+        mongoc_matcher_destroy(stmt->matcher);
+        stmt->matcher = NULL;
+    }
+
+    if (stmt->param_count > 0) {
+        if (stmt->bound_filter) {
+            bson_reinit(stmt->bound_filter);
+        } else {
+            stmt->bound_filter = bson_new();
+        }
+        if (!stmt->bound_filter ||
+            !_substitute_params(stmt->filter, stmt->bound_filter, stmt->params)) {
+            set_error(error, MONGOLITE_LIB, MONGOLITE_ENOMEM,
+                     "Failed to build filter from bindings");
+            return MONGOLITE_ENOMEM;
+        }
+    }
+
+    stmt->bindings_dirty = false;
+    return MONGOLITE_OK;
+}
+
+static inline const bson_t* _stmt_filter(const mongolite_stmt_t *stmt) {
+    return stmt->param_count > 0 ? stmt->bound_filter : stmt->filter;
+}
+
+static int _stmt_ensure_matcher(mongolite_stmt_t *stmt, gerror_t *error) {
+    if (stmt->matcher) return MONGOLITE_OK;
+
+    bson_error_t bson_err;
+    stmt->matcher = mongoc_matcher_new(_stmt_filter(stmt), &bson_err);
+    if (!stmt->matcher) {
+        set_error(error, "bsonmatch", MONGOLITE_EQUERY,
+                 "Invalid query: %s", bson_err.message);
+        return MONGOLITE_EQUERY;
+    }
+    return MONGOLITE_OK;
+}
+
+/* Expose a row copied out of a (soon released) transaction */
+static int _stmt_set_row_copy(mongolite_stmt_t *stmt, const void *data, size_t len) {
+    if (len > stmt->row_cap) {
+        uint8_t *buf = realloc(stmt->row_buf, len);
+        if (!buf) return MONGOLITE_ENOMEM;
+        stmt->row_buf = buf;
+        stmt->row_cap = len;
+    }
+    memcpy(stmt->row_buf, data, len);
+    return bson_init_static(&stmt->current, stmt->row_buf, len) ? MONGOLITE_OK : MONGOLITE_ERROR;
+}
+
+/* Does a bound placeholder prevent an exact index seek? */
+static bool _stmt_bindings_exact(const mongolite_stmt_t *stmt, bool *seekable) {
+    bool exact = true;
+    *seekable = true;
+    for (size_t i = 0; i < stmt->eq_count; i++) {
+        int n = stmt->eq_params[i];
+        if (n == 0) continue;
+        bson_type_t type = stmt->params[n - 1].value_type;
+        if (type == BSON_TYPE_REGEX) *seekable = false;
+        if (!_is_exact_scalar(type)) exact = false;
+    }
+    return exact;
+}
+
+/* Single-row plans: _id lookup or unique index seek, on the pooled read txn */
+static int _stmt_run_single(mongolite_stmt_t *stmt, mongolite_tree_cache_entry_t *entry,
+                            const void *id_key, size_t id_len, const bson_t *index_key,
+                            bool need_match, gerror_t *error) {
+    mongolite_db_t *db = stmt->db;
+    wtree3_txn_t *txn = _mongolite_get_read_txn(db, error);
+    if (MONGOLITE_UNLIKELY(!txn)) return MONGOLITE_ETXN;
+
+    int rc = MONGOLITE_OK;
+    stmt->done = true;
+
+    if (index_key) {
+        MDB_val key = {.mv_size = index_key->len, .mv_data = (void*)bson_get_data(index_key)};
+        MDB_val val;
+        int mrc = mdb_get(wtree3_txn_get_mdb(txn), stmt->index->dbi, &key, &val);
+        if (mrc != MDB_SUCCESS || val.mv_size != 12) {
+            _mongolite_release_read_txn(db, txn);
+            return MONGOLITE_OK;  /* No row */
+        }
+        id_key = val.mv_data;
+        id_len = val.mv_size;
+    }
+
+    const void *data;
+    size_t len;
+    if (wtree3_get_txn(txn, entry->tree, id_key, id_len, &data, &len, NULL) == 0) {
+        bson_t doc;
+        bool match = true;
+        if (need_match) {
+            match = bson_init_static(&doc, data, len) &&
+                    mongoc_matcher_match(stmt->matcher, &doc);
+        }
+        if (match) {
+            rc = _stmt_set_row_copy(stmt, data, len);
+            if (rc == MONGOLITE_OK) stmt->done = false;  /* One row pending */
+        }
+        _mongolite_stats_docs(db, entry->stats, 1, match ? 1 : 0, need_match ? 1 : 0);
+    }
+
+    _mongolite_release_read_txn(db, txn);
+    if (rc != MONGOLITE_OK) {
+        set_error(error, "system", rc, "Failed to copy result row");
+    }
+    return rc;
+}
+
+/* Multi-row index plan: own read txn + cursor positioned on the key.
+ * Steps run without the db lock, so they use the tree copied here. */
+static int _stmt_open_index_cursor(mongolite_stmt_t *stmt, mongolite_tree_cache_entry_t *entry,
+                                   const bson_t *index_key, gerror_t *error) {
+    stmt->tree = entry->tree;
+
+    /* Inside a session, read its snapshot */
+    stmt->txn = _mongolite_session_txn(stmt->db);
+    stmt->session_txn = (stmt->txn != NULL);
+    if (!stmt->txn) {
+        stmt->txn = wtree3_txn_begin(stmt->db->wdb, false, error);
+        if (!stmt->txn) return MONGOLITE_ETXN;
+        MONGOLITE_ATOMIC_ADD(&stmt->db->cursor_txns, 1);
+        MONGOLITE_STAT(stmt->db, read_txn_begins, 1);
+    }
+
+    int rc = mdb_cursor_open(wtree3_txn_get_mdb(stmt->txn), stmt->index->dbi,
+                             &stmt->index_cursor);
+    if (rc != MDB_SUCCESS) {
+        set_error(error, "lmdb", rc, "Failed to open cursor: %s", mdb_strerror(rc));
+        return MONGOLITE_ERROR;
+    }
+
+    MDB_val key = {.mv_size = index_key->len, .mv_data = (void*)bson_get_data(index_key)};
+    MDB_val val;
+    rc = mdb_cursor_get(stmt->index_cursor, &key, &val, MDB_SET_KEY);
+    if (rc == MDB_NOTFOUND) {
+        stmt->done = true;
+    } else if (rc != MDB_SUCCESS) {
+        set_error(error, "lmdb", rc, "Failed to seek index: %s", mdb_strerror(rc));
+        return MONGOLITE_ERROR;
+    }
+    stmt->index_op = MDB_GET_CURRENT;
+    _mongolite_readahead_init(stmt->db, stmt->txn, &stmt->readahead);
+    return MONGOLITE_OK;
+}
+
+/* Next duplicates of the key, looked up together so their documents are
+ * hinted before being read. A session's write txn may change them between
+ * steps, so it fetches one at a time. A missing document leaves its row
+ * empty (skipped); a failed read is returned. */
+static int _stmt_fill_batch(mongolite_stmt_t *stmt, gerror_t *error) {
+    const void *ids[MONGOLITE_FETCH_BATCH];
+    size_t cap = stmt->session_txn ? 1 : MONGOLITE_FETCH_BATCH;
+    size_t n = 0;
+
+    stmt->batch_pos = 0;
+    stmt->batch_len = 0;
+
+    MDB_val key, val;
+    while (n < cap) {
+        int mrc = mdb_cursor_get(stmt->index_cursor, &key, &val, stmt->index_op);
+        if (mrc != MDB_SUCCESS) {
+            stmt->index_done = true;
+            if (mrc == MDB_NOTFOUND) break;
+            set_error(error, "lmdb", mrc, "Failed to read index: %s", mdb_strerror(mrc));
+            return MONGOLITE_ERROR;
+        }
+        stmt->index_op = MDB_NEXT_DUP;
+        if (val.mv_size != 12) continue;
+        _mongolite_readahead_seq(&stmt->readahead, val.mv_data);
+        ids[n++] = val.mv_data;
+    }
+
+    int rc = _mongolite_fetch_batch(&stmt->readahead, stmt->txn, stmt->tree,
+                                    ids, n, stmt->batch, error);
+    if (MONGOLITE_UNLIKELY(rc != MONGOLITE_OK)) return rc;
+    stmt->batch_len = n;
+    return MONGOLITE_OK;
+}
+
+static int _stmt_begin(mongolite_stmt_t *stmt, gerror_t *error) {
+    mongolite_tree_cache_entry_t *entry = _mongolite_collection_resolve(stmt->col, error);
+    if (!entry) return MONGOLITE_ENOTFOUND;
+
+    /* Replan when the collection was re-opened or its indexes changed. A
+     * re-created entry may reuse the address, so check the generation. */
+    if (MONGOLITE_UNLIKELY(entry != stmt->plan_entry ||
+                           stmt->db->tree_cache_generation != stmt->plan_generation ||
+                           entry->index_epoch != stmt->plan_epoch)) {
+        _stmt_plan(stmt, entry);
+    }
+
+    int rc = _stmt_prepare_bindings(stmt, error);
+    if (rc != MONGOLITE_OK) return rc;
+
+    stmt->active = true;
+    stmt->done = false;
+    const bson_t *filter = _stmt_filter(stmt);
+
+    mongolite_plan_type_t plan = stmt->plan;
+    bool seekable = true;
+    bool exact = _stmt_bindings_exact(stmt, &seekable);
+
+    if (plan == MONGOLITE_PLAN_ID) {
+        bson_iter_t iter;
+        if (bson_iter_init_find(&iter, filter, "_id") && BSON_ITER_HOLDS_OID(&iter)) {
+            const bson_oid_t *oid = bson_iter_oid(&iter);
+            _mongolite_stats_query(stmt->db, entry->stats, MONGOLITE_PLAN_ID);
+            return _stmt_run_single(stmt, entry, oid->bytes, sizeof(oid->bytes),
+                                    NULL, false, error);
+        }
+        plan = MONGOLITE_PLAN_SCAN;  /* Non-OID _id: keyed by generated OID */
+    }
+
+    if (plan == MONGOLITE_PLAN_INDEX_EQ && !_mongolite_index_eq_seekable(stmt->index, filter, &exact)) {
+        seekable = false;
+    }
+
+    if (plan == MONGOLITE_PLAN_INDEX_EQ && seekable) {
+        bool need_match = !(stmt->covered && exact);
+        if (need_match && (rc = _stmt_ensure_matcher(stmt, error)) != MONGOLITE_OK) {
+            return rc;
+        }
+        stmt->match_rows = need_match;
+        _mongolite_stats_query(stmt->db, entry->stats, MONGOLITE_PLAN_INDEX_EQ);
+
+        bson_t index_key;
+        bson_init(&index_key);
+        if (!_mongolite_index_key_from_filter(filter, stmt->index->keys, &index_key)) {
+            bson_destroy(&index_key);
+            set_error(error, MONGOLITE_LIB, MONGOLITE_EQUERY, "Failed to build index key");
+            return MONGOLITE_EQUERY;
+        }
+
+        if (stmt->index->unique) {
+            rc = _stmt_run_single(stmt, entry, NULL, 0, &index_key, need_match, error);
+        } else {
+            rc = _stmt_open_index_cursor(stmt, entry, &index_key, error);
+        }
+        bson_destroy(&index_key);
+        return rc;
+    }
+
+    /* Scan: cursor compiles its own matcher from the concrete filter */
+    stmt->scan = _mongolite_find_entry(stmt->db, entry, filter, NULL, error);
+    return stmt->scan ? MONGOLITE_OK : MONGOLITE_ERROR;
+}
+
+/* ============================================================
+ * Prepare / Finalize
+ * ============================================================ */
+
+mongolite_stmt_t* mongolite_prepare(mongolite_db_t *db, const char *collection,
+                                    const bson_t *filter, const bson_t *projection,
+                                    gerror_t *error) {
+    if (!db || !collection) {
+        set_error(error, MONGOLITE_LIB, MONGOLITE_EINVAL,
+                 "Database and collection are required");
+        return NULL;
+    }
+    if (projection && !bson_empty(projection)) {
+        set_error(error, MONGOLITE_LIB, MONGOLITE_EINVAL,
+                 "Projections are not supported by prepared statements");
+        return NULL;
+    }
+
+    mongolite_stmt_t *stmt = calloc(1, sizeof(mongolite_stmt_t));
+    if (!stmt) {
+        set_error(error, "system", MONGOLITE_ENOMEM, "Failed to allocate statement");
+        return NULL;
+    }
+    stmt->db = db;
+
+    stmt->filter = filter ? bson_copy(filter) : bson_new();
+    if (!stmt->filter) {
+        set_error(error, "system", MONGOLITE_ENOMEM, "Failed to copy filter");
+        mongolite_finalize(stmt);
+        return NULL;
+    }
+
+    if (_count_params(stmt->filter, &stmt->param_count, error) != MONGOLITE_OK ||
+        _analyze_shape(stmt, error) != MONGOLITE_OK) {
+        mongolite_finalize(stmt);
+        return NULL;
+    }
+
+    if (stmt->param_count > 0) {
+        stmt->params = calloc((size_t)stmt->param_count, sizeof(bson_value_t));
+        stmt->bound = calloc((size_t)stmt->param_count, sizeof(bool));
+        if (!stmt->params || !stmt->bound) {
+            set_error(error, "system", MONGOLITE_ENOMEM, "Failed to allocate bindings");
+            mongolite_finalize(stmt);
+            return NULL;
+        }
+    } else {
+        /* Validate the literal filter now (reported at prepare, not step) */
+        if (_stmt_ensure_matcher(stmt, error) != MONGOLITE_OK) {
+            mongolite_finalize(stmt);
+            return NULL;
+        }
+    }
+    stmt->bindings_dirty = true;
+
+    stmt->col = mongolite_collection_open(db, collection, error);
+    if (!stmt->col) {
+        mongolite_finalize(stmt);
+        return NULL;
+    }
+
+    _mongolite_lock(db);
+    mongolite_tree_cache_entry_t *entry = _mongolite_collection_resolve(stmt->col, error);
+    if (entry) {
+        _stmt_plan(stmt, entry);
+    }
+    _mongolite_unlock(db);
+
+    if (!entry) {
+        mongolite_finalize(stmt);
+        return NULL;
+    }
+
+    return stmt;
+}
+
+void mongolite_finalize(mongolite_stmt_t *stmt) {
+    if (!stmt) return;
+
+    _stmt_end(stmt);
+
+    if (stmt->matcher) mongoc_matcher_destroy(stmt->matcher);
+    if (stmt->bound_filter) bson_destroy(stmt->bound_filter);
+    if (stmt->filter) bson_destroy(stmt->filter);
+
+    if (stmt->params) {
+        for (int i = 0; i < stmt->param_count; i++) {
+            if (stmt->bound[i]) bson_value_destroy(&stmt->params[i]);
+        }
+        free(stmt->params);
+    }
+    free(stmt->bound);
+
+    if (stmt->eq_fields) {
+        for (size_t i = 0; i < stmt->eq_count; i++) {
+            free(stmt->eq_fields[i]);
+        }
+        free(stmt->eq_fields);
+    }
+    free(stmt->eq_params);
+    free(stmt->row_buf);
+
+    mongolite_collection_close(stmt->col);
+    free(stmt);
+}
+
+/* ============================================================
+ * Binding
+ * ============================================================ */
+
+int mongolite_bind_count(mongolite_stmt_t *stmt) {
+    return stmt ? stmt->param_count : 0;
+}
+
+int mongolite_bind_value(mongolite_stmt_t *stmt, int index, const bson_value_t *value) {
+    if (!stmt || !value) return MONGOLITE_EINVAL;
+    if (index < 1 || index > stmt->param_count) return MONGOLITE_EINVAL;
+
+    /* Rebinding implies a reset (SQLite requires it explicitly) */
+    if (stmt->active) _stmt_end(stmt);
+
+    bson_value_t *slot = &stmt->params[index - 1];
+    if (stmt->bound[index - 1]) {
+        bson_value_destroy(slot);
+    }
+    bson_value_copy(value, slot);
+    stmt->bound[index - 1] = true;
+    stmt->bindings_dirty = true;
+    return MONGOLITE_OK;
+}
+
+int mongolite_bind_int32(mongolite_stmt_t *stmt, int index, int32_t value) {
+    bson_value_t v = {.value_type = BSON_TYPE_INT32};
+    v.value.v_int32 = value;
+    return mongolite_bind_value(stmt, index, &v);
+}
+
+int mongolite_bind_int64(mongolite_stmt_t *stmt, int index, int64_t value) {
+    bson_value_t v = {.value_type = BSON_TYPE_INT64};
+    v.value.v_int64 = value;
+    return mongolite_bind_value(stmt, index, &v);
+}
+
+int mongolite_bind_double(mongolite_stmt_t *stmt, int index, double value) {
+    bson_value_t v = {.value_type = BSON_TYPE_DOUBLE};
+    v.value.v_double = value;
+    return mongolite_bind_value(stmt, index, &v);
+}
+
+int mongolite_bind_bool(mongolite_stmt_t *stmt, int index, bool value) {
+    bson_value_t v = {.value_type = BSON_TYPE_BOOL};
+    v.value.v_bool = value;
+    return mongolite_bind_value(stmt, index, &v);
+}
+
+int mongolite_bind_null(mongolite_stmt_t *stmt, int index) {
+    bson_value_t v = {.value_type = BSON_TYPE_NULL};
+    return mongolite_bind_value(stmt, index, &v);
+}
+
+int mongolite_bind_utf8(mongolite_stmt_t *stmt, int index, const char *value) {
+    if (!value) return MONGOLITE_EINVAL;
+    bson_value_t v = {.value_type = BSON_TYPE_UTF8};
+    v.value.v_utf8.str = (char*)value;
+    v.value.v_utf8.len = (uint32_t)strlen(value);
+    return mongolite_bind_value(stmt, index, &v);
+}
+
+int mongolite_bind_oid(mongolite_stmt_t *stmt, int index, const bson_oid_t *value) {
+    if (!value) return MONGOLITE_EINVAL;
+    bson_value_t v = {.value_type = BSON_TYPE_OID};
+    bson_oid_copy(value, &v.value.v_oid);
+    return mongolite_bind_value(stmt, index, &v);
+}
+
+int mongolite_clear_bindings(mongolite_stmt_t *stmt) {
+    if (!stmt) return MONGOLITE_EINVAL;
+    if (stmt->active) _stmt_end(stmt);
+    for (int i = 0; i < stmt->param_count; i++) {
+        if (stmt->bound[i]) {
+            bson_value_destroy(&stmt->params[i]);
+            stmt->bound[i] = false;
+        }
+    }
+    stmt->bindings_dirty = true;
+    return MONGOLITE_OK;
+}
+
+/* ============================================================
+ * Step / Reset
+ * ============================================================ */
+
+/* Finish the execution; the next step starts over (like SQLite's auto-reset) */
+static inline int _stmt_done(mongolite_stmt_t *stmt) {
+    _stmt_end(stmt);
+    return MONGOLITE_DONE;
+}
+
+MONGOLITE_HOT
+int mongolite_step(mongolite_stmt_t *stmt, const bson_t **doc, gerror_t *error) {
+    if (MONGOLITE_UNLIKELY(!stmt || !doc)) {
+        set_error(error, MONGOLITE_LIB, MONGOLITE_EINVAL, "Statement and doc are required");
+        return MONGOLITE_EINVAL;
+    }
+    *doc = NULL;
+
+    if (!stmt->active) {
+        _mongolite_lock(stmt->db);
+        int rc = _stmt_begin(stmt, error);
+        _mongolite_unlock(stmt->db);
+        if (MONGOLITE_UNLIKELY(rc != MONGOLITE_OK)) {
+            _stmt_end(stmt);
+            return rc;
+        }
+
+        /* Single-row plans have their row ready */
+        if (!stmt->txn && !stmt->scan) {
+            if (stmt->done) return _stmt_done(stmt);
+            stmt->done = true;
+            *doc = &stmt->current;
+            return MONGOLITE_ROW;
+        }
+    }
+
+    if (stmt->done) return _stmt_done(stmt);
+
+    if (stmt->scan) {
+        if (mongolite_cursor_next(stmt->scan, doc)) return MONGOLITE_ROW;
+        int rc = mongolite_cursor_error(stmt->scan, error);
+        if (MONGOLITE_UNLIKELY(rc != MONGOLITE_OK)) {
+            _stmt_end(stmt);
+            return rc;
+        }
+        return _stmt_done(stmt);
+    }
+
+    /* Index equality seek: serve the fetched rows, then the next batch */
+    for (;;) {
+        while (stmt->batch_pos < stmt->batch_len) {
+            const mongolite_fetch_t *row = &stmt->batch[stmt->batch_pos++];
+            /* Zero-copy: valid while the statement's txn is open */
+            if (!row->data || !bson_init_static(&stmt->current, row->data, row->len)) continue;
+            bool match = !stmt->match_rows || mongoc_matcher_match(stmt->matcher, &stmt->current);
+            stmt->rows_scanned++;
+            if (!match) continue;
+
+            stmt->rows_returned++;
+
+            *doc = &stmt->current;
+            return MONGOLITE_ROW;
+        }
+        if (stmt->index_done) break;
+        int rc = _stmt_fill_batch(stmt, error);
+        if (MONGOLITE_UNLIKELY(rc != MONGOLITE_OK)) {
+            _stmt_end(stmt);
+            return rc;
+        }
+    }
+
+    return _stmt_done(stmt);
+}
+
+int mongolite_reset(mongolite_stmt_t *stmt) {
+    if (!stmt) return MONGOLITE_EINVAL;
+    _stmt_end(stmt);
+    return MONGOLITE_OK;
+}
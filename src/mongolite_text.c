@@ -0,0 +1,287 @@
+/*
+ * mongolite_text.c - Text indexes
+ *
+ * Handles:
+ * - Tokenizing text the way bsonmatch's $text op does (its stop
+ *   characters and, when built with a stemmer, its stemming language)
+ * - The multi-key extractor: one {_fts: <term>} key per distinct term
+ *   of a document's text fields
+ * - Parsing {$text: {$search: ...}} and removing it from a filter
+ *
+ * An index whose key values are all "text" (e.g. {"title": "text",
+ * "body": "text"}) is an inverted index: each term's duplicates are the
+ * _ids of the documents holding it, in _id order, so a query's terms are
+ * intersected by merge-joining their posting lists (mongolite_query_index.c)
+ * before any document is read. Terms are lowercased; a document or
+ * search with no terms has no keys.
+ */
+
+#include "mongolite_internal.h"
+#include "macros.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef WITH_TEXT
+#include "mongoc-matcher-op-text.h"
+#endif
+#ifdef WITH_STEMMER
+#include "libstemmer.h"
+#endif
+
+#define MONGOLITE_LIB "mongolite"
+
+/* The $text op's defaults (mongoc-matcher-op-text.h), which is compiled
+ * only WITH_TEXT */
+#ifdef DEFAULT_TEXT_STOPCHARS
+#define MONGOLITE_TEXT_STOPCHARS DEFAULT_TEXT_STOPCHARS
+#define MONGOLITE_TEXT_LANGUAGE  DEFAULT_TEXT_STEMMING_LANG
+#else
+#define MONGOLITE_TEXT_STOPCHARS " ,.-?;:()&@#%$^"
+#define MONGOLITE_TEXT_LANGUAGE  "english"
+#endif
+
+/* ============================================================
+ * Tokenizer
+ * ============================================================ */
+
+void _mongolite_text_terms_init(mongolite_text_terms_t *t) {
+    memset(t, 0, sizeof(*t));
+}
+
+void _mongolite_text_terms_free(mongolite_text_terms_t *t) {
+    free(t->arena);
+    free(t->terms);
+#ifdef WITH_STEMMER
+    if (t->stemmer) sb_stemmer_delete(t->stemmer);
+#endif
+    memset(t, 0, sizeof(*t));
+}
+
+static bool _terms_push(mongolite_text_terms_t *t, const char *term, size_t len) {
+    if (len > MONGOLITE_TEXT_MAX_TERM) {
+        /* Long terms are cut at a character boundary */
+        len = MONGOLITE_TEXT_MAX_TERM;
+        while (len > 0 && ((unsigned char)term[len] & 0xC0) == 0x80) len--;
+    }
+    if (t->used + len > t->arena_cap) {
+        size_t grown = t->arena_cap ? t->arena_cap * 2 : 256;
+        while (grown < t->used + len) grown *= 2;
+        char *tmp = realloc(t->arena, grown);
+        if (!tmp) return false;
+        t->arena = tmp;
+        t->arena_cap = grown;
+    }
+    if (t->n == t->cap) {
+        size_t grown = t->cap ? t->cap * 2 : 32;
+        mongolite_text_term_t *tmp = realloc(t->terms, grown * sizeof(*tmp));
+        if (!tmp) return false;
+        t->terms = tmp;
+        t->cap = grown;
+    }
+    memcpy(t->arena + t->used, term, len);
+    t->terms[t->n].off = t->used;
+    t->terms[t->n].len = (uint32_t)len;
+    t->n++;
+    t->used += len;
+    return true;
+}
+
+/* Add the terms of one string: split on the stop characters and ASCII
+ * whitespace, lowercased (ASCII), stemmed when built WITH_STEMMER */
+bool _mongolite_text_terms_add(mongolite_text_terms_t *t, const char *text, size_t len) {
+    bool sep[256] = {false};
+    for (const char *s = MONGOLITE_TEXT_STOPCHARS; *s; s++) sep[(unsigned char)*s] = true;
+    for (int c = 0; c <= ' '; c++) sep[c] = true;
+
+    char word[MONGOLITE_TEXT_MAX_TERM * 4];
+    size_t i = 0;
+    while (i < len) {
+        while (i < len && sep[(unsigned char)text[i]]) i++;
+        size_t start = i;
+        while (i < len && !sep[(unsigned char)text[i]]) i++;
+        if (i == start) break;
+
+        size_t n = i - start < sizeof(word) ? i - start : sizeof(word);
+        for (size_t k = 0; k < n; k++) {
+            char c = text[start + k];
+            word[k] = (c >= 'A' && c <= 'Z') ? (char)(c + ('a' - 'A')) : c;
+        }
+
+        const char *term = word;
+#ifdef WITH_STEMMER
+        if (!t->stemmer) t->stemmer = sb_stemmer_new(MONGOLITE_TEXT_LANGUAGE, NULL);
+        if (t->stemmer) {
+            term = (const char *)sb_stemmer_stem(t->stemmer, (const sb_symbol *)word, (int)n);
+            n = (size_t)sb_stemmer_length(t->stemmer);
+        }
+#endif
+        if (!_terms_push(t, term, n)) return false;
+    }
+    return true;
+}
+
+static int _term_cmp(const void *a, const void *b) {
+    const mongolite_text_term_t *x = a, *y = b;
+    uint32_t n = x->len < y->len ? x->len : y->len;
+    int c = memcmp(x->p, y->p, n);
+    return c ? c : (x->len > y->len) - (x->len < y->len);
+}
+
+/* Point the terms into the arena, sorted and distinct */
+void _mongolite_text_terms_finish(mongolite_text_terms_t *t) {
+    for (size_t i = 0; i < t->n; i++) t->terms[i].p = t->arena + t->terms[i].off;
+    if (t->n < 2) return;
+
+    qsort(t->terms, t->n, sizeof(*t->terms), _term_cmp);
+    size_t m = 1;
+    for (size_t i = 1; i < t->n; i++) {
+        if (_term_cmp(&t->terms[i], &t->terms[m - 1]) != 0) t->terms[m++] = t->terms[i];
+    }
+    t->n = m;
+}
+
+void _mongolite_text_key(const mongolite_text_term_t *term, bson_t *key) {
+    bson_init(key);
+    bson_append_utf8(key, MONGOLITE_TEXT_FIELD, -1, term->p, (int)term->len);
+}
+
+/* ============================================================
+ * Index Spec and Extractor
+ * ============================================================ */
+
+bool _mongolite_text_spec(const bson_t *keys) {
+    bson_iter_t iter;
+    if (!keys || !bson_iter_init(&iter, keys)) return false;
+
+    bool any = false;
+    while (bson_iter_next(&iter)) {
+        if (!BSON_ITER_HOLDS_UTF8(&iter) || strcmp(bson_iter_utf8(&iter, NULL), "text") != 0) {
+            return false;
+        }
+        any = true;
+    }
+    return any;
+}
+
+bool _mongolite_text_mentioned(const bson_t *keys) {
+    bson_iter_t iter;
+    if (!keys || !bson_iter_init(&iter, keys)) return false;
+    while (bson_iter_next(&iter)) {
+        if (BSON_ITER_HOLDS_UTF8(&iter) && strcmp(bson_iter_utf8(&iter, NULL), "text") == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Strings, and strings inside arrays, as the $text op matches them */
+static bool _text_add_value(mongolite_text_terms_t *t, bson_iter_t *value) {
+    if (BSON_ITER_HOLDS_UTF8(value)) {
+        uint32_t len;
+        const char *s = bson_iter_utf8(value, &len);
+        return _mongolite_text_terms_add(t, s, len);
+    }
+
+    bson_iter_t elems;
+    if (BSON_ITER_HOLDS_ARRAY(value) && bson_iter_recurse(value, &elems)) {
+        while (bson_iter_next(&elems)) {
+            if (BSON_ITER_HOLDS_UTF8(&elems) && !_text_add_value(t, &elems)) return false;
+        }
+    }
+    return true;
+}
+
+bool _mongolite_text_extractor(const void *value, size_t value_len,
+                               const bson_t *keys, void **out_key, size_t *out_len) {
+    bson_t doc;
+    bson_iter_t kit;
+    if (!bson_init_static(&doc, value, value_len) || !bson_iter_init(&kit, keys)) {
+        return false;
+    }
+
+    mongolite_text_terms_t t;
+    _mongolite_text_terms_init(&t);
+    bool ok = true;
+    while (ok && bson_iter_next(&kit)) {
+        const char *field = bson_iter_key(&kit);
+        bson_iter_t it, found;
+        if (bson_iter_init_find(&it, &doc, field)) {
+            ok = _text_add_value(&t, &it);
+        } else if (strchr(field, '.') && bson_iter_init(&it, &doc) &&
+                   bson_iter_find_descendant(&it, field, &found)) {
+            ok = _text_add_value(&t, &found);
+        }
+    }
+    _mongolite_text_terms_finish(&t);
+    if (!ok || t.n == 0) {
+        _mongolite_text_terms_free(&t);
+        return false;                   /* No terms: not in the index */
+    }
+
+    /* Packed [uint32_t len][{_fts: term}] per term (see wtree3_index_key_fn) */
+    size_t total = 0;
+    for (size_t i = 0; i < t.n; i++) {
+        total += sizeof(uint32_t) + 16 + strlen(MONGOLITE_TEXT_FIELD) + t.terms[i].len;
+    }
+    uint8_t *buf = malloc(total);
+    size_t used = 0;
+    for (size_t i = 0; buf && i < t.n; i++) {
+        bson_t key;
+        _mongolite_text_key(&t.terms[i], &key);
+        uint32_t len = key.len;
+        memcpy(buf + used, &len, sizeof(len));
+        memcpy(buf + used + sizeof(len), bson_get_data(&key), len);
+        used += sizeof(len) + len;
+        bson_destroy(&key);
+    }
+    _mongolite_text_terms_free(&t);
+    if (!buf) return false;
+
+    *out_key = buf;
+    *out_len = used;
+    return true;
+}
+
+/* ============================================================
+ * Queries
+ * ============================================================ */
+
+bool _mongolite_text_search(const bson_iter_t *iter, const char **search, uint32_t *len) {
+    bson_iter_t opts;
+    if (!BSON_ITER_HOLDS_DOCUMENT(iter) || !bson_iter_recurse(iter, &opts)) return false;
+
+    const char *s = NULL;
+    uint32_t n = 0;
+    while (bson_iter_next(&opts)) {
+        const char *key = bson_iter_key(&opts);
+        if (strcmp(key, "$search") == 0 && BSON_ITER_HOLDS_UTF8(&opts)) {
+            s = bson_iter_utf8(&opts, &n);
+        } else if (strcmp(key, "$language") == 0 && BSON_ITER_HOLDS_UTF8(&opts)) {
+            /* The index is built in one language */
+            if (strcmp(bson_iter_utf8(&opts, NULL), MONGOLITE_TEXT_LANGUAGE) != 0) return false;
+        } else if (strcmp(key, "$stopWord") == 0 && BSON_ITER_HOLDS_UTF8(&opts)) {
+            if (strcmp(bson_iter_utf8(&opts, NULL), MONGOLITE_TEXT_STOPCHARS) != 0) return false;
+        } else {
+            return false;
+        }
+    }
+    if (!s) return false;
+    *search = s;
+    *len = n;
+    return true;
+}
+
+bson_t* _mongolite_text_strip(const bson_t *filter) {
+    if (!filter || !bson_has_field(filter, "$text")) return NULL;
+
+    bson_t *rest = bson_new();
+    bson_copy_to_excluding_noinit(filter, rest, "$text", NULL);
+    return rest;
+}
+
+bool _mongolite_text_unindexed(const bson_t *filter, gerror_t *error) {
+    if (!filter || !bson_has_field(filter, "$text")) return false;
+    set_error(error, MONGOLITE_LIB, MONGOLITE_EQUERY,
+              "$text query requires a text index (top level, with $search)");
+    return true;
+}
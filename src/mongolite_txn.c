@@ -3,6 +3,7 @@
  *
  * Handles:
  * - Transaction helpers (_get_write_txn, _get_read_txn, etc.)
+ * - Routing into the calling thread's session
  * - Public transaction API (begin, commit, rollback)
  * - Sync operations
  * - Doc count updates (transactional)
@@ -25,8 +26,30 @@ wtree3_txn_t* _mongolite_get_write_txn(mongolite_db_t *db, gerror_t *error) {
         set_error(error, MONGOLITE_LIB, MONGOLITE_EINVAL, "Database is NULL");
         return NULL;
     }
-    if (MONGOLITE_UNLIKELY(db->in_transaction && db->current_txn)) {
-        return db->current_txn;
+    if (MONGOLITE_UNLIKELY(db->open_sessions > 0)) {
+        mongolite_session_t *session = _mongolite_session_current(db);
+        if (session) {
+            if (!session->write) {
+                set_error(error, MONGOLITE_LIB, MONGOLITE_ETXN,
+                         "Cannot write in a snapshot session");
+                return NULL;
+            }
+            /* Group commit: each write nests so it can fail on its own */
+            if (session->group) return _mongolite_session_nested_txn(session, error);
+            return session->txn;
+        }
+        /* LMDB has one writer: wait for the session to end, with the db
+         * lock released, since the session's thread needs it to finish */
+        uint64_t schema = db->schema_generation;
+        if (_mongolite_require_no_write_session(db, error) != MONGOLITE_OK) {
+            return NULL;
+        }
+        /* Trees the caller looked up before the wait may be gone */
+        if (MONGOLITE_UNLIKELY(db->schema_generation != schema)) {
+            set_error(error, MONGOLITE_LIB, MONGOLITE_EBUSY,
+                     "Collections changed while waiting for a write session");
+            return NULL;
+        }
     }
 
     /*
@@ -39,6 +62,8 @@ wtree3_txn_t* _mongolite_get_write_txn(mongolite_db_t *db, gerror_t *error) {
         db->read_txn_pool = NULL;
     }
 
+    if (MONGOLITE_UNLIKELY(_mongolite_require_env(db, error) != MONGOLITE_OK)) return NULL;
+    MONGOLITE_STAT(db, write_txn_begins, 1);
     return wtree3_txn_begin(db->wdb, true, error);
 }
 
@@ -56,15 +81,17 @@ wtree3_txn_t* _mongolite_get_read_txn(mongolite_db_t *db, gerror_t *error) {
         return NULL;
     }
 
-    /* If in explicit transaction, use that */
-    if (MONGOLITE_UNLIKELY(db->in_transaction && db->current_txn)) {
-        return db->current_txn;
+    /* Inside a session: all reads share its snapshot */
+    if (MONGOLITE_UNLIKELY(db->open_sessions > 0)) {
+        wtree3_txn_t *session_txn = _mongolite_session_txn(db);
+        if (session_txn) return session_txn;
     }
 
     /* Try to reuse pooled read transaction */
     if (MONGOLITE_LIKELY(db->read_txn_pool != NULL)) {
         int rc = wtree3_txn_renew(db->read_txn_pool, error);
         if (MONGOLITE_LIKELY(rc == 0)) {
+            MONGOLITE_STAT(db, read_txn_renews, 1);
             return db->read_txn_pool;
         }
         /* Renew failed - abort and create new */
@@ -73,6 +100,8 @@ wtree3_txn_t* _mongolite_get_read_txn(mongolite_db_t *db, gerror_t *error) {
     }
 
     /* Create new read transaction and cache it */
+    if (MONGOLITE_UNLIKELY(_mongolite_require_env(db, error) != MONGOLITE_OK)) return NULL;
+    MONGOLITE_STAT(db, read_txn_begins, 1);
     wtree3_txn_t *txn = wtree3_txn_begin(db->wdb, false, error);
     if (MONGOLITE_LIKELY(txn != NULL)) {
         db->read_txn_pool = txn;
@@ -88,8 +117,8 @@ MONGOLITE_HOT
 void _mongolite_release_read_txn(mongolite_db_t *db, wtree3_txn_t *txn) {
     if (MONGOLITE_UNLIKELY(!db || !txn)) return;
 
-    /* Don't touch explicit transactions */
-    if (MONGOLITE_UNLIKELY(db->in_transaction)) return;
+    /* Don't touch session transactions */
+    if (MONGOLITE_UNLIKELY(txn == _mongolite_session_txn(db))) return;
 
     /* If this is our pooled transaction, just reset it */
     if (MONGOLITE_LIKELY(txn == db->read_txn_pool)) {
@@ -102,22 +131,42 @@ void _mongolite_release_read_txn(mongolite_db_t *db, wtree3_txn_t *txn) {
 
 int _mongolite_commit_if_auto(mongolite_db_t *db, wtree3_txn_t *txn, gerror_t *error) {
     if (MONGOLITE_UNLIKELY(!db || !txn)) return MONGOLITE_EINVAL;
-    /* Only commit if not in explicit transaction */
-    if (MONGOLITE_LIKELY(!db->in_transaction)) {
-        return wtree3_txn_commit(txn, error);
+    /* Session transactions are committed by the session */
+    if (MONGOLITE_LIKELY(txn != _mongolite_session_txn(db))) {
+        uint64_t start = _mongolite_stats_start(db);
+        int rc = wtree3_txn_commit(txn, error);
+        _mongolite_stats_record(db, MONGOLITE_OP_COMMIT, start);
+        if (rc == 0) {
+            _mongolite_durability_committed(db);
+            _mongolite_change_feed_committed(db);
+            _mongolite_map_committed(db);
+            _mongolite_analyze_committed(db);
+        }
+        return rc;
+    }
+    /* ...except a group write's nested txn, which folds into the batch */
+    mongolite_session_t *session = _mongolite_session_current(db);
+    if (session->group && txn == session->nested) {
+        return _mongolite_session_end_nested(session, true, error);
     }
     return MONGOLITE_OK;
 }
 
 void _mongolite_abort_if_auto(mongolite_db_t *db, wtree3_txn_t *txn) {
     if (MONGOLITE_UNLIKELY(!db || !txn)) return;
-    /* Only abort if not in explicit transaction */
-    if (MONGOLITE_LIKELY(!db->in_transaction)) {
+    /* Session transactions are aborted by the session */
+    if (MONGOLITE_LIKELY(txn != _mongolite_session_txn(db))) {
         wtree3_txn_abort(txn);
         /* Clear the pool reference if we just aborted the pooled txn */
         if (txn == db->read_txn_pool) {
             db->read_txn_pool = NULL;
         }
+        return;
+    }
+    /* A failed group write rolls back only its nested txn */
+    mongolite_session_t *session = _mongolite_session_current(db);
+    if (session->group && txn == session->nested) {
+        _mongolite_session_end_nested(session, false, NULL);
     }
 }
 
@@ -127,68 +176,45 @@ void _mongolite_abort_if_auto(mongolite_db_t *db, wtree3_txn_t *txn) {
  * Transaction Support (Public API)
  * ============================================================ */
 
+/* The legacy API drives a write session bound to the calling thread */
+
 int mongolite_begin_transaction(mongolite_db_t *db) {
     if (!db) return MONGOLITE_EINVAL;
 
-    _mongolite_lock(db);
-
-    if (db->in_transaction) {
-        _mongolite_unlock(db);
-        /* Note: No gerror parameter in this function, so can't set error */
-        return MONGOLITE_ERROR;  /* Already in transaction */
-    }
-
+    /* Note: No gerror parameter in this function, so can't return the error */
     gerror_t local_error = {0};
-    db->current_txn = wtree3_txn_begin(db->wdb, true, &local_error);
-    if (!db->current_txn) {
-        _mongolite_unlock(db);
-        /* Note: error was set in local_error but we can't return it (no gerror param) */
-        return MONGOLITE_ERROR;
-    }
-
-    db->in_transaction = true;
-    _mongolite_unlock(db);
-    return MONGOLITE_OK;
+    mongolite_session_t *session = mongolite_session_begin(db, MONGOLITE_SESSION_WRITE,
+                                                           &local_error);
+    return session ? MONGOLITE_OK : MONGOLITE_ERROR;
 }
 
 int mongolite_commit(mongolite_db_t *db) {
     if (!db) return MONGOLITE_EINVAL;
 
     _mongolite_lock(db);
+    mongolite_session_t *session = _mongolite_session_current(db);
+    _mongolite_unlock(db);
 
-    if (!db->in_transaction || !db->current_txn) {
-        _mongolite_unlock(db);
-        /* Note: No gerror parameter in this function, so can't set error */
+    if (!session || !session->write) {
         return MONGOLITE_ERROR;  /* Not in transaction */
     }
 
     gerror_t local_error = {0};
-    int rc = wtree3_txn_commit(db->current_txn, &local_error);
-
-    db->current_txn = NULL;
-    db->in_transaction = false;
-
-    _mongolite_unlock(db);
-    return rc;
+    return mongolite_session_commit(session, &local_error);
 }
 
 int mongolite_rollback(mongolite_db_t *db) {
     if (!db) return MONGOLITE_EINVAL;
 
     _mongolite_lock(db);
+    mongolite_session_t *session = _mongolite_session_current(db);
+    _mongolite_unlock(db);
 
-    if (!db->in_transaction || !db->current_txn) {
-        _mongolite_unlock(db);
-        /* Note: No gerror parameter in this function, so can't set error */
+    if (!session || !session->write) {
         return MONGOLITE_ERROR;  /* Not in transaction */
     }
 
-    wtree3_txn_abort(db->current_txn);
-
-    db->current_txn = NULL;
-    db->in_transaction = false;
-
-    _mongolite_unlock(db);
+    mongolite_session_abort(session);
     return MONGOLITE_OK;
 }
 
@@ -201,5 +227,10 @@ int mongolite_sync(mongolite_db_t *db, bool force, gerror_t *error) {
         set_error(error, MONGOLITE_LIB, MONGOLITE_EINVAL, "Database is NULL");
         return MONGOLITE_EINVAL;
     }
-    return wtree3_db_sync(db->wdb, force, error);
+    /* Forced syncs also advance the durable id */
+    if (force) return _mongolite_durability_sync(db, error);
+    _mongolite_env_lock(db);
+    int rc = wtree3_db_sync(db->wdb, force, error);
+    _mongolite_env_unlock(db);
+    return rc;
 }
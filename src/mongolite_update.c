@@ -42,6 +42,7 @@ typedef struct {
     const bson_t *update;  /* Update operators ($set, $inc, etc.) */
     const bson_t *filter;  /* Query filter for upsert base (may be NULL) */
     gerror_t *error;       /* Error output */
+    bool merged;           /* Set when an existing document was updated */
 } mongolite_merge_ctx_t;
 
 /**
@@ -58,6 +59,7 @@ static void* _mongolite_update_merge(const void *existing_value, size_t existing
     (void)new_len;
 
     mongolite_merge_ctx_t *ctx = (mongolite_merge_ctx_t *)user_data;
+    ctx->merged = true;
 
     /* Parse existing document */
     bson_t existing;
@@ -92,10 +94,9 @@ static void* _mongolite_update_merge(const void *existing_value, size_t existing
  * 4. Use wtree3_upsert_txn with merge callback for atomic update
  * ============================================================ */
 
-MONGOLITE_HOT
-int mongolite_update_one(mongolite_db_t *db, const char *collection,
-                         const bson_t *filter, const bson_t *update,
-                         bool upsert, gerror_t *error) {
+static int _update_one(mongolite_db_t *db, const char *collection,
+                       const bson_t *filter, const bson_t *update,
+                       bool upsert, gerror_t *error) {
     VALIDATE_DB_COLLECTION_UPDATE(db, collection, update, error, -1);
 
     /* Try to get _id from filter for direct lookup */
@@ -111,6 +112,8 @@ int mongolite_update_one(mongolite_db_t *db, const char *collection,
         _mongolite_unlock(db);
         return -1;
     }
+    _mongolite_stats_query(db, _mongolite_collection_stats_lookup(db, collection),
+                           has_id ? MONGOLITE_PLAN_ID : MONGOLITE_PLAN_SCAN);
 
     if (!has_id) {
         /* No _id in filter: need to find document first (under lock) */
@@ -190,6 +193,12 @@ int mongolite_update_one(mongolite_db_t *db, const char *collection,
                                    error);
 
             wtree3_tree_set_merge_fn(tree, NULL, NULL);
+            if (rc == 0 && MONGOLITE_UNLIKELY(db->change_feed != NULL)) {
+                rc = _mongolite_change_log(db, txn,
+                                           merge_ctx.merged ? MONGOLITE_CHANGE_UPDATE
+                                                            : MONGOLITE_CHANGE_INSERT,
+                                           collection, tree, &oid, NULL, error);
+            }
 
             if (final_doc != new_doc) {
                 bson_destroy(final_doc);
@@ -217,6 +226,10 @@ int mongolite_update_one(mongolite_db_t *db, const char *collection,
                                                error);
 
             wtree3_tree_set_merge_fn(tree, NULL, NULL);
+            if (rc == 0 && MONGOLITE_UNLIKELY(db->change_feed != NULL)) {
+                rc = _mongolite_change_log(db, txn, MONGOLITE_CHANGE_UPDATE, collection, tree,
+                                           &oid, NULL, error);
+            }
 
             if (rc == WTREE3_NOT_FOUND) {
                 /* Document doesn't exist - nothing to update */
@@ -265,6 +278,10 @@ int mongolite_update_one(mongolite_db_t *db, const char *collection,
                                     new_oid.bytes, sizeof(new_oid.bytes),
                                     bson_get_data(final_doc), final_doc->len,
                                     error);
+        if (rc == 0 && MONGOLITE_UNLIKELY(db->change_feed != NULL)) {
+            rc = _mongolite_change_log(db, txn, MONGOLITE_CHANGE_INSERT, collection, tree,
+                                       &new_oid, final_doc, error);
+        }
 
         if (final_doc != new_doc) {
             bson_destroy(final_doc);
@@ -289,6 +306,36 @@ int mongolite_update_one(mongolite_db_t *db, const char *collection,
     return 0;
 }
 
+/* Group commit: arguments of a queued update_one / replace_one */
+typedef struct {
+    const char *collection;
+    const bson_t *filter;
+    const bson_t *update;               /* Update spec or replacement */
+    bool upsert;
+} update_one_args_t;
+
+static int _update_one_grouped(mongolite_db_t *db, void *arg, gerror_t *error) {
+    update_one_args_t *args = arg;
+    return _update_one(db, args->collection, args->filter, args->update,
+                       args->upsert, error);
+}
+
+MONGOLITE_HOT
+int mongolite_update_one(mongolite_db_t *db, const char *collection,
+                         const bson_t *filter, const bson_t *update,
+                         bool upsert, gerror_t *error) {
+    uint64_t start = _mongolite_stats_start_query(db, collection, filter);
+    int rc;
+    if (collection && _mongolite_group_enabled(db)) {
+        update_one_args_t args = {collection, filter, update, upsert};
+        rc = _mongolite_group_submit(db, collection, _update_one_grouped, &args, error);
+    } else {
+        rc = _update_one(db, collection, filter, update, upsert, error);
+    }
+    _mongolite_stats_record(db, MONGOLITE_OP_UPDATE, start);
+    return rc;
+}
+
 /* ============================================================
  * Update many documents
  * ============================================================ */
@@ -299,6 +346,7 @@ typedef struct {
     bson_oid_t *keys;      /* Array of matching keys */
     size_t count;          /* Number of collected keys */
     size_t capacity;       /* Allocated capacity */
+    uint64_t scanned;      /* Documents visited (stats) */
 } collect_keys_ctx_t;
 
 /* Scan callback to collect matching document keys */
@@ -306,6 +354,7 @@ static bool _collect_matching_keys_cb(const void *key, size_t key_len,
                                        const void *value, size_t value_len,
                                        void *user_data) {
     collect_keys_ctx_t *ctx = (collect_keys_ctx_t *)user_data;
+    ctx->scanned++;
 
     /* Parse document */
     bson_t doc;
@@ -336,10 +385,9 @@ static bool _collect_matching_keys_cb(const void *key, size_t key_len,
     return true;  /* Continue scanning */
 }
 
-MONGOLITE_HOT
-int mongolite_update_many(mongolite_db_t *db, const char *collection,
-                         const bson_t *filter, const bson_t *update,
-                         bool upsert, int64_t *modified_count, gerror_t *error) {
+static int _update_many(mongolite_db_t *db, const char *collection,
+                       const bson_t *filter, const bson_t *update,
+                       bool upsert, int64_t *modified_count, gerror_t *error) {
     VALIDATE_DB_COLLECTION_UPDATE(db, collection, update, error, -1);
 
     if (modified_count) {
@@ -383,7 +431,8 @@ int mongolite_update_many(mongolite_db_t *db, const char *collection,
         .matcher = matcher,
         .keys = NULL,
         .count = 0,
-        .capacity = 0
+        .capacity = 0,
+        .scanned = 0
     };
 
     int rc = wtree3_scan_range_txn(txn, tree,
@@ -392,6 +441,11 @@ int mongolite_update_many(mongolite_db_t *db, const char *collection,
                                     _collect_matching_keys_cb, &collect_ctx,
                                     error);
 
+    mongolite_op_stats_shard_t *col_stats = _mongolite_collection_stats_lookup(db, collection);
+    _mongolite_stats_query(db, col_stats, MONGOLITE_PLAN_SCAN);
+    _mongolite_stats_docs(db, col_stats, collect_ctx.scanned, collect_ctx.count,
+                          matcher ? collect_ctx.scanned : 0);
+
     if (matcher) {
         mongoc_matcher_destroy(matcher);
     }
@@ -432,6 +486,10 @@ int mongolite_update_many(mongolite_db_t *db, const char *collection,
                                collect_ctx.keys[i].bytes, sizeof(bson_oid_t),
                                bson_get_data(updated_doc), updated_doc->len,
                                error);
+        if (rc == 0 && MONGOLITE_UNLIKELY(db->change_feed != NULL)) {
+            rc = _mongolite_change_log(db, txn, MONGOLITE_CHANGE_UPDATE, collection, tree,
+                                       &collect_ctx.keys[i], updated_doc, error);
+        }
         bson_destroy(updated_doc);
 
         if (rc != 0) {
@@ -499,6 +557,10 @@ int mongolite_update_many(mongolite_db_t *db, const char *collection,
                                     new_oid.bytes, sizeof(new_oid.bytes),
                                     bson_get_data(new_doc), new_doc->len,
                                     error);
+        if (rc == 0 && MONGOLITE_UNLIKELY(db->change_feed != NULL)) {
+            rc = _mongolite_change_log(db, txn, MONGOLITE_CHANGE_INSERT, collection, tree,
+                                       &new_oid, new_doc, error);
+        }
         if (MONGOLITE_UNLIKELY(rc != 0)) {
             bson_destroy(new_doc);
             _mongolite_abort_if_auto(db, txn);
@@ -526,13 +588,23 @@ int mongolite_update_many(mongolite_db_t *db, const char *collection,
     return 0;
 }
 
+MONGOLITE_HOT
+int mongolite_update_many(mongolite_db_t *db, const char *collection,
+                         const bson_t *filter, const bson_t *update,
+                         bool upsert, int64_t *modified_count, gerror_t *error) {
+    uint64_t start = _mongolite_stats_start_query(db, collection, filter);
+    int rc = _update_many(db, collection, filter, update, upsert, modified_count, error);
+    _mongolite_stats_record(db, MONGOLITE_OP_UPDATE, start);
+    return rc;
+}
+
 /* ============================================================
  * Replace one document
  * ============================================================ */
 
-int mongolite_replace_one(mongolite_db_t *db, const char *collection,
-                         const bson_t *filter, const bson_t *replacement,
-                         bool upsert, gerror_t *error) {
+static int _replace_one(mongolite_db_t *db, const char *collection,
+                       const bson_t *filter, const bson_t *replacement,
+                       bool upsert, gerror_t *error) {
     VALIDATE_PARAMS(db && collection && replacement, error, "Database, collection, and replacement are required", -1);
 
     /* Replacement must not contain update operators */
@@ -560,6 +632,9 @@ int mongolite_replace_one(mongolite_db_t *db, const char *collection,
         return -1;
     }
 
+    _mongolite_stats_query(db, _mongolite_collection_stats_lookup(db, collection),
+                           has_id_filter ? MONGOLITE_PLAN_ID : MONGOLITE_PLAN_SCAN);
+
     /* Find the first matching document (under lock) */
     bson_t *existing = NULL;
     if (has_id_filter) {
@@ -655,6 +730,10 @@ int mongolite_replace_one(mongolite_db_t *db, const char *collection,
                                             new_oid.bytes, sizeof(new_oid.bytes),
                                             bson_get_data(new_doc), new_doc->len,
                                             error);
+            if (rc == 0 && MONGOLITE_UNLIKELY(db->change_feed != NULL)) {
+                rc = _mongolite_change_log(db, txn, MONGOLITE_CHANGE_INSERT, collection, tree,
+                                           &new_oid, new_doc, error);
+            }
             bson_destroy(new_doc);
 
             if (MONGOLITE_UNLIKELY(rc != 0)) {
@@ -713,6 +792,10 @@ int mongolite_replace_one(mongolite_db_t *db, const char *collection,
                           doc_id.bytes, sizeof(doc_id.bytes),
                           bson_get_data(new_doc), new_doc->len,
                           error);
+    if (rc == 0 && MONGOLITE_UNLIKELY(db->change_feed != NULL)) {
+        rc = _mongolite_change_log(db, txn, MONGOLITE_CHANGE_REPLACE, collection, tree,
+                                   &doc_id, new_doc, error);
+    }
     if (MONGOLITE_UNLIKELY(rc != 0)) {
         _mongolite_abort_if_auto(db, txn);
         bson_destroy(new_doc);
@@ -733,6 +816,27 @@ int mongolite_replace_one(mongolite_db_t *db, const char *collection,
     return 0;
 }
 
+static int _replace_one_grouped(mongolite_db_t *db, void *arg, gerror_t *error) {
+    update_one_args_t *args = arg;
+    return _replace_one(db, args->collection, args->filter, args->update,
+                        args->upsert, error);
+}
+
+int mongolite_replace_one(mongolite_db_t *db, const char *collection,
+                         const bson_t *filter, const bson_t *replacement,
+                         bool upsert, gerror_t *error) {
+    uint64_t start = _mongolite_stats_start_query(db, collection, filter);
+    int rc;
+    if (collection && _mongolite_group_enabled(db)) {
+        update_one_args_t args = {collection, filter, replacement, upsert};
+        rc = _mongolite_group_submit(db, collection, _replace_one_grouped, &args, error);
+    } else {
+        rc = _replace_one(db, collection, filter, replacement, upsert, error);
+    }
+    _mongolite_stats_record(db, MONGOLITE_OP_UPDATE, start);
+    return rc;
+}
+
 /* ============================================================
  * Find and Modify (Atomic Operations)
  * ============================================================ */
@@ -747,6 +851,7 @@ typedef struct {
     bool return_new;
     bson_t *old_doc;  /* Copy of document before modification */
     gerror_t *error;
+    bool existed;     /* The document was there before */
 } find_modify_ctx_t;
 
 /**
@@ -759,6 +864,7 @@ static void* _find_and_modify_cb(const void *existing_value, size_t existing_len
 
     if (existing_value) {
         /* Document exists - apply update */
+        ctx->existed = true;
         bson_t existing;
         bson_init_static(&existing, existing_value, existing_len);
 
@@ -819,9 +925,9 @@ static void* _find_and_modify_cb(const void *existing_value, size_t existing_len
     return NULL;
 }
 
-bson_t* mongolite_find_and_modify(mongolite_db_t *db, const char *collection,
-                                  const bson_t *filter, const bson_t *update,
-                                  bool return_new, bool upsert, gerror_t *error) {
+static bson_t* _find_and_modify(mongolite_db_t *db, const char *collection,
+                                const bson_t *filter, const bson_t *update,
+                                bool return_new, bool upsert, gerror_t *error) {
     VALIDATE_DB_COLLECTION_UPDATE(db, collection, update, error, NULL);
 
     /* Check for direct _id lookup */
@@ -837,6 +943,8 @@ bson_t* mongolite_find_and_modify(mongolite_db_t *db, const char *collection,
         _mongolite_unlock(db);
         return NULL;
     }
+    _mongolite_stats_query(db, _mongolite_collection_stats_lookup(db, collection),
+                           has_id ? MONGOLITE_PLAN_ID : MONGOLITE_PLAN_SCAN);
 
     if (!has_id && !upsert) {
         /* Need to find document first to get _id (under lock) */
@@ -879,6 +987,12 @@ bson_t* mongolite_find_and_modify(mongolite_db_t *db, const char *collection,
                                     oid.bytes, sizeof(oid.bytes),
                                     _find_and_modify_cb, &ctx,
                                     error);
+        if (rc == 0 && MONGOLITE_UNLIKELY(db->change_feed != NULL)) {
+            rc = _mongolite_change_log(db, txn,
+                                       ctx.existed ? MONGOLITE_CHANGE_UPDATE
+                                                   : MONGOLITE_CHANGE_INSERT,
+                                       collection, tree, &oid, NULL, error);
+        }
 
         if (rc != 0) {
             _mongolite_abort_if_auto(db, txn);
@@ -920,6 +1034,10 @@ bson_t* mongolite_find_and_modify(mongolite_db_t *db, const char *collection,
                                         new_oid.bytes, sizeof(new_oid.bytes),
                                         bson_get_data(final_doc), final_doc->len,
                                         error);
+        if (rc == 0 && MONGOLITE_UNLIKELY(db->change_feed != NULL)) {
+            rc = _mongolite_change_log(db, txn, MONGOLITE_CHANGE_INSERT, collection, tree,
+                                       &new_oid, final_doc, error);
+        }
 
         if (MONGOLITE_UNLIKELY(rc != 0)) {
             if (final_doc != new_doc) bson_destroy(final_doc);
@@ -950,6 +1068,15 @@ bson_t* mongolite_find_and_modify(mongolite_db_t *db, const char *collection,
     return result;
 }
 
+bson_t* mongolite_find_and_modify(mongolite_db_t *db, const char *collection,
+                                  const bson_t *filter, const bson_t *update,
+                                  bool return_new, bool upsert, gerror_t *error) {
+    uint64_t start = _mongolite_stats_start_query(db, collection, filter);
+    bson_t *result = _find_and_modify(db, collection, filter, update, return_new, upsert, error);
+    _mongolite_stats_record(db, MONGOLITE_OP_UPDATE, start);
+    return result;
+}
+
 bson_t* mongolite_find_and_modify_json(mongolite_db_t *db, const char *collection,
                                        const char *filter_json, const char *update_json,
                                        bool return_new, bool upsert, gerror_t *error) {
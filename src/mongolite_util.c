@@ -19,6 +19,7 @@
 #else
 #include <pthread.h>
 #include <sys/time.h>
+#include <time.h>
 #endif
 
 #define MONGOLITE_LIB "mongolite"
@@ -182,16 +183,36 @@ int _mongolite_lock_init(mongolite_db_t *db) {
 #ifdef _WIN32
     CRITICAL_SECTION *cs = malloc(sizeof(CRITICAL_SECTION));
     if (!cs) return MONGOLITE_ENOMEM;
+    CONDITION_VARIABLE *cond = malloc(sizeof(CONDITION_VARIABLE));
+    if (!cond) {
+        free(cs);
+        return MONGOLITE_ENOMEM;
+    }
     InitializeCriticalSection(cs);
+    InitializeConditionVariable(cond);
     db->mutex = cs;
+    db->writer_cond = cond;
 #else
     pthread_mutex_t *mtx = malloc(sizeof(pthread_mutex_t));
-    if (!mtx) return MONGOLITE_ENOMEM;
+    pthread_cond_t *cond = malloc(sizeof(pthread_cond_t));
+    if (!mtx || !cond) {
+        free(mtx);
+        free(cond);
+        return MONGOLITE_ENOMEM;
+    }
     if (pthread_mutex_init(mtx, NULL) != 0) {
         free(mtx);
+        free(cond);
+        return MONGOLITE_ERROR;
+    }
+    if (pthread_cond_init(cond, NULL) != 0) {
+        pthread_mutex_destroy(mtx);
+        free(mtx);
+        free(cond);
         return MONGOLITE_ERROR;
     }
     db->mutex = mtx;
+    db->writer_cond = cond;
 #endif
 
     return MONGOLITE_OK;
@@ -204,23 +225,56 @@ void _mongolite_lock_free(mongolite_db_t *db) {
     DeleteCriticalSection((CRITICAL_SECTION*)db->mutex);
     free(db->mutex);
 #else
+    pthread_cond_destroy(db->writer_cond);
     pthread_mutex_destroy(db->mutex);
     free(db->mutex);
 #endif
+    free(db->writer_cond);
     db->mutex = NULL;
+    db->writer_cond = NULL;
 }
 
+/* Database whose lock the calling thread holds across calls */
+static MONGOLITE_THREAD_LOCAL mongolite_db_t *_tls_lock_held = NULL;
+
 void _mongolite_lock(mongolite_db_t *db) {
     if (!db || !db->mutex) return;
+    if (MONGOLITE_UNLIKELY(_tls_lock_held == db)) return;
+
+    /* Uncontended: no clock reads. Contended: time the wait. */
 #ifdef _WIN32
+    if (MONGOLITE_LIKELY(TryEnterCriticalSection((CRITICAL_SECTION*)db->mutex))) {
+        MONGOLITE_STAT(db, lock_acquires, 1);
+        return;
+    }
+    bool timed = db->stats_shards || db->slowlog;
+    uint64_t start = timed ? _mongolite_now_ns() : 0;
     EnterCriticalSection((CRITICAL_SECTION*)db->mutex);
 #else
+    if (MONGOLITE_LIKELY(pthread_mutex_trylock(db->mutex) == 0)) {
+        MONGOLITE_STAT(db, lock_acquires, 1);
+        return;
+    }
+    bool timed = db->stats_shards || db->slowlog;
+    uint64_t start = timed ? _mongolite_now_ns() : 0;
     pthread_mutex_lock(db->mutex);
 #endif
+    if (!timed) return;
+
+    uint64_t wait = _mongolite_now_ns() - start;
+    MONGOLITE_TRACE(db, lock_wait_ns, wait);
+
+    mongolite_stats_t *shard = _mongolite_stats_shard(db);
+    if (shard) {
+        MONGOLITE_ATOMIC_ADD(&shard->lock_acquires, (uint64_t)1);
+        MONGOLITE_ATOMIC_ADD(&shard->lock_contended, (uint64_t)1);
+        MONGOLITE_ATOMIC_ADD(&shard->lock_wait_ns, wait);
+    }
 }
 
 void _mongolite_unlock(mongolite_db_t *db) {
     if (!db || !db->mutex) return;
+    if (MONGOLITE_UNLIKELY(_tls_lock_held == db)) return;
 #ifdef _WIN32
     LeaveCriticalSection((CRITICAL_SECTION*)db->mutex);
 #else
@@ -228,6 +282,45 @@ void _mongolite_unlock(mongolite_db_t *db) {
 #endif
 }
 
+void _mongolite_writer_wait(mongolite_db_t *db, int ms) {
+    if (!db || !db->mutex) return;
+#ifdef _WIN32
+    SleepConditionVariableCS((CONDITION_VARIABLE*)db->writer_cond, (CRITICAL_SECTION*)db->mutex,
+                             ms < 0 ? INFINITE : (DWORD)ms);
+#else
+    if (ms < 0) {
+        pthread_cond_wait(db->writer_cond, db->mutex);
+        return;
+    }
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_nsec += (long)(ms % 1000) * 1000000L;
+    deadline.tv_sec += ms / 1000 + deadline.tv_nsec / 1000000000L;
+    deadline.tv_nsec %= 1000000000L;
+    pthread_cond_timedwait(db->writer_cond, db->mutex, &deadline);
+#endif
+}
+
+void _mongolite_writer_wake(mongolite_db_t *db) {
+    if (!db || !db->writer_cond) return;
+#ifdef _WIN32
+    WakeAllConditionVariable((CONDITION_VARIABLE*)db->writer_cond);
+#else
+    pthread_cond_broadcast(db->writer_cond);
+#endif
+}
+
+void _mongolite_lock_hold(mongolite_db_t *db) {
+    _mongolite_lock(db);
+    _tls_lock_held = db;
+}
+
+void _mongolite_lock_drop(mongolite_db_t *db) {
+    if (_tls_lock_held != db) return;
+    _tls_lock_held = NULL;
+    _mongolite_unlock(db);
+}
+
 /* ============================================================
  * Tree Name Builders
  * ============================================================ */
@@ -260,18 +353,76 @@ char* _mongolite_index_tree_name(const char *collection_name, const char *index_
 
 /* ============================================================
  * Tree Cache Operations
+ *
+ * Open-addressed hash table with linear probing. Slots hold pointers to
+ * heap-allocated entries; removal uses backward-shift deletion so no
+ * tombstones are needed. Load factor is kept at or below 1/2.
  * ============================================================ */
 
+#define MONGOLITE_TREE_CACHE_MIN_CAPACITY 16
+
+uint64_t _mongolite_name_hash(const char *name) {
+    /* FNV-1a, 64-bit */
+    uint64_t h = 14695981039346656037ULL;
+    for (const unsigned char *p = (const unsigned char*)name; *p; p++) {
+        h ^= *p;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+MONGOLITE_HOT
+mongolite_tree_cache_entry_t* _mongolite_tree_cache_lookup(mongolite_db_t *db,
+                                                           const char *name,
+                                                           uint64_t hash) {
+    if (!db || !name || db->tree_cache_capacity == 0) return NULL;
+
+    size_t mask = db->tree_cache_capacity - 1;
+    size_t i = (size_t)hash & mask;
+    mongolite_tree_cache_entry_t *entry;
+    while ((entry = db->tree_cache[i]) != NULL) {
+        if (entry->hash == hash && strcmp(entry->name, name) == 0) {
+            return entry;
+        }
+        i = (i + 1) & mask;
+    }
+    return NULL;
+}
+
 wtree3_tree_t* _mongolite_tree_cache_get(mongolite_db_t *db, const char *name) {
     if (!db || !name) return NULL;
-    mongolite_tree_cache_entry_t *entry = db->tree_cache;
-    while (entry) {
-        if (strcmp(entry->name, name) == 0) {
-            return entry->tree;
+    mongolite_tree_cache_entry_t *entry =
+        _mongolite_tree_cache_lookup(db, name, _mongolite_name_hash(name));
+    return entry ? entry->tree : NULL;
+}
+
+/* Place an entry in the first free slot of its probe sequence */
+static void _tree_cache_insert_slot(mongolite_tree_cache_entry_t **slots, size_t capacity,
+                                    mongolite_tree_cache_entry_t *entry) {
+    size_t mask = capacity - 1;
+    size_t i = (size_t)entry->hash & mask;
+    while (slots[i]) {
+        i = (i + 1) & mask;
+    }
+    slots[i] = entry;
+}
+
+static int _tree_cache_grow(mongolite_db_t *db) {
+    size_t new_capacity = db->tree_cache_capacity ?
+                          db->tree_cache_capacity * 2 : MONGOLITE_TREE_CACHE_MIN_CAPACITY;
+    mongolite_tree_cache_entry_t **slots = calloc(new_capacity, sizeof(*slots));
+    if (!slots) return MONGOLITE_ENOMEM;
+
+    for (size_t i = 0; i < db->tree_cache_capacity; i++) {
+        if (db->tree_cache[i]) {
+            _tree_cache_insert_slot(slots, new_capacity, db->tree_cache[i]);
         }
-        entry = entry->next;
     }
-    return NULL;
+
+    free(db->tree_cache);
+    db->tree_cache = slots;
+    db->tree_cache_capacity = new_capacity;
+    return MONGOLITE_OK;
 }
 
 int _mongolite_tree_cache_put(mongolite_db_t *db, const char *name,
@@ -279,14 +430,29 @@ int _mongolite_tree_cache_put(mongolite_db_t *db, const char *name,
                               wtree3_tree_t *tree) {
     if (!db || !name || !tree_name || !tree) return MONGOLITE_EINVAL;
 
+    uint64_t hash = _mongolite_name_hash(name);
+
     /* Check if already exists */
-    if (_mongolite_tree_cache_get(db, name)) {
+    if (_mongolite_tree_cache_lookup(db, name, hash)) {
         return MONGOLITE_EEXISTS;
     }
 
+    /* Keep load factor <= 1/2 */
+    if ((db->tree_cache_count + 1) * 2 > db->tree_cache_capacity) {
+        int rc = _tree_cache_grow(db);
+        if (rc != MONGOLITE_OK) return rc;
+    }
+
     mongolite_tree_cache_entry_t *entry = calloc(1, sizeof(mongolite_tree_cache_entry_t));
     if (!entry) return MONGOLITE_ENOMEM;
+    int rc = MONGOLITE_OK;
+    entry->stats = _mongolite_collection_stats_alloc(db, &rc);
+    if (rc != MONGOLITE_OK) {
+        free(entry);
+        return rc;
+    }
 
+    entry->hash = hash;
     entry->name = strdup(name);
     entry->tree_name = strdup(tree_name);
     entry->tree = tree;
@@ -295,10 +461,9 @@ int _mongolite_tree_cache_put(mongolite_db_t *db, const char *name,
         memcpy(&entry->oid, oid, sizeof(bson_oid_t));
     }
 
-    /* Add to front of list */
-    entry->next = db->tree_cache;
-    db->tree_cache = entry;
+    _tree_cache_insert_slot(db->tree_cache, db->tree_cache_capacity, entry);
     db->tree_cache_count++;
+    db->schema_generation++;
 
     return MONGOLITE_OK;
 }
@@ -309,43 +474,72 @@ static void _free_cached_indexes(mongolite_cached_index_t *indexes, size_t count
     for (size_t i = 0; i < count; i++) {
         free(indexes[i].name);
         if (indexes[i].keys) bson_destroy(indexes[i].keys);
+        _mongolite_hist_free(indexes[i].hist);
         /* Note: Index trees are now managed by wtree3 internally */
     }
     free(indexes);
 }
 
+static void _free_cache_entry(mongolite_tree_cache_entry_t *entry) {
+    wtree3_tree_close(entry->tree);
+    free(entry->name);
+    free(entry->tree_name);
+    _free_cached_indexes(entry->indexes, entry->index_count);
+    _mongolite_plan_cache_clear(entry);
+    free(entry->stats);
+    free(entry);
+}
+
 void _mongolite_tree_cache_remove(mongolite_db_t *db, const char *name) {
-    if (!db || !name) return;
-
-    mongolite_tree_cache_entry_t **pp = &db->tree_cache;
-    while (*pp) {
-        if (strcmp((*pp)->name, name) == 0) {
-            mongolite_tree_cache_entry_t *to_remove = *pp;
-            *pp = to_remove->next;
-            wtree3_tree_close(to_remove->tree);
-            free(to_remove->name);
-            free(to_remove->tree_name);
-            _free_cached_indexes(to_remove->indexes, to_remove->index_count);
-            free(to_remove);
-            db->tree_cache_count--;
-            return;
+    if (!db || !name || db->tree_cache_capacity == 0) return;
+
+    uint64_t hash = _mongolite_name_hash(name);
+    size_t mask = db->tree_cache_capacity - 1;
+    size_t i = (size_t)hash & mask;
+    mongolite_tree_cache_entry_t *entry;
+    while ((entry = db->tree_cache[i]) != NULL) {
+        if (entry->hash == hash && strcmp(entry->name, name) == 0) {
+            break;
+        }
+        i = (i + 1) & mask;
+    }
+    if (!entry) return;
+
+    db->tree_cache[i] = NULL;
+
+    /* Backward-shift the rest of the cluster so probes stay unbroken */
+    size_t j = (i + 1) & mask;
+    while (db->tree_cache[j]) {
+        mongolite_tree_cache_entry_t *moved = db->tree_cache[j];
+        size_t home = (size_t)moved->hash & mask;
+        /* Move if the hole lies cyclically between home and j */
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            db->tree_cache[i] = moved;
+            db->tree_cache[j] = NULL;
+            i = j;
         }
-        pp = &(*pp)->next;
+        j = (j + 1) & mask;
     }
+
+    _free_cache_entry(entry);
+    db->tree_cache_count--;
+    db->tree_cache_generation++;
+    db->schema_generation++;
 }
 
 void _mongolite_tree_cache_clear(mongolite_db_t *db) {
     if (!db) return;
-    while (db->tree_cache) {
-        mongolite_tree_cache_entry_t *next = db->tree_cache->next;
-        wtree3_tree_close(db->tree_cache->tree);
-        free(db->tree_cache->name);
-        free(db->tree_cache->tree_name);
-        _free_cached_indexes(db->tree_cache->indexes, db->tree_cache->index_count);
-        free(db->tree_cache);
-        db->tree_cache = next;
+    for (size_t i = 0; i < db->tree_cache_capacity; i++) {
+        if (db->tree_cache[i]) {
+            _free_cache_entry(db->tree_cache[i]);
+        }
     }
+    free(db->tree_cache);
+    db->tree_cache = NULL;
+    db->tree_cache_capacity = 0;
     db->tree_cache_count = 0;
+    db->tree_cache_generation++;
+    db->schema_generation++;
 }
 
 /*
@@ -372,14 +566,7 @@ int64_t mongolite_get_collection_doc_count(mongolite_db_t *db, const char *name)
 
 /* Helper to find cache entry by name */
 static mongolite_tree_cache_entry_t* _find_cache_entry(mongolite_db_t *db, const char *name) {
-    mongolite_tree_cache_entry_t *entry = db->tree_cache;
-    while (entry) {
-        if (strcmp(entry->name, name) == 0) {
-            return entry;
-        }
-        entry = entry->next;
-    }
-    return NULL;
+    return _mongolite_tree_cache_lookup(db, name, _mongolite_name_hash(name));
 }
 
 /*
@@ -398,19 +585,29 @@ mongolite_cached_index_t* _mongolite_get_cached_indexes(mongolite_db_t *db,
         return NULL;
     }
 
-    mongolite_tree_cache_entry_t *entry = _find_cache_entry(db, collection);
+    /* Opens the collection if it is not cached yet */
+    mongolite_tree_cache_entry_t *entry = _mongolite_get_collection_entry(db, collection, error);
     if (!entry) {
-        /* Collection not in cache - need to open it first */
-        wtree3_tree_t *tree = _mongolite_get_collection_tree(db, collection, error);
-        if (!tree) {
-            *out_count = 0;
-            return NULL;
-        }
-        entry = _find_cache_entry(db, collection);
-        if (!entry) {
-            *out_count = 0;
-            return NULL;
-        }
+        *out_count = 0;
+        return NULL;
+    }
+
+    return _mongolite_entry_indexes(db, entry, out_count, error);
+}
+
+/*
+ * Get cached index specs for an already-resolved cache entry.
+ * Same contract as _mongolite_get_cached_indexes().
+ */
+MONGOLITE_HOT
+mongolite_cached_index_t* _mongolite_entry_indexes(mongolite_db_t *db,
+                                                    mongolite_tree_cache_entry_t *entry,
+                                                    size_t *out_count,
+                                                    gerror_t *error) {
+    (void)db;
+    if (!entry || !out_count) {
+        if (out_count) *out_count = 0;
+        return NULL;
     }
 
     /* If indexes already loaded, return them */
@@ -462,6 +659,11 @@ mongolite_cached_index_t* _mongolite_get_cached_indexes(mongolite_db_t *db,
             bson_t bson_keys;
             if (bson_init_static(&bson_keys, wtree_indexes[i].user_data, wtree_indexes[i].user_data_len)) {
                 cached[i].keys = bson_copy(&bson_keys);
+                cached[i].text = _mongolite_text_spec(cached[i].keys);
+                cached[i].geo = _mongolite_geo_spec(cached[i].keys) != NULL;
+                cached[i].multikey = wtree_indexes[i].multikey &&
+                                     !cached[i].text && !cached[i].geo;
+                cached[i].legacy = !wtree_indexes[i].multikey;
             } else {
                 cached[i].keys = NULL;
             }
@@ -470,6 +672,13 @@ mongolite_cached_index_t* _mongolite_get_cached_indexes(mongolite_db_t *db,
         }
 
         free(wtree_indexes[i].user_data);  /* Free user_data, we copied it */
+
+        /* Planner statistics persisted with the index, if analyzed */
+        const void *stats;
+        size_t stats_len;
+        if (wtree3_tree_get_index_stats(entry->tree, cached[i].name, &stats, &stats_len) == 0) {
+            cached[i].hist = _mongolite_hist_parse(stats, stats_len);
+        }
     }
     free(wtree_indexes);
 
@@ -495,6 +704,11 @@ void _mongolite_invalidate_index_cache(mongolite_db_t *db, const char *collectio
     entry->indexes = NULL;
     entry->index_count = 0;
     entry->indexes_loaded = false;
+    entry->index_epoch++;
+    db->schema_generation++;
+
+    /* Cached plans may reference the freed specs */
+    _mongolite_plan_cache_clear(entry);
 }
 
 /* ============================================================
@@ -171,6 +171,7 @@
  * - wtree3_db_madvise(): Hint access patterns (random, sequential, willneed)
  * - wtree3_db_mlock(): Lock pages in RAM (prevent swapping)
  * - wtree3_db_prefetch(): Async prefetch for specific ranges
+ * - wtree3_db_prefetch_addr(): Same, for pages holding a read result
  *
  * @section error_sec Error Handling
  *
@@ -377,6 +378,11 @@ typedef struct wtree3_iterator_t wtree3_iterator_t;
  * For sparse indexes, return `false` when the indexed field is missing or null.
  * The entry will be skipped in the index, saving space.
  *
+ * **Multi-key Indexes:**
+ * For indexes created with `multikey`, `out_key` holds any number of distinct
+ * keys packed back to back, each as a native `uint32_t` length followed by
+ * the key bytes. Every key maps to the entry's main key.
+ *
  * **Memory Management:**
  * - The callback MUST allocate `out_key` using malloc()
  * - WTree3 will free the key after using it
@@ -688,6 +694,9 @@ typedef struct wtree3_index_config {
     /** Sparse index - true: skip entries where extractor returns false */
     bool sparse;
 
+    /** Multi-key index - true: the extractor emits a packed list of keys */
+    bool multikey;
+
     /** Custom key comparator function (NULL for lexicographic) */
     MDB_cmp_func *compare;
 
@@ -754,6 +763,10 @@ void wtree3_db_close(wtree3_db_t *db);
 /* Sync database to disk */
 int wtree3_db_sync(wtree3_db_t *db, bool force, gerror_t *error);
 
+/* Bytes put into or deleted from trees since open (index entries not
+ * counted; writes of aborted transactions included) */
+uint64_t wtree3_db_bytes_written(wtree3_db_t *db);
+
 /* Resize the database map */
 int wtree3_db_resize(wtree3_db_t *db, size_t new_mapsize, gerror_t *error);
 
@@ -793,6 +806,15 @@ int wtree3_db_register_key_extractor(
     gerror_t *error
 );
 
+/*
+ * Set the key comparator of persisted indexes
+ *
+ * LMDB does not store comparators: indexes reloaded by wtree3_tree_open
+ * get this one (indexes added with wtree3_tree_add_index use their
+ * config's). Set it before opening trees. NULL: LMDB's default.
+ */
+void wtree3_db_set_index_compare(wtree3_db_t *db, MDB_cmp_func *cmp);
+
 /* ============================================================
  * Memory Optimization API
  * ============================================================ */
@@ -925,6 +947,29 @@ int wtree3_db_prefetch(wtree3_db_t *db,
                        size_t length,
                        gerror_t *error);
 
+/*
+ * Prefetch the pages holding [addr, addr + length)
+ *
+ * For pointers returned by reads: keys and values point into the map.
+ * mdb_env_info() only reports the map address for MDB_FIXEDMAP
+ * environments, so wtree3_db_prefetch() cannot locate the map otherwise;
+ * this variant works from an address inside it.
+ *
+ * @param db Database handle
+ * @param addr Address inside the map (rounded down to a page boundary)
+ * @param length Number of bytes to prefetch
+ * @param error Error output
+ * @return WTREE3_OK on success, error code otherwise
+ *
+ * Notes:
+ * - A range running past the end of the map is prefetched up to the end
+ * - Same platform support as wtree3_db_prefetch()
+ */
+int wtree3_db_prefetch_addr(wtree3_db_t *db,
+                            const void *addr,
+                            size_t length,
+                            gerror_t *error);
+
 /* ============================================================
  * Transaction Operations
  * ============================================================ */
@@ -941,6 +986,17 @@ int wtree3_db_prefetch(wtree3_db_t *db,
  */
 wtree3_txn_t* wtree3_txn_begin(wtree3_db_t *db, bool write, gerror_t *error);
 
+/*
+ * Begin a child of a write transaction
+ *
+ * Committing the child folds its changes into the parent (no sync);
+ * aborting it discards only the child's changes. The parent may not be
+ * used while the child is open.
+ *
+ * Returns: Transaction handle or NULL on error
+ */
+wtree3_txn_t* wtree3_txn_begin_nested(wtree3_txn_t *parent, gerror_t *error);
+
 /* Commit transaction */
 int wtree3_txn_commit(wtree3_txn_t *txn, gerror_t *error);
 
@@ -1005,6 +1061,9 @@ int64_t wtree3_tree_count(wtree3_tree_t *tree);
 /* Get parent database from tree */
 wtree3_db_t* wtree3_tree_get_db(wtree3_tree_t *tree);
 
+/* Get the tree's LMDB DBI handle */
+MDB_dbi wtree3_tree_get_dbi(wtree3_tree_t *tree);
+
 /* Set custom key comparison function */
 int wtree3_tree_set_compare(wtree3_tree_t *tree, MDB_cmp_func *cmp, gerror_t *error);
 
@@ -1067,6 +1126,7 @@ typedef struct wtree3_index_info {
     size_t user_data_len;
     bool unique;
     bool sparse;
+    bool multikey;
     MDB_dbi dbi;
 } wtree3_index_info_t;
 
@@ -1134,6 +1194,30 @@ int wtree3_index_get_extractor_id(
     gerror_t *error
 );
 
+/*
+ * Planner statistics for an index
+ *
+ * An opaque blob owned by the caller's format, persisted with the
+ * index metadata and removed with the index. The getter returns the
+ * loaded copy (valid until the next set or drop); WTREE3_NOT_FOUND if
+ * none was stored. The setter writes in txn and replaces the loaded copy.
+ */
+int wtree3_tree_get_index_stats(
+    wtree3_tree_t *tree,
+    const char *index_name,
+    const void **out_data,
+    size_t *out_len
+);
+
+int wtree3_tree_set_index_stats_txn(
+    wtree3_txn_t *txn,
+    wtree3_tree_t *tree,
+    const char *index_name,
+    const void *data,
+    size_t len,
+    gerror_t *error
+);
+
 /* ============================================================
  * Data Operations (With Transaction)
  *
@@ -1452,6 +1536,10 @@ int wtree3_modify_txn(
  * Note: If a key doesn't exist, corresponding value pointer is set to NULL
  *       and value_len to 0. This is NOT an error.
  *
+ * Keys may come in any order: they are looked up sorted, walking one
+ * cursor forward, so keys sharing B-tree pages are found without a
+ * descent from the root. Results stay aligned with the input.
+ *
  * Returns: 0 on success, error code on failure
  */
 int wtree3_get_many_txn(
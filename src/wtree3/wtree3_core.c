@@ -89,7 +89,7 @@ wtree3_db_t* wtree3_db_open(const char *path, size_t mapsize,
     if (WTREE_UNLIKELY(rc != 0)) {
         set_error(error, WTREE3_LIB, WTREE3_ERROR,
                  "Failed to create environment: %s", mdb_strerror(rc));
-        free(db);
+        wtree3_db_close(db);
         return NULL;
     }
 
@@ -101,8 +101,7 @@ wtree3_db_t* wtree3_db_open(const char *path, size_t mapsize,
     if (WTREE_UNLIKELY(rc != 0)) {
         set_error(error, WTREE3_LIB, WTREE3_ERROR,
                  "Failed to set mapsize: %s", mdb_strerror(rc));
-        mdb_env_close(db->env);
-        free(db);
+        wtree3_db_close(db);
         return NULL;
     }
 
@@ -110,8 +109,7 @@ wtree3_db_t* wtree3_db_open(const char *path, size_t mapsize,
     if (WTREE_UNLIKELY(rc != 0)) {
         set_error(error, WTREE3_LIB, WTREE3_ERROR,
                  "Failed to set max databases: %s", mdb_strerror(rc));
-        mdb_env_close(db->env);
-        free(db);
+        wtree3_db_close(db);
         return NULL;
     }
 
@@ -119,8 +117,7 @@ wtree3_db_t* wtree3_db_open(const char *path, size_t mapsize,
     if (WTREE_UNLIKELY(rc != 0)) {
         set_error(error, WTREE3_LIB, WTREE3_ERROR,
                  "Failed to open environment: %s", mdb_strerror(rc));
-        mdb_env_close(db->env);
-        free(db);
+        wtree3_db_close(db);
         return NULL;
     }
 
@@ -154,6 +151,10 @@ int wtree3_db_sync(wtree3_db_t *db, bool force, gerror_t *error) {
     return WTREE3_OK;
 }
 
+uint64_t wtree3_db_bytes_written(wtree3_db_t *db) {
+    return db ? WTREE_ATOMIC_LOAD(&db->bytes_written) : 0;
+}
+
 WTREE_COLD WTREE_WARN_UNUSED
 int wtree3_db_resize(wtree3_db_t *db, size_t new_mapsize, gerror_t *error) {
     if (WTREE_UNLIKELY(!db)) {
@@ -217,6 +218,30 @@ wtree3_txn_t* wtree3_txn_begin(wtree3_db_t *db, bool write, gerror_t *error) {
     return txn;
 }
 
+wtree3_txn_t* wtree3_txn_begin_nested(wtree3_txn_t *parent, gerror_t *error) {
+    if (WTREE_UNLIKELY(!parent || !parent->is_write)) {
+        set_error(error, WTREE3_LIB, WTREE3_EINVAL, "Parent must be a write transaction");
+        return NULL;
+    }
+
+    wtree3_txn_t *txn = calloc(1, sizeof(wtree3_txn_t));
+    if (WTREE_UNLIKELY(!txn)) {
+        set_error(error, WTREE3_LIB, WTREE3_ENOMEM, "Failed to allocate transaction");
+        return NULL;
+    }
+
+    int rc = mdb_txn_begin(parent->db->env, parent->txn, 0, &txn->txn);
+    if (WTREE_UNLIKELY(rc != 0)) {
+        translate_mdb_error(rc, error);
+        free(txn);
+        return NULL;
+    }
+
+    txn->db = parent->db;
+    txn->is_write = true;
+    return txn;
+}
+
 WTREE_WARN_UNUSED
 int wtree3_txn_commit(wtree3_txn_t *txn, gerror_t *error) {
     if (WTREE_UNLIKELY(!txn)) {
@@ -390,6 +415,10 @@ int wtree3_db_register_key_extractor(wtree3_db_t *db, uint32_t version,
     return WTREE3_OK;
 }
 
+void wtree3_db_set_index_compare(wtree3_db_t *db, MDB_cmp_func *cmp) {
+    if (db) db->index_compare = cmp;
+}
+
 WTREE_PURE
 wtree3_index_key_fn find_extractor(wtree3_db_t *db, uint64_t extractor_id) {
     if (!db) return NULL;
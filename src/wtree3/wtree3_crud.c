@@ -15,6 +15,37 @@
  * Index Maintenance Helpers
  * ============================================================ */
 
+WTREE_HOT
+int index_put_keys(wtree3_index_t *idx, MDB_txn *txn,
+                   const void *idx_key, size_t idx_key_len,
+                   const void *key, size_t key_len,
+                   gerror_t *error) {
+    size_t pos = 0;
+    MDB_val mk;
+    while (index_key_next(idx, idx_key, idx_key_len, &pos, &mk)) {
+        /* Check unique constraint */
+        if (WTREE_UNLIKELY(idx->unique)) {
+            MDB_val check_key = mk;
+            MDB_val check_val;
+            int get_rc = mdb_get(txn, idx->dbi, &check_key, &check_val);
+            if (WTREE_UNLIKELY(get_rc == 0)) {
+                set_error(error, WTREE3_LIB, WTREE3_INDEX_ERROR,
+                         "Duplicate key for unique index '%s'", idx->name);
+                return WTREE3_INDEX_ERROR;
+            }
+        }
+
+        /* Insert: index_key -> main_key */
+        MDB_val mv = {.mv_size = key_len, .mv_data = (void*)key};
+        int rc = mdb_put(txn, idx->dbi, &mk, &mv, MDB_NODUPDATA);
+        if (WTREE_UNLIKELY(rc != 0 && rc != MDB_KEYEXIST)) {
+            return translate_mdb_error(rc, error);
+        }
+    }
+
+    return WTREE3_OK;
+}
+
 WTREE_HOT
 int indexes_insert(wtree3_tree_t *tree, MDB_txn *txn,
                           const void *key, size_t key_len,
@@ -36,28 +67,9 @@ int indexes_insert(wtree3_tree_t *tree, MDB_txn *txn,
             return WTREE3_ERROR;
         }
 
-        /* Check unique constraint */
-        if (WTREE_UNLIKELY(idx->unique)) {
-            MDB_val check_key = {.mv_size = idx_key_len, .mv_data = idx_key};
-            MDB_val check_val;
-            int get_rc = mdb_get(txn, idx->dbi, &check_key, &check_val);
-            if (WTREE_UNLIKELY(get_rc == 0)) {
-                free(idx_key);
-                set_error(error, WTREE3_LIB, WTREE3_INDEX_ERROR,
-                         "Duplicate key for unique index '%s'", idx->name);
-                return WTREE3_INDEX_ERROR;
-            }
-        }
-
-        /* Insert: index_key -> main_key */
-        MDB_val mk = {.mv_size = idx_key_len, .mv_data = idx_key};
-        MDB_val mv = {.mv_size = key_len, .mv_data = (void*)key};
-        int rc = mdb_put(txn, idx->dbi, &mk, &mv, MDB_NODUPDATA);
+        int rc = index_put_keys(idx, txn, idx_key, idx_key_len, key, key_len, error);
         free(idx_key);
-
-        if (WTREE_UNLIKELY(rc != 0 && rc != MDB_KEYEXIST)) {
-            return translate_mdb_error(rc, error);
-        }
+        if (WTREE_UNLIKELY(rc != 0)) return rc;
     }
 
     return WTREE3_OK;
@@ -79,13 +91,19 @@ int indexes_delete(wtree3_tree_t *tree, MDB_txn *txn,
 
         if (WTREE_LIKELY(!should_index || !idx_key)) continue;
 
-        /* Delete specific key+value pair from DUPSORT tree */
-        MDB_val mk = {.mv_size = idx_key_len, .mv_data = idx_key};
-        MDB_val mv = {.mv_size = key_len, .mv_data = (void*)key};
-        int rc = mdb_del(txn, idx->dbi, &mk, &mv);
+        /* Delete specific key+value pairs from DUPSORT tree */
+        size_t pos = 0;
+        MDB_val mk;
+        int rc = 0;
+        while (index_key_next(idx, idx_key, idx_key_len, &pos, &mk)) {
+            MDB_val mv = {.mv_size = key_len, .mv_data = (void*)key};
+            rc = mdb_del(txn, idx->dbi, &mk, &mv);
+            if (WTREE_UNLIKELY(rc != 0 && rc != MDB_NOTFOUND)) break;
+            rc = 0;
+        }
         free(idx_key);
 
-        if (WTREE_UNLIKELY(rc != 0 && rc != MDB_NOTFOUND)) {
+        if (WTREE_UNLIKELY(rc != 0)) {
             return translate_mdb_error(rc, error);
         }
     }
@@ -144,6 +162,7 @@ int wtree3_insert_one_txn(wtree3_txn_t *txn, wtree3_tree_t *tree,
     rc = mdb_put(txn->txn, tree->dbi, &mkey, &mval, MDB_NOOVERWRITE);
     if (WTREE_UNLIKELY(rc != 0)) return translate_mdb_error(rc, error);
 
+    WTREE3_COUNT_WRITE(txn->db, key_len + value_len);
     tree->entry_count++;
     return WTREE3_OK;
 }
@@ -190,6 +209,7 @@ int wtree3_update_txn(wtree3_txn_t *txn, wtree3_tree_t *tree,
     rc = mdb_put(txn->txn, tree->dbi, &mkey, &mval, 0);
     if (WTREE_UNLIKELY(rc != 0)) return translate_mdb_error(rc, error);
 
+    WTREE3_COUNT_WRITE(txn->db, key_len + value_len);
     return WTREE3_OK;
 }
 
@@ -351,8 +371,10 @@ int wtree3_delete_one_txn(wtree3_txn_t *txn, wtree3_tree_t *tree,
     if (rc != 0) return rc;
 
     /* Delete from main tree */
+    size_t old_len = mval.mv_size;
     rc = mdb_del(txn->txn, tree->dbi, &mkey, NULL);
     if (rc == 0) {
+        WTREE3_COUNT_WRITE(txn->db, key_len + old_len);
         tree->entry_count--;
         if (deleted) *deleted = true;
     } else if (rc != MDB_NOTFOUND) {
@@ -265,6 +265,7 @@ int wtree3_tree_add_index(wtree3_tree_t *tree,
     idx->key_fn = key_fn;
     idx->unique = config->unique;
     idx->sparse = config->sparse;
+    idx->multikey = config->multikey;
     idx->compare = config->compare;
     idx->dupsort_compare = config->dupsort_compare;
 
@@ -362,32 +363,22 @@ int wtree3_tree_populate_index(wtree3_tree_t *tree,
         bool should_index = idx->key_fn(mval.mv_data, mval.mv_size, idx->user_data,
                                         &idx_key, &idx_key_size);
 
-        if (should_index && idx_key) {
-            /* Check unique constraint */
-            if (idx->unique) {
-                MDB_val check_key = {.mv_size = idx_key_size, .mv_data = idx_key};
-                MDB_val check_val;
-                int get_rc = mdb_get(txn, idx->dbi, &check_key, &check_val);
-                if (get_rc == 0) {
-                    free(idx_key);
-                    mdb_cursor_close(cursor);
-                    mdb_txn_abort(txn);
-                    set_error(error, WTREE3_LIB, WTREE3_INDEX_ERROR,
-                             "Duplicate key for unique index '%s'", index_name);
-                    return WTREE3_INDEX_ERROR;
-                }
-            }
-
-            /* Insert: index_key -> main_key */
-            MDB_val idx_k = {.mv_size = idx_key_size, .mv_data = idx_key};
-            MDB_val idx_v = {.mv_size = mkey.mv_size, .mv_data = mkey.mv_data};
-            rc = mdb_put(txn, idx->dbi, &idx_k, &idx_v, MDB_NODUPDATA);
+        if (should_index && !idx_key) {
+            set_error(error, WTREE3_LIB, WTREE3_ERROR,
+                     "Index key extraction failed for '%s'", idx->name);
+            mdb_cursor_close(cursor);
+            mdb_txn_abort(txn);
+            return WTREE3_ERROR;
+        }
+        if (should_index) {
+            rc = index_put_keys(idx, txn, idx_key, idx_key_size,
+                                mkey.mv_data, mkey.mv_size, error);
             free(idx_key);
 
-            if (rc != 0 && rc != MDB_KEYEXIST) {
+            if (rc != 0) {
                 mdb_cursor_close(cursor);
                 mdb_txn_abort(txn);
-                return translate_mdb_error(rc, error);
+                return rc;
             }
         }
 
@@ -532,10 +523,7 @@ int wtree3_verify_indexes(wtree3_tree_t *tree, gerror_t *error) {
                 return WTREE3_INDEX_ERROR;
             }
 
-            // Check if this entry exists in the index
-            MDB_val idx_search_key = {.mv_size = idx_key_len, .mv_data = idx_key};
-            MDB_val idx_val;
-
+            // Check that every key it emits is in the index
             MDB_cursor *idx_cursor;
             int idx_rc = mdb_cursor_open(txn, idx->dbi, &idx_cursor);
             if (idx_rc != 0) {
@@ -545,56 +533,52 @@ int wtree3_verify_indexes(wtree3_tree_t *tree, gerror_t *error) {
                 return translate_mdb_error(idx_rc, error);
             }
 
-            // For unique indexes, there should be exactly one entry
-            // For non-unique, search for our primary key in duplicates
-            idx_rc = mdb_cursor_get(idx_cursor, &idx_search_key, &idx_val, MDB_SET);
-
-            if (idx_rc == MDB_NOTFOUND) {
-                // Missing index entry!
-                mdb_cursor_close(idx_cursor);
-                free(idx_key);
-                mdb_cursor_close(main_cursor);
-                mdb_txn_abort(txn);
-                set_error(error, WTREE3_LIB, WTREE3_INDEX_ERROR,
-                         "Index '%s': missing entry for main tree key (index inconsistency)",
-                         idx->name);
-                return WTREE3_INDEX_ERROR;
-            }
-
-            if (idx_rc != 0) {
-                mdb_cursor_close(idx_cursor);
-                free(idx_key);
-                mdb_cursor_close(main_cursor);
-                mdb_txn_abort(txn);
-                return translate_mdb_error(idx_rc, error);
-            }
-
-            // For non-unique indexes with DUPSORT, verify our PK is in the duplicates
-            if (!idx->unique) {
-                bool found_pk = false;
-                do {
-                    if (idx_val.mv_size == key.mv_size &&
-                        memcmp(idx_val.mv_data, key.mv_data, key.mv_size) == 0) {
-                        found_pk = true;
-                        break;
+            size_t pos = 0;
+            MDB_val idx_search_key;
+            const char *problem = NULL;
+            while (!problem && idx_rc == 0 &&
+                   index_key_next(idx, idx_key, idx_key_len, &pos, &idx_search_key)) {
+                // For unique indexes, there should be exactly one entry
+                // For non-unique, search for our primary key in duplicates
+                MDB_val idx_val;
+                idx_rc = mdb_cursor_get(idx_cursor, &idx_search_key, &idx_val, MDB_SET);
+
+                if (idx_rc == MDB_NOTFOUND) {
+                    // Missing index entry!
+                    problem = "missing entry for main tree key (index inconsistency)";
+                    break;
+                }
+                if (idx_rc != 0) break;
+
+                // For non-unique indexes with DUPSORT, verify our PK is in the duplicates
+                if (!idx->unique) {
+                    bool found_pk = false;
+                    do {
+                        if (idx_val.mv_size == key.mv_size &&
+                            memcmp(idx_val.mv_data, key.mv_data, key.mv_size) == 0) {
+                            found_pk = true;
+                            break;
+                        }
+                        idx_rc = mdb_cursor_get(idx_cursor, &idx_search_key, &idx_val, MDB_NEXT_DUP);
+                    } while (idx_rc == 0);
+
+                    if (!found_pk) {
+                        problem = "primary key not found in index duplicates (index inconsistency)";
                     }
-                    idx_rc = mdb_cursor_get(idx_cursor, &idx_search_key, &idx_val, MDB_NEXT_DUP);
-                } while (idx_rc == 0);
-
-                if (!found_pk) {
-                    mdb_cursor_close(idx_cursor);
-                    free(idx_key);
-                    mdb_cursor_close(main_cursor);
-                    mdb_txn_abort(txn);
-                    set_error(error, WTREE3_LIB, WTREE3_INDEX_ERROR,
-                             "Index '%s': primary key not found in index duplicates (index inconsistency)",
-                             idx->name);
-                    return WTREE3_INDEX_ERROR;
+                    idx_rc = 0;
                 }
             }
 
             mdb_cursor_close(idx_cursor);
             free(idx_key);
+            if (problem || idx_rc != 0) {
+                mdb_cursor_close(main_cursor);
+                mdb_txn_abort(txn);
+                if (!problem) return translate_mdb_error(idx_rc, error);
+                set_error(error, WTREE3_LIB, WTREE3_INDEX_ERROR, "Index '%s': %s",
+                         idx->name, problem);
+                return WTREE3_INDEX_ERROR;
+            }
         }
 
         rc = mdb_cursor_get(main_cursor, &key, &val, MDB_NEXT);
@@ -739,6 +723,7 @@ int wtree3_tree_list_indexes(
 
         infos[i].unique = idx->unique;
         infos[i].sparse = idx->sparse;
+        infos[i].multikey = idx->multikey;
         infos[i].dbi = idx->dbi;
     }
 
@@ -2,12 +2,15 @@
  * wtree3_index_persist.c - Index Persistence and Restoration
  *
  * This module handles index metadata serialization and restoration:
- * - Save index metadata (extractor_id, flags, user_data)
+ * - Save index metadata (extractor_id, flags, user_data, statistics)
  * - Load index metadata and auto-attach indexes
  * - Index introspection (get_extractor_id)
+ * - Planner statistics (opaque to wtree3, kept with the metadata)
  *
- * Metadata format (16 bytes + user_data):
- *   [extractor_id:8][flags:4][user_data_len:4][user_data:N]
+ * Metadata format (16 bytes + user_data, then optional statistics):
+ *   [extractor_id:8][flags:4][user_data_len:4][user_data:N][stats_len:4][stats:M]
+ *
+ * Records written before statistics existed end after user_data.
  */
 
 #include "wtree3_internal.h"
@@ -31,9 +34,13 @@
 /* Total header size (before variable-length user_data) */
 #define META_HEADER_SIZE            16
 
+/* Length prefix of the optional statistics section */
+#define META_STATS_LEN_SIZE         4
+
 /* Flag bits */
 #define META_FLAG_UNIQUE            0x01
 #define META_FLAG_SPARSE            0x02
+#define META_FLAG_MULTIKEY          0x04
 
 /*
  * In-memory representation of index metadata
@@ -43,8 +50,11 @@ typedef struct {
     uint64_t extractor_id;
     bool unique;
     bool sparse;
+    bool multikey;
     void *user_data;
     size_t user_data_len;
+    void *stats;
+    size_t stats_len;
 } index_metadata_t;
 
 /* ============================================================
@@ -63,6 +73,9 @@ static uint8_t* serialize_index_metadata(const index_metadata_t *meta, size_t *o
     }
 
     size_t total_len = META_HEADER_SIZE + meta->user_data_len;
+    if (meta->stats_len > 0) {
+        total_len += META_STATS_LEN_SIZE + meta->stats_len;
+    }
     uint8_t *buffer = malloc(total_len);
     if (WTREE_UNLIKELY(!buffer)) {
         return NULL;
@@ -75,6 +88,7 @@ static uint8_t* serialize_index_metadata(const index_metadata_t *meta, size_t *o
     uint32_t flags = 0;
     if (meta->unique) flags |= META_FLAG_UNIQUE;
     if (meta->sparse) flags |= META_FLAG_SPARSE;
+    if (meta->multikey) flags |= META_FLAG_MULTIKEY;
     memcpy(buffer + META_FLAGS_OFFSET, &flags, META_FLAGS_SIZE);
 
     /* Write user_data length at offset 12 */
@@ -86,6 +100,14 @@ static uint8_t* serialize_index_metadata(const index_metadata_t *meta, size_t *o
         memcpy(buffer + META_USERDATA_OFFSET, meta->user_data, meta->user_data_len);
     }
 
+    /* Optional statistics after user_data */
+    if (meta->stats_len > 0) {
+        uint8_t *at = buffer + META_USERDATA_OFFSET + meta->user_data_len;
+        uint32_t st_len = (uint32_t)meta->stats_len;
+        memcpy(at, &st_len, META_STATS_LEN_SIZE);
+        memcpy(at + META_STATS_LEN_SIZE, meta->stats, meta->stats_len);
+    }
+
     *out_len = total_len;
     return buffer;
 }
@@ -93,7 +115,7 @@ static uint8_t* serialize_index_metadata(const index_metadata_t *meta, size_t *o
 /*
  * Deserialize index metadata from binary format
  * Returns 0 on success, error code on failure
- * Allocates user_data if present (caller must free)
+ * Allocates user_data and stats if present (caller must free)
  */
 static int deserialize_index_metadata(const void *data, size_t data_len,
                                         index_metadata_t *out_meta, gerror_t *error) {
@@ -117,6 +139,7 @@ static int deserialize_index_metadata(const void *data, size_t data_len,
     memcpy(&flags, buffer + META_FLAGS_OFFSET, META_FLAGS_SIZE);
     out_meta->unique = (flags & META_FLAG_UNIQUE) != 0;
     out_meta->sparse = (flags & META_FLAG_SPARSE) != 0;
+    out_meta->multikey = (flags & META_FLAG_MULTIKEY) != 0;
 
     /* Read user_data length */
     uint32_t ud_len;
@@ -142,6 +165,32 @@ static int deserialize_index_metadata(const void *data, size_t data_len,
         out_meta->user_data_len = 0;
     }
 
+    /* Optional statistics */
+    out_meta->stats = NULL;
+    out_meta->stats_len = 0;
+    size_t at = META_HEADER_SIZE + ud_len;
+    if (data_len >= at + META_STATS_LEN_SIZE) {
+        uint32_t st_len;
+        memcpy(&st_len, buffer + at, META_STATS_LEN_SIZE);
+        if (WTREE_UNLIKELY(data_len < at + META_STATS_LEN_SIZE + st_len)) {
+            free(out_meta->user_data);
+            out_meta->user_data = NULL;
+            set_error(error, WTREE3_LIB, WTREE3_ERROR, "Invalid metadata format: stats truncated");
+            return WTREE3_ERROR;
+        }
+        if (st_len > 0) {
+            out_meta->stats = malloc(st_len);
+            if (WTREE_UNLIKELY(!out_meta->stats)) {
+                free(out_meta->user_data);
+                out_meta->user_data = NULL;
+                set_error(error, WTREE3_LIB, WTREE3_ENOMEM, "Failed to allocate stats");
+                return WTREE3_ENOMEM;
+            }
+            memcpy(out_meta->stats, buffer + at + META_STATS_LEN_SIZE, st_len);
+            out_meta->stats_len = st_len;
+        }
+    }
+
     return WTREE3_OK;
 }
 
@@ -185,8 +234,11 @@ int save_index_metadata(wtree3_tree_t *tree,
         .extractor_id = idx->extractor_id,
         .unique = idx->unique,
         .sparse = idx->sparse,
+        .multikey = idx->multikey,
         .user_data = idx->user_data,
-        .user_data_len = idx->user_data_len
+        .user_data_len = idx->user_data_len,
+        .stats = idx->stats,
+        .stats_len = idx->stats_len
     };
 
     /* Serialize to binary format */
@@ -219,8 +271,11 @@ typedef struct {
     uint64_t extractor_id;
     bool unique;
     bool sparse;
+    bool multikey;
     void *user_data;
     size_t user_data_len;
+    void *stats;
+    size_t stats_len;
     gerror_t *error;
 } read_metadata_ctx_t;
 
@@ -245,8 +300,11 @@ static int read_metadata_txn(MDB_txn *txn, void *user_data_param) {
     ctx->extractor_id = meta.extractor_id;
     ctx->unique = meta.unique;
     ctx->sparse = meta.sparse;
+    ctx->multikey = meta.multikey;
     ctx->user_data = meta.user_data;
     ctx->user_data_len = meta.user_data_len;
+    ctx->stats = meta.stats;
+    ctx->stats_len = meta.stats_len;
 
     return WTREE3_OK;
 }
@@ -254,12 +312,16 @@ static int read_metadata_txn(MDB_txn *txn, void *user_data_param) {
 /* Helper context for opening index DBI */
 typedef struct {
     const char *idx_tree_name;
+    MDB_cmp_func *compare;
     MDB_dbi *out_dbi;
 } open_index_dbi_ctx_t;
 
 static int open_index_dbi_txn(MDB_txn *txn, void *user_data_param) {
     open_index_dbi_ctx_t *ctx = (open_index_dbi_ctx_t *)user_data_param;
     int rc = mdb_dbi_open(txn, ctx->idx_tree_name, MDB_DUPSORT, ctx->out_dbi);
+    if (rc == 0 && ctx->compare) {
+        rc = mdb_set_compare(txn, *ctx->out_dbi, ctx->compare);
+    }
     return rc != 0 ? rc : WTREE3_OK;
 }
 
@@ -298,6 +360,7 @@ int load_index_metadata(wtree3_tree_t *tree, const char *index_name, gerror_t *e
     wtree3_index_key_fn key_fn = find_extractor(tree->db, meta_ctx.extractor_id);
     if (WTREE_UNLIKELY(!key_fn)) {
         free(meta_ctx.user_data);
+        free(meta_ctx.stats);
         /* Extractor not registered - log warning and skip */
         fprintf(stderr, "Warning: Skipping index '%s' - extractor 0x%016llx not registered\n",
                 index_name, (unsigned long long)meta_ctx.extractor_id);
@@ -315,6 +378,7 @@ int load_index_metadata(wtree3_tree_t *tree, const char *index_name, gerror_t *e
     MDB_dbi idx_dbi;
     open_index_dbi_ctx_t open_ctx = {
         .idx_tree_name = idx_tree_name,
+        .compare = tree->db->index_compare,
         .out_dbi = &idx_dbi
     };
 
@@ -344,9 +408,12 @@ int load_index_metadata(wtree3_tree_t *tree, const char *index_name, gerror_t *e
     idx->key_fn = key_fn;
     idx->user_data = meta_ctx.user_data;
     idx->user_data_len = meta_ctx.user_data_len;
+    idx->stats = meta_ctx.stats;
+    idx->stats_len = meta_ctx.stats_len;
     idx->unique = meta_ctx.unique;
     idx->sparse = meta_ctx.sparse;
-    idx->compare = NULL;  /* Not persisted */
+    idx->multikey = meta_ctx.multikey;
+    idx->compare = tree->db->index_compare;  /* Not persisted */
     idx->dupsort_compare = NULL;  /* Not persisted */
 
     /* Add to vector */
@@ -370,6 +437,7 @@ cleanup_tree_name:
     free(idx_tree_name);
 cleanup_user_data:
     free(meta_ctx.user_data);
+    free(meta_ctx.stats);
     return rc;
 }
 
@@ -404,8 +472,9 @@ static int get_extractor_id_txn(MDB_txn *txn, void *user_data) {
 
     *ctx->out_extractor_id = meta.extractor_id;
 
-    /* Free user_data since we don't need it */
+    /* Free user_data and stats since we don't need them */
     free(meta.user_data);
+    free(meta.stats);
 
     return WTREE3_OK;
 }
@@ -438,6 +507,87 @@ int wtree3_index_get_extractor_id(wtree3_tree_t *tree,
     return with_read_txn(tree->db, get_extractor_id_txn, &ctx, error);
 }
 
+/* ============================================================
+ * Planner Statistics
+ * ============================================================ */
+
+int wtree3_tree_get_index_stats(wtree3_tree_t *tree, const char *index_name,
+                                const void **out_data, size_t *out_len) {
+    if (WTREE_UNLIKELY(!tree || !index_name || !out_data || !out_len)) {
+        return WTREE3_EINVAL;
+    }
+
+    wtree3_index_t *idx = find_index(tree, index_name);
+    if (!idx || !idx->stats) return WTREE3_NOT_FOUND;
+
+    *out_data = idx->stats;
+    *out_len = idx->stats_len;
+    return WTREE3_OK;
+}
+
+WTREE_COLD
+int wtree3_tree_set_index_stats_txn(wtree3_txn_t *txn, wtree3_tree_t *tree,
+                                    const char *index_name, const void *data, size_t len,
+                                    gerror_t *error) {
+    if (WTREE_UNLIKELY(!txn || !tree || !index_name || (len > 0 && !data))) {
+        set_error(error, WTREE3_LIB, WTREE3_EINVAL, "Invalid parameters");
+        return WTREE3_EINVAL;
+    }
+    if (WTREE_UNLIKELY(!txn->is_write)) {
+        set_error(error, WTREE3_LIB, WTREE3_EINVAL, "Write transaction required");
+        return WTREE3_EINVAL;
+    }
+
+    wtree3_index_t *idx = find_index(tree, index_name);
+    if (WTREE_UNLIKELY(!idx)) {
+        set_error(error, WTREE3_LIB, WTREE3_NOT_FOUND,
+                 "Index '%s' not found", index_name);
+        return WTREE3_NOT_FOUND;
+    }
+
+    void *copy = NULL;
+    if (len > 0) {
+        copy = malloc(len);
+        if (WTREE_UNLIKELY(!copy)) {
+            set_error(error, WTREE3_LIB, WTREE3_ENOMEM, "Failed to allocate stats");
+            return WTREE3_ENOMEM;
+        }
+        memcpy(copy, data, len);
+    }
+
+    index_metadata_t meta = {
+        .extractor_id = idx->extractor_id,
+        .unique = idx->unique,
+        .sparse = idx->sparse,
+        .multikey = idx->multikey,
+        .user_data = idx->user_data,
+        .user_data_len = idx->user_data_len,
+        .stats = copy,
+        .stats_len = len
+    };
+
+    size_t meta_len;
+    uint8_t *meta_value = serialize_index_metadata(&meta, &meta_len);
+    if (WTREE_UNLIKELY(!meta_value)) {
+        free(copy);
+        set_error(error, WTREE3_LIB, WTREE3_ENOMEM, "Failed to allocate metadata");
+        return WTREE3_ENOMEM;
+    }
+
+    int rc = metadata_put_txn(txn->txn, tree->db, tree->name, index_name,
+                              meta_value, meta_len, error);
+    free(meta_value);
+    if (rc != 0) {
+        free(copy);
+        return rc;
+    }
+
+    free(idx->stats);
+    idx->stats = copy;
+    idx->stats_len = len;
+    return WTREE3_OK;
+}
+
 /* ============================================================
  * List Persisted Indexes
  * ============================================================ */
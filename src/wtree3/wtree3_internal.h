@@ -47,8 +47,17 @@ struct wtree3_db_t {
 
     /* Extractor registry (version+flags → key_fn) */
     wtree3_extractor_registry_t *extractor_registry;
+
+    /* Comparator of reloaded indexes (NULL: LMDB default) */
+    MDB_cmp_func *index_compare;
+
+    /* Main-tree bytes put or deleted (relaxed atomic; aborted txns count too) */
+    uint64_t bytes_written;
 };
 
+/* Account a main-tree write of n bytes */
+#define WTREE3_COUNT_WRITE(db, n) WTREE_ATOMIC_ADD(&(db)->bytes_written, (uint64_t)(n))
+
 /* Transaction handle */
 struct wtree3_txn_t {
     MDB_txn *txn;
@@ -65,8 +74,11 @@ typedef struct wtree3_index {
     wtree3_index_key_fn key_fn;     /* Key extraction callback (looked up from registry) */
     void *user_data;                /* Callback user data (owned by index, copied from config) */
     size_t user_data_len;           /* Length of user_data */
+    void *stats;                    /* Planner statistics (opaque, persisted; may be NULL) */
+    size_t stats_len;               /* Length of stats */
     bool unique;                    /* Unique constraint */
     bool sparse;                    /* Sparse index */
+    bool multikey;                  /* Extractor emits a packed key list */
     MDB_cmp_func *compare;          /* Custom key comparator */
     MDB_cmp_func *dupsort_compare;  /* Custom duplicate value comparator */
 } wtree3_index_t;
@@ -136,9 +148,32 @@ static inline uint32_t extract_index_flags(const wtree3_index_config_t *config)
     uint32_t flags = 0;
     if (config->unique) flags |= 0x01;
     if (config->sparse) flags |= 0x02;
+    if (config->multikey) flags |= 0x04;
     return flags;
 }
 
+/* Next key an extractor emitted (pos starts at 0): the whole buffer, or
+ * for a multi-key index the next [uint32_t len][bytes] entry */
+static inline bool index_key_next(const wtree3_index_t *idx, const void *buf, size_t len,
+                                  size_t *pos, MDB_val *out) {
+    if (!idx->multikey) {
+        if (*pos) return false;
+        *pos = 1;
+        out->mv_data = (void *)buf;
+        out->mv_size = len;
+        return true;
+    }
+
+    uint32_t n;
+    if (*pos + sizeof(n) > len) return false;
+    memcpy(&n, (const uint8_t *)buf + *pos, sizeof(n));
+    if (n > len - *pos - sizeof(n)) return false;
+    out->mv_data = (uint8_t *)buf + *pos + sizeof(n);
+    out->mv_size = n;
+    *pos += sizeof(n) + n;
+    return true;
+}
+
 /* ============================================================
  * Index Helper Functions (implemented in wtree3_index.c)
  * ============================================================ */
@@ -197,4 +232,11 @@ int indexes_delete(wtree3_tree_t *tree, MDB_txn *txn,
                    const void *value, size_t value_len,
                    gerror_t *error);
 
+/* Map each key an extractor emitted to the main key, checking uniqueness */
+WTREE_HOT
+int index_put_keys(wtree3_index_t *idx, MDB_txn *txn,
+                   const void *idx_key, size_t idx_key_len,
+                   const void *key, size_t key_len,
+                   gerror_t *error);
+
 #endif /* WTREE3_INTERNAL_H */
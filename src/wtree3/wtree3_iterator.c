@@ -280,6 +280,7 @@ int wtree3_iterator_delete(wtree3_iterator_t *iter, gerror_t *error) {
     if (rc != 0) return translate_mdb_error(rc, error);
 
     /* Update iterator state */
+    WTREE3_COUNT_WRITE(iter->txn->db, key_len + value_len);
     tree->entry_count--;
     iter->valid = false;
 
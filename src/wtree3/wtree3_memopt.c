@@ -4,7 +4,7 @@
  * Provides OS-level memory optimizations for wtree3 databases:
  * - Memory access hints (madvise)
  * - Memory locking (mlock/munlock)
- * - Page prefetching
+ * - Page prefetching (by map offset or by address)
  * - Memory map introspection
  *
  * Platform support:
@@ -20,6 +20,7 @@
     #include <sys/mman.h>
     #include <errno.h>
     #include <string.h>
+    #include <unistd.h>
 #elif WTREE_OS_WINDOWS
     #include <windows.h>
     #include <memoryapi.h>
@@ -322,3 +323,47 @@ int wtree3_db_prefetch(wtree3_db_t *db, size_t offset, size_t length, gerror_t *
 
     return WTREE3_OK;
 }
+
+WTREE_WARN_UNUSED
+int wtree3_db_prefetch_addr(wtree3_db_t *db, const void *addr, size_t length, gerror_t *error) {
+    if (WTREE_UNLIKELY(!db || !addr)) {
+        set_error(error, WTREE3_LIB, WTREE3_EINVAL, "Database and address cannot be NULL");
+        return WTREE3_EINVAL;
+    }
+
+#if WTREE_OS_POSIX
+    uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+    uintptr_t start = (uintptr_t)addr & ~(page - 1);
+    length += (size_t)((uintptr_t)addr - start);
+
+    /* ENOMEM: part of the range is past the map; the rest was advised */
+    if (WTREE_UNLIKELY(madvise((void*)start, length, MADV_WILLNEED) != 0 && errno != ENOMEM)) {
+        set_error(error, WTREE3_LIB, WTREE3_ERROR,
+                 "madvise(MADV_WILLNEED) failed: %s", strerror(errno));
+        return WTREE3_ERROR;
+    }
+
+#elif WTREE_OS_WINDOWS
+    #if defined(PrefetchVirtualMemory)
+    WIN32_MEMORY_RANGE_ENTRY range = {(PVOID)addr, length};
+    if (!PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0)) {
+        set_error(error, WTREE3_LIB, WTREE3_ERROR,
+                 "PrefetchVirtualMemory failed (code %lu)", GetLastError());
+        return WTREE3_ERROR;
+    }
+    #else
+    (void)length;
+    set_error(error, WTREE3_LIB, WTREE3_ERROR,
+             "Memory prefetch not available (requires Windows 8+)");
+    return WTREE3_ERROR;
+    #endif
+
+#else
+    (void)length;
+    set_error(error, WTREE3_LIB, WTREE3_ERROR,
+             "Memory prefetch not supported on this platform");
+    return WTREE3_ERROR;
+#endif
+
+    return WTREE3_OK;
+}
@@ -274,6 +274,7 @@ int wtree3_modify_txn(
         free(new_value);
 
         if (rc != 0) return translate_mdb_error(rc, error);
+        WTREE3_COUNT_WRITE(txn->db, key_len + new_len);
     } else {
         /* Insert new key */
         rc = wtree3_insert_one_txn(txn, tree, key, key_len, new_value, new_len, error);
@@ -284,6 +285,46 @@ int wtree3_modify_txn(
     return WTREE3_OK;
 }
 
+/* Key order of two batch keys under the tree's comparator */
+static inline int _kv_cmp(wtree3_txn_t *txn, wtree3_tree_t *tree,
+                          const wtree3_kv_t *a, const wtree3_kv_t *b) {
+    MDB_val ka = {.mv_size = a->key_len, .mv_data = (void*)a->key};
+    MDB_val kb = {.mv_size = b->key_len, .mv_data = (void*)b->key};
+    return mdb_cmp(txn->txn, tree->dbi, &ka, &kb);
+}
+
+/* Sort order[] (indexes into keys) by key: bottom-up merge sort (stable,
+ * no recursion), skipped when the keys already ascend */
+static void _sort_key_order(wtree3_txn_t *txn, wtree3_tree_t *tree, const wtree3_kv_t *keys,
+                            size_t *order, size_t *tmp, size_t n) {
+    bool sorted = true;
+    for (size_t i = 1; i < n && sorted; i++) {
+        sorted = _kv_cmp(txn, tree, &keys[i - 1], &keys[i]) <= 0;
+    }
+    if (sorted) return;
+
+    size_t *src = order, *dst = tmp;
+    for (size_t width = 1; width < n; width *= 2) {
+        for (size_t lo = 0; lo < n; lo += 2 * width) {
+            size_t mid = lo + width < n ? lo + width : n;
+            size_t hi = lo + 2 * width < n ? lo + 2 * width : n;
+            size_t i = lo, j = mid, k = lo;
+            while (i < mid && j < hi) {
+                dst[k++] = _kv_cmp(txn, tree, &keys[src[j]], &keys[src[i]]) < 0 ? src[j++] : src[i++];
+            }
+            while (i < mid) dst[k++] = src[i++];
+            while (j < hi) dst[k++] = src[j++];
+        }
+        size_t *swap = src;
+        src = dst;
+        dst = swap;
+    }
+    if (src != order) memcpy(order, src, n * sizeof(*order));
+}
+
+/* Keys are looked up in sorted order through one cursor: LMDB then finds
+ * neighbouring keys on the leaf it is already on instead of descending
+ * from the root, and the pages it does touch are visited in file order. */
 int wtree3_get_many_txn(
     wtree3_txn_t *txn,
     wtree3_tree_t *tree,
@@ -296,11 +337,31 @@ int wtree3_get_many_txn(
         return WTREE3_EINVAL;
     }
 
-    for (size_t i = 0; i < key_count; i++) {
+    size_t stack_order[2 * 64];
+    size_t *order = stack_order;
+    if (key_count > 64) {
+        order = malloc(2 * key_count * sizeof(*order));
+        if (!order) {
+            set_error(error, WTREE3_LIB, WTREE3_ENOMEM, "Failed to allocate batch order");
+            return WTREE3_ENOMEM;
+        }
+    }
+    for (size_t i = 0; i < key_count; i++) order[i] = i;
+    _sort_key_order(txn, tree, keys, order, order + key_count, key_count);
+
+    MDB_cursor *cursor;
+    int rc = mdb_cursor_open(txn->txn, tree->dbi, &cursor);
+    if (rc != 0) {
+        if (order != stack_order) free(order);
+        return translate_mdb_error(rc, error);
+    }
+
+    for (size_t n = 0; n < key_count; n++) {
+        size_t i = order[n];
         MDB_val mkey = {.mv_size = keys[i].key_len, .mv_data = (void*)keys[i].key};
         MDB_val mval;
 
-        int rc = mdb_get(txn->txn, tree->dbi, &mkey, &mval);
+        rc = mdb_cursor_get(cursor, &mkey, &mval, MDB_SET_KEY);
 
         if (rc == 0) {
             values[i] = mval.mv_data;
@@ -309,10 +370,14 @@ int wtree3_get_many_txn(
             values[i] = NULL;
             value_lens[i] = 0;
         } else {
-            return translate_mdb_error(rc, error);
+            break;
         }
     }
 
+    mdb_cursor_close(cursor);
+    if (order != stack_order) free(order);
+    if (rc != 0 && rc != MDB_NOTFOUND) return translate_mdb_error(rc, error);
+
     return WTREE3_OK;
 }
 
@@ -412,6 +477,7 @@ int wtree3_delete_if_txn(
                 return translate_mdb_error(rc, error);
             }
 
+            WTREE3_COUNT_WRITE(txn->db, key_copy_len + val_copy_len);
             tree->entry_count--;
             deleted_count++;
 
@@ -26,6 +26,7 @@ static void cleanup_index(void *element) {
     wtree3_index_t *idx = (wtree3_index_t *)element;
     if (WTREE_UNLIKELY(!idx)) return;
     free(idx->user_data);
+    free(idx->stats);
     free(idx->name);
     free(idx->tree_name);
     free(idx);
@@ -356,6 +357,10 @@ wtree3_db_t* wtree3_tree_get_db(wtree3_tree_t *tree) {
     return tree ? tree->db : NULL;
 }
 
+MDB_dbi wtree3_tree_get_dbi(wtree3_tree_t *tree) {
+    return tree ? tree->dbi : 0;
+}
+
 /* Helper context for set_compare transaction */
 typedef struct {
     wtree3_tree_t *tree;
@@ -1009,6 +1009,80 @@ static void test_numeric_transitivity(void **state) {
     bson_destroy(a); bson_destroy(b); bson_destroy(c);
 }
 
+/* ============================================================
+ * TESTS: Keys, Symbols and Batch Comparison
+ * ============================================================ */
+
+static void test_key_prefix_is_less(void **state) {
+    (void)state;
+    bson_t *a = make_doc_int32("ab", 1);
+    bson_t *b = make_doc_int32("abc", 1);
+    assert_true(bson_compare_docs(a, b) < 0);
+    assert_true(bson_compare_docs(b, a) > 0);
+    bson_destroy(a); bson_destroy(b);
+}
+
+static void test_symbol_vs_string(void **state) {
+    (void)state;
+    bson_t *a = bson_new();
+    bson_t *b = make_doc_utf8("s", "abd");
+    bson_t *c = bson_new();
+    BSON_APPEND_SYMBOL(a, "s", "abc");
+    BSON_APPEND_SYMBOL(c, "s", "zzz");
+    /* Symbols read as "": the order persisted indexes were built with */
+    assert_true(bson_compare_docs(a, b) < 0);
+    assert_int_equal(bson_compare_docs(a, c), 0);
+    bson_destroy(c);
+    bson_t *e = make_doc_utf8("s", "");
+    assert_int_equal(bson_compare_docs(a, e), 0);
+    bson_destroy(e);
+    bson_destroy(a); bson_destroy(b);
+}
+
+static void test_batch_matches_single(void **state) {
+    (void)state;
+    /* Runs of the pivot's type (batched) mixed with other types */
+    bson_t *doc = bson_new();
+    char key[16];
+    for (int i = 0; i < 200; i++) {
+        snprintf(key, sizeof(key), "%d", i);
+        switch (i % 23) {
+            case 5:  BSON_APPEND_UTF8(doc, key, "x"); break;
+            case 9:  BSON_APPEND_INT64(doc, key, i - 100); break;
+            case 11: BSON_APPEND_DOUBLE(doc, key, NAN); break;
+            case 17: BSON_APPEND_NULL(doc, key); break;
+            default:
+                if (i < 120) BSON_APPEND_INT32(doc, key, (i * 37) % 101 - 50);
+                else BSON_APPEND_DOUBLE(doc, key, (i % 7) - 3.5);
+                break;
+        }
+    }
+    bson_iter_t values[200];
+    bson_iter_t it;
+    size_t n = 0;
+    assert_true(bson_iter_init(&it, doc));
+    while (bson_iter_next(&it)) values[n++] = it;
+
+    bson_t *pivots = bson_new();
+    BSON_APPEND_INT32(pivots, "a", 0);
+    BSON_APPEND_DOUBLE(pivots, "b", -0.5);
+    BSON_APPEND_DOUBLE(pivots, "c", NAN);
+    BSON_APPEND_INT64(pivots, "d", 3);
+    BSON_APPEND_UTF8(pivots, "e", "x");
+
+    bson_iter_t pivot;
+    assert_true(bson_iter_init(&pivot, pivots));
+    while (bson_iter_next(&pivot)) {
+        int out[200];
+        mongodb_compare_iter_batch(values, n, &pivot, out);
+        for (size_t i = 0; i < n; i++) {
+            assert_int_equal(mongodb_compare_iter(&values[i], &pivot), out[i]);
+        }
+    }
+    bson_destroy(pivots);
+    bson_destroy(doc);
+}
+
 int main(void) {
     const struct CMUnitTest tests[] = {
         // Type precedence
@@ -1107,6 +1181,10 @@ int main(void) {
         // Symmetry and transitivity
         cmocka_unit_test(test_numeric_symmetry),
         cmocka_unit_test(test_numeric_transitivity),
+        // Keys, symbols, batch
+        cmocka_unit_test(test_key_prefix_is_less),
+        cmocka_unit_test(test_symbol_vs_string),
+        cmocka_unit_test(test_batch_matches_single),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
@@ -0,0 +1,309 @@
+/**
+ * test_mongolite_analyze.c - Tests for index statistics and cost-based planning
+ *
+ * Tests:
+ * - Equality on two indexed fields uses the selective index, not the
+ *   first one created
+ * - $in seeks pick the path with the fewest estimated entries
+ * - mongolite_index_stats after create_index; unknown index
+ * - Statistics rebuilt and persisted by the commit that grows an index,
+ *   not by the next query
+ * - mongolite_analyze persists statistics across reopen; NULL collection
+ *   analyzes every collection
+ * - Dropping an index drops its statistics
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "mongolite.h"
+#include "mongolite_internal.h"
+
+/* ============================================================
+ * Test Setup/Teardown
+ * ============================================================ */
+
+static mongolite_db_t *g_db = NULL;
+static const char *DB_PATH = "./test_analyze_db";
+
+#define N_DOCS 1000
+
+static void cleanup_db_path(void) {
+    char cmd[256];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", DB_PATH);
+    system(cmd);
+}
+
+static int open_db(void) {
+    gerror_t error = {0};
+    db_config_t config = {0};
+    config.max_bytes = 64ULL * 1024 * 1024;
+    return mongolite_open(DB_PATH, &g_db, &config, &error);
+}
+
+static void reopen_db(void) {
+    mongolite_close(g_db);
+    g_db = NULL;
+    assert_int_equal(0, open_db());
+}
+
+static int setup(void **state) {
+    (void)state;
+    cleanup_db_path();
+
+    gerror_t error = {0};
+    if (open_db() != 0) return -1;
+    return mongolite_collection_create(g_db, "users", NULL, &error);
+}
+
+static int teardown(void **state) {
+    (void)state;
+    if (g_db) {
+        mongolite_close(g_db);
+        g_db = NULL;
+    }
+    cleanup_db_path();
+    return 0;
+}
+
+/* Skewed data: 9 in 10 users are "US", the rest spread over 50
+ * countries; user_id = i */
+static void insert_users(int n) {
+    gerror_t error = {0};
+    bson_t **docs = calloc((size_t)n, sizeof(bson_t *));
+    for (int i = 0; i < n; i++) {
+        char country[16];
+        if (i % 10) {
+            snprintf(country, sizeof(country), "US");
+        } else {
+            snprintf(country, sizeof(country), "c%02d", (i / 10) % 50);
+        }
+        docs[i] = BCON_NEW("country", BCON_UTF8(country), "user_id", BCON_INT32(i),
+                           "pad", BCON_UTF8("xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx"));
+    }
+    assert_int_equal(0, mongolite_insert_many(g_db, "users", (const bson_t **)docs,
+                                              (size_t)n, NULL, &error));
+    for (int i = 0; i < n; i++) bson_destroy(docs[i]);
+    free(docs);
+}
+
+static void create_index(const char *field, const char *name) {
+    gerror_t error = {0};
+    bson_t *keys = BCON_NEW(field, BCON_INT32(1));
+    assert_int_equal(0, mongolite_create_index(g_db, "users", keys, name, NULL, &error));
+    bson_destroy(keys);
+}
+
+static mongolite_stats_t db_stats(void) {
+    gerror_t error = {0};
+    mongolite_stats_t stats;
+    assert_int_equal(MONGOLITE_OK, mongolite_stats(g_db, &stats, &error));
+    return stats;
+}
+
+static mongolite_index_stats_t index_stats(const char *name) {
+    gerror_t error = {0};
+    mongolite_index_stats_t stats;
+    assert_int_equal(MONGOLITE_OK, mongolite_index_stats(g_db, "users", name, &stats, &error));
+    return stats;
+}
+
+/* Documents matched by find */
+static int find_count(const bson_t *filter) {
+    gerror_t error = {0};
+    mongolite_cursor_t *cursor = mongolite_find(g_db, "users", filter, NULL, &error);
+    assert_non_null(cursor);
+
+    const bson_t *doc;
+    int count = 0;
+    while (mongolite_cursor_next(cursor, &doc)) count++;
+    mongolite_cursor_destroy(cursor);
+    return count;
+}
+
+/* ============================================================
+ * Tests
+ * ============================================================ */
+
+static void test_selective_index_chosen(void **state) {
+    (void)state;
+    insert_users(N_DOCS);
+    create_index("country", "by_country");
+    create_index("user_id", "by_user");
+
+    gerror_t error = {0};
+    bson_t *filter = BCON_NEW("country", BCON_UTF8("US"), "user_id", BCON_INT32(5));
+    query_analysis_t *analysis = _analyze_query_for_index(filter);
+    assert_non_null(analysis);
+
+    _mongolite_lock(g_db);
+    mongolite_cached_index_t *idx = _find_best_index(g_db, "users", analysis, &error);
+    assert_non_null(idx);
+    assert_string_equal("by_user", idx->name);
+    _mongolite_unlock(g_db);
+    _free_query_analysis(analysis);
+
+    /* One document read, not the 900 under "US" */
+    uint64_t before = db_stats().totals.docs_scanned;
+    bson_t *doc = mongolite_find_one(g_db, "users", filter, NULL, &error);
+    assert_non_null(doc);
+    bson_destroy(doc);
+    assert_int_equal(1, find_count(filter));
+    assert_true(db_stats().totals.docs_scanned - before <= 2);
+    bson_destroy(filter);
+}
+
+static void test_seek_path_by_estimate(void **state) {
+    (void)state;
+    insert_users(N_DOCS);
+    create_index("country", "by_country");
+    create_index("user_id", "by_user");
+
+    /* One "US" key holds more entries than five user_id keys */
+    bson_t *filter = BCON_NEW("country", BCON_UTF8("US"),
+                              "user_id", "{", "$in", "[", BCON_INT32(1), BCON_INT32(2),
+                              BCON_INT32(3), BCON_INT32(4), BCON_INT32(10), "]", "}");
+    uint64_t before = db_stats().totals.docs_scanned;
+    assert_int_equal(4, find_count(filter));
+    assert_true(db_stats().totals.docs_scanned - before <= 5);
+    bson_destroy(filter);
+
+    /* Two rare countries are cheaper than twenty user_ids */
+    bson_t *ids = bson_new();
+    bson_t in_doc, in_arr;
+    BSON_APPEND_DOCUMENT_BEGIN(ids, "user_id", &in_doc);
+    BSON_APPEND_ARRAY_BEGIN(&in_doc, "$in", &in_arr);
+    for (int i = 0; i < 20; i++) {
+        char key[16];
+        snprintf(key, sizeof(key), "%d", i);
+        BSON_APPEND_INT32(&in_arr, key, i * 10);
+    }
+    bson_append_array_end(&in_doc, &in_arr);
+    bson_append_document_end(ids, &in_doc);
+    filter = BCON_NEW("country", "{", "$in", "[", BCON_UTF8("c00"), BCON_UTF8("c01"), "]", "}");
+    bson_concat(filter, ids);
+    bson_destroy(ids);
+
+    /* c00 and c01 hold users 0, 500, 10 and 510; 0 and 10 are asked for */
+    before = db_stats().totals.docs_scanned;
+    assert_int_equal(2, find_count(filter));
+    assert_true(db_stats().totals.docs_scanned - before <= 4);
+    bson_destroy(filter);
+}
+
+static void test_index_stats(void **state) {
+    (void)state;
+    insert_users(N_DOCS);
+    create_index("country", "by_country");
+
+    mongolite_index_stats_t stats = index_stats("by_country");
+    assert_true(stats.analyzed);
+    assert_int_equal(N_DOCS, stats.entries);
+    assert_int_equal(51, stats.distinct_keys);
+    assert_true(stats.histogram_buckets > 1);
+
+    gerror_t error = {0};
+    assert_int_equal(MONGOLITE_ENOTFOUND,
+                     mongolite_index_stats(g_db, "users", "missing", &stats, &error));
+    assert_int_equal(MONGOLITE_ENOTFOUND,
+                     mongolite_index_stats(g_db, "missing", "by_country", &stats, &error));
+}
+
+static void test_refresh_after_growth(void **state) {
+    (void)state;
+    create_index("country", "by_country");
+    assert_int_equal(0, index_stats("by_country").entries);
+
+    uint64_t before = db_stats().index_analyses;
+    insert_users(2 * N_DOCS);
+
+    /* The commit that grew the index rebuilt its statistics */
+    uint64_t after = db_stats().index_analyses;
+    assert_true(after > before);
+    mongolite_index_stats_t stats = index_stats("by_country");
+    assert_int_equal(2 * N_DOCS, stats.entries);
+    assert_int_equal(51, stats.distinct_keys);
+
+    /* Planning does not rebuild them again */
+    bson_t *filter = BCON_NEW("country", BCON_UTF8("c07"));
+    assert_int_equal(4, find_count(filter));
+    bson_destroy(filter);
+    assert_int_equal(after, db_stats().index_analyses);
+
+    /* ...and they were persisted */
+    reopen_db();
+    assert_int_equal(2 * N_DOCS, index_stats("by_country").entries);
+}
+
+static void test_analyze_persists(void **state) {
+    (void)state;
+    gerror_t error = {0};
+    create_index("country", "by_country");
+    insert_users(N_DOCS);
+
+    assert_int_equal(MONGOLITE_OK, mongolite_analyze(g_db, "users", &error));
+    assert_int_equal(N_DOCS, index_stats("by_country").entries);
+
+    reopen_db();
+    mongolite_index_stats_t stats = index_stats("by_country");
+    assert_true(stats.analyzed);
+    assert_int_equal(N_DOCS, stats.entries);
+    assert_int_equal(51, stats.distinct_keys);
+
+    assert_int_equal(MONGOLITE_ENOTFOUND, mongolite_analyze(g_db, "missing", &error));
+}
+
+static void test_analyze_all(void **state) {
+    (void)state;
+    gerror_t error = {0};
+    assert_int_equal(0, mongolite_collection_create(g_db, "empty", NULL, &error));
+    create_index("user_id", "by_user");
+    insert_users(N_DOCS);
+
+    uint64_t before = db_stats().index_analyses;
+    assert_int_equal(MONGOLITE_OK, mongolite_analyze(g_db, NULL, &error));
+    assert_int_equal(before + 1, db_stats().index_analyses);
+
+    mongolite_index_stats_t stats = index_stats("by_user");
+    assert_int_equal(N_DOCS, stats.distinct_keys);
+}
+
+static void test_drop_index_drops_stats(void **state) {
+    (void)state;
+    gerror_t error = {0};
+    insert_users(N_DOCS);
+    create_index("country", "by_country");
+
+    assert_int_equal(0, mongolite_drop_index(g_db, "users", "by_country", &error));
+    mongolite_index_stats_t stats;
+    assert_int_equal(MONGOLITE_ENOTFOUND,
+                     mongolite_index_stats(g_db, "users", "by_country", &stats, &error));
+
+    /* Recreated under the same name: fresh statistics, also after reopen */
+    create_index("user_id", "by_country");
+    reopen_db();
+    assert_int_equal(N_DOCS, index_stats("by_country").distinct_keys);
+}
+
+/* ============================================================
+ * Test Runner
+ * ============================================================ */
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_selective_index_chosen, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_seek_path_by_estimate, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_index_stats, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_refresh_after_growth, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_analyze_persists, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_analyze_all, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_drop_index_drops_stats, setup, teardown),
+    };
+
+    return cmocka_run_group_tests_name("tests", tests, NULL, NULL);
+}
@@ -0,0 +1,323 @@
+/**
+ * test_mongolite_backup.c - Tests for hot backup and compaction
+ *
+ * Tests:
+ * - Backup while a cursor is open; the copy opens with the same documents
+ * - Compacting backup is smaller after deletes
+ * - Progress reaches the total; a callback can cancel (no file left)
+ * - max_bytes_per_sec paces the copy
+ * - Destination must not already hold a database
+ * - Compact in place keeps data and shrinks the file; EBUSY with a cursor
+ * - Compact with the ASYNC flusher running; it syncs the reopened file
+ * - A failed reopen leaves the handle closed: calls fail until close
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#include "mongolite.h"
+#include "mongolite_internal.h"
+
+/* ============================================================
+ * Test Setup/Teardown
+ * ============================================================ */
+
+static mongolite_db_t *g_db = NULL;
+static const char *DB_PATH = "./test_backup_db";
+static const char *COPY_PATH = "./test_backup_copy";
+
+static void cleanup_db_paths(void) {
+    char cmd[256];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s %s", DB_PATH, COPY_PATH);
+    system(cmd);
+}
+
+static int setup(void **state) {
+    (void)state;
+    cleanup_db_paths();
+
+    gerror_t error = {0};
+    db_config_t config = {0};
+    config.max_bytes = 64ULL * 1024 * 1024;
+    if (mongolite_open(DB_PATH, &g_db, &config, &error) != 0) return -1;
+    return mongolite_collection_create(g_db, "items", NULL, &error);
+}
+
+static int teardown(void **state) {
+    (void)state;
+    if (g_db) {
+        mongolite_close(g_db);
+        g_db = NULL;
+    }
+    cleanup_db_paths();
+    return 0;
+}
+
+static void insert_n(int n) {
+    gerror_t error = {0};
+    char pad[256];
+    memset(pad, 'x', sizeof(pad) - 1);
+    pad[sizeof(pad) - 1] = '\0';
+
+    for (int i = 0; i < n; i++) {
+        bson_t *doc = BCON_NEW("n", BCON_INT32(i), "pad", BCON_UTF8(pad));
+        assert_int_equal(0, mongolite_insert_one(g_db, "items", doc, NULL, &error));
+        bson_destroy(doc);
+    }
+}
+
+static void delete_below(int n) {
+    gerror_t error = {0};
+    bson_t *filter = BCON_NEW("n", "{", "$lt", BCON_INT32(n), "}");
+    assert_int_equal(0, mongolite_delete_many(g_db, "items", filter, NULL, &error));
+    bson_destroy(filter);
+}
+
+static int64_t file_size(const char *dir) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/data.mdb", dir);
+    struct stat st;
+    return stat(path, &st) == 0 ? (int64_t)st.st_size : -1;
+}
+
+static int64_t count_in(const char *dir) {
+    gerror_t error = {0};
+    mongolite_db_t *copy = NULL;
+    assert_int_equal(0, mongolite_open(dir, &copy, NULL, &error));
+    int64_t n = mongolite_collection_count(copy, "items", NULL, &error);
+    mongolite_close(copy);
+    return n;
+}
+
+typedef struct {
+    int calls;
+    uint64_t done;
+    uint64_t total;
+    int cancel_after;                   /* 0 = never */
+} progress_t;
+
+static int on_progress(uint64_t done, uint64_t total, void *ctx) {
+    progress_t *p = ctx;
+    p->calls++;
+    p->done = done;
+    p->total = total;
+    return (p->cancel_after > 0 && p->calls >= p->cancel_after) ? 1 : 0;
+}
+
+/* ============================================================
+ * Tests
+ * ============================================================ */
+
+static void test_backup_hot(void **state) {
+    (void)state;
+    gerror_t error = {0};
+    insert_n(200);
+
+    /* A reader on this thread does not block the copy */
+    mongolite_cursor_t *cursor = mongolite_find(g_db, "items", NULL, NULL, &error);
+    assert_non_null(cursor);
+    const bson_t *doc;
+    assert_true(mongolite_cursor_next(cursor, &doc));
+
+    assert_int_equal(MONGOLITE_OK, mongolite_backup(g_db, COPY_PATH, 0, NULL, &error));
+    mongolite_cursor_destroy(cursor);
+
+    /* Writes after the backup are not in it */
+    insert_n(10);
+    assert_int_equal(200, count_in(COPY_PATH));
+    assert_int_equal(210, mongolite_collection_count(g_db, "items", NULL, &error));
+}
+
+static void test_backup_compact_smaller(void **state) {
+    (void)state;
+    gerror_t error = {0};
+    insert_n(2000);
+    delete_below(1900);
+
+    assert_int_equal(MONGOLITE_OK, mongolite_backup(g_db, COPY_PATH, 0, NULL, &error));
+    int64_t plain = file_size(COPY_PATH);
+    system("rm -rf ./test_backup_copy");
+
+    assert_int_equal(MONGOLITE_OK, mongolite_backup(g_db, COPY_PATH,
+                                                    MONGOLITE_BACKUP_COMPACT, NULL, &error));
+    int64_t compact = file_size(COPY_PATH);
+
+    assert_true(compact > 0);
+    assert_true(compact < plain / 2);
+    assert_int_equal(100, count_in(COPY_PATH));
+}
+
+static void test_backup_progress_and_cancel(void **state) {
+    (void)state;
+    gerror_t error = {0};
+    insert_n(4000);
+
+    progress_t progress = {0};
+    mongolite_backup_opts_t opts = {.progress = on_progress, .progress_ctx = &progress};
+    assert_int_equal(MONGOLITE_OK, mongolite_backup(g_db, COPY_PATH, 0, &opts, &error));
+    assert_true(progress.calls >= 1);
+    assert_int_equal(progress.total, progress.done);
+    assert_int_equal(file_size(COPY_PATH), (int64_t)progress.done);
+    system("rm -rf ./test_backup_copy");
+
+    /* The first report cancels; the partial file is removed */
+    progress_t cancel = {.cancel_after = 1};
+    opts.progress_ctx = &cancel;
+    memset(&error, 0, sizeof(error));
+    assert_int_equal(MONGOLITE_ECANCELED, mongolite_backup(g_db, COPY_PATH, 0, &opts, &error));
+    assert_int_equal(MONGOLITE_ECANCELED, error.code);
+    assert_int_equal(-1, file_size(COPY_PATH));
+
+    /* The database is unaffected */
+    insert_n(1);
+    assert_int_equal(4001, mongolite_collection_count(g_db, "items", NULL, &error));
+}
+
+static void test_backup_throttled(void **state) {
+    (void)state;
+    gerror_t error = {0};
+    insert_n(1000);
+
+    progress_t progress = {0};
+    mongolite_backup_opts_t opts = {
+        .progress = on_progress,
+        .progress_ctx = &progress,
+        .max_bytes_per_sec = 2 * 1024 * 1024
+    };
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    assert_int_equal(MONGOLITE_OK, mongolite_backup(g_db, COPY_PATH, 0, &opts, &error));
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    double elapsed = (double)(t1.tv_sec - t0.tv_sec) + (double)(t1.tv_nsec - t0.tv_nsec) / 1e9;
+    double floor_s = (double)progress.done / (double)opts.max_bytes_per_sec;
+    assert_true(floor_s > 0.1);
+    assert_true(elapsed >= floor_s * 0.9);
+    assert_int_equal(1000, count_in(COPY_PATH));
+}
+
+static void test_backup_dest_in_use(void **state) {
+    (void)state;
+    gerror_t error = {0};
+    insert_n(5);
+
+    assert_int_equal(MONGOLITE_OK, mongolite_backup(g_db, COPY_PATH, 0, NULL, &error));
+    assert_int_not_equal(MONGOLITE_OK, mongolite_backup(g_db, COPY_PATH, 0, NULL, &error));
+    assert_int_equal(5, count_in(COPY_PATH));
+
+    /* Backing up into the live directory is refused the same way */
+    assert_int_not_equal(MONGOLITE_OK, mongolite_backup(g_db, DB_PATH, 0, NULL, &error));
+    assert_int_equal(5, mongolite_collection_count(g_db, "items", NULL, &error));
+}
+
+static void test_compact_in_place(void **state) {
+    (void)state;
+    gerror_t error = {0};
+    insert_n(2000);
+    delete_below(1900);
+
+    /* Not while a cursor holds a snapshot */
+    mongolite_cursor_t *cursor = mongolite_find(g_db, "items", NULL, NULL, &error);
+    assert_non_null(cursor);
+    assert_int_equal(MONGOLITE_EBUSY, mongolite_compact(g_db, &error));
+    mongolite_cursor_destroy(cursor);
+
+    int64_t before = file_size(DB_PATH);
+    uint64_t commit_before = mongolite_commit_id(g_db);
+    assert_int_equal(MONGOLITE_OK, mongolite_compact(g_db, &error));
+
+    assert_true(file_size(DB_PATH) < before / 2);
+    assert_true(mongolite_commit_id(g_db) < commit_before);
+    assert_int_equal(mongolite_commit_id(g_db), mongolite_durable_id(g_db));
+
+    /* Same handle keeps working */
+    assert_int_equal(100, mongolite_collection_count(g_db, "items", NULL, &error));
+    bson_t *filter = BCON_NEW("n", BCON_INT32(1950));
+    bson_t *found = mongolite_find_one(g_db, "items", filter, NULL, &error);
+    assert_non_null(found);
+    bson_destroy(found);
+    bson_destroy(filter);
+
+    insert_n(10);
+    assert_int_equal(110, mongolite_collection_count(g_db, "items", NULL, &error));
+
+    mongolite_close(g_db);
+    g_db = NULL;
+    assert_int_equal(110, count_in(DB_PATH));
+}
+
+static void test_compact_async_flusher(void **state) {
+    (void)state;
+    gerror_t error = {0};
+    mongolite_close(g_db);
+
+    db_config_t config = {0};
+    config.max_bytes = 64ULL * 1024 * 1024;
+    config.durability = MONGOLITE_DURABILITY_ASYNC;
+    config.sync_interval_ms = 5;
+    assert_int_equal(0, mongolite_open(DB_PATH, &g_db, &config, &error));
+
+    insert_n(500);
+    delete_below(400);
+    assert_int_equal(MONGOLITE_OK, mongolite_compact(g_db, &error));
+
+    /* The flusher runs again, against the new environment */
+    insert_n(10);
+    assert_int_equal(MONGOLITE_OK, mongolite_wait_durable(g_db, 0, 5000, &error));
+    assert_int_equal(mongolite_commit_id(g_db), mongolite_durable_id(g_db));
+    assert_int_equal(110, mongolite_collection_count(g_db, "items", NULL, &error));
+}
+
+static void test_compact_reopen_fails(void **state) {
+    (void)state;
+    gerror_t error = {0};
+    insert_n(200);
+    delete_below(150);
+
+    /* Flags LMDB refuses: the compacted file is in place, reopening fails */
+    unsigned int flags = g_db->lmdb_flags;
+    g_db->lmdb_flags |= MDB_REVERSEKEY;
+    assert_int_not_equal(MONGOLITE_OK, mongolite_compact(g_db, &error));
+    g_db->lmdb_flags = flags;
+
+    memset(&error, 0, sizeof(error));
+    assert_int_equal(-1, mongolite_collection_count(g_db, "items", NULL, &error));
+    assert_int_equal(MONGOLITE_EIO, error.code);
+    bson_t *doc = BCON_NEW("n", BCON_INT32(1));
+    assert_int_not_equal(0, mongolite_insert_one(g_db, "items", doc, NULL, &error));
+    bson_destroy(doc);
+    assert_null(mongolite_session_begin(g_db, MONGOLITE_SESSION_WRITE, &error));
+    assert_int_equal(MONGOLITE_EIO, mongolite_collection_create(g_db, "more", NULL, &error));
+    assert_int_equal(0, mongolite_commit_id(g_db));
+
+    mongolite_close(g_db);
+    g_db = NULL;
+    assert_int_equal(50, count_in(DB_PATH));
+}
+
+/* ============================================================
+ * Test Runner
+ * ============================================================ */
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_backup_hot, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_backup_compact_smaller, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_backup_progress_and_cancel, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_backup_throttled, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_backup_dest_in_use, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_compact_in_place, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_compact_async_flusher, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_compact_reopen_fails, setup, teardown),
+    };
+
+    return cmocka_run_group_tests_name("tests", tests, NULL, NULL);
+}
@@ -0,0 +1,366 @@
+/**
+ * test_mongolite_changes.c - Tests for the change feed
+ *
+ * Tests:
+ * - Off by default: no stream, last seq 0
+ * - Every write path records its change with the post-image
+ * - Rolled-back writes record nothing and give their seq back
+ * - Resume after a seq, also across reopen
+ * - A waiting stream wakes on a commit from another thread; poll and
+ *   timeout without one
+ * - Retention keeps the newest entries, a stream that fell behind gets
+ *   MONGOLITE_ETRUNCATED, truncate keeps the newest entry
+ * - The feed survives compaction
+ *
+ * Worker threads only record results; assertions run on the main thread.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "mongolite.h"
+#include "mongolite_internal.h"
+
+/* ============================================================
+ * Test Setup/Teardown
+ * ============================================================ */
+
+static mongolite_db_t *g_db = NULL;
+static const char *DB_PATH = "./test_changes_db";
+
+static void cleanup_db_path(void) {
+    char cmd[256];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", DB_PATH);
+    system(cmd);
+}
+
+static int open_db(bool feed, uint64_t max_entries) {
+    gerror_t error = {0};
+    db_config_t config = {0};
+    config.max_bytes = 64ULL * 1024 * 1024;
+    config.change_feed = feed;
+    config.change_feed_max_entries = max_entries;
+    return mongolite_open(DB_PATH, &g_db, &config, &error);
+}
+
+static void reopen_db(bool feed, uint64_t max_entries) {
+    mongolite_close(g_db);
+    g_db = NULL;
+    assert_int_equal(0, open_db(feed, max_entries));
+}
+
+static int setup(void **state) {
+    (void)state;
+    cleanup_db_path();
+
+    gerror_t error = {0};
+    if (open_db(true, 0) != 0) return -1;
+    return mongolite_collection_create(g_db, "users", NULL, &error);
+}
+
+static int teardown(void **state) {
+    (void)state;
+    if (g_db) {
+        mongolite_close(g_db);
+        g_db = NULL;
+    }
+    cleanup_db_path();
+    return 0;
+}
+
+static void insert_user(int n) {
+    gerror_t error = {0};
+    bson_t *doc = BCON_NEW("name", BCON_UTF8("user"), "n", BCON_INT32(n));
+    assert_int_equal(0, mongolite_insert_one(g_db, "users", doc, NULL, &error));
+    bson_destroy(doc);
+}
+
+static const bson_t* next_change(mongolite_change_stream_t *stream) {
+    gerror_t error = {0};
+    const bson_t *change = NULL;
+    assert_int_equal(MONGOLITE_OK, mongolite_change_stream_next(stream, &change, 0, &error));
+    assert_non_null(change);
+    return change;
+}
+
+static const char* change_op(const bson_t *change) {
+    bson_iter_t iter;
+    assert_true(bson_iter_init_find(&iter, change, "op"));
+    return bson_iter_utf8(&iter, NULL);
+}
+
+static int64_t change_seq(const bson_t *change) {
+    bson_iter_t iter;
+    assert_true(bson_iter_init_find(&iter, change, "seq"));
+    return bson_iter_int64(&iter);
+}
+
+/* doc.n of the post-image, -1 without one */
+static int32_t change_n(const bson_t *change) {
+    bson_iter_t iter, n;
+    if (!bson_iter_init(&iter, change) || !bson_iter_find_descendant(&iter, "doc.n", &n)) {
+        return -1;
+    }
+    return bson_iter_int32(&n);
+}
+
+static void assert_no_change(mongolite_change_stream_t *stream) {
+    gerror_t error = {0};
+    const bson_t *change = NULL;
+    assert_int_equal(MONGOLITE_ETIMEDOUT,
+                     mongolite_change_stream_next(stream, &change, 0, &error));
+    assert_null(change);
+}
+
+/* ============================================================
+ * Tests
+ * ============================================================ */
+
+static void test_disabled_by_default(void **state) {
+    (void)state;
+    reopen_db(false, 0);
+    insert_user(1);
+
+    gerror_t error = {0};
+    assert_null(mongolite_change_stream_open(g_db, 0, &error));
+    assert_int_equal(MONGOLITE_EINVAL, error.code);
+    assert_int_equal(0, mongolite_change_feed_last_seq(g_db));
+}
+
+static void test_write_paths(void **state) {
+    (void)state;
+    gerror_t error = {0};
+
+    bson_oid_t id;
+    bson_t *doc = BCON_NEW("n", BCON_INT32(1));
+    assert_int_equal(0, mongolite_insert_one(g_db, "users", doc, &id, &error));
+    bson_destroy(doc);
+
+    const bson_t *docs[2];
+    docs[0] = BCON_NEW("n", BCON_INT32(2));
+    docs[1] = BCON_NEW("n", BCON_INT32(3));
+    assert_int_equal(0, mongolite_insert_many(g_db, "users", docs, 2, NULL, &error));
+    bson_destroy((bson_t *)docs[0]);
+    bson_destroy((bson_t *)docs[1]);
+
+    bson_t *filter = BCON_NEW("_id", BCON_OID(&id));
+    bson_t *update = BCON_NEW("$set", "{", "n", BCON_INT32(10), "}");
+    assert_int_equal(0, mongolite_update_one(g_db, "users", filter, update, false, &error));
+    bson_destroy(update);
+
+    bson_t *replacement = BCON_NEW("n", BCON_INT32(20));
+    assert_int_equal(0, mongolite_replace_one(g_db, "users", filter, replacement, false, &error));
+    bson_destroy(replacement);
+
+    /* Matches nothing: no change */
+    bson_t *none = BCON_NEW("n", BCON_INT32(99));
+    update = BCON_NEW("$set", "{", "x", BCON_INT32(1), "}");
+    assert_int_equal(0, mongolite_update_one(g_db, "users", none, update, false, &error));
+    bson_destroy(none);
+
+    bson_t *ge2 = BCON_NEW("n", "{", "$in", "[", BCON_INT32(2), BCON_INT32(3), "]", "}");
+    int64_t modified = 0;
+    assert_int_equal(0, mongolite_update_many(g_db, "users", ge2, update, false, &modified, &error));
+    assert_int_equal(2, modified);
+    bson_destroy(update);
+
+    assert_int_equal(0, mongolite_delete_one(g_db, "users", filter, &error));
+    int64_t deleted = 0;
+    assert_int_equal(0, mongolite_delete_many(g_db, "users", ge2, &deleted, &error));
+    assert_int_equal(2, deleted);
+    bson_destroy(ge2);
+
+    mongolite_change_stream_t *stream = mongolite_change_stream_open(g_db, 0, &error);
+    assert_non_null(stream);
+
+    const bson_t *change = next_change(stream);
+    assert_string_equal("insert", change_op(change));
+    assert_int_equal(1, change_seq(change));
+    assert_int_equal(1, change_n(change));
+    bson_iter_t iter;
+    assert_true(bson_iter_init_find(&iter, change, "ns"));
+    assert_string_equal("users", bson_iter_utf8(&iter, NULL));
+    assert_true(bson_iter_init_find(&iter, change, "_id"));
+    assert_int_equal(0, bson_oid_compare(&id, bson_iter_oid(&iter)));
+
+    assert_string_equal("insert", change_op(next_change(stream)));
+    assert_string_equal("insert", change_op(next_change(stream)));
+
+    change = next_change(stream);
+    assert_string_equal("update", change_op(change));
+    assert_int_equal(10, change_n(change));
+
+    change = next_change(stream);
+    assert_string_equal("replace", change_op(change));
+    assert_int_equal(20, change_n(change));
+
+    assert_string_equal("update", change_op(next_change(stream)));
+    assert_string_equal("update", change_op(next_change(stream)));
+
+    change = next_change(stream);
+    assert_string_equal("delete", change_op(change));
+    assert_int_equal(-1, change_n(change));
+    assert_true(bson_iter_init_find(&iter, change, "_id"));
+    assert_int_equal(0, bson_oid_compare(&id, bson_iter_oid(&iter)));
+
+    assert_string_equal("delete", change_op(next_change(stream)));
+    change = next_change(stream);
+    assert_string_equal("delete", change_op(change));
+    assert_int_equal(10, change_seq(change));
+    assert_no_change(stream);
+
+    assert_int_equal(10, mongolite_change_stream_seq(stream));
+    assert_int_equal(10, mongolite_change_feed_last_seq(g_db));
+    mongolite_change_stream_close(stream);
+    bson_destroy(filter);
+}
+
+static void test_rollback_records_nothing(void **state) {
+    (void)state;
+    insert_user(1);
+
+    assert_int_equal(0, mongolite_begin_transaction(g_db));
+    insert_user(2);
+    insert_user(3);
+    assert_int_equal(0, mongolite_rollback(g_db));
+    assert_int_equal(1, mongolite_change_feed_last_seq(g_db));
+
+    /* The next write takes the seq the rolled-back ones gave back */
+    insert_user(4);
+    gerror_t error = {0};
+    mongolite_change_stream_t *stream = mongolite_change_stream_open(g_db, 1, &error);
+    const bson_t *change = next_change(stream);
+    assert_int_equal(2, change_seq(change));
+    assert_int_equal(4, change_n(change));
+    mongolite_change_stream_close(stream);
+}
+
+static void test_resume(void **state) {
+    (void)state;
+    gerror_t error = {0};
+    for (int i = 1; i <= 5; i++) insert_user(i);
+
+    mongolite_change_stream_t *stream = mongolite_change_stream_open(g_db, 0, &error);
+    next_change(stream);
+    next_change(stream);
+    uint64_t resume = mongolite_change_stream_seq(stream);
+    assert_int_equal(2, resume);
+    mongolite_change_stream_close(stream);
+
+    reopen_db(true, 0);
+    insert_user(6);
+
+    stream = mongolite_change_stream_open(g_db, resume, &error);
+    assert_non_null(stream);
+    for (int i = 3; i <= 6; i++) {
+        const bson_t *change = next_change(stream);
+        assert_int_equal(i, change_seq(change));
+        assert_int_equal(i, change_n(change));
+    }
+    assert_no_change(stream);
+    mongolite_change_stream_close(stream);
+}
+
+static void* delayed_insert_thread(void *arg) {
+    (void)arg;
+    usleep(100 * 1000);
+    gerror_t error = {0};
+    bson_t *doc = BCON_NEW("n", BCON_INT32(42));
+    mongolite_insert_one(g_db, "users", doc, NULL, &error);
+    bson_destroy(doc);
+    return NULL;
+}
+
+static void test_wait_for_commit(void **state) {
+    (void)state;
+    gerror_t error = {0};
+    mongolite_change_stream_t *stream = mongolite_change_stream_open(g_db, 0, &error);
+    assert_non_null(stream);
+
+    /* Poll and a short timeout, nothing committed */
+    assert_no_change(stream);
+    const bson_t *change = NULL;
+    assert_int_equal(MONGOLITE_ETIMEDOUT,
+                     mongolite_change_stream_next(stream, &change, 50, &error));
+
+    pthread_t tid;
+    pthread_create(&tid, NULL, delayed_insert_thread, NULL);
+    int rc = mongolite_change_stream_next(stream, &change, 10000, &error);
+    pthread_join(tid, NULL);
+
+    assert_int_equal(MONGOLITE_OK, rc);
+    assert_int_equal(42, change_n(change));
+    mongolite_change_stream_close(stream);
+}
+
+static void test_retention_and_truncate(void **state) {
+    (void)state;
+    reopen_db(true, 10);
+    for (int i = 1; i <= 50; i++) insert_user(i);
+    assert_int_equal(50, mongolite_change_feed_last_seq(g_db));
+
+    gerror_t error = {0};
+    mongolite_change_stream_t *stream = mongolite_change_stream_open(g_db, 0, &error);
+    const bson_t *change = next_change(stream);
+    assert_int_equal(41, change_seq(change));
+    mongolite_change_stream_close(stream);
+
+    /* Resuming before the oldest kept entry lost changes */
+    stream = mongolite_change_stream_open(g_db, 5, &error);
+    assert_int_equal(MONGOLITE_ETRUNCATED,
+                     mongolite_change_stream_next(stream, &change, 0, &error));
+    mongolite_change_stream_close(stream);
+    /* Right before it did not */
+    stream = mongolite_change_stream_open(g_db, 40, &error);
+    assert_int_equal(41, change_seq(next_change(stream)));
+    mongolite_change_stream_close(stream);
+
+    /* Truncating past the end keeps the newest, and the seq goes on */
+    assert_int_equal(0, mongolite_change_feed_truncate(g_db, 1000, &error));
+    stream = mongolite_change_stream_open(g_db, 0, &error);
+    assert_int_equal(50, change_seq(next_change(stream)));
+    assert_no_change(stream);
+    mongolite_change_stream_close(stream);
+
+    reopen_db(true, 0);
+    insert_user(51);
+    assert_int_equal(51, mongolite_change_feed_last_seq(g_db));
+}
+
+static void test_survives_compact(void **state) {
+    (void)state;
+    gerror_t error = {0};
+    for (int i = 1; i <= 3; i++) insert_user(i);
+    assert_int_equal(0, mongolite_compact(g_db, &error));
+    insert_user(4);
+
+    mongolite_change_stream_t *stream = mongolite_change_stream_open(g_db, 2, &error);
+    assert_int_equal(3, change_seq(next_change(stream)));
+    assert_int_equal(4, change_n(next_change(stream)));
+    mongolite_change_stream_close(stream);
+}
+
+/* ============================================================
+ * Test Runner
+ * ============================================================ */
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_disabled_by_default, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_write_paths, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_rollback_records_nothing, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_resume, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_wait_for_commit, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_retention_and_truncate, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_survives_compact, setup, teardown),
+    };
+
+    return cmocka_run_group_tests_name("tests", tests, NULL, NULL);
+}
@@ -188,6 +188,115 @@ static void test_collection_persistence(void **state) {
     }
 }
 
+static void test_collection_cache_many(void **state) {
+    (void)state;
+    mongolite_db_t *db = NULL;
+    gerror_t error = {0};
+
+    db_config_t config = {0};
+    config.max_bytes = 32ULL * 1024 * 1024;
+    config.max_dbs = 512;
+    int rc = mongolite_open(TEST_DB_PATH, &db, &config, &error);
+    assert_int_equal(0, rc);
+
+    /* Enough collections to force several cache rehashes */
+    char name[32];
+    for (int i = 0; i < 200; i++) {
+        snprintf(name, sizeof(name), "col_%d", i);
+        rc = mongolite_collection_create(db, name, NULL, &error);
+        assert_int_equal(0, rc);
+    }
+    assert_int_equal(200, db->tree_cache_count);
+
+    /* Drop every third collection (exercises backward-shift deletion) */
+    for (int i = 0; i < 200; i += 3) {
+        snprintf(name, sizeof(name), "col_%d", i);
+        rc = mongolite_collection_drop(db, name, &error);
+        assert_int_equal(0, rc);
+    }
+
+    for (int i = 0; i < 200; i++) {
+        snprintf(name, sizeof(name), "col_%d", i);
+        if (i % 3 == 0) {
+            assert_null(_mongolite_tree_cache_get(db, name));
+            assert_false(mongolite_collection_exists(db, name, NULL));
+        } else {
+            assert_non_null(_mongolite_tree_cache_get(db, name));
+        }
+    }
+
+    mongolite_close(db);
+}
+
+static void test_collection_handle(void **state) {
+    (void)state;
+    mongolite_db_t *db = NULL;
+    gerror_t error = {0};
+
+    db_config_t config = {0};
+    config.max_bytes = 32ULL * 1024 * 1024;
+    int rc = mongolite_open(TEST_DB_PATH, &db, &config, &error);
+    assert_int_equal(0, rc);
+
+    /* Missing collection is reported at open time */
+    assert_null(mongolite_collection_open(db, "missing", &error));
+    assert_int_equal(MONGOLITE_ENOTFOUND, error.code);
+
+    rc = mongolite_collection_create(db, "users", NULL, &error);
+    assert_int_equal(0, rc);
+
+    mongolite_collection_t *col = mongolite_collection_open(db, "users", &error);
+    assert_non_null(col);
+    assert_string_equal("users", mongolite_collection_name(col));
+
+    bson_oid_t id;
+    bson_t *doc = BCON_NEW("name", BCON_UTF8("alice"), "age", BCON_INT32(30));
+    rc = mongolite_col_insert_one(col, doc, &id, &error);
+    assert_int_equal(0, rc);
+    bson_destroy(doc);
+
+    doc = BCON_NEW("name", BCON_UTF8("bob"), "age", BCON_INT32(40));
+    rc = mongolite_col_insert_one(col, doc, NULL, &error);
+    assert_int_equal(0, rc);
+    bson_destroy(doc);
+
+    assert_int_equal(2, mongolite_col_count(col, NULL, &error));
+
+    bson_t *filter = BCON_NEW("name", BCON_UTF8("bob"));
+    assert_int_equal(1, mongolite_col_count(col, filter, &error));
+    bson_t *found = mongolite_col_find_one(col, filter, NULL, &error);
+    assert_non_null(found);
+    bson_destroy(found);
+    bson_destroy(filter);
+
+    /* Visible through the name-based API as well */
+    filter = BCON_NEW("_id", BCON_OID(&id));
+    found = mongolite_find_one(db, "users", filter, NULL, &error);
+    assert_non_null(found);
+    bson_destroy(found);
+    bson_destroy(filter);
+
+    mongolite_cursor_t *cursor = mongolite_col_find(col, NULL, NULL, &error);
+    assert_non_null(cursor);
+    int n = 0;
+    const bson_t *d;
+    while (mongolite_cursor_next(cursor, &d)) n++;
+    assert_int_equal(2, n);
+    mongolite_cursor_destroy(cursor);
+
+    /* Drop invalidates the resolved entry; re-create is picked up */
+    rc = mongolite_collection_drop(db, "users", &error);
+    assert_int_equal(0, rc);
+    assert_int_equal(-1, mongolite_col_count(col, NULL, &error));
+
+    rc = mongolite_collection_create(db, "users", NULL, &error);
+    assert_int_equal(0, rc);
+    assert_int_equal(0, mongolite_col_count(col, NULL, &error));
+
+    mongolite_collection_close(col);
+    mongolite_close(db);
+}
+
 int main(void) {
     const struct CMUnitTest tests[] = {
         cmocka_unit_test_setup_teardown(test_collection_create, setup, teardown),
@@ -198,6 +307,8 @@ int main(void) {
         cmocka_unit_test_setup_teardown(test_collection_count_empty, setup, teardown),
         /* test_collection_metadata removed - schema/metadata eliminated */
         cmocka_unit_test_setup_teardown(test_collection_persistence, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_collection_cache_many, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_collection_handle, setup, teardown),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
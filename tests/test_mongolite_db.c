@@ -287,6 +287,175 @@ static void test_changes_counter(void **state) {
     mongolite_close(db);
 }
 
+/* ============================================================
+ * Map growth
+ * ============================================================ */
+
+#define SMALL_MAP (1024ULL * 1024)
+
+static bson_t* padded_doc(int n) {
+    char pad[1024];
+    memset(pad, 'x', sizeof(pad) - 1);
+    pad[sizeof(pad) - 1] = '\0';
+    return BCON_NEW("n", BCON_INT32(n), "pad", BCON_UTF8(pad));
+}
+
+static mongolite_stats_t map_stats(mongolite_db_t *db) {
+    gerror_t error = {0};
+    mongolite_stats_t stats;
+    assert_int_equal(0, mongolite_stats(db, &stats, &error));
+    return stats;
+}
+
+static void test_map_grows_ahead(void **state) {
+    (void)state;
+    mongolite_db_t *db = NULL;
+    gerror_t error = {0};
+
+    db_config_t config = {0};
+    config.max_bytes = SMALL_MAP;
+    assert_int_equal(0, mongolite_open(TEST_DB_PATH, &db, &config, &error));
+    assert_int_equal(0, mongolite_collection_create(db, "grow", NULL, &error));
+
+    /* ~3x the initial map, one auto-commit insert at a time */
+    for (int i = 0; i < 3000; i++) {
+        bson_t *doc = padded_doc(i);
+        assert_int_equal(0, mongolite_insert_one(db, "grow", doc, NULL, &error));
+        bson_destroy(doc);
+    }
+
+    mongolite_stats_t stats = map_stats(db);
+    assert_true(stats.map_grows > 0);
+    assert_int_equal(0, stats.resizes);
+    assert_int_equal(0, stats.map_full_replays);
+    assert_true(db->max_bytes > SMALL_MAP);
+    assert_int_equal(3000, mongolite_collection_count(db, "grow", NULL, &error));
+
+    mongolite_close(db);
+}
+
+static void test_map_batch_reserve(void **state) {
+    (void)state;
+    mongolite_db_t *db = NULL;
+    gerror_t error = {0};
+
+    db_config_t config = {0};
+    config.max_bytes = SMALL_MAP;
+    config.map_growth_step = 256 * 1024;
+    assert_int_equal(0, mongolite_open(TEST_DB_PATH, &db, &config, &error));
+    assert_int_equal(0, mongolite_collection_create(db, "batch", NULL, &error));
+
+    enum { N = 4000 };
+    bson_t **docs = calloc(N, sizeof(bson_t *));
+    for (int i = 0; i < N; i++) docs[i] = padded_doc(i);
+
+    /* Sized up front: the batch is never replayed after MAP_FULL */
+    assert_int_equal(0, mongolite_insert_many(db, "batch", (const bson_t **)docs, N,
+                                              NULL, &error));
+    for (int i = 0; i < N; i++) bson_destroy(docs[i]);
+    free(docs);
+
+    mongolite_stats_t stats = map_stats(db);
+    assert_int_equal(0, stats.resizes);
+    assert_int_equal(0, stats.map_full_replays);
+    assert_true(stats.map_grows >= 1);
+    assert_int_equal(N, mongolite_collection_count(db, "batch", NULL, &error));
+
+    mongolite_close(db);
+}
+
+static void test_map_full_replay(void **state) {
+    (void)state;
+    mongolite_db_t *db = NULL;
+    gerror_t error = {0};
+
+    /* Grow only when full: every growth is a MAP_FULL replay */
+    db_config_t config = {0};
+    config.max_bytes = SMALL_MAP;
+    config.map_grow_at_percent = 100;
+    assert_int_equal(0, mongolite_open(TEST_DB_PATH, &db, &config, &error));
+    assert_int_equal(0, mongolite_collection_create(db, "replay", NULL, &error));
+
+    for (int i = 0; i < 3000; i++) {
+        bson_t *doc = padded_doc(i);
+        assert_int_equal(0, mongolite_insert_one(db, "replay", doc, NULL, &error));
+        bson_destroy(doc);
+    }
+
+    mongolite_stats_t stats = map_stats(db);
+    assert_true(stats.map_full_replays > 0);
+    assert_int_equal(stats.resizes, stats.map_full_replays);
+    assert_int_equal(3000, mongolite_collection_count(db, "replay", NULL, &error));
+
+    mongolite_close(db);
+}
+
+static void test_map_cap(void **state) {
+    (void)state;
+    mongolite_db_t *db = NULL;
+    gerror_t error = {0};
+
+    db_config_t config = {0};
+    config.max_bytes = SMALL_MAP;
+    config.map_max_bytes = 2 * SMALL_MAP;
+    assert_int_equal(0, mongolite_open(TEST_DB_PATH, &db, &config, &error));
+    assert_int_equal(0, mongolite_collection_create(db, "cap", NULL, &error));
+
+    int rc = 0;
+    for (int i = 0; i < 5000 && rc == 0; i++) {
+        bson_t *doc = padded_doc(i);
+        rc = mongolite_insert_one(db, "cap", doc, NULL, &error);
+        bson_destroy(doc);
+    }
+
+    assert_int_not_equal(0, rc);
+    assert_int_equal(2 * SMALL_MAP, db->max_bytes);
+
+    mongolite_close(db);
+}
+
+typedef struct {
+    int calls;
+    int full_calls;
+} growth_hook_t;
+
+static size_t growth_hook(const mongolite_map_usage_t *usage, void *ctx) {
+    growth_hook_t *hook = ctx;
+    hook->calls++;
+    if (usage->map_full) hook->full_calls++;
+
+    /* Keep 512KB free */
+    if (usage->map_size - usage->used_bytes >= 512 * 1024) return 0;
+    return usage->map_size + SMALL_MAP;
+}
+
+static void test_map_growth_hook(void **state) {
+    (void)state;
+    mongolite_db_t *db = NULL;
+    gerror_t error = {0};
+    growth_hook_t hook = {0};
+
+    db_config_t config = {0};
+    config.max_bytes = SMALL_MAP;
+    config.map_growth_fn = growth_hook;
+    config.map_growth_ctx = &hook;
+    assert_int_equal(0, mongolite_open(TEST_DB_PATH, &db, &config, &error));
+    assert_int_equal(0, mongolite_collection_create(db, "hook", NULL, &error));
+
+    for (int i = 0; i < 2000; i++) {
+        bson_t *doc = padded_doc(i);
+        assert_int_equal(0, mongolite_insert_one(db, "hook", doc, NULL, &error));
+        bson_destroy(doc);
+    }
+
+    assert_true(hook.calls >= 2000);
+    assert_int_equal(0, hook.full_calls);
+    assert_int_equal(0, (int)(db->max_bytes % SMALL_MAP));
+    assert_true(db->max_bytes > SMALL_MAP);
+
+    mongolite_close(db);
+}
+
 int main(void) {
     const struct CMUnitTest tests[] = {
         cmocka_unit_test_setup_teardown(test_open_close, setup, teardown),
@@ -302,6 +471,11 @@ int main(void) {
         cmocka_unit_test_setup_teardown(test_last_insert_rowid, setup, teardown),
         /* test_set_metadata removed - schema system eliminated */
         cmocka_unit_test_setup_teardown(test_changes_counter, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_map_grows_ahead, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_map_batch_reserve, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_map_full_replay, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_map_cap, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_map_growth_hook, setup, teardown),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
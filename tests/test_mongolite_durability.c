@@ -0,0 +1,244 @@
+/**
+ * test_mongolite_durability.c - Tests for durability levels
+ *
+ * Tests:
+ * - FULL: every commit is durable when it returns
+ * - ASYNC: the flusher catches up within the interval
+ * - ASYNC: sync_bytes wakes the flusher before a long interval
+ * - ASYNC: concurrent waiters share the flusher's syncs
+ * - NONE: durable id stays behind until wait_durable / mongolite_sync
+ * - Data committed under NONE survives close and reopen
+ *
+ * Worker threads only record results; assertions run on the main thread.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "mongolite.h"
+#include "mongolite_internal.h"
+
+/* ============================================================
+ * Test Setup/Teardown
+ * ============================================================ */
+
+static mongolite_db_t *g_db = NULL;
+static const char *DB_PATH = "./test_durability_db";
+
+static void cleanup_db_path(void) {
+    char cmd[256];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", DB_PATH);
+    system(cmd);
+}
+
+static int open_db(mongolite_durability_t durability, unsigned int interval_ms,
+                   size_t sync_bytes) {
+    gerror_t error = {0};
+    db_config_t config = {0};
+    config.max_bytes = 64ULL * 1024 * 1024;
+    config.durability = durability;
+    config.sync_interval_ms = interval_ms;
+    config.sync_bytes = sync_bytes;
+    int rc = mongolite_open(DB_PATH, &g_db, &config, &error);
+    if (rc != 0) return rc;
+    return mongolite_collection_create(g_db, "items", NULL, &error);
+}
+
+static int setup(void **state) {
+    (void)state;
+    cleanup_db_path();
+    return 0;
+}
+
+static int teardown(void **state) {
+    (void)state;
+    if (g_db) {
+        mongolite_close(g_db);
+        g_db = NULL;
+    }
+    cleanup_db_path();
+    return 0;
+}
+
+static int insert_n(int n) {
+    gerror_t error = {0};
+    for (int i = 0; i < n; i++) {
+        bson_t *doc = BCON_NEW("n", BCON_INT32(i), "pad",
+                               BCON_UTF8("0123456789012345678901234567890123456789"));
+        int rc = mongolite_insert_one(g_db, "items", doc, NULL, &error);
+        bson_destroy(doc);
+        if (rc != 0) return rc;
+    }
+    return 0;
+}
+
+static uint64_t db_syncs(void) {
+    gerror_t error = {0};
+    mongolite_stats_t stats;
+    assert_int_equal(MONGOLITE_OK, mongolite_stats(g_db, &stats, &error));
+    return stats.syncs;
+}
+
+/* Poll (the flusher is asynchronous) for up to timeout_ms */
+static bool durable_within(uint64_t commit_id, int timeout_ms) {
+    for (int waited = 0; waited <= timeout_ms; waited += 5) {
+        if (mongolite_durable_id(g_db) >= commit_id) return true;
+        struct timespec ts = {0, 5 * 1000000L};
+        nanosleep(&ts, NULL);
+    }
+    return false;
+}
+
+/* ============================================================
+ * Tests
+ * ============================================================ */
+
+static void test_full_always_durable(void **state) {
+    (void)state;
+    gerror_t error = {0};
+    assert_int_equal(0, open_db(MONGOLITE_DURABILITY_FULL, 0, 0));
+
+    uint64_t before = mongolite_commit_id(g_db);
+    assert_int_equal(0, insert_n(5));
+    uint64_t id = mongolite_commit_id(g_db);
+    assert_true(id >= before + 5);
+    assert_int_equal(id, mongolite_durable_id(g_db));
+
+    assert_int_equal(MONGOLITE_OK, mongolite_wait_durable(g_db, id, 0, &error));
+    assert_int_equal(0, db_syncs());
+}
+
+static void test_async_interval(void **state) {
+    (void)state;
+    gerror_t error = {0};
+    assert_int_equal(0, open_db(MONGOLITE_DURABILITY_ASYNC, 10, 0));
+
+    assert_int_equal(0, insert_n(20));
+    uint64_t id = mongolite_commit_id(g_db);
+    assert_true(durable_within(id, 2000));
+    assert_true(db_syncs() >= 1);
+
+    /* Ids past the latest commit are rejected */
+    assert_int_equal(MONGOLITE_EINVAL, mongolite_wait_durable(g_db, id + 100, 0, &error));
+}
+
+static void test_async_sync_bytes(void **state) {
+    (void)state;
+    gerror_t error = {0};
+
+    /* The interval alone would not sync during the test */
+    assert_int_equal(0, open_db(MONGOLITE_DURABILITY_ASYNC, 60000, 1024));
+    uint64_t start = mongolite_durable_id(g_db);
+
+    assert_int_equal(0, insert_n(1));
+    uint64_t small = mongolite_commit_id(g_db);
+    assert_int_equal(start, mongolite_durable_id(g_db));
+
+    assert_int_equal(0, insert_n(40));
+    uint64_t id = mongolite_commit_id(g_db);
+    assert_true(id > small);
+    assert_true(durable_within(small, 2000));
+
+    /* An explicit wait syncs right away */
+    assert_int_equal(MONGOLITE_OK, mongolite_wait_durable(g_db, 0, 5000, &error));
+    assert_true(mongolite_durable_id(g_db) >= id);
+}
+
+typedef struct {
+    uint64_t commit_id;
+    int rc;
+} waiter_t;
+
+static void* waiter_thread(void *arg) {
+    waiter_t *w = arg;
+    gerror_t error = {0};
+    w->rc = mongolite_wait_durable(g_db, w->commit_id, -1, &error);
+    return NULL;
+}
+
+static void test_async_concurrent_waiters(void **state) {
+    (void)state;
+    enum { WAITERS = 6 };
+    assert_int_equal(0, open_db(MONGOLITE_DURABILITY_ASYNC, 60000, 0));
+
+    assert_int_equal(0, insert_n(10));
+    uint64_t id = mongolite_commit_id(g_db);
+    assert_true(mongolite_durable_id(g_db) < id);
+
+    pthread_t tids[WAITERS];
+    waiter_t waiters[WAITERS];
+    for (int i = 0; i < WAITERS; i++) {
+        waiters[i].commit_id = id;
+        waiters[i].rc = -1;
+        pthread_create(&tids[i], NULL, waiter_thread, &waiters[i]);
+    }
+    for (int i = 0; i < WAITERS; i++) {
+        pthread_join(tids[i], NULL);
+        assert_int_equal(MONGOLITE_OK, waiters[i].rc);
+    }
+    assert_true(mongolite_durable_id(g_db) >= id);
+    assert_true(db_syncs() <= WAITERS);
+}
+
+static void test_none_explicit_sync(void **state) {
+    (void)state;
+    gerror_t error = {0};
+    assert_int_equal(0, open_db(MONGOLITE_DURABILITY_NONE, 0, 0));
+    uint64_t start = mongolite_durable_id(g_db);
+
+    assert_int_equal(0, insert_n(5));
+    uint64_t first = mongolite_commit_id(g_db);
+    assert_true(first > start);
+    assert_int_equal(start, mongolite_durable_id(g_db));
+
+    assert_int_equal(MONGOLITE_OK, mongolite_wait_durable(g_db, first, 0, &error));
+    assert_int_equal(first, mongolite_durable_id(g_db));
+
+    assert_int_equal(0, insert_n(5));
+    uint64_t second = mongolite_commit_id(g_db);
+    assert_int_equal(first, mongolite_durable_id(g_db));
+
+    assert_int_equal(MONGOLITE_OK, mongolite_sync(g_db, true, &error));
+    assert_int_equal(second, mongolite_durable_id(g_db));
+    assert_int_equal(2, db_syncs());
+}
+
+static void test_none_survives_reopen(void **state) {
+    (void)state;
+    gerror_t error = {0};
+    assert_int_equal(0, open_db(MONGOLITE_DURABILITY_NONE, 0, 0));
+    assert_int_equal(0, insert_n(25));
+
+    /* Close syncs what was left */
+    mongolite_close(g_db);
+    g_db = NULL;
+
+    db_config_t config = {0};
+    config.max_bytes = 64ULL * 1024 * 1024;
+    assert_int_equal(0, mongolite_open(DB_PATH, &g_db, &config, &error));
+    assert_int_equal(25, mongolite_collection_count(g_db, "items", NULL, &error));
+    assert_int_equal(mongolite_commit_id(g_db), mongolite_durable_id(g_db));
+}
+
+/* ============================================================
+ * Test Runner
+ * ============================================================ */
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_full_always_durable, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_async_interval, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_async_sync_bytes, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_async_concurrent_waiters, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_none_explicit_sync, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_none_survives_reopen, setup, teardown),
+    };
+
+    return cmocka_run_group_tests_name("tests", tests, NULL, NULL);
+}
@@ -0,0 +1,302 @@
+/**
+ * test_mongolite_explain.c - Tests for mongolite_explain
+ *
+ * Tests:
+ * - Unindexed filter: COLLSCAN, every document examined, no keys
+ * - _id equality and _id $in: FETCH over ID_LOOKUP
+ * - Indexed equality: FETCH over IXSCAN with its bounds; the other index
+ *   is listed as a rejected candidate
+ * - $or over two indexes: OR stage; intersection: AND_SORTED stage
+ * - Second explain of a shape comes from the plan cache
+ * - Sort and projection are reported; missing collection is an error
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "mongolite.h"
+#include "mongolite_internal.h"
+
+/* ============================================================
+ * Test Setup/Teardown
+ * ============================================================ */
+
+static mongolite_db_t *g_db = NULL;
+static const char *DB_PATH = "./test_explain_db";
+
+#define N_DOCS 300
+static bson_oid_t g_ids[N_DOCS];
+
+static void cleanup_db_path(void) {
+    char cmd[256];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", DB_PATH);
+    system(cmd);
+}
+
+static int setup(void **state) {
+    (void)state;
+    cleanup_db_path();
+
+    gerror_t error = {0};
+    db_config_t config = {0};
+    config.max_bytes = 64ULL * 1024 * 1024;
+    if (mongolite_open(DB_PATH, &g_db, &config, &error) != 0) return -1;
+    if (mongolite_collection_create(g_db, "items", NULL, &error) != 0) return -1;
+
+    /* n = i, grp = i % 3, tag = i % 100 */
+    for (int i = 0; i < N_DOCS; i++) {
+        bson_t *doc = BCON_NEW("n", BCON_INT32(i), "grp", BCON_INT32(i % 3),
+                               "tag", BCON_INT32(i % 100));
+        int rc = mongolite_insert_one(g_db, "items", doc, &g_ids[i], &error);
+        bson_destroy(doc);
+        if (rc != 0) return -1;
+    }
+    return 0;
+}
+
+static int teardown(void **state) {
+    (void)state;
+    if (g_db) {
+        mongolite_close(g_db);
+        g_db = NULL;
+    }
+    cleanup_db_path();
+    return 0;
+}
+
+static void create_index(const char *field, const char *name) {
+    gerror_t error = {0};
+    bson_t *keys = BCON_NEW(field, BCON_INT32(1));
+    assert_int_equal(0, mongolite_create_index(g_db, "items", keys, name, NULL, &error));
+    bson_destroy(keys);
+}
+
+static bson_t* explain(const bson_t *filter) {
+    gerror_t error = {0};
+    bson_t *report = mongolite_explain(g_db, "items", filter, NULL, NULL, &error);
+    assert_non_null(report);
+    return report;
+}
+
+static int64_t get_int(const bson_t *report, const char *path) {
+    bson_iter_t it, found;
+    assert_true(bson_iter_init(&it, report));
+    assert_true(bson_iter_find_descendant(&it, path, &found));
+    return bson_iter_as_int64(&found);
+}
+
+static const char* get_str(const bson_t *report, const char *path) {
+    bson_iter_t it, found;
+    assert_true(bson_iter_init(&it, report));
+    assert_true(bson_iter_find_descendant(&it, path, &found));
+    assert_true(BSON_ITER_HOLDS_UTF8(&found));
+    return bson_iter_utf8(&found, NULL);
+}
+
+static bool has_path(const bson_t *report, const char *path) {
+    bson_iter_t it, found;
+    assert_true(bson_iter_init(&it, report));
+    return bson_iter_find_descendant(&it, path, &found);
+}
+
+static bool get_bool(const bson_t *report, const char *path) {
+    bson_iter_t it, found;
+    assert_true(bson_iter_init(&it, report));
+    assert_true(bson_iter_find_descendant(&it, path, &found));
+    return bson_iter_as_bool(&found);
+}
+
+/* ============================================================
+ * Tests
+ * ============================================================ */
+
+static void test_explain_collscan(void **state) {
+    (void)state;
+    bson_t *filter = BCON_NEW("grp", BCON_INT32(1));
+    bson_t *report = explain(filter);
+    bson_destroy(filter);
+
+    assert_string_equal("items", get_str(report, "queryPlanner.namespace"));
+    assert_string_equal("COLLSCAN", get_str(report, "queryPlanner.winningPlan.stage"));
+    assert_true(has_path(report, "queryPlanner.winningPlan.filter.grp"));
+    assert_int_equal(100, get_int(report, "executionStats.nReturned"));
+    assert_int_equal(N_DOCS, get_int(report, "executionStats.docsExamined"));
+    assert_int_equal(0, get_int(report, "executionStats.keysExamined"));
+    assert_true(get_int(report, "executionStats.executionTimeMicros") >= 0);
+    bson_destroy(report);
+}
+
+static void test_explain_id(void **state) {
+    (void)state;
+    bson_t *filter = BCON_NEW("_id", BCON_OID(&g_ids[7]));
+    bson_t *report = explain(filter);
+    bson_destroy(filter);
+
+    assert_string_equal("FETCH", get_str(report, "queryPlanner.winningPlan.stage"));
+    assert_string_equal("ID_LOOKUP",
+                        get_str(report, "queryPlanner.winningPlan.inputStage.stage"));
+    assert_false(has_path(report, "queryPlanner.winningPlan.filter"));
+    assert_int_equal(1, get_int(report, "executionStats.nReturned"));
+    assert_int_equal(1, get_int(report, "executionStats.keysExamined"));
+    assert_int_equal(1, get_int(report, "executionStats.docsExamined"));
+    bson_destroy(report);
+
+    /* $in on _id with another predicate left to the matcher */
+    filter = BCON_NEW("_id", "{", "$in", "[", BCON_OID(&g_ids[1]), BCON_OID(&g_ids[2]),
+                      BCON_OID(&g_ids[4]), "]", "}", "grp", BCON_INT32(1));
+    report = explain(filter);
+    bson_destroy(filter);
+
+    assert_string_equal("ID_LOOKUP",
+                        get_str(report, "queryPlanner.winningPlan.inputStage.stage"));
+    assert_int_equal(3, get_int(report, "queryPlanner.winningPlan.inputStage.seeks"));
+    assert_true(has_path(report, "queryPlanner.winningPlan.filter"));
+    assert_int_equal(2, get_int(report, "executionStats.nReturned"));
+    assert_int_equal(3, get_int(report, "executionStats.keysExamined"));
+    assert_int_equal(3, get_int(report, "executionStats.docsExamined"));
+    bson_destroy(report);
+}
+
+static void test_explain_index(void **state) {
+    (void)state;
+    create_index("grp", "by_grp");
+    create_index("tag", "by_tag");
+
+    bson_t *filter = BCON_NEW("tag", BCON_INT32(42));
+    bson_t *report = explain(filter);
+    bson_destroy(filter);
+
+    assert_string_equal("FETCH", get_str(report, "queryPlanner.winningPlan.stage"));
+    assert_string_equal("IXSCAN", get_str(report, "queryPlanner.winningPlan.inputStage.stage"));
+    assert_string_equal("by_tag",
+                        get_str(report, "queryPlanner.winningPlan.inputStage.indexName"));
+    assert_int_equal(42, get_int(report,
+                                 "queryPlanner.winningPlan.inputStage.indexBounds.0.tag"));
+    assert_false(has_path(report, "queryPlanner.winningPlan.filter"));
+    assert_int_equal(3, get_int(report, "executionStats.nReturned"));
+    assert_int_equal(3, get_int(report, "executionStats.keysExamined"));
+    assert_int_equal(3, get_int(report, "executionStats.docsExamined"));
+
+    /* Both indexes listed; by_grp cannot serve {tag: 42} */
+    assert_string_equal("by_grp", get_str(report, "queryPlanner.candidates.0.indexName"));
+    assert_false(get_bool(report, "queryPlanner.candidates.0.chosen"));
+    assert_true(has_path(report, "queryPlanner.candidates.0.rejected"));
+    assert_true(get_bool(report, "queryPlanner.candidates.1.chosen"));
+    assert_true(get_bool(report, "queryPlanner.candidates.1.analyzed"));
+    bson_destroy(report);
+
+    /* Both pinned: the selective tag index wins on estimated cost */
+    filter = BCON_NEW("grp", BCON_INT32(0),
+                      "tag", "{", "$in", "[", BCON_INT32(3), BCON_INT32(4), "]", "}");
+    report = explain(filter);
+    bson_destroy(filter);
+    assert_string_equal("by_tag",
+                        get_str(report, "queryPlanner.winningPlan.inputStage.indexName"));
+    assert_int_equal(2, get_int(report, "queryPlanner.winningPlan.inputStage.seeks"));
+    assert_string_equal("higher estimated cost",
+                        get_str(report, "queryPlanner.candidates.0.rejected"));
+    assert_true(has_path(report, "queryPlanner.candidates.0.estimatedKeys"));
+    /* 3 and 204 are grp 0 */
+    assert_int_equal(2, get_int(report, "executionStats.nReturned"));
+    assert_int_equal(6, get_int(report, "executionStats.docsExamined"));
+    bson_destroy(report);
+}
+
+static void test_explain_or_and(void **state) {
+    (void)state;
+    create_index("grp", "by_grp");
+    create_index("tag", "by_tag");
+
+    bson_t *filter = BCON_NEW("$or", "[", "{", "tag", BCON_INT32(5), "}",
+                              "{", "grp", BCON_INT32(2), "}", "]");
+    bson_t *report = explain(filter);
+    bson_destroy(filter);
+
+    assert_string_equal("OR", get_str(report, "queryPlanner.winningPlan.inputStage.stage"));
+    assert_string_equal("by_tag", get_str(report,
+        "queryPlanner.winningPlan.inputStage.inputStages.0.indexName"));
+    assert_string_equal("by_grp", get_str(report,
+        "queryPlanner.winningPlan.inputStage.inputStages.1.indexName"));
+    /* tag 5: 5, 105, 205 (grp 2, 0, 1); grp 2: 100 documents */
+    assert_int_equal(102, get_int(report, "executionStats.nReturned"));
+    assert_int_equal(103, get_int(report, "executionStats.keysExamined"));
+    bson_destroy(report);
+
+    /* A point on each index: intersected, tag driving */
+    filter = BCON_NEW("grp", BCON_INT32(0), "tag", BCON_INT32(5));
+    report = explain(filter);
+    bson_destroy(filter);
+    assert_string_equal("AND_SORTED",
+                        get_str(report, "queryPlanner.winningPlan.inputStage.stage"));
+    assert_string_equal("by_tag", get_str(report,
+        "queryPlanner.winningPlan.inputStage.inputStages.0.indexName"));
+    assert_string_equal("by_grp", get_str(report,
+        "queryPlanner.winningPlan.inputStage.inputStages.1.indexName"));
+    assert_true(get_bool(report, "queryPlanner.candidates.0.chosen"));
+    assert_int_equal(1, get_int(report, "executionStats.nReturned"));
+    bson_destroy(report);
+}
+
+static void test_explain_plan_cache(void **state) {
+    (void)state;
+    create_index("tag", "by_tag");
+
+    bson_t *filter = BCON_NEW("tag", BCON_INT32(1));
+    bson_t *report = explain(filter);
+    assert_false(get_bool(report, "queryPlanner.planCacheHit"));
+    bson_destroy(report);
+
+    report = explain(filter);
+    assert_true(get_bool(report, "queryPlanner.planCacheHit"));
+    bson_destroy(report);
+    bson_destroy(filter);
+}
+
+static void test_explain_options(void **state) {
+    (void)state;
+    gerror_t error = {0};
+    bson_t *filter = BCON_NEW("grp", BCON_INT32(1));
+    bson_t *sort = BCON_NEW("n", BCON_INT32(-1));
+    bson_t *projection = BCON_NEW("n", BCON_INT32(1));
+
+    bson_t *report = mongolite_explain(g_db, "items", filter, sort, projection, &error);
+    assert_non_null(report);
+    assert_int_equal(-1, get_int(report, "queryPlanner.sort.n"));
+    assert_int_equal(1, get_int(report, "queryPlanner.projection.n"));
+    bson_destroy(report);
+
+    /* No filter: every document */
+    report = mongolite_explain(g_db, "items", NULL, NULL, NULL, &error);
+    assert_non_null(report);
+    assert_int_equal(N_DOCS, get_int(report, "executionStats.nReturned"));
+    bson_destroy(report);
+
+    assert_null(mongolite_explain(g_db, "missing", filter, NULL, NULL, &error));
+    assert_null(mongolite_explain(NULL, "items", filter, NULL, NULL, &error));
+
+    bson_destroy(filter);
+    bson_destroy(sort);
+    bson_destroy(projection);
+}
+
+/* ============================================================
+ * Test Runner
+ * ============================================================ */
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_explain_collscan, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_explain_id, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_explain_index, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_explain_or_and, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_explain_plan_cache, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_explain_options, setup, teardown),
+    };
+
+    return cmocka_run_group_tests_name("tests", tests, NULL, NULL);
+}
@@ -0,0 +1,274 @@
+/**
+ * test_mongolite_find_many.c - Tests for batched lookups by _id
+ *
+ * Tests:
+ * - find_many_by_id: results aligned with the input, missing ids NULL,
+ *   duplicates answered twice, unsorted input
+ * - A large batch (more ids than one fetch batch)
+ * - find with {_id: {$in: [...]}}: every match once, in _id order,
+ *   with skip/limit and other predicates applied
+ * - find_one with $in on _id
+ * - $in with non-OID elements falls back to a scan
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "mongolite.h"
+#include "mongolite_internal.h"
+
+/* ============================================================
+ * Test Setup/Teardown
+ * ============================================================ */
+
+static mongolite_db_t *g_db = NULL;
+static const char *DB_PATH = "./test_find_many_db";
+
+#define N_DOCS 600
+static bson_oid_t g_ids[N_DOCS];
+
+static void cleanup_db_path(void) {
+    char cmd[256];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", DB_PATH);
+    system(cmd);
+}
+
+static int setup(void **state) {
+    (void)state;
+    cleanup_db_path();
+
+    gerror_t error = {0};
+    db_config_t config = {0};
+    config.max_bytes = 64ULL * 1024 * 1024;
+    if (mongolite_open(DB_PATH, &g_db, &config, &error) != 0) return -1;
+    if (mongolite_collection_create(g_db, "items", NULL, &error) != 0) return -1;
+
+    /* n = i, grp = i % 3 */
+    for (int i = 0; i < N_DOCS; i++) {
+        bson_t *doc = BCON_NEW("n", BCON_INT32(i), "grp", BCON_INT32(i % 3));
+        int rc = mongolite_insert_one(g_db, "items", doc, &g_ids[i], &error);
+        bson_destroy(doc);
+        if (rc != 0) return -1;
+    }
+    return 0;
+}
+
+static int teardown(void **state) {
+    (void)state;
+    if (g_db) {
+        mongolite_close(g_db);
+        g_db = NULL;
+    }
+    cleanup_db_path();
+    return 0;
+}
+
+static int doc_n(const bson_t *doc) {
+    bson_iter_t it;
+    assert_true(bson_iter_init_find(&it, doc, "n"));
+    return bson_iter_int32(&it);
+}
+
+static uint64_t id_queries(void) {
+    gerror_t error = {0};
+    mongolite_stats_t stats;
+    assert_int_equal(MONGOLITE_OK, mongolite_stats(g_db, &stats, &error));
+    return stats.totals.id_queries;
+}
+
+/* {_id: {$in: [ids of ns...]}} plus an optional grp predicate */
+static bson_t* in_filter(const int *ns, size_t count, int grp) {
+    bson_t *filter = bson_new();
+    bson_t id_doc, in_arr;
+    BSON_APPEND_DOCUMENT_BEGIN(filter, "_id", &id_doc);
+    BSON_APPEND_ARRAY_BEGIN(&id_doc, "$in", &in_arr);
+    for (size_t i = 0; i < count; i++) {
+        char key[16];
+        snprintf(key, sizeof(key), "%zu", i);
+        BSON_APPEND_OID(&in_arr, key, &g_ids[ns[i]]);
+    }
+    bson_append_array_end(&id_doc, &in_arr);
+    bson_append_document_end(filter, &id_doc);
+    if (grp >= 0) BSON_APPEND_INT32(filter, "grp", grp);
+    return filter;
+}
+
+/* Runs find, checking n ascends; returns the ns seen */
+static size_t find_ns(const bson_t *filter, int64_t skip, int64_t limit, int *out) {
+    gerror_t error = {0};
+    mongolite_cursor_t *cursor = mongolite_find(g_db, "items", filter, NULL, &error);
+    assert_non_null(cursor);
+    if (skip) mongolite_cursor_set_skip(cursor, skip);
+    if (limit) mongolite_cursor_set_limit(cursor, limit);
+
+    const bson_t *doc;
+    size_t count = 0;
+    while (mongolite_cursor_next(cursor, &doc)) {
+        out[count] = doc_n(doc);
+        if (count) assert_true(out[count] > out[count - 1]);
+        count++;
+    }
+    mongolite_cursor_destroy(cursor);
+    return count;
+}
+
+/* ============================================================
+ * Tests
+ * ============================================================ */
+
+static void test_many_by_id_aligned(void **state) {
+    (void)state;
+    gerror_t error = {0};
+    bson_oid_t ids[6];
+    bson_t *docs[6];
+
+    bson_oid_copy(&g_ids[500], &ids[0]);
+    bson_oid_copy(&g_ids[3], &ids[1]);
+    bson_oid_init(&ids[2], NULL);               /* not stored */
+    bson_oid_copy(&g_ids[3], &ids[3]);          /* duplicate */
+    bson_oid_copy(&g_ids[599], &ids[4]);
+    bson_oid_copy(&g_ids[0], &ids[5]);
+
+    uint64_t before = id_queries();
+    assert_int_equal(MONGOLITE_OK,
+                     mongolite_find_many_by_id(g_db, "items", ids, 6, docs, &error));
+    assert_int_equal(before + 1, id_queries());
+
+    assert_int_equal(500, doc_n(docs[0]));
+    assert_int_equal(3, doc_n(docs[1]));
+    assert_null(docs[2]);
+    assert_int_equal(3, doc_n(docs[3]));
+    assert_int_equal(599, doc_n(docs[4]));
+    assert_int_equal(0, doc_n(docs[5]));
+    for (int i = 0; i < 6; i++) {
+        if (docs[i]) bson_destroy(docs[i]);
+    }
+
+    assert_int_equal(MONGOLITE_OK,
+                     mongolite_find_many_by_id(g_db, "items", ids, 0, docs, &error));
+    assert_int_not_equal(MONGOLITE_OK,
+                         mongolite_find_many_by_id(g_db, "missing", ids, 6, docs, &error));
+}
+
+static void test_many_by_id_large(void **state) {
+    (void)state;
+    gerror_t error = {0};
+    mongolite_collection_t *col = mongolite_collection_open(g_db, "items", &error);
+    assert_non_null(col);
+
+    /* Every other document, newest first */
+    bson_oid_t ids[N_DOCS / 2];
+    bson_t *docs[N_DOCS / 2];
+    for (int i = 0; i < N_DOCS / 2; i++) bson_oid_copy(&g_ids[N_DOCS - 1 - 2 * i], &ids[i]);
+
+    assert_int_equal(MONGOLITE_OK,
+                     mongolite_col_find_many_by_id(col, ids, N_DOCS / 2, docs, &error));
+    for (int i = 0; i < N_DOCS / 2; i++) {
+        assert_int_equal(N_DOCS - 1 - 2 * i, doc_n(docs[i]));
+        bson_destroy(docs[i]);
+    }
+    mongolite_collection_close(col);
+}
+
+static void test_find_id_in(void **state) {
+    (void)state;
+    int ns[] = {450, 7, 99, 7, 300, 12};        /* unsorted, one duplicate */
+    int out[N_DOCS];
+
+    uint64_t before = id_queries();
+    bson_t *filter = in_filter(ns, 6, -1);
+    assert_int_equal(5, find_ns(filter, 0, 0, out));
+    assert_int_equal(7, out[0]);
+    assert_int_equal(450, out[4]);
+    assert_true(id_queries() > before);
+
+    /* Skip and limit over the batched results */
+    assert_int_equal(2, find_ns(filter, 1, 2, out));
+    assert_int_equal(12, out[0]);
+    assert_int_equal(99, out[1]);
+    bson_destroy(filter);
+
+    /* Other predicates still apply: only 7 is not grp 0 */
+    filter = in_filter(ns, 6, 0);
+    assert_int_equal(4, find_ns(filter, 0, 0, out));
+    assert_int_equal(12, out[0]);
+    bson_destroy(filter);
+
+    /* Empty $in matches nothing */
+    filter = in_filter(ns, 0, -1);
+    assert_int_equal(0, find_ns(filter, 0, 0, out));
+    bson_destroy(filter);
+
+    /* More ids than one fetch batch */
+    int many[200];
+    for (int i = 0; i < 200; i++) many[i] = (i * 7) % N_DOCS;
+    filter = in_filter(many, 200, -1);
+    assert_int_equal(200, find_ns(filter, 0, 0, out));
+    bson_destroy(filter);
+}
+
+static void test_find_one_id_in(void **state) {
+    (void)state;
+    gerror_t error = {0};
+    int ns[] = {320, 40, 41};
+
+    bson_t *filter = in_filter(ns, 3, -1);
+    bson_t *doc = mongolite_find_one(g_db, "items", filter, NULL, &error);
+    bson_destroy(filter);
+    assert_non_null(doc);
+    assert_int_equal(40, doc_n(doc));
+    bson_destroy(doc);
+
+    /* 40 is grp 1, 41 is grp 2 */
+    filter = in_filter(ns, 3, 2);
+    doc = mongolite_find_one(g_db, "items", filter, NULL, &error);
+    bson_destroy(filter);
+    assert_non_null(doc);
+    assert_int_equal(41, doc_n(doc));
+    bson_destroy(doc);
+}
+
+static void test_id_in_mixed_falls_back(void **state) {
+    (void)state;
+    gerror_t error = {0};
+    bson_t *doc = BCON_NEW("_id", BCON_UTF8("custom"), "n", BCON_INT32(-1));
+    assert_int_equal(0, mongolite_insert_one(g_db, "items", doc, NULL, &error));
+    bson_destroy(doc);
+
+    bson_t *filter = BCON_NEW("_id", "{", "$in", "[",
+                              BCON_UTF8("custom"), BCON_OID(&g_ids[5]), "]", "}");
+    mongolite_cursor_t *cursor = mongolite_find(g_db, "items", filter, NULL, &error);
+    bson_destroy(filter);
+    assert_non_null(cursor);
+
+    const bson_t *found;
+    int count = 0, sum = 0;
+    while (mongolite_cursor_next(cursor, &found)) {
+        sum += doc_n(found);
+        count++;
+    }
+    mongolite_cursor_destroy(cursor);
+    assert_int_equal(2, count);
+    assert_int_equal(4, sum);
+}
+
+/* ============================================================
+ * Test Runner
+ * ============================================================ */
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_many_by_id_aligned, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_many_by_id_large, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_find_id_in, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_find_one_id_in, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_id_in_mixed_falls_back, setup, teardown),
+    };
+
+    return cmocka_run_group_tests_name("tests", tests, NULL, NULL);
+}
@@ -0,0 +1,438 @@
+/**
+ * test_mongolite_geo.c - Tests for geospatial indexes
+ *
+ * Tests:
+ * - Cell keys: corners of the plane, neighbours share a prefix
+ * - Geo index creation: name, invalid specs
+ * - $geoWithin $box / $polygon: same documents as without the index,
+ *   explain reports a GEO_WITHIN stage
+ * - $near ($geometry in meters, legacy pairs in plane units): nearest
+ *   first, bounds applied, across the antimeridian, with limits,
+ *   find_one and other predicates
+ * - Updates and deletes move and remove points; verify passes
+ * - The index survives reopening the database
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <math.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "mongolite.h"
+#include "mongolite_internal.h"
+
+/* ============================================================
+ * Test Setup/Teardown
+ * ============================================================ */
+
+static mongolite_db_t *g_db = NULL;
+static const char *DB_PATH = "./test_geo_db";
+
+#define N_PLACES 600
+
+static double g_x[N_PLACES], g_y[N_PLACES];
+
+static void cleanup_db_path(void) {
+    char cmd[256];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", DB_PATH);
+    system(cmd);
+}
+
+static int open_db(void) {
+    gerror_t error = {0};
+    db_config_t config = {0};
+    config.max_bytes = 64ULL * 1024 * 1024;
+    return mongolite_open(DB_PATH, &g_db, &config, &error);
+}
+
+static int setup(void **state) {
+    (void)state;
+    cleanup_db_path();
+
+    gerror_t error = {0};
+    if (open_db() != 0) return -1;
+    if (mongolite_collection_create(g_db, "places", NULL, &error) != 0) return -1;
+    return mongolite_collection_create(g_db, "plain", NULL, &error);
+}
+
+static int teardown(void **state) {
+    (void)state;
+    if (g_db) {
+        mongolite_close(g_db);
+        g_db = NULL;
+    }
+    cleanup_db_path();
+    return 0;
+}
+
+/* Places 0..N_PLACES-1 in [-20, 20] x [-10, 10], the last few across the
+ * antimeridian; every fifth without a location. "places" and "plain"
+ * hold the same documents, legacy pairs or GeoJSON points. */
+static void insert_places(bool geojson) {
+    gerror_t error = {0};
+    uint32_t seed = 12345;
+    for (int i = 0; i < N_PLACES; i++) {
+        seed = seed * 1103515245u + 12345u;
+        g_x[i] = ((seed >> 8) % 40000) / 1000.0 - 20.0;
+        seed = seed * 1103515245u + 12345u;
+        g_y[i] = ((seed >> 8) % 20000) / 1000.0 - 10.0;
+        if (i >= N_PLACES - 4) g_x[i] = (i % 2) ? 179.9 + 0.02 * (i % 3) : -179.95;
+
+        bson_t *doc;
+        if (i % 5 == 4) {
+            doc = BCON_NEW("n", BCON_INT32(i));
+        } else if (geojson) {
+            doc = BCON_NEW("n", BCON_INT32(i), "loc", "{", "type", BCON_UTF8("Point"),
+                           "coordinates", "[", BCON_DOUBLE(g_x[i]), BCON_DOUBLE(g_y[i]), "]",
+                           "}");
+        } else {
+            doc = BCON_NEW("n", BCON_INT32(i), "loc", "[", BCON_DOUBLE(g_x[i]),
+                           BCON_DOUBLE(g_y[i]), "]");
+        }
+        assert_int_equal(MONGOLITE_OK, mongolite_insert_one(g_db, "places", doc, NULL, &error));
+        assert_int_equal(MONGOLITE_OK, mongolite_insert_one(g_db, "plain", doc, NULL, &error));
+        bson_destroy(doc);
+    }
+}
+
+static void create_geo_index(void) {
+    gerror_t error = {0};
+    bson_t *keys = BCON_NEW("loc", BCON_UTF8("2dsphere"));
+    assert_int_equal(MONGOLITE_OK,
+                     mongolite_create_index(g_db, "places", keys, NULL, NULL, &error));
+    bson_destroy(keys);
+}
+
+/* The "n" fields of the documents matching filter, in cursor order;
+ * returns how many (at most max) */
+static size_t collect(const char *collection, const bson_t *filter, int64_t limit,
+                      int *out, size_t max) {
+    gerror_t error = {0};
+    mongolite_cursor_t *cursor = mongolite_find(g_db, collection, filter, NULL, &error);
+    assert_non_null(cursor);
+    if (limit > 0) mongolite_cursor_set_limit(cursor, limit);
+
+    size_t n = 0;
+    const bson_t *doc;
+    while (mongolite_cursor_next(cursor, &doc)) {
+        bson_iter_t iter;
+        assert_true(bson_iter_init_find(&iter, doc, "n"));
+        if (n < max) out[n] = bson_iter_int32(&iter);
+        n++;
+    }
+    mongolite_cursor_destroy(cursor);
+    return n;
+}
+
+static int cmp_int(const void *a, const void *b) {
+    return *(const int *)a - *(const int *)b;
+}
+
+/* The filter finds the same documents with and without the index */
+static size_t assert_same_as_scan(const bson_t *filter) {
+    static int a[N_PLACES], b[N_PLACES];
+    size_t na = collect("places", filter, 0, a, N_PLACES);
+    size_t nb = collect("plain", filter, 0, b, N_PLACES);
+    assert_int_equal(nb, na);
+    qsort(a, na, sizeof(int), cmp_int);
+    qsort(b, nb, sizeof(int), cmp_int);
+    assert_memory_equal(a, b, na * sizeof(int));
+    return na;
+}
+
+static double haversine(double x1, double y1, double x2, double y2) {
+    const double rad = 3.14159265358979323846 / 180.0;
+    double h = 0.5 * (1 - cos((y2 - y1) * rad)) +
+               cos(y1 * rad) * cos(y2 * rad) * 0.5 * (1 - cos((x2 - x1) * rad));
+    return 2 * asin(sqrt(h)) * 6371000.0;
+}
+
+static const char *winning_stage(const bson_t *filter) {
+    static char stage[32];
+    gerror_t error = {0};
+    bson_t *report = mongolite_explain(g_db, "places", filter, NULL, NULL, &error);
+    assert_non_null(report);
+    bson_iter_t iter, found;
+    assert_true(bson_iter_init(&iter, report));
+    assert_true(bson_iter_find_descendant(&iter, "queryPlanner.winningPlan.inputStage.stage",
+                                          &found));
+    snprintf(stage, sizeof(stage), "%s", bson_iter_utf8(&found, NULL));
+    bson_destroy(report);
+    return stage;
+}
+
+/* ============================================================
+ * Tests
+ * ============================================================ */
+
+static void test_cells(void **state) {
+    (void)state;
+    assert_int_equal(0, _mongolite_geo_cell(-180, -90));
+    assert_int_equal(0, _mongolite_geo_cell(-500, -500));
+    assert_true(_mongolite_geo_cell(180, 90) == (1ULL << 62) - 1);
+    assert_true(_mongolite_geo_cell(180, 90) == _mongolite_geo_cell(1000, 1000));
+    assert_int_equal(0, _mongolite_geo_cell(NAN, NAN));
+
+    /* Close points share the high bits of their cell */
+    uint64_t a = _mongolite_geo_cell(2.35, 48.85), b = _mongolite_geo_cell(2.36, 48.86);
+    uint64_t c = _mongolite_geo_cell(-74.0, 40.7);
+    assert_true((a ^ b) < (a ^ c));
+    assert_true(((a ^ b) >> 40) == 0);
+}
+
+static void test_create_geo_index(void **state) {
+    (void)state;
+    gerror_t error = {0};
+    insert_places(false);
+    create_geo_index();
+
+    size_t count;
+    mongolite_cached_index_t *cached = _mongolite_get_cached_indexes(g_db, "places", &count,
+                                                                     &error);
+    assert_non_null(cached);
+    bool found = false;
+    for (size_t i = 0; i < count; i++) {
+        if (strcmp(cached[i].name, "loc_2dsphere") == 0) {
+            assert_true(cached[i].geo);
+            found = true;
+        }
+    }
+    assert_true(found);
+
+    /* One field, not unique */
+    bson_t *keys = BCON_NEW("loc", BCON_UTF8("2d"), "n", BCON_INT32(1));
+    assert_int_equal(MONGOLITE_EINVAL,
+                     mongolite_create_index(g_db, "plain", keys, NULL, NULL, &error));
+    bson_destroy(keys);
+    keys = BCON_NEW("loc", BCON_UTF8("2d"));
+    index_config_t config = {0};
+    config.unique = true;
+    assert_int_equal(MONGOLITE_EINVAL,
+                     mongolite_create_index(g_db, "plain", keys, NULL, &config, &error));
+    bson_destroy(keys);
+}
+
+static void test_geo_within(void **state) {
+    (void)state;
+    gerror_t error = {0};
+    insert_places(false);
+    create_geo_index();
+
+    static const double boxes[][4] = {
+        {-5, -5, 5, 5}, {0, 0, 0.5, 0.5}, {-20, -10, 20, 10}, {10.25, -3, 10.5, 9},
+        {-180, -90, 180, 90}, {30, 30, 40, 40}, {5, 5, -5, -5},
+    };
+    for (size_t i = 0; i < sizeof(boxes) / sizeof(boxes[0]); i++) {
+        bson_t *filter = BCON_NEW("loc", "{", "$geoWithin", "{", "$box", "[",
+                                  "[", BCON_DOUBLE(boxes[i][0]), BCON_DOUBLE(boxes[i][1]), "]",
+                                  "[", BCON_DOUBLE(boxes[i][2]), BCON_DOUBLE(boxes[i][3]), "]",
+                                  "]", "}", "}");
+        size_t n = assert_same_as_scan(filter);
+        if (i == 2) assert_int_equal(N_PLACES * 4 / 5 - 3, n);    /* All but the far ones */
+        if (i == 5 || i == 6) assert_int_equal(0, n);
+        bson_destroy(filter);
+    }
+
+    /* Polygons: the index reads their bounding box */
+    bson_t *filter = BCON_NEW("loc", "{", "$geoWithin", "{", "$polygon", "[",
+                              "[", BCON_DOUBLE(0), BCON_DOUBLE(0), "]",
+                              "[", BCON_DOUBLE(10), BCON_DOUBLE(0), "]",
+                              "[", BCON_DOUBLE(0), BCON_DOUBLE(8), "]",
+                              "]", "}", "}");
+    assert_true(assert_same_as_scan(filter) > 0);
+    assert_string_equal("GEO_WITHIN", winning_stage(filter));
+    bson_destroy(filter);
+
+    /* With another predicate, and counted */
+    filter = BCON_NEW("loc", "{", "$geoWithin", "{", "$box", "[",
+                      "[", BCON_DOUBLE(-5), BCON_DOUBLE(-5), "]",
+                      "[", BCON_DOUBLE(5), BCON_DOUBLE(5), "]", "]", "}", "}",
+                      "n", "{", "$lt", BCON_INT32(300), "}");
+    size_t n = assert_same_as_scan(filter);
+    assert_int_equal((int64_t)n, mongolite_collection_count(g_db, "places", filter, &error));
+    bson_destroy(filter);
+}
+
+static void test_geo_near(void **state) {
+    (void)state;
+    gerror_t error = {0};
+    insert_places(true);
+    create_geo_index();
+
+    /* Everything within 500 km of (1, 2), nearest first */
+    static int got[N_PLACES];
+    double cx = 1, cy = 2, max_d = 500000;
+    bson_t *filter = BCON_NEW("loc", "{", "$near", "{",
+                              "$geometry", "{", "type", BCON_UTF8("Point"),
+                              "coordinates", "[", BCON_DOUBLE(cx), BCON_DOUBLE(cy), "]", "}",
+                              "$maxDistance", BCON_DOUBLE(max_d), "}", "}");
+    size_t n = collect("places", filter, 0, got, N_PLACES);
+    size_t expected = 0;
+    for (int i = 0; i < N_PLACES; i++) {
+        if (i % 5 != 4 && haversine(cx, cy, g_x[i], g_y[i]) <= max_d) expected++;
+    }
+    assert_true(expected > 10);
+    assert_int_equal(expected, n);
+    for (size_t i = 1; i < n; i++) {
+        assert_true(haversine(cx, cy, g_x[got[i - 1]], g_y[got[i - 1]]) <=
+                    haversine(cx, cy, g_x[got[i]], g_y[got[i]]));
+    }
+    assert_string_equal("GEO_NEAR", winning_stage(filter));
+
+    /* A limit stops early; find_one is the nearest */
+    static int first[5];
+    assert_int_equal(5, collect("places", filter, 5, first, 5));
+    assert_memory_equal(got, first, sizeof(first));
+    bson_t *doc = mongolite_find_one(g_db, "places", filter, NULL, &error);
+    assert_non_null(doc);
+    bson_iter_t iter;
+    assert_true(bson_iter_init_find(&iter, doc, "n"));
+    assert_int_equal(got[0], bson_iter_int32(&iter));
+    bson_destroy(doc);
+    assert_int_equal((int64_t)n, mongolite_collection_count(g_db, "places", filter, &error));
+    bson_destroy(filter);
+
+    /* Unbounded, with $minDistance and another predicate */
+    filter = BCON_NEW("loc", "{", "$near", "{",
+                      "$geometry", "{", "type", BCON_UTF8("Point"),
+                      "coordinates", "[", BCON_DOUBLE(cx), BCON_DOUBLE(cy), "]", "}",
+                      "$minDistance", BCON_DOUBLE(100000), "}", "}",
+                      "n", "{", "$lt", BCON_INT32(100), "}");
+    n = collect("places", filter, 0, got, N_PLACES);
+    expected = 0;
+    for (int i = 0; i < 100; i++) {
+        if (i % 5 != 4 && haversine(cx, cy, g_x[i], g_y[i]) >= 100000) expected++;
+    }
+    assert_int_equal(expected, n);
+    for (size_t i = 1; i < n; i++) {
+        assert_true(haversine(cx, cy, g_x[got[i - 1]], g_y[got[i - 1]]) <=
+                    haversine(cx, cy, g_x[got[i]], g_y[got[i]]));
+    }
+    bson_destroy(filter);
+
+    /* Across the antimeridian */
+    filter = BCON_NEW("loc", "{", "$near", "{",
+                      "$geometry", "{", "type", BCON_UTF8("Point"),
+                      "coordinates", "[", BCON_DOUBLE(179.99), BCON_DOUBLE(g_y[N_PLACES - 4]),
+                      "]", "}", "$maxDistance", BCON_DOUBLE(2000000), "}", "}");
+    expected = 0;
+    for (int i = N_PLACES - 4; i < N_PLACES; i++) {
+        if (i % 5 != 4 && haversine(179.99, g_y[N_PLACES - 4], g_x[i], g_y[i]) <= 2000000) expected++;
+    }
+    assert_true(expected >= 2);
+    n = collect("places", filter, 0, got, N_PLACES);
+    assert_int_equal(expected, n);
+    assert_int_equal(N_PLACES - 4, got[0]);
+    bson_destroy(filter);
+}
+
+static void test_geo_near_legacy(void **state) {
+    (void)state;
+    insert_places(false);
+    bson_t *keys = BCON_NEW("loc", BCON_UTF8("2d"));
+    gerror_t error = {0};
+    assert_int_equal(MONGOLITE_OK,
+                     mongolite_create_index(g_db, "places", keys, NULL, NULL, &error));
+    bson_destroy(keys);
+
+    /* Plane distance in coordinate units */
+    static int got[N_PLACES];
+    bson_t *filter = BCON_NEW("loc", "{", "$near", "[", BCON_DOUBLE(-3), BCON_DOUBLE(4), "]",
+                              "$maxDistance", BCON_DOUBLE(2.5), "}");
+    size_t n = collect("places", filter, 0, got, N_PLACES);
+    size_t expected = 0;
+    for (int i = 0; i < N_PLACES; i++) {
+        if (i % 5 != 4 && hypot(g_x[i] + 3, g_y[i] - 4) <= 2.5) expected++;
+    }
+    assert_true(expected > 5);
+    assert_int_equal(expected, n);
+    for (size_t i = 1; i < n; i++) {
+        assert_true(hypot(g_x[got[i - 1]] + 3, g_y[got[i - 1]] - 4) <=
+                    hypot(g_x[got[i]] + 3, g_y[got[i]] - 4));
+    }
+    bson_destroy(filter);
+}
+
+static void test_geo_maintenance(void **state) {
+    (void)state;
+    gerror_t error = {0};
+    insert_places(false);
+    create_geo_index();
+
+    bson_t *box = BCON_NEW("loc", "{", "$geoWithin", "{", "$box", "[",
+                           "[", BCON_DOUBLE(100), BCON_DOUBLE(50), "]",
+                           "[", BCON_DOUBLE(101), BCON_DOUBLE(51), "]", "]", "}", "}");
+    int got[4];
+    assert_int_equal(0, collect("places", box, 0, got, 4));
+
+    /* Moved into the box, then a new point, then deleted */
+    bson_t *filter = BCON_NEW("n", BCON_INT32(0));
+    bson_t *update = BCON_NEW("$set", "{", "loc", "[", BCON_DOUBLE(100.5), BCON_DOUBLE(50.5),
+                              "]", "}");
+    assert_int_equal(MONGOLITE_OK,
+                     mongolite_update_one(g_db, "places", filter, update, false, &error));
+    bson_destroy(update);
+    bson_destroy(filter);
+    assert_int_equal(1, collect("places", box, 0, got, 4));
+    assert_int_equal(0, got[0]);
+
+    bson_t *doc = BCON_NEW("n", BCON_INT32(-1), "loc", "[", BCON_DOUBLE(100.25),
+                           BCON_DOUBLE(50.25), "]");
+    assert_int_equal(MONGOLITE_OK, mongolite_insert_one(g_db, "places", doc, NULL, &error));
+    bson_destroy(doc);
+    assert_int_equal(2, collect("places", box, 0, got, 4));
+
+    filter = BCON_NEW("n", BCON_INT32(0));
+    assert_int_equal(MONGOLITE_OK, mongolite_delete_one(g_db, "places", filter, &error));
+    bson_destroy(filter);
+    assert_int_equal(1, collect("places", box, 0, got, 4));
+    assert_int_equal(-1, got[0]);
+    bson_destroy(box);
+
+    wtree3_tree_t *tree = _mongolite_tree_cache_get(g_db, "places");
+    assert_non_null(tree);
+    assert_int_equal(0, wtree3_verify_indexes(tree, &error));
+}
+
+static void test_geo_reopen(void **state) {
+    (void)state;
+    insert_places(true);
+    create_geo_index();
+
+    mongolite_close(g_db);
+    g_db = NULL;
+    assert_int_equal(0, open_db());
+
+    bson_t *filter = BCON_NEW("loc", "{", "$near", "{",
+                              "$geometry", "{", "type", BCON_UTF8("Point"),
+                              "coordinates", "[", BCON_DOUBLE(g_x[0]), BCON_DOUBLE(g_y[0]),
+                              "]", "}", "$maxDistance", BCON_DOUBLE(1), "}", "}");
+    int got[4];
+    assert_int_equal(1, collect("places", filter, 0, got, 4));
+    assert_int_equal(0, got[0]);
+    assert_string_equal("GEO_NEAR", winning_stage(filter));
+    bson_destroy(filter);
+}
+
+/* ============================================================
+ * Test Runner
+ * ============================================================ */
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_cells, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_create_geo_index, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_geo_within, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_geo_near, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_geo_near_legacy, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_geo_maintenance, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_geo_reopen, setup, teardown),
+    };
+
+    return cmocka_run_group_tests_name("tests", tests, NULL, NULL);
+}
@@ -0,0 +1,306 @@
+/**
+ * test_mongolite_group.c - Tests for group commit
+ *
+ * Tests:
+ * - Concurrent inserts coalesce into fewer transactions, none lost
+ * - A failing write (unique violation) does not affect its batch
+ * - update_one / replace_one / delete_one through the queue
+ * - Writes to a missing collection fail alone
+ * - Session threads bypass the queue; queued writes wait for a write
+ *   session, up to busy_timeout_ms (then EBUSY)
+ *
+ * Worker threads only record results; assertions run on the main thread.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "mongolite.h"
+#include "mongolite_internal.h"
+
+/* ============================================================
+ * Test Setup/Teardown
+ * ============================================================ */
+
+static mongolite_db_t *g_db = NULL;
+static const char *DB_PATH = "./test_group_db";
+
+static void cleanup_db_path(void) {
+    char cmd[256];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", DB_PATH);
+    system(cmd);
+}
+
+static int open_db(unsigned int max_ops, unsigned int wait_us) {
+    gerror_t error = {0};
+    db_config_t config = {0};
+    config.max_bytes = 64ULL * 1024 * 1024;
+    config.group_commit = true;
+    config.group_commit_max_ops = max_ops;
+    config.group_commit_wait_us = wait_us;
+    return mongolite_open(DB_PATH, &g_db, &config, &error);
+}
+
+static int setup(void **state) {
+    (void)state;
+    cleanup_db_path();
+
+    gerror_t error = {0};
+    if (open_db(16, 2000) != 0) return -1;
+    if (mongolite_collection_create(g_db, "items", NULL, &error) != 0) return -1;
+    mongolite_stats_reset(g_db);
+    return 0;
+}
+
+static int teardown(void **state) {
+    (void)state;
+    if (g_db) {
+        mongolite_close(g_db);
+        g_db = NULL;
+    }
+    cleanup_db_path();
+    return 0;
+}
+
+static mongolite_stats_t db_stats(void) {
+    gerror_t error = {0};
+    mongolite_stats_t stats;
+    assert_int_equal(MONGOLITE_OK, mongolite_stats(g_db, &stats, &error));
+    return stats;
+}
+
+/* ============================================================
+ * Worker Threads
+ * ============================================================ */
+
+enum { THREADS = 8, PER_THREAD = 50 };
+
+typedef struct {
+    int id;
+    const char *collection;
+    int failures;
+    int dup_rc;
+    int dup_code;
+} worker_t;
+
+static void* insert_worker(void *arg) {
+    worker_t *w = arg;
+    gerror_t error = {0};
+    for (int i = 0; i < PER_THREAD; i++) {
+        bson_t *doc = BCON_NEW("worker", BCON_INT32(w->id), "i", BCON_INT32(i));
+        if (mongolite_insert_one(g_db, w->collection, doc, NULL, &error) != 0) w->failures++;
+        bson_destroy(doc);
+    }
+    return NULL;
+}
+
+/* One shared key (only one thread may win) plus one key of its own */
+static void* unique_worker(void *arg) {
+    worker_t *w = arg;
+    gerror_t error = {0};
+
+    bson_t *dup = BCON_NEW("sku", BCON_UTF8("shared"));
+    w->dup_rc = mongolite_insert_one(g_db, "items", dup, NULL, &error);
+    w->dup_code = error.code;
+    bson_destroy(dup);
+
+    char sku[16];
+    snprintf(sku, sizeof(sku), "own-%d", w->id);
+    bson_t *own = BCON_NEW("sku", BCON_UTF8(sku));
+    memset(&error, 0, sizeof(error));
+    if (mongolite_insert_one(g_db, "items", own, NULL, &error) != 0) w->failures++;
+    bson_destroy(own);
+    return NULL;
+}
+
+static void run_workers(void *(*fn)(void *), worker_t *workers, const char *collection) {
+    pthread_t tids[THREADS];
+    for (int t = 0; t < THREADS; t++) {
+        memset(&workers[t], 0, sizeof(worker_t));
+        workers[t].id = t;
+        workers[t].collection = collection;
+        pthread_create(&tids[t], NULL, fn, &workers[t]);
+    }
+    for (int t = 0; t < THREADS; t++) pthread_join(tids[t], NULL);
+}
+
+/* ============================================================
+ * Tests
+ * ============================================================ */
+
+static void test_group_concurrent_inserts(void **state) {
+    (void)state;
+    gerror_t error = {0};
+
+    worker_t workers[THREADS];
+    run_workers(insert_worker, workers, "items");
+    for (int t = 0; t < THREADS; t++) assert_int_equal(0, workers[t].failures);
+
+    assert_int_equal(THREADS * PER_THREAD,
+                     mongolite_collection_count(g_db, "items", NULL, &error));
+
+    mongolite_stats_t stats = db_stats();
+    assert_int_equal(THREADS * PER_THREAD, stats.group_ops);
+    assert_true(stats.group_commits > 0);
+    assert_true(stats.group_commits < stats.group_ops);
+    assert_int_equal(THREADS * PER_THREAD, stats.latency[MONGOLITE_OP_INSERT].count);
+
+    /* Data is durable and readable after reopen */
+    mongolite_close(g_db);
+    assert_int_equal(0, open_db(0, 0));
+    assert_int_equal(THREADS * PER_THREAD,
+                     mongolite_collection_count(g_db, "items", NULL, &error));
+}
+
+static void test_group_failure_isolated(void **state) {
+    (void)state;
+    gerror_t error = {0};
+
+    bson_t *keys = BCON_NEW("sku", BCON_INT32(1));
+    index_config_t cfg = {.unique = true};
+    assert_int_equal(0, mongolite_create_index(g_db, "items", keys, NULL, &cfg, &error));
+    bson_destroy(keys);
+
+    worker_t workers[THREADS];
+    run_workers(unique_worker, workers, "items");
+
+    int winners = 0;
+    for (int t = 0; t < THREADS; t++) {
+        assert_int_equal(0, workers[t].failures);
+        if (workers[t].dup_rc == 0) {
+            winners++;
+        } else {
+            assert_int_not_equal(0, workers[t].dup_code);
+        }
+    }
+    assert_int_equal(1, winners);
+    assert_int_equal(THREADS + 1, mongolite_collection_count(g_db, "items", NULL, &error));
+}
+
+static void test_group_update_replace_delete(void **state) {
+    (void)state;
+    gerror_t error = {0};
+
+    bson_oid_t id;
+    bson_t *doc = BCON_NEW("name", BCON_UTF8("a"), "n", BCON_INT32(1));
+    assert_int_equal(0, mongolite_insert_one(g_db, "items", doc, &id, &error));
+    bson_destroy(doc);
+
+    bson_t *filter = BCON_NEW("_id", BCON_OID(&id));
+    bson_t *update = BCON_NEW("$set", "{", "n", BCON_INT32(2), "}");
+    assert_int_equal(0, mongolite_update_one(g_db, "items", filter, update, false, &error));
+    bson_destroy(update);
+
+    bson_t *by_n = BCON_NEW("n", BCON_INT32(2));
+    bson_t *replacement = BCON_NEW("name", BCON_UTF8("b"), "n", BCON_INT32(3));
+    assert_int_equal(0, mongolite_replace_one(g_db, "items", by_n, replacement, false, &error));
+    bson_destroy(replacement);
+    bson_destroy(by_n);
+
+    bson_t *found = mongolite_find_one(g_db, "items", filter, NULL, &error);
+    assert_non_null(found);
+    bson_iter_t it;
+    assert_true(bson_iter_init_find(&it, found, "name"));
+    assert_string_equal("b", bson_iter_utf8(&it, NULL));
+    bson_destroy(found);
+
+    /* Upsert through the queue */
+    bson_t *missing = BCON_NEW("name", BCON_UTF8("c"));
+    update = BCON_NEW("$set", "{", "n", BCON_INT32(9), "}");
+    assert_int_equal(0, mongolite_update_one(g_db, "items", missing, update, true, &error));
+    bson_destroy(update);
+    bson_destroy(missing);
+    assert_int_equal(2, mongolite_collection_count(g_db, "items", NULL, &error));
+
+    assert_int_equal(0, mongolite_delete_one(g_db, "items", filter, &error));
+    bson_destroy(filter);
+    assert_int_equal(1, mongolite_collection_count(g_db, "items", NULL, &error));
+
+    mongolite_stats_t stats = db_stats();
+    assert_int_equal(5, stats.group_ops);
+}
+
+static void test_group_missing_collection(void **state) {
+    (void)state;
+    gerror_t error = {0};
+
+    worker_t good[THREADS];
+    worker_t bad = {0};
+    bad.collection = "missing";
+
+    pthread_t bad_tid;
+    pthread_create(&bad_tid, NULL, insert_worker, &bad);
+    run_workers(insert_worker, good, "items");
+    pthread_join(bad_tid, NULL);
+
+    assert_int_equal(PER_THREAD, bad.failures);
+    for (int t = 0; t < THREADS; t++) assert_int_equal(0, good[t].failures);
+    assert_int_equal(THREADS * PER_THREAD,
+                     mongolite_collection_count(g_db, "items", NULL, &error));
+}
+
+static void* session_outsider(void *arg) {
+    worker_t *w = arg;
+    gerror_t error = {0};
+    bson_t *doc = BCON_NEW("outsider", BCON_BOOL(true));
+    w->dup_rc = mongolite_insert_one(g_db, "items", doc, NULL, &error);
+    w->dup_code = error.code;
+    bson_destroy(doc);
+    return NULL;
+}
+
+static void test_group_with_sessions(void **state) {
+    (void)state;
+    gerror_t error = {0};
+
+    /* Writes inside a session do not go through the queue */
+    mongolite_session_t *session = mongolite_session_begin(g_db, MONGOLITE_SESSION_WRITE,
+                                                           &error);
+    assert_non_null(session);
+    bson_t *doc = BCON_NEW("in_session", BCON_BOOL(true));
+    assert_int_equal(0, mongolite_insert_one(g_db, "items", doc, NULL, &error));
+    bson_destroy(doc);
+
+    /* Queued writes from other threads wait for the open write session,
+     * here only briefly */
+    g_db->busy_timeout_ms = 50;
+    worker_t outsider = {0};
+    pthread_t tid;
+    pthread_create(&tid, NULL, session_outsider, &outsider);
+    pthread_join(tid, NULL);
+    assert_int_not_equal(0, outsider.dup_rc);
+    assert_int_equal(MONGOLITE_EBUSY, outsider.dup_code);
+
+    assert_int_equal(MONGOLITE_OK, mongolite_session_commit(session, &error));
+
+    mongolite_stats_t stats = db_stats();
+    assert_int_equal(1, stats.group_ops);
+    assert_int_equal(1, mongolite_collection_count(g_db, "items", NULL, &error));
+
+    pthread_create(&tid, NULL, session_outsider, &outsider);
+    pthread_join(tid, NULL);
+    assert_int_equal(0, outsider.dup_rc);
+    assert_int_equal(2, mongolite_collection_count(g_db, "items", NULL, &error));
+}
+
+/* ============================================================
+ * Test Runner
+ * ============================================================ */
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_group_concurrent_inserts, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_group_failure_isolated, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_group_update_replace_delete, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_group_missing_collection, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_group_with_sessions, setup, teardown),
+    };
+
+    return cmocka_run_group_tests_name("tests", tests, NULL, NULL);
+}
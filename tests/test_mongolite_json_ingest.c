@@ -0,0 +1,241 @@
+/**
+ * test_mongolite_json_ingest.c - Tests for the JSON ingest path
+ *
+ * Tests:
+ * - The one-pass parser builds the same BSON as libbson, for plain JSON,
+ *   escapes, numbers and extended JSON (native and fallback wrappers)
+ * - Invalid JSON is rejected by both; the output document is left empty
+ * - NDJSON bulk insert in batches: blank lines and CRLF, counts
+ * - NDJSON parse error names the line; earlier batches stay inserted
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "mongolite.h"
+#include "mongolite_internal.h"
+
+/* ============================================================
+ * Test Setup/Teardown
+ * ============================================================ */
+
+static mongolite_db_t *g_db = NULL;
+static const char *DB_PATH = "./test_json_ingest_db";
+
+static void cleanup_db_path(void) {
+    char cmd[256];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", DB_PATH);
+    system(cmd);
+}
+
+static int setup(void **state) {
+    (void)state;
+    cleanup_db_path();
+
+    gerror_t error = {0};
+    db_config_t config = {0};
+    config.max_bytes = 64ULL * 1024 * 1024;
+    if (mongolite_open(DB_PATH, &g_db, &config, &error) != 0) return -1;
+    return mongolite_collection_create(g_db, "items", NULL, &error);
+}
+
+static int teardown(void **state) {
+    (void)state;
+    if (g_db) {
+        mongolite_close(g_db);
+        g_db = NULL;
+    }
+    cleanup_db_path();
+    return 0;
+}
+
+static int64_t count_items(void) {
+    gerror_t error = {0};
+    return mongolite_collection_count(g_db, "items", NULL, &error);
+}
+
+/* ============================================================
+ * Tests
+ * ============================================================ */
+
+static void test_parse_matches_libbson(void **state) {
+    (void)state;
+    static const char *const inputs[] = {
+        "{}",
+        " { \"a\" : 1 , \"b\" : [ ] , \"c\" : { } } ",
+        "{\"s\":\"plain\",\"e\":\"q\\\"b\\\\s\\/n\\nt\\tu\\u00e9\\ud83d\\ude00\",\"z\":\"a\\u0000b\"}",
+        "{\"k\\u00e9y\":\"caf\xc3\xa9 long enough to cross several eight byte blocks\"}",
+        "{\"i\":2147483647,\"j\":-2147483648,\"k\":2147483648,\"l\":-9223372036854775808}",
+        "{\"big\":18446744073709551616,\"f\":1.5,\"g\":-0.25e-3,\"h\":1E10,\"z\":-0}",
+        "{\"t\":true,\"f\":false,\"n\":null,\"arr\":[1,\"two\",[3,{\"four\":4}],null]}",
+        "{\"_id\":{\"$oid\":\"507f1f77bcf86cd799439011\"},\"n\":{\"$numberLong\":\"42\"}}",
+        "{\"i\":{\"$numberInt\":\"-7\"},\"d\":{\"$numberDouble\":\"2.5\"},"
+        "\"inf\":{\"$numberDouble\":\"-Infinity\"}}",
+        "{\"p\":{\"$numberDouble\":\"Infinity\"},\"n\":{\"$numberDouble\":\"NaN\"},"
+        "\"tiny\":4.9e-324,\"max\":1.7976931348623157e308}",
+        "{\"d1\":{\"$date\":{\"$numberLong\":\"1700000000123\"}},\"d2\":{\"$date\":1700000000000}}",
+        "{\"iso\":{\"$date\":\"2023-11-14T22:13:20.123Z\"}}",
+        "{\"dec\":{\"$numberDecimal\":\"1.5\"},\"bin\":{\"$binary\":{\"base64\":\"AAE=\",\"subType\":\"00\"}}}",
+        "{\"age\":{\"$gt\":18,\"$lt\":65},\"$or\":[{\"a\":1},{\"b\":{\"$in\":[1,2]}}]}",
+        "{\"$set\":{\"name\":\"x\"},\"$inc\":{\"n\":1}}",
+        "[1,2,3]",
+    };
+
+    for (size_t i = 0; i < sizeof(inputs) / sizeof(inputs[0]); i++) {
+        gerror_t error = {0};
+        bson_error_t berr;
+        bson_t *expected = bson_new_from_json((const uint8_t *)inputs[i], -1, &berr);
+        assert_non_null(expected);
+
+        bson_t *doc = bson_new();
+        assert_int_equal(MONGOLITE_OK, _mongolite_json_parse(inputs[i], strlen(inputs[i]),
+                                                             doc, &error));
+        if (!bson_equal(expected, doc)) {
+            char *a = bson_as_canonical_extended_json(expected, NULL);
+            char *b = bson_as_canonical_extended_json(doc, NULL);
+            fprintf(stderr, "input %zu\n expected %s\n got      %s\n", i, a, b);
+            bson_free(a);
+            bson_free(b);
+            fail();
+        }
+        bson_destroy(doc);
+        bson_destroy(expected);
+    }
+}
+
+static void test_parse_rejects_invalid(void **state) {
+    (void)state;
+    static const char *const inputs[] = {
+        "",
+        "   ",
+        "42",
+        "{",
+        "{\"a\"}",
+        "{\"a\":}",
+        "{\"a\":1,}",
+        "{\"a\":1 \"b\":2}",
+        "{\"a\":[1,2}",
+        "{\"a\":\"unterminated}",
+        "{\"a\":\"bad \\x escape\"}",
+        "{\"a\":\"lone \\ud800\"}",
+        "{\"a\":\"raw\ttab\"}",
+        "{\"a\":tru}",
+        "{\"a\":01}",
+        "{\"a\":1.}",
+        "{\"a\":-}",
+        "{\"a\":\"\xff\xfe\"}",
+        "{\"a\":1} trailing",
+        "{\"a\":1e400}",
+        "{\"a\":-1e400}",
+        "{\"a\":{\"$numberDouble\":\"1e400\"}}",
+    };
+
+    for (size_t i = 0; i < sizeof(inputs) / sizeof(inputs[0]); i++) {
+        gerror_t error = {0};
+        bson_t *doc = bson_new();
+        int rc = _mongolite_json_parse(inputs[i], strlen(inputs[i]), doc, &error);
+        if (rc != MONGOLITE_EINVAL) {
+            fprintf(stderr, "input %zu accepted: %s\n", i, inputs[i]);
+            fail();
+        }
+        assert_int_equal(MONGOLITE_EINVAL, error.code);
+        assert_int_equal(0, bson_count_keys(doc));
+        bson_destroy(doc);
+    }
+
+    /* Nesting beyond the limit */
+    char deep[1024];
+    size_t n = 0;
+    deep[n++] = '{';
+    for (int i = 0; i < 120; i++) n += (size_t)snprintf(deep + n, sizeof(deep) - n, "\"a\":{");
+    gerror_t error = {0};
+    bson_t *doc = bson_new();
+    assert_int_equal(MONGOLITE_EINVAL, _mongolite_json_parse(deep, n, doc, &error));
+    bson_destroy(doc);
+}
+
+static void test_ndjson_batches(void **state) {
+    (void)state;
+    gerror_t error = {0};
+
+    /* 2500 documents over three batches, with blank lines and CRLF */
+    size_t cap = 2600 * 64;
+    char *data = malloc(cap);
+    size_t len = 0;
+    for (int i = 0; i < 2500; i++) {
+        len += (size_t)snprintf(data + len, cap - len, "{\"n\":%d,\"name\":\"item %d\"}%s", i, i,
+                                i % 2 ? "\r\n" : "\n");
+        if (i % 100 == 0) len += (size_t)snprintf(data + len, cap - len, "  \n");
+    }
+
+    int64_t n = 0;
+    assert_int_equal(MONGOLITE_OK,
+                     mongolite_insert_ndjson(g_db, "items", data, len, 1000, &n, &error));
+    assert_int_equal(2500, n);
+    assert_int_equal(2500, count_items());
+
+    bson_t *filter = BCON_NEW("n", BCON_INT32(1234));
+    bson_t *found = mongolite_find_one(g_db, "items", filter, NULL, &error);
+    assert_non_null(found);
+    bson_iter_t iter;
+    assert_true(bson_iter_init_find(&iter, found, "name"));
+    assert_string_equal("item 1234", bson_iter_utf8(&iter, NULL));
+    bson_destroy(found);
+    bson_destroy(filter);
+
+    /* No trailing newline, default batch size */
+    const char *last = "{\"n\":-1}\n{\"n\":-2}";
+    assert_int_equal(MONGOLITE_OK,
+                     mongolite_insert_ndjson(g_db, "items", last, strlen(last), 0, &n, &error));
+    assert_int_equal(2, n);
+    assert_int_equal(2502, count_items());
+    free(data);
+}
+
+static void test_ndjson_parse_error(void **state) {
+    (void)state;
+    gerror_t error = {0};
+    const char *data =
+        "{\"n\":1}\n"
+        "{\"n\":2}\n"
+        "\n"
+        "{\"n\":3}\n"
+        "{\"n\":4\n"
+        "{\"n\":5}\n";
+
+    int64_t n = -1;
+    assert_int_equal(MONGOLITE_EINVAL,
+                     mongolite_insert_ndjson(g_db, "items", data, strlen(data), 2, &n, &error));
+    assert_non_null(strstr(error.message, "Line 5"));
+    assert_int_equal(2, n);             /* First batch only */
+    assert_int_equal(2, count_items());
+
+    /* The JSON wrappers report parse errors the same way */
+    bson_oid_t id;
+    assert_int_equal(MONGOLITE_EINVAL,
+                     mongolite_insert_one_json(g_db, "items", "{\"a\":", &id, &error));
+    assert_int_equal(MONGOLITE_OK,
+                     mongolite_insert_one_json(g_db, "items", "{\"a\":\"\\u00e9\"}", &id, &error));
+    assert_int_equal(3, count_items());
+}
+
+/* ============================================================
+ * Test Runner
+ * ============================================================ */
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_parse_matches_libbson, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_parse_rejects_invalid, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_ndjson_batches, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_ndjson_parse_error, setup, teardown),
+    };
+
+    return cmocka_run_group_tests_name("tests", tests, NULL, NULL);
+}
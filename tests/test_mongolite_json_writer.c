@@ -0,0 +1,322 @@
+/**
+ * test_mongolite_json_writer.c - Tests for streaming JSON output
+ *
+ * Tests:
+ * - JSON array output parses back to the stored documents
+ * - JSON lines output: one parseable document per line
+ * - Canonical mode round-trips every BSON type exactly
+ * - Relaxed mode prints plain numbers and ISO-8601 dates
+ * - Output reaches the sink in bounded chunks; a stopping sink cancels
+ * - File descriptor sink; empty results
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include <unistd.h>
+
+#include "mongolite.h"
+#include "mongolite_internal.h"
+
+/* ============================================================
+ * Test Setup/Teardown
+ * ============================================================ */
+
+static mongolite_db_t *g_db = NULL;
+static const char *DB_PATH = "./test_json_writer_db";
+
+static void cleanup_db_path(void) {
+    char cmd[256];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", DB_PATH);
+    system(cmd);
+}
+
+static int setup(void **state) {
+    (void)state;
+    cleanup_db_path();
+
+    gerror_t error = {0};
+    db_config_t config = {0};
+    config.max_bytes = 64ULL * 1024 * 1024;
+    if (mongolite_open(DB_PATH, &g_db, &config, &error) != 0) return -1;
+    return mongolite_collection_create(g_db, "items", NULL, &error);
+}
+
+static int teardown(void **state) {
+    (void)state;
+    if (g_db) {
+        mongolite_close(g_db);
+        g_db = NULL;
+    }
+    cleanup_db_path();
+    return 0;
+}
+
+static void insert_items(int n) {
+    gerror_t error = {0};
+    for (int i = 0; i < n; i++) {
+        bson_t *doc = BCON_NEW("n", BCON_INT32(i), "name", BCON_UTF8("item \"quoted\"\n"));
+        assert_int_equal(0, mongolite_insert_one(g_db, "items", doc, NULL, &error));
+        bson_destroy(doc);
+    }
+}
+
+/* Sink collecting everything into one string */
+typedef struct {
+    char *data;
+    size_t len;
+    int calls;
+    size_t max_chunk;
+    int stop_after;                     /* Fail the nth call (0 = never) */
+} collect_t;
+
+static int collect_sink(const char *data, size_t len, void *ctx) {
+    collect_t *c = ctx;
+    c->calls++;
+    if (c->stop_after && c->calls >= c->stop_after) return 1;
+    if (len > c->max_chunk) c->max_chunk = len;
+    c->data = realloc(c->data, c->len + len + 1);
+    memcpy(c->data + c->len, data, len);
+    c->len += len;
+    c->data[c->len] = '\0';
+    return 0;
+}
+
+static char* write_json(const mongolite_json_opts_t *opts, const bson_t *filter, int64_t *n) {
+    gerror_t error = {0};
+    collect_t c = {0};
+    mongolite_cursor_t *cursor = mongolite_find(g_db, "items", filter, NULL, &error);
+    assert_non_null(cursor);
+    assert_int_equal(MONGOLITE_OK,
+                     mongolite_cursor_write_json(cursor, opts, collect_sink, &c, n, &error));
+    mongolite_cursor_destroy(cursor);
+    return c.data;
+}
+
+/* Parse a JSON array by wrapping it in a document */
+static bson_t* parse_array(const char *json) {
+    size_t len = strlen(json) + 16;
+    char *wrapped = malloc(len);
+    snprintf(wrapped, len, "{\"a\":%s}", json);
+    bson_error_t berr;
+    bson_t *doc = bson_new_from_json((const uint8_t *)wrapped, -1, &berr);
+    free(wrapped);
+    assert_non_null(doc);
+    return doc;
+}
+
+/* ============================================================
+ * Tests
+ * ============================================================ */
+
+static void test_array_output(void **state) {
+    (void)state;
+    insert_items(5);
+
+    int64_t n = 0;
+    char *json = write_json(NULL, NULL, &n);
+    assert_int_equal(5, n);
+    assert_int_equal('[', json[0]);
+
+    bson_t *parsed = parse_array(json);
+    bson_iter_t iter, item;
+    assert_true(bson_iter_init_find(&iter, parsed, "a"));
+    assert_true(bson_iter_recurse(&iter, &item));
+    int count = 0;
+    while (bson_iter_next(&item)) {
+        bson_iter_t field;
+        assert_true(bson_iter_recurse(&item, &field));
+        assert_true(bson_iter_find(&field, "name"));
+        assert_string_equal("item \"quoted\"\n", bson_iter_utf8(&field, NULL));
+        count++;
+    }
+    assert_int_equal(5, count);
+
+    bson_destroy(parsed);
+    free(json);
+}
+
+static void test_lines_output(void **state) {
+    (void)state;
+    insert_items(4);
+
+    mongolite_json_opts_t opts = {MONGOLITE_JSON_LINES, MONGOLITE_JSON_RELAXED, 0};
+    char *json = write_json(&opts, NULL, NULL);
+
+    int lines = 0;
+    char *save = NULL;
+    for (char *line = strtok_r(json, "\n", &save); line; line = strtok_r(NULL, "\n", &save)) {
+        bson_error_t berr;
+        bson_t *doc = bson_new_from_json((const uint8_t *)line, -1, &berr);
+        assert_non_null(doc);
+        assert_true(bson_has_field(doc, "_id"));
+        bson_destroy(doc);
+        lines++;
+    }
+    assert_int_equal(4, lines);
+    free(json);
+}
+
+static void test_canonical_round_trip(void **state) {
+    (void)state;
+    gerror_t error = {0};
+
+    bson_oid_t oid;
+    bson_oid_init(&oid, NULL);
+    bson_decimal128_t dec;
+    bson_decimal128_from_string("1.5E+10", &dec);
+    const uint8_t bin[] = {0x00, 0xff, 0x10, 0x7f, 0x80};
+
+    bson_t *doc = bson_new();
+    BSON_APPEND_OID(doc, "_id", &oid);
+    BSON_APPEND_DOUBLE(doc, "d", 3.0);
+    BSON_APPEND_DOUBLE(doc, "pi", 3.141592653589793);
+    BSON_APPEND_DOUBLE(doc, "inf", INFINITY);
+    BSON_APPEND_INT32(doc, "i32", -7);
+    BSON_APPEND_INT64(doc, "i64", INT64_C(9007199254740993));
+    BSON_APPEND_UTF8(doc, "s", "tab\there \xc3\xa9 \x01");
+    BSON_APPEND_BOOL(doc, "t", true);
+    BSON_APPEND_NULL(doc, "nil");
+    BSON_APPEND_DATE_TIME(doc, "date", INT64_C(1700000000123));
+    BSON_APPEND_DATE_TIME(doc, "old", INT64_C(-1000));
+    BSON_APPEND_BINARY(doc, "bin", BSON_SUBTYPE_BINARY, bin, sizeof(bin));
+    BSON_APPEND_REGEX(doc, "re", "^a.*b$", "i");
+    BSON_APPEND_TIMESTAMP(doc, "ts", 100, 2);
+    BSON_APPEND_DECIMAL128(doc, "dec", &dec);
+    BSON_APPEND_MINKEY(doc, "min");
+    BSON_APPEND_MAXKEY(doc, "max");
+    BSON_APPEND_CODE(doc, "code", "function() {}");
+    bson_t child;
+    BSON_APPEND_DOCUMENT_BEGIN(doc, "sub", &child);
+    BSON_APPEND_INT32(&child, "x", 1);
+    bson_append_document_end(doc, &child);
+    BSON_APPEND_ARRAY_BEGIN(doc, "arr", &child);
+    BSON_APPEND_UTF8(&child, "0", "a");
+    BSON_APPEND_INT64(&child, "1", 2);
+    bson_append_array_end(doc, &child);
+    assert_int_equal(0, mongolite_insert_one(g_db, "items", doc, NULL, &error));
+
+    mongolite_json_opts_t opts = {MONGOLITE_JSON_LINES, MONGOLITE_JSON_CANONICAL, 0};
+    char *json = write_json(&opts, NULL, NULL);
+    json[strlen(json) - 1] = '\0';      /* Trailing newline */
+
+    bson_error_t berr;
+    bson_t *parsed = bson_new_from_json((const uint8_t *)json, -1, &berr);
+    assert_non_null(parsed);
+    assert_true(bson_equal(doc, parsed));
+
+    bson_destroy(parsed);
+    bson_destroy(doc);
+    free(json);
+}
+
+static void test_relaxed_forms(void **state) {
+    (void)state;
+    gerror_t error = {0};
+    bson_t *doc = BCON_NEW("_id", BCON_INT32(1), "d", BCON_DOUBLE(2.0),
+                           "l", BCON_INT64(5), "when", BCON_DATE_TIME(1700000000123));
+    assert_int_equal(0, mongolite_insert_one(g_db, "items", doc, NULL, &error));
+    bson_destroy(doc);
+
+    char *json = write_json(NULL, NULL, NULL);
+    assert_string_equal("[{\"_id\":1,\"d\":2.0,\"l\":5,"
+                        "\"when\":{\"$date\":\"2023-11-14T22:13:20.123Z\"}}]", json);
+    free(json);
+}
+
+static void test_chunks_and_cancel(void **state) {
+    (void)state;
+    gerror_t error = {0};
+    insert_items(200);
+
+    /* Small chunks: many calls, none much bigger than a chunk plus a document */
+    mongolite_json_opts_t opts = {MONGOLITE_JSON_ARRAY, MONGOLITE_JSON_RELAXED, 512};
+    collect_t c = {0};
+    mongolite_cursor_t *cursor = mongolite_find(g_db, "items", NULL, NULL, &error);
+    assert_int_equal(MONGOLITE_OK,
+                     mongolite_cursor_write_json(cursor, &opts, collect_sink, &c, NULL, &error));
+    mongolite_cursor_destroy(cursor);
+    assert_true(c.calls > 10);
+    assert_true(c.max_chunk < 512 + 256);
+    bson_t *parsed = parse_array(c.data);
+    bson_destroy(parsed);
+    free(c.data);
+
+    /* A sink that stops cancels the write */
+    collect_t stop = {0};
+    stop.stop_after = 3;
+    int64_t n = 0;
+    cursor = mongolite_find(g_db, "items", NULL, NULL, &error);
+    assert_int_equal(MONGOLITE_ECANCELED,
+                     mongolite_cursor_write_json(cursor, &opts, collect_sink, &stop, &n, &error));
+    mongolite_cursor_destroy(cursor);
+    assert_int_equal(3, stop.calls);
+    assert_true(n > 0 && n < 200);
+    free(stop.data);
+}
+
+static void test_fd_and_empty(void **state) {
+    (void)state;
+    gerror_t error = {0};
+    insert_items(3);
+
+    char path[] = "/tmp/mongolite_json_XXXXXX";
+    int fd = mkstemp(path);
+    assert_true(fd >= 0);
+
+    mongolite_json_opts_t opts = {MONGOLITE_JSON_LINES, MONGOLITE_JSON_RELAXED, 64};
+    int64_t n = 0;
+    mongolite_cursor_t *cursor = mongolite_find(g_db, "items", NULL, NULL, &error);
+    assert_int_equal(MONGOLITE_OK, mongolite_cursor_write_json_fd(cursor, &opts, fd, &n, &error));
+    mongolite_cursor_destroy(cursor);
+    assert_int_equal(3, n);
+
+    char buf[4096];
+    ssize_t len = pread(fd, buf, sizeof(buf) - 1, 0);
+    assert_true(len > 0);
+    buf[len] = '\0';
+    int lines = 0;
+    for (char *p = buf; *p; p++) lines += *p == '\n';
+    assert_int_equal(3, lines);
+    close(fd);
+    unlink(path);
+
+    /* Closed descriptor: write fails with MONGOLITE_EIO */
+    cursor = mongolite_find(g_db, "items", NULL, NULL, &error);
+    assert_int_equal(MONGOLITE_EIO, mongolite_cursor_write_json_fd(cursor, &opts, fd, NULL, &error));
+    mongolite_cursor_destroy(cursor);
+
+    /* No match: an empty array, nothing for JSON lines */
+    bson_t *filter = BCON_NEW("n", BCON_INT32(-1));
+    char *json = write_json(NULL, filter, &n);
+    assert_string_equal("[]", json);
+    assert_int_equal(0, n);
+    free(json);
+    opts.format = MONGOLITE_JSON_LINES;
+    json = write_json(&opts, filter, &n);
+    assert_null(json);
+    bson_destroy(filter);
+}
+
+/* ============================================================
+ * Test Runner
+ * ============================================================ */
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_array_output, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_lines_output, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_canonical_round_trip, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_relaxed_forms, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_chunks_and_cancel, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_fd_and_empty, setup, teardown),
+    };
+
+    return cmocka_run_group_tests_name("tests", tests, NULL, NULL);
+}
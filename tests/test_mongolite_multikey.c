@@ -0,0 +1,564 @@
+/**
+ * test_mongolite_multikey.c - Tests for multi-key indexes over array fields
+ *
+ * Tests:
+ * - Extracted keys: one per element, cartesian over compound fields,
+ *   distinct and sorted; scalar documents keep their single key; dotted
+ *   paths through arrays of documents; the key bound
+ * - Element equality, $in and compound equality: same documents as
+ *   without the index, each once, through an index seek; whole-array
+ *   equality falls back to a scan
+ * - Counts with equality and ranges: no document counted twice, and a
+ *   range with both bounds left to the matcher
+ * - Unique multi-key indexes reject shared elements
+ * - Updates and deletes maintain the element keys; verify passes
+ * - Indexes created before multi-key support (whole-array keys) are
+ *   maintained but not used by find, find_one or count, also after
+ *   reopening
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "mongolite.h"
+#include "mongolite_internal.h"
+#include "key_compare.h"
+
+/* ============================================================
+ * Test Setup/Teardown
+ * ============================================================ */
+
+static mongolite_db_t *g_db = NULL;
+static const char *DB_PATH = "./test_multikey_db";
+
+#define N_ITEMS 300
+
+static const char *COLORS[] = {"red", "green", "blue", "black"};
+
+static void cleanup_db_path(void) {
+    char cmd[256];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", DB_PATH);
+    system(cmd);
+}
+
+static int setup(void **state) {
+    (void)state;
+    cleanup_db_path();
+
+    gerror_t error = {0};
+    db_config_t config = {0};
+    config.max_bytes = 64ULL * 1024 * 1024;
+    if (mongolite_open(DB_PATH, &g_db, &config, &error) != 0) return -1;
+    if (mongolite_collection_create(g_db, "items", NULL, &error) != 0) return -1;
+    return mongolite_collection_create(g_db, "plain", NULL, &error);
+}
+
+static int teardown(void **state) {
+    (void)state;
+    if (g_db) {
+        mongolite_close(g_db);
+        g_db = NULL;
+    }
+    cleanup_db_path();
+    return 0;
+}
+
+/* Items 0..N_ITEMS-1 in "items" and "plain": tags an array of colors
+ * (with repeats), a single color, an empty array or missing; scores an
+ * array of numbers or one; a an array of {b: ...} documents or one */
+static void insert_items(void) {
+    gerror_t error = {0};
+    for (int i = 0; i < N_ITEMS; i++) {
+        bson_t doc, arr, sub;
+        bson_init(&doc);
+        BSON_APPEND_INT32(&doc, "n", i);
+
+        if (i % 7 == 5) {
+            BSON_APPEND_UTF8(&doc, "tags", COLORS[i % 4]);
+        } else if (i % 7 != 6) {
+            BSON_APPEND_ARRAY_BEGIN(&doc, "tags", &arr);
+            for (int j = 0; i % 7 != 4 && j <= i % 3; j++) {
+                char key[8];
+                snprintf(key, sizeof(key), "%d", j);
+                BSON_APPEND_UTF8(&arr, key, COLORS[(i + j * j) % 4]);
+            }
+            bson_append_array_end(&doc, &arr);
+        }
+
+        if (i % 11 == 0) {
+            BSON_APPEND_INT32(&doc, "scores", i % 100);
+        } else {
+            BSON_APPEND_ARRAY_BEGIN(&doc, "scores", &arr);
+            for (int j = 0; j <= i % 3; j++) {
+                char key[8];
+                snprintf(key, sizeof(key), "%d", j);
+                BSON_APPEND_INT32(&arr, key, (i * 7 + j * 31) % 100);
+            }
+            bson_append_array_end(&doc, &arr);
+        }
+
+        if (i % 2 == 0) {
+            BSON_APPEND_ARRAY_BEGIN(&doc, "a", &arr);
+            BSON_APPEND_DOCUMENT_BEGIN(&arr, "0", &sub);
+            BSON_APPEND_INT32(&sub, "b", i % 5);
+            bson_append_document_end(&arr, &sub);
+            BSON_APPEND_DOCUMENT_BEGIN(&arr, "1", &sub);
+            BSON_APPEND_INT32(&sub, "b", (i + 2) % 5);
+            bson_append_document_end(&arr, &sub);
+            bson_append_array_end(&doc, &arr);
+        } else {
+            BSON_APPEND_DOCUMENT_BEGIN(&doc, "a", &sub);
+            BSON_APPEND_INT32(&sub, "b", i % 5);
+            bson_append_document_end(&doc, &sub);
+        }
+
+        assert_int_equal(MONGOLITE_OK, mongolite_insert_one(g_db, "items", &doc, NULL, &error));
+        assert_int_equal(MONGOLITE_OK, mongolite_insert_one(g_db, "plain", &doc, NULL, &error));
+        bson_destroy(&doc);
+    }
+}
+
+static void create_index(const char *collection, bson_t *keys, bool unique) {
+    gerror_t error = {0};
+    index_config_t config = {0};
+    config.unique = unique;
+    assert_int_equal(MONGOLITE_OK,
+                     mongolite_create_index(g_db, collection, keys, NULL, &config, &error));
+    bson_destroy(keys);
+}
+
+/* The "n" fields of the documents matching filter; returns how many */
+static size_t collect(const char *collection, const bson_t *filter, int *out, size_t max) {
+    gerror_t error = {0};
+    mongolite_cursor_t *cursor = mongolite_find(g_db, collection, filter, NULL, &error);
+    assert_non_null(cursor);
+
+    size_t n = 0;
+    const bson_t *doc;
+    while (mongolite_cursor_next(cursor, &doc)) {
+        bson_iter_t iter;
+        assert_true(bson_iter_init_find(&iter, doc, "n"));
+        if (n < max) out[n] = bson_iter_int32(&iter);
+        n++;
+    }
+    mongolite_cursor_destroy(cursor);
+    return n;
+}
+
+static int cmp_int(const void *a, const void *b) {
+    return *(const int *)a - *(const int *)b;
+}
+
+/* The filter finds and counts the same documents with and without the
+ * index, each once */
+static size_t assert_same_as_scan(const bson_t *filter) {
+    static int a[N_ITEMS * 4], b[N_ITEMS * 4];
+    gerror_t error = {0};
+    size_t na = collect("items", filter, a, N_ITEMS * 4);
+    size_t nb = collect("plain", filter, b, N_ITEMS * 4);
+    assert_int_equal(nb, na);
+    qsort(a, na, sizeof(int), cmp_int);
+    qsort(b, nb, sizeof(int), cmp_int);
+    assert_memory_equal(a, b, na * sizeof(int));
+    for (size_t i = 1; i < na; i++) assert_true(a[i - 1] < a[i]);
+
+    assert_int_equal((int64_t)nb, mongolite_collection_count(g_db, "items", filter, &error));
+    assert_int_equal((int64_t)nb, mongolite_collection_count(g_db, "plain", filter, &error));
+    return na;
+}
+
+static const char *winning_stage(const bson_t *filter) {
+    static char stage[32];
+    gerror_t error = {0};
+    bson_t *report = mongolite_explain(g_db, "items", filter, NULL, NULL, &error);
+    assert_non_null(report);
+    bson_iter_t iter, found;
+    assert_true(bson_iter_init(&iter, report));
+    if (bson_iter_find_descendant(&iter, "queryPlanner.winningPlan.inputStage.stage", &found)) {
+        snprintf(stage, sizeof(stage), "%s", bson_iter_utf8(&found, NULL));
+    } else {
+        snprintf(stage, sizeof(stage), "COLLSCAN");
+    }
+    bson_destroy(report);
+    return stage;
+}
+
+/* Extract keys with the multi-key extractor; returns how many (-1: the
+ * document cannot be indexed) */
+static int extract(const bson_t *doc, const bson_t *keys, bson_t *out, int max) {
+    void *buf = NULL;
+    size_t len = 0;
+    if (!_mongolite_multikey_extractor(bson_get_data(doc), doc->len, (void *)bson_get_data(keys),
+                                       &buf, &len)) {
+        return 0;
+    }
+    if (!buf) return -1;
+
+    int n = 0;
+    size_t pos = 0;
+    while (pos < len) {
+        uint32_t klen;
+        memcpy(&klen, (uint8_t *)buf + pos, sizeof(klen));
+        if (n < max) {
+            bson_t key;
+            assert_true(bson_init_static(&key, (uint8_t *)buf + pos + sizeof(klen), klen));
+            bson_copy_to(&key, &out[n]);
+        }
+        n++;
+        pos += sizeof(klen) + klen;
+    }
+    assert_int_equal(len, pos);
+    free(buf);
+    return n;
+}
+
+/* ============================================================
+ * Tests
+ * ============================================================ */
+
+static void test_multikey_keys(void **state) {
+    (void)state;
+    bson_t out[8];
+
+    /* Scalars: the key bson_extract_index_key builds */
+    bson_t *keys = BCON_NEW("tags", BCON_INT32(1), "s", BCON_INT32(1));
+    bson_t *doc = BCON_NEW("tags", BCON_UTF8("x"), "s", BCON_INT32(3));
+    assert_int_equal(1, extract(doc, keys, out, 8));
+    bson_t *single = bson_extract_index_key(doc, keys);
+    assert_true(bson_equal(single, &out[0]));
+    bson_destroy(single);
+    bson_destroy(&out[0]);
+    bson_destroy(doc);
+
+    /* Cartesian product, distinct and sorted */
+    doc = BCON_NEW("tags", "[", BCON_UTF8("y"), BCON_UTF8("x"), BCON_UTF8("y"), "]",
+                   "s", "[", BCON_INT32(2), BCON_DOUBLE(1.0), BCON_INT32(1), "]");
+    assert_int_equal(4, extract(doc, keys, out, 8));
+    for (int i = 1; i < 4; i++) assert_true(bson_compare_docs(&out[i - 1], &out[i]) < 0);
+    bson_t *first = BCON_NEW("tags", BCON_UTF8("x"), "s", BCON_DOUBLE(1.0));
+    assert_int_equal(0, bson_compare_docs(first, &out[0]));
+    bson_destroy(first);
+    for (int i = 0; i < 4; i++) bson_destroy(&out[i]);
+    bson_destroy(doc);
+
+    /* Missing: null; empty array: itself */
+    doc = BCON_NEW("tags", "[", "]");
+    assert_int_equal(1, extract(doc, keys, out, 8));
+    bson_t *expected = BCON_NEW("tags", "[", "]", "s", BCON_NULL);
+    assert_true(bson_equal(expected, &out[0]));
+    bson_destroy(expected);
+    bson_destroy(&out[0]);
+    bson_destroy(doc);
+    bson_destroy(keys);
+
+    /* Dotted paths continue into arrays of documents */
+    keys = BCON_NEW("a.b", BCON_INT32(1));
+    doc = BCON_NEW("a", "[", "{", "b", BCON_INT32(2), "}", "{", "c", BCON_INT32(9), "}",
+                   "{", "b", "[", BCON_INT32(1), BCON_INT32(2), "]", "}", "]");
+    assert_int_equal(2, extract(doc, keys, out, 8));
+    expected = BCON_NEW("a.b", BCON_INT32(1));
+    assert_true(bson_equal(expected, &out[0]));
+    bson_destroy(expected);
+    for (int i = 0; i < 2; i++) bson_destroy(&out[i]);
+    bson_destroy(doc);
+    bson_destroy(keys);
+
+    /* 32 x 33 keys exceed the bound */
+    keys = BCON_NEW("x", BCON_INT32(1), "y", BCON_INT32(1));
+    bson_t big, xs, ys;
+    bson_init(&big);
+    BSON_APPEND_ARRAY_BEGIN(&big, "x", &xs);
+    for (int i = 0; i < 32; i++) {
+        char key[8];
+        snprintf(key, sizeof(key), "%d", i);
+        BSON_APPEND_INT32(&xs, key, i);
+    }
+    bson_append_array_end(&big, &xs);
+    BSON_APPEND_ARRAY_BEGIN(&big, "y", &ys);
+    for (int i = 0; i < 33; i++) {
+        char key[8];
+        snprintf(key, sizeof(key), "%d", i);
+        BSON_APPEND_INT32(&ys, key, i);
+    }
+    bson_append_array_end(&big, &ys);
+    assert_int_equal(-1, extract(&big, keys, out, 8));
+    bson_destroy(&big);
+    bson_destroy(keys);
+}
+
+static void test_multikey_equality(void **state) {
+    (void)state;
+    insert_items();
+    create_index("items", BCON_NEW("tags", BCON_INT32(1)), false);
+
+    size_t count;
+    gerror_t error = {0};
+    mongolite_cached_index_t *cached = _mongolite_get_cached_indexes(g_db, "items", &count,
+                                                                     &error);
+    assert_non_null(cached);
+    assert_int_equal(1, count);
+    assert_true(cached[0].multikey);
+
+    for (int c = 0; c < 4; c++) {
+        bson_t *filter = BCON_NEW("tags", BCON_UTF8(COLORS[c]));
+        assert_true(assert_same_as_scan(filter) > 20);
+        assert_string_equal("IXSCAN", winning_stage(filter));
+
+        bson_t *doc = mongolite_find_one(g_db, "items", filter, NULL, &error);
+        assert_non_null(doc);
+        bson_destroy(doc);
+        bson_destroy(filter);
+    }
+
+    bson_t *filter = BCON_NEW("tags", "{", "$in", "[", BCON_UTF8("red"), BCON_UTF8("blue"),
+                              "]", "}");
+    assert_true(assert_same_as_scan(filter) > 40);
+    bson_destroy(filter);
+
+    /* The whole array is not a key of the index */
+    filter = BCON_NEW("tags", "[", BCON_UTF8("green"), BCON_UTF8("blue"), "]");
+    assert_true(assert_same_as_scan(filter) > 0);
+    assert_string_equal("COLLSCAN", winning_stage(filter));
+    bson_t *doc = mongolite_find_one(g_db, "items", filter, NULL, &error);
+    assert_non_null(doc);
+    bson_destroy(doc);
+    bson_destroy(filter);
+
+    filter = BCON_NEW("tags", "[", "]");
+    assert_same_as_scan(filter);
+    bson_destroy(filter);
+}
+
+static void test_multikey_compound(void **state) {
+    (void)state;
+    insert_items();
+    create_index("items", BCON_NEW("tags", BCON_INT32(1), "a.b", BCON_INT32(1)), false);
+
+    for (int c = 0; c < 4; c++) {
+        for (int b = 0; b < 5; b++) {
+            bson_t *filter = BCON_NEW("tags", BCON_UTF8(COLORS[c]), "a.b", BCON_INT32(b));
+            assert_same_as_scan(filter);
+            bson_destroy(filter);
+        }
+    }
+
+    /* A key prefix */
+    bson_t *filter = BCON_NEW("tags", BCON_UTF8("red"));
+    assert_true(assert_same_as_scan(filter) > 20);
+    bson_destroy(filter);
+}
+
+static void test_multikey_count(void **state) {
+    (void)state;
+    gerror_t error = {0};
+    insert_items();
+    create_index("items", BCON_NEW("scores", BCON_INT32(1)), false);
+    create_index("items", BCON_NEW("tags", BCON_INT32(1), "scores", BCON_INT32(1)), false);
+
+    mongolite_tree_cache_entry_t *entry = _mongolite_get_collection_entry(g_db, "items", NULL);
+    assert_non_null(entry);
+
+    /* One bound: answered by the index, each document once */
+    bson_t *filter = BCON_NEW("scores", "{", "$gt", BCON_INT32(50), "}");
+    int64_t n = -1;
+    assert_int_equal(1, _mongolite_count_with_index(g_db, entry, filter, &n, &error));
+    assert_int_equal(n, assert_same_as_scan(filter));
+    bson_destroy(filter);
+
+    filter = BCON_NEW("scores", "{", "$lte", BCON_INT32(10), "}");
+    assert_int_equal(1, _mongolite_count_with_index(g_db, entry, filter, &n, &error));
+    assert_int_equal(n, assert_same_as_scan(filter));
+    bson_destroy(filter);
+
+    /* Both bounds: two elements may each satisfy one */
+    filter = BCON_NEW("scores", "{", "$gt", BCON_INT32(20), "$lt", BCON_INT32(30), "}");
+    assert_int_equal(0, _mongolite_count_with_index(g_db, entry, filter, &n, &error));
+    assert_true(assert_same_as_scan(filter) > 0);
+    bson_destroy(filter);
+
+    /* Equality prefix, then a range */
+    filter = BCON_NEW("tags", BCON_UTF8("red"), "scores", "{", "$gte", BCON_INT32(40), "}");
+    assert_int_equal(1, _mongolite_count_with_index(g_db, entry, filter, &n, &error));
+    assert_int_equal(n, assert_same_as_scan(filter));
+    bson_destroy(filter);
+
+    filter = BCON_NEW("scores", BCON_INT32(31));
+    assert_int_equal(1, _mongolite_count_with_index(g_db, entry, filter, &n, &error));
+    assert_int_equal(n, assert_same_as_scan(filter));
+    bson_destroy(filter);
+}
+
+static void test_multikey_unique(void **state) {
+    (void)state;
+    gerror_t error = {0};
+    create_index("items", BCON_NEW("codes", BCON_INT32(1)), true);
+
+    bson_t *doc = BCON_NEW("n", BCON_INT32(1), "codes", "[", BCON_INT32(1), BCON_INT32(2), "]");
+    assert_int_equal(MONGOLITE_OK, mongolite_insert_one(g_db, "items", doc, NULL, &error));
+    bson_destroy(doc);
+
+    /* Repeats within a document are one key */
+    doc = BCON_NEW("n", BCON_INT32(2), "codes", "[", BCON_INT32(3), BCON_DOUBLE(3.0), "]");
+    assert_int_equal(MONGOLITE_OK, mongolite_insert_one(g_db, "items", doc, NULL, &error));
+    bson_destroy(doc);
+
+    doc = BCON_NEW("n", BCON_INT32(3), "codes", "[", BCON_INT32(4), BCON_INT32(2), "]");
+    assert_int_not_equal(MONGOLITE_OK, mongolite_insert_one(g_db, "items", doc, NULL, &error));
+    bson_destroy(doc);
+
+    doc = BCON_NEW("n", BCON_INT32(4), "codes", BCON_INT32(1));
+    assert_int_not_equal(MONGOLITE_OK, mongolite_insert_one(g_db, "items", doc, NULL, &error));
+    bson_destroy(doc);
+
+    bson_t *filter = BCON_NEW("n", BCON_INT32(2));
+    bson_t *update = BCON_NEW("$push", "{", "codes", BCON_INT32(1), "}");
+    assert_int_not_equal(MONGOLITE_OK,
+                         mongolite_update_one(g_db, "items", filter, update, false, &error));
+    bson_destroy(update);
+    bson_destroy(filter);
+
+    filter = BCON_NEW("codes", BCON_INT32(2));
+    int got[4];
+    assert_int_equal(1, collect("items", filter, got, 4));
+    assert_int_equal(1, got[0]);
+    bson_destroy(filter);
+}
+
+static void test_multikey_maintenance(void **state) {
+    (void)state;
+    gerror_t error = {0};
+    insert_items();
+    create_index("items", BCON_NEW("tags", BCON_INT32(1)), false);
+
+    bson_t *white = BCON_NEW("tags", BCON_UTF8("white"));
+    int got[4];
+    assert_int_equal(0, collect("items", white, got, 4));
+
+    /* Add an element, then remove the others */
+    bson_t *filter = BCON_NEW("n", BCON_INT32(0));
+    bson_t *update = BCON_NEW("$push", "{", "tags", BCON_UTF8("white"), "}");
+    assert_int_equal(MONGOLITE_OK,
+                     mongolite_update_one(g_db, "items", filter, update, false, &error));
+    bson_destroy(update);
+    assert_int_equal(1, collect("items", white, got, 4));
+    assert_int_equal(0, got[0]);
+
+    update = BCON_NEW("$set", "{", "tags", "[", BCON_UTF8("white"), "]", "}");
+    assert_int_equal(MONGOLITE_OK,
+                     mongolite_update_one(g_db, "items", filter, update, false, &error));
+    bson_destroy(update);
+    bson_t *red = BCON_NEW("tags", BCON_UTF8("red"));
+    size_t reds = collect("items", red, got, 0);
+    assert_int_equal(1, collect("items", white, got, 4));
+
+    assert_int_equal(MONGOLITE_OK, mongolite_delete_one(g_db, "items", filter, &error));
+    bson_destroy(filter);
+    assert_int_equal(0, collect("items", white, got, 4));
+    assert_int_equal(reds, collect("items", red, got, 0));
+    bson_destroy(red);
+    bson_destroy(white);
+
+    wtree3_tree_t *tree = _mongolite_tree_cache_get(g_db, "items");
+    assert_non_null(tree);
+    assert_int_equal(0, wtree3_verify_indexes(tree, &error));
+
+    /* A document with too many keys cannot be written or indexed */
+    bson_t doc, arr;
+    bson_init(&doc);
+    BSON_APPEND_ARRAY_BEGIN(&doc, "tags", &arr);
+    for (int i = 0; i < MONGOLITE_INDEX_MAX_KEYS + 1; i++) {
+        char key[8];
+        snprintf(key, sizeof(key), "%d", i);
+        BSON_APPEND_INT32(&arr, key, i);
+    }
+    bson_append_array_end(&doc, &arr);
+    assert_int_not_equal(MONGOLITE_OK, mongolite_insert_one(g_db, "items", &doc, NULL, &error));
+    assert_int_equal(MONGOLITE_OK, mongolite_insert_one(g_db, "plain", &doc, NULL, &error));
+    bson_destroy(&doc);
+
+    bson_t *keys = BCON_NEW("tags", BCON_INT32(1));
+    assert_int_not_equal(MONGOLITE_OK,
+                         mongolite_create_index(g_db, "plain", keys, NULL, NULL, &error));
+    bson_destroy(keys);
+}
+
+static void test_multikey_legacy_index(void **state) {
+    (void)state;
+    gerror_t error = {0};
+    insert_items();
+
+    /* An index as created before multi-key support */
+    bson_t *keys = BCON_NEW("tags", BCON_INT32(1));
+    wtree3_tree_t *tree = _mongolite_get_collection_tree(g_db, "items", &error);
+    assert_non_null(tree);
+    wtree3_index_config_t config = {
+        .name = "tags_1",
+        .user_data = (void *)bson_get_data(keys),
+        .user_data_len = keys->len,
+        .compare = _mongolite_index_compare,
+    };
+    assert_int_equal(0, wtree3_tree_add_index(tree, &config, &error));
+    assert_int_equal(0, wtree3_tree_populate_index(tree, "tags_1", &error));
+    _mongolite_invalidate_index_cache(g_db, "items");
+    bson_destroy(keys);
+
+    for (int pass = 0; pass < 2; pass++) {
+        size_t count;
+        mongolite_cached_index_t *cached = _mongolite_get_cached_indexes(g_db, "items", &count,
+                                                                         &error);
+        assert_non_null(cached);
+        assert_int_equal(1, count);
+        assert_false(cached[0].multikey);
+        assert_true(cached[0].legacy);
+
+        for (int c = 0; c < 4; c++) {
+            bson_t *filter = BCON_NEW("tags", BCON_UTF8(COLORS[c]));
+            assert_true(assert_same_as_scan(filter) > 20);
+            assert_string_equal("COLLSCAN", winning_stage(filter));
+
+            bson_t *doc = mongolite_find_one(g_db, "items", filter, NULL, &error);
+            assert_non_null(doc);
+            bson_destroy(doc);
+            bson_destroy(filter);
+        }
+        bson_t *filter = BCON_NEW("tags", "{", "$in", "[", BCON_UTF8("red"),
+                                  BCON_UTF8("blue"), "]", "}");
+        assert_same_as_scan(filter);
+        bson_destroy(filter);
+
+        /* Still maintained */
+        tree = _mongolite_tree_cache_get(g_db, "items");
+        assert_non_null(tree);
+        assert_int_equal(0, wtree3_verify_indexes(tree, &error));
+
+        mongolite_close(g_db);
+        g_db = NULL;
+        db_config_t db_config = {0};
+        db_config.max_bytes = 64ULL * 1024 * 1024;
+        assert_int_equal(0, mongolite_open(DB_PATH, &g_db, &db_config, &error));
+    }
+}
+
+/* ============================================================
+ * Test Runner
+ * ============================================================ */
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_multikey_keys, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_multikey_equality, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_multikey_compound, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_multikey_count, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_multikey_unique, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_multikey_maintenance, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_multikey_legacy_index, setup, teardown),
+    };
+
+    return cmocka_run_group_tests_name("tests", tests, NULL, NULL);
+}
@@ -0,0 +1,261 @@
+/**
+ * test_mongolite_readahead.c - Tests for scan and index-fetch readahead
+ *
+ * Tests:
+ * - A filtered scan hints the pages ahead of it; results are unchanged
+ * - disable_readahead issues no hints
+ * - Parallel scan workers hint their own ranges
+ * - Prepared index seeks fetch in batches: every row, in _id order,
+ *   with the residual filter applied; large documents are hinted
+ * - Inside a write session the seek sees the session's own writes
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "mongolite.h"
+#include "mongolite_internal.h"
+
+/* ============================================================
+ * Test Setup/Teardown
+ * ============================================================ */
+
+static mongolite_db_t *g_db = NULL;
+static const char *DB_PATH = "./test_readahead_db";
+
+static void cleanup_db_path(void) {
+    char cmd[256];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", DB_PATH);
+    system(cmd);
+}
+
+static int open_db(size_t window, bool disable, unsigned int threads) {
+    gerror_t error = {0};
+    db_config_t config = {0};
+    config.max_bytes = 64ULL * 1024 * 1024;
+    config.readahead_bytes = window;
+    config.disable_readahead = disable;
+    config.scan_threads = threads;
+    config.scan_parallel_min_docs = 1;
+    return mongolite_open(DB_PATH, &g_db, &config, &error);
+}
+
+static void reopen_db(size_t window, bool disable, unsigned int threads) {
+    mongolite_close(g_db);
+    g_db = NULL;
+    assert_int_equal(0, open_db(window, disable, threads));
+}
+
+static int setup(void **state) {
+    (void)state;
+    cleanup_db_path();
+
+    gerror_t error = {0};
+    if (open_db(64 * 1024, false, 0) != 0) return -1;
+    return mongolite_collection_create(g_db, "items", NULL, &error);
+}
+
+static int teardown(void **state) {
+    (void)state;
+    if (g_db) {
+        mongolite_close(g_db);
+        g_db = NULL;
+    }
+    cleanup_db_path();
+    return 0;
+}
+
+/* n documents with pad bytes each; grp = i % groups */
+static void insert_docs(int n, int groups, size_t pad_len) {
+    gerror_t error = {0};
+    char *pad = malloc(pad_len + 1);
+    memset(pad, 'x', pad_len);
+    pad[pad_len] = '\0';
+
+    bson_t **docs = calloc((size_t)n, sizeof(bson_t *));
+    for (int i = 0; i < n; i++) {
+        docs[i] = BCON_NEW("n", BCON_INT32(i), "grp", BCON_INT32(i % groups),
+                           "pad", BCON_UTF8(pad));
+    }
+    assert_int_equal(0, mongolite_insert_many(g_db, "items", (const bson_t **)docs,
+                                              (size_t)n, NULL, &error));
+    for (int i = 0; i < n; i++) bson_destroy(docs[i]);
+    free(docs);
+    free(pad);
+}
+
+static void create_grp_index(void) {
+    gerror_t error = {0};
+    bson_t *keys = BCON_NEW("grp", BCON_INT32(1));
+    assert_int_equal(0, mongolite_create_index(g_db, "items", keys, NULL, NULL, &error));
+    bson_destroy(keys);
+}
+
+static uint64_t hints(void) {
+    gerror_t error = {0};
+    mongolite_stats_t stats;
+    assert_int_equal(MONGOLITE_OK, mongolite_stats(g_db, &stats, &error));
+    return stats.readahead_hints;
+}
+
+/* Matching documents, checking n ascends (insert order = _id order) */
+static int find_grp(int grp) {
+    gerror_t error = {0};
+    bson_t *filter = BCON_NEW("grp", BCON_INT32(grp));
+    mongolite_cursor_t *cursor = mongolite_find(g_db, "items", filter, NULL, &error);
+    bson_destroy(filter);
+    assert_non_null(cursor);
+
+    const bson_t *doc;
+    int count = 0, last = -1;
+    while (mongolite_cursor_next(cursor, &doc)) {
+        bson_iter_t it;
+        assert_true(bson_iter_init_find(&it, doc, "n"));
+        assert_true(bson_iter_int32(&it) > last);
+        last = bson_iter_int32(&it);
+        count++;
+    }
+    mongolite_cursor_destroy(cursor);
+    return count;
+}
+
+/* Rows of a prepared {grp: $1, n: {$gte: $2}} seek, checking n ascends */
+static int step_grp(mongolite_stmt_t *stmt, int grp, int min_n) {
+    gerror_t error = {0};
+    assert_int_equal(MONGOLITE_OK, mongolite_bind_int32(stmt, 1, grp));
+    assert_int_equal(MONGOLITE_OK, mongolite_bind_int32(stmt, 2, min_n));
+
+    const bson_t *doc;
+    int rc, count = 0, last = -1;
+    while ((rc = mongolite_step(stmt, &doc, &error)) == MONGOLITE_ROW) {
+        bson_iter_t it;
+        assert_true(bson_iter_init_find(&it, doc, "grp"));
+        assert_int_equal(grp, bson_iter_int32(&it));
+        assert_true(bson_iter_init_find(&it, doc, "n"));
+        assert_true(bson_iter_int32(&it) > last);
+        assert_true(bson_iter_int32(&it) >= min_n);
+        last = bson_iter_int32(&it);
+        count++;
+    }
+    assert_int_equal(MONGOLITE_DONE, rc);
+    return count;
+}
+
+static mongolite_stmt_t* prepare_grp(void) {
+    gerror_t error = {0};
+    bson_t *filter = BCON_NEW("grp", "{", "$param", BCON_INT32(1), "}",
+                              "n", "{", "$gte", "{", "$param", BCON_INT32(2), "}", "}");
+    mongolite_stmt_t *stmt = mongolite_prepare(g_db, "items", filter, NULL, &error);
+    bson_destroy(filter);
+    assert_non_null(stmt);
+    return stmt;
+}
+
+/* ============================================================
+ * Tests
+ * ============================================================ */
+
+static void test_scan_hints(void **state) {
+    (void)state;
+    insert_docs(2000, 4, 900);
+
+    uint64_t before = hints();
+    assert_int_equal(500, find_grp(1));
+    assert_true(hints() - before >= 4);     /* ~2MB of documents, 64KB windows */
+}
+
+static void test_readahead_disabled(void **state) {
+    (void)state;
+    insert_docs(2000, 4, 900);
+    reopen_db(0, true, 0);
+
+    uint64_t before = hints();
+    assert_int_equal(500, find_grp(1));
+    assert_int_equal(before, hints());
+}
+
+static void test_parallel_scan_hints(void **state) {
+    (void)state;
+    insert_docs(4000, 4, 900);
+    reopen_db(64 * 1024, false, 4);
+
+    uint64_t before = hints();
+    gerror_t error = {0};
+    bson_t *filter = BCON_NEW("grp", BCON_INT32(2));
+    assert_int_equal(1000, mongolite_collection_count(g_db, "items", filter, &error));
+    bson_destroy(filter);
+    assert_true(hints() - before >= 4);
+}
+
+static void test_stmt_index_batches(void **state) {
+    (void)state;
+    /* 3000-byte documents sit on overflow pages; 3 groups of 100 rows
+     * span several fetch batches */
+    insert_docs(300, 3, 3000);
+    create_grp_index();
+
+    mongolite_stmt_t *stmt = prepare_grp();
+    uint64_t before = hints();
+    assert_int_equal(100, step_grp(stmt, 1, 0));
+    assert_true(hints() - before >= 100);
+
+    /* Residual filter on the fetched rows; re-execution starts over */
+    assert_int_equal(50, step_grp(stmt, 1, 150));
+    assert_int_equal(100, step_grp(stmt, 2, 0));
+    assert_int_equal(0, step_grp(stmt, 7, 0));
+
+    /* Reset mid-batch, then run again */
+    gerror_t error = {0};
+    const bson_t *doc;
+    assert_int_equal(MONGOLITE_OK, mongolite_bind_int32(stmt, 1, 0));
+    assert_int_equal(MONGOLITE_OK, mongolite_bind_int32(stmt, 2, 0));
+    assert_int_equal(MONGOLITE_ROW, mongolite_step(stmt, &doc, &error));
+    assert_int_equal(MONGOLITE_ROW, mongolite_step(stmt, &doc, &error));
+    assert_int_equal(MONGOLITE_OK, mongolite_reset(stmt));
+    assert_int_equal(100, step_grp(stmt, 0, 0));
+
+    mongolite_finalize(stmt);
+}
+
+static void test_stmt_index_in_session(void **state) {
+    (void)state;
+    insert_docs(100, 2, 100);
+    create_grp_index();
+
+    gerror_t error = {0};
+    mongolite_stmt_t *stmt = prepare_grp();
+    mongolite_session_t *session = mongolite_session_begin(g_db, MONGOLITE_SESSION_WRITE, &error);
+    assert_non_null(session);
+
+    bson_t *doc = BCON_NEW("n", BCON_INT32(1000), "grp", BCON_INT32(1));
+    assert_int_equal(0, mongolite_insert_one(g_db, "items", doc, NULL, &error));
+    bson_destroy(doc);
+
+    /* The seek reads the session's txn, including the uncommitted row */
+    assert_int_equal(51, step_grp(stmt, 1, 0));
+    mongolite_session_abort(session);
+
+    assert_int_equal(50, step_grp(stmt, 1, 0));
+    mongolite_finalize(stmt);
+}
+
+/* ============================================================
+ * Test Runner
+ * ============================================================ */
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_scan_hints, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_readahead_disabled, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_parallel_scan_hints, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_stmt_index_batches, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_stmt_index_in_session, setup, teardown),
+    };
+
+    return cmocka_run_group_tests_name("tests", tests, NULL, NULL);
+}
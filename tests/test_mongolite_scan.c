@@ -0,0 +1,335 @@
+/**
+ * test_mongolite_scan.c - Tests for parallel collection scans
+ *
+ * Tests:
+ * - Filtered count matches a serial count, on _ids spread over time too
+ * - find returns every match in _id order; unordered returns the same set
+ * - A finished cursor reports no read error
+ * - skip / limit on a parallel cursor
+ * - delete_many removes exactly the matches
+ * - A parallel cursor reads one snapshot; later writes are not seen
+ * - Sessions, small collections and empty filters stay serial
+ * - Invalid filters fail the call
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "mongolite.h"
+#include "mongolite_internal.h"
+
+/* ============================================================
+ * Test Setup/Teardown
+ * ============================================================ */
+
+static mongolite_db_t *g_db = NULL;
+static const char *DB_PATH = "./test_scan_db";
+
+enum { DOCS = 5000 };
+
+static void cleanup_db_path(void) {
+    char cmd[256];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", DB_PATH);
+    system(cmd);
+}
+
+static int open_db(unsigned int threads, uint64_t min_docs) {
+    gerror_t error = {0};
+    db_config_t config = {0};
+    config.max_bytes = 64ULL * 1024 * 1024;
+    config.scan_threads = threads;
+    config.scan_parallel_min_docs = min_docs;
+    return mongolite_open(DB_PATH, &g_db, &config, &error);
+}
+
+static void reopen_db(unsigned int threads, uint64_t min_docs) {
+    mongolite_close(g_db);
+    g_db = NULL;
+    assert_int_equal(0, open_db(threads, min_docs));
+}
+
+static int setup(void **state) {
+    (void)state;
+    cleanup_db_path();
+
+    gerror_t error = {0};
+    if (open_db(4, 100) != 0) return -1;
+    return mongolite_collection_create(g_db, "items", NULL, &error);
+}
+
+static int teardown(void **state) {
+    (void)state;
+    if (g_db) {
+        mongolite_close(g_db);
+        g_db = NULL;
+    }
+    cleanup_db_path();
+    return 0;
+}
+
+static void insert_docs(int n) {
+    gerror_t error = {0};
+    bson_t **docs = calloc((size_t)n, sizeof(bson_t *));
+    for (int i = 0; i < n; i++) {
+        docs[i] = BCON_NEW("n", BCON_INT32(i), "mod7", BCON_INT32(i % 7));
+    }
+    assert_int_equal(0, mongolite_insert_many(g_db, "items", (const bson_t **)docs,
+                                              (size_t)n, NULL, &error));
+    for (int i = 0; i < n; i++) bson_destroy(docs[i]);
+    free(docs);
+}
+
+/* _ids whose timestamps are a day apart: ranges split on the time bytes */
+static void insert_docs_over_time(int n) {
+    gerror_t error = {0};
+    for (int i = 0; i < n; i++) {
+        uint8_t raw[12] = {0};
+        uint32_t ts = 1600000000u + (uint32_t)i * 86400u;
+        raw[0] = (uint8_t)(ts >> 24);
+        raw[1] = (uint8_t)(ts >> 16);
+        raw[2] = (uint8_t)(ts >> 8);
+        raw[3] = (uint8_t)ts;
+        raw[11] = (uint8_t)i;
+        bson_oid_t oid;
+        bson_oid_init_from_data(&oid, raw);
+
+        bson_t *doc = BCON_NEW("_id", BCON_OID(&oid), "n", BCON_INT32(i),
+                               "mod7", BCON_INT32(i % 7));
+        assert_int_equal(0, mongolite_insert_one(g_db, "items", doc, NULL, &error));
+        bson_destroy(doc);
+    }
+}
+
+static uint64_t parallel_scans(void) {
+    gerror_t error = {0};
+    mongolite_stats_t stats;
+    assert_int_equal(MONGOLITE_OK, mongolite_stats(g_db, &stats, &error));
+    return stats.parallel_scans;
+}
+
+static int expected_mod7(int n, int value) {
+    int count = 0;
+    for (int i = 0; i < n; i++) {
+        if (i % 7 == value) count++;
+    }
+    return count;
+}
+
+/* ============================================================
+ * Tests
+ * ============================================================ */
+
+static void test_scan_count(void **state) {
+    (void)state;
+    gerror_t error = {0};
+    insert_docs(DOCS);
+
+    bson_t *filter = BCON_NEW("mod7", BCON_INT32(3));
+    uint64_t before = parallel_scans();
+    assert_int_equal(expected_mod7(DOCS, 3), mongolite_collection_count(g_db, "items", filter, &error));
+    assert_int_equal(before + 1, parallel_scans());
+
+    bson_t *range = BCON_NEW("n", "{", "$gte", BCON_INT32(100), "$lt", BCON_INT32(4100), "}");
+    assert_int_equal(4000, mongolite_collection_count(g_db, "items", range, &error));
+    bson_destroy(range);
+
+    /* Same answer serially */
+    reopen_db(0, 0);
+    assert_int_equal(expected_mod7(DOCS, 3), mongolite_collection_count(g_db, "items", filter, &error));
+    assert_int_equal(0, parallel_scans());
+    bson_destroy(filter);
+}
+
+static void test_scan_count_over_time(void **state) {
+    (void)state;
+    gerror_t error = {0};
+    insert_docs_over_time(1000);
+
+    bson_t *filter = BCON_NEW("mod7", BCON_INT32(0));
+    assert_int_equal(expected_mod7(1000, 0), mongolite_collection_count(g_db, "items", filter, &error));
+    assert_int_equal(1, parallel_scans());
+    bson_destroy(filter);
+}
+
+static void test_scan_find_ordered(void **state) {
+    (void)state;
+    gerror_t error = {0};
+    insert_docs(DOCS);
+
+    bson_t *filter = BCON_NEW("mod7", "{", "$ne", BCON_INT32(5), "}");
+    mongolite_cursor_t *cursor = mongolite_find(g_db, "items", filter, NULL, &error);
+    assert_non_null(cursor);
+    assert_int_equal(1, parallel_scans());
+
+    /* insert_many ids ascend with n */
+    const bson_t *doc;
+    int seen = 0, last = -1;
+    while (mongolite_cursor_next(cursor, &doc)) {
+        bson_iter_t it;
+        assert_true(bson_iter_init_find(&it, doc, "n"));
+        int n = bson_iter_int32(&it);
+        assert_true(n > last);
+        assert_int_not_equal(5, n % 7);
+        last = n;
+        seen++;
+    }
+    assert_int_equal(MONGOLITE_OK, mongolite_cursor_error(cursor, &error));
+    assert_false(mongolite_cursor_more(cursor));
+    mongolite_cursor_destroy(cursor);
+    assert_int_equal(DOCS - expected_mod7(DOCS, 5), seen);
+
+    /* Unordered: same documents */
+    cursor = mongolite_find(g_db, "items", filter, NULL, &error);
+    assert_int_equal(MONGOLITE_OK, mongolite_cursor_set_ordered(cursor, false));
+    char *hit = calloc(DOCS, 1);
+    seen = 0;
+    while (mongolite_cursor_next(cursor, &doc)) {
+        bson_iter_t it;
+        assert_true(bson_iter_init_find(&it, doc, "n"));
+        int n = bson_iter_int32(&it);
+        assert_int_equal(0, hit[n]);
+        hit[n] = 1;
+        seen++;
+    }
+    assert_int_equal(MONGOLITE_OK, mongolite_cursor_error(cursor, &error));
+    mongolite_cursor_destroy(cursor);
+    free(hit);
+    assert_int_equal(DOCS - expected_mod7(DOCS, 5), seen);
+    bson_destroy(filter);
+}
+
+static void test_scan_find_skip_limit(void **state) {
+    (void)state;
+    gerror_t error = {0};
+    insert_docs(DOCS);
+
+    bson_t *filter = BCON_NEW("mod7", BCON_INT32(1));
+    mongolite_cursor_t *cursor = mongolite_find(g_db, "items", filter, NULL, &error);
+    assert_non_null(cursor);
+    mongolite_cursor_set_skip(cursor, 10);
+    mongolite_cursor_set_limit(cursor, 5);
+
+    const bson_t *doc;
+    int seen = 0;
+    while (mongolite_cursor_next(cursor, &doc)) {
+        bson_iter_t it;
+        assert_true(bson_iter_init_find(&it, doc, "n"));
+        assert_int_equal(1 + 7 * (10 + seen), bson_iter_int32(&it));
+        seen++;
+    }
+    assert_int_equal(5, seen);
+    assert_int_equal(MONGOLITE_OK, mongolite_cursor_error(cursor, &error));
+    mongolite_cursor_destroy(cursor);
+
+    /* Abandoned early: workers stop */
+    cursor = mongolite_find(g_db, "items", filter, NULL, &error);
+    assert_true(mongolite_cursor_next(cursor, &doc));
+    mongolite_cursor_destroy(cursor);
+    bson_destroy(filter);
+}
+
+static void test_scan_delete_many(void **state) {
+    (void)state;
+    gerror_t error = {0};
+    insert_docs(DOCS);
+
+    bson_t *filter = BCON_NEW("mod7", BCON_INT32(2));
+    int64_t deleted = 0;
+    assert_int_equal(0, mongolite_delete_many(g_db, "items", filter, &deleted, &error));
+    assert_int_equal(expected_mod7(DOCS, 2), deleted);
+    assert_int_equal(1, parallel_scans());
+
+    assert_int_equal(0, mongolite_collection_count(g_db, "items", filter, &error));
+    assert_int_equal(DOCS - deleted, mongolite_collection_count(g_db, "items", NULL, &error));
+    bson_destroy(filter);
+}
+
+static void test_scan_snapshot(void **state) {
+    (void)state;
+    gerror_t error = {0};
+    insert_docs(DOCS);
+
+    bson_t *filter = BCON_NEW("mod7", BCON_INT32(4));
+    mongolite_cursor_t *cursor = mongolite_find(g_db, "items", filter, NULL, &error);
+    assert_non_null(cursor);
+
+    /* Written after the scan started */
+    bson_t *doc = BCON_NEW("n", BCON_INT32(-1), "mod7", BCON_INT32(4));
+    assert_int_equal(0, mongolite_insert_one(g_db, "items", doc, NULL, &error));
+    bson_destroy(doc);
+
+    const bson_t *found;
+    int seen = 0;
+    while (mongolite_cursor_next(cursor, &found)) seen++;
+    mongolite_cursor_destroy(cursor);
+    assert_int_equal(expected_mod7(DOCS, 4), seen);
+    assert_int_equal(expected_mod7(DOCS, 4) + 1,
+                     mongolite_collection_count(g_db, "items", filter, &error));
+    bson_destroy(filter);
+}
+
+static void test_scan_stays_serial(void **state) {
+    (void)state;
+    gerror_t error = {0};
+    insert_docs(50);
+
+    /* Below scan_parallel_min_docs */
+    bson_t *filter = BCON_NEW("mod7", BCON_INT32(6));
+    assert_int_equal(expected_mod7(50, 6), mongolite_collection_count(g_db, "items", filter, &error));
+    insert_docs(DOCS);
+
+    /* No filter */
+    assert_int_equal(DOCS + 50, mongolite_collection_count(g_db, "items", NULL, &error));
+
+    /* A session sees its own writes: only its txn can answer */
+    mongolite_session_t *session = mongolite_session_begin(g_db, MONGOLITE_SESSION_WRITE, &error);
+    assert_non_null(session);
+    bson_t *doc = BCON_NEW("n", BCON_INT32(-1), "mod7", BCON_INT32(6));
+    assert_int_equal(0, mongolite_insert_one(g_db, "items", doc, NULL, &error));
+    bson_destroy(doc);
+    assert_int_equal(expected_mod7(50, 6) + expected_mod7(DOCS, 6) + 1,
+                     mongolite_collection_count(g_db, "items", filter, &error));
+    mongolite_session_abort(session);
+
+    assert_int_equal(0, parallel_scans());
+    bson_destroy(filter);
+}
+
+static void test_scan_invalid_filter(void **state) {
+    (void)state;
+    gerror_t error = {0};
+    insert_docs(DOCS);
+
+    bson_t *filter = BCON_NEW("n", "{", "$bogus", BCON_INT32(1), "}");
+    assert_null(mongolite_find(g_db, "items", filter, NULL, &error));
+    assert_int_equal(MONGOLITE_EQUERY, error.code);
+
+    memset(&error, 0, sizeof(error));
+    assert_int_equal(-1, mongolite_collection_count(g_db, "items", filter, &error));
+    assert_int_equal(MONGOLITE_EQUERY, error.code);
+    bson_destroy(filter);
+}
+
+/* ============================================================
+ * Test Runner
+ * ============================================================ */
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_scan_count, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_scan_count_over_time, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_scan_find_ordered, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_scan_find_skip_limit, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_scan_delete_many, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_scan_snapshot, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_scan_stays_serial, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_scan_invalid_filter, setup, teardown),
+    };
+
+    return cmocka_run_group_tests_name("tests", tests, NULL, NULL);
+}
@@ -0,0 +1,363 @@
+/**
+ * test_mongolite_session.c - Tests for thread-bound sessions
+ *
+ * Tests:
+ * - Snapshot sessions keep one view across queries
+ * - Write sessions are invisible to (and not shared with) other threads
+ * - Other threads' writes wait for a write session, up to busy_timeout_ms
+ * - Commit / abort, read-only enforcement, one session per thread
+ * - Several snapshot readers alongside a writer session
+ * - Legacy begin/commit on a freshly opened database
+ *
+ * Worker threads only record results; assertions run on the main thread.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "mongolite.h"
+#include "mongolite_internal.h"
+
+/* ============================================================
+ * Test Setup/Teardown
+ * ============================================================ */
+
+static mongolite_db_t *g_db = NULL;
+static const char *DB_PATH = "./test_session_db";
+
+static void cleanup_db_path(void) {
+    char cmd[256];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", DB_PATH);
+    system(cmd);
+}
+
+static int open_db(void) {
+    gerror_t error = {0};
+    db_config_t config = {0};
+    config.max_bytes = 64ULL * 1024 * 1024;
+    return mongolite_open(DB_PATH, &g_db, &config, &error);
+}
+
+static int insert_n(int n, int tag) {
+    gerror_t error = {0};
+    for (int i = 0; i < n; i++) {
+        bson_t *doc = BCON_NEW("n", BCON_INT32(i), "tag", BCON_INT32(tag));
+        int rc = mongolite_insert_one(g_db, "items", doc, NULL, &error);
+        bson_destroy(doc);
+        if (rc != 0) return rc;
+    }
+    return 0;
+}
+
+static int setup(void **state) {
+    (void)state;
+    cleanup_db_path();
+
+    gerror_t error = {0};
+    if (open_db() != 0) return -1;
+    if (mongolite_collection_create(g_db, "items", NULL, &error) != 0) return -1;
+    return insert_n(10, 0);
+}
+
+static int teardown(void **state) {
+    (void)state;
+    if (g_db) {
+        mongolite_close(g_db);
+        g_db = NULL;
+    }
+    cleanup_db_path();
+    return 0;
+}
+
+/* Filtered count: goes through a cursor, so it reads the session snapshot */
+static int64_t count_items(void) {
+    gerror_t error = {0};
+    bson_t *filter = BCON_NEW("n", "{", "$gte", BCON_INT32(0), "}");
+    int64_t n = mongolite_collection_count(g_db, "items", filter, &error);
+    bson_destroy(filter);
+    return n;
+}
+
+/* ============================================================
+ * Worker Threads
+ * ============================================================ */
+
+typedef struct {
+    int insert_rc;
+    int insert_code;                    /* gerror code of the insert */
+    int create_rc;
+    int64_t count;
+    int done;                           /* Set last (atomic) */
+} worker_result_t;
+
+static void* writer_thread(void *arg) {
+    worker_result_t *res = arg;
+    res->insert_rc = insert_n(5, 1);
+    res->count = count_items();
+    return NULL;
+}
+
+static void* outsider_thread(void *arg) {
+    worker_result_t *res = arg;
+    gerror_t error = {0};
+
+    res->count = count_items();
+
+    bson_t *doc = BCON_NEW("n", BCON_INT32(100));
+    res->insert_rc = mongolite_insert_one(g_db, "items", doc, NULL, &error);
+    res->insert_code = error.code;
+    bson_destroy(doc);
+
+    res->create_rc = mongolite_collection_create(g_db, "other", NULL, &error);
+    __atomic_store_n(&res->done, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+/* Readers take a snapshot, wait for the writer to commit, then re-read */
+static pthread_mutex_t g_phase_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_phase_cond = PTHREAD_COND_INITIALIZER;
+static int g_readers_ready = 0;
+static bool g_writer_done = false;
+
+typedef struct {
+    int64_t before;
+    int64_t after;
+    int64_t after_end;
+    bool began;
+} reader_result_t;
+
+static void* reader_thread(void *arg) {
+    reader_result_t *res = arg;
+    gerror_t error = {0};
+
+    mongolite_session_t *session = mongolite_session_begin(g_db, MONGOLITE_SESSION_SNAPSHOT,
+                                                           &error);
+    res->began = (session != NULL);
+    res->before = count_items();
+
+    pthread_mutex_lock(&g_phase_mutex);
+    g_readers_ready++;
+    pthread_cond_broadcast(&g_phase_cond);
+    while (!g_writer_done) pthread_cond_wait(&g_phase_cond, &g_phase_mutex);
+    pthread_mutex_unlock(&g_phase_mutex);
+
+    res->after = count_items();
+    mongolite_session_commit(session, &error);
+    res->after_end = count_items();
+    return NULL;
+}
+
+/* ============================================================
+ * Tests
+ * ============================================================ */
+
+static void test_snapshot_isolation(void **state) {
+    (void)state;
+    gerror_t error = {0};
+
+    mongolite_session_t *session = mongolite_session_begin(g_db, MONGOLITE_SESSION_SNAPSHOT,
+                                                           &error);
+    assert_non_null(session);
+    assert_int_equal(10, count_items());
+
+    /* Another thread commits 5 more (auto-commit, not blocked) */
+    worker_result_t res = {0};
+    pthread_t tid;
+    pthread_create(&tid, NULL, writer_thread, &res);
+    pthread_join(tid, NULL);
+    assert_int_equal(0, res.insert_rc);
+    assert_int_equal(15, res.count);
+
+    /* Still the old snapshot, for every query of the session */
+    assert_int_equal(10, count_items());
+    bson_t *filter = BCON_NEW("tag", BCON_INT32(1));
+    bson_t *doc = mongolite_find_one(g_db, "items", filter, NULL, &error);
+    assert_null(doc);
+    bson_destroy(filter);
+
+    assert_int_equal(MONGOLITE_OK, mongolite_session_commit(session, &error));
+    assert_int_equal(15, count_items());
+}
+
+static void test_write_session_isolated(void **state) {
+    (void)state;
+    gerror_t error = {0};
+
+    mongolite_session_t *session = mongolite_session_begin(g_db, MONGOLITE_SESSION_WRITE,
+                                                           &error);
+    assert_non_null(session);
+    assert_int_equal(0, insert_n(3, 2));
+    assert_int_equal(13, count_items());
+
+    /* Other threads neither see nor join the open write */
+    g_db->busy_timeout_ms = 50;
+    worker_result_t res = {0};
+    pthread_t tid;
+    pthread_create(&tid, NULL, outsider_thread, &res);
+    pthread_join(tid, NULL);
+    assert_int_equal(10, res.count);
+    assert_int_not_equal(0, res.insert_rc);
+    assert_int_equal(MONGOLITE_EBUSY, res.insert_code);
+    assert_int_equal(MONGOLITE_EBUSY, res.create_rc);
+
+    assert_int_equal(MONGOLITE_OK, mongolite_session_commit(session, &error));
+
+    memset(&res, 0, sizeof(res));
+    pthread_create(&tid, NULL, outsider_thread, &res);
+    pthread_join(tid, NULL);
+    assert_int_equal(13, res.count);
+    assert_int_equal(0, res.insert_rc);
+    assert_int_equal(0, res.create_rc);
+}
+
+static void test_writer_waits_for_session(void **state) {
+    (void)state;
+    gerror_t error = {0};
+
+    mongolite_session_t *session = mongolite_session_begin(g_db, MONGOLITE_SESSION_WRITE,
+                                                           &error);
+    assert_non_null(session);
+    assert_int_equal(0, insert_n(3, 2));
+
+    /* No timeout: the outsider's insert waits for the commit */
+    worker_result_t res = {0};
+    pthread_t tid;
+    pthread_create(&tid, NULL, outsider_thread, &res);
+    struct timespec pause = {0, 100 * 1000000L};
+    nanosleep(&pause, NULL);
+    assert_int_equal(0, __atomic_load_n(&res.done, __ATOMIC_ACQUIRE));
+
+    assert_int_equal(MONGOLITE_OK, mongolite_session_commit(session, &error));
+    pthread_join(tid, NULL);
+    assert_int_equal(10, res.count);
+    assert_int_equal(0, res.insert_rc);
+    assert_int_equal(0, res.create_rc);
+    assert_int_equal(14, count_items());
+}
+
+static void test_write_session_abort(void **state) {
+    (void)state;
+    gerror_t error = {0};
+
+    mongolite_session_t *session = mongolite_session_begin(g_db, MONGOLITE_SESSION_WRITE,
+                                                           &error);
+    assert_non_null(session);
+    assert_int_equal(0, insert_n(4, 3));
+
+    bson_t *filter = BCON_NEW("tag", BCON_INT32(0));
+    int64_t deleted = 0;
+    assert_int_equal(0, mongolite_delete_many(g_db, "items", filter, &deleted, &error));
+    assert_int_equal(10, deleted);
+    bson_destroy(filter);
+    assert_int_equal(4, count_items());
+
+    mongolite_session_abort(session);
+    assert_int_equal(10, count_items());
+}
+
+static void test_session_rules(void **state) {
+    (void)state;
+    gerror_t error = {0};
+
+    mongolite_session_t *session = mongolite_session_begin(g_db, MONGOLITE_SESSION_SNAPSHOT,
+                                                           &error);
+    assert_non_null(session);
+
+    /* Snapshot sessions are read-only */
+    bson_t *doc = BCON_NEW("n", BCON_INT32(1));
+    assert_int_not_equal(0, mongolite_insert_one(g_db, "items", doc, NULL, &error));
+    assert_int_equal(MONGOLITE_ETXN, error.code);
+    bson_destroy(doc);
+
+    /* One session per thread, legacy API included */
+    assert_null(mongolite_session_begin(g_db, MONGOLITE_SESSION_WRITE, &error));
+    assert_int_equal(MONGOLITE_ETXN, error.code);
+    assert_int_equal(MONGOLITE_ERROR, mongolite_begin_transaction(g_db));
+    assert_int_equal(MONGOLITE_ERROR, mongolite_commit(g_db));
+
+    assert_int_equal(MONGOLITE_OK, mongolite_session_commit(session, &error));
+    assert_int_equal(MONGOLITE_ERROR, mongolite_rollback(g_db));
+}
+
+static void test_readers_alongside_writer(void **state) {
+    (void)state;
+    gerror_t error = {0};
+    enum { READERS = 4 };
+
+    g_readers_ready = 0;
+    g_writer_done = false;
+
+    mongolite_session_t *writer = mongolite_session_begin(g_db, MONGOLITE_SESSION_WRITE,
+                                                          &error);
+    assert_non_null(writer);
+
+    pthread_t tids[READERS];
+    reader_result_t res[READERS];
+    memset(res, 0, sizeof(res));
+    for (int i = 0; i < READERS; i++) {
+        pthread_create(&tids[i], NULL, reader_thread, &res[i]);
+    }
+
+    pthread_mutex_lock(&g_phase_mutex);
+    while (g_readers_ready < READERS) pthread_cond_wait(&g_phase_cond, &g_phase_mutex);
+    pthread_mutex_unlock(&g_phase_mutex);
+
+    /* Write and commit while every reader holds its snapshot */
+    assert_int_equal(0, insert_n(7, 4));
+    assert_int_equal(MONGOLITE_OK, mongolite_session_commit(writer, &error));
+
+    pthread_mutex_lock(&g_phase_mutex);
+    g_writer_done = true;
+    pthread_cond_broadcast(&g_phase_cond);
+    pthread_mutex_unlock(&g_phase_mutex);
+
+    for (int i = 0; i < READERS; i++) {
+        pthread_join(tids[i], NULL);
+        assert_true(res[i].began);
+        assert_int_equal(10, res[i].before);
+        assert_int_equal(10, res[i].after);
+        assert_int_equal(17, res[i].after_end);
+    }
+}
+
+static void test_transaction_after_reopen(void **state) {
+    (void)state;
+    gerror_t error = {0};
+
+    /* Collections are not cached after reopen: the write session opens them
+     * up front instead of deadlocking on LMDB's writer lock */
+    mongolite_close(g_db);
+    assert_int_equal(0, open_db());
+
+    assert_int_equal(MONGOLITE_OK, mongolite_begin_transaction(g_db));
+    assert_int_equal(0, insert_n(2, 5));
+    assert_int_equal(12, count_items());
+    assert_int_equal(MONGOLITE_OK, mongolite_commit(g_db));
+
+    assert_int_equal(12, mongolite_collection_count(g_db, "items", NULL, &error));
+}
+
+/* ============================================================
+ * Test Runner
+ * ============================================================ */
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_snapshot_isolation, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_write_session_isolated, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_writer_waits_for_session, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_write_session_abort, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_session_rules, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_readers_alongside_writer, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_transaction_after_reopen, setup, teardown),
+    };
+
+    return cmocka_run_group_tests_name("tests", tests, NULL, NULL);
+}
@@ -0,0 +1,334 @@
+/**
+ * test_mongolite_slowlog.c - Tests for the slow-operation log
+ *
+ * Tests:
+ * - Sampling every call logs find_one / count / update / delete with
+ *   their filter shape and plan
+ * - update_one without _id shows the full scan behind it (also with
+ *   statistics disabled)
+ * - find is logged when its cursor is destroyed, with index keys and
+ *   documents read while iterating
+ * - Nothing is logged under the threshold or with the log off
+ * - A full queue drops new entries and counts them
+ * - Concurrent producers and a concurrent drain lose no entry
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "mongolite.h"
+#include "mongolite_internal.h"
+
+/* ============================================================
+ * Test Setup/Teardown
+ * ============================================================ */
+
+static mongolite_db_t *g_db = NULL;
+static const char *DB_PATH = "./test_slowlog_db";
+
+#define N_DOCS 500
+
+static void cleanup_db_path(void) {
+    char cmd[256];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", DB_PATH);
+    system(cmd);
+}
+
+/* Open with the given log settings and fill "items": n = i, grp = i % 10 */
+static void open_db(uint64_t threshold_us, double sample_rate, unsigned int capacity,
+                    bool disable_stats) {
+    gerror_t error = {0};
+    db_config_t config = {0};
+    config.max_bytes = 64ULL * 1024 * 1024;
+    config.slowlog_threshold_us = threshold_us;
+    config.slowlog_sample_rate = sample_rate;
+    config.slowlog_capacity = capacity;
+    config.disable_stats = disable_stats;
+    assert_int_equal(0, mongolite_open(DB_PATH, &g_db, &config, &error));
+    assert_int_equal(0, mongolite_collection_create(g_db, "items", NULL, &error));
+
+    bson_t **docs = calloc(N_DOCS, sizeof(bson_t *));
+    for (int i = 0; i < N_DOCS; i++) {
+        docs[i] = BCON_NEW("n", BCON_INT32(i), "grp", BCON_INT32(i % 10));
+    }
+    assert_int_equal(0, mongolite_insert_many(g_db, "items", (const bson_t **)docs,
+                                              N_DOCS, NULL, &error));
+    for (int i = 0; i < N_DOCS; i++) bson_destroy(docs[i]);
+    free(docs);
+}
+
+static int setup(void **state) {
+    (void)state;
+    cleanup_db_path();
+    return 0;
+}
+
+static int teardown(void **state) {
+    (void)state;
+    if (g_db) {
+        mongolite_close(g_db);
+        g_db = NULL;
+    }
+    cleanup_db_path();
+    return 0;
+}
+
+#define MAX_LOGGED 64
+
+typedef struct {
+    mongolite_slow_op_t ops[MAX_LOGGED];
+    size_t count;
+} logged_t;
+
+static void collect(const mongolite_slow_op_t *op, void *ctx) {
+    logged_t *logged = ctx;
+    if (logged->count < MAX_LOGGED) logged->ops[logged->count] = *op;
+    logged->count++;
+}
+
+static size_t drain(logged_t *logged) {
+    memset(logged, 0, sizeof(*logged));
+    size_t n = mongolite_slowlog_drain(g_db, collect, logged);
+    assert_int_equal(n, logged->count);
+    return n;
+}
+
+static mongolite_stats_t db_stats(void) {
+    gerror_t error = {0};
+    mongolite_stats_t stats;
+    assert_int_equal(MONGOLITE_OK, mongolite_stats(g_db, &stats, &error));
+    return stats;
+}
+
+/* ============================================================
+ * Tests
+ * ============================================================ */
+
+static void test_sampled_calls(void **state) {
+    (void)state;
+    open_db(0, 1.0, 0, false);
+    gerror_t error = {0};
+    logged_t logged;
+    drain(&logged);                     /* collection_create / inserts are not logged */
+
+    bson_t *filter = BCON_NEW("n", BCON_INT32(7));
+    bson_t *doc = mongolite_find_one(g_db, "items", filter, NULL, &error);
+    assert_non_null(doc);
+    bson_destroy(doc);
+    bson_destroy(filter);
+
+    filter = BCON_NEW("grp", "{", "$gte", BCON_INT32(8), "}");
+    assert_int_equal(100, mongolite_collection_count(g_db, "items", filter, &error));
+    bson_destroy(filter);
+
+    filter = BCON_NEW("grp", BCON_INT32(3));
+    bson_t *update = BCON_NEW("$set", "{", "hit", BCON_BOOL(true), "}");
+    int64_t modified = 0;
+    assert_int_equal(0, mongolite_update_many(g_db, "items", filter, update, false,
+                                              &modified, &error));
+    assert_int_equal(50, modified);
+    bson_destroy(update);
+
+    int64_t deleted = 0;
+    assert_int_equal(0, mongolite_delete_many(g_db, "items", filter, &deleted, &error));
+    assert_int_equal(50, deleted);
+    bson_destroy(filter);
+
+    assert_int_equal(4, drain(&logged));
+    assert_int_equal(MONGOLITE_OP_FIND_ONE, logged.ops[0].op);
+    assert_string_equal("items", logged.ops[0].collection);
+    assert_string_equal("n=10;", logged.ops[0].shape);
+    assert_string_equal("COLLSCAN", logged.ops[0].plan);
+    assert_int_equal(8, logged.ops[0].docs_examined);
+    assert_int_equal(1, logged.ops[0].docs_returned);
+    assert_true(logged.ops[0].sampled);
+    assert_true(logged.ops[0].duration_ns > 0);
+
+    assert_int_equal(MONGOLITE_OP_COUNT, logged.ops[1].op);
+    assert_string_equal("grp{$gte,};", logged.ops[1].shape);
+    assert_int_equal(N_DOCS, logged.ops[1].docs_examined);
+    assert_int_equal(100, logged.ops[1].docs_returned);
+
+    assert_int_equal(MONGOLITE_OP_UPDATE, logged.ops[2].op);
+    assert_int_equal(50, logged.ops[2].docs_returned);
+    assert_int_equal(MONGOLITE_OP_DELETE, logged.ops[3].op);
+    assert_int_equal(50, logged.ops[3].docs_returned);
+
+    assert_int_equal(4, db_stats().slow_ops);
+    assert_int_equal(0, drain(&logged));
+}
+
+static void test_update_one_scan(void **state) {
+    (void)state;
+    open_db(0, 1.0, 0, true);
+    gerror_t error = {0};
+    logged_t logged;
+
+    /* No _id: update_one first scans for the document */
+    bson_t *filter = BCON_NEW("n", BCON_INT32(450));
+    bson_t *update = BCON_NEW("$set", "{", "hit", BCON_BOOL(true), "}");
+    assert_int_equal(0, mongolite_update_one(g_db, "items", filter, update, false, &error));
+    bson_destroy(update);
+    bson_destroy(filter);
+
+    assert_int_equal(1, drain(&logged));
+    assert_int_equal(MONGOLITE_OP_UPDATE, logged.ops[0].op);
+    assert_string_equal("COLLSCAN", logged.ops[0].plan);
+    assert_int_equal(451, logged.ops[0].docs_examined);
+    assert_int_equal(1, logged.ops[0].docs_returned);
+
+    /* By _id: one document */
+    bson_t *doc = mongolite_find_one(g_db, "items", NULL, NULL, &error);
+    assert_non_null(doc);
+    bson_iter_t it;
+    assert_true(bson_iter_init_find(&it, doc, "_id"));
+    filter = BCON_NEW("_id", BCON_OID(bson_iter_oid(&it)));
+    bson_destroy(doc);
+    assert_int_equal(0, mongolite_delete_one(g_db, "items", filter, &error));
+    bson_destroy(filter);
+
+    assert_int_equal(2, drain(&logged));
+    assert_int_equal(MONGOLITE_OP_DELETE, logged.ops[1].op);
+    assert_string_equal("ID_LOOKUP", logged.ops[1].plan);
+    assert_string_equal("_id=07;", logged.ops[1].shape);
+}
+
+static void test_find_cursor(void **state) {
+    (void)state;
+    open_db(0, 1.0, 0, false);
+    gerror_t error = {0};
+    logged_t logged;
+
+    bson_t *keys = BCON_NEW("grp", BCON_INT32(1));
+    assert_int_equal(0, mongolite_create_index(g_db, "items", keys, "by_grp", NULL, &error));
+    bson_destroy(keys);
+    drain(&logged);
+
+    bson_t *filter = BCON_NEW("grp", "{", "$in", "[", BCON_INT32(2), BCON_INT32(5), "]", "}");
+    mongolite_cursor_t *cursor = mongolite_find(g_db, "items", filter, NULL, &error);
+    bson_destroy(filter);
+    assert_non_null(cursor);
+
+    /* Not logged until the cursor is done */
+    assert_int_equal(0, drain(&logged));
+
+    const bson_t *doc;
+    int count = 0;
+    while (mongolite_cursor_next(cursor, &doc)) count++;
+    assert_int_equal(100, count);
+    mongolite_cursor_destroy(cursor);
+
+    assert_int_equal(1, drain(&logged));
+    assert_int_equal(MONGOLITE_OP_FIND, logged.ops[0].op);
+    assert_string_equal("IXSEEK", logged.ops[0].plan);
+    assert_string_equal("grp{$in,};", logged.ops[0].shape);
+    assert_int_equal(100, logged.ops[0].keys_examined);
+    assert_int_equal(100, logged.ops[0].docs_examined);
+    assert_int_equal(100, logged.ops[0].docs_returned);
+}
+
+static void test_threshold_and_off(void **state) {
+    (void)state;
+    gerror_t error = {0};
+    logged_t logged;
+
+    /* Ten seconds: nothing here is that slow */
+    open_db(10 * 1000 * 1000, 0.0, 0, false);
+    bson_t *filter = BCON_NEW("n", BCON_INT32(499));
+    assert_int_equal(1, mongolite_collection_count(g_db, "items", filter, &error));
+    assert_int_equal(0, drain(&logged));
+    mongolite_close(g_db);
+    g_db = NULL;
+    cleanup_db_path();
+
+    /* Off */
+    open_db(0, 0.0, 0, false);
+    assert_null(g_db->slowlog);
+    assert_int_equal(1, mongolite_collection_count(g_db, "items", filter, &error));
+    assert_int_equal(0, drain(&logged));
+    assert_int_equal(0, db_stats().slow_ops);
+    bson_destroy(filter);
+}
+
+static void test_full_queue_drops(void **state) {
+    (void)state;
+    open_db(0, 1.0, 4, false);
+    gerror_t error = {0};
+    logged_t logged;
+
+    bson_t *filter = BCON_NEW("grp", BCON_INT32(0));
+    for (int i = 0; i < 10; i++) {
+        assert_int_equal(50, mongolite_collection_count(g_db, "items", filter, &error));
+    }
+    bson_destroy(filter);
+
+    mongolite_stats_t stats = db_stats();
+    assert_int_equal(4, stats.slow_ops);
+    assert_int_equal(6, stats.slow_ops_dropped);
+    assert_int_equal(4, drain(&logged));
+
+    /* Room again */
+    assert_int_equal(N_DOCS, mongolite_collection_count(g_db, "items", NULL, &error));
+    assert_int_equal(1, drain(&logged));
+    assert_string_equal("", logged.ops[0].shape);
+    assert_string_equal("NONE", logged.ops[0].plan);
+}
+
+#define THREADS 4
+#define OPS_PER_THREAD 200
+
+static void* find_one_worker(void *arg) {
+    (void)arg;
+    gerror_t error = {0};
+    bson_t *filter = BCON_NEW("n", BCON_INT32(3));
+    for (int i = 0; i < OPS_PER_THREAD; i++) {
+        bson_t *doc = mongolite_find_one(g_db, "items", filter, NULL, &error);
+        if (doc) bson_destroy(doc);
+    }
+    bson_destroy(filter);
+    return NULL;
+}
+
+static void count_entry(const mongolite_slow_op_t *op, void *ctx) {
+    if (op->op == MONGOLITE_OP_FIND_ONE && op->docs_returned == 1) (*(size_t *)ctx)++;
+}
+
+static void test_concurrent_drain(void **state) {
+    (void)state;
+    open_db(0, 1.0, 64, false);
+
+    pthread_t tids[THREADS];
+    for (int t = 0; t < THREADS; t++) pthread_create(&tids[t], NULL, find_one_worker, NULL);
+
+    size_t drained = 0;
+    for (int i = 0; i < 1000; i++) mongolite_slowlog_drain(g_db, count_entry, &drained);
+    for (int t = 0; t < THREADS; t++) pthread_join(tids[t], NULL);
+    mongolite_slowlog_drain(g_db, count_entry, &drained);
+
+    mongolite_stats_t stats = db_stats();
+    assert_int_equal(THREADS * OPS_PER_THREAD, stats.slow_ops + stats.slow_ops_dropped);
+    assert_int_equal(stats.slow_ops, drained);
+}
+
+/* ============================================================
+ * Test Runner
+ * ============================================================ */
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_sampled_calls, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_update_one_scan, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_find_cursor, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_threshold_and_off, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_full_queue_drops, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_concurrent_drain, setup, teardown),
+    };
+
+    return cmocka_run_group_tests_name("tests", tests, NULL, NULL);
+}
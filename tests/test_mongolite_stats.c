@@ -0,0 +1,328 @@
+/**
+ * test_mongolite_stats.c - Tests for built-in metrics
+ *
+ * Tests:
+ * - Query counters by plan (_id, index, scan)
+ * - Documents scanned vs returned
+ * - Latency histograms and percentiles
+ * - Transaction and lock counters
+ * - Per-thread shards summed across concurrent readers
+ * - Reset and disable_stats
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <string.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "mongolite.h"
+#include "mongolite_internal.h"
+
+/* ============================================================
+ * Test Setup/Teardown
+ * ============================================================ */
+
+static mongolite_db_t *g_db = NULL;
+static const char *DB_PATH = "./test_stats_db";
+static gerror_t error = {0};
+static bson_oid_t g_first_id;
+
+static void cleanup_db_path(const char *path) {
+    char cmd[256];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", path);
+    system(cmd);
+}
+
+static int setup(void **state) {
+    (void)state;
+    cleanup_db_path(DB_PATH);
+
+    db_config_t config = {0};
+    config.max_bytes = 64ULL * 1024 * 1024;
+
+    if (mongolite_open(DB_PATH, &g_db, &config, &error) != 0) {
+        return -1;
+    }
+    if (mongolite_collection_create(g_db, "items", NULL, &error) != 0) {
+        return -1;
+    }
+
+    /* 20 items: sku unique, kind = i % 4 */
+    for (int i = 0; i < 20; i++) {
+        char sku[16];
+        snprintf(sku, sizeof(sku), "sku-%02d", i);
+        bson_t *doc = BCON_NEW("sku", BCON_UTF8(sku), "kind", BCON_INT32(i % 4));
+        int rc = mongolite_insert_one(g_db, "items", doc, i == 0 ? &g_first_id : NULL, &error);
+        bson_destroy(doc);
+        if (rc != 0) return -1;
+    }
+
+    bson_t *keys = BCON_NEW("sku", BCON_INT32(1));
+    index_config_t cfg = {.unique = true};
+    int rc = mongolite_create_index(g_db, "items", keys, NULL, &cfg, &error);
+    bson_destroy(keys);
+    if (rc != 0) return -1;
+
+    mongolite_stats_reset(g_db);
+    return 0;
+}
+
+static int teardown(void **state) {
+    (void)state;
+    if (g_db) {
+        mongolite_close(g_db);
+        g_db = NULL;
+    }
+    cleanup_db_path(DB_PATH);
+    return 0;
+}
+
+static mongolite_op_stats_t collection_stats(void) {
+    mongolite_op_stats_t out;
+    assert_int_equal(MONGOLITE_OK, mongolite_collection_stats(g_db, "items", &out, &error));
+    return out;
+}
+
+/* ============================================================
+ * Tests
+ * ============================================================ */
+
+static void test_stats_query_plans(void **state) {
+    (void)state;
+
+    /* _id lookup */
+    bson_t *filter = BCON_NEW("_id", BCON_OID(&g_first_id));
+    bson_t *doc = mongolite_find_one(g_db, "items", filter, NULL, &error);
+    assert_non_null(doc);
+    bson_destroy(doc);
+    bson_destroy(filter);
+
+    /* Unique index seek */
+    filter = BCON_NEW("sku", BCON_UTF8("sku-07"));
+    doc = mongolite_find_one(g_db, "items", filter, NULL, &error);
+    assert_non_null(doc);
+    bson_destroy(doc);
+    bson_destroy(filter);
+
+    /* Scan: every document is read and matched, 5 are returned */
+    filter = BCON_NEW("kind", BCON_INT32(2));
+    mongolite_cursor_t *cursor = mongolite_find(g_db, "items", filter, NULL, &error);
+    assert_non_null(cursor);
+    const bson_t *row;
+    int n = 0;
+    while (mongolite_cursor_next(cursor, &row)) n++;
+    assert_int_equal(5, n);
+    mongolite_cursor_destroy(cursor);
+    bson_destroy(filter);
+
+    mongolite_op_stats_t col = collection_stats();
+    assert_int_equal(1, col.id_queries);
+    assert_int_equal(1, col.index_queries);
+    assert_int_equal(1, col.scan_queries);
+    assert_int_equal(1 + 1 + 20, col.docs_scanned);
+    assert_int_equal(1 + 1 + 5, col.docs_returned);
+    assert_int_equal(1 + 20, col.matcher_evals);
+
+    mongolite_stats_t stats;
+    assert_int_equal(MONGOLITE_OK, mongolite_stats(g_db, &stats, &error));
+    assert_int_equal(col.id_queries, stats.totals.id_queries);
+    assert_int_equal(col.docs_scanned, stats.totals.docs_scanned);
+    assert_int_equal(2, stats.latency[MONGOLITE_OP_FIND_ONE].count);
+    assert_int_equal(1, stats.latency[MONGOLITE_OP_FIND].count);
+    assert_true(stats.read_txn_begins + stats.read_txn_renews >= 3);
+    assert_true(stats.lock_acquires >= 3);
+}
+
+static void test_stats_writes_and_count(void **state) {
+    (void)state;
+
+    bson_t *doc = BCON_NEW("sku", BCON_UTF8("sku-new"), "kind", BCON_INT32(9));
+    assert_int_equal(0, mongolite_insert_one(g_db, "items", doc, NULL, &error));
+    bson_destroy(doc);
+
+    bson_t *filter = BCON_NEW("kind", BCON_INT32(9));
+    bson_t *update = BCON_NEW("$set", "{", "kind", BCON_INT32(10), "}");
+    int64_t modified = 0;
+    assert_int_equal(0, mongolite_update_many(g_db, "items", filter, update, false,
+                                              &modified, &error));
+    assert_int_equal(1, modified);
+    bson_destroy(update);
+    bson_destroy(filter);
+
+    filter = BCON_NEW("kind", BCON_INT32(10));
+    assert_int_equal(1, mongolite_collection_count(g_db, "items", filter, &error));
+    int64_t deleted = 0;
+    assert_int_equal(0, mongolite_delete_many(g_db, "items", filter, &deleted, &error));
+    assert_int_equal(1, deleted);
+    bson_destroy(filter);
+
+    mongolite_stats_t stats;
+    assert_int_equal(MONGOLITE_OK, mongolite_stats(g_db, &stats, &error));
+    assert_int_equal(1, stats.latency[MONGOLITE_OP_INSERT].count);
+    assert_int_equal(1, stats.latency[MONGOLITE_OP_UPDATE].count);
+    assert_int_equal(1, stats.latency[MONGOLITE_OP_COUNT].count);
+    assert_int_equal(1, stats.latency[MONGOLITE_OP_DELETE].count);
+    assert_true(stats.latency[MONGOLITE_OP_COMMIT].count >= 3);
+    assert_true(stats.write_txn_begins >= 3);
+
+    /* update_many, count and delete_many each scan the 21 documents */
+    mongolite_op_stats_t col = collection_stats();
+    assert_int_equal(3, col.scan_queries);
+    assert_int_equal(3 * 21, col.docs_scanned);
+    assert_int_equal(3, col.docs_returned);
+}
+
+static void test_stats_latency_percentile(void **state) {
+    (void)state;
+
+    for (int i = 0; i < 50; i++) {
+        bson_t *filter = BCON_NEW("sku", BCON_UTF8("sku-03"));
+        bson_t *doc = mongolite_find_one(g_db, "items", filter, NULL, &error);
+        assert_non_null(doc);
+        bson_destroy(doc);
+        bson_destroy(filter);
+    }
+
+    mongolite_stats_t stats;
+    assert_int_equal(MONGOLITE_OK, mongolite_stats(g_db, &stats, &error));
+    const mongolite_latency_t *lat = &stats.latency[MONGOLITE_OP_FIND_ONE];
+    assert_int_equal(50, lat->count);
+    assert_true(lat->max_ns > 0);
+    assert_true(lat->total_ns >= lat->max_ns);
+
+    uint64_t bucketed = 0;
+    for (int b = 0; b < MONGOLITE_LATENCY_BUCKETS; b++) bucketed += lat->buckets[b];
+    assert_int_equal(50, bucketed);
+
+    uint64_t p50 = mongolite_latency_percentile(lat, 50.0);
+    uint64_t p99 = mongolite_latency_percentile(lat, 99.0);
+    assert_true(p50 > 0);
+    assert_true(p50 <= p99);
+    assert_true(p99 <= lat->max_ns);
+    assert_int_equal(lat->max_ns, mongolite_latency_percentile(lat, 100.0));
+
+    mongolite_latency_t empty = {0};
+    assert_int_equal(0, mongolite_latency_percentile(&empty, 50.0));
+}
+
+#define THREADS 4
+#define OPS_PER_THREAD 200
+
+static void *find_worker(void *arg) {
+    (void)arg;
+    gerror_t werr = {0};
+    bson_t *by_id = BCON_NEW("_id", BCON_OID(&g_first_id));
+    bson_t *by_kind = BCON_NEW("kind", BCON_INT32(3));
+    for (int i = 0; i < OPS_PER_THREAD; i++) {
+        bson_t *doc = mongolite_find_one(g_db, "items", by_id, NULL, &werr);
+        if (doc) bson_destroy(doc);
+        mongolite_cursor_t *cursor = mongolite_find(g_db, "items", by_kind, NULL, &werr);
+        const bson_t *row;
+        while (cursor && mongolite_cursor_next(cursor, &row)) {}
+        mongolite_cursor_destroy(cursor);
+    }
+    bson_destroy(by_kind);
+    bson_destroy(by_id);
+    return NULL;
+}
+
+static void test_stats_concurrent(void **state) {
+    (void)state;
+
+    pthread_t tids[THREADS];
+    for (int t = 0; t < THREADS; t++) pthread_create(&tids[t], NULL, find_worker, NULL);
+    for (int t = 0; t < THREADS; t++) pthread_join(tids[t], NULL);
+
+    /* No update is lost across the shards */
+    const uint64_t ops = THREADS * OPS_PER_THREAD;
+    mongolite_op_stats_t col = collection_stats();
+    assert_int_equal(ops, col.id_queries);
+    assert_int_equal(ops, col.scan_queries);
+    assert_int_equal(ops * (1 + 20), col.docs_scanned);
+    assert_int_equal(ops * (1 + 5), col.docs_returned);
+
+    mongolite_stats_t stats;
+    assert_int_equal(MONGOLITE_OK, mongolite_stats(g_db, &stats, &error));
+    assert_int_equal(col.id_queries, stats.totals.id_queries);
+    assert_int_equal(col.docs_scanned, stats.totals.docs_scanned);
+
+    const mongolite_latency_t *lat = &stats.latency[MONGOLITE_OP_FIND_ONE];
+    assert_int_equal(ops, lat->count);
+    assert_true(lat->max_ns > 0);
+    assert_true(lat->max_ns <= lat->total_ns);
+    assert_true(lat->max_ns >= lat->total_ns / lat->count);
+}
+
+static void test_stats_reset(void **state) {
+    (void)state;
+
+    bson_t *filter = BCON_NEW("kind", BCON_INT32(1));
+    assert_int_equal(5, mongolite_collection_count(g_db, "items", filter, &error));
+    bson_destroy(filter);
+
+    mongolite_stats_reset(g_db);
+
+    mongolite_stats_t stats;
+    assert_int_equal(MONGOLITE_OK, mongolite_stats(g_db, &stats, &error));
+    assert_int_equal(0, stats.totals.scan_queries);
+    assert_int_equal(0, stats.latency[MONGOLITE_OP_COUNT].count);
+
+    mongolite_op_stats_t col = collection_stats();
+    assert_int_equal(0, col.scan_queries);
+    assert_int_equal(0, col.docs_scanned);
+
+    assert_int_equal(MONGOLITE_ENOTFOUND,
+                     mongolite_collection_stats(g_db, "missing", &col, &error));
+}
+
+static void test_stats_disabled(void **state) {
+    (void)state;
+
+    const char *path = "./test_stats_off_db";
+    cleanup_db_path(path);
+
+    mongolite_db_t *db = NULL;
+    db_config_t config = {0};
+    config.disable_stats = true;
+    assert_int_equal(0, mongolite_open(path, &db, &config, &error));
+    assert_int_equal(0, mongolite_collection_create(db, "items", NULL, &error));
+
+    bson_t *doc = BCON_NEW("kind", BCON_INT32(1));
+    assert_int_equal(0, mongolite_insert_one(db, "items", doc, NULL, &error));
+    assert_int_equal(1, mongolite_collection_count(db, "items", doc, &error));
+    bson_destroy(doc);
+
+    mongolite_stats_t stats;
+    assert_int_equal(MONGOLITE_OK, mongolite_stats(db, &stats, &error));
+    assert_int_equal(0, stats.latency[MONGOLITE_OP_INSERT].count);
+    assert_int_equal(0, stats.totals.scan_queries);
+    assert_int_equal(0, stats.lock_acquires);
+
+    mongolite_op_stats_t col;
+    assert_int_equal(MONGOLITE_OK, mongolite_collection_stats(db, "items", &col, &error));
+    assert_int_equal(0, col.docs_scanned);
+
+    mongolite_close(db);
+    cleanup_db_path(path);
+}
+
+/* ============================================================
+ * Test Runner
+ * ============================================================ */
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_stats_query_plans, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_stats_writes_and_count, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_stats_latency_percentile, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_stats_concurrent, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_stats_reset, setup, teardown),
+        cmocka_unit_test(test_stats_disabled),
+    };
+
+    return cmocka_run_group_tests_name("tests", tests, NULL, NULL);
+}
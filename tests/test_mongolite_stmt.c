@@ -0,0 +1,357 @@
+/**
+ * test_mongolite_stmt.c - Tests for prepared queries
+ *
+ * Tests:
+ * - Placeholder counting and validation
+ * - Plan selection (_id lookup, index equality seek, scan)
+ * - Bind / step / reset cycles
+ * - Replanning after index changes and collection re-creation
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "mongolite.h"
+#include "mongolite_internal.h"
+
+/* ============================================================
+ * Test Setup/Teardown
+ * ============================================================ */
+
+static mongolite_db_t *g_db = NULL;
+static const char *DB_PATH = "./test_stmt_db";
+static gerror_t error = {0};
+
+static void cleanup_db_path(void) {
+    char cmd[256];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", DB_PATH);
+    system(cmd);
+}
+
+static int global_setup(void **state) {
+    (void)state;
+    cleanup_db_path();
+
+    db_config_t config = {0};
+    config.max_bytes = 64ULL * 1024 * 1024;
+
+    if (mongolite_open(DB_PATH, &g_db, &config, &error) != 0) {
+        return -1;
+    }
+
+    if (mongolite_collection_create(g_db, "users", NULL, &error) != 0) {
+        return -1;
+    }
+
+    /* 30 users: email unique, group = i % 3 */
+    for (int i = 0; i < 30; i++) {
+        char email[32];
+        snprintf(email, sizeof(email), "user%d@test.com", i);
+        bson_t *doc = BCON_NEW("email", BCON_UTF8(email),
+                               "group", BCON_INT32(i % 3),
+                               "age", BCON_INT32(20 + i));
+        if (mongolite_insert_one(g_db, "users", doc, NULL, &error) != 0) {
+            bson_destroy(doc);
+            return -1;
+        }
+        bson_destroy(doc);
+    }
+
+    bson_t *keys = BCON_NEW("email", BCON_INT32(1));
+    index_config_t cfg = {.unique = true};
+    int rc = mongolite_create_index(g_db, "users", keys, NULL, &cfg, &error);
+    bson_destroy(keys);
+    return rc == 0 ? 0 : -1;
+}
+
+static int global_teardown(void **state) {
+    (void)state;
+    if (g_db) {
+        mongolite_close(g_db);
+        g_db = NULL;
+    }
+    cleanup_db_path();
+    return 0;
+}
+
+static int count_rows(mongolite_stmt_t *stmt) {
+    const bson_t *doc;
+    int n = 0;
+    int rc;
+    while ((rc = mongolite_step(stmt, &doc, &error)) == MONGOLITE_ROW) {
+        assert_non_null(doc);
+        n++;
+    }
+    assert_int_equal(MONGOLITE_DONE, rc);
+    return n;
+}
+
+/* ============================================================
+ * Tests
+ * ============================================================ */
+
+static void test_prepare_counts_params(void **state) {
+    (void)state;
+
+    bson_t *filter = BCON_NEW("email", "{", "$param", BCON_INT32(1), "}",
+                              "age", "{", "$gt", "{", "$param", BCON_INT32(2), "}", "}");
+    mongolite_stmt_t *stmt = mongolite_prepare(g_db, "users", filter, NULL, &error);
+    assert_non_null(stmt);
+    assert_int_equal(2, mongolite_bind_count(stmt));
+
+    /* Out of range */
+    assert_int_equal(MONGOLITE_EINVAL, mongolite_bind_int32(stmt, 3, 1));
+    assert_int_equal(MONGOLITE_EINVAL, mongolite_bind_int32(stmt, 0, 1));
+
+    /* Unbound parameter is an error at step time */
+    const bson_t *doc;
+    assert_int_equal(MONGOLITE_OK, mongolite_bind_utf8(stmt, 1, "user1@test.com"));
+    assert_int_equal(MONGOLITE_EINVAL, mongolite_step(stmt, &doc, &error));
+
+    mongolite_finalize(stmt);
+    bson_destroy(filter);
+}
+
+static void test_prepare_invalid(void **state) {
+    (void)state;
+
+    bson_t *filter = BCON_NEW("email", "{", "$param", BCON_UTF8("x"), "}");
+    assert_null(mongolite_prepare(g_db, "users", filter, NULL, &error));
+    assert_int_equal(MONGOLITE_EQUERY, error.code);
+    bson_destroy(filter);
+
+    filter = BCON_NEW("email", BCON_UTF8("x"));
+    assert_null(mongolite_prepare(g_db, "missing", filter, NULL, &error));
+    assert_int_equal(MONGOLITE_ENOTFOUND, error.code);
+
+    /* Projections are rejected, not ignored; an empty one is no projection */
+    bson_t *projection = BCON_NEW("email", BCON_INT32(1));
+    assert_null(mongolite_prepare(g_db, "users", filter, projection, &error));
+    assert_int_equal(MONGOLITE_EINVAL, error.code);
+    bson_destroy(projection);
+
+    projection = bson_new();
+    mongolite_stmt_t *stmt = mongolite_prepare(g_db, "users", filter, projection, &error);
+    assert_non_null(stmt);
+    mongolite_finalize(stmt);
+    bson_destroy(projection);
+    bson_destroy(filter);
+}
+
+static void test_stmt_unique_index(void **state) {
+    (void)state;
+
+    bson_t *filter = BCON_NEW("email", "{", "$param", BCON_INT32(1), "}");
+    mongolite_stmt_t *stmt = mongolite_prepare(g_db, "users", filter, NULL, &error);
+    assert_non_null(stmt);
+    assert_int_equal(MONGOLITE_PLAN_INDEX_EQ, stmt->plan);
+    assert_true(stmt->covered);
+
+    for (int i = 0; i < 30; i++) {
+        char email[32];
+        snprintf(email, sizeof(email), "user%d@test.com", i);
+        assert_int_equal(MONGOLITE_OK, mongolite_bind_utf8(stmt, 1, email));
+
+        const bson_t *doc;
+        assert_int_equal(MONGOLITE_ROW, mongolite_step(stmt, &doc, &error));
+        bson_iter_t iter;
+        assert_true(bson_iter_init_find(&iter, doc, "age"));
+        assert_int_equal(20 + i, bson_iter_int32(&iter));
+        assert_int_equal(MONGOLITE_DONE, mongolite_step(stmt, &doc, &error));
+    }
+
+    /* Miss */
+    mongolite_bind_utf8(stmt, 1, "nobody@test.com");
+    assert_int_equal(0, count_rows(stmt));
+
+    mongolite_finalize(stmt);
+    bson_destroy(filter);
+}
+
+static void test_stmt_index_with_residual(void **state) {
+    (void)state;
+
+    /* Index on email, residual predicate on age needs the matcher */
+    bson_t *filter = BCON_NEW("email", "{", "$param", BCON_INT32(1), "}",
+                              "age", "{", "$gte", "{", "$param", BCON_INT32(2), "}", "}");
+    mongolite_stmt_t *stmt = mongolite_prepare(g_db, "users", filter, NULL, &error);
+    assert_non_null(stmt);
+    assert_int_equal(MONGOLITE_PLAN_INDEX_EQ, stmt->plan);
+    assert_false(stmt->covered);
+
+    mongolite_bind_utf8(stmt, 1, "user5@test.com");
+    mongolite_bind_int32(stmt, 2, 25);
+    assert_int_equal(1, count_rows(stmt));
+
+    mongolite_bind_int32(stmt, 2, 26);
+    assert_int_equal(0, count_rows(stmt));
+
+    mongolite_finalize(stmt);
+    bson_destroy(filter);
+}
+
+static void test_stmt_scan_and_reset(void **state) {
+    (void)state;
+
+    bson_t *filter = BCON_NEW("group", "{", "$param", BCON_INT32(1), "}");
+    mongolite_stmt_t *stmt = mongolite_prepare(g_db, "users", filter, NULL, &error);
+    assert_non_null(stmt);
+    assert_int_equal(MONGOLITE_PLAN_SCAN, stmt->plan);
+
+    mongolite_bind_int32(stmt, 1, 1);
+    assert_int_equal(10, count_rows(stmt));
+
+    /* Partial read, then reset re-executes from the start */
+    const bson_t *doc;
+    assert_int_equal(MONGOLITE_ROW, mongolite_step(stmt, &doc, &error));
+    assert_int_equal(MONGOLITE_OK, mongolite_reset(stmt));
+    assert_int_equal(10, count_rows(stmt));
+
+    mongolite_finalize(stmt);
+    bson_destroy(filter);
+}
+
+static void test_stmt_replans_after_index_change(void **state) {
+    (void)state;
+
+    bson_t *filter = BCON_NEW("group", "{", "$param", BCON_INT32(1), "}");
+    mongolite_stmt_t *stmt = mongolite_prepare(g_db, "users", filter, NULL, &error);
+    assert_non_null(stmt);
+    assert_int_equal(MONGOLITE_PLAN_SCAN, stmt->plan);
+
+    bson_t *keys = BCON_NEW("group", BCON_INT32(1));
+    assert_int_equal(0, mongolite_create_index(g_db, "users", keys, NULL, NULL, &error));
+
+    /* Non-unique index: multi-row seek */
+    mongolite_bind_int32(stmt, 1, 2);
+    assert_int_equal(10, count_rows(stmt));
+    assert_int_equal(MONGOLITE_PLAN_INDEX_EQ, stmt->plan);
+    assert_true(stmt->covered);
+
+    /* Numeric equality across types */
+    mongolite_bind_double(stmt, 1, 0.0);
+    assert_int_equal(10, count_rows(stmt));
+
+    assert_int_equal(0, mongolite_drop_index(g_db, "users", "group_1", &error));
+    mongolite_bind_int32(stmt, 1, 2);
+    assert_int_equal(10, count_rows(stmt));
+    assert_int_equal(MONGOLITE_PLAN_SCAN, stmt->plan);
+
+    mongolite_finalize(stmt);
+    bson_destroy(keys);
+    bson_destroy(filter);
+}
+
+static int fill_recreated(int n) {
+    bson_t *keys = BCON_NEW("k", BCON_INT32(1));
+    int rc = mongolite_collection_create(g_db, "recreated", NULL, &error);
+    for (int i = 0; rc == 0 && i < n; i++) {
+        bson_t *doc = BCON_NEW("k", BCON_INT32(i % 2), "i", BCON_INT32(i));
+        rc = mongolite_insert_one(g_db, "recreated", doc, NULL, &error);
+        bson_destroy(doc);
+    }
+    if (rc == 0) rc = mongolite_create_index(g_db, "recreated", keys, NULL, NULL, &error);
+    bson_destroy(keys);
+    return rc;
+}
+
+static void test_stmt_replans_after_recreate(void **state) {
+    (void)state;
+
+    assert_int_equal(0, fill_recreated(20));
+    bson_t *filter = BCON_NEW("k", "{", "$param", BCON_INT32(1), "}");
+    mongolite_stmt_t *stmt = mongolite_prepare(g_db, "recreated", filter, NULL, &error);
+    assert_non_null(stmt);
+    assert_int_equal(MONGOLITE_PLAN_INDEX_EQ, stmt->plan);
+    mongolite_bind_int32(stmt, 1, 1);
+    assert_int_equal(10, count_rows(stmt));
+
+    /* The new entry may reuse the old address with the same index epoch:
+     * the plan must not keep the freed index */
+    for (int round = 0; round < 3; round++) {
+        assert_int_equal(0, mongolite_collection_drop(g_db, "recreated", &error));
+        assert_int_equal(0, fill_recreated(6 + round * 2));
+        assert_int_equal(3 + round, count_rows(stmt));
+        assert_int_equal(MONGOLITE_PLAN_INDEX_EQ, stmt->plan);
+        assert_int_equal(g_db->tree_cache_generation, stmt->plan_generation);
+    }
+
+    /* Dropped between the first step and the rest */
+    const bson_t *doc;
+    assert_int_equal(MONGOLITE_ROW, mongolite_step(stmt, &doc, &error));
+    assert_int_equal(0, mongolite_collection_drop(g_db, "recreated", &error));
+    assert_int_equal(MONGOLITE_OK, mongolite_reset(stmt));
+
+    mongolite_finalize(stmt);
+    bson_destroy(filter);
+}
+
+static void test_stmt_id_lookup(void **state) {
+    (void)state;
+
+    bson_oid_t id;
+    bson_t *doc = BCON_NEW("email", BCON_UTF8("byid@test.com"), "age", BCON_INT32(99));
+    assert_int_equal(0, mongolite_insert_one(g_db, "users", doc, &id, &error));
+    bson_destroy(doc);
+
+    bson_t *filter = BCON_NEW("_id", "{", "$param", BCON_INT32(1), "}");
+    mongolite_stmt_t *stmt = mongolite_prepare(g_db, "users", filter, NULL, &error);
+    assert_non_null(stmt);
+    assert_int_equal(MONGOLITE_PLAN_ID, stmt->plan);
+
+    mongolite_bind_oid(stmt, 1, &id);
+    const bson_t *found;
+    assert_int_equal(MONGOLITE_ROW, mongolite_step(stmt, &found, &error));
+    bson_iter_t iter;
+    assert_true(bson_iter_init_find(&iter, found, "age"));
+    assert_int_equal(99, bson_iter_int32(&iter));
+    assert_int_equal(MONGOLITE_DONE, mongolite_step(stmt, &found, &error));
+
+    bson_oid_t other;
+    bson_oid_init(&other, NULL);
+    mongolite_bind_oid(stmt, 1, &other);
+    assert_int_equal(0, count_rows(stmt));
+
+    mongolite_finalize(stmt);
+    bson_destroy(filter);
+}
+
+static void test_stmt_literal_filter(void **state) {
+    (void)state;
+
+    /* No placeholders: matcher compiled once at prepare */
+    bson_t *filter = BCON_NEW("age", "{", "$lt", BCON_INT32(25), "}");
+    mongolite_stmt_t *stmt = mongolite_prepare(g_db, "users", filter, NULL, &error);
+    assert_non_null(stmt);
+    assert_int_equal(0, mongolite_bind_count(stmt));
+    assert_int_equal(5, count_rows(stmt));
+    assert_int_equal(5, count_rows(stmt));
+
+    mongolite_finalize(stmt);
+    bson_destroy(filter);
+}
+
+/* ============================================================
+ * Test Runner
+ * ============================================================ */
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_prepare_counts_params),
+        cmocka_unit_test(test_prepare_invalid),
+        cmocka_unit_test(test_stmt_unique_index),
+        cmocka_unit_test(test_stmt_index_with_residual),
+        cmocka_unit_test(test_stmt_scan_and_reset),
+        cmocka_unit_test(test_stmt_replans_after_index_change),
+        cmocka_unit_test(test_stmt_replans_after_recreate),
+        cmocka_unit_test(test_stmt_id_lookup),
+        cmocka_unit_test(test_stmt_literal_filter),
+    };
+
+    return cmocka_run_group_tests_name("tests", tests, global_setup, global_teardown);
+}
@@ -0,0 +1,315 @@
+/**
+ * test_mongolite_text.c - Tests for text indexes and $text queries
+ *
+ * Tests:
+ * - Tokenizer: separators, lowercasing, sorted distinct terms
+ * - Text index creation: name, invalid specs, one per collection
+ * - $text find/count/find_one: every term must match, other predicates
+ *   are still applied, explain reports a TEXT stage
+ * - Updates and deletes keep the posting lists current; verify passes
+ * - The index survives reopening the database
+ * - $text without a text index is an error
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "mongolite.h"
+#include "mongolite_internal.h"
+
+/* ============================================================
+ * Test Setup/Teardown
+ * ============================================================ */
+
+static mongolite_db_t *g_db = NULL;
+static const char *DB_PATH = "./test_text_db";
+
+static void cleanup_db_path(void) {
+    char cmd[256];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", DB_PATH);
+    system(cmd);
+}
+
+static int open_db(void) {
+    gerror_t error = {0};
+    db_config_t config = {0};
+    config.max_bytes = 64ULL * 1024 * 1024;
+    return mongolite_open(DB_PATH, &g_db, &config, &error);
+}
+
+static int setup(void **state) {
+    (void)state;
+    cleanup_db_path();
+
+    gerror_t error = {0};
+    if (open_db() != 0) return -1;
+    return mongolite_collection_create(g_db, "notes", NULL, &error);
+}
+
+static int teardown(void **state) {
+    (void)state;
+    if (g_db) {
+        mongolite_close(g_db);
+        g_db = NULL;
+    }
+    cleanup_db_path();
+    return 0;
+}
+
+static void insert_note(int n, const char *title, const char *body) {
+    gerror_t error = {0};
+    bson_t *doc = BCON_NEW("n", BCON_INT32(n), "title", BCON_UTF8(title),
+                           "body", BCON_UTF8(body));
+    assert_int_equal(MONGOLITE_OK, mongolite_insert_one(g_db, "notes", doc, NULL, &error));
+    bson_destroy(doc);
+}
+
+static void create_text_index(void) {
+    gerror_t error = {0};
+    bson_t *keys = BCON_NEW("title", BCON_UTF8("text"), "body", BCON_UTF8("text"));
+    assert_int_equal(MONGOLITE_OK,
+                     mongolite_create_index(g_db, "notes", keys, NULL, NULL, &error));
+    bson_destroy(keys);
+}
+
+/* Sum of the "n" fields of the documents matching filter (-1 on error) */
+static int64_t sum_matching(const bson_t *filter) {
+    gerror_t error = {0};
+    mongolite_cursor_t *cursor = mongolite_find(g_db, "notes", filter, NULL, &error);
+    if (!cursor) return -1;
+
+    int64_t sum = 0;
+    const bson_t *doc;
+    while (mongolite_cursor_next(cursor, &doc)) {
+        bson_iter_t iter;
+        if (bson_iter_init_find(&iter, doc, "n")) sum += bson_iter_int32(&iter);
+    }
+    mongolite_cursor_destroy(cursor);
+    return sum;
+}
+
+static int64_t search_sum(const char *search) {
+    bson_t *filter = BCON_NEW("$text", "{", "$search", BCON_UTF8(search), "}");
+    int64_t sum = sum_matching(filter);
+    bson_destroy(filter);
+    return sum;
+}
+
+/* Notes 1, 2, 4, 8, 16: sums identify the matching set */
+static void insert_notes(void) {
+    insert_note(1, "Shopping list", "Milk, eggs and BREAD");
+    insert_note(2, "Meeting notes", "Discuss the bread supplier; eggs later");
+    insert_note(4, "Recipe", "bread: flour, water, salt");
+    insert_note(8, "Travel", "Train to Lisbon at 9:30");
+    insert_note(16, "Misc", "nothing to see here");
+}
+
+/* ============================================================
+ * Tests
+ * ============================================================ */
+
+static void test_tokenizer(void **state) {
+    (void)state;
+    mongolite_text_terms_t t;
+    _mongolite_text_terms_init(&t);
+    const char *text = "  Hello, world! hello\tWORLD (again)-again ";
+    assert_true(_mongolite_text_terms_add(&t, text, strlen(text)));
+    _mongolite_text_terms_finish(&t);
+
+    /* "!" is not a separator */
+    static const char *const expected[] = {"again", "hello", "world", "world!"};
+    assert_int_equal(4, t.n);
+    for (size_t i = 0; i < t.n; i++) {
+        assert_int_equal(strlen(expected[i]), t.terms[i].len);
+        assert_memory_equal(expected[i], t.terms[i].p, t.terms[i].len);
+    }
+    _mongolite_text_terms_free(&t);
+
+    /* Long terms are cut */
+    char longword[400];
+    memset(longword, 'x', sizeof(longword));
+    _mongolite_text_terms_init(&t);
+    assert_true(_mongolite_text_terms_add(&t, longword, sizeof(longword)));
+    _mongolite_text_terms_finish(&t);
+    assert_int_equal(1, t.n);
+    assert_int_equal(MONGOLITE_TEXT_MAX_TERM, t.terms[0].len);
+    _mongolite_text_terms_free(&t);
+}
+
+static void test_create_text_index(void **state) {
+    (void)state;
+    gerror_t error = {0};
+    insert_notes();
+    create_text_index();
+
+    mongolite_cached_index_t *cached;
+    size_t count;
+    cached = _mongolite_get_cached_indexes(g_db, "notes", &count, &error);
+    assert_non_null(cached);
+    bool found = false;
+    for (size_t i = 0; i < count; i++) {
+        if (strcmp(cached[i].name, "title_text_body_text") == 0) {
+            assert_true(cached[i].text);
+            found = true;
+        }
+    }
+    assert_true(found);
+
+    /* One text index per collection */
+    bson_t *keys = BCON_NEW("body", BCON_UTF8("text"));
+    assert_int_equal(MONGOLITE_EINVAL,
+                     mongolite_create_index(g_db, "notes", keys, NULL, NULL, &error));
+    bson_destroy(keys);
+
+    /* Text mixed with ordinary keys, unique text */
+    assert_int_equal(MONGOLITE_OK, mongolite_collection_create(g_db, "other", NULL, &error));
+    keys = BCON_NEW("title", BCON_UTF8("text"), "n", BCON_INT32(1));
+    assert_int_equal(MONGOLITE_EINVAL,
+                     mongolite_create_index(g_db, "other", keys, NULL, NULL, &error));
+    bson_destroy(keys);
+    keys = BCON_NEW("title", BCON_UTF8("text"));
+    index_config_t config = {0};
+    config.unique = true;
+    assert_int_equal(MONGOLITE_EINVAL,
+                     mongolite_create_index(g_db, "other", keys, NULL, &config, &error));
+    bson_destroy(keys);
+}
+
+static void test_text_search(void **state) {
+    (void)state;
+    gerror_t error = {0};
+    insert_notes();
+    create_text_index();
+
+    assert_int_equal(1 + 2 + 4, search_sum("bread"));
+    assert_int_equal(1 + 2 + 4, search_sum("BREAD"));
+    assert_int_equal(1 + 2, search_sum("bread eggs"));
+    assert_int_equal(2, search_sum("eggs, bread; supplier"));
+    assert_int_equal(8, search_sum("lisbon"));
+    assert_int_equal(0, search_sum("bread lisbon"));
+    assert_int_equal(0, search_sum("absent"));
+    assert_int_equal(0, search_sum("  ,. "));
+
+    /* Combined with other predicates */
+    bson_t *filter = BCON_NEW("$text", "{", "$search", BCON_UTF8("bread"), "}",
+                              "n", "{", "$gte", BCON_INT32(2), "}");
+    assert_int_equal(2 + 4, sum_matching(filter));
+    assert_int_equal(2, mongolite_collection_count(g_db, "notes", filter, &error));
+
+    bson_t *doc = mongolite_find_one(g_db, "notes", filter, NULL, &error);
+    assert_non_null(doc);
+    bson_destroy(doc);
+    bson_destroy(filter);
+
+    /* Explain: the text index, one key per term */
+    filter = BCON_NEW("$text", "{", "$search", BCON_UTF8("bread eggs"), "}");
+    bson_t *report = mongolite_explain(g_db, "notes", filter, NULL, NULL, &error);
+    assert_non_null(report);
+    bson_iter_t iter, found;
+    assert_true(bson_iter_init(&iter, report));
+    assert_true(bson_iter_find_descendant(&iter, "queryPlanner.winningPlan.inputStage.stage",
+                                          &found));
+    assert_string_equal("TEXT", bson_iter_utf8(&found, NULL));
+    assert_true(bson_iter_init(&iter, report));
+    assert_true(bson_iter_find_descendant(&iter, "executionStats.nReturned", &found));
+    assert_int_equal(2, bson_iter_as_int64(&found));
+    bson_destroy(report);
+    bson_destroy(filter);
+}
+
+static void test_text_maintenance(void **state) {
+    (void)state;
+    gerror_t error = {0};
+    insert_notes();
+    create_text_index();
+
+    /* Indexed after creation, including string arrays */
+    bson_t *doc = BCON_NEW("n", BCON_INT32(32), "body", "[", BCON_UTF8("fresh bread"),
+                           BCON_INT32(7), BCON_UTF8("jam"), "]");
+    assert_int_equal(MONGOLITE_OK, mongolite_insert_one(g_db, "notes", doc, NULL, &error));
+    bson_destroy(doc);
+    assert_int_equal(1 + 2 + 4 + 32, search_sum("bread"));
+    assert_int_equal(32, search_sum("jam"));
+
+    /* Update moves the document between posting lists */
+    bson_t *filter = BCON_NEW("n", BCON_INT32(4));
+    bson_t *update = BCON_NEW("$set", "{", "body", BCON_UTF8("pancakes with jam"), "}");
+    assert_int_equal(MONGOLITE_OK,
+                     mongolite_update_one(g_db, "notes", filter, update, false, &error));
+    bson_destroy(update);
+    bson_destroy(filter);
+    assert_int_equal(1 + 2 + 32, search_sum("bread"));
+    assert_int_equal(4 + 32, search_sum("jam"));
+
+    /* Delete removes every posting */
+    filter = BCON_NEW("n", BCON_INT32(32));
+    assert_int_equal(MONGOLITE_OK, mongolite_delete_one(g_db, "notes", filter, &error));
+    bson_destroy(filter);
+    assert_int_equal(1 + 2, search_sum("bread"));
+    assert_int_equal(4, search_sum("jam"));
+
+    wtree3_tree_t *tree = _mongolite_tree_cache_get(g_db, "notes");
+    assert_non_null(tree);
+    assert_int_equal(0, wtree3_verify_indexes(tree, &error));
+}
+
+static void test_text_reopen(void **state) {
+    (void)state;
+    insert_notes();
+    create_text_index();
+
+    mongolite_close(g_db);
+    g_db = NULL;
+    assert_int_equal(0, open_db());
+
+    assert_int_equal(1 + 2, search_sum("eggs"));
+    insert_note(64, "Eggs", "more eggs");
+    assert_int_equal(1 + 2 + 64, search_sum("eggs"));
+}
+
+static void test_text_requires_index(void **state) {
+    (void)state;
+    gerror_t error = {0};
+    insert_notes();
+
+    bson_t *filter = BCON_NEW("$text", "{", "$search", BCON_UTF8("bread"), "}");
+    mongolite_cursor_t *cursor = mongolite_find(g_db, "notes", filter, NULL, &error);
+    assert_null(cursor);
+    assert_int_equal(MONGOLITE_EQUERY, error.code);
+
+    error = (gerror_t){0};
+    assert_null(mongolite_find_one(g_db, "notes", filter, NULL, &error));
+    assert_int_equal(MONGOLITE_EQUERY, error.code);
+    assert_int_equal(-1, mongolite_collection_count(g_db, "notes", filter, &error));
+    bson_destroy(filter);
+
+    /* Unsupported options are not answered by the index either */
+    create_text_index();
+    filter = BCON_NEW("$text", "{", "$search", BCON_UTF8("bread"),
+                      "$language", BCON_UTF8("klingon"), "}");
+    assert_int_equal(-1, sum_matching(filter));
+    bson_destroy(filter);
+}
+
+/* ============================================================
+ * Test Runner
+ * ============================================================ */
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_tokenizer),
+        cmocka_unit_test_setup_teardown(test_create_text_index, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_text_search, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_text_maintenance, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_text_reopen, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_text_requires_index, setup, teardown),
+    };
+
+    return cmocka_run_group_tests_name("tests", tests, NULL, NULL);
+}
@@ -6,6 +6,10 @@
  * - Index selection for matching queries
  * - find_one using secondary index
  * - Fallback to collection scan when no index
+ * - Plan cache keyed by query shape
+ * - Index-only filtered count
+ * - $in point seeks and $or index unions agree with a scan
+ * - Index intersection (merge-join) for equalities on separate indexes
  */
 
 #include <stdarg.h>
@@ -341,6 +345,377 @@ static void test_find_one_compound_index(void **state) {
     mongolite_collection_drop(g_db, "compound", NULL);
 }
 
+/* ============================================================
+ * Tests: Plan Cache
+ * ============================================================ */
+
+static void test_query_shape(void **state) {
+    (void)state;
+
+    char a[MONGOLITE_QUERY_SHAPE_MAX], b[MONGOLITE_QUERY_SHAPE_MAX];
+
+    /* Same fields and types, different values: same shape */
+    bson_t *f1 = BCON_NEW("email", BCON_UTF8("a@x.com"), "age", "{", "$gt", BCON_INT32(1), "}");
+    bson_t *f2 = BCON_NEW("email", BCON_UTF8("b@x.com"), "age", "{", "$gt", BCON_INT32(9), "}");
+    assert_true(_mongolite_query_shape(f1, a, sizeof(a)) > 0);
+    assert_true(_mongolite_query_shape(f2, b, sizeof(b)) > 0);
+    assert_string_equal(a, b);
+    bson_destroy(f2);
+
+    /* Different operator: different shape */
+    f2 = BCON_NEW("email", BCON_UTF8("b@x.com"), "age", "{", "$lt", BCON_INT32(9), "}");
+    assert_true(_mongolite_query_shape(f2, b, sizeof(b)) > 0);
+    assert_string_not_equal(a, b);
+    bson_destroy(f2);
+
+    /* Different equality type: different shape */
+    f2 = BCON_NEW("email", BCON_INT32(5), "age", "{", "$gt", BCON_INT32(9), "}");
+    assert_true(_mongolite_query_shape(f2, b, sizeof(b)) > 0);
+    assert_string_not_equal(a, b);
+
+    bson_destroy(f1);
+    bson_destroy(f2);
+}
+
+static void test_plan_cache_hits_and_invalidation(void **state) {
+    (void)state;
+
+    int rc = mongolite_collection_create(g_db, "plan_cache", NULL, &error);
+    assert_int_equal(0, rc);
+
+    for (int i = 0; i < 20; i++) {
+        char email[32];
+        snprintf(email, sizeof(email), "user%d@test.com", i);
+        bson_t *doc = BCON_NEW("email", BCON_UTF8(email), "n", BCON_INT32(i));
+        rc = mongolite_insert_one(g_db, "plan_cache", doc, NULL, &error);
+        assert_int_equal(0, rc);
+        bson_destroy(doc);
+    }
+
+    uint64_t hits = 0, replans = 0;
+    for (int i = 0; i < 20; i++) {
+        char email[32];
+        snprintf(email, sizeof(email), "user%d@test.com", i);
+        bson_t *filter = BCON_NEW("email", BCON_UTF8(email));
+        bson_t *found = mongolite_find_one(g_db, "plan_cache", filter, NULL, &error);
+        assert_non_null(found);
+        bson_destroy(found);
+        bson_destroy(filter);
+    }
+
+    rc = mongolite_plan_cache_stats(g_db, "plan_cache", &hits, &replans, &error);
+    assert_int_equal(0, rc);
+    assert_int_equal(1, replans);
+    assert_int_equal(19, hits);
+
+    /* Creating an index drops cached plans; the next query re-plans onto it */
+    bson_t *keys = BCON_NEW("email", BCON_INT32(1));
+    rc = mongolite_create_index(g_db, "plan_cache", keys, "email_1", NULL, &error);
+    assert_int_equal(0, rc);
+
+    bson_t *filter = BCON_NEW("email", BCON_UTF8("user7@test.com"));
+    bson_t *found = mongolite_find_one(g_db, "plan_cache", filter, NULL, &error);
+    assert_non_null(found);
+    bson_iter_t iter;
+    assert_true(bson_iter_init_find(&iter, found, "n"));
+    assert_int_equal(7, bson_iter_int32(&iter));
+    bson_destroy(found);
+
+    mongolite_plan_cache_stats(g_db, "plan_cache", &hits, &replans, &error);
+    assert_int_equal(2, replans);
+
+    /* Dropping it invalidates again and falls back to a scan */
+    rc = mongolite_drop_index(g_db, "plan_cache", "email_1", &error);
+    assert_int_equal(0, rc);
+
+    found = mongolite_find_one(g_db, "plan_cache", filter, NULL, &error);
+    assert_non_null(found);
+    assert_true(bson_iter_init_find(&iter, found, "n"));
+    assert_int_equal(7, bson_iter_int32(&iter));
+    bson_destroy(found);
+
+    mongolite_plan_cache_stats(g_db, "plan_cache", &hits, &replans, &error);
+    assert_int_equal(3, replans);
+
+    bson_destroy(filter);
+    bson_destroy(keys);
+    mongolite_collection_drop(g_db, "plan_cache", NULL);
+}
+
+/* ============================================================
+ * Tests: Index-only Count
+ * ============================================================ */
+
+/* Count through the index path, and check it agrees with a scan of an
+ * identical collection that has no indexes */
+static int64_t count_both_ways(bson_t *filter, int expect_index) {
+    _mongolite_lock(g_db);
+    mongolite_tree_cache_entry_t *entry = _mongolite_get_collection_entry(g_db, "counted", &error);
+    assert_non_null(entry);
+    int64_t direct = -1;
+    int rc = _mongolite_count_with_index(g_db, entry, filter, &direct, &error);
+    _mongolite_unlock(g_db);
+    assert_int_equal(expect_index, rc);
+
+    int64_t fast = mongolite_collection_count(g_db, "counted", filter, &error);
+    int64_t scan = mongolite_collection_count(g_db, "counted_scan", filter, &error);
+
+    assert_int_equal(scan, fast);
+    if (expect_index) assert_int_equal(scan, direct);
+    bson_destroy(filter);
+    return fast;
+}
+
+static void insert_both(bson_t *doc) {
+    assert_int_equal(0, mongolite_insert_one(g_db, "counted", doc, NULL, &error));
+    assert_int_equal(0, mongolite_insert_one(g_db, "counted_scan", doc, NULL, &error));
+    bson_destroy(doc);
+}
+
+static void test_count_with_index(void **state) {
+    (void)state;
+
+    int rc = mongolite_collection_create(g_db, "counted", NULL, &error);
+    assert_int_equal(0, rc);
+
+    bson_t *keys = BCON_NEW("status", BCON_INT32(1));
+    rc = mongolite_create_index(g_db, "counted", keys, "status_1", NULL, &error);
+    assert_int_equal(0, rc);
+    bson_destroy(keys);
+
+    keys = BCON_NEW("cat", BCON_INT32(1), "n", BCON_INT32(1));
+    rc = mongolite_create_index(g_db, "counted", keys, "cat_n_1", NULL, &error);
+    assert_int_equal(0, rc);
+    bson_destroy(keys);
+
+    rc = mongolite_collection_create(g_db, "counted_scan", NULL, &error);
+    assert_int_equal(0, rc);
+
+    const char *statuses[] = {"active", "idle", "closed"};
+    for (int i = 0; i < 90; i++) {
+        insert_both(BCON_NEW("status", BCON_UTF8(statuses[i % 3]),
+                             "cat", BCON_INT32(i % 5),
+                             "n", BCON_INT32(i)));
+    }
+
+    /* Mixed types and missing fields around the numeric range */
+    insert_both(BCON_NEW("cat", BCON_INT32(1), "n", BCON_UTF8("text")));
+    insert_both(BCON_NEW("cat", BCON_INT32(1), "n", BCON_DOUBLE(10.5)));
+    insert_both(BCON_NEW("cat", BCON_INT32(1)));
+
+    /* Exact key: single seek + mdb_cursor_count */
+    assert_int_equal(30, count_both_ways(BCON_NEW("status", BCON_UTF8("idle")), 1));
+    assert_int_equal(0, count_both_ways(BCON_NEW("status", BCON_UTF8("none")), 1));
+    assert_int_equal(1, count_both_ways(
+        BCON_NEW("cat", BCON_INT32(2), "n", BCON_DOUBLE(7.0)), 1));
+
+    /* Equality prefix of a compound index */
+    assert_int_equal(21, count_both_ways(BCON_NEW("cat", BCON_INT64(1)), 1));
+
+    /* Ranges */
+    assert_int_equal(9, count_both_ways(
+        BCON_NEW("cat", BCON_INT32(1), "n", "{", "$gte", BCON_INT32(10),
+                                                  "$lt", BCON_INT32(50), "}"), 1));
+    assert_int_equal(17, count_both_ways(
+        BCON_NEW("cat", BCON_INT32(1), "n", "{", "$gt", BCON_INT32(10), "}"), 1));
+    assert_int_equal(4, count_both_ways(
+        BCON_NEW("cat", BCON_INT32(1), "n", "{", "$lte", BCON_INT32(11), "}"), 1));
+    assert_int_equal(18, count_both_ways(
+        BCON_NEW("cat", "{", "$gt", BCON_INT32(3), "}"), 1));
+
+    /* Not answerable from an index: falls back to the matcher */
+    count_both_ways(BCON_NEW("n", BCON_INT32(5)), 0);
+    count_both_ways(BCON_NEW("status", BCON_UTF8("idle"), "n", BCON_INT32(4)), 0);
+    count_both_ways(BCON_NEW("status", "{", "$ne", BCON_UTF8("idle"), "}"), 0);
+    count_both_ways(BCON_NEW("cat", BCON_NULL), 0);
+    count_both_ways(BCON_NEW("status", "{", "$gt", BCON_UTF8("b"), "}"), 0);
+
+    mongolite_collection_drop(g_db, "counted", NULL);
+    mongolite_collection_drop(g_db, "counted_scan", NULL);
+}
+
+/* ============================================================
+ * Tests: Multi-point Index Seeks
+ * ============================================================ */
+
+static void seek_insert_both(bson_t *doc) {
+    assert_int_equal(0, mongolite_insert_one(g_db, "seeks", doc, NULL, &error));
+    assert_int_equal(0, mongolite_insert_one(g_db, "seeks_scan", doc, NULL, &error));
+    bson_destroy(doc);
+}
+
+static uint64_t seek_index_queries(void) {
+    mongolite_op_stats_t col;
+    assert_int_equal(0, mongolite_collection_stats(g_db, "seeks", &col, &error));
+    return col.index_queries;
+}
+
+/* The "n" values find returns, in order */
+static int seek_find_ns(const char *collection, const bson_t *filter, int *out) {
+    mongolite_cursor_t *cursor = mongolite_find(g_db, collection, filter, NULL, &error);
+    assert_non_null(cursor);
+    const bson_t *doc;
+    int count = 0;
+    while (mongolite_cursor_next(cursor, &doc)) {
+        bson_iter_t it;
+        out[count++] = bson_iter_init_find(&it, doc, "n") ? bson_iter_int32(&it) : -1;
+    }
+    mongolite_cursor_destroy(cursor);
+    return count;
+}
+
+/* find, find_one and count on the indexed collection agree with a scan of
+ * an identical one; returns the number of matches */
+static int seek_both_ways(bson_t *filter, bool expect_index) {
+    int fast[128], scan[128];
+
+    uint64_t before = seek_index_queries();
+    int n = seek_find_ns("seeks", filter, fast);
+    assert_int_equal(expect_index, seek_index_queries() > before);
+    assert_int_equal(seek_find_ns("seeks_scan", filter, scan), n);
+    assert_memory_equal(scan, fast, (size_t)n * sizeof(int));
+
+    bson_t *one = mongolite_find_one(g_db, "seeks", filter, NULL, &error);
+    assert_int_equal(n > 0, one != NULL);
+    if (one) {
+        bson_iter_t it;
+        assert_true(bson_iter_init_find(&it, one, "n"));
+        assert_int_equal(scan[0], bson_iter_int32(&it));
+        bson_destroy(one);
+    }
+
+    assert_int_equal(n, mongolite_collection_count(g_db, "seeks", filter, &error));
+    bson_destroy(filter);
+    return n;
+}
+
+static void test_index_seeks_in_and_or(void **state) {
+    (void)state;
+
+    assert_int_equal(0, mongolite_collection_create(g_db, "seeks", NULL, &error));
+    assert_int_equal(0, mongolite_collection_create(g_db, "seeks_scan", NULL, &error));
+
+    bson_t *keys = BCON_NEW("status", BCON_INT32(1));
+    assert_int_equal(0, mongolite_create_index(g_db, "seeks", keys, NULL, NULL, &error));
+    bson_destroy(keys);
+    keys = BCON_NEW("cat", BCON_INT32(1), "n", BCON_INT32(1));
+    assert_int_equal(0, mongolite_create_index(g_db, "seeks", keys, NULL, NULL, &error));
+    bson_destroy(keys);
+    keys = BCON_NEW("n", BCON_INT32(1));
+    assert_int_equal(0, mongolite_create_index(g_db, "seeks", keys, NULL, NULL, &error));
+    bson_destroy(keys);
+
+    const char *statuses[] = {"active", "idle", "closed", "new"};
+    for (int i = 0; i < 80; i++) {
+        seek_insert_both(BCON_NEW("n", BCON_INT32(i), "status", BCON_UTF8(statuses[i % 4]),
+                                  "cat", BCON_INT32(i % 5)));
+    }
+
+    /* $in on one index: sorted point seeks, results in _id order */
+    assert_int_equal(40, seek_both_ways(BCON_NEW("status", "{", "$in", "[",
+        BCON_UTF8("new"), BCON_UTF8("active"), BCON_UTF8("gone"), BCON_UTF8("new"),
+        "]", "}"), true));
+    assert_int_equal(0, seek_both_ways(BCON_NEW("status", "{", "$in", "[", "]", "}"), true));
+
+    /* Residual predicates run on the fetched documents only */
+    assert_int_equal(8, seek_both_ways(BCON_NEW("status", "{", "$in", "[",
+        BCON_UTF8("idle"), BCON_UTF8("closed"), "]", "}",
+        "cat", BCON_INT32(3)), true));
+
+    /* Equality and $in on a compound key; mixed numeric types */
+    assert_int_equal(2, seek_both_ways(BCON_NEW(
+        "cat", "{", "$in", "[", BCON_DOUBLE(1.0), BCON_INT64(2), "]", "}",
+        "n", "{", "$in", "[", BCON_INT32(6), BCON_INT32(7), BCON_INT32(8), "]", "}"), true));
+    assert_int_equal(1, seek_both_ways(BCON_NEW("cat", BCON_INT32(4), "n", BCON_INT32(9)),
+                                       true));
+
+    /* $or: union over several indexes, overlaps returned once */
+    assert_int_equal(22, seek_both_ways(BCON_NEW("$or", "[",
+        "{", "status", BCON_UTF8("idle"), "}",
+        "{", "n", "{", "$in", "[",
+            BCON_INT32(5), BCON_INT32(9), BCON_INT32(10), BCON_INT32(20), "]", "}", "}",
+        "{", "n", BCON_INT32(1), "}",
+        "]"), true));
+    assert_int_equal(8, seek_both_ways(BCON_NEW(
+        "$or", "[", "{", "status", BCON_UTF8("new"), "}",
+                    "{", "status", BCON_UTF8("active"), "}", "]",
+        "cat", BCON_INT32(2)), true));
+
+    /* A clause no index serves: the whole $or scans */
+    seek_both_ways(BCON_NEW("$or", "[", "{", "status", BCON_UTF8("new"), "}",
+                                        "{", "cat", BCON_INT32(3), "}", "]"), false);
+    seek_both_ways(BCON_NEW("status", "{", "$in", "[", BCON_UTF8("new"),
+                            BCON_REGEX("^a", ""), "]", "}"), false);
+    seek_both_ways(BCON_NEW("status", "{", "$in", "[", BCON_UTF8("new"), "]",
+                            "$ne", BCON_UTF8("x"), "}"), false);
+
+    /* Index entries hold the collection key, generated OIDs included */
+    seek_insert_both(BCON_NEW("_id", BCON_UTF8("custom"), "n", BCON_INT32(100),
+                              "status", BCON_UTF8("new")));
+    assert_int_equal(21, seek_both_ways(BCON_NEW("status", "{", "$in", "[",
+        BCON_UTF8("new"), "]", "}"), true));
+
+    mongolite_collection_drop(g_db, "seeks", NULL);
+    mongolite_collection_drop(g_db, "seeks_scan", NULL);
+}
+
+static uint64_t intersections(void) {
+    mongolite_stats_t stats;
+    assert_int_equal(0, mongolite_stats(g_db, &stats, &error));
+    return stats.index_intersections;
+}
+
+static void test_index_intersection(void **state) {
+    (void)state;
+
+    assert_int_equal(0, mongolite_collection_create(g_db, "seeks", NULL, &error));
+    assert_int_equal(0, mongolite_collection_create(g_db, "seeks_scan", NULL, &error));
+
+    const char *fields[] = {"a", "b", "flag"};
+    for (int i = 0; i < 3; i++) {
+        bson_t *keys = BCON_NEW(fields[i], BCON_INT32(1));
+        assert_int_equal(0, mongolite_create_index(g_db, "seeks", keys, NULL, NULL, &error));
+        bson_destroy(keys);
+    }
+
+    for (int i = 0; i < 400; i++) {
+        seek_insert_both(BCON_NEW("n", BCON_INT32(i), "a", BCON_INT32(i % 10),
+                                  "b", BCON_INT32(i % 7), "c", BCON_INT32(i % 3),
+                                  "flag", BCON_BOOL(i == 5)));
+    }
+
+    /* Two single-field indexes: merge-join, fetch only the intersection */
+    uint64_t before = intersections();
+    assert_int_equal(5, seek_both_ways(BCON_NEW("a", BCON_INT32(3), "b", BCON_INT32(4)),
+                                       true));
+    assert_true(intersections() > before);
+
+    /* Residual predicate on an unindexed field; a key with no entries */
+    assert_int_equal(2, seek_both_ways(BCON_NEW("a", BCON_INT32(3), "b", BCON_INT32(4),
+                                                "c", BCON_INT32(2)), true));
+    assert_int_equal(0, seek_both_ways(BCON_NEW("b", BCON_INT32(4), "a", BCON_INT32(99)),
+                                       true));
+
+    /* An $in is not a single sorted stream: one index plus the matcher */
+    before = intersections();
+    assert_int_equal(11, seek_both_ways(BCON_NEW("a", BCON_INT32(3), "b", "{", "$in", "[",
+        BCON_INT32(4), BCON_INT32(5), "]", "}"), true));
+    assert_int_equal(before, intersections());
+
+    /* 399 entries against 40: walking the larger one costs more than it
+     * saves, so the matcher checks flag on the 40 (n=5 is flagged) */
+    assert_int_equal(39, seek_both_ways(BCON_NEW("flag", BCON_BOOL(false), "a", BCON_INT32(5)),
+                                        true));
+    assert_int_equal(before, intersections());
+    /* The other way round the single flagged entry drives alone */
+    assert_int_equal(1, seek_both_ways(BCON_NEW("flag", BCON_BOOL(true), "a", BCON_INT32(5)),
+                                       true));
+    assert_int_equal(before, intersections());
+
+    mongolite_collection_drop(g_db, "seeks", NULL);
+    mongolite_collection_drop(g_db, "seeks_scan", NULL);
+}
+
 /* ============================================================
  * Test Runner
  * ============================================================ */
@@ -363,6 +738,17 @@ int main(void) {
         cmocka_unit_test(test_find_one_not_found_with_index),
         cmocka_unit_test(test_find_one_falls_back_to_scan),
         cmocka_unit_test(test_find_one_compound_index),
+
+        /* Plan Cache */
+        cmocka_unit_test(test_query_shape),
+        cmocka_unit_test(test_plan_cache_hits_and_invalidation),
+
+        /* Index-only Count */
+        cmocka_unit_test(test_count_with_index),
+
+        /* Multi-point Index Seeks */
+        cmocka_unit_test(test_index_seeks_in_and_or),
+        cmocka_unit_test(test_index_intersection),
     };
 
     int rc = cmocka_run_group_tests_name("tests", tests, global_setup, global_teardown);
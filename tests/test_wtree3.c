@@ -87,6 +87,39 @@ static bool simple_key_extractor(const void *value, size_t value_len,
     return true;
 }
 
+/* Multi-key: "tags:a,b,c" yields the packed keys "a", "b" and "c" */
+static bool list_key_extractor(const void *value, size_t value_len,
+                               void *user_data,
+                               void **out_key, size_t *out_len) {
+    void *field;
+    size_t len;
+    if (!simple_key_extractor(value, value_len, user_data, &field, &len)) {
+        return false;
+    }
+
+    /* At most one length prefix per byte of the field */
+    uint8_t *packed = malloc(len * (sizeof(uint32_t) + 1) + sizeof(uint32_t));
+    if (!packed) {
+        free(field);
+        return false;
+    }
+    size_t used = 0, start = 0;
+    const char *s = field;
+    for (size_t i = 0; i <= len; i++) {
+        if (i < len && s[i] != ',') continue;
+        uint32_t n = (uint32_t)(i - start);
+        memcpy(packed + used, &n, sizeof(n));
+        memcpy(packed + used + sizeof(n), s + start, n);
+        used += sizeof(n) + n;
+        start = i + 1;
+    }
+    free(field);
+
+    *out_key = packed;
+    *out_len = used;
+    return true;
+}
+
 /* ============================================================
  * Test Fixtures
  * ============================================================ */
@@ -108,7 +141,7 @@ static int setup_db(void **state) {
     }
 
     /* Register simple key extractor for all flag combinations */
-    /* Flags: 0x00 = non-unique, non-sparse; 0x01 = unique; 0x02 = sparse; 0x03 = unique+sparse */
+    /* Flags: 0x00 = non-unique, non-sparse; 0x01 = unique; 0x02 = sparse; 0x03 = unique+sparse; 0x04 = multi-key */
     int rc;
     rc = wtree3_db_register_key_extractor(test_db, version, 0x00, simple_key_extractor, &error);
     if (rc != 0) {
@@ -138,6 +171,13 @@ static int setup_db(void **state) {
         return -1;
     }
 
+    rc = wtree3_db_register_key_extractor(test_db, version, 0x04, list_key_extractor, &error);
+    if (rc != 0) {
+        fprintf(stderr, "Failed to register extractor 0x04: %s\n", error.message);
+        wtree3_db_close(test_db);
+        return -1;
+    }
+
     return 0;
 }
 
@@ -763,6 +803,63 @@ static void test_multiple_indexes(void **state) {
     wtree3_tree_close(tree);
 }
 
+static bool index_has(wtree3_tree_t *tree, const char *key) {
+    gerror_t error = {0};
+    wtree3_iterator_t *iter = wtree3_index_seek(tree, "tags", key, strlen(key), &error);
+    assert_non_null(iter);
+    bool found = wtree3_iterator_valid(iter);
+    wtree3_iterator_close(iter);
+    return found;
+}
+
+static void test_multikey_index(void **state) {
+    (void)state;
+    gerror_t error = {0};
+
+    wtree3_tree_t *tree = wtree3_tree_open(test_db, "idx_tree10", 0, 0, &error);
+    assert_non_null(tree);
+
+    /* Populated from an existing document */
+    const char *key1 = "doc1";
+    const char *val1 = "name:Alice|tags:red,blue,red";
+    assert_int_equal(WTREE3_OK,
+                     wtree3_insert_one(tree, key1, strlen(key1), val1, strlen(val1) + 1, &error));
+
+    wtree3_index_config_t config = {
+        .name = "tags",
+        .user_data = (void *)"tags",
+        .user_data_len = strlen("tags") + 1,
+        .multikey = true,
+    };
+    assert_int_equal(WTREE3_OK, wtree3_tree_add_index(tree, &config, &error));
+    assert_int_equal(WTREE3_OK, wtree3_tree_populate_index(tree, "tags", &error));
+    assert_true(index_has(tree, "red"));
+    assert_true(index_has(tree, "blue"));
+
+    /* Maintained by insert, update and delete: one entry per key */
+    const char *key2 = "doc2";
+    const char *val2 = "name:Bob|tags:blue,green";
+    assert_int_equal(WTREE3_OK,
+                     wtree3_insert_one(tree, key2, strlen(key2), val2, strlen(val2) + 1, &error));
+    assert_true(index_has(tree, "green"));
+
+    const char *val1_updated = "name:Alice|tags:yellow";
+    assert_int_equal(WTREE3_OK, wtree3_update(tree, key1, strlen(key1), val1_updated,
+                                              strlen(val1_updated) + 1, &error));
+    assert_false(index_has(tree, "red"));
+    assert_true(index_has(tree, "blue"));
+    assert_true(index_has(tree, "yellow"));
+
+    bool deleted = false;
+    assert_int_equal(WTREE3_OK, wtree3_delete_one(tree, key2, strlen(key2), &deleted, &error));
+    assert_true(deleted);
+    assert_false(index_has(tree, "blue"));
+    assert_false(index_has(tree, "green"));
+    assert_int_equal(WTREE3_OK, wtree3_verify_indexes(tree, &error));
+
+    wtree3_tree_close(tree);
+}
+
 static void test_error_strings(void **state) {
     (void)state;
 
@@ -808,6 +905,7 @@ int main(void) {
         cmocka_unit_test(test_populate_index),
         cmocka_unit_test(test_drop_index),
         cmocka_unit_test(test_multiple_indexes),
+        cmocka_unit_test(test_multikey_index),
 
         /* Utility tests */
         cmocka_unit_test(test_error_strings),